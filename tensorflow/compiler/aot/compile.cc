@@ -147,6 +147,10 @@ Status CompileGraph(GraphDef graph_def, const tf2xla::Config& config,
       flags.target_triple, flags.target_cpu, flags.target_features,
       flags.entry_point,
       xla::cpu::CpuAotCompilationOptions::RelocationModel::BigPic);
+  if (flags.share_constants) {
+    (*aot_opts.mutable_debug_options()->mutable_xla_backend_extra_options())
+        ["xla_cpu_share_constants_across_objects"] = "";
+  }
 
   return CompileXla(client, computation, aot_opts, compile_result);
 }
@@ -159,6 +163,17 @@ static Status ReadProtoFile(const string& fname, protobuf::Message* proto) {
   }
 }
 
+// Replaces the unknown leading dimension of each feed in `config` by
+// `batch_size`.
+static void SetFeedBatchSize(int64 batch_size, tf2xla::Config* config) {
+  for (tf2xla::Feed& feed : *config->mutable_feed()) {
+    TensorShapeProto* shape = feed.mutable_shape();
+    if (shape->dim_size() > 0 && shape->dim(0).size() == -1) {
+      shape->mutable_dim(0)->set_size(batch_size);
+    }
+  }
+}
+
 static absl::once_flag targets_init;
 
 static void InitializeTargets() {
@@ -215,6 +230,13 @@ Status Main(const MainFlags& flags) {
     return errors::InvalidArgument("Must specify --config");
   }
   TF_RETURN_IF_ERROR(ReadProtoFile(flags.config, &config));
+  if (flags.batch_size < 0) {
+    return errors::InvalidArgument("--batch_size must not be negative, got ",
+                                   flags.batch_size);
+  }
+  if (flags.batch_size > 0) {
+    SetFeedBatchSize(flags.batch_size, &config);
+  }
   TF_RETURN_IF_ERROR(ValidateConfig(config));
   if (flags.dump_fetch_nodes) {
     std::set<string> nodes;
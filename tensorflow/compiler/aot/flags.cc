@@ -80,6 +80,14 @@ void AppendMainFlags(std::vector<Flag>* flag_list, MainFlags* flags) {
       {"experimental_quantize", &flags->experimental_quantize,
        "If set, quantization passes will run and dump the result before HLO "
        "code generation."},
+      {"batch_size", &flags->batch_size,
+       "If positive, feeds whose leading dimension is -1 in the config are "
+       "compiled with this leading dimension instead.  Used to build the "
+       "batch size variants of a tf_library_bundle from a single config."},
+      {"share_constants", &flags->share_constants,
+       "If set, constants are emitted with link-once linkage under names "
+       "derived from their contents, so that identical constants in several "
+       "objects linked into the same binary are stored once."},
       {"gen_name_to_index", &flags->gen_name_to_index,
        "Generate name-to-index data for Lookup{Arg,Result}Index methods."},
       {"gen_program_shape", &flags->gen_program_shape,
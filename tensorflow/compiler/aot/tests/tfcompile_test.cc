@@ -43,6 +43,7 @@ limitations under the License.
 #include "tensorflow/compiler/aot/tests/test_graph_tfvariable_readonly_mlir_bridge.h"
 #include "tensorflow/compiler/aot/tests/test_graph_tfvariable_sequential_updates_mlir_bridge.h"
 #else
+#include "tensorflow/compiler/aot/tests/test_graph_bundle.h"
 #include "tensorflow/compiler/aot/tests/test_graph_tfadd.h"
 #include "tensorflow/compiler/aot/tests/test_graph_tfadd_with_ckpt.h"
 #include "tensorflow/compiler/aot/tests/test_graph_tfadd_with_ckpt_saver.h"
@@ -339,6 +340,41 @@ TEST(TFCompileTest, MatMul2_SetArg) {
   EXPECT_EQ(matmul.result0_data(), matmul.results()[0]);
 }
 
+#if !defined(ENABLE_MLIR_BRIDGE_TEST)
+TEST(TFCompileTest, Bundle) {
+  const XlaCompiledCpuFunctionBundle& bundle = foo::bar::Bundle();
+  ASSERT_EQ(bundle.variants().size(), 4);
+  EXPECT_EQ(bundle.Select("add", 1)->static_data,
+            &foo::bar::Bundle_add_1::StaticData());
+  EXPECT_EQ(bundle.Select("add", 2), nullptr);
+  EXPECT_EQ(bundle.Select("matmul", 5), nullptr);
+
+  const XlaCompiledCpuFunctionBundle::Variant* variant =
+      bundle.Select("matmul", 3);
+  ASSERT_NE(variant, nullptr);
+  EXPECT_EQ(variant->batch_size, 4);
+  EXPECT_EQ(variant->static_data, &foo::bar::Bundle_matmul_4::StaticData());
+
+  Eigen::ThreadPool tp(2);
+  Eigen::ThreadPoolDevice device(&tp, tp.NumThreads());
+  std::unique_ptr<XlaCompiledCpuFunction> matmul = bundle.Create(*variant);
+  matmul->set_thread_pool(&device);
+
+  // Three rows of a request, and a row of padding.
+  const float x[12] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 0, 0, 0};
+  const float y[6] = {7, 8, 9, 10, 11, 12};
+  std::copy(x, x + 12, static_cast<float*>(matmul->arg_data(0)));
+  std::copy(y, y + 6, static_cast<float*>(matmul->arg_data(1)));
+  EXPECT_TRUE(matmul->Run());
+  EXPECT_EQ(matmul->error_msg(), "");
+  const float results[6] = {58, 64, 139, 154, 220, 244};
+  const float* result = static_cast<const float*>(matmul->result_data(0));
+  for (int i = 0; i < 6; ++i) {
+    EXPECT_EQ(result[i], results[i]);
+  }
+}
+#endif
+
 TEST(TFCompileTest, MatMulAndAdd1) {
   Eigen::ThreadPool tp(1);
   Eigen::ThreadPoolDevice device(&tp, tp.NumThreads());
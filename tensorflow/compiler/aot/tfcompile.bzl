@@ -419,6 +419,189 @@ def tf_library(
             tags = tags,
         )
 
+def tf_library_bundle(
+        name,
+        signatures,
+        cpp_class,
+        batch_sizes = [1],
+        share_constants = True,
+        gen_benchmark = True,
+        visibility = None,
+        testonly = None,
+        tfcompile_flags = None,
+        tags = [],
+        **kwargs):
+    """Compiles several TensorFlow graphs, each for several batch sizes, into a
+    cc_library with a dispatcher that picks the variant for a request.
+
+    Given an invocation of tf_library_bundle(name="foo", ...), generates the
+    following build targets:
+      foo:           A cc_library containing the bundle header and the
+                     variants.
+      foo_<sig>_<n>: A tf_library for batch size <n> of signature <sig>.
+      foo_benchmark: A cc_binary that benchmarks the dispatch, and each
+                     variant.  Only created if gen_benchmark=True.
+    The output header is called <name>.h.  It declares a function named after
+    cpp_class that returns the tensorflow::XlaCompiledCpuFunctionBundle; the
+    class of each variant is cpp_class + "_<sig>_<n>".
+
+    Args:
+      name: The name of the build rule.
+      signatures: A dict from signature name to a dict with the "graph" and
+        "config" of the signature, as taken by tf_library, and optionally its
+        own "batch_sizes".  Feeds whose leading dimension is -1 in the config
+        are compiled with the leading dimension set to each batch size.
+      cpp_class: The name of the generated function returning the bundle, with
+        the syntax of the tf_library cpp_class.
+      batch_sizes: The batch sizes to compile the signatures without their own
+        batch_sizes for.
+      share_constants: If True, constants that are identical across variants,
+        e.g. the weights of a model, are stored once in the linked binary.
+      gen_benchmark: If True, also generate a binary with a simple benchmark.
+      visibility: Bazel build visibility.
+      testonly:   Bazel testonly attribute.
+      tfcompile_flags: Extra flags to pass to tfcompile for all variants, as a
+        list.
+      tags: tags to apply to subsidiary build rules.
+      **kwargs: Passed to tf_library for each variant.
+    """
+    cpp_class_split = cpp_class.rsplit("::", 1)
+    if len(cpp_class_split) == 1:
+        namespaces = []
+        bundle_name = cpp_class_split[0]
+    else:
+        namespaces = cpp_class_split[0].split("::")
+        bundle_name = cpp_class_split[1]
+
+    variant_flags = (tfcompile_flags or []) + (
+        ["--share_constants"] if share_constants else []
+    )
+    variant_libs = []
+    includes = []
+    entries = []
+    for signature in sorted(signatures.keys()):
+        spec = signatures[signature]
+        for batch_size in spec.get("batch_sizes", batch_sizes):
+            variant_name = "%s_%s_%d" % (name, signature, batch_size)
+            variant_class = "%s_%s_%d" % (bundle_name, signature, batch_size)
+            tf_library(
+                name = variant_name,
+                graph = spec["graph"],
+                config = spec["config"],
+                cpp_class = "::".join(namespaces + [variant_class]),
+                gen_test = False,
+                gen_benchmark = False,
+                visibility = visibility,
+                testonly = testonly,
+                tfcompile_flags = variant_flags + [
+                    "--batch_size=%d" % batch_size,
+                ],
+                tags = tags,
+                **kwargs
+            )
+            variant_libs.append(":" + variant_name)
+            includes.append('#include "%s/%s.h"' % (
+                native.package_name(),
+                variant_name,
+            ))
+            entries.append('      {"%s", %d, &%s::StaticData()},' % (
+                signature,
+                batch_size,
+                variant_class,
+            ))
+
+    header_file = name + ".h"
+    guard = ("TFCOMPILE_BUNDLE_" + native.package_name() + "_" +
+             name).replace("/", "_").upper() + "_H_"
+    header = "\n".join(
+        [
+            "// Generated by the tf_library_bundle build rule.  DO NOT EDIT!",
+            "#ifndef " + guard,
+            "#define " + guard,
+            "",
+            '#include "tensorflow/compiler/tf2xla/' +
+            'xla_compiled_cpu_function_bundle.h"',
+        ] + includes + [""] +
+        ["namespace %s {" % ns for ns in namespaces] + [
+            "",
+            "inline const ::tensorflow::XlaCompiledCpuFunctionBundle& " +
+            bundle_name + "() {",
+            "  static const ::tensorflow::XlaCompiledCpuFunctionBundle* " +
+            "bundle = new ::tensorflow::XlaCompiledCpuFunctionBundle({",
+        ] + entries + [
+            "  });",
+            "  return *bundle;",
+            "}",
+            "",
+        ] + ["}  // namespace %s" % ns for ns in reversed(namespaces)] + [
+            "",
+            "#endif  // " + guard,
+        ],
+    )
+    native.genrule(
+        name = "gen_" + name,
+        outs = [header_file],
+        cmd = "cat > $@ <<'EOF'\n" + header + "\nEOF",
+        visibility = visibility,
+        testonly = testonly,
+        tags = tags,
+    )
+
+    native.cc_library(
+        name = name,
+        hdrs = [header_file],
+        visibility = visibility,
+        testonly = testonly,
+        deps = variant_libs + [
+            "//tensorflow/compiler/tf2xla:xla_compiled_cpu_function_bundle",
+        ],
+        tags = tags,
+    )
+
+    if gen_benchmark:
+        benchmark_name = name + "_benchmark"
+        benchmark_file = benchmark_name + ".cc"
+        benchmark_main = ("//tensorflow/compiler/aot:" +
+                          "benchmark_bundle_main.template")
+        sed_replace = (
+            "-e \"s|{{TFCOMPILE_HEADER}}|$(location " + header_file + ")|g\" " +
+            "-e \"s|{{TFCOMPILE_BUNDLE}}|" + cpp_class + "|g\" "
+        )
+
+        # Rule to rewrite the template to produce the benchmark_file.
+        native.genrule(
+            name = ("gen_" + benchmark_name),
+            srcs = [
+                benchmark_main,
+                header_file,
+            ],
+            testonly = testonly,
+            outs = [benchmark_file],
+            cmd = ("sed " + sed_replace +
+                   " $(location " + benchmark_main + ") " +
+                   "> $(OUTS)"),
+            tags = tags,
+        )
+
+        # As for tf_library, this deliberately does not depend on
+        # //tensorflow/core:lib.
+        native.cc_binary(
+            name = benchmark_name,
+            srcs = [benchmark_file],
+            testonly = testonly,
+            copts = tf_copts(),
+            linkopts = if_android(["-pie", "-s"]),
+            deps = [
+                ":" + name,
+                "//tensorflow/compiler/aot:benchmark",
+                "//tensorflow/compiler/xla:executable_run_options",
+                "//third_party/eigen3",
+            ] + if_android([
+                "//tensorflow/compiler/aot:benchmark_extra_android",
+            ]),
+            tags = tags,
+        )
+
 def target_llvm_triple():
     """Returns the target LLVM triple to be used for compiling the target."""
 
@@ -163,6 +163,8 @@ void AllocateAndParseFlags() {
 
   ops_flags = new XlaOpsCommonFlags;
   ops_flags->tf_xla_always_defer_compilation = false;
+  ops_flags->tf_xla_async_compilation = false;
+  ops_flags->tf_xla_shape_bucketing = "";
 
   jitter_flags = new IntroduceFloatingPointJitterPassFlags;
   jitter_flags->jitter_amount = 1e-5;
@@ -207,6 +209,14 @@ void AllocateAndParseFlags() {
 
        Flag("tf_xla_always_defer_compilation",
             &ops_flags->tf_xla_always_defer_compilation, ""),
+       Flag("tf_xla_async_compilation", &ops_flags->tf_xla_async_compilation,
+            "If true, compile new shapes of lazily compiled clusters in the "
+            "background and run them in the TF executor until compilation "
+            "finishes."),
+       Flag("tf_xla_shape_bucketing", &ops_flags->tf_xla_shape_bucketing,
+            "Pad varying dimensions of XLA cluster inputs on the host up to "
+            "the next bucket: either \"pow2\" or a comma-separated list of "
+            "bucket sizes.  Empty disables bucketing."),
 
        Flag("tf_introduce_floating_point_jitter_to_tensors",
             setter_for_jitter_tensor_names, "",
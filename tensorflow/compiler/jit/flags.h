@@ -97,6 +97,19 @@ struct XlaOpsCommonFlags {
   // If true, _XlaCompile always refuses to compile the cluster, which means the
   // XLA clusters always run in the TF executor.  Defaults to false.
   bool tf_xla_always_defer_compilation;
+
+  // If true, _XlaCompile compiles new signatures of lazily compiled clusters
+  // on background threads and runs the cluster in the TF executor until the
+  // executable is ready, instead of blocking on the compilation.  Defaults to
+  // false.
+  bool tf_xla_async_compilation;
+
+  // Rounds the dynamic dimensions of XLA cluster inputs on the host up to
+  // shape buckets, so that clusters fed variable batch or sequence lengths
+  // are compiled once per bucket instead of once per shape.  Either "pow2"
+  // (powers of two) or a comma-separated increasing list of bucket sizes.
+  // Empty disables bucketing, which is the default.
+  string tf_xla_shape_bucketing;
 };
 
 // Flags for the build_xla_ops pass.
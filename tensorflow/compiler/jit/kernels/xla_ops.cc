@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/compiler/jit/kernels/xla_ops.h"
 
+#include <map>
+
 #include "absl/container/flat_hash_map.h"
 #include "absl/memory/memory.h"
 #include "tensorflow/compiler/jit/defs.h"
@@ -102,18 +104,21 @@ XlaPlatformInfo PlatformInfoFromContext(OpKernelConstruction* ctx) {
 // This is necessary: we need to use the snapshots observed by the compiler as
 // the initial values for the resource variables (and cannot snapshot them again
 // during execution) because otherwise we risk observing a different snapshot
-// with shapes different from what we compiled for.
+// with shapes different from what we compiled for.  For the same reason it
+// holds the inputs padded by a ShapeBucketer, if any.
 class XlaExecutableClosure {
  public:
   explicit XlaExecutableClosure(
       xla::LocalClient* client, xla::LocalExecutable* executable,
       const XlaCompiler::CompilationResult* compilation_result,
-      ResourceVarsSnapshot resource_var_snapshots, int num_constant_args)
+      ResourceVarsSnapshot resource_var_snapshots, int num_constant_args,
+      std::map<int, Tensor> bucketed_inputs)
       : client_(client),
         executable_(executable),
         compilation_result_(compilation_result),
         resource_var_snapshots_(std::move(resource_var_snapshots)),
-        num_constant_args_(num_constant_args) {}
+        num_constant_args_(num_constant_args),
+        bucketed_inputs_(std::move(bucketed_inputs)) {}
 
   XlaExecutableClosure(XlaExecutableClosure&&) = default;
   XlaExecutableClosure& operator=(XlaExecutableClosure&&) = default;
@@ -127,6 +132,9 @@ class XlaExecutableClosure {
     return resource_var_snapshots_;
   }
   int num_constant_args() const { return num_constant_args_; }
+  const std::map<int, Tensor>& bucketed_inputs() const {
+    return bucketed_inputs_;
+  }
 
  private:
   xla::LocalClient* client_;
@@ -134,6 +142,7 @@ class XlaExecutableClosure {
   const XlaCompiler::CompilationResult* compilation_result_;
   ResourceVarsSnapshot resource_var_snapshots_;
   int num_constant_args_;
+  std::map<int, Tensor> bucketed_inputs_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(XlaExecutableClosure);
 };
@@ -203,6 +212,33 @@ se::DeviceMemoryAllocator* GetAllocator(
   return &tf_allocator_adapter->value();
 }
 
+// Returns the ShapeBucketer selected by --tf_xla_shape_bucketing, or null if
+// bucketing is disabled or the kernel does not run on the host.
+std::unique_ptr<ShapeBucketer> ShapeBucketerFromFlags(
+    OpKernelConstruction* ctx, const XlaPlatformInfo& platform_info) {
+  const string& spec = GetXlaOpsCommonFlags().tf_xla_shape_bucketing;
+  if (spec.empty() ||
+      platform_info.platform_id() != se::host::kHostPlatformId ||
+      platform_info.is_on_xla_device()) {
+    return nullptr;
+  }
+  xla::StatusOr<ShapeBucketingPolicy> policy =
+      ShapeBucketingPolicy::Parse(spec);
+  OP_REQUIRES_OK_RETURN(ctx, nullptr, policy.status());
+  return absl::make_unique<ShapeBucketer>(policy.ConsumeValueOrDie());
+}
+
+// Returns pointers to the tensors in `bucketed_inputs`, as taken by
+// XlaComputationLaunchContext::PopulateInputs.
+std::map<int, const Tensor*> BucketedInputPointers(
+    const std::map<int, Tensor>& bucketed_inputs) {
+  std::map<int, const Tensor*> pointers;
+  for (const auto& p : bucketed_inputs) {
+    pointers.emplace(p.first, &p.second);
+  }
+  return pointers;
+}
+
 }  // namespace
 
 XlaLocalLaunchBase::XlaLocalLaunchBase(OpKernelConstruction* ctx,
@@ -215,7 +251,8 @@ XlaLocalLaunchBase::XlaLocalLaunchBase(OpKernelConstruction* ctx,
       resources_(resources),
       function_(function),
       platform_info_(PlatformInfoFromContext(ctx)),
-      has_ref_vars_(has_ref_vars) {}
+      has_ref_vars_(has_ref_vars),
+      shape_bucketer_(ShapeBucketerFromFlags(ctx, platform_info_)) {}
 
 static Status BuildCompilationCache(OpKernelContext* ctx,
                                     const XlaPlatformInfo& platform_info,
@@ -277,8 +314,10 @@ static Status CompileToLocalExecutable(
     OpKernelContext* ctx, const NameAttrList& function, bool has_ref_vars,
     const XlaPlatformInfo& platform_info,
     absl::Span<VariableInfo const> variable_infos,
-    absl::Span<const int> constants, bool lazy, bool may_alias_resource_update,
-    xla::LocalClient** client,
+    absl::Span<const int> constants, ShapeBucketer* shape_bucketer,
+    std::map<int, Tensor>* bucketed_inputs,
+    XlaCompilationCache::CompileMode compile_mode,
+    bool may_alias_resource_update, xla::LocalClient** client,
     const XlaCompiler::CompilationResult** compilation_result,
     xla::LocalExecutable** executable) {
   // We store information about the JIT-compiled XLA computation
@@ -340,9 +379,39 @@ static Status CompileToLocalExecutable(
   std::vector<XlaCompiler::Argument> args;
   TF_RETURN_IF_ERROR(XlaComputationLaunchContext::BuildXlaCompilerArguments(
       constant_args, variable_infos, ctx, &args));
-  return cache->Compile(options, function, args, compile_options,
-                        lazy ? XlaCompilationCache::CompileMode::kLazy
-                             : XlaCompilationCache::CompileMode::kStrict,
+  if (shape_bucketer != nullptr) {
+    TF_RETURN_IF_ERROR(shape_bucketer->Apply(ctx, &args, bucketed_inputs));
+    if (!bucketed_inputs->empty()) {
+      Status status =
+          cache->Compile(options, function, args, compile_options,
+                         compile_mode, compilation_result, executable);
+      if (status.ok()) {
+        return status;
+      }
+      // Compile this call for the exact input shapes instead.
+      bucketed_inputs->clear();
+      args.clear();
+      TF_RETURN_IF_ERROR(XlaComputationLaunchContext::BuildXlaCompilerArguments(
+          constant_args, variable_infos, ctx, &args));
+      Status exact_status =
+          cache->Compile(options, function, args, compile_options,
+                         compile_mode, compilation_result, executable);
+      // Not every cluster can be compiled with dynamic dimensions. Bucketing
+      // is only turned off for a cluster that compiles for its exact shapes
+      // and failed in a way the dynamic dimensions can explain; after other
+      // errors, later calls try bucketing again.
+      if (exact_status.ok() && IsShapeBucketingError(status)) {
+        VLOG(1) << "Disabling shape bucketing of " << function.name() << ": "
+                << status;
+        shape_bucketer->Disable();
+      } else {
+        VLOG(1) << "Compiled " << function.name()
+                << " for exact shapes after: " << status;
+      }
+      return exact_status;
+    }
+  }
+  return cache->Compile(options, function, args, compile_options, compile_mode,
                         compilation_result, executable);
 }
 
@@ -355,13 +424,15 @@ void XlaLocalLaunchBase::Compute(OpKernelContext* ctx) {
   xla::LocalExecutable* executable;
 
   std::vector<VariableInfo> variable_infos;
+  std::map<int, Tensor> bucketed_inputs;
   {
     OP_REQUIRES_OK(
         ctx, GetVariableInfosFromCtxInputs(ctx, resources_, &variable_infos));
     OP_REQUIRES_OK(ctx, LockVariables(absl::MakeSpan(variable_infos)));
     Status s = CompileToLocalExecutable(
         ctx, function_, /*has_ref_vars=*/has_ref_vars_, platform_info_,
-        variable_infos, constants_, /*lazy=*/false,
+        variable_infos, constants_, shape_bucketer_.get(), &bucketed_inputs,
+        XlaCompilationCache::CompileMode::kStrict,
         /*may_alias_resource_update=*/true, &client, &compilation_result,
         &executable);
     OP_REQUIRES_OK(ctx, s);
@@ -391,7 +462,8 @@ void XlaLocalLaunchBase::Compute(OpKernelContext* ctx) {
   xla::StatusOr<std::vector<xla::ExecutionInput>> execution_inputs =
       launch_context.PopulateInputs(ctx, compilation_result, resource_var_ptrs,
                                     /*missing_ctx_input_prefix=*/0,
-                                    input_output_alias);
+                                    input_output_alias,
+                                    BucketedInputPointers(bucketed_inputs));
   OP_REQUIRES_OK(ctx, execution_inputs.status());
 
   // Execute the computation.
@@ -505,7 +577,8 @@ XlaCompileOp::XlaCompileOp(OpKernelConstruction* ctx)
       function_(FunctionAttr(ctx)),
       platform_info_(PlatformInfoFromContext(ctx)),
       must_compile_(MustCompileAttr(ctx)),
-      has_ref_vars_(HasRefVars(ctx)) {}
+      has_ref_vars_(HasRefVars(ctx)),
+      shape_bucketer_(ShapeBucketerFromFlags(ctx, platform_info_)) {}
 
 void XlaCompileOp::Compute(OpKernelContext* ctx) {
   VLOG(3) << "XlaCompileOp " << def().name()
@@ -514,6 +587,7 @@ void XlaCompileOp::Compute(OpKernelContext* ctx) {
   const XlaCompiler::CompilationResult* kernel;
   xla::LocalExecutable* executable;
   ResourceVarsSnapshot variables;
+  std::map<int, Tensor> bucketed_inputs;
 
   bool cannot_compile_cluster;
   {
@@ -530,12 +604,19 @@ void XlaCompileOp::Compute(OpKernelContext* ctx) {
         ctx, GetVariableInfosFromCtxInputs(ctx, resources_, &variable_infos));
     OP_REQUIRES_OK(ctx, LockVariables(absl::MakeSpan(variable_infos)));
 
+    XlaCompilationCache::CompileMode compile_mode =
+        XlaCompilationCache::CompileMode::kStrict;
+    if (!must_compile_) {
+      compile_mode = GetXlaOpsCommonFlags().tf_xla_async_compilation
+                         ? XlaCompilationCache::CompileMode::kAsync
+                         : XlaCompilationCache::CompileMode::kLazy;
+    }
+
     // Do not alias resource updates as locking variables in XlaCompile and
     // unlocking them in XlaRun may lead to deadlocks.
     Status status = CompileToLocalExecutable(
         ctx, function_, has_ref_vars_, platform_info_, variable_infos,
-        constants_,
-        /*lazy=*/!must_compile_,
+        constants_, shape_bucketer_.get(), &bucketed_inputs, compile_mode,
         /*may_alias_resource_update=*/false, &client, &kernel, &executable);
     OP_REQUIRES_OK(ctx, SnapshotResourceVariables(ctx, resources_,
                                                   variable_infos, &variables));
@@ -578,7 +659,8 @@ void XlaCompileOp::Compute(OpKernelContext* ctx) {
   // variables.
   XlaExecutableClosureStore::KeyT key =
       XlaExecutableClosureStore::Global()->Produce(XlaExecutableClosure(
-          client, executable, kernel, std::move(variables), constants_.size()));
+          client, executable, kernel, std::move(variables), constants_.size(),
+          std::move(bucketed_inputs)));
 
   Tensor compilation_key(cpu_allocator, DT_STRING, TensorShape({}));
   compilation_key.flat<tstring>()(0) = key;
@@ -636,7 +718,7 @@ void XlaRunOp::Compute(OpKernelContext* ctx) {
     execution_inputs = launch_context.PopulateInputs(
         ctx, closure.compilation_result(), snapshot_ptrs,
         /*missing_ctx_input_prefix=*/closure.num_constant_args(),
-        input_output_alias);
+        input_output_alias, BucketedInputPointers(closure.bucketed_inputs()));
     OP_REQUIRES_OK(ctx, execution_inputs.status());
   }
 
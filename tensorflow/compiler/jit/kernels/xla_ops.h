@@ -17,7 +17,9 @@ limitations under the License.
 #define TENSORFLOW_COMPILER_JIT_KERNELS_XLA_OPS_H_
 
 #include <atomic>
+#include <memory>
 
+#include "tensorflow/compiler/jit/shape_bucketing.h"
 #include "tensorflow/compiler/jit/xla_compilation_cache.h"
 #include "tensorflow/compiler/jit/xla_device.h"
 #include "tensorflow/compiler/jit/xla_launch_util.h"
@@ -120,6 +122,10 @@ class XlaLocalLaunchBase : public OpKernel {
   const XlaPlatformInfo platform_info_;
 
   bool has_ref_vars_;
+
+  // Pads the inputs up to shape buckets.  Null unless
+  // --tf_xla_shape_bucketing is set and the kernel runs on the host.
+  const std::unique_ptr<ShapeBucketer> shape_bucketer_;
 };
 
 // XlaLocalLaunchOp is used to replace a region of the TensorFlow graph
@@ -161,6 +167,10 @@ class XlaCompileOp : public OpKernel {
   // Whether the graph has TF reference variables.
   const bool has_ref_vars_;
 
+  // Pads the inputs up to shape buckets.  Null unless
+  // --tf_xla_shape_bucketing is set and the kernel runs on the host.
+  const std::unique_ptr<ShapeBucketer> shape_bucketer_;
+
   // cannot_compile_cluster_ is set to true if XLA returns an Unimplemented
   // error when compiling the cluster this _XlaCompile is supposed to compile.
   // If `cannot_compile_cluster_` is true then we avoid compiling this cluster
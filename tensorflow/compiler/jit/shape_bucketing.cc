@@ -0,0 +1,218 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/jit/shape_bucketing.h"
+
+#include <cstring>
+#include <iterator>
+
+#include "absl/algorithm/container.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_split.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+
+/*static*/ xla::StatusOr<ShapeBucketingPolicy> ShapeBucketingPolicy::Parse(
+    absl::string_view spec) {
+  ShapeBucketingPolicy policy;
+  if (spec == "pow2") {
+    return policy;
+  }
+  for (absl::string_view bucket_string : absl::StrSplit(spec, ',')) {
+    int64 bucket;
+    if (!absl::SimpleAtoi(bucket_string, &bucket) || bucket <= 0) {
+      return errors::InvalidArgument("Invalid shape bucket \"", bucket_string,
+                                     "\" in \"", spec, "\"");
+    }
+    if (!policy.buckets_.empty() && bucket <= policy.buckets_.back()) {
+      return errors::InvalidArgument("Shape buckets must be increasing: \"",
+                                     spec, "\"");
+    }
+    policy.buckets_.push_back(bucket);
+  }
+  return policy;
+}
+
+int64 ShapeBucketingPolicy::Bucket(int64 size) const {
+  if (buckets_.empty()) {
+    int64 bucket = 1;
+    while (bucket < size) {
+      bucket <<= 1;
+    }
+    return bucket;
+  }
+  auto it = absl::c_lower_bound(buckets_, size);
+  return it == buckets_.end() ? -1 : *it;
+}
+
+ShapeBucketer::ShapeBucketer(ShapeBucketingPolicy policy)
+    : policy_(std::move(policy)) {}
+
+bool IsShapeBucketingError(const Status& status) {
+  switch (status.code()) {
+    case error::INVALID_ARGUMENT:
+    case error::UNIMPLEMENTED:
+    case error::FAILED_PRECONDITION:
+    case error::OUT_OF_RANGE:
+    case error::INTERNAL:
+      return true;
+    default:
+      return false;
+  }
+}
+
+void ShapeBucketer::Disable() {
+  mutex_lock lock(mu_);
+  disabled_ = true;
+}
+
+Status ShapeBucketer::Apply(OpKernelContext* ctx,
+                            std::vector<XlaCompiler::Argument>* args,
+                            std::map<int, Tensor>* bucketed_inputs) {
+  std::vector<Tensor> inputs;
+  inputs.reserve(ctx->num_inputs());
+  for (int i = 0; i < ctx->num_inputs(); ++i) {
+    inputs.push_back(ctx->input(i));
+  }
+  return Apply(inputs, ctx->device()->GetAllocator(AllocatorAttributes()),
+               args, bucketed_inputs);
+}
+
+Status ShapeBucketer::Apply(absl::Span<const Tensor> inputs,
+                            Allocator* allocator,
+                            std::vector<XlaCompiler::Argument>* args,
+                            std::map<int, Tensor>* bucketed_inputs) {
+  bucketed_inputs->clear();
+  if (args->size() != inputs.size()) {
+    return errors::InvalidArgument("Expected ", inputs.size(),
+                                   " arguments, got ", args->size());
+  }
+
+  // The dimensions to bucket, by argument number.
+  std::map<int, std::vector<int>> dynamic_dims;
+  {
+    mutex_lock lock(mu_);
+    if (disabled_) {
+      return Status::OK();
+    }
+    for (int arg_num = 0; arg_num < args->size(); ++arg_num) {
+      const XlaCompiler::Argument& arg = (*args)[arg_num];
+      if (arg.kind != XlaCompiler::Argument::kParameter ||
+          !DataTypeCanUseMemcpy(arg.type)) {
+        continue;
+      }
+      const TensorShape& shape = inputs[arg_num].shape();
+      auto it = observed_dims_.find(arg_num);
+      if (it == observed_dims_.end()) {
+        observed_dims_.emplace(arg_num, shape.dim_sizes());
+        continue;
+      }
+      absl::InlinedVector<int64, 4>& observed = it->second;
+      if (observed.size() != static_cast<size_t>(shape.dims())) {
+        // Rank changes can't be expressed with dynamic dimensions.
+        continue;
+      }
+      for (int d = 0; d < shape.dims(); ++d) {
+        if (observed[d] != shape.dim_size(d)) {
+          observed[d] = -1;
+        }
+        if (observed[d] == -1 && policy_.Bucket(shape.dim_size(d)) != -1) {
+          dynamic_dims[arg_num].push_back(d);
+        }
+      }
+    }
+  }
+
+  std::vector<XlaCompiler::Argument> size_args;
+  for (const auto& arg_and_dims : dynamic_dims) {
+    const int arg_num = arg_and_dims.first;
+    XlaCompiler::Argument& arg = (*args)[arg_num];
+    const Tensor& input = inputs[arg_num];
+
+    TensorShape padded_shape = input.shape();
+    for (int d : arg_and_dims.second) {
+      padded_shape.set_dim(d, policy_.Bucket(input.dim_size(d)));
+
+      Tensor size(allocator, DT_INT32, TensorShape({}));
+      size.scalar<int32>()() = input.dim_size(d);
+      const int size_arg_num = args->size() + size_args.size();
+      (*bucketed_inputs)[size_arg_num] = size;
+      arg.dynamic_dim_to_arg_num_map[d] = size_arg_num;
+
+      XlaCompiler::Argument size_arg;
+      size_arg.kind = XlaCompiler::Argument::kParameter;
+      size_arg.type = DT_INT32;
+      size_arg.shape = TensorShape({});
+      size_args.push_back(std::move(size_arg));
+    }
+
+    Tensor padded = input;
+    if (padded_shape != input.shape()) {
+      padded = Tensor(allocator, arg.type, padded_shape);
+      if (!padded.IsInitialized()) {
+        return errors::ResourceExhausted("Failed to allocate the ",
+                                         padded_shape.DebugString(),
+                                         " bucket of argument ", arg_num);
+      }
+      PadTensorWithZeros(input, &padded);
+    }
+    arg.shape = padded_shape;
+    (*bucketed_inputs)[arg_num] = padded;
+  }
+  absl::c_move(size_args, std::back_inserter(*args));
+  return Status::OK();
+}
+
+void PadTensorWithZeros(const Tensor& input, Tensor* output) {
+  DCHECK_EQ(input.dtype(), output->dtype());
+  DCHECK_EQ(input.dims(), output->dims());
+  const char* src = input.tensor_data().data();
+  char* dst = const_cast<char*>(output->tensor_data().data());
+  std::memset(dst, 0, output->TotalBytes());
+  if (input.NumElements() == 0) {
+    return;
+  }
+  const int rank = input.dims();
+  if (rank == 0) {
+    std::memcpy(dst, src, input.TotalBytes());
+    return;
+  }
+
+  // Copy the input one innermost row at a time, to the row with the same
+  // index in the output.
+  const int64 element_size = DataTypeSize(input.dtype());
+  const int64 src_row_bytes = input.dim_size(rank - 1) * element_size;
+  const int64 dst_row_bytes = output->dim_size(rank - 1) * element_size;
+  const int64 num_rows = input.NumElements() / input.dim_size(rank - 1);
+  absl::InlinedVector<int64, 4> row_index(rank - 1, 0);
+  for (int64 row = 0; row < num_rows; ++row) {
+    int64 dst_row = 0;
+    for (int d = 0; d < rank - 1; ++d) {
+      dst_row = dst_row * output->dim_size(d) + row_index[d];
+    }
+    std::memcpy(dst + dst_row * dst_row_bytes, src + row * src_row_bytes,
+                src_row_bytes);
+    for (int d = rank - 2; d >= 0; --d) {
+      if (++row_index[d] < input.dim_size(d)) {
+        break;
+      }
+      row_index[d] = 0;
+    }
+  }
+}
+
+}  // namespace tensorflow
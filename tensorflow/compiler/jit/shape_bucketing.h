@@ -0,0 +1,114 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_JIT_SHAPE_BUCKETING_H_
+#define TENSORFLOW_COMPILER_JIT_SHAPE_BUCKETING_H_
+
+#include <map>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/inlined_vector.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "tensorflow/compiler/tf2xla/xla_compiler.h"
+#include "tensorflow/compiler/xla/statusor.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+
+// Rounds dimension sizes up to a fixed set of buckets.
+class ShapeBucketingPolicy {
+ public:
+  // Parses a policy specification, as taken by --tf_xla_shape_bucketing:
+  // either "pow2", for powers of two, or a comma-separated, strictly
+  // increasing list of positive bucket sizes.
+  static xla::StatusOr<ShapeBucketingPolicy> Parse(absl::string_view spec);
+
+  // Returns the smallest bucket that holds `size`, or -1 if `size` is larger
+  // than all buckets.
+  int64 Bucket(int64 size) const;
+
+ private:
+  // Empty for powers of two.
+  std::vector<int64> buckets_;
+};
+
+// Pads the inputs of an XLA cluster so that the cluster is compiled once per
+// shape bucket instead of once per input shape.
+//
+// A dimension of a (non-constant, non-resource) input is bucketed once it has
+// been seen with two different sizes.  Bucketed dimensions are padded with
+// zeros up to their bucket and marked dynamic: their actual size is passed to
+// the computation as an extra S32 scalar argument, bound to the dimension with
+// XlaCompiler::Argument::dynamic_dim_to_arg_num_map.  XLA's dynamic padder
+// then masks the padding wherever it could change the result, and outputs
+// whose shape depends on a bucketed dimension are sliced back to their actual
+// size when they are read.
+//
+// Only host memory inputs can be padded, so bucketing is meant for clusters
+// placed on the CPU.  Thread-safe.
+class ShapeBucketer {
+ public:
+  explicit ShapeBucketer(ShapeBucketingPolicy policy);
+
+  // Rewrites `args`, as built by
+  // XlaComputationLaunchContext::BuildXlaCompilerArguments for the inputs of
+  // `ctx`, to the bucketed shapes, and appends the size arguments of the
+  // bucketed dimensions.  Sets `bucketed_inputs` to the tensors to run the
+  // computation with in place of the inputs of `ctx`, keyed by argument
+  // number; it is left empty if no dimension is bucketed.
+  Status Apply(OpKernelContext* ctx, std::vector<XlaCompiler::Argument>* args,
+               std::map<int, Tensor>* bucketed_inputs);
+
+  // As above, for a kernel with inputs `inputs`.  The padded inputs are
+  // allocated from `allocator`.
+  Status Apply(absl::Span<const Tensor> inputs, Allocator* allocator,
+               std::vector<XlaCompiler::Argument>* args,
+               std::map<int, Tensor>* bucketed_inputs);
+
+  // Stops bucketing, e.g. because the cluster did not compile with dynamic
+  // dimensions.
+  void Disable();
+
+ private:
+  const ShapeBucketingPolicy policy_;
+
+  mutex mu_;
+  bool disabled_ TF_GUARDED_BY(mu_) = false;
+
+  // The dimension sizes first seen for each argument, with -1 for the
+  // dimensions seen with different sizes since.
+  absl::flat_hash_map<int, absl::InlinedVector<int64, 4>> observed_dims_
+      TF_GUARDED_BY(mu_);
+};
+
+// Returns true if `status`, the error of compiling a cluster with bucketed
+// dimensions, may come from the dynamic dimensions or the padding, rather than
+// from a transient condition such as running out of memory or cancellation.
+bool IsShapeBucketingError(const Status& status);
+
+// Copies `input` into the leading corner of `output`, which must have the same
+// type and rank and a shape at least as large in every dimension, and fills
+// the rest of `output` with zeros.  The type must be memcpy-able.
+void PadTensorWithZeros(const Tensor& input, Tensor* output);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMPILER_JIT_SHAPE_BUCKETING_H_
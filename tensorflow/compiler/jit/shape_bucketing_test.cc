@@ -0,0 +1,300 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/jit/shape_bucketing.h"
+
+#include <algorithm>
+#include <random>
+#include <set>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/compiler/jit/xla_compilation_cache.h"
+#include "tensorflow/compiler/tf2xla/literal_util.h"
+#include "tensorflow/compiler/tf2xla/xla_op_registry.h"
+#include "tensorflow/compiler/xla/client/client_library.h"
+#include "tensorflow/compiler/xla/client/local_client.h"
+#include "tensorflow/compiler/xla/executable_run_options.h"
+#include "tensorflow/compiler/xla/literal.h"
+#include "tensorflow/compiler/xla/status_macros.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(ShapeBucketingPolicyTest, PowersOfTwo) {
+  TF_ASSERT_OK_AND_ASSIGN(ShapeBucketingPolicy policy,
+                          ShapeBucketingPolicy::Parse("pow2"));
+  EXPECT_EQ(1, policy.Bucket(1));
+  EXPECT_EQ(4, policy.Bucket(3));
+  EXPECT_EQ(64, policy.Bucket(64));
+  EXPECT_EQ(128, policy.Bucket(65));
+}
+
+TEST(ShapeBucketingPolicyTest, ExplicitBuckets) {
+  TF_ASSERT_OK_AND_ASSIGN(ShapeBucketingPolicy policy,
+                          ShapeBucketingPolicy::Parse("16,32,64"));
+  EXPECT_EQ(16, policy.Bucket(1));
+  EXPECT_EQ(32, policy.Bucket(17));
+  EXPECT_EQ(64, policy.Bucket(64));
+  EXPECT_EQ(-1, policy.Bucket(65));
+}
+
+TEST(ShapeBucketingPolicyTest, InvalidSpecs) {
+  for (const char* spec : {"", "pow3", "16,,32", "0,16", "32,16"}) {
+    EXPECT_FALSE(ShapeBucketingPolicy::Parse(spec).ok()) << spec;
+  }
+}
+
+TEST(ShapeBucketingTest, PadTensorWithZeros) {
+  Tensor input = test::AsTensor<float>({1, 2, 3, 4, 5, 6}, {2, 3});
+  Tensor padded(DT_FLOAT, TensorShape({3, 4}));
+  PadTensorWithZeros(input, &padded);
+  test::ExpectTensorEqual<float>(
+      padded,
+      test::AsTensor<float>({1, 2, 3, 0, 4, 5, 6, 0, 0, 0, 0, 0}, {3, 4}));
+}
+
+std::vector<XlaCompiler::Argument> ParameterArgs(
+    absl::Span<const Tensor> inputs) {
+  std::vector<XlaCompiler::Argument> args(inputs.size());
+  for (int i = 0; i < inputs.size(); ++i) {
+    args[i].kind = XlaCompiler::Argument::kParameter;
+    args[i].type = inputs[i].dtype();
+    args[i].shape = inputs[i].shape();
+  }
+  return args;
+}
+
+TEST(ShapeBucketingTest, BucketsDimensionsThatVary) {
+  ShapeBucketer bucketer(ShapeBucketingPolicy::Parse("pow2").ValueOrDie());
+  std::map<int, Tensor> bucketed_inputs;
+
+  // Nothing varied yet.
+  std::vector<Tensor> inputs = {Tensor(DT_FLOAT, TensorShape({5, 8}))};
+  std::vector<XlaCompiler::Argument> args = ParameterArgs(inputs);
+  TF_ASSERT_OK(
+      bucketer.Apply(inputs, cpu_allocator(), &args, &bucketed_inputs));
+  EXPECT_TRUE(bucketed_inputs.empty());
+  ASSERT_EQ(1, args.size());
+  EXPECT_EQ(TensorShape({5, 8}), absl::get<TensorShape>(args[0].shape));
+
+  inputs = {Tensor(DT_FLOAT, TensorShape({7, 8}))};
+  args = ParameterArgs(inputs);
+  TF_ASSERT_OK(
+      bucketer.Apply(inputs, cpu_allocator(), &args, &bucketed_inputs));
+  ASSERT_EQ(2, args.size());
+  EXPECT_EQ(TensorShape({8, 8}), absl::get<TensorShape>(args[0].shape));
+  EXPECT_EQ((std::map<int32, int32>{{0, 1}}),
+            args[0].dynamic_dim_to_arg_num_map);
+  EXPECT_EQ(XlaCompiler::Argument::kParameter, args[1].kind);
+  EXPECT_EQ(DT_INT32, args[1].type);
+  ASSERT_EQ(2, bucketed_inputs.size());
+  EXPECT_EQ(TensorShape({8, 8}), bucketed_inputs[0].shape());
+  EXPECT_EQ(7, bucketed_inputs[1].scalar<int32>()());
+
+  bucketer.Disable();
+  args = ParameterArgs(inputs);
+  TF_ASSERT_OK(
+      bucketer.Apply(inputs, cpu_allocator(), &args, &bucketed_inputs));
+  EXPECT_TRUE(bucketed_inputs.empty());
+  EXPECT_EQ(1, args.size());
+}
+
+TEST(ShapeBucketingTest, IsShapeBucketingError) {
+  EXPECT_TRUE(IsShapeBucketingError(errors::Unimplemented("dynamic")));
+  EXPECT_TRUE(IsShapeBucketingError(errors::InvalidArgument("shape")));
+  EXPECT_FALSE(IsShapeBucketingError(errors::ResourceExhausted("OOM")));
+  EXPECT_FALSE(IsShapeBucketingError(errors::Cancelled("cancelled")));
+}
+
+// Compiles and runs a cluster that reduces the rows of its input with
+// `reduction` ("Sum", "Max", "Mean", ...), for inputs of varying length.
+class ReduceRowsCompiler {
+ public:
+  ReduceRowsCompiler(const string& reduction, const string& bucketing_spec)
+      : flib_def_(OpRegistry::Global(), FunctionDefLibrary()) {
+    TF_CHECK_OK(flib_def_.AddFunctionDef(FunctionDefHelper::Define(
+        "ReduceRows", {"x: float"}, {"y: float"}, {},
+        {FunctionDefHelper::Const("axis", 0),
+         {{"y"},
+          reduction,
+          {"x", "axis"},
+          {{"T", DT_FLOAT}, {"Tidx", DT_INT32}}}})));
+    function_.set_name("ReduceRows");
+
+    client_ = xla::ClientLibrary::LocalClientOrDie();
+    cache_ = new XlaCompilationCache(client_, DeviceType(DEVICE_CPU_XLA_JIT));
+    options_.client = client_;
+    options_.device_type = DeviceType(DEVICE_CPU_XLA_JIT);
+    options_.flib_def = &flib_def_;
+    if (!bucketing_spec.empty()) {
+      bucketer_ = absl::make_unique<ShapeBucketer>(
+          ShapeBucketingPolicy::Parse(bucketing_spec).ValueOrDie());
+    }
+  }
+
+  ~ReduceRowsCompiler() { cache_->Unref(); }
+
+  // Returns the number of different input shapes compiled for.
+  int num_compiled_shapes() const { return compiled_shapes_.size(); }
+
+  Status Compile(int64 length) {
+    return Compile({Tensor(DT_FLOAT, TensorShape({length, 16}))}, nullptr);
+  }
+
+  // Compiles the cluster for `input`, runs it, and sets `output` to the
+  // result.
+  Status Run(const Tensor& input, Tensor* output) {
+    return Compile({input}, output);
+  }
+
+  XlaCompilationCache* cache() { return cache_; }
+
+ private:
+  Status Compile(const std::vector<Tensor>& inputs, Tensor* output) {
+    std::vector<XlaCompiler::Argument> args = ParameterArgs(inputs);
+    std::map<int, Tensor> bucketed_inputs;
+    if (bucketer_ != nullptr) {
+      TF_RETURN_IF_ERROR(
+          bucketer_->Apply(inputs, cpu_allocator(), &args, &bucketed_inputs));
+    }
+    const XlaCompiler::CompilationResult* compilation_result;
+    xla::LocalExecutable* executable;
+    XlaCompiler::CompileOptions compile_options;
+    compile_options.always_return_tuple = false;
+    TF_RETURN_IF_ERROR(cache_->Compile(
+        options_, function_, args, compile_options,
+        XlaCompilationCache::CompileMode::kStrict, &compilation_result,
+        &executable));
+    if (executable == nullptr) {
+      return errors::Internal("No executable for ",
+                              inputs[0].shape().DebugString());
+    }
+    compiled_shapes_.insert(
+        absl::get<TensorShape>(args[0].shape).DebugString());
+    if (output == nullptr) return Status::OK();
+
+    // The padded input and the sizes of the bucketed dimensions replace the
+    // inputs, as in XlaLocalLaunchBase.
+    std::vector<xla::ScopedShapedBuffer> arguments;
+    for (int arg_num : compilation_result->input_mapping) {
+      auto it = bucketed_inputs.find(arg_num);
+      const Tensor& input =
+          it != bucketed_inputs.end() ? it->second : inputs[arg_num];
+      TF_ASSIGN_OR_RETURN(xla::Literal literal, HostTensorToLiteral(input));
+      TF_ASSIGN_OR_RETURN(
+          xla::ScopedShapedBuffer argument,
+          client_->LiteralToShapedBuffer(literal, /*device_ordinal=*/0));
+      arguments.push_back(std::move(argument));
+    }
+    std::vector<const xla::ShapedBuffer*> argument_ptrs;
+    for (const xla::ScopedShapedBuffer& argument : arguments) {
+      argument_ptrs.push_back(&argument);
+    }
+    xla::ExecutableRunOptions run_options;
+    run_options.set_allocator(client_->backend().memory_allocator());
+    TF_ASSIGN_OR_RETURN(xla::ScopedShapedBuffer result,
+                        executable->Run(argument_ptrs, run_options));
+    TF_ASSIGN_OR_RETURN(xla::Literal result_literal,
+                        client_->ShapedBufferToLiteral(result));
+    return LiteralToHostTensor(result_literal, DT_FLOAT, output);
+  }
+
+  FunctionLibraryDefinition flib_def_;
+  NameAttrList function_;
+  xla::LocalClient* client_;
+  XlaCompilationCache* cache_;
+  XlaCompiler::Options options_;
+  std::unique_ptr<ShapeBucketer> bucketer_;
+  std::set<string> compiled_shapes_;
+};
+
+TEST(ShapeBucketingTest, CompilesOncePerBucket) {
+  ReduceRowsCompiler compiler("Sum", "pow2");
+  for (int64 length : {5, 7, 3, 8, 12, 16, 9}) {
+    TF_ASSERT_OK(compiler.Compile(length));
+  }
+  EXPECT_EQ(4, compiler.num_compiled_shapes());
+
+  // The first call is compiled for its exact shape, since no dimension has
+  // varied yet.
+  std::map<string, XlaCompilationCache::BucketStats> stats =
+      compiler.cache()->GetBucketStats("ReduceRows");
+  ASSERT_EQ(3, stats.size());
+  EXPECT_EQ(0, stats["4"].hits);
+  EXPECT_EQ(1, stats["4"].misses);
+  EXPECT_EQ(1, stats["8"].hits);
+  EXPECT_EQ(1, stats["8"].misses);
+  EXPECT_EQ(2, stats["16"].hits);
+  EXPECT_EQ(1, stats["16"].misses);
+}
+
+// Zero padding would change the result of reductions that zero is not the
+// identity of, e.g. the maximum or mean of negative values, unless the dynamic
+// dimensions mask it.
+TEST(ShapeBucketingTest, BucketedResultsMatchExactShapes) {
+  for (const char* reduction : {"Sum", "Max", "Mean"}) {
+    ReduceRowsCompiler exact(reduction, "");
+    ReduceRowsCompiler bucketed(reduction, "pow2");
+    for (int64 length : {5, 7, 3, 12}) {
+      Tensor input(DT_FLOAT, TensorShape({length, 16}));
+      auto values = input.flat<float>();
+      for (int64 i = 0; i < values.size(); ++i) {
+        values(i) = -1.0f - (i % 13);
+      }
+      Tensor expected, actual;
+      TF_ASSERT_OK(exact.Run(input, &expected));
+      TF_ASSERT_OK(bucketed.Run(input, &actual));
+      test::ExpectTensorNear<float>(expected, actual, 1e-5);
+    }
+    // Lengths 7, 3 and 12 ran padded to 8, 4 and 16.
+    EXPECT_EQ(4, bucketed.num_compiled_shapes()) << reduction;
+  }
+}
+
+// Replays sequence lengths drawn from a log-normal distribution (a common fit
+// for request and sentence lengths) through the compilation cache, with and
+// without bucketing.
+void BM_ReplayLengthDistribution(int iters, int bucketed) {
+  testing::StopTiming();
+  constexpr int kNumRequests = 256;
+  std::mt19937 generator(42);
+  std::lognormal_distribution<double> distribution(/*m=*/3.5, /*s=*/0.6);
+  std::vector<int64> lengths(kNumRequests);
+  for (int64& length : lengths) {
+    length = std::min<int64>(512, std::max<int64>(1, distribution(generator)));
+  }
+
+  int num_compiled_shapes = 0;
+  for (int i = 0; i < iters; ++i) {
+    ReduceRowsCompiler compiler("Sum", bucketed ? "pow2" : "");
+    testing::StartTiming();
+    for (int64 length : lengths) {
+      TF_CHECK_OK(compiler.Compile(length));
+    }
+    testing::StopTiming();
+    num_compiled_shapes = compiler.num_compiled_shapes();
+  }
+  testing::SetLabel(absl::StrCat(num_compiled_shapes, " compilations"));
+}
+BENCHMARK(BM_ReplayLengthDistribution)->Arg(0)->Arg(1);
+
+}  // namespace
+}  // namespace tensorflow
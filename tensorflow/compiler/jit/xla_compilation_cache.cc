@@ -18,6 +18,7 @@ limitations under the License.
 #include <numeric>
 
 #include "absl/base/call_once.h"
+#include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "tensorflow/compiler/jit/xla_activity.pb.h"
@@ -50,12 +51,22 @@ limitations under the License.
 namespace tensorflow {
 
 constexpr int64 XlaCompilationCache::kDefaultCompilationThreshold;
+constexpr int XlaCompilationCache::kNumAsyncCompilationThreads;
+constexpr int64 XlaCompilationCache::kMaxPendingAsyncCompilations;
 
 XlaCompilationCache::XlaCompilationCache(xla::LocalClient* client,
                                          DeviceType device_type)
     : client_(client), device_type_(std::move(device_type)) {}
 
 XlaCompilationCache::~XlaCompilationCache() {
+  // Wait for the background compilations, which write into our entries. The
+  // pool is destroyed outside of the lock, which its closures acquire.
+  std::unique_ptr<thread::ThreadPool> async_compilation_pool;
+  {
+    mutex_lock lock(async_compilation_mu_);
+    async_compilation_pool = std::move(async_compilation_pool_);
+  }
+  async_compilation_pool.reset();
   // Ensure any use of our programs have completed by waiting for all stream
   // executors to complete.
   for (auto* executor : client_->backend().stream_executors()) {
@@ -184,16 +195,15 @@ Status XlaCompilationCache::Compile(
     CompileMode compile_mode,
     const XlaCompiler::CompilationResult** out_compilation_result,
     xla::LocalExecutable** out_executable) {
-  absl::optional<int64> compile_threshold;
-  if (compile_mode == CompileMode::kLazy) {
-    compile_threshold = kDefaultCompilationThreshold;
-  }
-  auto compile_fn = [&](XlaCompiler* compiler,
+  // `compile_options` is captured by value so that the function can outlive
+  // this call in kAsync mode.
+  auto compile_fn = [compile_options](
+                        XlaCompiler* compiler, const NameAttrList& function,
+                        absl::Span<const XlaCompiler::Argument> args,
                         XlaCompiler::CompilationResult* result) {
     return compiler->CompileFunction(compile_options, function, args, result);
   };
-  return CompileImpl(options, function, args, compile_fn,
-                     /*compile_threshold=*/compile_threshold,
+  return CompileImpl(options, function, args, compile_fn, compile_mode,
                      out_compilation_result, out_executable);
 }
 
@@ -208,6 +218,22 @@ static bool ShouldBeMegamorphic(int64 compile_count, int64 execution_count) {
          execution_count < kMinExecutionsPerCompile * compile_count;
 }
 
+// Returns the padded sizes of the dimensions of `args` that were bucketed by a
+// ShapeBucketer, or the empty string if there are none.
+static string BucketName(absl::Span<const XlaCompiler::Argument> args) {
+  std::vector<int64> sizes;
+  for (const XlaCompiler::Argument& arg : args) {
+    if (arg.dynamic_dim_to_arg_num_map.empty()) {
+      continue;
+    }
+    const auto dims = arg.DimensionSizesAsInlinedVector();
+    for (const auto& dim_and_arg_num : arg.dynamic_dim_to_arg_num_map) {
+      sizes.push_back(dims[dim_and_arg_num.first]);
+    }
+  }
+  return absl::StrJoin(sizes, ",");
+}
+
 // Creates a simple graph using the specified op as the only op apart from the
 // arg and retval nodes.
 static xla::StatusOr<std::unique_ptr<Graph>> CreateGraph(
@@ -268,7 +294,8 @@ Status XlaCompilationCache::CompileSingleOp(
   // compilation cache key. This attribute is information for the colocator
   // and causes false uniqueness between nodes.
   name.mutable_attr()->erase("_class");
-  auto compile_op = [&](XlaCompiler* compiler,
+  auto compile_op = [&](XlaCompiler* compiler, const NameAttrList& function,
+                        absl::Span<const XlaCompiler::Argument> args,
                         XlaCompiler::CompilationResult* result) {
     std::vector<DataType> result_dtypes(ctx->num_outputs());
     for (int i = 0; i < result_dtypes.size(); ++i) {
@@ -298,8 +325,7 @@ Status XlaCompilationCache::CompileSingleOp(
         compile_options.use_tuple_arg, *options.flib_def, debug_info,
         options.shape_representation_fn, result);
   };
-  return CompileImpl(options, name, args, compile_op,
-                     /*compile_threshold=*/absl::nullopt,
+  return CompileImpl(options, name, args, compile_op, CompileMode::kStrict,
                      out_compilation_result, out_executable);
 }
 
@@ -320,9 +346,7 @@ void LogOnceXlaCompiledFirstCluster() {
 Status XlaCompilationCache::CompileImpl(
     const XlaCompiler::Options& options, const NameAttrList& function,
     absl::Span<const XlaCompiler::Argument> args,
-    const std::function<Status(XlaCompiler* compiler,
-                               XlaCompiler::CompilationResult*)>& compile_fn,
-    absl::optional<int64> compile_threshold,
+    const CompileFn& compile_fn, CompileMode compile_mode,
     const XlaCompiler::CompilationResult** out_compilation_result,
     xla::LocalExecutable** out_executable) {
   DCHECK_NE(out_executable, nullptr);
@@ -388,14 +412,19 @@ Status XlaCompilationCache::CompileImpl(
   // cache eviction.
   mutex_lock entry_lock(entry->mu);
   int64 current_request_count = ++entry->request_count;
-  VLOG(2) << "Compilation cache entry hit: " << entry->compiled
+  const string bucket = BucketName(args);
+  if (!bucket.empty()) {
+    RecordBucketLookup(function.name(), bucket,
+                       /*hit=*/entry->state == Entry::State::kCompiled);
+  }
+  VLOG(2) << "Compilation cache entry hit: "
+          << static_cast<int>(entry->state)
           << " signature: " << signature.HumanString() << " with request count "
-          << current_request_count << " and compile threshold "
-          << compile_threshold.value_or(0);
-  if (!entry->compiled) {
+          << current_request_count;
+  if (entry->state == Entry::State::kUncompiled) {
     XLA_SCOPED_LOGGING_TIMER("Compilation of XLA executable");
     const bool should_compile = [&] {
-      if (!compile_threshold.has_value()) {
+      if (compile_mode == CompileMode::kStrict) {
         // Lazy compilation is disabled.
         return true;
       }
@@ -409,23 +438,30 @@ Status XlaCompilationCache::CompileImpl(
         return false;
       }
 
-      if (is_first_execution) {
+      // Background compilations don't stall the caller, so there is no reason
+      // to wait for the compile threshold.
+      if (is_first_execution || compile_mode == CompileMode::kAsync) {
         return true;
       }
 
       bool reached_compile_threshold =
-          current_request_count >= *compile_threshold;
+          current_request_count >= kDefaultCompilationThreshold;
       if (!reached_compile_threshold) {
         VLOG(3)
             << "Not compiling cluster " << function.name()
             << " because it has not reached compile threshold; threshold is "
-            << *compile_threshold << " execution count "
+            << kDefaultCompilationThreshold << " execution count "
             << current_request_count << ".";
       }
       return reached_compile_threshold;
     }();
 
-    if (!should_compile) {
+    if (should_compile && compile_mode == CompileMode::kAsync &&
+        ScheduleAsyncCompilation(entry, options, function, args, compile_fn)) {
+      entry->state = Entry::State::kCompiling;
+    }
+
+    if (!should_compile || compile_mode == CompileMode::kAsync) {
       VLOG(2) << "Not compiling for signature: " << signature.HumanString();
       *out_compilation_result = nullptr;
       *out_executable = nullptr;
@@ -438,45 +474,28 @@ Status XlaCompilationCache::CompileImpl(
     // a long time.)
 
     XlaCompiler compiler(options);
-    entry->compiled = true;
+    entry->state = Entry::State::kCompiled;
 
     entry->compilation_status =
-        compile_fn(&compiler, &entry->compilation_result);
+        compile_fn(&compiler, function, args, &entry->compilation_result);
     TF_RETURN_IF_ERROR(entry->compilation_status);
     CHECK_EQ(entry->executable.get(), nullptr);
     entry->compilation_status =
         BuildExecutable(options, entry->compilation_result, &entry->executable);
 
     const uint64 compile_end_us = env->NowMicros();
-    const uint64 compile_time_us = compile_end_us - compile_start_us;
-    metrics::UpdateXlaCompilationTime(compile_time_us);
-    {
-      mutex_lock lock(cluster_compile_stats_mu_);
-      auto it = cluster_compile_stats_.find(function.name());
-      it->second.compile_count++;
-      it->second.cumulative_compile_time_us += compile_time_us;
-      LogOnceXlaCompiledFirstCluster();
-      VLOG(1) << "compiled " << function.name() << " "
-              << it->second.compile_count
-              << " times, compile time: " << compile_time_us
-              << " us, cumulative: " << it->second.cumulative_compile_time_us
-              << " us ("
-              << tensorflow::strings::HumanReadableElapsedTime(compile_time_us /
-                                                               1.0e6)
-              << " / "
-              << tensorflow::strings::HumanReadableElapsedTime(
-                     it->second.cumulative_compile_time_us / 1.0e6)
-              << ")";
-
-      XlaJitCompilationActivity jit_compilation_activity;
-      jit_compilation_activity.set_cluster_name(function.name());
-      jit_compilation_activity.set_compile_count(it->second.compile_count);
-      jit_compilation_activity.set_compile_time_us(compile_time_us);
-      jit_compilation_activity.set_cumulative_compile_time_us(
-          it->second.cumulative_compile_time_us);
-
-      TF_RETURN_IF_ERROR(
-          BroadcastXlaActivity(std::move(jit_compilation_activity)));
+    TF_RETURN_IF_ERROR(
+        RecordCompilation(function.name(), compile_end_us - compile_start_us));
+  } else if (entry->state == Entry::State::kCompiling) {
+    if (compile_mode != CompileMode::kStrict) {
+      VLOG(2) << "Signature " << signature.HumanString()
+              << " is still being compiled in the background";
+      *out_compilation_result = nullptr;
+      *out_executable = nullptr;
+      return Status::OK();
+    }
+    while (entry->state != Entry::State::kCompiled) {
+      entry->compiled_cv.wait(entry_lock);
     }
   }
   TF_RETURN_IF_ERROR(entry->compilation_status);
@@ -485,4 +504,136 @@ Status XlaCompilationCache::CompileImpl(
   return Status::OK();
 }
 
+bool XlaCompilationCache::ScheduleAsyncCompilation(
+    Entry* entry, const XlaCompiler::Options& options,
+    const NameAttrList& function, absl::Span<const XlaCompiler::Argument> args,
+    const CompileFn& compile_fn) {
+  Env* env = Env::Default();
+  {
+    mutex_lock lock(async_compilation_mu_);
+    if (num_pending_async_compilations_ >= kMaxPendingAsyncCompilations) {
+      VLOG(2) << "Not scheduling a background compilation of "
+              << function.name() << ": " << num_pending_async_compilations_
+              << " compilations are pending";
+      return false;
+    }
+    if (async_compilation_pool_ == nullptr) {
+      async_compilation_pool_ = absl::make_unique<thread::ThreadPool>(
+          env, "xla_async_compilation", kNumAsyncCompilationThreads);
+    }
+    metrics::UpdateXlaAsyncCompilationQueueDepth(
+        ++num_pending_async_compilations_);
+  }
+
+  // The compilation outlives this call, so it can't use anything owned by the
+  // caller: take a snapshot of the function library, and let the backend use
+  // its own allocator rather than the per-call one.
+  std::shared_ptr<const FunctionLibraryDefinition> flib_def;
+  if (options.flib_def != nullptr) {
+    flib_def = std::make_shared<FunctionLibraryDefinition>(*options.flib_def);
+  }
+  XlaCompiler::Options async_options = options;
+  async_options.flib_def = flib_def.get();
+  async_options.device_allocator = nullptr;
+  std::vector<XlaCompiler::Argument> async_args(args.begin(), args.end());
+  const uint64 schedule_time_us = env->NowMicros();
+
+  auto compile = [this, entry, env, async_options, flib_def, function,
+                  async_args = std::move(async_args), compile_fn,
+                  schedule_time_us]() {
+    const uint64 compile_start_us = env->NowMicros();
+    XlaCompiler::CompilationResult compilation_result;
+    std::unique_ptr<xla::LocalExecutable> executable;
+    XlaCompiler compiler(async_options);
+    Status status =
+        compile_fn(&compiler, function, async_args, &compilation_result);
+    if (status.ok()) {
+      status = BuildExecutable(async_options, compilation_result, &executable);
+    }
+    const uint64 compile_end_us = env->NowMicros();
+    if (status.ok()) {
+      Status stats_status =
+          RecordCompilation(function.name(), compile_end_us - compile_start_us);
+      if (!stats_status.ok()) {
+        LOG(WARNING) << "Failed to record the compilation of "
+                     << function.name() << ": " << stats_status;
+      }
+    }
+    metrics::RecordXlaAsyncCompilationLatency(compile_end_us -
+                                              schedule_time_us);
+
+    // Publish the results; callers only read them once `state` is kCompiled.
+    {
+      mutex_lock lock(entry->mu);
+      entry->compilation_status = status;
+      entry->compilation_result = std::move(compilation_result);
+      entry->executable = std::move(executable);
+      entry->state = Entry::State::kCompiled;
+    }
+    entry->compiled_cv.notify_all();
+
+    mutex_lock lock(async_compilation_mu_);
+    metrics::UpdateXlaAsyncCompilationQueueDepth(
+        --num_pending_async_compilations_);
+  };
+
+  mutex_lock lock(async_compilation_mu_);
+  async_compilation_pool_->Schedule(std::move(compile));
+  return true;
+}
+
+Status XlaCompilationCache::RecordCompilation(const string& function_name,
+                                              uint64 compile_time_us) {
+  metrics::UpdateXlaCompilationTime(compile_time_us);
+  mutex_lock lock(cluster_compile_stats_mu_);
+  auto it = cluster_compile_stats_.find(function_name);
+  it->second.compile_count++;
+  it->second.cumulative_compile_time_us += compile_time_us;
+  LogOnceXlaCompiledFirstCluster();
+  VLOG(1) << "compiled " << function_name << " " << it->second.compile_count
+          << " times, compile time: " << compile_time_us
+          << " us, cumulative: " << it->second.cumulative_compile_time_us
+          << " us ("
+          << tensorflow::strings::HumanReadableElapsedTime(compile_time_us /
+                                                           1.0e6)
+          << " / "
+          << tensorflow::strings::HumanReadableElapsedTime(
+                 it->second.cumulative_compile_time_us / 1.0e6)
+          << ")";
+
+  XlaJitCompilationActivity jit_compilation_activity;
+  jit_compilation_activity.set_cluster_name(function_name);
+  jit_compilation_activity.set_compile_count(it->second.compile_count);
+  jit_compilation_activity.set_compile_time_us(compile_time_us);
+  jit_compilation_activity.set_cumulative_compile_time_us(
+      it->second.cumulative_compile_time_us);
+
+  return BroadcastXlaActivity(std::move(jit_compilation_activity));
+}
+
+void XlaCompilationCache::RecordBucketLookup(const string& function_name,
+                                             const string& bucket, bool hit) {
+  metrics::RecordXlaShapeBucketLookup(function_name, bucket, hit);
+  mutex_lock lock(cluster_compile_stats_mu_);
+  BucketStats& stats =
+      cluster_compile_stats_[function_name].bucket_stats[bucket];
+  if (hit) {
+    stats.hits++;
+  } else {
+    stats.misses++;
+  }
+  VLOG(2) << "Shape bucket " << bucket << " of " << function_name << ": "
+          << stats.hits << " hits, " << stats.misses << " misses";
+}
+
+std::map<string, XlaCompilationCache::BucketStats>
+XlaCompilationCache::GetBucketStats(const string& function_name) {
+  mutex_lock lock(cluster_compile_stats_mu_);
+  auto it = cluster_compile_stats_.find(function_name);
+  if (it == cluster_compile_stats_.end()) {
+    return {};
+  }
+  return it->second.bucket_stats;
+}
+
 }  // namespace tensorflow
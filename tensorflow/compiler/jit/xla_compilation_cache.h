@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_JIT_XLA_COMPILATION_CACHE_H_
 #define TENSORFLOW_COMPILER_JIT_XLA_COMPILATION_CACHE_H_
 
+#include <map>
+
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/inlined_vector.h"
 #include "absl/types/optional.h"
@@ -50,6 +52,7 @@ class XlaCompilationCache : public ResourceBase {
   enum class CompileMode {
     kLazy,
     kStrict,
+    kAsync,
   };
 
   // Compiles a function into a XlaCompiler::CompilationResult that can be used
@@ -62,7 +65,12 @@ class XlaCompilationCache : public ResourceBase {
   // heuristics, the compilation cache may decide not to compile the cluster at
   // this time.  In this case it returns null into both `out_compilation_result`
   // and `out_executable`.  If `compile_mode` is `kStrict` then the compilation
-  // cache always attempts the compilation on a cache miss.
+  // cache always attempts the compilation on a cache miss.  If `compile_mode`
+  // is `kAsync` then a cache miss schedules the compilation on a bounded pool
+  // of background threads and returns null, like a lazy miss, until the
+  // executable is ready; callers are expected to run the original TensorFlow
+  // function in the meantime.  Compilation errors are reported by the first
+  // call after the background compilation finished.
   //
   // The result of compilation is written to `*out_compilation_result`, which
   // must be non-null. If `out_executable` is non-null, also builds an
@@ -88,6 +96,19 @@ class XlaCompilationCache : public ResourceBase {
       const XlaCompiler::CompilationResult** out_compilation_result,
       xla::LocalExecutable** out_executable);
 
+  // Lookup statistics of a shape bucket of a cluster whose inputs are
+  // rewritten by a ShapeBucketer.
+  struct BucketStats {
+    // Lookups that found a compiled executable.
+    int64 hits = 0;
+    // Lookups that had to compile, or fell back to TensorFlow.
+    int64 misses = 0;
+  };
+
+  // Returns the lookup statistics of the shape buckets of the cluster
+  // `function_name`, keyed by the comma-separated bucketed dimension sizes.
+  std::map<string, BucketStats> GetBucketStats(const string& function_name);
+
   xla::LocalClient* client() const { return client_; }
   const DeviceType& device_type() const { return device_type_; }
 
@@ -123,13 +144,19 @@ class XlaCompilationCache : public ResourceBase {
       absl::Span<const XlaCompiler::Argument> args);
 
  private:
+  // Compiles `function` with `args` into `result`. Must not capture any
+  // per-call state if used with CompileMode::kAsync, since it may run after
+  // the call that scheduled it returned.
+  using CompileFn = std::function<Status(
+      XlaCompiler* compiler, const NameAttrList& function,
+      absl::Span<const XlaCompiler::Argument> args,
+      XlaCompiler::CompilationResult* result)>;
+
   // Common implementation of Compile and CompileSingleOp.
   Status CompileImpl(
       const XlaCompiler::Options& options, const NameAttrList& function,
-      absl::Span<const XlaCompiler::Argument> args,
-      const std::function<Status(XlaCompiler* compiler,
-                                 XlaCompiler::CompilationResult*)>& compile_fn,
-      absl::optional<int64> compile_threshold,
+      absl::Span<const XlaCompiler::Argument> args, const CompileFn& compile_fn,
+      CompileMode compile_mode,
       const XlaCompiler::CompilationResult** out_compilation_result,
       xla::LocalExecutable** out_executable);
 
@@ -139,15 +166,34 @@ class XlaCompilationCache : public ResourceBase {
                          const XlaCompiler::CompilationResult& result,
                          std::unique_ptr<xla::LocalExecutable>* executable);
 
+  // Updates the compile statistics of the cluster `function_name` after a
+  // compilation that took `compile_time_us`.
+  Status RecordCompilation(const string& function_name, uint64 compile_time_us);
+
+  // Updates the statistics of the shape bucket `bucket` of the cluster
+  // `function_name` after a lookup.
+  void RecordBucketLookup(const string& function_name, const string& bucket,
+                          bool hit);
+
   xla::LocalClient* const client_;
   const DeviceType device_type_;
 
   // The value associated with a cache entry.
   struct Entry {
+    enum class State {
+      kUncompiled,
+      // A background compilation has been scheduled and hasn't finished yet.
+      kCompiling,
+      kCompiled,
+    };
+
     mutex mu;
 
     // Have we tried compiling this entry?
-    bool compiled = false;
+    State state TF_GUARDED_BY(mu) = State::kUncompiled;
+
+    // Notified when `state` becomes kCompiled.
+    condition_variable compiled_cv;
 
     // The number of times a compilation with this signature has been requested.
     int64 request_count = 0;
@@ -163,6 +209,15 @@ class XlaCompilationCache : public ResourceBase {
     std::unique_ptr<xla::LocalExecutable> executable TF_GUARDED_BY(mu);
   };
 
+  // Schedules the compilation of `entry` on the background compilation threads.
+  // Returns false, without scheduling anything, if too many compilations are
+  // pending already.
+  bool ScheduleAsyncCompilation(Entry* entry,
+                                const XlaCompiler::Options& options,
+                                const NameAttrList& function,
+                                absl::Span<const XlaCompiler::Argument> args,
+                                const CompileFn& compile_fn);
+
   mutex compile_cache_mu_;
   absl::flat_hash_map<Signature, std::unique_ptr<Entry>, Signature::Hash> cache_
       TF_GUARDED_BY(compile_cache_mu_);
@@ -181,6 +236,9 @@ class XlaCompilationCache : public ResourceBase {
     // change too frequently) to profitably JIT compile.  Once a cluster is
     // tagged megamorphic, it stays megamorphic forever.
     bool is_megamorphic = false;
+
+    // Lookup statistics of each shape bucket, if the cluster is bucketed.
+    std::map<string, BucketStats> bucket_stats;
   };
 
   mutex cluster_compile_stats_mu_;
@@ -189,10 +247,28 @@ class XlaCompilationCache : public ResourceBase {
   absl::flat_hash_map<string, ClusterCompileStats> cluster_compile_stats_
       TF_GUARDED_BY(cluster_compile_stats_mu_);
 
+  mutex async_compilation_mu_;
+
+  // Runs the kAsync compilations. Created on first use.
+  std::unique_ptr<thread::ThreadPool> async_compilation_pool_
+      TF_GUARDED_BY(async_compilation_mu_);
+
+  // The number of kAsync compilations scheduled or running.
+  int64 num_pending_async_compilations_ TF_GUARDED_BY(async_compilation_mu_) =
+      0;
+
   // The number of times a lazy compilation must be requested for a specific
   // signature before  we attempt to compile it.
   static constexpr int64 kDefaultCompilationThreshold = 2;
 
+  // The number of threads compiling kAsync requests.
+  static constexpr int kNumAsyncCompilationThreads = 2;
+
+  // The maximum number of kAsync compilations scheduled or running at once.
+  // Requests beyond that keep running the TensorFlow fallback and retry on
+  // their next call.
+  static constexpr int64 kMaxPendingAsyncCompilations = 16;
+
   TF_DISALLOW_COPY_AND_ASSIGN(XlaCompilationCache);
 };
 
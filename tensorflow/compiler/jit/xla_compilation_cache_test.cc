@@ -15,13 +15,129 @@ limitations under the License.
 
 #include "tensorflow/compiler/jit/xla_compilation_cache.h"
 
+#include <atomic>
+
 #include "tensorflow/compiler/tf2xla/shape_util.h"
+#include "tensorflow/compiler/tf2xla/xla_op_kernel.h"
+#include "tensorflow/compiler/tf2xla/xla_op_registry.h"
+#include "tensorflow/compiler/xla/client/client_library.h"
+#include "tensorflow/core/framework/common_shape_fns.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/notification.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 
 namespace tensorflow {
 namespace {
 
+// An op whose XLA kernel stands in for a slow compiler: compiling it blocks
+// until `slow_compilation_unblocked` is notified.
+REGISTER_OP("SlowToCompile")
+    .Input("x: float")
+    .Output("y: float")
+    .SetShapeFn(shape_inference::UnchangedShape);
+
+Notification* slow_compilation_unblocked = nullptr;
+std::atomic<int> num_slow_compilations{0};
+
+class SlowToCompileOp : public XlaOpKernel {
+ public:
+  explicit SlowToCompileOp(OpKernelConstruction* ctx) : XlaOpKernel(ctx) {}
+
+  void Compile(XlaOpKernelContext* ctx) override {
+    ++num_slow_compilations;
+    slow_compilation_unblocked->WaitForNotification();
+    ctx->SetOutput(0, ctx->Input(0));
+  }
+};
+
+REGISTER_XLA_OP(Name("SlowToCompile"), SlowToCompileOp);
+
+class XlaCompilationCacheAsyncTest : public ::testing::Test {
+ protected:
+  XlaCompilationCacheAsyncTest()
+      : flib_def_(OpRegistry::Global(), FunctionDefLibrary()) {
+    TF_CHECK_OK(flib_def_.AddFunctionDef(FunctionDefHelper::Define(
+        "SlowFn", {"x: float"}, {"y: float"}, {},
+        {{{"y"}, "SlowToCompile", {"x"}}})));
+    function_.set_name("SlowFn");
+
+    xla::LocalClient* client = xla::ClientLibrary::LocalClientOrDie();
+    cache_ = new XlaCompilationCache(client, DeviceType(DEVICE_CPU_XLA_JIT));
+    options_.client = client;
+    options_.device_type = DeviceType(DEVICE_CPU_XLA_JIT);
+    options_.flib_def = &flib_def_;
+
+    args_.resize(1);
+    args_[0].kind = XlaCompiler::Argument::kParameter;
+    args_[0].type = DT_FLOAT;
+    args_[0].shape = TensorShape({2});
+
+    slow_compilation_unblocked = &unblocked_;
+    num_slow_compilations = 0;
+  }
+
+  ~XlaCompilationCacheAsyncTest() override {
+    if (!unblocked_.HasBeenNotified()) {
+      unblocked_.Notify();
+    }
+    cache_->Unref();
+    slow_compilation_unblocked = nullptr;
+  }
+
+  Status Compile(XlaCompilationCache::CompileMode compile_mode) {
+    return cache_->Compile(options_, function_, args_,
+                           XlaCompiler::CompileOptions(), compile_mode,
+                           &compilation_result_, &executable_);
+  }
+
+  Notification unblocked_;
+  FunctionLibraryDefinition flib_def_;
+  NameAttrList function_;
+  XlaCompilationCache* cache_;
+  XlaCompiler::Options options_;
+  std::vector<XlaCompiler::Argument> args_;
+  const XlaCompiler::CompilationResult* compilation_result_ = nullptr;
+  xla::LocalExecutable* executable_ = nullptr;
+};
+
+TEST_F(XlaCompilationCacheAsyncTest, FallsBackUntilCompiled) {
+  TF_ASSERT_OK(Compile(XlaCompilationCache::CompileMode::kAsync));
+  EXPECT_EQ(compilation_result_, nullptr);
+  EXPECT_EQ(executable_, nullptr);
+
+  // Further calls don't wait for, nor restart, the pending compilation.
+  TF_ASSERT_OK(Compile(XlaCompilationCache::CompileMode::kAsync));
+  EXPECT_EQ(executable_, nullptr);
+
+  unblocked_.Notify();
+  for (int i = 0; executable_ == nullptr; ++i) {
+    ASSERT_LT(i, 1000) << "Background compilation did not finish";
+    Env::Default()->SleepForMicroseconds(10 * 1000);
+    TF_ASSERT_OK(Compile(XlaCompilationCache::CompileMode::kAsync));
+  }
+  EXPECT_NE(compilation_result_, nullptr);
+  EXPECT_EQ(1, num_slow_compilations);
+}
+
+TEST_F(XlaCompilationCacheAsyncTest, StrictCompileWaitsForAsyncCompilation) {
+  TF_ASSERT_OK(Compile(XlaCompilationCache::CompileMode::kAsync));
+  EXPECT_EQ(executable_, nullptr);
+
+  std::unique_ptr<Thread> unblocker(Env::Default()->StartThread(
+      ThreadOptions(), "unblocker", [this] {
+        Env::Default()->SleepForMicroseconds(50 * 1000);
+        unblocked_.Notify();
+      }));
+  TF_ASSERT_OK(Compile(XlaCompilationCache::CompileMode::kStrict));
+  EXPECT_NE(compilation_result_, nullptr);
+  EXPECT_NE(executable_, nullptr);
+  EXPECT_EQ(1, num_slow_compilations);
+}
+
 TEST(XlaCompilationCacheTest, SignatureEquality) {
   NameAttrList fn;
   fn.set_name("afunction");
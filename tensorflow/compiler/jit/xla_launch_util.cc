@@ -24,6 +24,8 @@ limitations under the License.
 #include "tensorflow/compiler/tf2xla/xla_compiler.h"
 #include "tensorflow/compiler/xla/client/client_library.h"
 #include "tensorflow/compiler/xla/client/local_client.h"
+#include "tensorflow/compiler/xla/service/backend.h"
+#include "tensorflow/compiler/xla/service/stream_pool.h"
 #include "tensorflow/compiler/xla/statusor.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/common_runtime/function.h"
@@ -200,7 +202,8 @@ XlaComputationLaunchContext::PopulateInputs(
     const XlaCompiler::CompilationResult* compilation_result,
     const std::map<int, const Tensor*>& resource_vars,
     int missing_ctx_input_prefix,
-    const xla::HloInputOutputAliasConfig& input_output_alias) {
+    const xla::HloInputOutputAliasConfig& input_output_alias,
+    const std::map<int, const Tensor*>& bucketed_inputs) {
   std::vector<xla::ExecutionInput> arguments;
   arguments.reserve(compilation_result->xla_input_shapes.size());
 
@@ -221,9 +224,13 @@ XlaComputationLaunchContext::PopulateInputs(
                          return update.input_index == i && update.modified;
                        });
 
-    const Tensor* t = is_resource_variable
-                          ? resource_vars.at(arg_num)
-                          : &(ctx->input(arg_num - missing_ctx_input_prefix));
+    auto bucketed_it = bucketed_inputs.find(arg_num);
+    const Tensor* t =
+        is_resource_variable
+            ? resource_vars.at(arg_num)
+            : bucketed_it != bucketed_inputs.end()
+                  ? bucketed_it->second
+                  : &(ctx->input(arg_num - missing_ctx_input_prefix));
     CHECK(t);
     bool donate_buffer =
         t->RefCountIsOne() && is_updated_resource_variable &&
@@ -441,14 +448,26 @@ Status XlaComputationLaunchContext::PopulateOutputs(
   std::vector<TensorShape> output_tensor_shapes;
   output_tensor_shapes.reserve(ctx->num_outputs());
   if (output.on_host_shape().is_dynamic()) {
+    // The host platform runs without a stream, but reading the dynamic sizes
+    // still needs one.
+    xla::StreamPool::Ptr borrowed_stream;
+    se::Stream* dynamic_shapes_stream = stream;
+    if (dynamic_shapes_stream == nullptr) {
+      TF_ASSIGN_OR_RETURN(borrowed_stream,
+                          client_->mutable_backend()->BorrowStream(
+                              output.device_ordinal()));
+      dynamic_shapes_stream = borrowed_stream.get();
+    }
     TF_ASSIGN_OR_RETURN(
         auto transfer_manager,
-        xla::TransferManager::GetForPlatform(stream->parent()->platform()));
+        xla::TransferManager::GetForPlatform(
+            dynamic_shapes_stream->parent()->platform()));
 
     xla::Shape output_host_shape = output.on_host_shape();
     xla::Shape output_device_shape = output.on_device_shape();
     TF_RETURN_IF_ERROR(transfer_manager->ReadDynamicShapes(
-        stream, &output, &output_host_shape, &output_device_shape));
+        dynamic_shapes_stream, &output, &output_host_shape,
+        &output_device_shape));
 
     output.set_shapes(output_host_shape, output_device_shape);
     for (int i = 0; i < ctx->num_outputs(); ++i) {
@@ -0,0 +1,71 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/tf2xla/xla_compiled_cpu_function_bundle.h"
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+namespace tensorflow {
+
+namespace {
+
+bool VariantLess(const XlaCompiledCpuFunctionBundle::Variant& a,
+                 const XlaCompiledCpuFunctionBundle::Variant& b) {
+  if (a.signature != b.signature) {
+    return a.signature < b.signature;
+  }
+  return a.batch_size < b.batch_size;
+}
+
+}  // namespace
+
+XlaCompiledCpuFunctionBundle::XlaCompiledCpuFunctionBundle(
+    std::vector<Variant> variants)
+    : variants_(std::move(variants)) {
+  std::sort(variants_.begin(), variants_.end(), VariantLess);
+  assert(std::adjacent_find(variants_.begin(), variants_.end(),
+                            [](const Variant& a, const Variant& b) {
+                              return !VariantLess(a, b);
+                            }) == variants_.end() &&
+         "duplicate variant in bundle");
+}
+
+const XlaCompiledCpuFunctionBundle::Variant*
+XlaCompiledCpuFunctionBundle::Select(const string& signature,
+                                     int64 batch_size) const {
+  // The first variant not less than {signature, batch_size} is the smallest
+  // one that fits, if it belongs to `signature`.
+  auto it = std::lower_bound(
+      variants_.begin(), variants_.end(), batch_size,
+      [&signature](const Variant& variant, int64 batch_size) {
+        int cmp = variant.signature.compare(signature);
+        return cmp < 0 || (cmp == 0 && variant.batch_size < batch_size);
+      });
+  if (it == variants_.end() || it->signature != signature) {
+    return nullptr;
+  }
+  return &*it;
+}
+
+std::unique_ptr<XlaCompiledCpuFunction> XlaCompiledCpuFunctionBundle::Create(
+    const Variant& variant,
+    XlaCompiledCpuFunction::AllocMode alloc_mode) const {
+  return std::unique_ptr<XlaCompiledCpuFunction>(
+      new XlaCompiledCpuFunction(*variant.static_data, alloc_mode));
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,84 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_TF2XLA_XLA_COMPILED_CPU_FUNCTION_BUNDLE_H_
+#define TENSORFLOW_COMPILER_TF2XLA_XLA_COMPILED_CPU_FUNCTION_BUNDLE_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/compiler/tf2xla/xla_compiled_cpu_function.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A set of functions compiled ahead of time from several signatures, each in
+// several batch-size specializations, as produced by the tf_library_bundle
+// build macro.
+//
+// The bundle only selects a compiled specialization: Select picks the one of a
+// signature with the smallest batch size that fits a request.  Padding the
+// request to that batch size is up to the caller, e.g. by writing it into the
+// first rows of the batched arguments and reading the first rows of the
+// batched results.  That is only correct if the rows of the compiled
+// computation are independent of each other, which the bundle doesn't check:
+// a computation that e.g. reduces over the batch mixes the padding rows into
+// every result.
+//
+// Example usage:
+//   const XlaCompiledCpuFunctionBundle& bundle = MyBundle();
+//   const XlaCompiledCpuFunctionBundle::Variant* variant =
+//       bundle.Select("serve", request_batch_size);
+//   std::unique_ptr<XlaCompiledCpuFunction> function = bundle.Create(*variant);
+//   ... set args in function->arg_data(0), ...
+//   function->Run();
+class XlaCompiledCpuFunctionBundle {
+ public:
+  // One specialization of a signature.
+  struct Variant {
+    string signature;
+    int64 batch_size;
+    const XlaCompiledCpuFunction::StaticData* static_data;
+  };
+
+  // `variants` may be given in any order, but each pair of signature and batch
+  // size must be unique.
+  explicit XlaCompiledCpuFunctionBundle(std::vector<Variant> variants);
+
+  XlaCompiledCpuFunctionBundle(const XlaCompiledCpuFunctionBundle&) = delete;
+  XlaCompiledCpuFunctionBundle& operator=(
+      const XlaCompiledCpuFunctionBundle&) = delete;
+
+  // Returns the variant of `signature` with the smallest batch size that is at
+  // least `batch_size`, or nullptr if `signature` has no such variant.
+  const Variant* Select(const string& signature, int64 batch_size) const;
+
+  // Creates a function that runs `variant`, which must be one of variants().
+  std::unique_ptr<XlaCompiledCpuFunction> Create(
+      const Variant& variant,
+      XlaCompiledCpuFunction::AllocMode alloc_mode = XlaCompiledCpuFunction::
+          AllocMode::ARGS_VARIABLES_RESULTS_PROFILES_AND_TEMPS) const;
+
+  // The variants, ordered by signature and then by increasing batch size.
+  const std::vector<Variant>& variants() const { return variants_; }
+
+ private:
+  std::vector<Variant> variants_;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMPILER_TF2XLA_XLA_COMPILED_CPU_FUNCTION_BUNDLE_H_
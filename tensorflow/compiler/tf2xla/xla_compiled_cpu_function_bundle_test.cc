@@ -0,0 +1,64 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/tf2xla/xla_compiled_cpu_function_bundle.h"
+
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class XlaCompiledCpuFunctionBundleTest : public ::testing::Test {
+ protected:
+  XlaCompiledCpuFunctionBundleTest()
+      : bundle_({{"serve", 16, &serve_16_},
+                 {"serve", 1, &serve_1_},
+                 {"serve", 4, &serve_4_},
+                 {"embed", 8, &embed_8_}}) {}
+
+  XlaCompiledCpuFunction::StaticData serve_1_;
+  XlaCompiledCpuFunction::StaticData serve_4_;
+  XlaCompiledCpuFunction::StaticData serve_16_;
+  XlaCompiledCpuFunction::StaticData embed_8_;
+  XlaCompiledCpuFunctionBundle bundle_;
+};
+
+TEST_F(XlaCompiledCpuFunctionBundleTest, VariantsAreSorted) {
+  const auto& variants = bundle_.variants();
+  ASSERT_EQ(variants.size(), 4);
+  EXPECT_EQ(variants[0].static_data, &embed_8_);
+  EXPECT_EQ(variants[1].static_data, &serve_1_);
+  EXPECT_EQ(variants[2].static_data, &serve_4_);
+  EXPECT_EQ(variants[3].static_data, &serve_16_);
+}
+
+TEST_F(XlaCompiledCpuFunctionBundleTest, SelectsSmallestFittingBatchSize) {
+  EXPECT_EQ(bundle_.Select("serve", 1)->static_data, &serve_1_);
+  EXPECT_EQ(bundle_.Select("serve", 2)->static_data, &serve_4_);
+  EXPECT_EQ(bundle_.Select("serve", 4)->static_data, &serve_4_);
+  EXPECT_EQ(bundle_.Select("serve", 5)->static_data, &serve_16_);
+  EXPECT_EQ(bundle_.Select("serve", 16)->static_data, &serve_16_);
+  EXPECT_EQ(bundle_.Select("embed", 1)->static_data, &embed_8_);
+}
+
+TEST_F(XlaCompiledCpuFunctionBundleTest, SelectsNothingThatDoesNotFit) {
+  EXPECT_EQ(bundle_.Select("serve", 17), nullptr);
+  // The next signature's variants don't fit "embed".
+  EXPECT_EQ(bundle_.Select("embed", 9), nullptr);
+  EXPECT_EQ(bundle_.Select("unknown", 1), nullptr);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -561,6 +561,20 @@ static void AllocateFlags() {
       flag_values->xla_cpu_enable_xprof_traceme(),
       "If true, XLA CPU generates code to call "
       "TraceMe::Activity{Start|End} around HLO operations."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_cpu_persistent_cache_dir",
+      string_setter_for(&DebugOptions::set_xla_cpu_persistent_cache_dir),
+      flag_values->xla_cpu_persistent_cache_dir(),
+      "Directory of an on-disk cache of XLA:CPU compilation results. If set, "
+      "optimized HLO and object code are reused across processes that compile "
+      "the same module for the same target machine."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_cpu_parallel_task_profile",
+      string_setter_for(&DebugOptions::set_xla_cpu_parallel_task_profile),
+      flag_values->xla_cpu_parallel_task_profile(),
+      "Path of the hlo_execution_profile_data dumped by a previous "
+      "--xla_hlo_profile run of the same module. If set, XLA:CPU picks "
+      "parallel task counts from the measured instruction run times."));
   flag_objects->push_back(tensorflow::Flag(
       "xla_gpu_unsafe_fallback_to_driver_on_ptxas_not_found",
       bool_setter_for(
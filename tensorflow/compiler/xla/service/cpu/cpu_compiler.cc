@@ -18,7 +18,9 @@ limitations under the License.
 #include <stddef.h>
 #include <string.h>
 
+#include <functional>
 #include <map>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -29,6 +31,7 @@ limitations under the License.
 #include "absl/base/call_once.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
+#include "absl/types/optional.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/IR/Function.h"
@@ -38,6 +41,7 @@ limitations under the License.
 #include "llvm/IR/Verifier.h"
 #include "llvm/Object/ObjectFile.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Target/TargetMachine.h"
@@ -65,11 +69,13 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/cpu/cpu_executable.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_instruction_fusion.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_layout_assignment.h"
+#include "tensorflow/compiler/xla/service/cpu/cpu_multi_output_fusion.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_options.h"
 #include "tensorflow/compiler/xla/service/cpu/dot_op_emitter.h"
 #include "tensorflow/compiler/xla/service/cpu/ir_emission_utils.h"
 #include "tensorflow/compiler/xla/service/cpu/ir_emitter.h"
 #include "tensorflow/compiler/xla/service/cpu/parallel_task_assignment.h"
+#include "tensorflow/compiler/xla/service/cpu/persistent_compilation_cache.h"
 #include "tensorflow/compiler/xla/service/cpu/simple_orc_jit.h"
 #include "tensorflow/compiler/xla/service/dfs_hlo_visitor_with_default.h"
 #include "tensorflow/compiler/xla/service/dot_decomposer.h"
@@ -238,11 +244,19 @@ class CollectProfileCandidates : public DfsHloVisitorWithDefault {
   const std::unordered_map<const HloInstruction*, int64>& assigned_indices_;
 };
 
+// The maximum parallel task count per instruction.
+int MaxParallelism(const HloModuleConfig& config) {
+  return config.intra_op_parallelism_threads() > 0
+             ? config.intra_op_parallelism_threads()
+             : tensorflow::port::NumSchedulableCPUs();
+}
+
 }  // namespace
 
 Status CpuCompiler::RunHloPassesThroughLayoutAssn(
-    HloModule* module, bool /*is_aot_compile*/,
-    LLVMTargetMachineFeatures* target_machine_features) {
+    HloModule* module, bool is_aot_compile,
+    LLVMTargetMachineFeatures* target_machine_features,
+    const ParallelTaskProfile* parallel_task_profile) {
   HloPassPipeline pipeline("HLO passes through layout assignment");
   pipeline.AddInvariantChecker<HloVerifier>(/*layout_sensitive=*/false,
                                             /*allow_mixed_precision=*/false);
@@ -339,14 +353,30 @@ Status CpuCompiler::RunHloPassesThroughLayoutAssn(
       module->mutable_entry_computation_layout(),
       LayoutAssignment::InstructionCanChangeLayout, target_machine_features);
 
-  pipeline.AddPass<CpuInstructionFusion>();
+  // The low precision GEMM runtime is only linked into JIT compiled code.
+  const bool fuse_low_precision_gemms =
+      !is_aot_compile && !options::LowPrecisionGemmDisabled(module->config());
+  pipeline.AddPass<CpuInstructionFusion>(
+      /*low_precision_gemm_target=*/fuse_low_precision_gemms
+          ? target_machine_features
+          : nullptr);
+  if (!options::MultiOutputFusionDisabled(module->config())) {
+    // Nothing is parallelized in AOT compiled code, see
+    // RunHloPassesAfterLayoutAssn.
+    pipeline.AddPass<CpuMultiOutputFusion>(
+        /*max_parallelism=*/is_aot_compile ? 1
+                                           : MaxParallelism(module->config()),
+        ShapeSizeBytesFunction(), target_machine_features,
+        parallel_task_profile);
+  }
 
   return pipeline.Run(module).status();
 }
 
 Status CpuCompiler::RunHloPassesAfterLayoutAssn(
     HloModule* module, bool is_aot_compile,
-    LLVMTargetMachineFeatures* target_machine_features) {
+    LLVMTargetMachineFeatures* target_machine_features,
+    const ParallelTaskProfile* parallel_task_profile) {
   HloPassPipeline pipeline("HLO passes after layout assignment");
   // After layout assignment, use a layout-sensitive verifier.
 
@@ -375,10 +405,7 @@ Status CpuCompiler::RunHloPassesAfterLayoutAssn(
   pipeline.AddPass<HloElementTypeConverter>(BF16, F32);
 
   // Outline ops in the entry computation into calls to subcomputations.
-  const int max_parallelism =
-      module->config().intra_op_parallelism_threads() > 0
-          ? module->config().intra_op_parallelism_threads()
-          : tensorflow::port::NumSchedulableCPUs();
+  const int max_parallelism = MaxParallelism(module->config());
   if (!is_aot_compile) {
     // Run ParallelTaskAssigner to assign parallel tasks to HLOs in module.
     // Note this is not run for AOT because it would bring in thread pool
@@ -386,7 +413,8 @@ Status CpuCompiler::RunHloPassesAfterLayoutAssn(
     // binary size (and most AOT applications are single-threaded).
     // TODO(b/29630486) Support multi-threaded AOT.
     pipeline.AddPass<ParallelTaskAssigner>(
-        max_parallelism, ShapeSizeBytesFunction(), target_machine_features);
+        max_parallelism, ShapeSizeBytesFunction(), target_machine_features,
+        parallel_task_profile);
   }
   // Copy insertion should be performed immediately before IR emission to
   // avoid inserting unnecessary copies (later pass adds an instruction which
@@ -403,10 +431,18 @@ Status CpuCompiler::RunHloPassesAfterLayoutAssn(
 Status CpuCompiler::RunHloPasses(HloModule* module, bool is_aot_compile,
                                  llvm::TargetMachine* target_machine) {
   LLVMTargetMachineFeatures target_machine_features(target_machine);
-  TF_RETURN_IF_ERROR(RunHloPassesThroughLayoutAssn(module, is_aot_compile,
-                                                   &target_machine_features));
+  // Shared by CpuMultiOutputFusion and ParallelTaskAssigner. Nothing is
+  // parallelized in AOT compiled code.
+  std::unique_ptr<ParallelTaskProfile> parallel_task_profile;
+  if (!is_aot_compile) {
+    parallel_task_profile = ParallelTaskProfile::LoadForModule(*module);
+  }
+  TF_RETURN_IF_ERROR(RunHloPassesThroughLayoutAssn(
+      module, is_aot_compile, &target_machine_features,
+      parallel_task_profile.get()));
   return RunHloPassesAfterLayoutAssn(module, is_aot_compile,
-                                     &target_machine_features);
+                                     &target_machine_features,
+                                     parallel_task_profile.get());
 }
 
 namespace {
@@ -510,7 +546,8 @@ Status CreateHloProfilingArtifacts(
   HloCostAnalysis cost_analysis(shape_size_bytes);
   TF_RETURN_IF_ERROR(entry_computation.Accept(&cost_analysis));
   *hlo_profile_printer_data = CreateHloProfilePrinterData(
-      **hlo_profile_index_map, cost_analysis, entry_computation.name());
+      **hlo_profile_index_map, cost_analysis, entry_computation.name(),
+      module.name());
   *computation_to_profile_idx =
       (*hlo_profile_index_map)->computation_to_profile_idx();
 
@@ -527,9 +564,42 @@ StatusOr<std::unique_ptr<HloModule>> CpuCompiler::RunHloPasses(
           CompilerTargetOptions(module->config()),
           CodeGenOptLevel(module->config()));
 
-  TF_RETURN_IF_ERROR(RunHloPasses(module.get(), /*is_aot_compile=*/false,
-                                  jit_target_machine.get()));
-  return std::move(module);
+  std::unique_ptr<PersistentCompilationCache> persistent_cache =
+      PersistentCompilationCache::ForModule(*module);
+  if (persistent_cache == nullptr) {
+    TF_RETURN_IF_ERROR(RunHloPasses(module.get(), /*is_aot_compile=*/false,
+                                    jit_target_machine.get()));
+    return std::move(module);
+  }
+
+  const std::string cache_key = PersistentCompilationCache::Key(
+      *module, *jit_target_machine, /*stage=*/"hlo");
+  absl::optional<PersistentCompilationCacheEntry> cached_entry =
+      persistent_cache->Lookup(cache_key);
+  if (!cached_entry.has_value()) {
+    TF_RETURN_IF_ERROR(RunHloPasses(module.get(), /*is_aot_compile=*/false,
+                                    jit_target_machine.get()));
+    cached_entry.emplace();
+    *cached_entry->mutable_optimized_module() = module->ToProto();
+    Status status = persistent_cache->Insert(cache_key, *cached_entry);
+    if (!status.ok()) {
+      LOG(WARNING) << "Failed to cache optimized HLO module " << module->name()
+                   << ": " << status;
+    }
+  } else {
+    VLOG(1) << "Loaded optimized HLO module " << module->name()
+            << " from the persistent compilation cache";
+  }
+
+  // Both a cold and a warm compilation continue with the module deserialized
+  // from the cache entry, so that the backend (and its cache key) sees
+  // exactly the same module either way.
+  const HloModuleProto& optimized_module = cached_entry->optimized_module();
+  HloModuleConfig config = module->config();
+  *config.mutable_entry_computation_layout() = ComputationLayout(
+      ProgramShape(optimized_module.host_program_shape()),
+      /*ignore_layouts=*/false);
+  return HloModule::CreateFromProto(optimized_module, config);
 }
 
 StatusOr<
@@ -621,14 +691,30 @@ StatusOr<std::unique_ptr<Executable>> CpuCompiler::RunBackend(
       mlir_context.getRegisteredDialect<mlir::LLVM::LLVMDialect>()
           ->getLLVMContext());
 
+  // The persistent cache can't replay user IR hooks, so it is bypassed when
+  // they are installed.
+  std::unique_ptr<PersistentCompilationCache> persistent_cache;
+  if (!user_pre_optimization_hook_ && !user_post_optimization_hook_) {
+    persistent_cache = PersistentCompilationCache::ForModule(*module);
+  }
+  std::function<void(const llvm::object::ObjectFile&)> post_codegen_hook =
+      OrcJITPostCompilationHook::Create(module.get());
+  auto object_code = std::make_shared<std::string>();
+  if (persistent_cache != nullptr) {
+    post_codegen_hook = [post_codegen_hook,
+                         object_code](const llvm::object::ObjectFile& obj_file) {
+      post_codegen_hook(obj_file);
+      object_code->assign(obj_file.getData().data(), obj_file.getData().size());
+    };
+  }
+
   auto jit = absl::make_unique<SimpleOrcJIT>(
       CompilerTargetOptions(module->config()),
       CodeGenOptLevel(module->config()),
       options::OptimizeForSizeRequested(module->config()),
       module->config().debug_options().xla_llvm_disable_expensive_passes(),
       llvm_ir::GetCpuFastMathFlags(module->config()), pre_optimization_ir_hook,
-      post_optimization_ir_hook,
-      OrcJITPostCompilationHook::Create(module.get()));
+      post_optimization_ir_hook, std::move(post_codegen_hook));
   llvm_module->setDataLayout(jit->data_layout());
   llvm_module->setTargetTriple(jit->target_triple().getTriple());
 
@@ -667,6 +753,31 @@ StatusOr<std::unique_ptr<Executable>> CpuCompiler::RunBackend(
                           /*allocate_buffers_for_constants=*/true));
   DumpHloModuleIfEnabled(*module, *assignment, "after_optimizations");
 
+  std::string cache_key;
+  if (persistent_cache != nullptr) {
+    cache_key = PersistentCompilationCache::Key(*module, *jit->target_machine(),
+                                                /*stage=*/"backend");
+    absl::optional<PersistentCompilationCacheEntry> cached_entry =
+        persistent_cache->Lookup(cache_key);
+    // The cached object code hardcodes buffer offsets, so it is only usable
+    // if the buffer assignment we just computed is the one it was emitted
+    // against.
+    if (cached_entry.has_value() &&
+        protobuf_util::ProtobufEquals(assignment->ToProto(),
+                                      cached_entry->buffer_assignment())) {
+      VLOG(1) << "Loaded object code for " << module->name()
+              << " from the persistent compilation cache";
+      jit->AddObjectFile(
+          llvm::MemoryBuffer::getMemBufferCopy(cached_entry->object_code()));
+      cpu_executable.reset(new CpuExecutable(
+          std::move(jit), std::move(assignment), std::move(module),
+          cached_entry->entry_function_name(),
+          std::move(hlo_profile_printer_data),
+          std::move(hlo_profile_index_map)));
+      return std::move(cpu_executable);
+    }
+  }
+
   // Each computation is a single function.  Emit all embedded computations
   // before the entry computation. The order of computations returned from
   // GetEmbeddedComputations guarantees that a called computation occurs
@@ -724,6 +835,19 @@ StatusOr<std::unique_ptr<Executable>> CpuCompiler::RunBackend(
 
   // JIT compile the LLVM IR module to in-memory machine code.
   jit->AddModule(std::move(llvm_module));
+
+  if (persistent_cache != nullptr) {
+    PersistentCompilationCacheEntry entry;
+    entry.set_object_code(std::move(*object_code));
+    entry.set_entry_function_name(function_name);
+    *entry.mutable_buffer_assignment() = assignment->ToProto();
+    Status status = persistent_cache->Insert(cache_key, entry);
+    if (!status.ok()) {
+      LOG(WARNING) << "Failed to cache object code for " << module->name()
+                   << ": " << status;
+    }
+  }
+
   cpu_executable.reset(new CpuExecutable(
       std::move(jit), std::move(assignment), std::move(module), function_name,
       std::move(hlo_profile_printer_data), std::move(hlo_profile_index_map)));
@@ -21,6 +21,7 @@ limitations under the License.
 #include "absl/types/span.h"
 #include "llvm/Target/TargetMachine.h"
 #include "tensorflow/compiler/xla/cpu_function_runtime.h"
+#include "tensorflow/compiler/xla/service/cpu/parallel_task_assignment.h"
 #include "tensorflow/compiler/xla/service/cpu/target_machine_features.h"
 #include "tensorflow/compiler/xla/service/executable.h"
 #include "tensorflow/compiler/xla/service/hlo_module.h"
@@ -164,14 +165,18 @@ class CpuCompiler : public LLVMCompiler {
                       llvm::TargetMachine* target_machine);
 
   // Runs HLO passes up to and including layout assignment.
+  // 'parallel_task_profile' may be null.
   Status RunHloPassesThroughLayoutAssn(
       HloModule* module, bool /*is_aot_compile*/,
-      LLVMTargetMachineFeatures* target_machine_features);
+      LLVMTargetMachineFeatures* target_machine_features,
+      const ParallelTaskProfile* parallel_task_profile);
 
   // Runs HLO passes after layout assignment.
+  // 'parallel_task_profile' may be null.
   Status RunHloPassesAfterLayoutAssn(
       HloModule* module, bool is_aot_compile,
-      LLVMTargetMachineFeatures* target_machine_features);
+      LLVMTargetMachineFeatures* target_machine_features,
+      const ParallelTaskProfile* parallel_task_profile);
 
   TF_DISALLOW_COPY_AND_ASSIGN(CpuCompiler);
 };
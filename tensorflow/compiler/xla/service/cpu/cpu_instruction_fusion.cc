@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/cpu/cpu_instruction_fusion.h"
 
+#include "tensorflow/compiler/xla/service/cpu/ir_emission_utils.h"
 #include "tensorflow/compiler/xla/service/fusion_node_indexing_evaluation.h"
 #include "tensorflow/compiler/xla/service/hlo_opcode.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/fused_ir_emitter.h"
@@ -119,6 +120,14 @@ bool CpuInstructionFusion::ShouldFuse(HloInstruction* consumer,
     return false;
   }
 
+  if (low_precision_gemm_target_ != nullptr &&
+      CanBeLowPrecisionGemm(*consumer, *low_precision_gemm_target_)) {
+    // The low precision GEMM runtime reads the narrow operands directly, so
+    // only their widening converts are fused into the dot.
+    VLOG(2) << "Consumer is a low precision GEMM.";
+    return IsLowPrecisionGemmOperand(*producer);
+  }
+
   // Don't fuse if fusing would cause too much code duplication because of
   // inefficiencies in the fusion emitter.
   // TODO(b/119692968): Remove this once the fusion emitter can handle
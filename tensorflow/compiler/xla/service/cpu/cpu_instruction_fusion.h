@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_COMPILER_XLA_SERVICE_CPU_CPU_INSTRUCTION_FUSION_H_
 
 #include "absl/container/flat_hash_map.h"
+#include "tensorflow/compiler/xla/service/cpu/target_machine_features.h"
 #include "tensorflow/compiler/xla/service/fusion_node_indexing_evaluation.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
 #include "tensorflow/compiler/xla/service/instruction_fusion.h"
@@ -26,8 +27,14 @@ namespace cpu {
 
 class CpuInstructionFusion : public InstructionFusion {
  public:
-  CpuInstructionFusion()
-      : InstructionFusion(CpuInstructionFusion::IsExpensive) {}
+  // If 'low_precision_gemm_target' is not null, the widening converts of int8
+  // and bfloat16 dot operands are fused into the dots that
+  // CanBeLowPrecisionGemm accepts for that target, which are then emitted as
+  // calls to the low precision GEMM runtime.
+  explicit CpuInstructionFusion(
+      const TargetMachineFeatures* low_precision_gemm_target = nullptr)
+      : InstructionFusion(CpuInstructionFusion::IsExpensive),
+        low_precision_gemm_target_(low_precision_gemm_target) {}
   ~CpuInstructionFusion() override = default;
 
   StatusOr<bool> Run(HloModule* module) override {
@@ -44,6 +51,8 @@ class CpuInstructionFusion : public InstructionFusion {
   HloInstruction* FuseInstruction(HloInstruction* fusion_instruction,
                                   HloInstruction* producer) override;
 
+  const TargetMachineFeatures* low_precision_gemm_target_;
+
   // Keep track of the number of times each instruction inside a fusion node is
   // indexed with different index vectors.
   absl::flat_hash_map<const HloInstruction*, FusionNodeIndexingEvaluation>
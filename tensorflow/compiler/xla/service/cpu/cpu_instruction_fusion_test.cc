@@ -18,9 +18,13 @@ limitations under the License.
 #include <algorithm>
 #include <memory>
 #include <set>
+#include <string>
+#include <vector>
 
 #include "absl/strings/str_cat.h"
 #include "absl/types/span.h"
+#include "tensorflow/compiler/xla/service/cpu/runtime_low_precision_matmul_impl.h"
+#include "tensorflow/compiler/xla/service/cpu/target_machine_features_fake.h"
 #include "tensorflow/compiler/xla/service/hlo_matchers.h"
 #include "tensorflow/compiler/xla/service/transpose_folding.h"
 #include "tensorflow/compiler/xla/shape.h"
@@ -945,6 +949,89 @@ ENTRY main {
   EXPECT_TRUE(fused_something);
   EXPECT_THAT(module->entry_computation()->root_instruction(), op::Fusion());
 }
+
+// A dot of int8 operands widened to int32, and one of bfloat16 operands widened
+// to float.
+const char* const kS8DotModule = R"(
+HloModule module
+
+ENTRY main {
+  lhs = s8[64,96]{1,0} parameter(0)
+  rhs = s8[96,48]{1,0} parameter(1)
+  lhs_wide = s32[64,96]{1,0} convert(lhs)
+  rhs_wide = s32[96,48]{1,0} convert(rhs)
+  ROOT dot = s32[64,48]{1,0} dot(lhs_wide, rhs_wide),
+    lhs_contracting_dims={1}, rhs_contracting_dims={0}
+}
+)";
+
+const char* const kBF16DotModule = R"(
+HloModule module
+
+ENTRY main {
+  lhs = bf16[64,96]{1,0} parameter(0)
+  rhs = bf16[96,48]{1,0} parameter(1)
+  lhs_wide = f32[64,96]{1,0} convert(lhs)
+  rhs_wide = f32[96,48]{1,0} convert(rhs)
+  ROOT dot = f32[64,48]{1,0} dot(lhs_wide, rhs_wide),
+    lhs_contracting_dims={1}, rhs_contracting_dims={0}
+}
+)";
+
+TargetMachineFeaturesWithFakeAlignmentLogic MakeTargetMachineFeatures(
+    std::vector<std::string> target_features) {
+  return TargetMachineFeaturesWithFakeAlignmentLogic(
+      [](int64 shape_size) {
+        return TargetMachineFeatures::kEigenExpectedTensorAlignment;
+      },
+      std::move(target_features));
+}
+
+TEST_F(InstructionFusionTest, LowPrecisionGemmFusedOnTargetWithVnni) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(kS8DotModule));
+  auto target_machine_features =
+      MakeTargetMachineFeatures({"avx512f", "avx512bw", "avx512vnni"});
+  TF_ASSERT_OK_AND_ASSIGN(
+      bool fused_something,
+      CpuInstructionFusion(&target_machine_features).Run(module.get()));
+  // The runtime is only used if it was built with the VNNI kernel.
+  if (::tensorflow::xla::kLowPrecisionMatMulHasAvx512Kernels) {
+    EXPECT_TRUE(fused_something);
+    EXPECT_THAT(module->entry_computation()->root_instruction(),
+                op::Fusion(op::Parameter(), op::Parameter()));
+  } else {
+    EXPECT_FALSE(fused_something);
+  }
+}
+
+TEST_F(InstructionFusionTest, LowPrecisionGemmNotFusedOnTargetWithoutVnni) {
+  // Without dot product instructions, Eigen's s32 GEMM is faster than the
+  // portable kernel of the low precision GEMM runtime.
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(kS8DotModule));
+  auto target_machine_features =
+      MakeTargetMachineFeatures({"avx512f", "avx512bw", "avx512bf16"});
+  TF_ASSERT_OK_AND_ASSIGN(
+      bool fused_something,
+      CpuInstructionFusion(&target_machine_features).Run(module.get()));
+  EXPECT_FALSE(fused_something);
+  EXPECT_THAT(module->entry_computation()->root_instruction(),
+              op::Dot(op::Convert(), op::Convert()));
+}
+
+TEST_F(InstructionFusionTest, LowPrecisionGemmNotFusedOnTargetWithoutBF16) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(kBF16DotModule));
+  auto target_machine_features =
+      MakeTargetMachineFeatures({"avx512f", "avx512bw", "avx512vnni"});
+  TF_ASSERT_OK_AND_ASSIGN(
+      bool fused_something,
+      CpuInstructionFusion(&target_machine_features).Run(module.get()));
+  EXPECT_FALSE(fused_something);
+  EXPECT_THAT(module->entry_computation()->root_instruction(),
+              op::Dot(op::Convert(), op::Convert()));
+}
 }  // namespace
 }  // namespace cpu
 }  // namespace xla
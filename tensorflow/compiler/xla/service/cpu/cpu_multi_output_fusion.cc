@@ -0,0 +1,249 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/cpu/cpu_multi_output_fusion.h"
+
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_format.h"
+#include "tensorflow/compiler/xla/debug_options_flags.h"
+#include "tensorflow/compiler/xla/layout_util.h"
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_opcode.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+
+namespace xla {
+namespace cpu {
+
+namespace {
+
+// Returns the outputs of 'instr': the operands of the root tuple of a
+// multi-output fusion, the root of any other fusion, or 'instr' itself.
+std::vector<const HloInstruction*> GetOutputs(const HloInstruction& instr) {
+  if (instr.opcode() != HloOpcode::kFusion) {
+    return {&instr};
+  }
+  const HloInstruction* root = instr.fused_expression_root();
+  if (root->opcode() != HloOpcode::kTuple) {
+    return {root};
+  }
+  return std::vector<const HloInstruction*>(root->operands().begin(),
+                                            root->operands().end());
+}
+
+// Reductions over the minor dimension are emitted elementally; reductions
+// that keep it have a vectorized lowering that's only implemented for the
+// unfused case, so they are left alone (as in CpuInstructionFusion).
+bool IsRowReduction(const HloInstruction* hlo) {
+  return hlo->opcode() == HloOpcode::kReduce && hlo->shape().IsArray() &&
+         absl::c_linear_search(
+             hlo->dimensions(),
+             LayoutUtil::Minor(hlo->operand(0)->shape().layout(), 0));
+}
+
+bool IsFusibleOutput(const HloInstruction* hlo) {
+  if (!hlo->shape().IsArray()) {
+    return false;
+  }
+  if (hlo->opcode() == HloOpcode::kReduce) {
+    return IsRowReduction(hlo);
+  }
+  // Dots, including the low precision GEMMs of fused converts, have their own
+  // emitters that a shared loop would replace with a naive one.
+  if (hlo->opcode() == HloOpcode::kDot) {
+    return false;
+  }
+  // In-place dynamic-update-slices lose their in-place emission when fused
+  // with other outputs.
+  return hlo->opcode() != HloOpcode::kDynamicUpdateSlice;
+}
+
+bool SameReducedDimensions(const HloInstruction* a, const HloInstruction* b) {
+  std::vector<int64> a_dims(a->dimensions().begin(), a->dimensions().end());
+  std::vector<int64> b_dims(b->dimensions().begin(), b->dimensions().end());
+  absl::c_sort(a_dims);
+  absl::c_sort(b_dims);
+  return a_dims == b_dims;
+}
+
+}  // namespace
+
+/*static*/ bool CpuMultiOutputFusion::OutputsCompatible(
+    const HloInstruction& instr1, const HloInstruction& instr2) {
+  std::vector<const HloInstruction*> outputs = GetOutputs(instr1);
+  if (&instr1 != &instr2) {
+    std::vector<const HloInstruction*> outputs2 = GetOutputs(instr2);
+    outputs.insert(outputs.end(), outputs2.begin(), outputs2.end());
+  }
+
+  auto reduce_it = absl::c_find_if(outputs, [](const HloInstruction* output) {
+    return output->opcode() == HloOpcode::kReduce;
+  });
+  if (reduce_it == outputs.end()) {
+    // A plain loop over the common output shape.
+    return absl::c_all_of(outputs, [&](const HloInstruction* output) {
+      return ShapeUtil::EqualIgnoringElementType(output->shape(),
+                                                 outputs[0]->shape());
+    });
+  }
+
+  // A loop over the reduced input, which computes the reductions and writes
+  // the elementwise outputs as it goes.
+  const HloInstruction* reduce = *reduce_it;
+  const Shape& input_shape = reduce->operand(0)->shape();
+  return absl::c_all_of(outputs, [&](const HloInstruction* output) {
+    if (output->opcode() == HloOpcode::kReduce) {
+      return ShapeUtil::EqualIgnoringElementType(output->operand(0)->shape(),
+                                                 input_shape) &&
+             SameReducedDimensions(output, reduce);
+    }
+    return ShapeUtil::EqualIgnoringElementType(output->shape(), input_shape);
+  });
+}
+
+StatusOr<bool> CpuMultiOutputFusion::Run(HloModule* module) {
+  parallel_task_assignment_ = absl::make_unique<ParallelTaskAssignment>(
+      max_parallelism_, shape_size_, module, &target_machine_features_,
+      profile_);
+  return MultiOutputFusion::Run(module);
+}
+
+bool CpuMultiOutputFusion::ShapesCompatibleForFusion(HloInstruction* instr1,
+                                                     HloInstruction* instr2) {
+  return OutputsCompatible(*instr1, *instr2);
+}
+
+bool CpuMultiOutputFusion::IsFusible(HloInstruction* instr) {
+  if (instr->opcode() == HloOpcode::kFusion) {
+    if (!instr->IsLoopFusion()) {
+      return false;
+    }
+  } else if (instr->opcode() != HloOpcode::kReduce &&
+             !instr->IsElementwise()) {
+    return false;
+  }
+  if (instr->opcode() == HloOpcode::kConstant ||
+      instr->opcode() == HloOpcode::kParameter || instr->HasSideEffect()) {
+    return false;
+  }
+  // Fusing an instruction that would run as several parallel tasks would
+  // serialize it.  Multi-output fusions are already single tasks.
+  if (!instr->shape().IsTuple() &&
+      parallel_task_assignment_->GetTargetParallelTaskCount(instr) > 1) {
+    VLOG(2) << "Not fusing " << instr->name()
+            << ", which runs as parallel tasks.";
+    return false;
+  }
+  return absl::c_all_of(GetOutputs(*instr), IsFusibleOutput) &&
+         OutputsCompatible(*instr, *instr);
+}
+
+int64 CpuMultiOutputFusion::GetProfit(HloInstruction* instr1,
+                                      HloInstruction* instr2) {
+  // Each operand the two instructions share is read once instead of twice.
+  absl::flat_hash_set<HloInstruction*> operands(instr1->operands().begin(),
+                                                instr1->operands().end());
+  int64 profit = 0;
+  for (HloInstruction* operand : instr2->operands()) {
+    if (operands.erase(operand) > 0 && IsProfitableOperand(operand)) {
+      profit += ShapeUtil::ByteSizeOf(operand->shape());
+    }
+  }
+  return profit >> 10;
+}
+
+bool CpuMultiOutputFusion::LegalToFuse(HloInstruction* instr1,
+                                       HloInstruction* instr2) {
+  // Unlike the base class, plain instructions are fused too, by first
+  // wrapping one of them in a fusion.  Merging two multi-output fusions is
+  // left out to keep the fused loops small.
+  if (instr1->IsMultiOutputFusion() && instr2->IsMultiOutputFusion()) {
+    return false;
+  }
+  return LegalToFuseMainConstraints(instr1, instr2);
+}
+
+HloInstruction* CpuMultiOutputFusion::Fuse(HloInstruction* instr1,
+                                           HloInstruction* instr2) {
+  if (instr1->opcode() != HloOpcode::kFusion &&
+      instr2->opcode() != HloOpcode::kFusion) {
+    instr1 = CreateFusion(instr1, instr2);
+  }
+  return MultiOutputFusion::Fuse(instr1, instr2);
+}
+
+bool CpuMultiOutputFusion::DoProducerConsumerMultiOutputFusion() {
+  // Fuse the producer of a reduction's input into the reduction when the
+  // producer has other users, and so wasn't fused by CpuInstructionFusion.
+  // The fusion then writes the producer's output and reduces it in the same
+  // pass, instead of writing it and reading it back.
+  bool changed = false;
+  RecomputeReachability();
+  for (HloInstruction* consumer : computation()->MakeInstructionPostOrder()) {
+    if (!IsFusible(consumer) ||
+        !absl::c_any_of(GetOutputs(*consumer), IsRowReduction)) {
+      continue;
+    }
+    for (HloInstruction* producer : consumer->operands()) {
+      if (producer->user_count() < 2 || producer->IsMultiOutputFusion() ||
+          !IsFusible(producer) ||
+          absl::c_any_of(GetOutputs(*producer), IsRowReduction) ||
+          (ShapeUtil::ByteSizeOf(producer->shape()) >> 10) == 0 ||
+          !OutputsCompatible(*producer, *consumer)) {
+        continue;
+      }
+      // The fusion would be a cycle if another operand of the consumer
+      // depends on the producer.
+      if (absl::c_any_of(consumer->operands(), [&](HloInstruction* operand) {
+            return operand != producer &&
+                   reachability()->IsReachable(producer, operand);
+          })) {
+        continue;
+      }
+      if (!ConsumeFuel(name(), [&] {
+            return absl::StrFormat("Not fusing producer %s into %s.",
+                                   producer->ToString(), consumer->ToString());
+          })) {
+        return changed;
+      }
+      VLOG(2) << "Fusing producer " << producer->ToString() << " into "
+              << consumer->ToString();
+
+      HloInstruction* fusion = consumer;
+      if (consumer->opcode() != HloOpcode::kFusion) {
+        fusion = computation()->AddInstruction(HloInstruction::CreateFusion(
+            consumer->shape(), HloInstruction::FusionKind::kLoop, consumer));
+        TF_CHECK_OK(computation()->ReplaceInstruction(consumer, fusion));
+      }
+      if (producer->opcode() == HloOpcode::kFusion) {
+        fusion->MergeFusionInstructionIntoMultiOutput(producer);
+      } else {
+        fusion->FuseInstructionIntoMultiOutput(producer);
+        CHECK_EQ(0, producer->user_count());
+        TF_CHECK_OK(computation()->RemoveInstruction(producer));
+      }
+      changed = true;
+      RecomputeReachability();
+      break;
+    }
+  }
+  return changed;
+}
+
+}  // namespace cpu
+}  // namespace xla
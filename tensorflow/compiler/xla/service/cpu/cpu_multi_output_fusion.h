@@ -0,0 +1,88 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_CPU_CPU_MULTI_OUTPUT_FUSION_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_CPU_CPU_MULTI_OUTPUT_FUSION_H_
+
+#include <memory>
+
+#include "tensorflow/compiler/xla/service/cpu/parallel_task_assignment.h"
+#include "tensorflow/compiler/xla/service/cpu/target_machine_features.h"
+#include "tensorflow/compiler/xla/service/hlo_cost_analysis.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/multi_output_fusion.h"
+
+namespace xla {
+namespace cpu {
+
+// Multi-output fusion for the CPU backend.  Runs after CpuInstructionFusion
+// and merges loop fusions, reductions and elementwise ops that read the same
+// operand (sibling fusion), or that produce the operand of a reduction which
+// has other users (producer-consumer fusion), so that the operand is read from
+// memory once.
+//
+// All outputs of a resulting fusion are emitted in a single loop nest: either
+// they all have the same shape, or they are reductions over the same
+// dimensions (including the minor one) of same-shaped inputs, together with
+// elementwise outputs of that input shape.  See
+// IrEmitter::EmitMultiOutputReductionFusion.
+//
+// The loop nest of a multi-output fusion runs as a single task, so
+// instructions that ParallelTaskAssigner would split into several tasks are
+// not fused.
+class CpuMultiOutputFusion : public MultiOutputFusion {
+ public:
+  // 'max_parallelism', 'shape_size', 'target_machine_features' and 'profile'
+  // are those the module's ParallelTaskAssigner runs with; a
+  // 'max_parallelism' of 1 means that nothing is parallelized.
+  CpuMultiOutputFusion(const int64 max_parallelism,
+                       const HloCostAnalysis::ShapeSizeFunction& shape_size,
+                       const TargetMachineFeatures* target_machine_features,
+                       const ParallelTaskProfile* profile)
+      : max_parallelism_(max_parallelism),
+        shape_size_(shape_size),
+        target_machine_features_(*target_machine_features),
+        profile_(profile) {}
+
+  StatusOr<bool> Run(HloModule* module) override;
+
+  // Returns whether the outputs of 'instr1' and 'instr2' can be emitted
+  // together in one loop nest.
+  static bool OutputsCompatible(const HloInstruction& instr1,
+                                const HloInstruction& instr2);
+
+ protected:
+  bool ShapesCompatibleForFusion(HloInstruction* instr1,
+                                 HloInstruction* instr2) override;
+  bool IsFusible(HloInstruction* instr) override;
+  int64 GetProfit(HloInstruction* instr1, HloInstruction* instr2) override;
+  bool LegalToFuse(HloInstruction* instr1, HloInstruction* instr2) override;
+  HloInstruction* Fuse(HloInstruction* instr1, HloInstruction* instr2) override;
+  bool DoProducerConsumerMultiOutputFusion() override;
+
+ private:
+  const int64 max_parallelism_;
+  const HloCostAnalysis::ShapeSizeFunction shape_size_;
+  const TargetMachineFeatures& target_machine_features_;
+  const ParallelTaskProfile* profile_;
+
+  // The parallel task counts of the instructions of the module being run on.
+  std::unique_ptr<ParallelTaskAssignment> parallel_task_assignment_;
+};
+
+}  // namespace cpu
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_CPU_CPU_MULTI_OUTPUT_FUSION_H_
@@ -0,0 +1,253 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/cpu/cpu_multi_output_fusion.h"
+
+#include "tensorflow/compiler/xla/service/cpu/parallel_task_assignment.h"
+#include "tensorflow/compiler/xla/service/cpu/target_machine_features_fake.h"
+#include "tensorflow/compiler/xla/service/hlo_matchers.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+
+namespace op = xla::testing::opcode_matchers;
+
+namespace xla {
+namespace cpu {
+namespace {
+
+constexpr int64 kMaxParallelism = 8;
+
+class CpuMultiOutputFusionTest : public HloTestBase {
+ protected:
+  CpuMultiOutputFusionTest()
+      : target_machine_features_([](int64 shape_size) {
+          return TargetMachineFeatures::kEigenExpectedTensorAlignment;
+        }) {}
+
+  StatusOr<bool> RunMultiOutputFusion(HloModule* module) {
+    return CpuMultiOutputFusion(kMaxParallelism, ShapeSizeBytes,
+                                &target_machine_features_, /*profile=*/nullptr)
+        .Run(module);
+  }
+
+  // Returns the task count ParallelTaskAssigner would give 'instruction'.
+  int64 GetParallelTaskCount(HloModule* module, HloInstruction* instruction) {
+    return ParallelTaskAssignment(kMaxParallelism, ShapeSizeBytes, module,
+                                  &target_machine_features_,
+                                  /*profile=*/nullptr)
+        .GetTargetParallelTaskCount(instruction);
+  }
+
+  static int64 ShapeSizeBytes(const Shape& shape) {
+    return ShapeUtil::ByteSizeOf(shape, sizeof(void*));
+  }
+
+  TargetMachineFeaturesWithFakeAlignmentLogic target_machine_features_;
+};
+
+TEST_F(CpuMultiOutputFusionTest, SiblingReductions) {
+  // The sum and the sum of squares of layer normalization.
+  const char* const hlo_string = R"(
+    HloModule LayerNormStatistics
+
+    add {
+      lhs = f32[] parameter(0)
+      rhs = f32[] parameter(1)
+      ROOT add = f32[] add(lhs, rhs)
+    }
+
+    fused_sum_of_squares {
+      p0 = f32[128,512] parameter(0)
+      square = f32[128,512] multiply(p0, p0)
+      zero = f32[] constant(0)
+      ROOT reduce = f32[128] reduce(square, zero), dimensions={1}, to_apply=add
+    }
+
+    ENTRY main {
+      x = f32[128,512] parameter(0)
+      zero = f32[] constant(0)
+      sum = f32[128] reduce(x, zero), dimensions={1}, to_apply=add
+      sum_of_squares = f32[128] fusion(x), kind=kLoop,
+        calls=fused_sum_of_squares
+      ROOT tuple = (f32[128], f32[128]) tuple(sum, sum_of_squares)
+    }
+  )";
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunMultiOutputFusion(module.get()));
+  ASSERT_TRUE(changed);
+
+  const HloInstruction* root = module->entry_computation()->root_instruction();
+  EXPECT_THAT(root, op::Tuple(op::GetTupleElement(op::Fusion()),
+                              op::GetTupleElement(op::Fusion())));
+  const HloInstruction* fusion = root->operand(0)->operand(0);
+  EXPECT_EQ(fusion, root->operand(1)->operand(0));
+  EXPECT_TRUE(fusion->IsMultiOutputFusion());
+  EXPECT_THAT(fusion->fused_expression_root(),
+              op::Tuple(op::Reduce(), op::Reduce()));
+}
+
+TEST_F(CpuMultiOutputFusionTest, ProducerIntoReduction) {
+  // The exponentials of softmax are reduced and read again by the division.
+  const char* const hlo_string = R"(
+    HloModule Softmax
+
+    add {
+      lhs = f32[] parameter(0)
+      rhs = f32[] parameter(1)
+      ROOT add = f32[] add(lhs, rhs)
+    }
+
+    fused_exp {
+      p0 = f32[128,512] parameter(0)
+      p1 = f32[128] parameter(1)
+      max = f32[128,512] broadcast(p1), dimensions={0}
+      shifted = f32[128,512] subtract(p0, max)
+      ROOT exp = f32[128,512] exponential(shifted)
+    }
+
+    ENTRY main {
+      x = f32[128,512] parameter(0)
+      max = f32[128] parameter(1)
+      exp = f32[128,512] fusion(x, max), kind=kLoop, calls=fused_exp
+      zero = f32[] constant(0)
+      sum = f32[128] reduce(exp, zero), dimensions={1}, to_apply=add
+      sum_broadcast = f32[128,512] broadcast(sum), dimensions={0}
+      ROOT divide = f32[128,512] divide(exp, sum_broadcast)
+    }
+  )";
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  // The exponentials are small enough to run as one task, so fusing them
+  // loses no parallelism.
+  HloInstruction* exp = FindInstruction(module.get(), "exp");
+  EXPECT_EQ(GetParallelTaskCount(module.get(), exp), 1);
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunMultiOutputFusion(module.get()));
+  ASSERT_TRUE(changed);
+
+  HloInstruction* root = module->entry_computation()->root_instruction();
+  EXPECT_THAT(root,
+              op::Divide(op::GetTupleElement(op::Fusion()),
+                         op::Broadcast(op::GetTupleElement(op::Fusion()))));
+  HloInstruction* fusion = root->mutable_operand(0)->mutable_operand(0);
+  EXPECT_EQ(fusion, root->operand(1)->operand(0)->operand(0));
+  EXPECT_TRUE(fusion->IsMultiOutputFusion());
+  EXPECT_TRUE(CpuMultiOutputFusion::OutputsCompatible(*fusion, *fusion));
+  EXPECT_EQ(GetParallelTaskCount(module.get(), fusion), 1);
+}
+
+TEST_F(CpuMultiOutputFusionTest, ParallelProducerIsNotFused) {
+  // The polynomial is expensive enough to be split into several tasks, which
+  // the single loop nest of a multi-output fusion would serialize.
+  const char* const hlo_string = R"(
+    HloModule ParallelProducer
+
+    add {
+      lhs = f32[] parameter(0)
+      rhs = f32[] parameter(1)
+      ROOT add = f32[] add(lhs, rhs)
+    }
+
+    fused_polynomial {
+      p0 = f32[1024,1024] parameter(0)
+      m0 = f32[1024,1024] multiply(p0, p0)
+      a0 = f32[1024,1024] add(m0, p0)
+      m1 = f32[1024,1024] multiply(a0, p0)
+      a1 = f32[1024,1024] add(m1, p0)
+      m2 = f32[1024,1024] multiply(a1, p0)
+      a2 = f32[1024,1024] add(m2, p0)
+      m3 = f32[1024,1024] multiply(a2, p0)
+      a3 = f32[1024,1024] add(m3, p0)
+      m4 = f32[1024,1024] multiply(a3, p0)
+      a4 = f32[1024,1024] add(m4, p0)
+      m5 = f32[1024,1024] multiply(a4, p0)
+      ROOT a5 = f32[1024,1024] add(m5, p0)
+    }
+
+    ENTRY main {
+      x = f32[1024,1024] parameter(0)
+      polynomial = f32[1024,1024] fusion(x), kind=kLoop,
+        calls=fused_polynomial
+      zero = f32[] constant(0)
+      sum = f32[1024] reduce(polynomial, zero), dimensions={1}, to_apply=add
+      sum_broadcast = f32[1024,1024] broadcast(sum), dimensions={0}
+      ROOT divide = f32[1024,1024] divide(polynomial, sum_broadcast)
+    }
+  )";
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  HloInstruction* polynomial = FindInstruction(module.get(), "polynomial");
+  EXPECT_EQ(GetParallelTaskCount(module.get(), polynomial), kMaxParallelism);
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunMultiOutputFusion(module.get()));
+  EXPECT_FALSE(changed);
+  EXPECT_EQ(GetParallelTaskCount(module.get(), polynomial), kMaxParallelism);
+}
+
+TEST_F(CpuMultiOutputFusionTest, ColumnReductionsAreNotFused) {
+  // Reductions that keep the minor dimension have a vectorized lowering that
+  // fusion would lose.
+  const char* const hlo_string = R"(
+    HloModule ColumnReductions
+
+    add {
+      lhs = f32[] parameter(0)
+      rhs = f32[] parameter(1)
+      ROOT add = f32[] add(lhs, rhs)
+    }
+
+    ENTRY main {
+      x = f32[128,512] parameter(0)
+      zero = f32[] constant(0)
+      sum = f32[512] reduce(x, zero), dimensions={0}, to_apply=add
+      square = f32[128,512] multiply(x, x)
+      sum_of_squares = f32[512] reduce(square, zero), dimensions={0},
+        to_apply=add
+      ROOT tuple = (f32[512], f32[512]) tuple(sum, sum_of_squares)
+    }
+  )";
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunMultiOutputFusion(module.get()));
+  EXPECT_FALSE(changed);
+}
+
+TEST_F(CpuMultiOutputFusionTest, IncompatibleSiblingsAreNotFused) {
+  // The reductions keep different dimensions, so they can't share a loop.
+  const char* const hlo_string = R"(
+    HloModule DifferentReductions
+
+    add {
+      lhs = f32[] parameter(0)
+      rhs = f32[] parameter(1)
+      ROOT add = f32[] add(lhs, rhs)
+    }
+
+    ENTRY main {
+      x = f32[32,64,128] parameter(0)
+      zero = f32[] constant(0)
+      rows = f32[32,64] reduce(x, zero), dimensions={2}, to_apply=add
+      planes = f32[32] reduce(x, zero), dimensions={1,2}, to_apply=add
+      ROOT tuple = (f32[32,64], f32[32]) tuple(rows, planes)
+    }
+  )";
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunMultiOutputFusion(module.get()));
+  EXPECT_FALSE(changed);
+}
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
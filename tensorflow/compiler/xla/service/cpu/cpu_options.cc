@@ -26,6 +26,16 @@ const char* const kLlvmIrDotTilingFactor = "xla_llvm_dot_tiling_factor";
 const char* const kXlaForceEnableExperimentalLlvmIrGemm =
     "xla_force_enable_experimental_llvm_ir_gemm";
 const char* const kLlvmIrGemmTileSize = "xla_llvm_ir_gemm_tile_size";
+const char* const kXlaDisableMultiOutputFusionCpuOption =
+    "xla_cpu_disable_multi_output_fusion";
+const char* const kXlaDisableLowPrecisionGemmCpuOption =
+    "xla_cpu_disable_low_precision_gemm";
+const char* const kXlaPersistentForkJoinTeamCpuOption =
+    "xla_cpu_persistent_fork_join_team";
+const char* const kXlaShareConstantsAcrossObjectsCpuOption =
+    "xla_cpu_share_constants_across_objects";
+const char* const kXlaUnrolledGemmMaxDimsCpuOption =
+    "xla_cpu_unrolled_gemm_max_dims";
 
 }  // namespace
 
@@ -45,6 +55,30 @@ bool VectorizedReduceDisabled(const HloModuleConfig& config) {
   return extra_options_map.count(kXlaOptimizeForSizeCpuOption) > 0;
 }
 
+bool MultiOutputFusionDisabled(const HloModuleConfig& config) {
+  const auto& extra_options_map =
+      config.debug_options().xla_backend_extra_options();
+  return extra_options_map.count(kXlaDisableMultiOutputFusionCpuOption) > 0;
+}
+
+bool LowPrecisionGemmDisabled(const HloModuleConfig& config) {
+  const auto& extra_options_map =
+      config.debug_options().xla_backend_extra_options();
+  return extra_options_map.count(kXlaDisableLowPrecisionGemmCpuOption) > 0;
+}
+
+bool PersistentForkJoinTeamEnabled(const HloModuleConfig& config) {
+  const auto& extra_options_map =
+      config.debug_options().xla_backend_extra_options();
+  return extra_options_map.count(kXlaPersistentForkJoinTeamCpuOption) > 0;
+}
+
+bool ConstantsSharedAcrossObjects(const HloModuleConfig& config) {
+  const auto& extra_options_map =
+      config.debug_options().xla_backend_extra_options();
+  return extra_options_map.count(kXlaShareConstantsAcrossObjectsCpuOption) > 0;
+}
+
 absl::optional<int64> LlvmIrGemvTilingFactor(const HloModuleConfig& config) {
   const auto& extra_options_map =
       config.debug_options().xla_backend_extra_options();
@@ -99,6 +133,28 @@ absl::optional<std::tuple<int64, int64, int64>> LlvmIrGemmTileSize(
                                          tile_size_n_in_vector_width);
 }
 
+// The option is of the form "m:k:n".  "0:0:0" turns unrolled GEMMs off.
+absl::optional<std::tuple<int64, int64, int64>> UnrolledGemmMaxDims(
+    const HloModuleConfig& config) {
+  const auto& extra_options_map =
+      config.debug_options().xla_backend_extra_options();
+  auto it = extra_options_map.find(kXlaUnrolledGemmMaxDimsCpuOption);
+  if (it == extra_options_map.end()) {
+    return absl::nullopt;
+  }
+
+  std::vector<string> dim_components = absl::StrSplit(it->second, ':');
+  CHECK_EQ(dim_components.size(), 3);
+
+  int64 max_m;
+  int64 max_k;
+  int64 max_n;
+  CHECK(absl::SimpleAtoi(dim_components[0], &max_m));
+  CHECK(absl::SimpleAtoi(dim_components[1], &max_k));
+  CHECK(absl::SimpleAtoi(dim_components[2], &max_n));
+  return std::tuple<int64, int64, int64>(max_m, max_k, max_n);
+}
+
 }  // namespace options
 }  // namespace cpu
 }  // namespace xla
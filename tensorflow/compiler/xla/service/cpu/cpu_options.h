@@ -26,10 +26,16 @@ namespace options {
 
 bool OptimizeForSizeRequested(const HloModuleConfig& config);
 bool VectorizedReduceDisabled(const HloModuleConfig& config);
+bool MultiOutputFusionDisabled(const HloModuleConfig& config);
+bool LowPrecisionGemmDisabled(const HloModuleConfig& config);
+bool PersistentForkJoinTeamEnabled(const HloModuleConfig& config);
+bool ConstantsSharedAcrossObjects(const HloModuleConfig& config);
 bool ForceEnableExperimentalLlvmIrGemm(const HloModuleConfig& config);
 absl::optional<int64> LlvmIrGemvTilingFactor(const HloModuleConfig& config);
 absl::optional<std::tuple<int64, int64, int64>> LlvmIrGemmTileSize(
     const HloModuleConfig& config);
+absl::optional<std::tuple<int64, int64, int64>> UnrolledGemmMaxDims(
+    const HloModuleConfig& config);
 
 }  // namespace options
 }  // namespace cpu
@@ -73,6 +73,10 @@ extern const char* const kEigenMatMulC128SymbolName =
     "__xla_cpu_runtime_EigenMatMulC128";
 extern const char* const kEigenMatMulS32SymbolName =
     "__xla_cpu_runtime_EigenMatMulS32";
+extern const char* const kLowPrecisionMatMulS8S32SymbolName =
+    "__xla_cpu_runtime_LowPrecisionMatMulS8S32";
+extern const char* const kLowPrecisionMatMulBF16F32SymbolName =
+    "__xla_cpu_runtime_LowPrecisionMatMulBF16F32";
 extern const char* const kMKLConvF32SymbolName = "__xla_cpu_runtime_MKLConvF32";
 extern const char* const kMKLMatMulF32SymbolName =
     "__xla_cpu_runtime_MKLMatMulF32";
@@ -101,6 +105,10 @@ extern const char* const kEigenSingleThreadedMatMulC128SymbolName =
     "__xla_cpu_runtime_EigenSingleThreadedMatMulC128";
 extern const char* const kEigenSingleThreadedMatMulS32SymbolName =
     "__xla_cpu_runtime_EigenSingleThreadedMatMulS32";
+extern const char* const kSingleThreadedLowPrecisionMatMulS8S32SymbolName =
+    "__xla_cpu_runtime_SingleThreadedLowPrecisionMatMulS8S32";
+extern const char* const kSingleThreadedLowPrecisionMatMulBF16F32SymbolName =
+    "__xla_cpu_runtime_SingleThreadedLowPrecisionMatMulBF16F32";
 extern const char* const kEigenSingleThreadedConvF16SymbolName =
     "__xla_cpu_runtime_EigenSingleThreadedConvF16";
 extern const char* const kEigenSingleThreadedConvF32SymbolName =
@@ -115,6 +123,8 @@ extern const char* const kReleaseOutfeedBufferAfterPopulationSymbolName =
     "__xla_cpu_runtime_ReleaseOutfeedBufferAfterPopulation";
 extern const char* const kParallelForkJoinSymbolName =
     "__xla_cpu_runtime_ParallelForkJoin";
+extern const char* const kParallelForkJoinPersistentTeamSymbolName =
+    "__xla_cpu_runtime_ParallelForkJoinPersistentTeam";
 extern const char* const kKeyValueSortSymbolName =
     "__xla_cpu_runtime_KeyValueSort";
 extern const char* const kTracingStartSymbolName =
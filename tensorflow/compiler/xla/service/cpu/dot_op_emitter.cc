@@ -101,6 +101,12 @@ enum class DotImplementationStrategy {
   // and the output have to be row major.
   kTiledLlvmIrGemm,
 
+  // The dot operation is lowered into LLVM IR that implements a Matrix*Matrix
+  // operation with small static dimensions as straight-line code, without
+  // loops.  No fusions are supported.  The two inputs and the output have to
+  // be row major.
+  kUnrolledLlvmIrGemm,
+
   // The dot operation is lowered into linalg.matmul op and lowered to LLVM IR.
   kLinalgMatmul,
 
@@ -178,6 +184,9 @@ class DotOpEmitter {
   // Lowers the dot operation as a tiled Matrix*Matrix loop.
   void EmitTiledLlvmIrGemm();
 
+  // Lowers the dot operation as a fully unrolled Matrix*Matrix product.
+  void EmitUnrolledLlvmIrGemm();
+
   // Lowers the dot operation through MLIR's linalg.matmul.
   Status EmitLinalgMatmul();
 
@@ -375,6 +384,49 @@ void DotOpEmitter::EmitTiledLlvmIrGemm() {
       /*rhs=*/rhs, /*result=*/target, b_, hlo_module_config_);
 }
 
+void DotOpEmitter::EmitUnrolledLlvmIrGemm() {
+  PrimitiveType primitive_type = dot_info_.result_shape.element_type();
+  MatMultDims mat_mult_dims = GetMatMultDims();
+
+  llvm::Value* lhs = lhs_array_.GetBasePointer();
+  llvm::Value* rhs = rhs_array_.GetBasePointer();
+  llvm::Value* target = target_array_.GetBasePointer();
+  int64 m = mat_mult_dims.m;
+  int64 k = mat_mult_dims.k;
+  int64 n = mat_mult_dims.n;
+
+  if (mat_mult_dims.lhs_column_major) {
+    std::swap(lhs, rhs);
+    std::swap(m, n);
+  }
+
+  const llvm::Function& function = *b_->GetInsertBlock()->getParent();
+  int64 vectorization_width =
+      target_machine_features_.vector_register_num_elements(function,
+                                                            primitive_type);
+  if (vectorization_width == 0) {
+    const int64 kUnknownTargetVectorRegisterSize = 4;
+    vectorization_width = kUnknownTargetVectorRegisterSize;
+  }
+
+  // Each tile of the result takes tile_size_m * tile_size_n registers, plus
+  // tile_size_n registers for a row of the RHS and one for a broadcast element
+  // of the LHS.
+  const int64 kTileSizeM = 4;
+  int64 tile_size_n = std::max<int64>(
+      1, (target_machine_features_.vector_register_count(function) - 1) /
+             (kTileSizeM + 1));
+
+  VLOG(2) << "Emitting unrolled matrix-matrix multiply with m = " << m
+          << ", k = " << k << " and n = " << n;
+  EmitUnrolledSmallGemm(
+      /*scalar_type=*/primitive_type,
+      /*m=*/m, /*k=*/k, /*n=*/n,
+      /*vectorization_width=*/vectorization_width,
+      /*tile_size_m=*/kTileSizeM, /*tile_size_n=*/tile_size_n, /*lhs=*/lhs,
+      /*rhs=*/rhs, /*result=*/target, b_, hlo_module_config_);
+}
+
 void DotOpEmitter::EmitTiledLlvmIrGemv() {
   PrimitiveType primitive_type = dot_info_.result_shape.element_type();
 
@@ -536,6 +588,10 @@ Status DotOpEmitter::Emit() {
       EmitTiledLlvmIrGemm();
       return Status::OK();
 
+    case DotImplementationStrategy::kUnrolledLlvmIrGemm:
+      EmitUnrolledLlvmIrGemm();
+      return Status::OK();
+
     case DotImplementationStrategy::kLinalgMatmul:
       return EmitLinalgMatmul();
 
@@ -1005,6 +1061,40 @@ bool CanEmitTiledLlvmIrGemm(
   return true;
 }
 
+// Returns true if the dot is small enough to be emitted as straight-line code.
+// Beyond these sizes the code size, and the compile time, outweigh the
+// overhead of loops.
+bool CanEmitUnrolledLlvmIrGemm(const HloModuleConfig& config,
+                               const DotInfo& dot_info) {
+  if (options::OptimizeForSizeRequested(config)) {
+    return false;
+  }
+
+  PrimitiveType element_type = dot_info.result_shape.element_type();
+  if (element_type != F32 && element_type != F64) {
+    return false;
+  }
+
+  bool lhs_canonical = dot_info.dim_nums.lhs_contracting_dimensions(0) == 1;
+  bool rhs_canonical = dot_info.dim_nums.rhs_contracting_dimensions(0) == 0;
+  if (!(lhs_canonical && rhs_canonical)) {
+    return false;
+  }
+
+  // Sized for the small layers of recommendation models, e.g. [8,64]x[64,32].
+  const std::tuple<int64, int64, int64> kDefaultMaxDims(16, 64, 64);
+  const int64 kMaxMultiplyAdds = 16 * 64 * 32;
+  int64 max_m, max_k, max_n;
+  std::tie(max_m, max_k, max_n) =
+      options::UnrolledGemmMaxDims(config).value_or(kDefaultMaxDims);
+
+  int64 m = dot_info.result_shape.dimensions(0);
+  int64 k = dot_info.lhs_shape.dimensions(1);
+  int64 n = dot_info.result_shape.dimensions(1);
+  return m <= max_m && k <= max_k && n <= max_n &&
+         m * k * n <= kMaxMultiplyAdds;
+}
+
 DotImplementationStrategy GetDotImplementationStrategy(
     const HloModuleConfig& config, const DotInfo& dot_info,
     const TargetMachineFeatures& target_machine_features) {
@@ -1022,6 +1112,9 @@ DotImplementationStrategy GetDotImplementationStrategy(
   }
 
   if (IsAlignedGemm(dot_info, target_machine_features)) {
+    if (CanEmitUnrolledLlvmIrGemm(config, dot_info)) {
+      return DotImplementationStrategy::kUnrolledLlvmIrGemm;
+    }
     if (CanEmitTiledLlvmIrGemm(config, dot_info, target_machine_features)) {
       return DotImplementationStrategy::kLinalgMatmul;
     }
@@ -1217,6 +1310,7 @@ bool DotOperandsAndResultMustHaveRowMajorLayout(
                                    DotInfo(dot_instr), target_machine_features);
 
   return impl_strategy == DotImplementationStrategy::kTiledLlvmIrGemm ||
+         impl_strategy == DotImplementationStrategy::kUnrolledLlvmIrGemm ||
          impl_strategy == DotImplementationStrategy::kEigen;
 }
 
@@ -1245,5 +1339,115 @@ Status EmitDotOperation(const HloInstruction& dot,
                                   executable_run_options_value, b, mlir_context,
                                   hlo_module_config, target_machine_features);
 }
+
+Status EmitLowPrecisionGemm(
+    const HloInstruction& fusion, const llvm_ir::IrArray& target_array,
+    const llvm_ir::IrArray& lhs_array, const llvm_ir::IrArray& rhs_array,
+    llvm::Value* executable_run_options_value, llvm::IRBuilder<>* b,
+    const HloModuleConfig& hlo_module_config,
+    const TargetMachineFeatures& target_machine_features) {
+  // The signature of the low precision runtime matmul functions is that of
+  // the Eigen ones, with narrow operands:
+  //
+  //   (void)(void* run_options, int32* out, int8* lhs, int8* rhs,
+  //          int64 m, int64 n, int64 k, int32 transpose_lhs,
+  //          int32 transpose_rhs);
+  //
+  // or with float, bfloat16 and bfloat16.
+  TF_RET_CHECK(
+      PotentiallyImplementedAsLowPrecisionGemm(fusion, target_machine_features));
+  CHECK(fusion.outer_dimension_partitions().empty());
+
+  bool multi_threaded = ShouldUseMultiThreadedEigen(hlo_module_config);
+  llvm::Module* module = b->GetInsertBlock()->getParent()->getParent();
+  llvm::Type* out_type;
+  llvm::Type* in_type;
+  const char* fn_name;
+  switch (lhs_array.GetShape().element_type()) {
+    case S8:
+      fn_name =
+          multi_threaded
+              ? runtime::kLowPrecisionMatMulS8S32SymbolName
+              : runtime::kSingleThreadedLowPrecisionMatMulS8S32SymbolName;
+      out_type = b->getInt32Ty();
+      in_type = b->getInt8Ty();
+      break;
+    case BF16:
+      fn_name =
+          multi_threaded
+              ? runtime::kLowPrecisionMatMulBF16F32SymbolName
+              : runtime::kSingleThreadedLowPrecisionMatMulBF16F32SymbolName;
+      out_type = b->getFloatTy();
+      in_type = b->getInt16Ty();
+      break;
+    default:
+      return Unimplemented(
+          "Invalid type %s for low precision dot operation",
+          PrimitiveType_Name(lhs_array.GetShape().element_type()));
+  }
+
+  llvm::Type* out_ptr_type = out_type->getPointerTo();
+  llvm::Type* in_ptr_type = in_type->getPointerTo();
+  llvm::Type* int64_type = b->getInt64Ty();
+  llvm::Type* int32_type = b->getInt32Ty();
+  llvm::Type* int8_ptr_type = b->getInt8Ty()->getPointerTo();
+  llvm::FunctionType* matmul_type = llvm::FunctionType::get(
+      b->getVoidTy(),
+      {int8_ptr_type, out_ptr_type, in_ptr_type, in_ptr_type, int64_type,
+       int64_type, int64_type, int32_type, int32_type},
+      /*isVarArg=*/false);
+
+  llvm::FunctionCallee matmul_func =
+      module->getOrInsertFunction(fn_name, matmul_type);
+  if (auto* fn = llvm::dyn_cast<llvm::Function>(matmul_func.getCallee())) {
+    fn->setCallingConv(llvm::CallingConv::C);
+    fn->setDoesNotThrow();
+    fn->setOnlyAccessesArgMemory();
+  }
+
+  const DotDimensionNumbers& dim_nums =
+      fusion.fused_expression_root()->dot_dimension_numbers();
+  const Shape& lhs_shape = lhs_array.GetShape();
+  const Shape& rhs_shape = rhs_array.GetShape();
+  auto is_column_major = [](const Shape& shape) {
+    return LayoutUtil::Minor(shape.layout(), 0) == 0;
+  };
+  int64 lhs_contracting_dim = dim_nums.lhs_contracting_dimensions(0);
+  int64 rhs_contracting_dim = dim_nums.rhs_contracting_dimensions(0);
+  int64 m = lhs_shape.dimensions(1 - lhs_contracting_dim);
+  int64 n = rhs_shape.dimensions(1 - rhs_contracting_dim);
+  int64 k = lhs_shape.dimensions(lhs_contracting_dim);
+
+  // The runtime multiplies an m x k matrix by a k x n matrix, both column
+  // major unless transposed.  An operand buffer holds its matrix in column
+  // major order if the contracting dimension is where the matrix has it and
+  // the layout is column major, or neither.
+  bool transpose_lhs =
+      (lhs_contracting_dim == 1) != is_column_major(lhs_shape);
+  bool transpose_rhs =
+      (rhs_contracting_dim == 0) != is_column_major(rhs_shape);
+  const llvm_ir::IrArray* lhs = &lhs_array;
+  const llvm_ir::IrArray* rhs = &rhs_array;
+
+  // A row major result is the column major result of (A x B)^T = B^T x A^T,
+  // for which each operand buffer holds the transpose of what it held above.
+  if (!is_column_major(target_array.GetShape())) {
+    std::swap(m, n);
+    std::swap(lhs, rhs);
+    std::swap(transpose_lhs, transpose_rhs);
+    transpose_lhs = !transpose_lhs;
+    transpose_rhs = !transpose_rhs;
+  }
+
+  b->CreateCall(
+      matmul_func,
+      {b->CreateBitCast(executable_run_options_value, int8_ptr_type),
+       b->CreateBitCast(target_array.GetBasePointer(), out_ptr_type),
+       b->CreateBitCast(lhs->GetBasePointer(), in_ptr_type),
+       b->CreateBitCast(rhs->GetBasePointer(), in_ptr_type), b->getInt64(m),
+       b->getInt64(n), b->getInt64(k), b->getInt32(transpose_lhs),
+       b->getInt32(transpose_rhs)});
+  return Status::OK();
+}
 }  // namespace cpu
 }  // namespace xla
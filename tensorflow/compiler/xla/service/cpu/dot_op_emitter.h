@@ -67,6 +67,17 @@ Status EmitDotOperation(const HloInstruction& dot,
                         llvm::IRBuilder<>* b, mlir::MLIRContext* mlir_context,
                         const HloModuleConfig& hlo_module_config,
                         const TargetMachineFeatures& target_machine_features);
+
+// Emit a call to the low precision GEMM runtime for `fusion`, a fusion for
+// which PotentiallyImplementedAsLowPrecisionGemm is true.  `lhs_array` and
+// `rhs_array` are the int8 or bfloat16 operands of the fusion, before their
+// fused converts.
+Status EmitLowPrecisionGemm(
+    const HloInstruction& fusion, const llvm_ir::IrArray& target_array,
+    const llvm_ir::IrArray& lhs_array, const llvm_ir::IrArray& rhs_array,
+    llvm::Value* executable_run_options_value, llvm::IRBuilder<>* b,
+    const HloModuleConfig& hlo_module_config,
+    const TargetMachineFeatures& target_machine_features);
 }  // namespace cpu
 }  // namespace xla
 
@@ -15,8 +15,10 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/cpu/ir_emission_utils.h"
 
+#include "absl/algorithm/container.h"
 #include "tensorflow/compiler/xla/layout_util.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_runtime.h"
+#include "tensorflow/compiler/xla/service/cpu/runtime_low_precision_matmul_impl.h"
 #include "tensorflow/compiler/xla/service/hlo_module.h"
 #include "tensorflow/compiler/xla/shape_util.h"
 #include "tensorflow/compiler/xla/window_util.h"
@@ -40,6 +42,104 @@ int64 GetMinimumAlignmentForArray(
       allocation_size_bytes);
 }
 
+namespace {
+
+// Returns operand 'i' of the dot in 'hlo', which is a dot or a fusion rooted at
+// one.  Parameters of a fusion are resolved to the operands of the fusion.
+const HloInstruction* GemmOperand(const HloInstruction& hlo, int64 i) {
+  if (hlo.opcode() == HloOpcode::kDot) {
+    return hlo.operand(i);
+  }
+  const HloInstruction* operand = hlo.fused_expression_root()->operand(i);
+  if (operand->opcode() == HloOpcode::kParameter) {
+    return hlo.operand(operand->parameter_number());
+  }
+  return operand;
+}
+
+// Returns true if the low precision GEMM runtime has a kernel for 'type'
+// operands that uses the dot product instructions of the target.
+bool HasFastLowPrecisionGemmKernel(
+    PrimitiveType type, const TargetMachineFeatures& target_machine_features) {
+  if (!::tensorflow::xla::kLowPrecisionMatMulHasAvx512Kernels ||
+      !target_machine_features.has_target_feature("avx512f") ||
+      !target_machine_features.has_target_feature("avx512bw")) {
+    return false;
+  }
+  switch (type) {
+    case S8:
+      return target_machine_features.has_target_feature("avx512vnni");
+    case BF16:
+      return target_machine_features.has_target_feature("avx512bf16");
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+bool IsLowPrecisionGemmOperand(const HloInstruction& hlo) {
+  if (hlo.opcode() != HloOpcode::kConvert) {
+    return false;
+  }
+  PrimitiveType from = hlo.operand(0)->shape().element_type();
+  PrimitiveType to = hlo.shape().element_type();
+  return (from == S8 && to == S32) || (from == BF16 && to == F32);
+}
+
+bool CanBeLowPrecisionGemm(
+    const HloInstruction& hlo,
+    const TargetMachineFeatures& target_machine_features) {
+  const HloInstruction* dot = &hlo;
+  if (hlo.opcode() == HloOpcode::kFusion) {
+    if (!hlo.IsLoopFusion()) {
+      return false;
+    }
+    dot = hlo.fused_expression_root();
+  }
+  if (dot->opcode() != HloOpcode::kDot) {
+    return false;
+  }
+  const DotDimensionNumbers& dnums = dot->dot_dimension_numbers();
+  if (dot->shape().rank() != 2 || dot->operand(0)->shape().rank() != 2 ||
+      dot->operand(1)->shape().rank() != 2 ||
+      dnums.lhs_batch_dimensions_size() != 0 ||
+      dnums.lhs_contracting_dimensions_size() != 1 ||
+      dnums.rhs_contracting_dimensions_size() != 1 ||
+      ShapeUtil::IsZeroElementArray(dot->shape())) {
+    return false;
+  }
+  const HloInstruction* lhs = GemmOperand(hlo, 0);
+  const HloInstruction* rhs = GemmOperand(hlo, 1);
+  if (!IsLowPrecisionGemmOperand(*lhs) || !IsLowPrecisionGemmOperand(*rhs) ||
+      lhs->operand(0)->shape().element_type() !=
+          rhs->operand(0)->shape().element_type()) {
+    return false;
+  }
+  const PrimitiveType type = lhs->operand(0)->shape().element_type();
+  if (!HasFastLowPrecisionGemmKernel(type, target_machine_features)) {
+    return false;
+  }
+  const int64 k = dot->operand(0)->shape().dimensions(
+      dnums.lhs_contracting_dimensions(0));
+  return type != S8 || k <= kMaxLowPrecisionGemmS8ContractionSize;
+}
+
+bool PotentiallyImplementedAsLowPrecisionGemm(
+    const HloInstruction& hlo,
+    const TargetMachineFeatures& target_machine_features) {
+  if (hlo.opcode() != HloOpcode::kFusion ||
+      !CanBeLowPrecisionGemm(hlo, target_machine_features)) {
+    return false;
+  }
+  return absl::c_all_of(hlo.fused_expression_root()->operands(),
+                        [](const HloInstruction* operand) {
+                          return operand->opcode() == HloOpcode::kConvert &&
+                                 operand->operand(0)->opcode() ==
+                                     HloOpcode::kParameter;
+                        });
+}
+
 bool PotentiallyImplementedAsEigenConvolution(
     const HloInstruction& convolution,
     const TargetMachineFeatures& target_machine_features) {
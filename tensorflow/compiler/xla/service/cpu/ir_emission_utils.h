@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_XLA_SERVICE_CPU_IR_EMISSION_UTILS_H_
 #define TENSORFLOW_COMPILER_XLA_SERVICE_CPU_IR_EMISSION_UTILS_H_
 
+#include <limits>
+
 #include "llvm/IR/Value.h"
 #include "tensorflow/compiler/xla/service/cpu/target_machine_features.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
@@ -27,6 +29,35 @@ bool PotentiallyImplementedAsEigenConvolution(
     const HloInstruction& convolution,
     const TargetMachineFeatures& target_machine_features);
 
+// Returns true if 'hlo' widens int8 to int32, or bfloat16 to float, so that the
+// low precision GEMM runtime can read its operand directly.
+bool IsLowPrecisionGemmOperand(const HloInstruction& hlo);
+
+// The largest contraction dimension of an int8 dot that the low precision GEMM
+// runtime accumulates in 32-bit integers without overflow. The AVX-512 VNNI
+// kernel biases the lhs to [0, 255], so each product is at most 255 * 128 in
+// magnitude.
+constexpr int64 kMaxLowPrecisionGemmS8ContractionSize =
+    std::numeric_limits<int32>::max() / (255 * 128);
+
+// Returns true if 'hlo' is a matrix-matrix dot, or a loop fusion whose root is
+// one, whose operands are both widened from int8 or both from bfloat16 by
+// IsLowPrecisionGemmOperand converts, fused or not. Int8 dots must contract at
+// most kMaxLowPrecisionGemmS8ContractionSize elements. The target must support
+// the AVX-512 VNNI (int8) or BF16 (bfloat16) dot product instructions, and the
+// runtime must have been built with the kernels that use them; otherwise
+// Eigen's GEMM is faster.
+bool CanBeLowPrecisionGemm(
+    const HloInstruction& hlo,
+    const TargetMachineFeatures& target_machine_features);
+
+// Returns true if 'hlo' is a fusion of a dot with the converts of both its
+// operands, which is emitted as a call to the low precision GEMM runtime
+// instead of as a loop.
+bool PotentiallyImplementedAsLowPrecisionGemm(
+    const HloInstruction& hlo,
+    const TargetMachineFeatures& target_machine_features);
+
 // Computes the minimum alignment guaranteed for a tensor of shape `shape` on
 // the target machine.
 int64 GetMinimumAlignmentForArray(
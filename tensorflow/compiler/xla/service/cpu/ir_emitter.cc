@@ -26,12 +26,14 @@ limitations under the License.
 #include <vector>
 
 // IWYU pragma: no_include "llvm/IR/Intrinsics.gen.inc"
+#include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
 #include "absl/types/span.h"
+#include "llvm/ADT/Triple.h"
 #include "llvm/CodeGen/TargetRegisterInfo.h"
 #include "llvm/CodeGen/TargetSubtargetInfo.h"
 #include "llvm/IR/BasicBlock.h"
@@ -78,6 +80,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/bits.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/math/math_util.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/logging.h"
 
 namespace xla {
@@ -233,20 +236,47 @@ Status IrEmitter::HandleBitcast(HloInstruction* bitcast) {
 }
 
 llvm::Constant* IrEmitter::EmitGlobalForLiteral(const Literal& literal) {
+  llvm::Type* pointer_type = IrShapeType(literal.shape())->getPointerTo();
+  string shared_name;
+  if (options::ConstantsSharedAcrossObjects(hlo_module_config_)) {
+    // Name the global after its contents, so that identical constants emitted
+    // into several objects, e.g. the batch size variants of an AOT bundle, are
+    // merged into one by the linker.
+    tensorflow::Fprint128 fingerprint = tensorflow::Fingerprint128(
+        absl::StrCat(ShapeUtil::HumanStringWithLayout(literal.shape()), ":",
+                     absl::string_view(
+                         static_cast<const char*>(literal.untyped_data()),
+                         literal.size_bytes())));
+    shared_name = absl::StrCat(
+        "__xla_constant_", absl::Hex(fingerprint.high64, absl::kZeroPad16),
+        absl::Hex(fingerprint.low64, absl::kZeroPad16));
+    if (llvm::GlobalVariable* existing =
+            module_->getNamedGlobal(shared_name)) {
+      return llvm::ConstantExpr::getBitCast(existing, pointer_type);
+    }
+  }
+
   llvm::Constant* initializer =
       llvm_ir::ConvertLiteralToIrConstant(literal, module_);
   llvm::GlobalVariable* result_global = new llvm::GlobalVariable(
       /*Module=*/*module_,
       /*Type=*/initializer->getType(),
       /*isConstant=*/true,
-      /*Linkage=*/llvm::GlobalValue::PrivateLinkage,
+      /*Linkage=*/shared_name.empty()
+          ? llvm::GlobalValue::PrivateLinkage
+          : llvm::GlobalValue::LinkOnceODRLinkage,
       /*Initializer=*/initializer,
-      /*Name=*/"");
+      /*Name=*/shared_name);
   result_global->setAlignment(
       llvm::Align(MinimumAlignmentForShape(literal.shape())));
   result_global->setUnnamedAddr(llvm::GlobalVariable::UnnamedAddr::Global);
-  return llvm::ConstantExpr::getBitCast(
-      result_global, IrShapeType(literal.shape())->getPointerTo());
+  if (!shared_name.empty()) {
+    result_global->setVisibility(llvm::GlobalValue::HiddenVisibility);
+    if (llvm::Triple(module_->getTargetTriple()).supportsCOMDAT()) {
+      result_global->setComdat(module_->getOrInsertComdat(shared_name));
+    }
+  }
+  return llvm::ConstantExpr::getBitCast(result_global, pointer_type);
 }
 
 Status IrEmitter::EmitConstantGlobals() {
@@ -2205,6 +2235,21 @@ Status IrEmitter::HandleFusion(HloInstruction* fusion) {
     return llvm_ir::EmitFusedDynamicUpdateSliceInPlace(
         fusion, GetGeneratorForOperandIrArrays(fusion), GetIrArrayFor(fusion),
         &elemental_emitter, &b_);
+  } else if (PotentiallyImplementedAsLowPrecisionGemm(
+                 *fusion, target_machine_features_)) {
+    VLOG(3) << "HandleFusion low precision GEMM";
+    // The runtime reads the operands of the fused converts.
+    int64 lhs_param_number = root->operand(0)->operand(0)->parameter_number();
+    int64 rhs_param_number = root->operand(1)->operand(0)->parameter_number();
+    TF_RETURN_IF_ERROR(EmitTargetAddressForOp(fusion));
+    llvm_ir::IrArray lhs_array(
+        GetIrArrayFor(fusion->operand(lhs_param_number)));
+    llvm_ir::IrArray rhs_array(
+        GetIrArrayFor(fusion->operand(rhs_param_number)));
+    return EmitLowPrecisionGemm(*fusion, GetIrArrayFor(fusion), lhs_array,
+                                rhs_array, GetExecutableRunOptionsArgument(),
+                                &b_, hlo_module_config_,
+                                target_machine_features_);
   } else if (fusion->IsLoopFusion()) {
     VLOG(3) << "HandleFusion kLoop";
     CpuElementalIrEmitter elemental_emitter(hlo_module_config_, this, module_);
@@ -2213,6 +2258,12 @@ Status IrEmitter::HandleFusion(HloInstruction* fusion) {
                                  &elemental_emitter);
     TF_RETURN_IF_ERROR(fusion->fused_expression_root()->Accept(&fused_emitter));
 
+    if (fusion->IsMultiOutputFusion() &&
+        absl::c_any_of(root->operands(), [](const HloInstruction* output) {
+          return output->opcode() == HloOpcode::kReduce;
+        })) {
+      return EmitMultiOutputReductionFusion(fusion, fused_emitter);
+    }
     return EmitTargetElementLoop(fusion, fused_emitter.GetRootGenerator());
   } else if (fusion->IsOutputFusion()) {
     VLOG(3) << "HandleFusion kOutput";
@@ -2267,7 +2318,8 @@ Status IrEmitter::HandleCall(HloInstruction* call) {
     HloInstruction* root = computation->root_instruction();
     TF_RETURN_IF_ERROR(EmitCallToParallelForkJoin(
         call_args, root->shape(), root->outer_dimension_partitions(), &b_,
-        call_ir_function, computation->name()));
+        call_ir_function, computation->name(),
+        options::PersistentForkJoinTeamEnabled(hlo_module_config_)));
   } else {
     EmitGlobalCall(*computation, computation->name());
   }
@@ -3268,6 +3320,118 @@ Status IrEmitter::EmitTargetElementLoop(
   return Status::OK();
 }
 
+Status IrEmitter::EmitMultiOutputReductionFusion(
+    HloInstruction* fusion, const FusedIrEmitter& fused_emitter) {
+  // Pseudocode:
+  // for each index O in the reduction output
+  //   accumulator[r] = init_value[r] for each reduction r
+  //   for each index R in the reduced dimensions
+  //     I = the input index combining O and R
+  //     output[e][I] = generator[e](I) for each elementwise output e
+  //     accumulator[r] = reducer[r](accumulator[r], input[r](I))
+  //   output[r][O] = accumulator[r]
+  const HloInstruction* root = fusion->fused_expression_root();
+  const HloInstruction* first_reduce = *absl::c_find_if(
+      root->operands(), [](const HloInstruction* output) {
+        return output->opcode() == HloOpcode::kReduce;
+      });
+  const Shape& input_shape = first_reduce->operand(0)->shape();
+  absl::Span<const int64> reduced_dimensions(first_reduce->dimensions());
+  for (const HloInstruction* output : root->operands()) {
+    if (output->opcode() == HloOpcode::kReduce) {
+      TF_RET_CHECK(output->shape().IsArray());
+      TF_RET_CHECK(ShapeUtil::EqualIgnoringElementType(
+          output->operand(0)->shape(), input_shape));
+      TF_RET_CHECK(absl::c_is_permutation(output->dimensions(),
+                                          reduced_dimensions));
+    } else {
+      TF_RET_CHECK(
+          ShapeUtil::EqualIgnoringElementType(output->shape(), input_shape));
+    }
+  }
+
+  TF_RETURN_IF_ERROR(EmitTargetAddressForOp(fusion));
+  std::vector<llvm_ir::IrArray> output_arrays;
+  for (int64 i = 0; i < root->operand_count(); ++i) {
+    TF_ASSIGN_OR_RETURN(BufferAllocation::Slice slice,
+                        assignment_.GetUniqueSlice(fusion, {i}));
+    const Shape& element_shape = root->operand(i)->shape();
+    output_arrays.push_back(llvm_ir::IrArray(
+        EmitBufferPointer(slice, element_shape), element_shape));
+  }
+
+  auto body_emitter = [&](const llvm_ir::IrArray::Index& index) -> Status {
+    llvm::Type* index_type = index.GetType();
+    std::vector<llvm::Value*> accumulator_addrs(root->operand_count());
+    for (int64 i = 0; i < root->operand_count(); ++i) {
+      const HloInstruction* output = root->operand(i);
+      if (output->opcode() != HloOpcode::kReduce) {
+        continue;
+      }
+      accumulator_addrs[i] = llvm_ir::EmitAllocaAtFunctionEntry(
+          llvm_ir::PrimitiveTypeToIrType(output->shape().element_type(),
+                                         module_),
+          absl::StrCat("accumulator_", i), &b_);
+      TF_ASSIGN_OR_RETURN(
+          llvm::Value* const init_value,
+          fused_emitter.GetGenerator(output->operand(1))(
+              llvm_ir::IrArray::Index(index_type)));
+      Store(init_value, accumulator_addrs[i]);
+    }
+
+    llvm_ir::ForLoopNest loops(IrName(fusion, "inner"), &b_, index_type);
+    std::vector<llvm::Value*> input_multi_index =
+        loops.AddLoopsForShapeOnDimensions(input_shape, reduced_dimensions,
+                                           "reduction_dim");
+    SetToFirstInsertPoint(loops.GetInnerLoopBodyBasicBlock(), &b_);
+    auto it = index.begin();
+    for (auto& i : input_multi_index) {
+      if (i == nullptr) {
+        i = *it++;
+      }
+    }
+    CHECK(index.end() == it);
+    llvm_ir::IrArray::Index input_index(input_multi_index, input_shape,
+                                        index_type);
+
+    for (int64 i = 0; i < root->operand_count(); ++i) {
+      const HloInstruction* output = root->operand(i);
+      if (output->opcode() == HloOpcode::kReduce) {
+        TF_ASSIGN_OR_RETURN(
+            llvm::Value* const input_value,
+            fused_emitter.GetGenerator(output->operand(0))(input_index));
+        llvm::Value* result = EmitScalarReturningThreadLocalCall(
+            *output->to_apply(), {Load(accumulator_addrs[i]), input_value},
+            "reduce_function");
+        Store(result, accumulator_addrs[i]);
+      } else {
+        TF_ASSIGN_OR_RETURN(llvm::Value* const value,
+                            fused_emitter.GetGenerator(output)(input_index));
+        output_arrays[i].EmitWriteArrayElement(input_index, value, &b_);
+      }
+    }
+
+    SetToFirstInsertPoint(loops.GetOuterLoopExitBasicBlock(), &b_);
+    for (int64 i = 0; i < root->operand_count(); ++i) {
+      if (accumulator_addrs[i] != nullptr) {
+        output_arrays[i].EmitWriteArrayElement(
+            index, Load(accumulator_addrs[i]), &b_);
+      }
+    }
+    return Status::OK();
+  };
+  TF_RETURN_IF_ERROR(
+      llvm_ir::LoopEmitter(body_emitter, first_reduce->shape(), &b_)
+          .EmitLoop(IrName(fusion)));
+
+  std::vector<llvm::Value*> tuple_operand_ptrs;
+  for (const llvm_ir::IrArray& output_array : output_arrays) {
+    tuple_operand_ptrs.push_back(output_array.GetBasePointer());
+  }
+  llvm_ir::EmitTuple(GetIrArrayFor(fusion), tuple_operand_ptrs, &b_);
+  return Status::OK();
+}
+
 Status IrEmitter::EmitMemcpy(const HloInstruction& source,
                              const HloInstruction& destination) {
   llvm::Value* source_value = GetEmittedValueFor(&source);
@@ -55,6 +55,9 @@ limitations under the License.
 #include "tensorflow/core/platform/types.h"
 
 namespace xla {
+
+class FusedIrEmitter;
+
 namespace cpu {
 // This class is the top-level API for the XLA HLO --> LLVM IR compiler.  It
 // implements the DfsHloVisitor interface and emits HLO computations as LLVM IR
@@ -321,6 +324,15 @@ class IrEmitter : public DfsHloVisitorWithDefault,
       HloInstruction* target_op, absl::string_view desc,
       const llvm_ir::ElementGenerator& element_generator);
 
+  // Emits a multi-output loop fusion whose outputs include reductions.  The
+  // reductions must all reduce same-shaped inputs over the same dimensions,
+  // and the other outputs must have that input shape (as arranged by
+  // CpuMultiOutputFusion).  A single loop nest over the input shape computes
+  // every reduction and writes every elementwise output, so values shared by
+  // the outputs are generated once per input element.
+  Status EmitMultiOutputReductionFusion(HloInstruction* fusion,
+                                        const FusedIrEmitter& fused_emitter);
+
   // Emits a memcpy from the source instruction's result value to the
   // destination's.  Both source and destination must have an entry in the
   // emitted_value_ table.
@@ -128,11 +128,14 @@ std::vector<llvm::Value*> GetArrayFunctionCallArguments(
     llvm::Value* profile_counters_arg);
 
 // Emits a call to a runtime fork/join function which dispatches parallel
-// calls to 'parallel_function' (and joins threads before returning).
+// calls to 'parallel_function' (and joins threads before returning).  If
+// 'use_persistent_team' is true, the calls run on a team of threads that
+// persists across fork/joins instead of as thread pool tasks.
 Status EmitCallToParallelForkJoin(
     const std::vector<llvm::Value*>& arguments, const Shape& shape,
     const std::vector<int64>& dimension_partition_counts, llvm::IRBuilder<>* b,
-    llvm::Function* parallel_function, const string& name);
+    llvm::Function* parallel_function, const string& name,
+    bool use_persistent_team = false);
 
 }  // namespace cpu
 }  // namespace xla
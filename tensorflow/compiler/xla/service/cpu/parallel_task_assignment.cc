@@ -16,7 +16,9 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/cpu/parallel_task_assignment.h"
 
 #include "absl/memory/memory.h"
+#include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/strip.h"
 #include "tensorflow/compiler/xla/service/cpu/dot_op_emitter.h"
 #include "tensorflow/compiler/xla/service/cpu/ir_emission_utils.h"
 #include "tensorflow/compiler/xla/service/cpu/shape_partition.h"
@@ -24,6 +26,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
 #include "tensorflow/compiler/xla/service/hlo_opcode.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/dynamic_update_slice_util.h"
+#include "tensorflow/core/platform/env.h"
 
 namespace xla {
 namespace cpu {
@@ -106,10 +109,153 @@ class DefaultCostModel : public ParallelCostModel {
   const std::unique_ptr<HloCostAnalysis> cost_analysis_;
 };
 
+// Chooses task counts from the measured run times of instructions, and defers
+// to 'fallback' for the instructions the profile doesn't cover.
+//
+// Unlike DefaultCostModel, this doesn't guess which instructions are bound by
+// memory bandwidth: if an instruction was measured with several tasks, the
+// measurement already reflects how well it scaled.
+class ProfileGuidedCostModel : public ParallelCostModel {
+ public:
+  ProfileGuidedCostModel(const int64 max_parallelism,
+                         const ParallelTaskProfile& profile,
+                         std::unique_ptr<ParallelCostModel> fallback)
+      : max_parallelism_(max_parallelism),
+        profile_(profile),
+        fallback_(std::move(fallback)) {}
+  ~ProfileGuidedCostModel() override {}
+
+  int64 GetParallelTaskCount(HloInstruction* instruction) override {
+    const ParallelTaskProfile::Measurement* measurement =
+        profile_.Find(*instruction);
+    if (measurement == nullptr) {
+      return fallback_->GetParallelTaskCount(instruction);
+    }
+    // The total work of the instruction, assuming it scaled linearly with the
+    // task count it was measured with.
+    const int64 work_cycles =
+        measurement->cycles * measurement->parallel_task_count;
+    // Minimum per-task work is 50us on a 2GHz core, enough to amortize
+    // dispatching the task.
+    const int64 min_cycles_per_task = 100000;
+    // Return target parallel task count in [1, max_parallelism_].
+    return std::min(max_parallelism_,
+                    std::max(int64{1}, work_cycles / min_cycles_per_task));
+  }
+
+ private:
+  const int64 max_parallelism_;
+  const ParallelTaskProfile& profile_;
+  const std::unique_ptr<ParallelCostModel> fallback_;
+};
+
+/*static*/ StatusOr<ParallelTaskProfile> ParallelTaskProfile::FromProto(
+    const HloExecutionProfileData& data) {
+  const auto& counters = data.profile_counters();
+  auto read_counter = [&](int64 index) -> StatusOr<int64> {
+    if (index < 0 || index >= counters.size()) {
+      return InvalidArgument("Profile counter %d out of range [0, %d)", index,
+                             counters.size());
+    }
+    return counters[index];
+  };
+
+  // The task counts of the instructions parallelized in the profiled run,
+  // keyed by the name of the computation they were outlined to.
+  absl::flat_hash_map<string, int64> outlined_task_counts;
+  for (const auto& computation_info :
+       data.printer_data().computation_infos()) {
+    if (!absl::StartsWith(computation_info.name(), "parallel_")) {
+      continue;
+    }
+    // Only the outlined instruction has outer dimension partitions.
+    int64& task_count = outlined_task_counts[computation_info.name()];
+    task_count = 1;
+    for (const auto& instruction_info : computation_info.instruction_infos()) {
+      for (int64 partitions : instruction_info.outer_dimension_partitions()) {
+        task_count *= partitions;
+      }
+    }
+  }
+
+  ParallelTaskProfile profile;
+  profile.module_name_ = data.printer_data().module_name();
+  for (const auto& computation_info :
+       data.printer_data().computation_infos()) {
+    if (outlined_task_counts.contains(computation_info.name())) {
+      // Accounted for by the call to the computation below.
+      continue;
+    }
+    for (const auto& instruction_info : computation_info.instruction_infos()) {
+      if (instruction_info.name().empty()) {
+        return InvalidArgument(
+            "Instruction of computation %s has no name, the profile "
+            "predates instruction names",
+            computation_info.name());
+      }
+      Measurement measurement;
+      TF_ASSIGN_OR_RETURN(measurement.cycles,
+                          read_counter(instruction_info.profile_index()));
+      absl::string_view name = instruction_info.name();
+
+      // A call to an outlined "parallel_<name>" computation stands for the
+      // instruction <name> as it was before ParallelTaskAssigner outlined it.
+      for (const string& callee : instruction_info.called_computation_names()) {
+        auto it = outlined_task_counts.find(callee);
+        if (it != outlined_task_counts.end()) {
+          name = absl::StripPrefix(callee, "parallel_");
+          measurement.parallel_task_count = it->second;
+        }
+      }
+      profile.measurements_[string(name)] = measurement;
+    }
+  }
+  return profile;
+}
+
+/*static*/ StatusOr<ParallelTaskProfile> ParallelTaskProfile::Load(
+    const string& path) {
+  HloExecutionProfileData data;
+  TF_RETURN_IF_ERROR(
+      tensorflow::ReadBinaryProto(tensorflow::Env::Default(), path, &data));
+  return FromProto(data);
+}
+
+/*static*/ std::unique_ptr<ParallelTaskProfile>
+ParallelTaskProfile::LoadForModule(const HloModule& module) {
+  const string& path =
+      module.config().debug_options().xla_cpu_parallel_task_profile();
+  if (path.empty()) {
+    return nullptr;
+  }
+  StatusOr<ParallelTaskProfile> profile = Load(path);
+  if (profile.ok() && profile.ValueOrDie().module_name() != module.name()) {
+    // Instruction names are only meaningful within one module.
+    profile = InvalidArgument("Profile is of module \"%s\", not \"%s\"",
+                              profile.ValueOrDie().module_name(),
+                              module.name());
+  }
+  if (!profile.ok()) {
+    LOG(WARNING) << "Ignoring parallel task profile " << path << ": "
+                 << profile.status();
+    return nullptr;
+  }
+  VLOG(1) << "Using " << profile.ValueOrDie().size()
+          << " measured instructions from parallel task profile " << path;
+  return absl::make_unique<ParallelTaskProfile>(profile.ConsumeValueOrDie());
+}
+
+const ParallelTaskProfile::Measurement* ParallelTaskProfile::Find(
+    const HloInstruction& instruction) const {
+  auto it = measurements_.find(instruction.name());
+  return it == measurements_.end() ? nullptr : &it->second;
+}
+
 ParallelTaskAssignment::ParallelTaskAssignment(
     const int64 max_parallelism,
     const HloCostAnalysis::ShapeSizeFunction& shape_size, HloModule* module,
-    const TargetMachineFeatures* target_machine_features)
+    const TargetMachineFeatures* target_machine_features,
+    const ParallelTaskProfile* profile)
     : target_machine_features_(*target_machine_features) {
   VLOG(1) << "ParallelTaskAssignment max_parallelism: " << max_parallelism;
   // Run cost analysis on 'module'.
@@ -126,13 +272,19 @@ ParallelTaskAssignment::ParallelTaskAssignment(
     // HLOs like CustomCall are not yet implemented in the HloCostAnalysis).
     cost_model_.reset(new SimpleCostModel(max_parallelism, shape_size));
   }
+
+  if (profile != nullptr) {
+    cost_model_.reset(new ProfileGuidedCostModel(max_parallelism, *profile,
+                                                 std::move(cost_model_)));
+  }
 }
 
 int64 ParallelTaskAssignment::GetTargetParallelTaskCount(
     HloInstruction* instruction) {
   // Currently, we do not assign parallel tasks to instructions with at least
   // one of the following properties:
-  // *) Internal threading (library calls to kConv, kDot, kFft, kCustomCall).
+  // *) Internal threading (library calls to kConv, kDot, kFft, kCustomCall,
+  //    and low precision GEMM fusions).
   // *) Emit custom loops (kSelectAndScatter).
   // *) Operations that are not thread safe (like infeed and rng).
   // *) Tuple-shaped.
@@ -143,7 +295,9 @@ int64 ParallelTaskAssignment::GetTargetParallelTaskCount(
   // TODO(b/27458679) Parallelize instructions which are skipped here.
   auto opcode = instruction->opcode();
   if (llvm_ir::MayBeImplementedAsInPlaceDynamicUpdateSlice(instruction) ||
-      instruction->shape().IsTuple() || opcode == HloOpcode::kRng) {
+      instruction->shape().IsTuple() || opcode == HloOpcode::kRng ||
+      PotentiallyImplementedAsLowPrecisionGemm(*instruction,
+                                               target_machine_features_)) {
     return 1;
   }
 
@@ -245,9 +399,9 @@ bool ParallelTaskAssigner::AssignParallelTasksHelper(
 
 void ParallelTaskAssigner::ComputeTargetParallelTasks(
     HloModule* module, HloToParallelTasks* hlo_to_parallel_tasks) {
-  ParallelTaskAssignment parallel_task_assignment(max_parallelism_,
-                                                  shape_size_function_, module,
-                                                  &target_machine_features_);
+  ParallelTaskAssignment parallel_task_assignment(
+      max_parallelism_, shape_size_function_, module, &target_machine_features_,
+      profile_);
 
   // Compute parallel task counts for all instructions in 'module'.
   for (auto* computation : module->MakeNonfusionComputations()) {
@@ -16,8 +16,13 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_XLA_SERVICE_CPU_PARALLEL_TASK_ASSIGNMENT_H_
 #define TENSORFLOW_COMPILER_XLA_SERVICE_CPU_PARALLEL_TASK_ASSIGNMENT_H_
 
+#include <memory>
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
 #include "tensorflow/compiler/xla/service/cpu/target_machine_features.h"
 #include "tensorflow/compiler/xla/service/hlo_cost_analysis.h"
+#include "tensorflow/compiler/xla/service/hlo_execution_profile_data.pb.h"
 #include "tensorflow/compiler/xla/service/hlo_module.h"
 #include "tensorflow/compiler/xla/service/hlo_pass_interface.h"
 
@@ -31,6 +36,47 @@ class ParallelCostModel {
   virtual int64 GetParallelTaskCount(HloInstruction* instruction) = 0;
 };
 
+// The run times of the instructions of a module measured by a previous,
+// profiled (--xla_hlo_profile) run of the module, and the parallel task
+// counts they were measured with.
+class ParallelTaskProfile {
+ public:
+  struct Measurement {
+    // Wall-clock cycles taken by the instruction.
+    int64 cycles = 0;
+    // The parallel task count the instruction ran with.
+    int64 parallel_task_count = 1;
+  };
+
+  // Builds the profile from the counters of a profiled run.
+  static StatusOr<ParallelTaskProfile> FromProto(
+      const HloExecutionProfileData& data);
+
+  // Reads the HloExecutionProfileData at 'path', as dumped with
+  // --xla_dump_to.
+  static StatusOr<ParallelTaskProfile> Load(const string& path);
+
+  // Loads the profile named by the debug options of 'module'. Returns nullptr
+  // if there is none, or if it can't be read or is of another module, in
+  // which case a warning is logged.
+  static std::unique_ptr<ParallelTaskProfile> LoadForModule(
+      const HloModule& module);
+
+  // Returns the measurement of 'instruction', or nullptr if it wasn't
+  // profiled. Instructions are identified by name, so the profile must come
+  // from a run of the same module, see module_name().
+  const Measurement* Find(const HloInstruction& instruction) const;
+
+  // The name of the profiled module.
+  const string& module_name() const { return module_name_; }
+
+  int64 size() const { return measurements_.size(); }
+
+ private:
+  string module_name_;
+  absl::flat_hash_map<string, Measurement> measurements_;
+};
+
 // ParallelTaskAssignment computes parallel task counts for HLOs in 'module'.
 class ParallelTaskAssignment {
  public:
@@ -38,10 +84,14 @@ class ParallelTaskAssignment {
   // 'shape_size': shape size function used by HloCostAnalysis during parallel
   //               task assignment.
   // 'module': the containing HloModule.
+  // 'profile': if not null, a profile of 'module' from which the task counts
+  //            of the profiled instructions are derived. Must outlive this
+  //            object.
   ParallelTaskAssignment(const int64 max_parallelism,
                          const HloCostAnalysis::ShapeSizeFunction& shape_size,
                          HloModule* module,
-                         const TargetMachineFeatures* target_machine_features);
+                         const TargetMachineFeatures* target_machine_features,
+                         const ParallelTaskProfile* profile);
   ~ParallelTaskAssignment() {}
 
   // Computes and returns the target parallel task count for 'instruction'.
@@ -65,12 +115,16 @@ class ParallelTaskAssigner : public HloModulePass {
   // 'max_parallelism': the maximum parallel task count per instruction.
   // 'shape_size': shape size function used by HloCostAnalysis during parallel
   //               task assignment.
+  // 'profile': if not null, a profile of the module the pass runs on, see
+  //            ParallelTaskProfile::LoadForModule. Must outlive the pass.
   ParallelTaskAssigner(const int64 max_parallelism,
                        const HloCostAnalysis::ShapeSizeFunction& shape_size,
-                       const TargetMachineFeatures* target_machine_features)
+                       const TargetMachineFeatures* target_machine_features,
+                       const ParallelTaskProfile* profile)
       : max_parallelism_(max_parallelism),
         shape_size_function_(shape_size),
-        target_machine_features_(*target_machine_features) {}
+        target_machine_features_(*target_machine_features),
+        profile_(profile) {}
   ~ParallelTaskAssigner() override {}
 
   absl::string_view name() const override {
@@ -101,6 +155,7 @@ class ParallelTaskAssigner : public HloModulePass {
   int64 max_parallelism_;
   HloCostAnalysis::ShapeSizeFunction shape_size_function_;
   const TargetMachineFeatures& target_machine_features_;
+  const ParallelTaskProfile* profile_;
 };
 
 }  // namespace cpu
@@ -14,11 +14,14 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/compiler/xla/service/cpu/parallel_task_assignment.h"
+#include "absl/strings/str_cat.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_executable.h"
 #include "tensorflow/compiler/xla/service/cpu/target_machine_features_fake.h"
 #include "tensorflow/compiler/xla/test.h"
 #include "tensorflow/compiler/xla/tests/hlo_test_base.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/path.h"
 
 namespace xla {
 namespace {
@@ -39,11 +42,58 @@ class ParallelTaskAssignmentTest : public HloTestBase {
           return cpu::TargetMachineFeatures::kEigenExpectedTensorAlignment;
         }) {}
 
+  // Runs the pass with the profile named by the debug options of 'module',
+  // if any, as CpuCompiler does.
   StatusOr<bool> RunParallelTaskAssigner(HloModule* module) {
+    std::unique_ptr<cpu::ParallelTaskProfile> profile =
+        cpu::ParallelTaskProfile::LoadForModule(*module);
     return cpu::ParallelTaskAssigner(max_parallelism_, shape_size_func_,
-                                     &target_machine_features_)
+                                     &target_machine_features_, profile.get())
         .Run(module);
   }
+
+  // Points 'module' at a profile of itself in which each instruction named in
+  // 'cycles' took that many cycles.
+  void SetProfile(HloModule* module,
+                  const std::vector<std::pair<string, int64>>& cycles) {
+    HloExecutionProfileData data;
+    data.mutable_printer_data()->set_module_name(module->name());
+    auto* computation_info =
+        data.mutable_printer_data()->add_computation_infos();
+    computation_info->set_name(module->entry_computation()->name());
+    for (const auto& name_and_cycles : cycles) {
+      auto* instruction_info = computation_info->add_instruction_infos();
+      instruction_info->set_name(name_and_cycles.first);
+      instruction_info->set_profile_index(data.profile_counters_size());
+      data.add_profile_counters(name_and_cycles.second);
+    }
+    const string path = tensorflow::io::JoinPath(
+        tensorflow::testing::TmpDir(), absl::StrCat(module->name(), ".pb"));
+    TF_CHECK_OK(
+        tensorflow::WriteBinaryProto(tensorflow::Env::Default(), path, data));
+
+    HloModuleConfig config = module->config();
+    DebugOptions debug_options = config.debug_options();
+    debug_options.set_xla_cpu_parallel_task_profile(path);
+    config.set_debug_options(debug_options);
+    module->set_config(config);
+  }
+
+  // Returns the parallel task count assigned to the instruction outlined to
+  // 'parallel_<name>', or 1 if it wasn't parallelized.
+  int64 AssignedTaskCount(HloModule* module, const string& name) {
+    for (HloComputation* computation : module->computations()) {
+      if (computation->name() == absl::StrCat("parallel_", name)) {
+        int64 count = 1;
+        for (int64 partitions :
+             computation->root_instruction()->outer_dimension_partitions()) {
+          count *= partitions;
+        }
+        return count;
+      }
+    }
+    return 1;
+  }
 };
 
 TEST_F(ParallelTaskAssignmentTest, DotOperationNotParallelized) {
@@ -191,5 +241,154 @@ TEST_F(ParallelTaskAssignmentTest, AllReduceNotParallelized) {
   EXPECT_FALSE(changed);
 }
 
+TEST_F(ParallelTaskAssignmentTest, ProfileTracksOutlinedInstructions) {
+  const string hlo_string = R"(
+    HloModule TestTaskParallel_Profile
+    ENTRY Profile {
+      p = f32[1024,1024] parameter(0)
+      ROOT exp.1 = f32[1024,1024] exponential(p)
+    }
+  )";
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> m,
+                          ParseAndReturnVerifiedModule(hlo_string));
+
+  // The profile of a run in which exp.1 was outlined and split in 8 tasks.
+  HloExecutionProfileData data;
+  auto* entry = data.mutable_printer_data()->add_computation_infos();
+  entry->set_name("Profile");
+  auto* call = entry->add_instruction_infos();
+  call->set_name("call");
+  call->add_called_computation_names("parallel_exp.1");
+  call->set_profile_index(0);
+  auto* outlined = data.mutable_printer_data()->add_computation_infos();
+  outlined->set_name("parallel_exp.1");
+  auto* param = outlined->add_instruction_infos();
+  param->set_name("param_0");
+  param->set_profile_index(1);
+  auto* root = outlined->add_instruction_infos();
+  root->set_name("exp.2");
+  root->add_outer_dimension_partitions(2);
+  root->add_outer_dimension_partitions(4);
+  root->set_profile_index(2);
+  data.add_profile_counters(50000);
+  data.add_profile_counters(0);
+  data.add_profile_counters(40000);
+
+  TF_ASSERT_OK_AND_ASSIGN(cpu::ParallelTaskProfile profile,
+                          cpu::ParallelTaskProfile::FromProto(data));
+  const cpu::ParallelTaskProfile::Measurement* measurement =
+      profile.Find(*m->entry_computation()->root_instruction());
+  ASSERT_NE(measurement, nullptr);
+  EXPECT_EQ(50000, measurement->cycles);
+  EXPECT_EQ(8, measurement->parallel_task_count);
+
+  data.mutable_printer_data()
+      ->mutable_computation_infos(0)
+      ->mutable_instruction_infos(0)
+      ->set_profile_index(3);
+  EXPECT_FALSE(cpu::ParallelTaskProfile::FromProto(data).ok());
+
+  // Profiles dumped before instruction names were recorded can't be matched.
+  data.mutable_printer_data()
+      ->mutable_computation_infos(0)
+      ->mutable_instruction_infos(0)
+      ->set_profile_index(0);
+  EXPECT_TRUE(cpu::ParallelTaskProfile::FromProto(data).ok());
+  data.mutable_printer_data()
+      ->mutable_computation_infos(0)
+      ->mutable_instruction_infos(0)
+      ->clear_name();
+  EXPECT_FALSE(cpu::ParallelTaskProfile::FromProto(data).ok());
+}
+
+TEST_F(ParallelTaskAssignmentTest, ProfileGuidesTaskCounts) {
+  const string hlo_string = R"(
+    HloModule TestTaskParallel_ProfileGuided
+    add {
+      lhs = f32[] parameter(0)
+      rhs = f32[] parameter(1)
+      ROOT add = f32[] add(lhs, rhs)
+    }
+    ENTRY ProfileGuided {
+      p0 = f32[1024,1024] parameter(0)
+      p1 = f32[1024,1024] parameter(1)
+      sum = f32[1024,1024] add(p0, p1)
+      zero = f32[] constant(0)
+      ROOT reduce = f32[1024] reduce(sum, zero), dimensions={1}, to_apply=add
+    }
+  )";
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> m,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  // The elementwise add was measured to be too cheap to split, the reduce to
+  // be worth splitting across all threads.
+  SetProfile(m.get(), {{"sum", 20000}, {"reduce", 50000000}});
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunParallelTaskAssigner(m.get()));
+  EXPECT_TRUE(changed);
+  EXPECT_EQ(1, AssignedTaskCount(m.get(), "sum"));
+  EXPECT_EQ(max_parallelism_, AssignedTaskCount(m.get(), "reduce"));
+}
+
+TEST_F(ParallelTaskAssignmentTest, ProfileOfOtherModuleIsIgnored) {
+  const string hlo_string = R"(
+    HloModule TestTaskParallel_OtherModuleProfile
+    add {
+      lhs = f32[] parameter(0)
+      rhs = f32[] parameter(1)
+      ROOT add = f32[] add(lhs, rhs)
+    }
+    ENTRY OtherModuleProfile {
+      p0 = f32[1024,1024] parameter(0)
+      p1 = f32[1024,1024] parameter(1)
+      sum = f32[1024,1024] add(p0, p1)
+      zero = f32[] constant(0)
+      ROOT reduce = f32[1024] reduce(sum, zero), dimensions={1}, to_apply=add
+    }
+  )";
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> m,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> expected,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  SetProfile(m.get(), {{"sum", 20000}, {"reduce", 50000000}});
+  // The instructions have the same names in another module, but they may
+  // compute something else entirely.
+  m->set_name("TestTaskParallel_RenamedModule");
+  // Falls back to the default cost model.
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunParallelTaskAssigner(m.get()));
+  TF_ASSERT_OK_AND_ASSIGN(bool expected_changed,
+                          RunParallelTaskAssigner(expected.get()));
+  EXPECT_EQ(expected_changed, changed);
+  EXPECT_EQ(AssignedTaskCount(expected.get(), "sum"),
+            AssignedTaskCount(m.get(), "sum"));
+  EXPECT_EQ(AssignedTaskCount(expected.get(), "reduce"),
+            AssignedTaskCount(m.get(), "reduce"));
+}
+
+TEST_F(ParallelTaskAssignmentTest, UnreadableProfileIsIgnored) {
+  const string hlo_string = R"(
+    HloModule TestTaskParallel_BadProfile
+    ENTRY BadProfile {
+      p0 = f32[1024,1024] parameter(0)
+      ROOT exp = f32[1024,1024] exponential(p0)
+    }
+  )";
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> m,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> expected,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  HloModuleConfig config = m->config();
+  DebugOptions debug_options = config.debug_options();
+  debug_options.set_xla_cpu_parallel_task_profile(tensorflow::io::JoinPath(
+      tensorflow::testing::TmpDir(), "no_such_profile.pb"));
+  config.set_debug_options(debug_options);
+  m->set_config(config);
+  // Falls back to the default cost model.
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunParallelTaskAssigner(m.get()));
+  TF_ASSERT_OK_AND_ASSIGN(bool expected_changed,
+                          RunParallelTaskAssigner(expected.get()));
+  EXPECT_EQ(expected_changed, changed);
+  EXPECT_EQ(AssignedTaskCount(expected.get(), "exp"),
+            AssignedTaskCount(m.get(), "exp"));
+}
+
 }  // namespace
 }  // namespace xla
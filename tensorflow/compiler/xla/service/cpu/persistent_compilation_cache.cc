@@ -0,0 +1,120 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/cpu/persistent_compilation_cache.h"
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "llvm/Config/llvm-config.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/path.h"
+
+namespace xla {
+namespace cpu {
+
+namespace {
+
+// Bump this whenever the meaning of a cache entry changes, to invalidate
+// existing cache directories.
+constexpr int kCacheFormatVersion = 1;
+
+}  // namespace
+
+/*static*/ std::unique_ptr<PersistentCompilationCache>
+PersistentCompilationCache::ForModule(const HloModule& module) {
+  const HloModuleConfig& config = module.config();
+  const std::string& directory =
+      config.debug_options().xla_cpu_persistent_cache_dir();
+  if (directory.empty()) {
+    return nullptr;
+  }
+  // A nonzero seed makes every compilation unique (see
+  // HloModuleConfig::compilation_cache_key), profiling and embedded IR
+  // need artifacts that the cache does not store, and a parallel task profile
+  // changes the compilation result without changing the module.
+  if (config.seed() != 0 || config.hlo_profiling_enabled() ||
+      config.debug_options().xla_embed_ir_in_executable() ||
+      !config.debug_options().xla_cpu_parallel_task_profile().empty()) {
+    return nullptr;
+  }
+  return absl::make_unique<PersistentCompilationCache>(directory);
+}
+
+PersistentCompilationCache::PersistentCompilationCache(std::string directory,
+                                                       tensorflow::Env* env)
+    : directory_(std::move(directory)),
+      env_(env != nullptr ? env : tensorflow::Env::Default()) {}
+
+/*static*/ std::string PersistentCompilationCache::Key(
+    const HloModule& module, const llvm::TargetMachine& target_machine,
+    absl::string_view stage) {
+  // Constants and backend configs change the generated code, so unlike
+  // HloPrintOptions::Fingerprint() they must be part of the key.
+  const std::string module_string = module.ToString(
+      HloPrintOptions::Fingerprint()
+          .set_print_large_constants(true)
+          .set_print_backend_config(true));
+  const std::string key_string = absl::StrCat(
+      kCacheFormatVersion, ";", stage, ";", LLVM_VERSION_STRING, ";",
+      target_machine.getTargetTriple().str(), ";",
+      target_machine.getTargetCPU().str(), ";",
+      target_machine.getTargetFeatureString().str(), ";",
+      module.config().compilation_cache_key(), ";",
+      module.entry_computation_layout().ToString(), ";", module_string);
+  const tensorflow::Fprint128 fingerprint =
+      tensorflow::Fingerprint128(key_string);
+  return absl::StrFormat("%016x%016x", fingerprint.high64, fingerprint.low64);
+}
+
+absl::optional<PersistentCompilationCacheEntry>
+PersistentCompilationCache::Lookup(const std::string& key) const {
+  const std::string path = EntryPath(key);
+  if (!env_->FileExists(path).ok()) {
+    return absl::nullopt;
+  }
+  PersistentCompilationCacheEntry entry;
+  Status status = tensorflow::ReadBinaryProto(env_, path, &entry);
+  if (!status.ok()) {
+    LOG(WARNING) << "Ignoring unreadable compilation cache entry " << path
+                 << ": " << status;
+    return absl::nullopt;
+  }
+  return entry;
+}
+
+Status PersistentCompilationCache::Insert(
+    const std::string& key,
+    const PersistentCompilationCacheEntry& entry) const {
+  TF_RETURN_IF_ERROR(env_->RecursivelyCreateDir(directory_));
+  std::string temp_path = tensorflow::io::JoinPath(directory_, key);
+  if (!env_->CreateUniqueFileName(&temp_path, ".tmp")) {
+    return InternalError("Unable to create a temporary file name for %s",
+                         temp_path);
+  }
+  TF_RETURN_IF_ERROR(tensorflow::WriteBinaryProto(env_, temp_path, entry));
+  return env_->RenameFile(temp_path, EntryPath(key));
+}
+
+std::string PersistentCompilationCache::EntryPath(
+    const std::string& key) const {
+  return tensorflow::io::JoinPath(directory_, absl::StrCat(key, ".pb"));
+}
+
+}  // namespace cpu
+}  // namespace xla
@@ -0,0 +1,79 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_CPU_PERSISTENT_COMPILATION_CACHE_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_CPU_PERSISTENT_COMPILATION_CACHE_H_
+
+#include <memory>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "llvm/Target/TargetMachine.h"
+#include "tensorflow/compiler/xla/service/cpu/persistent_compilation_cache.pb.h"
+#include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/status.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace xla {
+namespace cpu {
+
+// An on-disk cache of CPU compilation results, shared by all processes that
+// point --xla_cpu_persistent_cache_dir at the same directory.
+//
+// Entries are keyed by a fingerprint of the HLO module (including its
+// constants and layouts), its HloModuleConfig and debug options, the LLVM
+// version, and the target triple, CPU and features of the target machine, so
+// a cache directory can be shared by binaries running on different hosts.
+// Each entry is a PersistentCompilationCacheEntry in its own file; entries
+// are written to a temporary file and renamed into place, so concurrent
+// writers and readers never observe a partial entry.
+class PersistentCompilationCache {
+ public:
+  // Returns the cache selected by `module`'s debug options, or nullptr if
+  // persistent caching is disabled or not applicable to `module`.
+  static std::unique_ptr<PersistentCompilationCache> ForModule(
+      const HloModule& module);
+
+  explicit PersistentCompilationCache(std::string directory,
+                                      tensorflow::Env* env = nullptr);
+
+  // Returns the key under which the result of compiling `module` for
+  // `target_machine` is cached. `stage` distinguishes the results of the
+  // different compilation phases of the same module.
+  static std::string Key(const HloModule& module,
+                         const llvm::TargetMachine& target_machine,
+                         absl::string_view stage);
+
+  // Returns the entry stored under `key`, if any. Unreadable entries are
+  // treated as missing.
+  absl::optional<PersistentCompilationCacheEntry> Lookup(
+      const std::string& key) const;
+
+  // Stores `entry` under `key`, replacing any previous entry.
+  Status Insert(const std::string& key,
+                const PersistentCompilationCacheEntry& entry) const;
+
+ private:
+  std::string EntryPath(const std::string& key) const;
+
+  const std::string directory_;
+  tensorflow::Env* const env_;
+};
+
+}  // namespace cpu
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_CPU_PERSISTENT_COMPILATION_CACHE_H_
@@ -17,11 +17,21 @@ limitations under the License.
 
 #define EIGEN_USE_THREADS
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <map>
+#include <mutex>  // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/compiler/xla/executable_run_options.h"
 #include "tensorflow/core/platform/blocking_counter.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/dynamic_annotations.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/types.h"
 
 using tensorflow::int32;
@@ -31,6 +41,214 @@ using tensorflow::uint64;
 using ComputeFunctionType = void (*)(void*, const void*, const void**, void**,
                                      int64*, uint64*);
 
+namespace {
+
+// The arguments of one parallel region, shared by all of its partitions.
+struct ParallelRegion {
+  ComputeFunctionType function;
+  void* result_ptr;
+  const void* run_options_ptr;
+  const void** params;
+  void** buffer_table;
+  uint64* prof_counters;
+  int32 num_partitions;
+  int64* partitions;
+  // Stride of a partition in 'partitions'.
+  int64 stride;
+
+  void RunPartition(int32 i) const {
+    // Only the first partition gets 'params', as in the fork/join below.
+    function(result_ptr, run_options_ptr, i == 0 ? params : nullptr,
+             buffer_table, &partitions[i * stride], prof_counters);
+  }
+};
+
+// Runs partition 0 of 'region' on the calling thread and the others as tasks
+// on the intra-op thread pool, and waits for all of them.
+void ForkJoinOnThreadPool(const ParallelRegion& region) {
+  const xla::ExecutableRunOptions* run_options =
+      static_cast<const xla::ExecutableRunOptions*>(region.run_options_ptr);
+  // Dispatch 'num_partitions - 1' compute functions to run in parallel.
+  tensorflow::BlockingCounter bc(region.num_partitions - 1);
+  for (int32 i = 1; i < region.num_partitions; ++i) {
+    run_options->intra_op_thread_pool()->enqueueNoNotification(
+        [i, &region, &bc]() {
+          region.RunPartition(i);
+          bc.DecrementCount();
+          VLOG(3) << "ParallelForkJoin partition " << i << " done.";
+        });
+  }
+
+  // Call first compute function inline.
+  region.RunPartition(0);
+  VLOG(3) << "ParallelForkJoin partition 0 done.";
+  bc.Wait();
+}
+
+// A fixed team of threads that runs the partitions of parallel regions.
+//
+// Member 0 of the team is the thread that calls Run, members 1 to size - 1
+// are threads owned by the team.  Partitions are split into contiguous runs,
+// one per member, so that a member gets the same slices of the iteration
+// space in consecutive regions of a computation when their partitions match,
+// and finds the data its previous region wrote in its own cache.  When the
+// host has several NUMA nodes, the owned threads are bound to nodes in member
+// order, so neighbouring slices also stay on the same node.
+//
+// Between regions the owned threads spin for kSpinTime, so that back to back
+// regions start without a wakeup, and then sleep until the next region.
+class PersistentTeam {
+ public:
+  // Returns the team with 'size' members, creating it on first use.  Teams
+  // are never destroyed.
+  static PersistentTeam* Get(int32 size) {
+    // Each calling thread remembers its last team, to keep the lock below
+    // off the path of every region.
+    static thread_local int32 cached_size = 0;
+    static thread_local PersistentTeam* cached_team = nullptr;
+    if (cached_size == size) {
+      return cached_team;
+    }
+    static std::mutex* mu = new std::mutex;
+    static auto* teams = new std::map<int32, PersistentTeam*>;
+    std::lock_guard<std::mutex> lock(*mu);
+    PersistentTeam*& team = (*teams)[size];
+    if (team == nullptr) {
+      team = new PersistentTeam(size);
+    }
+    cached_size = size;
+    cached_team = team;
+    return team;
+  }
+
+  // Runs all partitions of 'region' on the team and returns true, or returns
+  // false without running anything if the team is running another region.
+  bool TryRun(const ParallelRegion& region) {
+    if (busy_.exchange(true, std::memory_order_acquire)) {
+      return false;
+    }
+    region_ = &region;
+    pending_.store(size_ - 1, std::memory_order_relaxed);
+    generation_.fetch_add(1);
+    if (sleeping_.load() > 0) {
+      { std::lock_guard<std::mutex> lock(mu_); }
+      cv_.notify_all();
+    }
+
+    RunMemberPartitions(region, /*member=*/0);
+    while (pending_.load(std::memory_order_acquire) > 0) {
+      std::this_thread::yield();
+    }
+    busy_.store(false, std::memory_order_release);
+    return true;
+  }
+
+ private:
+  // How long an idle member spins before it sleeps.
+  static constexpr std::chrono::microseconds kSpinTime{200};
+
+  explicit PersistentTeam(int32 size) : size_(size) {
+    VLOG(1) << "Creating persistent fork/join team of " << size << " threads";
+    const int num_nodes = tensorflow::port::NUMANumNodes();
+    for (int32 member = 1; member < size; ++member) {
+      const int node = tensorflow::port::NUMAEnabled()
+                           ? member * num_nodes / size
+                           : tensorflow::port::kNUMANoAffinity;
+      std::thread([this, member, node]() {
+        if (node != tensorflow::port::kNUMANoAffinity) {
+          tensorflow::port::NUMASetThreadNodeAffinity(node);
+        }
+        MemberLoop(member);
+      }).detach();
+    }
+  }
+
+  void RunMemberPartitions(const ParallelRegion& region, int32 member) {
+    const int32 begin = member * region.num_partitions / size_;
+    const int32 end = (member + 1) * region.num_partitions / size_;
+    for (int32 i = begin; i < end; ++i) {
+      region.RunPartition(i);
+    }
+  }
+
+  void MemberLoop(int32 member) {
+    uint64 seen = 0;
+    while (true) {
+      uint64 generation = WaitForRegion(seen);
+      seen = generation;
+      RunMemberPartitions(*region_, member);
+      pending_.fetch_sub(1, std::memory_order_acq_rel);
+    }
+  }
+
+  // Returns the generation of the next region after 'seen'.
+  uint64 WaitForRegion(uint64 seen) {
+    const auto spin_until = std::chrono::steady_clock::now() + kSpinTime;
+    uint64 generation;
+    while ((generation = generation_.load(std::memory_order_acquire)) ==
+           seen) {
+      if (std::chrono::steady_clock::now() < spin_until) {
+        continue;
+      }
+      // 'sleeping_' is incremented before 'generation_' is checked again, so
+      // a region started after the check sees it and wakes this thread.
+      std::unique_lock<std::mutex> lock(mu_);
+      sleeping_.fetch_add(1);
+      cv_.wait(lock, [&]() { return generation_.load() != seen; });
+      sleeping_.fetch_sub(1);
+    }
+    return generation;
+  }
+
+  const int32 size_;
+  // Set while a region runs on the team.
+  std::atomic<bool> busy_{false};
+  // Incremented to start a region.
+  std::atomic<uint64> generation_{0};
+  // The region started by the last increment of 'generation_'.
+  const ParallelRegion* region_ = nullptr;
+  // Owned threads that have not finished their partitions of the region.
+  std::atomic<int32> pending_{0};
+  // Owned threads sleeping on 'cv_'.
+  std::atomic<int32> sleeping_{0};
+  std::mutex mu_;
+  std::condition_variable cv_;
+};
+
+constexpr std::chrono::microseconds PersistentTeam::kSpinTime;
+
+// Checks the arguments shared by the fork/join entry points and returns the
+// region they describe.
+ParallelRegion MakeParallelRegion(void* result_ptr,
+                                  const void* run_options_ptr,
+                                  const void** params, void** buffer_table,
+                                  uint64* prof_counters, int32 num_partitions,
+                                  int64* partitions,
+                                  int32 num_partitioned_dims,
+                                  void* function_ptr) {
+  CHECK_EQ(params, nullptr);
+  CHECK_GT(num_partitions, 1);
+  CHECK_GT(num_partitioned_dims, 0);
+  CHECK_NE(function_ptr, nullptr);
+  CHECK_NE(partitions, nullptr);
+  const xla::ExecutableRunOptions* run_options =
+      static_cast<const xla::ExecutableRunOptions*>(run_options_ptr);
+  CHECK_NE(run_options, nullptr);
+  CHECK_NE(run_options->intra_op_thread_pool(), nullptr);
+  return {reinterpret_cast<ComputeFunctionType>(function_ptr),
+          result_ptr,
+          run_options_ptr,
+          params,
+          buffer_table,
+          prof_counters,
+          num_partitions,
+          partitions,
+          // Compute partition stride in 'partitions' array.
+          2 * num_partitioned_dims};
+}
+
+}  // namespace
+
 // Dispatches 'num_partitions - 1' calls to 'function_ptr' in parallel.
 // Calls 'function_ptr' for first partition inline.
 // Uses blocking counter to synchronize threads after parallel calls complete.
@@ -66,39 +284,35 @@ TF_ATTRIBUTE_NO_SANITIZE_MEMORY void __xla_cpu_runtime_ParallelForkJoin(
   VLOG(2) << "ParallelForkJoin ENTRY"
           << " num_partitions: " << num_partitions
           << " num_partitioned_dims: " << num_partitioned_dims;
-  CHECK_EQ(params, nullptr);
-  CHECK_GT(num_partitions, 1);
-  CHECK_GT(num_partitioned_dims, 0);
-  CHECK_NE(function_ptr, nullptr);
-  CHECK_NE(partitions, nullptr);
-  const xla::ExecutableRunOptions* run_options =
-      static_cast<const xla::ExecutableRunOptions*>(run_options_ptr);
-  CHECK_NE(run_options, nullptr);
-  CHECK_NE(run_options->intra_op_thread_pool(), nullptr);
-
-  ComputeFunctionType function =
-      reinterpret_cast<ComputeFunctionType>(function_ptr);
-  // Compute partition stride in 'partitions' array.
-  const int64 stride = 2 * num_partitioned_dims;
+  ForkJoinOnThreadPool(MakeParallelRegion(
+      result_ptr, run_options_ptr, params, buffer_table, prof_counters,
+      num_partitions, partitions, num_partitioned_dims, function_ptr));
+  VLOG(2) << "ParallelForkJoin EXIT";
+}
 
-  // Dispatch 'num_partitions - 1' compute functions to run in parallel.
-  tensorflow::BlockingCounter bc(num_partitions - 1);
-  for (int32 i = 1; i < num_partitions; ++i) {
-    const int64 offset = i * stride;
-    run_options->intra_op_thread_pool()->enqueueNoNotification(
-        [i, function, result_ptr, run_options_ptr, buffer_table, prof_counters,
-         partitions, offset, &bc]() {
-          function(result_ptr, run_options_ptr, nullptr, buffer_table,
-                   &partitions[offset], prof_counters);
-          bc.DecrementCount();
-          VLOG(3) << "ParallelForkJoin partition " << i << " done.";
-        });
+// Like ParallelForkJoin, but runs the partitions on the persistent team with
+// as many members as the intra-op thread pool has threads, but no more than
+// there are CPUs: spinning members that share a CPU only slow each other down.
+// Falls back to the thread pool if that leaves a single member, or if the team
+// is running a region for another computation.
+TF_ATTRIBUTE_NO_SANITIZE_MEMORY void
+__xla_cpu_runtime_ParallelForkJoinPersistentTeam(
+    void* result_ptr, const void* run_options_ptr, const void** params,
+    void** buffer_table, uint64* prof_counters, int32 num_partitions,
+    int64* partitions, int32 num_partitioned_dims, void* function_ptr) {
+  VLOG(2) << "ParallelForkJoinPersistentTeam ENTRY"
+          << " num_partitions: " << num_partitions
+          << " num_partitioned_dims: " << num_partitioned_dims;
+  const ParallelRegion region = MakeParallelRegion(
+      result_ptr, run_options_ptr, params, buffer_table, prof_counters,
+      num_partitions, partitions, num_partitioned_dims, function_ptr);
+  static const int32 num_cpus = tensorflow::port::NumSchedulableCPUs();
+  const int32 team_size = std::min<int32>(
+      num_cpus, static_cast<const xla::ExecutableRunOptions*>(run_options_ptr)
+                    ->intra_op_thread_pool()
+                    ->numThreads());
+  if (team_size < 2 || !PersistentTeam::Get(team_size)->TryRun(region)) {
+    ForkJoinOnThreadPool(region);
   }
-
-  // Call first compute function inline.
-  function(result_ptr, run_options_ptr, params, buffer_table, &partitions[0],
-           prof_counters);
-  VLOG(3) << "ParallelForkJoin partition 0 done.";
-  bc.Wait();
-  VLOG(2) << "ParallelForkJoin EXIT";
+  VLOG(2) << "ParallelForkJoinPersistentTeam EXIT";
 }
@@ -0,0 +1,157 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+#include "tensorflow/compiler/xla/service/cpu/runtime_fork_join.h"
+
+#include <atomic>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/compiler/xla/executable_run_options.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace xla {
+namespace {
+
+using tensorflow::int32;
+using tensorflow::int64;
+using tensorflow::uint64;
+
+using ForkJoinFunction = void (*)(void*, const void*, const void**, void**,
+                                  uint64*, int32, int64*, int32, void*);
+
+// A compute function that counts its calls for each partition in the array of
+// atomics in buffer_table[0].  Partition i covers [i, i + 1) of dimension 0.
+void CountPartition(void* /*result_ptr*/, const void* /*run_options_ptr*/,
+                    const void** /*params*/, void** buffer_table,
+                    int64* partition, uint64* /*prof_counters*/) {
+  static_cast<std::atomic<int64>*>(buffer_table[0])[partition[0]]++;
+}
+
+void EmptyPartition(void* /*result_ptr*/, const void* /*run_options_ptr*/,
+                    const void** /*params*/, void** /*buffer_table*/,
+                    int64* /*partition*/, uint64* /*prof_counters*/) {}
+
+// Returns the partitions of a one dimensional shape of size 'num_partitions'
+// into unit slices.
+std::vector<int64> UnitPartitions(int32 num_partitions) {
+  std::vector<int64> partitions;
+  for (int64 i = 0; i < num_partitions; ++i) {
+    partitions.push_back(i);
+    partitions.push_back(i + 1);
+  }
+  return partitions;
+}
+
+// Runs 'num_regions' fork/joins of 'num_partitions' partitions with
+// 'fork_join' and checks that each partition ran once per region.
+void RunRegionsAndCheckCounts(ForkJoinFunction fork_join,
+                              const ExecutableRunOptions& run_options,
+                              int32 num_partitions, int num_regions) {
+  std::vector<int64> partitions = UnitPartitions(num_partitions);
+  std::vector<std::atomic<int64>> counts(num_partitions);
+  void* buffer_table[] = {counts.data()};
+  for (int i = 0; i < num_regions; ++i) {
+    fork_join(/*result_ptr=*/nullptr, &run_options, /*params=*/nullptr,
+              buffer_table, /*prof_counters=*/nullptr, num_partitions,
+              partitions.data(), /*num_partitioned_dims=*/1,
+              reinterpret_cast<void*>(&CountPartition));
+  }
+  for (int32 i = 0; i < num_partitions; ++i) {
+    EXPECT_EQ(counts[i], num_regions) << "partition " << i;
+  }
+}
+
+// The parameter selects the persistent team instead of thread pool tasks.
+class RuntimeForkJoinTest : public ::testing::TestWithParam<bool> {
+ protected:
+  RuntimeForkJoinTest() : pool_(4), device_(&pool_, pool_.NumThreads()) {
+    run_options_.set_intra_op_thread_pool(&device_);
+  }
+
+  ForkJoinFunction fork_join() const {
+    return GetParam() ? &__xla_cpu_runtime_ParallelForkJoinPersistentTeam
+                      : &__xla_cpu_runtime_ParallelForkJoin;
+  }
+
+  Eigen::ThreadPool pool_;
+  Eigen::ThreadPoolDevice device_;
+  ExecutableRunOptions run_options_;
+};
+
+TEST_P(RuntimeForkJoinTest, RunsEachPartitionOnce) {
+  // Fewer, as many and more partitions than threads.
+  for (int32 num_partitions : {2, 3, 4, 7, 16}) {
+    RunRegionsAndCheckCounts(fork_join(), run_options_, num_partitions,
+                             /*num_regions=*/100);
+  }
+}
+
+TEST_P(RuntimeForkJoinTest, ConcurrentCallers) {
+  // Callers that find the team busy run their regions on the thread pool.
+  std::vector<std::thread> callers;
+  for (int i = 0; i < 4; ++i) {
+    callers.emplace_back([this]() {
+      RunRegionsAndCheckCounts(fork_join(), run_options_,
+                               /*num_partitions=*/4, /*num_regions=*/200);
+    });
+  }
+  for (std::thread& caller : callers) {
+    caller.join();
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(ThreadPoolAndPersistentTeam, RuntimeForkJoinTest,
+                         ::testing::Bool());
+
+// Measures the overhead of a fork/join of empty partitions, one per thread.
+void BM_ForkJoin(int iters, int num_threads, int persistent_team) {
+  tensorflow::testing::StopTiming();
+  Eigen::ThreadPool pool(num_threads);
+  Eigen::ThreadPoolDevice device(&pool, pool.NumThreads());
+  ExecutableRunOptions run_options;
+  run_options.set_intra_op_thread_pool(&device);
+  ForkJoinFunction fork_join =
+      persistent_team ? &__xla_cpu_runtime_ParallelForkJoinPersistentTeam
+                      : &__xla_cpu_runtime_ParallelForkJoin;
+  std::vector<int64> partitions = UnitPartitions(num_threads);
+  auto run_region = [&]() {
+    fork_join(/*result_ptr=*/nullptr, &run_options, /*params=*/nullptr,
+              /*buffer_table=*/nullptr, /*prof_counters=*/nullptr,
+              num_threads, partitions.data(), /*num_partitioned_dims=*/1,
+              reinterpret_cast<void*>(&EmptyPartition));
+  };
+  // Warm up, which also starts the team.
+  run_region();
+  tensorflow::testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    run_region();
+  }
+  tensorflow::testing::StopTiming();
+}
+
+BENCHMARK(BM_ForkJoin)
+    ->ArgPair(2, 0)
+    ->ArgPair(2, 1)
+    ->ArgPair(4, 0)
+    ->ArgPair(4, 1)
+    ->ArgPair(8, 0)
+    ->ArgPair(8, 1);
+
+}  // namespace
+}  // namespace xla
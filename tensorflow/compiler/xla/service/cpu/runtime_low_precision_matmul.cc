@@ -0,0 +1,108 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/cpu/runtime_low_precision_matmul.h"
+
+#define EIGEN_USE_THREADS
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/compiler/xla/executable_run_options.h"
+#include "tensorflow/compiler/xla/service/cpu/runtime_lightweight_check.h"
+#include "tensorflow/compiler/xla/service/cpu/runtime_low_precision_matmul_impl.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/dynamic_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace {
+
+using tensorflow::xla::LowPrecisionParallelFor;
+
+bool UseAvx512Vnni() {
+  static const bool use_avx512_vnni = tensorflow::port::TestCPUFeature(
+      tensorflow::port::CPUFeature::AVX512_VNNI);
+  return use_avx512_vnni;
+}
+
+bool UseAvx512BF16() {
+  static const bool use_avx512_bf16 = tensorflow::port::TestCPUFeature(
+      tensorflow::port::CPUFeature::AVX512_BF16);
+  return use_avx512_bf16;
+}
+
+LowPrecisionParallelFor MultiThreadedParallelFor(const void* run_options_ptr) {
+  const xla::ExecutableRunOptions* run_options =
+      static_cast<const xla::ExecutableRunOptions*>(run_options_ptr);
+  XLA_LIGHTWEIGHT_CHECK(run_options->intra_op_thread_pool() != nullptr);
+  const Eigen::ThreadPoolDevice* device = run_options->intra_op_thread_pool();
+  return [device](tensorflow::int64 units, double cycles_per_unit,
+                  const std::function<void(tensorflow::int64,
+                                           tensorflow::int64)>& fn) {
+    device->parallelFor(
+        units, Eigen::TensorOpCost(0, 0, cycles_per_unit),
+        [&fn](Eigen::Index first, Eigen::Index last) { fn(first, last); });
+  };
+}
+
+LowPrecisionParallelFor SingleThreadedParallelFor() {
+  return [](tensorflow::int64 units, double /*cycles_per_unit*/,
+            const std::function<void(tensorflow::int64, tensorflow::int64)>&
+                fn) { fn(0, units); };
+}
+
+}  // namespace
+
+TF_ATTRIBUTE_NO_SANITIZE_MEMORY void __xla_cpu_runtime_LowPrecisionMatMulS8S32(
+    const void* run_options_ptr, tensorflow::int32* out, tensorflow::int8* lhs,
+    tensorflow::int8* rhs, tensorflow::int64 m, tensorflow::int64 n,
+    tensorflow::int64 k, tensorflow::int32 transpose_lhs,
+    tensorflow::int32 transpose_rhs) {
+  tensorflow::xla::LowPrecisionMatMulS8S32(
+      MultiThreadedParallelFor(run_options_ptr), UseAvx512Vnni(), out, lhs,
+      rhs, m, n, k, transpose_lhs, transpose_rhs);
+}
+
+TF_ATTRIBUTE_NO_SANITIZE_MEMORY void
+__xla_cpu_runtime_LowPrecisionMatMulBF16F32(
+    const void* run_options_ptr, float* out, tensorflow::uint16* lhs,
+    tensorflow::uint16* rhs, tensorflow::int64 m, tensorflow::int64 n,
+    tensorflow::int64 k, tensorflow::int32 transpose_lhs,
+    tensorflow::int32 transpose_rhs) {
+  tensorflow::xla::LowPrecisionMatMulBF16F32(
+      MultiThreadedParallelFor(run_options_ptr), UseAvx512BF16(), out, lhs,
+      rhs, m, n, k, transpose_lhs, transpose_rhs);
+}
+
+TF_ATTRIBUTE_NO_SANITIZE_MEMORY void
+__xla_cpu_runtime_SingleThreadedLowPrecisionMatMulS8S32(
+    const void* /*run_options_ptr*/, tensorflow::int32* out,
+    tensorflow::int8* lhs, tensorflow::int8* rhs, tensorflow::int64 m,
+    tensorflow::int64 n, tensorflow::int64 k, tensorflow::int32 transpose_lhs,
+    tensorflow::int32 transpose_rhs) {
+  tensorflow::xla::LowPrecisionMatMulS8S32(SingleThreadedParallelFor(),
+                                           UseAvx512Vnni(), out, lhs, rhs, m,
+                                           n, k, transpose_lhs, transpose_rhs);
+}
+
+TF_ATTRIBUTE_NO_SANITIZE_MEMORY void
+__xla_cpu_runtime_SingleThreadedLowPrecisionMatMulBF16F32(
+    const void* /*run_options_ptr*/, float* out, tensorflow::uint16* lhs,
+    tensorflow::uint16* rhs, tensorflow::int64 m, tensorflow::int64 n,
+    tensorflow::int64 k, tensorflow::int32 transpose_lhs,
+    tensorflow::int32 transpose_rhs) {
+  tensorflow::xla::LowPrecisionMatMulBF16F32(SingleThreadedParallelFor(),
+                                             UseAvx512BF16(), out, lhs, rhs, m,
+                                             n, k, transpose_lhs,
+                                             transpose_rhs);
+}
@@ -0,0 +1,368 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_CPU_RUNTIME_LOW_PRECISION_MATMUL_IMPL_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_CPU_RUNTIME_LOW_PRECISION_MATMUL_IMPL_H_
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#include "tensorflow/core/platform/types.h"
+
+// The AVX-512 kernels are compiled with function level target attributes, so
+// that the rest of the runtime doesn't need to be built for AVX-512.  They are
+// only selected at run time, on CPUs that support the extensions.
+#if defined(__x86_64__) && defined(__clang__) && __clang_major__ >= 9
+#define XLA_CPU_LOW_PRECISION_MATMUL_AVX512 1
+#elif defined(__x86_64__) && !defined(__clang__) && defined(__GNUC__) && \
+    __GNUC__ >= 10
+#define XLA_CPU_LOW_PRECISION_MATMUL_AVX512 1
+#endif
+
+#if defined(XLA_CPU_LOW_PRECISION_MATMUL_AVX512)
+#include <immintrin.h>
+#endif
+
+// 'tensorflow' namespace is used so that int64 and other types don't require
+// qualification.
+namespace tensorflow {
+namespace xla {
+
+// Runs 'fn(first, last)' over a partition of [0, units) into ranges; each unit
+// costs about 'cycles_per_unit'.
+using LowPrecisionParallelFor = std::function<void(
+    int64 units, double cycles_per_unit,
+    const std::function<void(int64, int64)>& fn)>;
+
+// True if the AVX-512 VNNI and BF16 kernels are compiled in.  Without them the
+// runtime only has portable kernels, which are slower than Eigen's GEMMs.
+#if defined(XLA_CPU_LOW_PRECISION_MATMUL_AVX512)
+constexpr bool kLowPrecisionMatMulHasAvx512Kernels = true;
+#else
+constexpr bool kLowPrecisionMatMulHasAvx512Kernels = false;
+#endif
+
+namespace low_precision_matmul {
+
+// Both operands are packed so that the contraction dimension is contiguous:
+// row i of the lhs and column j of the rhs each become a run of 'padded_k'
+// elements, zero padded to a whole number of 64 byte vectors.  Every output
+// element is then the dot product of two packed runs.
+constexpr int64 kVectorBytes = 64;
+
+// The output is computed in tiles of kTileRows x kTileCols elements, which
+// keeps kTileRows + kTileCols packed runs hot for kTileRows * kTileCols
+// accumulators.
+constexpr int64 kTileRows = 4;
+constexpr int64 kTileCols = 4;
+
+inline int64 PaddedK(int64 k, int64 element_bytes) {
+  const int64 elements_per_vector = kVectorBytes / element_bytes;
+  return (k + elements_per_vector - 1) / elements_per_vector *
+         elements_per_vector;
+}
+
+// Packs the 'rows' x 'k' matrix M into 'packed', where M(r, p) is at
+// 'data[r * row_stride + p * k_stride]'.  'convert' maps an element of M to
+// its packed representation.
+template <typename T, typename PackedT, typename Convert>
+void Pack(const T* data, int64 rows, int64 k, int64 row_stride, int64 k_stride,
+          int64 padded_k, Convert convert, std::vector<PackedT>* packed) {
+  packed->assign(rows * padded_k, PackedT(0));
+  for (int64 r = 0; r < rows; ++r) {
+    PackedT* run = packed->data() + r * padded_k;
+    for (int64 p = 0; p < k; ++p) {
+      run[p] = convert(data[r * row_stride + p * k_stride]);
+    }
+  }
+}
+
+inline float BF16ToFloat(uint16 bits) {
+  uint32 widened = static_cast<uint32>(bits) << 16;
+  float result;
+  std::memcpy(&result, &widened, sizeof(result));
+  return result;
+}
+
+// Portable kernels, used when the CPU has no dot product instructions.
+inline int32 DotS8(const int8* a, const int8* b, int64 padded_k) {
+  int32 sum = 0;
+  for (int64 p = 0; p < padded_k; ++p) {
+    sum += static_cast<int32>(a[p]) * static_cast<int32>(b[p]);
+  }
+  return sum;
+}
+
+inline float DotF32(const float* a, const float* b, int64 padded_k) {
+  float sum = 0.0f;
+  for (int64 p = 0; p < padded_k; ++p) {
+    sum += a[p] * b[p];
+  }
+  return sum;
+}
+
+#if defined(XLA_CPU_LOW_PRECISION_MATMUL_AVX512)
+
+// VPDPBUSD multiplies unsigned by signed bytes, so the lhs is packed biased by
+// 128 and the bias is removed with the column sums of the rhs:
+//   sum((a + 128) * b) - 128 * sum(b) = sum(a * b).
+template <int64 kRows, int64 kCols>
+__attribute__((target("avx512f,avx512bw,avx512vnni"))) inline void
+TileU8S8Avx512VnniImpl(const uint8* a, const int8* b, int64 padded_k,
+                       int32* dots) {
+  __m512i acc[kRows][kCols];
+  for (int64 r = 0; r < kRows; ++r) {
+    for (int64 c = 0; c < kCols; ++c) {
+      acc[r][c] = _mm512_setzero_si512();
+    }
+  }
+  for (int64 p = 0; p < padded_k; p += kVectorBytes) {
+    __m512i b_vec[kCols];
+    for (int64 c = 0; c < kCols; ++c) {
+      b_vec[c] = _mm512_loadu_si512(b + c * padded_k + p);
+    }
+    for (int64 r = 0; r < kRows; ++r) {
+      const __m512i a_vec = _mm512_loadu_si512(a + r * padded_k + p);
+      for (int64 c = 0; c < kCols; ++c) {
+        acc[r][c] = _mm512_dpbusd_epi32(acc[r][c], a_vec, b_vec[c]);
+      }
+    }
+  }
+  for (int64 r = 0; r < kRows; ++r) {
+    for (int64 c = 0; c < kCols; ++c) {
+      dots[r * kTileCols + c] = _mm512_reduce_add_epi32(acc[r][c]);
+    }
+  }
+}
+
+__attribute__((target("avx512f,avx512bw,avx512vnni"))) inline void
+TileU8S8Avx512Vnni(const uint8* a, int64 a_count, const int8* b, int64 b_count,
+                   int64 padded_k, int32* dots) {
+  if (a_count == kTileRows && b_count == kTileCols) {
+    TileU8S8Avx512VnniImpl<kTileRows, kTileCols>(a, b, padded_k, dots);
+    return;
+  }
+  for (int64 r = 0; r < a_count; ++r) {
+    for (int64 c = 0; c < b_count; ++c) {
+      TileU8S8Avx512VnniImpl<1, 1>(a + r * padded_k, b + c * padded_k,
+                                   padded_k, dots + r * kTileCols + c);
+    }
+  }
+}
+
+// VDPBF16PS multiplies pairs of bfloat16 values and accumulates in float.
+template <int64 kRows, int64 kCols>
+__attribute__((target("avx512f,avx512bw,avx512bf16"))) inline void
+TileBF16Avx512Impl(const uint16* a, const uint16* b, int64 padded_k,
+                   float* dots) {
+  __m512 acc[kRows][kCols];
+  for (int64 r = 0; r < kRows; ++r) {
+    for (int64 c = 0; c < kCols; ++c) {
+      acc[r][c] = _mm512_setzero_ps();
+    }
+  }
+  for (int64 p = 0; p < padded_k; p += kVectorBytes / sizeof(uint16)) {
+    __m512bh b_vec[kCols];
+    for (int64 c = 0; c < kCols; ++c) {
+      b_vec[c] = (__m512bh)_mm512_loadu_si512(b + c * padded_k + p);
+    }
+    for (int64 r = 0; r < kRows; ++r) {
+      const __m512bh a_vec =
+          (__m512bh)_mm512_loadu_si512(a + r * padded_k + p);
+      for (int64 c = 0; c < kCols; ++c) {
+        acc[r][c] = _mm512_dpbf16_ps(acc[r][c], a_vec, b_vec[c]);
+      }
+    }
+  }
+  for (int64 r = 0; r < kRows; ++r) {
+    for (int64 c = 0; c < kCols; ++c) {
+      dots[r * kTileCols + c] = _mm512_reduce_add_ps(acc[r][c]);
+    }
+  }
+}
+
+__attribute__((target("avx512f,avx512bw,avx512bf16"))) inline void
+TileBF16Avx512(const uint16* a, int64 a_count, const uint16* b, int64 b_count,
+               int64 padded_k, float* dots) {
+  if (a_count == kTileRows && b_count == kTileCols) {
+    TileBF16Avx512Impl<kTileRows, kTileCols>(a, b, padded_k, dots);
+    return;
+  }
+  for (int64 r = 0; r < a_count; ++r) {
+    for (int64 c = 0; c < b_count; ++c) {
+      TileBF16Avx512Impl<1, 1>(a + r * padded_k, b + c * padded_k, padded_k,
+                               dots + r * kTileCols + c);
+    }
+  }
+}
+
+#endif  // XLA_CPU_LOW_PRECISION_MATMUL_AVX512
+
+// Computes every tile of the m x n column major output, with the columns
+// split between the calls of 'parallel_for'.  'tile(i, rows, j, cols, dots)'
+// computes the dot products of 'rows' packed lhs runs starting at 'i' with
+// 'cols' packed rhs runs starting at 'j'.
+template <typename OutT, typename Tile>
+void ForEachTile(const LowPrecisionParallelFor& parallel_for, OutT* out,
+                 int64 m, int64 n, int64 padded_k, const Tile& tile) {
+  const int64 col_tiles = (n + kTileCols - 1) / kTileCols;
+  const double cycles_per_col_tile =
+      static_cast<double>(m) * kTileCols * padded_k / 16;
+  parallel_for(col_tiles, cycles_per_col_tile, [&](int64 first, int64 last) {
+    OutT dots[kTileRows * kTileCols];
+    for (int64 j = first * kTileCols; j < std::min(n, last * kTileCols);
+         j += kTileCols) {
+      const int64 cols = std::min(kTileCols, n - j);
+      for (int64 i = 0; i < m; i += kTileRows) {
+        const int64 rows = std::min(kTileRows, m - i);
+        tile(i, rows, j, cols, dots);
+        for (int64 c = 0; c < cols; ++c) {
+          for (int64 r = 0; r < rows; ++r) {
+            out[(j + c) * m + i + r] = dots[r * kTileCols + c];
+          }
+        }
+      }
+    }
+  });
+}
+
+}  // namespace low_precision_matmul
+
+// Computes the m x n matrix 'out' = 'lhs' * 'rhs' for an m x k 'lhs' and a
+// k x n 'rhs', all in column major order, like the Eigen matmul runtime.  If
+// 'transpose_lhs' ('transpose_rhs') is set, the buffer holds the transpose of
+// the operand instead.  Products are accumulated in 32-bit integers, which
+// can't overflow for 'k' up to kMaxLowPrecisionGemmS8ContractionSize (see
+// ir_emission_utils.h); the compiler doesn't call this for larger 'k'.
+inline void LowPrecisionMatMulS8S32(const LowPrecisionParallelFor& parallel_for,
+                                    bool use_avx512_vnni, int32* out,
+                                    const int8* lhs, const int8* rhs, int64 m,
+                                    int64 n, int64 k, bool transpose_lhs,
+                                    bool transpose_rhs) {
+  namespace lpm = low_precision_matmul;
+  const int64 padded_k = lpm::PaddedK(k, sizeof(int8));
+  const int64 lhs_row_stride = transpose_lhs ? k : 1;
+  const int64 lhs_k_stride = transpose_lhs ? 1 : m;
+  const int64 rhs_col_stride = transpose_rhs ? 1 : k;
+  const int64 rhs_k_stride = transpose_rhs ? n : 1;
+
+  std::vector<int8> packed_rhs;
+  lpm::Pack(rhs, n, k, rhs_col_stride, rhs_k_stride, padded_k,
+            [](int8 v) { return v; }, &packed_rhs);
+
+#if defined(XLA_CPU_LOW_PRECISION_MATMUL_AVX512)
+  if (use_avx512_vnni) {
+    std::vector<uint8> packed_lhs;
+    lpm::Pack(lhs, m, k, lhs_row_stride, lhs_k_stride, padded_k,
+              [](int8 v) { return static_cast<uint8>(v ^ 0x80); },
+              &packed_lhs);
+    std::vector<int32> bias(n);
+    for (int64 j = 0; j < n; ++j) {
+      int32 column_sum = 0;
+      for (int64 p = 0; p < k; ++p) {
+        column_sum += packed_rhs[j * padded_k + p];
+      }
+      bias[j] = 128 * column_sum;
+    }
+    lpm::ForEachTile(
+        parallel_for, out, m, n, padded_k,
+        [&](int64 i, int64 rows, int64 j, int64 cols, int32* dots) {
+          lpm::TileU8S8Avx512Vnni(packed_lhs.data() + i * padded_k, rows,
+                                  packed_rhs.data() + j * padded_k, cols,
+                                  padded_k, dots);
+          for (int64 r = 0; r < rows; ++r) {
+            for (int64 c = 0; c < cols; ++c) {
+              dots[r * lpm::kTileCols + c] -= bias[j + c];
+            }
+          }
+        });
+    return;
+  }
+#endif  // XLA_CPU_LOW_PRECISION_MATMUL_AVX512
+
+  std::vector<int8> packed_lhs;
+  lpm::Pack(lhs, m, k, lhs_row_stride, lhs_k_stride, padded_k,
+            [](int8 v) { return v; }, &packed_lhs);
+  lpm::ForEachTile(
+      parallel_for, out, m, n, padded_k,
+      [&](int64 i, int64 rows, int64 j, int64 cols, int32* dots) {
+        for (int64 r = 0; r < rows; ++r) {
+          for (int64 c = 0; c < cols; ++c) {
+            dots[r * lpm::kTileCols + c] =
+                lpm::DotS8(packed_lhs.data() + (i + r) * padded_k,
+                           packed_rhs.data() + (j + c) * padded_k, padded_k);
+          }
+        }
+      });
+}
+
+// Like LowPrecisionMatMulS8S32, for bfloat16 operands (given as their raw
+// bits) and a float output.  Products are accumulated in float.
+inline void LowPrecisionMatMulBF16F32(
+    const LowPrecisionParallelFor& parallel_for, bool use_avx512_bf16,
+    float* out, const uint16* lhs, const uint16* rhs, int64 m, int64 n, int64 k,
+    bool transpose_lhs, bool transpose_rhs) {
+  namespace lpm = low_precision_matmul;
+  const int64 padded_k = lpm::PaddedK(k, sizeof(uint16));
+  const int64 lhs_row_stride = transpose_lhs ? k : 1;
+  const int64 lhs_k_stride = transpose_lhs ? 1 : m;
+  const int64 rhs_col_stride = transpose_rhs ? 1 : k;
+  const int64 rhs_k_stride = transpose_rhs ? n : 1;
+
+#if defined(XLA_CPU_LOW_PRECISION_MATMUL_AVX512)
+  if (use_avx512_bf16) {
+    std::vector<uint16> packed_lhs;
+    std::vector<uint16> packed_rhs;
+    lpm::Pack(lhs, m, k, lhs_row_stride, lhs_k_stride, padded_k,
+              [](uint16 v) { return v; }, &packed_lhs);
+    lpm::Pack(rhs, n, k, rhs_col_stride, rhs_k_stride, padded_k,
+              [](uint16 v) { return v; }, &packed_rhs);
+    lpm::ForEachTile(
+        parallel_for, out, m, n, padded_k,
+        [&](int64 i, int64 rows, int64 j, int64 cols, float* dots) {
+          lpm::TileBF16Avx512(packed_lhs.data() + i * padded_k, rows,
+                              packed_rhs.data() + j * padded_k, cols, padded_k,
+                              dots);
+        });
+    return;
+  }
+#endif  // XLA_CPU_LOW_PRECISION_MATMUL_AVX512
+
+  // Without bfloat16 dot products the operands are widened while packing,
+  // which is still cheaper than widening them in memory before the dot.
+  std::vector<float> packed_lhs;
+  std::vector<float> packed_rhs;
+  lpm::Pack(lhs, m, k, lhs_row_stride, lhs_k_stride, padded_k,
+            lpm::BF16ToFloat, &packed_lhs);
+  lpm::Pack(rhs, n, k, rhs_col_stride, rhs_k_stride, padded_k,
+            lpm::BF16ToFloat, &packed_rhs);
+  lpm::ForEachTile(
+      parallel_for, out, m, n, padded_k,
+      [&](int64 i, int64 rows, int64 j, int64 cols, float* dots) {
+        for (int64 r = 0; r < rows; ++r) {
+          for (int64 c = 0; c < cols; ++c) {
+            dots[r * lpm::kTileCols + c] =
+                lpm::DotF32(packed_lhs.data() + (i + r) * padded_k,
+                            packed_rhs.data() + (j + c) * padded_k, padded_k);
+          }
+        }
+      });
+}
+
+}  // namespace xla
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_CPU_RUNTIME_LOW_PRECISION_MATMUL_IMPL_H_
@@ -0,0 +1,149 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "tensorflow/compiler/xla/service/cpu/runtime_low_precision_matmul_impl.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace xla {
+namespace {
+
+// Splits the work in two, to exercise partial column ranges.
+void TwoWayParallelFor(int64 units, double /*cycles_per_unit*/,
+                       const std::function<void(int64, int64)>& fn) {
+  fn(0, units / 2);
+  fn(units / 2, units);
+}
+
+struct MatMulDims {
+  int64 m;
+  int64 n;
+  int64 k;
+  bool transpose_lhs;
+  bool transpose_rhs;
+};
+
+// Odd sizes cover partial tiles and partial vectors of the packed runs.
+std::vector<MatMulDims> TestDims() {
+  std::vector<MatMulDims> dims;
+  for (int64 m : {1, 3, 4, 17}) {
+    for (int64 n : {1, 5, 8, 13}) {
+      for (int64 k : {1, 31, 64, 100, 257}) {
+        for (bool transpose_lhs : {false, true}) {
+          for (bool transpose_rhs : {false, true}) {
+            dims.push_back({m, n, k, transpose_lhs, transpose_rhs});
+          }
+        }
+      }
+    }
+  }
+  return dims;
+}
+
+// Returns element (r, c) of a rows x cols operand stored in column-major
+// order, or stored transposed.
+template <typename T>
+T Element(const std::vector<T>& data, int64 rows, int64 cols, bool transposed,
+          int64 r, int64 c) {
+  return transposed ? data[c + r * cols] : data[r + c * rows];
+}
+
+uint16 FloatToBF16(float value) {
+  uint32 bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return static_cast<uint16>(bits >> 16);
+}
+
+// The parameter selects the AVX-512 kernels instead of the portable ones.
+using LowPrecisionMatMulTest = ::testing::TestWithParam<bool>;
+
+TEST_P(LowPrecisionMatMulTest, S8S32) {
+  const bool use_avx512_vnni = GetParam();
+  if (use_avx512_vnni && !port::TestCPUFeature(port::CPUFeature::AVX512_VNNI)) {
+    GTEST_SKIP() << "AVX-512 VNNI is not supported";
+  }
+  std::mt19937 rng(1);
+  std::uniform_int_distribution<int> dist(-128, 127);
+  for (const MatMulDims& d : TestDims()) {
+    std::vector<int8> lhs(d.m * d.k);
+    std::vector<int8> rhs(d.k * d.n);
+    for (int8& v : lhs) v = dist(rng);
+    for (int8& v : rhs) v = dist(rng);
+    std::vector<int32> out(d.m * d.n);
+    LowPrecisionMatMulS8S32(TwoWayParallelFor, use_avx512_vnni, out.data(),
+                            lhs.data(), rhs.data(), d.m, d.n, d.k,
+                            d.transpose_lhs, d.transpose_rhs);
+    for (int64 i = 0; i < d.m; ++i) {
+      for (int64 j = 0; j < d.n; ++j) {
+        int32 expected = 0;
+        for (int64 p = 0; p < d.k; ++p) {
+          expected += Element(lhs, d.m, d.k, d.transpose_lhs, i, p) *
+                      Element(rhs, d.k, d.n, d.transpose_rhs, p, j);
+        }
+        ASSERT_EQ(out[i + j * d.m], expected)
+            << "m=" << d.m << " n=" << d.n << " k=" << d.k << " i=" << i
+            << " j=" << j;
+      }
+    }
+  }
+}
+
+TEST_P(LowPrecisionMatMulTest, BF16F32) {
+  const bool use_avx512_bf16 = GetParam();
+  if (use_avx512_bf16 && !port::TestCPUFeature(port::CPUFeature::AVX512_BF16)) {
+    GTEST_SKIP() << "AVX-512 BF16 is not supported";
+  }
+  std::mt19937 rng(1);
+  // Values with few significant bits, so that the products and sums are exact
+  // whatever the order of accumulation.
+  std::uniform_int_distribution<int> dist(-64, 64);
+  for (const MatMulDims& d : TestDims()) {
+    std::vector<uint16> lhs(d.m * d.k);
+    std::vector<uint16> rhs(d.k * d.n);
+    for (uint16& v : lhs) v = FloatToBF16(dist(rng) / 16.0f);
+    for (uint16& v : rhs) v = FloatToBF16(dist(rng) / 16.0f);
+    std::vector<float> out(d.m * d.n);
+    LowPrecisionMatMulBF16F32(TwoWayParallelFor, use_avx512_bf16, out.data(),
+                              lhs.data(), rhs.data(), d.m, d.n, d.k,
+                              d.transpose_lhs, d.transpose_rhs);
+    for (int64 i = 0; i < d.m; ++i) {
+      for (int64 j = 0; j < d.n; ++j) {
+        float expected = 0.0f;
+        for (int64 p = 0; p < d.k; ++p) {
+          expected += low_precision_matmul::BF16ToFloat(
+                          Element(lhs, d.m, d.k, d.transpose_lhs, i, p)) *
+                      low_precision_matmul::BF16ToFloat(
+                          Element(rhs, d.k, d.n, d.transpose_rhs, p, j));
+        }
+        ASSERT_EQ(out[i + j * d.m], expected)
+            << "m=" << d.m << " n=" << d.n << " k=" << d.k << " i=" << i
+            << " j=" << j;
+      }
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(PortableAndAvx512, LowPrecisionMatMulTest,
+                         ::testing::Bool());
+
+}  // namespace
+}  // namespace xla
+}  // namespace tensorflow
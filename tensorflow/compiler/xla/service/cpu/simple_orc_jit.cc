@@ -38,6 +38,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/cpu/runtime_fork_join.h"
 #include "tensorflow/compiler/xla/service/cpu/runtime_fp16.h"
 #include "tensorflow/compiler/xla/service/cpu/runtime_key_value_sort.h"
+#include "tensorflow/compiler/xla/service/cpu/runtime_low_precision_matmul.h"
 #include "tensorflow/compiler/xla/service/cpu/runtime_matmul.h"
 #include "tensorflow/compiler/xla/service/cpu/runtime_matmul_mkl.h"
 #include "tensorflow/compiler/xla/service/cpu/runtime_pow.h"
@@ -181,6 +182,14 @@ SimpleOrcJIT::VModuleKeyT SimpleOrcJIT::AddModule(
   return key;
 }
 
+SimpleOrcJIT::VModuleKeyT SimpleOrcJIT::AddObjectFile(
+    std::unique_ptr<llvm::MemoryBuffer> object) {
+  auto key = execution_session_.allocateVModule();
+  cantFail(object_layer_.addObject(key, std::move(object)));
+  module_keys_.push_back(key);
+  return key;
+}
+
 void SimpleOrcJIT::RemoveModule(SimpleOrcJIT::VModuleKeyT key) {
   module_keys_.erase(std::remove(module_keys_.begin(), module_keys_.end(), key),
                      module_keys_.end());
@@ -253,6 +262,8 @@ bool RegisterKnownJITSymbols() {
   REGISTER_CPU_RUNTIME_SYMBOL(EigenMatMulC64);
   REGISTER_CPU_RUNTIME_SYMBOL(EigenMatMulC128);
   REGISTER_CPU_RUNTIME_SYMBOL(EigenMatMulS32);
+  REGISTER_CPU_RUNTIME_SYMBOL(LowPrecisionMatMulS8S32);
+  REGISTER_CPU_RUNTIME_SYMBOL(LowPrecisionMatMulBF16F32);
   REGISTER_CPU_RUNTIME_SYMBOL(MKLMatMulF32);
   REGISTER_CPU_RUNTIME_SYMBOL(MKLMatMulF64);
   REGISTER_CPU_RUNTIME_SYMBOL(MKLSingleThreadedMatMulF32);
@@ -266,7 +277,10 @@ bool RegisterKnownJITSymbols() {
   REGISTER_CPU_RUNTIME_SYMBOL(EigenSingleThreadedMatMulC64);
   REGISTER_CPU_RUNTIME_SYMBOL(EigenSingleThreadedMatMulC128);
   REGISTER_CPU_RUNTIME_SYMBOL(EigenSingleThreadedMatMulS32);
+  REGISTER_CPU_RUNTIME_SYMBOL(SingleThreadedLowPrecisionMatMulS8S32);
+  REGISTER_CPU_RUNTIME_SYMBOL(SingleThreadedLowPrecisionMatMulBF16F32);
   REGISTER_CPU_RUNTIME_SYMBOL(ParallelForkJoin);
+  REGISTER_CPU_RUNTIME_SYMBOL(ParallelForkJoinPersistentTeam);
   REGISTER_CPU_RUNTIME_SYMBOL(ReleaseInfeedBufferAfterDequeue);
   REGISTER_CPU_RUNTIME_SYMBOL(ReleaseOutfeedBufferAfterPopulation);
   REGISTER_CPU_RUNTIME_SYMBOL(KeyValueSort);
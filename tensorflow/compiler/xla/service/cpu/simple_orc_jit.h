@@ -27,6 +27,7 @@ limitations under the License.
 #include "llvm/ExecutionEngine/Orc/RTDyldObjectLinkingLayer.h"
 #include "llvm/ExecutionEngine/Orc/SymbolStringPool.h"
 #include "llvm/IR/Module.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Target/TargetMachine.h"
 #include "tensorflow/compiler/xla/service/cpu/compiler_functor.h"
 #include "tensorflow/compiler/xla/types.h"
@@ -73,6 +74,11 @@ class SimpleOrcJIT {
   // remove this module.
   VModuleKeyT AddModule(std::unique_ptr<llvm::Module> module);
 
+  // Add an object file previously produced by this JIT's compiler (e.g. one
+  // captured by post_codegen_hook) without compiling anything. Returns an
+  // opaque key that can be used to later remove this object.
+  VModuleKeyT AddObjectFile(std::unique_ptr<llvm::MemoryBuffer> object);
+
   // Remove a module from the JIT and free the memory associated with it.
   void RemoveModule(VModuleKeyT key);
 
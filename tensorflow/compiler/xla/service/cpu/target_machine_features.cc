@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/cpu/target_machine_features.h"
 
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
 #include "tensorflow/compiler/xla/cpu_function_runtime.h"
 #include "tensorflow/core/platform/logging.h"
 
@@ -49,5 +51,20 @@ int64 LLVMTargetMachineFeatures::minimum_alignment_for_allocation(
                          cpu_function_runtime::kMinAlign);
 }
 
+bool LLVMTargetMachineFeatures::has_target_feature(
+    absl::string_view feature) const {
+  // The feature string lists every feature the target was created with as
+  // "+name" or "-name", separated by commas.
+  llvm::SmallVector<llvm::StringRef, 64> features;
+  target_machine_->getTargetFeatureString().split(features, ',');
+  for (llvm::StringRef target_feature : features) {
+    if (target_feature.consume_front("+") &&
+        target_feature == llvm::StringRef(feature.data(), feature.size())) {
+      return true;
+    }
+  }
+  return false;
+}
+
 }  // namespace cpu
 }  // namespace xla
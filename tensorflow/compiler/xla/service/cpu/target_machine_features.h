@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_COMPILER_XLA_SERVICE_CPU_TARGET_MACHINE_FEATURES_H_
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
 #include "llvm/Analysis/TargetTransformInfo.h"
 #include "llvm/Target/TargetMachine.h"
 #include "tensorflow/compiler/xla/primitive_util.h"
@@ -61,6 +62,10 @@ class TargetMachineFeatures {
   // Returns the minimum alignment for a buffer of size size_bytes.
   virtual int64 minimum_alignment_for_allocation(int64 size_bytes) const = 0;
 
+  // Returns true if the target supports the LLVM subtarget feature `feature`
+  // (for instance "avx512vnni").
+  virtual bool has_target_feature(absl::string_view feature) const = 0;
+
   virtual ~TargetMachineFeatures() = default;
 };
 
@@ -98,6 +103,8 @@ class LLVMTargetMachineFeatures : public TargetMachineFeatures {
 
   int64 minimum_alignment_for_allocation(int64 size_bytes) const override;
 
+  bool has_target_feature(absl::string_view feature) const override;
+
  private:
   llvm::TargetTransformInfo* GetTargetTransformInfoFor(
       const llvm::Function& function) const;
@@ -16,20 +16,27 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_XLA_SERVICE_CPU_TARGET_MACHINE_FEATURES_FAKE_H_
 #define TENSORFLOW_COMPILER_XLA_SERVICE_CPU_TARGET_MACHINE_FEATURES_FAKE_H_
 
+#include <string>
+#include <vector>
+
+#include "absl/algorithm/container.h"
 #include "tensorflow/compiler/xla/service/cpu/target_machine_features.h"
 
 namespace xla {
 namespace cpu {
 // Delegates calls to minimum_alignment_for_allocation to a user provided
-// std::function, crashes on all other methods.
+// std::function, reports the given target features, and crashes on all other
+// methods.
 //
 // Primarily useful for testing.
 class TargetMachineFeaturesWithFakeAlignmentLogic
     : public TargetMachineFeatures {
  public:
   explicit TargetMachineFeaturesWithFakeAlignmentLogic(
-      std::function<int64(int64)> fake_alignment_logic)
-      : fake_alignment_logic_(std::move(fake_alignment_logic)) {}
+      std::function<int64(int64)> fake_alignment_logic,
+      std::vector<std::string> target_features = {})
+      : fake_alignment_logic_(std::move(fake_alignment_logic)),
+        target_features_(std::move(target_features)) {}
 
   int vectorization_factor_in_bytes() const override {
     LOG(FATAL) << "Unexpected call to " << __func__;
@@ -52,8 +59,13 @@ class TargetMachineFeaturesWithFakeAlignmentLogic
     return fake_alignment_logic_(size_bytes);
   }
 
+  bool has_target_feature(absl::string_view feature) const override {
+    return absl::c_linear_search(target_features_, feature);
+  }
+
  private:
   std::function<int64(int64)> fake_alignment_logic_;
+  std::vector<std::string> target_features_;
 };
 }  // namespace cpu
 }  // namespace xla
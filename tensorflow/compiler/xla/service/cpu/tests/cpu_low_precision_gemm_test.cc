@@ -0,0 +1,284 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Tests that int8 and bfloat16 dots whose operands are widened by converts are
+// emitted as calls to the low precision GEMM runtime on CPUs with dot product
+// instructions, and compute the same result as the widened dot.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_replace.h"
+#include "tensorflow/compiler/xla/debug_options_flags.h"
+#include "tensorflow/compiler/xla/service/cpu/ir_emission_utils.h"
+#include "tensorflow/compiler/xla/service/cpu/runtime_low_precision_matmul_impl.h"
+#include "tensorflow/compiler/xla/service/cpu/tests/cpu_codegen_test.h"
+#include "tensorflow/compiler/xla/service/hlo_runner.h"
+#include "tensorflow/compiler/xla/service/platform_util.h"
+#include "tensorflow/compiler/xla/tests/test_utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+// A dot of int8 operands widened to int32, as a quantized matmul is written in
+// HLO.  $m, $n and $k are replaced by the dimensions of the product.
+const char* const kS8DotHlo = R"(
+HloModule S8Dot
+
+ENTRY main {
+  lhs = s8[$m,$k] parameter(0)
+  rhs = s8[$k,$n] parameter(1)
+  lhs_wide = s32[$m,$k] convert(lhs)
+  rhs_wide = s32[$k,$n] convert(rhs)
+  ROOT dot = s32[$m,$n] dot(lhs_wide, rhs_wide),
+    lhs_contracting_dims={1}, rhs_contracting_dims={0}
+}
+)";
+
+const char* const kBF16DotHlo = R"(
+HloModule BF16Dot
+
+ENTRY main {
+  lhs = bf16[$m,$k] parameter(0)
+  rhs = bf16[$k,$n] parameter(1)
+  lhs_wide = f32[$m,$k] convert(lhs)
+  rhs_wide = f32[$k,$n] convert(rhs)
+  ROOT dot = f32[$m,$n] dot(lhs_wide, rhs_wide),
+    lhs_contracting_dims={1}, rhs_contracting_dims={0}
+}
+)";
+
+// Both operands transposed: the lhs is k x m and the rhs n x k.
+const char* const kS8TransposedDotHlo = R"(
+HloModule S8TransposedDot
+
+ENTRY main {
+  lhs = s8[$k,$m] parameter(0)
+  rhs = s8[$n,$k] parameter(1)
+  lhs_wide = s32[$k,$m] convert(lhs)
+  rhs_wide = s32[$n,$k] convert(rhs)
+  ROOT dot = s32[$m,$n] dot(lhs_wide, rhs_wide),
+    lhs_contracting_dims={0}, rhs_contracting_dims={1}
+}
+)";
+
+string MakeDotHlo(const char* hlo_template, int64 m, int64 n, int64 k) {
+  return absl::StrReplaceAll(hlo_template, {{"$m", absl::StrCat(m)},
+                                            {"$n", absl::StrCat(n)},
+                                            {"$k", absl::StrCat(k)}});
+}
+
+// Returns true if the JIT target, the host, has the dot product instructions
+// that the low precision GEMM runtime uses for 'type' operands.  Otherwise the
+// compiler keeps Eigen's GEMM.
+bool HostHasLowPrecisionGemmKernel(PrimitiveType type) {
+  using tensorflow::port::CPUFeature;
+  using tensorflow::port::TestCPUFeature;
+  if (!::tensorflow::xla::kLowPrecisionMatMulHasAvx512Kernels ||
+      !TestCPUFeature(CPUFeature::AVX512F) ||
+      !TestCPUFeature(CPUFeature::AVX512BW)) {
+    return false;
+  }
+  return TestCPUFeature(type == S8 ? CPUFeature::AVX512_VNNI
+                                   : CPUFeature::AVX512_BF16);
+}
+
+const char* const kS8RuntimeCallPattern = R"(
+CHECK: call void @__xla_cpu_runtime_LowPrecisionMatMulS8S32
+)";
+
+const char* const kS8EigenCallPattern = R"(
+CHECK-NOT: LowPrecisionMatMul
+CHECK: call void @__xla_cpu_runtime_EigenMatMulS32
+)";
+
+const char* const kBF16RuntimeCallPattern = R"(
+CHECK: call void @__xla_cpu_runtime_LowPrecisionMatMulBF16F32
+)";
+
+// Float GEMMs may also go to MKL.
+const char* const kBF16EigenCallPattern = R"(
+CHECK-NOT: LowPrecisionMatMul
+CHECK: call void @__xla_cpu_runtime_{{.*}}MatMulF32
+)";
+
+void DisableLowPrecisionGemm(DebugOptions* debug_options) {
+  (*debug_options->mutable_xla_backend_extra_options())
+      ["xla_cpu_disable_low_precision_gemm"] = "";
+}
+
+class CpuLowPrecisionGemmTest : public CpuCodegenTest {
+ protected:
+  DebugOptions GetDebugOptionsForTest() override {
+    DebugOptions debug_options = CpuCodegenTest::GetDebugOptionsForTest();
+    if (disable_low_precision_gemm_) {
+      DisableLowPrecisionGemm(&debug_options);
+    }
+    return debug_options;
+  }
+
+  bool disable_low_precision_gemm_ = false;
+};
+
+TEST_F(CpuLowPrecisionGemmTest, S8DotCallsRuntimeOnlyWithVnni) {
+  CompileAndVerifyIr(MakeDotHlo(kS8DotHlo, 64, 48, 96),
+                     HostHasLowPrecisionGemmKernel(S8) ? kS8RuntimeCallPattern
+                                                       : kS8EigenCallPattern);
+}
+
+TEST_F(CpuLowPrecisionGemmTest, BF16DotCallsRuntimeOnlyWithBF16) {
+  CompileAndVerifyIr(MakeDotHlo(kBF16DotHlo, 64, 48, 96),
+                     HostHasLowPrecisionGemmKernel(BF16)
+                         ? kBF16RuntimeCallPattern
+                         : kBF16EigenCallPattern);
+}
+
+TEST_F(CpuLowPrecisionGemmTest, DisabledS8DotCallsEigen) {
+  disable_low_precision_gemm_ = true;
+  CompileAndVerifyIr(MakeDotHlo(kS8DotHlo, 64, 48, 96), kS8EigenCallPattern);
+}
+
+TEST_F(CpuLowPrecisionGemmTest, S8DotWithLongContractionCallsEigen) {
+  // The runtime's 32-bit accumulators could overflow.
+  CompileAndVerifyIr(
+      MakeDotHlo(kS8DotHlo, 64, 48, kMaxLowPrecisionGemmS8ContractionSize + 1),
+      kS8EigenCallPattern);
+  CompileAndVerifyIr(
+      MakeDotHlo(kS8DotHlo, 64, 48, kMaxLowPrecisionGemmS8ContractionSize),
+      HostHasLowPrecisionGemmKernel(S8) ? kS8RuntimeCallPattern
+                                        : kS8EigenCallPattern);
+}
+
+TEST_F(CpuLowPrecisionGemmTest, S8Dot) {
+  // Odd sizes leave partial tiles in every dimension.
+  EXPECT_TRUE(RunAndCompare(MakeDotHlo(kS8DotHlo, 37, 29, 133), ErrorSpec{0}));
+}
+
+TEST_F(CpuLowPrecisionGemmTest, S8TransposedDot) {
+  EXPECT_TRUE(RunAndCompare(MakeDotHlo(kS8TransposedDotHlo, 37, 29, 133),
+                            ErrorSpec{0}));
+}
+
+TEST_F(CpuLowPrecisionGemmTest, S8DotWithColumnMajorOperands) {
+  const char* const hlo_text = R"(
+HloModule S8DotColumnMajor
+
+ENTRY main {
+  lhs = s8[17,65]{0,1} parameter(0)
+  rhs = s8[65,9]{0,1} parameter(1)
+  lhs_wide = s32[17,65]{0,1} convert(lhs)
+  rhs_wide = s32[65,9]{0,1} convert(rhs)
+  ROOT dot = s32[17,9] dot(lhs_wide, rhs_wide),
+    lhs_contracting_dims={1}, rhs_contracting_dims={0}
+}
+)";
+  EXPECT_TRUE(RunAndCompare(hlo_text, ErrorSpec{0}));
+}
+
+TEST_F(CpuLowPrecisionGemmTest, S8DotWithElementwiseConsumer) {
+  // The bias add is not fused into the GEMM, which only takes the converts.
+  const char* const hlo_text = R"(
+HloModule S8DotBias
+
+ENTRY main {
+  lhs = s8[31,70] parameter(0)
+  rhs = s8[70,23] parameter(1)
+  bias = s32[31,23] parameter(2)
+  lhs_wide = s32[31,70] convert(lhs)
+  rhs_wide = s32[70,23] convert(rhs)
+  dot = s32[31,23] dot(lhs_wide, rhs_wide),
+    lhs_contracting_dims={1}, rhs_contracting_dims={0}
+  ROOT add = s32[31,23] add(dot, bias)
+}
+)";
+  EXPECT_TRUE(RunAndCompare(hlo_text, ErrorSpec{0}));
+}
+
+TEST_F(CpuLowPrecisionGemmTest, BF16Dot) {
+  // The runtime sums in a different order than the reference.
+  EXPECT_TRUE(RunAndCompare(MakeDotHlo(kBF16DotHlo, 37, 29, 133),
+                            ErrorSpec{1e-3, 1e-3}));
+}
+
+TEST_F(CpuLowPrecisionGemmTest, BF16DotWithoutLowPrecisionGemm) {
+  disable_low_precision_gemm_ = true;
+  EXPECT_TRUE(RunAndCompare(MakeDotHlo(kBF16DotHlo, 37, 29, 133),
+                            ErrorSpec{1e-3, 1e-3}));
+}
+
+// Measures a square dot of size 'size' with and without the low precision
+// GEMM runtime, and reports the multiply-adds as items.
+void RunHelper(int iters, const char* hlo_template, int64 size,
+               bool low_precision_gemm) {
+  tensorflow::testing::StopTiming();
+  HloRunner runner(PlatformUtil::GetDefaultPlatform().ValueOrDie());
+  DebugOptions debug_options = GetDebugOptionsFromFlags();
+  if (!low_precision_gemm) {
+    DisableLowPrecisionGemm(&debug_options);
+  }
+  std::unique_ptr<HloModule> module =
+      HloRunner::CreateModuleFromString(
+          MakeDotHlo(hlo_template, size, size, size), debug_options)
+          .ConsumeValueOrDie();
+  std::vector<Literal> arguments =
+      MakeFakeArguments(module.get()).ConsumeValueOrDie();
+  std::vector<ScopedShapedBuffer> buffers =
+      runner.TransferLiteralsToDevice(arguments).ConsumeValueOrDie();
+  std::unique_ptr<Executable> executable =
+      runner.CreateExecutable(std::move(module), /*run_hlo_passes=*/true)
+          .ConsumeValueOrDie();
+
+  // Warm up.
+  TF_CHECK_OK(
+      runner.ExecuteWithDeviceBuffers(executable.get(), buffers).status());
+  tensorflow::testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    TF_CHECK_OK(
+        runner.ExecuteWithDeviceBuffers(executable.get(), buffers).status());
+  }
+  tensorflow::testing::StopTiming();
+  tensorflow::testing::ItemsProcessed(static_cast<int64>(iters) * size * size *
+                                      size);
+}
+
+void BM_S8Dot(int iters, int size, int low_precision_gemm) {
+  RunHelper(iters, kS8DotHlo, size, low_precision_gemm);
+}
+
+void BM_BF16Dot(int iters, int size, int low_precision_gemm) {
+  RunHelper(iters, kBF16DotHlo, size, low_precision_gemm);
+}
+
+BENCHMARK(BM_S8Dot)
+    ->ArgPair(256, 0)
+    ->ArgPair(256, 1)
+    ->ArgPair(1024, 0)
+    ->ArgPair(1024, 1);
+BENCHMARK(BM_BF16Dot)
+    ->ArgPair(256, 0)
+    ->ArgPair(256, 1)
+    ->ArgPair(1024, 0)
+    ->ArgPair(1024, 1);
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
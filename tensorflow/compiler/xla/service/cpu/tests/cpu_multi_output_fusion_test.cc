@@ -0,0 +1,244 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/compiler/xla/debug_options_flags.h"
+#include "tensorflow/compiler/xla/service/cpu/tests/cpu_codegen_test.h"
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_runner.h"
+#include "tensorflow/compiler/xla/service/platform_util.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/tests/test_utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+// Layer normalization over the minor dimension.  The mean and the mean of
+// squares read 'x' once in a single multi-output fusion.
+const char* const kLayerNormHlo = R"(
+HloModule LayerNorm
+
+add {
+  lhs = f32[] parameter(0)
+  rhs = f32[] parameter(1)
+  ROOT add = f32[] add(lhs, rhs)
+}
+
+ENTRY main {
+  x = f32[1024,1024] parameter(0)
+  zero = f32[] constant(0)
+  sum = f32[1024] reduce(x, zero), dimensions={1}, to_apply=add
+  square = f32[1024,1024] multiply(x, x)
+  sum_of_squares = f32[1024] reduce(square, zero), dimensions={1},
+    to_apply=add
+  count = f32[] constant(1024)
+  count_broadcast = f32[1024] broadcast(count), dimensions={}
+  mean = f32[1024] divide(sum, count_broadcast)
+  mean_of_squares = f32[1024] divide(sum_of_squares, count_broadcast)
+  mean_squared = f32[1024] multiply(mean, mean)
+  variance = f32[1024] subtract(mean_of_squares, mean_squared)
+  epsilon = f32[] constant(1e-5)
+  epsilon_broadcast = f32[1024] broadcast(epsilon), dimensions={}
+  shifted_variance = f32[1024] add(variance, epsilon_broadcast)
+  scale = f32[1024] rsqrt(shifted_variance)
+  mean_broadcast = f32[1024,1024] broadcast(mean), dimensions={0}
+  centered = f32[1024,1024] subtract(x, mean_broadcast)
+  scale_broadcast = f32[1024,1024] broadcast(scale), dimensions={0}
+  ROOT normalized = f32[1024,1024] multiply(centered, scale_broadcast)
+}
+)";
+
+// Softmax over the minor dimension.  The exponentials are written and summed
+// in the same pass.
+const char* const kSoftmaxHlo = R"(
+HloModule Softmax
+
+add {
+  lhs = f32[] parameter(0)
+  rhs = f32[] parameter(1)
+  ROOT add = f32[] add(lhs, rhs)
+}
+
+max {
+  lhs = f32[] parameter(0)
+  rhs = f32[] parameter(1)
+  ROOT max = f32[] maximum(lhs, rhs)
+}
+
+ENTRY main {
+  x = f32[1024,1024] parameter(0)
+  lowest = f32[] constant(-inf)
+  row_max = f32[1024] reduce(x, lowest), dimensions={1}, to_apply=max
+  max_broadcast = f32[1024,1024] broadcast(row_max), dimensions={0}
+  shifted = f32[1024,1024] subtract(x, max_broadcast)
+  exp = f32[1024,1024] exponential(shifted)
+  zero = f32[] constant(0)
+  sum = f32[1024] reduce(exp, zero), dimensions={1}, to_apply=add
+  sum_broadcast = f32[1024,1024] broadcast(sum), dimensions={0}
+  ROOT softmax = f32[1024,1024] divide(exp, sum_broadcast)
+}
+)";
+
+void DisableMultiOutputFusion(DebugOptions* debug_options) {
+  (*debug_options->mutable_xla_backend_extra_options())
+      ["xla_cpu_disable_multi_output_fusion"] = "";
+}
+
+class CpuMultiOutputFusionTest : public CpuCodegenTest {
+ protected:
+  DebugOptions GetDebugOptionsForTest() override {
+    DebugOptions debug_options = CpuCodegenTest::GetDebugOptionsForTest();
+    if (disable_multi_output_fusion_) {
+      DisableMultiOutputFusion(&debug_options);
+    }
+    return debug_options;
+  }
+
+  bool disable_multi_output_fusion_ = false;
+};
+
+TEST_F(CpuMultiOutputFusionTest, LayerNorm) {
+  EXPECT_TRUE(RunAndCompare(kLayerNormHlo, ErrorSpec{1e-3, 1e-3}));
+}
+
+TEST_F(CpuMultiOutputFusionTest, LayerNormWithoutMultiOutputFusion) {
+  disable_multi_output_fusion_ = true;
+  EXPECT_TRUE(RunAndCompare(kLayerNormHlo, ErrorSpec{1e-3, 1e-3}));
+}
+
+TEST_F(CpuMultiOutputFusionTest, Softmax) {
+  EXPECT_TRUE(RunAndCompare(kSoftmaxHlo, ErrorSpec{1e-4, 1e-4}));
+}
+
+TEST_F(CpuMultiOutputFusionTest, SoftmaxWithoutMultiOutputFusion) {
+  disable_multi_output_fusion_ = true;
+  EXPECT_TRUE(RunAndCompare(kSoftmaxHlo, ErrorSpec{1e-4, 1e-4}));
+}
+
+TEST_F(CpuMultiOutputFusionTest, SiblingReductionAndElementwiseOutput) {
+  // A row reduction and an elementwise output of the reduced shape share a
+  // loop.
+  const char* const hlo_text = R"(
+HloModule ReductionAndElementwise
+
+add {
+  lhs = f32[] parameter(0)
+  rhs = f32[] parameter(1)
+  ROOT add = f32[] add(lhs, rhs)
+}
+
+ENTRY main {
+  x = f32[37,129] parameter(0)
+  zero = f32[] constant(0)
+  sum = f32[37] reduce(x, zero), dimensions={1}, to_apply=add
+  exp = f32[37,129] exponential(x)
+  ROOT tuple = (f32[37], f32[37,129]) tuple(sum, exp)
+}
+)";
+  EXPECT_TRUE(RunAndCompare(hlo_text, ErrorSpec{1e-4, 1e-4}));
+}
+
+// Returns an estimate of the bytes the entry computation of 'module' reads and
+// writes: the operands and outputs of each of its top-level instructions.
+int64 EntryMemoryTraffic(const HloModule& module) {
+  auto array_bytes = [](const Shape& shape) {
+    int64 bytes = 0;
+    ShapeUtil::ForEachSubshape(
+        shape, [&](const Shape& subshape, const ShapeIndex& /*index*/) {
+          if (subshape.IsArray()) {
+            bytes += ShapeUtil::ByteSizeOf(subshape);
+          }
+        });
+    return bytes;
+  };
+  int64 bytes = 0;
+  for (const HloInstruction* instr :
+       module.entry_computation()->instructions()) {
+    switch (instr->opcode()) {
+      case HloOpcode::kParameter:
+      case HloOpcode::kConstant:
+      case HloOpcode::kTuple:
+      case HloOpcode::kGetTupleElement:
+      case HloOpcode::kBitcast:
+        continue;
+      default:
+        break;
+    }
+    bytes += array_bytes(instr->shape());
+    for (const HloInstruction* operand : instr->operands()) {
+      if (operand->opcode() != HloOpcode::kConstant) {
+        bytes += array_bytes(operand->shape());
+      }
+    }
+  }
+  return bytes;
+}
+
+// Measures the run time of 'hlo_text' with and without multi-output fusion,
+// and labels it with the estimated memory traffic of the compiled module.
+void RunHelper(int iters, const char* hlo_text, bool multi_output_fusion) {
+  tensorflow::testing::StopTiming();
+  HloRunner runner(PlatformUtil::GetDefaultPlatform().ValueOrDie());
+  DebugOptions debug_options = GetDebugOptionsFromFlags();
+  if (!multi_output_fusion) {
+    DisableMultiOutputFusion(&debug_options);
+  }
+  std::unique_ptr<HloModule> module =
+      HloRunner::CreateModuleFromString(hlo_text, debug_options)
+          .ConsumeValueOrDie();
+  std::vector<Literal> arguments =
+      MakeFakeArguments(module.get()).ConsumeValueOrDie();
+  std::vector<ScopedShapedBuffer> buffers =
+      runner.TransferLiteralsToDevice(arguments).ConsumeValueOrDie();
+  std::unique_ptr<Executable> executable =
+      runner.CreateExecutable(std::move(module), /*run_hlo_passes=*/true)
+          .ConsumeValueOrDie();
+  const int64 traffic = EntryMemoryTraffic(executable->module());
+  tensorflow::testing::SetLabel(absl::StrCat(traffic >> 20, " MiB moved"));
+
+  // Warm up.
+  TF_CHECK_OK(
+      runner.ExecuteWithDeviceBuffers(executable.get(), buffers).status());
+  tensorflow::testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    TF_CHECK_OK(
+        runner.ExecuteWithDeviceBuffers(executable.get(), buffers).status());
+  }
+  tensorflow::testing::StopTiming();
+  tensorflow::testing::BytesProcessed(static_cast<int64>(iters) * traffic);
+}
+
+void BM_LayerNorm(int iters, int multi_output_fusion) {
+  RunHelper(iters, kLayerNormHlo, multi_output_fusion);
+}
+
+void BM_Softmax(int iters, int multi_output_fusion) {
+  RunHelper(iters, kSoftmaxHlo, multi_output_fusion);
+}
+
+BENCHMARK(BM_LayerNorm)->Arg(0)->Arg(1);
+BENCHMARK(BM_Softmax)->Arg(0)->Arg(1);
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
@@ -0,0 +1,166 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/compiler/xla/debug_options_flags.h"
+#include "tensorflow/compiler/xla/service/cpu/parallel_task_assignment.h"
+#include "tensorflow/compiler/xla/service/cpu/tests/cpu_codegen_test.h"
+#include "tensorflow/compiler/xla/service/hlo_runner.h"
+#include "tensorflow/compiler/xla/service/platform_util.h"
+#include "tensorflow/compiler/xla/tests/test_utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+// A cheap elementwise graph, fused into a single loop fusion.
+const char* const kLoopFusionHlo = R"(
+HloModule LoopFusion
+
+ENTRY main {
+  p0 = f32[512,1024] parameter(0)
+  p1 = f32[512,1024] parameter(1)
+  add = f32[512,1024] add(p0, p1)
+  ROOT multiply = f32[512,1024] multiply(add, p1)
+}
+)";
+
+// A large row reduction of a transcendental, fused into the reduce.
+const char* const kReduceHlo = R"(
+HloModule Reduce
+
+add {
+  lhs = f32[] parameter(0)
+  rhs = f32[] parameter(1)
+  ROOT add = f32[] add(lhs, rhs)
+}
+
+ENTRY main {
+  p0 = f32[4096,1024] parameter(0)
+  exp = f32[4096,1024] exponential(p0)
+  zero = f32[] constant(0)
+  ROOT reduce = f32[4096] reduce(exp, zero), dimensions={1}, to_apply=add
+}
+)";
+
+// Runs 'hlo_text' once with HLO profiling and returns the path of the
+// resulting HloExecutionProfileData.
+std::string ProfileModule(HloRunner* runner, const char* hlo_text) {
+  tensorflow::Env* env = tensorflow::Env::Default();
+  std::string dump_dir =
+      tensorflow::io::JoinPath(tensorflow::testing::TmpDir(), "profile");
+  CHECK(env->CreateUniqueFileName(&dump_dir, ""));
+  TF_CHECK_OK(env->RecursivelyCreateDir(dump_dir));
+
+  DebugOptions debug_options = GetDebugOptionsFromFlags();
+  debug_options.set_xla_hlo_profile(true);
+  debug_options.set_xla_dump_to(dump_dir);
+  std::unique_ptr<HloModule> module =
+      HloRunner::CreateModuleFromString(hlo_text, debug_options)
+          .ConsumeValueOrDie();
+  std::vector<Literal> arguments =
+      MakeFakeArguments(module.get()).ConsumeValueOrDie();
+  TF_CHECK_OK(runner->Execute(std::move(module), arguments).status());
+  return tensorflow::io::JoinPath(dump_dir, "hlo_execution_profile_data");
+}
+
+class CpuParallelTaskProfileTest : public CpuCodegenTest {
+ protected:
+  DebugOptions GetDebugOptionsForTest() override {
+    DebugOptions debug_options = CpuCodegenTest::GetDebugOptionsForTest();
+    debug_options.set_xla_cpu_parallel_task_profile(profile_path_);
+    return debug_options;
+  }
+
+  std::string profile_path_;
+};
+
+TEST_F(CpuParallelTaskProfileTest, ProfileCoversEntryInstructions) {
+  profile_path_ = ProfileModule(&test_runner_, kReduceHlo);
+  TF_ASSERT_OK_AND_ASSIGN(ParallelTaskProfile profile,
+                          ParallelTaskProfile::Load(profile_path_));
+  EXPECT_GT(profile.size(), 0);
+}
+
+TEST_F(CpuParallelTaskProfileTest, ProfileGuidedLoopFusionIsCorrect) {
+  profile_path_ = ProfileModule(&test_runner_, kLoopFusionHlo);
+  EXPECT_TRUE(RunAndCompare(kLoopFusionHlo, ErrorSpec{1e-5, 1e-5}));
+}
+
+TEST_F(CpuParallelTaskProfileTest, ProfileGuidedReduceIsCorrect) {
+  profile_path_ = ProfileModule(&test_runner_, kReduceHlo);
+  EXPECT_TRUE(RunAndCompare(kReduceHlo, ErrorSpec{1e-3, 1e-3}));
+}
+
+TEST_F(CpuParallelTaskProfileTest, MissingProfileFallsBack) {
+  profile_path_ = tensorflow::io::JoinPath(tensorflow::testing::TmpDir(),
+                                           "no_such_profile");
+  EXPECT_TRUE(RunAndCompare(kLoopFusionHlo, ErrorSpec{1e-5, 1e-5}));
+}
+
+// Measures the run time of 'hlo_text' with the task counts chosen by the
+// default cost model, or by one profiled run of the module.
+void RunHelper(int iters, const char* hlo_text, bool profile_guided) {
+  tensorflow::testing::StopTiming();
+  HloRunner runner(PlatformUtil::GetDefaultPlatform().ValueOrDie());
+  DebugOptions debug_options = GetDebugOptionsFromFlags();
+  if (profile_guided) {
+    debug_options.set_xla_cpu_parallel_task_profile(
+        ProfileModule(&runner, hlo_text));
+  }
+  std::unique_ptr<HloModule> module =
+      HloRunner::CreateModuleFromString(hlo_text, debug_options)
+          .ConsumeValueOrDie();
+  std::vector<Literal> arguments =
+      MakeFakeArguments(module.get()).ConsumeValueOrDie();
+  std::vector<ScopedShapedBuffer> buffers =
+      runner.TransferLiteralsToDevice(arguments).ConsumeValueOrDie();
+  std::unique_ptr<Executable> executable =
+      runner.CreateExecutable(std::move(module), /*run_hlo_passes=*/true)
+          .ConsumeValueOrDie();
+
+  // Warm up.
+  TF_CHECK_OK(
+      runner.ExecuteWithDeviceBuffers(executable.get(), buffers).status());
+  tensorflow::testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    TF_CHECK_OK(
+        runner.ExecuteWithDeviceBuffers(executable.get(), buffers).status());
+  }
+  tensorflow::testing::StopTiming();
+}
+
+void BM_LoopFusion(int iters, int profile_guided) {
+  RunHelper(iters, kLoopFusionHlo, profile_guided);
+}
+
+void BM_Reduce(int iters, int profile_guided) {
+  RunHelper(iters, kReduceHlo, profile_guided);
+}
+
+BENCHMARK(BM_LoopFusion)->Arg(0)->Arg(1);
+BENCHMARK(BM_Reduce)->Arg(0)->Arg(1);
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
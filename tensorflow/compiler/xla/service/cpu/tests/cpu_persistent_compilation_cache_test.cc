@@ -0,0 +1,206 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "llvm/Support/TargetSelect.h"
+#include "tensorflow/compiler/xla/debug_options_flags.h"
+#include "tensorflow/compiler/xla/service/backend.h"
+#include "tensorflow/compiler/xla/service/cpu/persistent_compilation_cache.h"
+#include "tensorflow/compiler/xla/service/cpu/simple_orc_jit.h"
+#include "tensorflow/compiler/xla/service/cpu/tests/cpu_codegen_test.h"
+#include "tensorflow/compiler/xla/service/hlo_parser.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+const char* const kHloText = R"(
+HloModule PersistentCache
+
+ENTRY main {
+  lhs = f32[64,64] parameter(0)
+  rhs = f32[64,64] parameter(1)
+  dot = f32[64,64] dot(lhs, rhs), lhs_contracting_dims={1}, rhs_contracting_dims={0}
+  exp = f32[64,64] exponential(dot)
+  ROOT add = f32[64,64] add(exp, lhs)
+}
+)";
+
+// Returns a fresh, empty directory for a cache.
+std::string NewCacheDirectory() {
+  tensorflow::Env* env = tensorflow::Env::Default();
+  std::string directory =
+      tensorflow::io::JoinPath(tensorflow::testing::TmpDir(), "xla_cache");
+  CHECK(env->CreateUniqueFileName(&directory, ""));
+  TF_CHECK_OK(env->RecursivelyCreateDir(directory));
+  return directory;
+}
+
+int CountCacheEntries(const std::string& directory) {
+  std::vector<std::string> children;
+  TF_CHECK_OK(tensorflow::Env::Default()->GetChildren(directory, &children));
+  int num_entries = 0;
+  for (const std::string& child : children) {
+    num_entries += absl::EndsWith(child, ".pb");
+  }
+  return num_entries;
+}
+
+class CpuPersistentCompilationCacheTest : public CpuCodegenTest {
+ protected:
+  void SetUp() override {
+    CpuCodegenTest::SetUp();
+    cache_directory_ = NewCacheDirectory();
+  }
+
+  DebugOptions GetDebugOptionsForTest() override {
+    DebugOptions debug_options = CpuCodegenTest::GetDebugOptionsForTest();
+    debug_options.set_xla_cpu_persistent_cache_dir(cache_directory_);
+    return debug_options;
+  }
+
+  std::string cache_directory_;
+};
+
+TEST_F(CpuPersistentCompilationCacheTest, LookupAndInsert) {
+  PersistentCompilationCache cache(cache_directory_);
+  EXPECT_FALSE(cache.Lookup("0123").has_value());
+
+  PersistentCompilationCacheEntry entry;
+  entry.set_object_code("object code");
+  entry.set_entry_function_name("entry");
+  TF_ASSERT_OK(cache.Insert("0123", entry));
+
+  absl::optional<PersistentCompilationCacheEntry> cached = cache.Lookup("0123");
+  ASSERT_TRUE(cached.has_value());
+  EXPECT_EQ("object code", cached->object_code());
+  EXPECT_EQ("entry", cached->entry_function_name());
+  EXPECT_FALSE(cache.Lookup("4567").has_value());
+}
+
+TEST_F(CpuPersistentCompilationCacheTest, CorruptEntryIsAMiss) {
+  PersistentCompilationCache cache(cache_directory_);
+  TF_ASSERT_OK(tensorflow::WriteStringToFile(
+      tensorflow::Env::Default(),
+      tensorflow::io::JoinPath(cache_directory_, "0123.pb"), "not a proto"));
+  EXPECT_FALSE(cache.Lookup("0123").has_value());
+}
+
+TEST_F(CpuPersistentCompilationCacheTest, KeyDependsOnModuleAndStage) {
+  llvm::InitializeNativeTarget();
+  std::unique_ptr<llvm::TargetMachine> target_machine =
+      SimpleOrcJIT::InferTargetMachineForJIT(llvm::TargetOptions(),
+                                             llvm::CodeGenOpt::Default);
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kHloText));
+  TF_ASSERT_OK_AND_ASSIGN(auto same_module,
+                          ParseAndReturnVerifiedModule(kHloText));
+  std::string other_text(kHloText);
+  other_text.replace(other_text.find("exponential"), strlen("exponential"),
+                     "tanh");
+  TF_ASSERT_OK_AND_ASSIGN(auto other_module,
+                          ParseAndReturnVerifiedModule(other_text));
+
+  const std::string key =
+      PersistentCompilationCache::Key(*module, *target_machine, "hlo");
+  EXPECT_EQ(key, PersistentCompilationCache::Key(*same_module, *target_machine,
+                                                 "hlo"));
+  EXPECT_NE(key, PersistentCompilationCache::Key(*other_module,
+                                                 *target_machine, "hlo"));
+  EXPECT_NE(key,
+            PersistentCompilationCache::Key(*module, *target_machine, "backend"));
+}
+
+TEST_F(CpuPersistentCompilationCacheTest, WarmCompilationReusesEntries) {
+  EXPECT_TRUE(RunAndCompare(kHloText, ErrorSpec{1e-3, 1e-3}));
+  // One entry for the HLO passes and one for the backend.
+  EXPECT_EQ(2, CountCacheEntries(cache_directory_));
+
+  // The second compilation is served from the cache and must still compute
+  // the right result.
+  EXPECT_TRUE(RunAndCompare(kHloText, ErrorSpec{1e-3, 1e-3}));
+  EXPECT_EQ(2, CountCacheEntries(cache_directory_));
+}
+
+TEST_F(CpuPersistentCompilationCacheTest, SeededModulesAreNotCached) {
+  HloModuleConfig config = GetModuleConfigForTest();
+  config.set_seed(42);
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(kHloText, config));
+  EXPECT_TRUE(RunAndCompare(std::move(module), ErrorSpec{1e-3, 1e-3}));
+  EXPECT_EQ(0, CountCacheEntries(cache_directory_));
+}
+
+// Measures compile time with an empty cache (cold) and with a populated one
+// (warm), as seen by a process starting up.
+void CompileHelper(int iters, bool warm) {
+  tensorflow::testing::StopTiming();
+  std::unique_ptr<Backend> backend =
+      Backend::CreateDefaultBackend().ConsumeValueOrDie();
+  tensorflow::Env* env = tensorflow::Env::Default();
+  const std::string directory = NewCacheDirectory();
+
+  HloModuleConfig config;
+  DebugOptions debug_options = GetDebugOptionsFromFlags();
+  debug_options.set_xla_cpu_persistent_cache_dir(directory);
+  config.set_debug_options(debug_options);
+  std::unique_ptr<HloModule> module =
+      ParseAndReturnUnverifiedModule(kHloText, config).ConsumeValueOrDie();
+
+  auto compile = [&]() {
+    std::unique_ptr<HloModule> optimized =
+        backend->compiler()
+            ->RunHloPasses(module->Clone(), backend->default_stream_executor(),
+                           /*device_allocator=*/nullptr)
+            .ConsumeValueOrDie();
+    CHECK(backend->compiler()
+              ->RunBackend(std::move(optimized),
+                           backend->default_stream_executor(),
+                           /*device_allocator=*/nullptr)
+              .ok());
+  };
+  if (warm) {
+    compile();
+  }
+
+  for (int i = 0; i < iters; ++i) {
+    if (!warm) {
+      int64 undeleted_files, undeleted_dirs;
+      TF_CHECK_OK(
+          env->DeleteRecursively(directory, &undeleted_files, &undeleted_dirs));
+    }
+    tensorflow::testing::StartTiming();
+    compile();
+    tensorflow::testing::StopTiming();
+  }
+}
+
+void BM_CompileColdCache(int iters) { CompileHelper(iters, /*warm=*/false); }
+void BM_CompileWarmCache(int iters) { CompileHelper(iters, /*warm=*/true); }
+BENCHMARK(BM_CompileColdCache);
+BENCHMARK(BM_CompileWarmCache);
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
@@ -0,0 +1,193 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Tests that dots with small static dimensions are emitted as straight-line
+// code, and compute the same result as the reference.
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_replace.h"
+#include "tensorflow/compiler/xla/debug_options_flags.h"
+#include "tensorflow/compiler/xla/service/cpu/tests/cpu_codegen_test.h"
+#include "tensorflow/compiler/xla/service/hlo_runner.h"
+#include "tensorflow/compiler/xla/service/platform_util.h"
+#include "tensorflow/compiler/xla/tests/test_utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+// $m, $n and $k are replaced by the dimensions of the product.
+const char* const kDotHlo = R"(
+HloModule Dot
+
+ENTRY main {
+  lhs = f32[$m,$k] parameter(0)
+  rhs = f32[$k,$n] parameter(1)
+  ROOT dot = f32[$m,$n] dot(lhs, rhs),
+    lhs_contracting_dims={1}, rhs_contracting_dims={0}
+}
+)";
+
+string MakeDotHlo(int64 m, int64 n, int64 k) {
+  return absl::StrReplaceAll(kDotHlo, {{"$m", absl::StrCat(m)},
+                                       {"$n", absl::StrCat(n)},
+                                       {"$k", absl::StrCat(k)}});
+}
+
+void DisableUnrolledGemm(DebugOptions* debug_options) {
+  (*debug_options->mutable_xla_backend_extra_options())
+      ["xla_cpu_unrolled_gemm_max_dims"] = "0:0:0";
+}
+
+class CpuUnrolledGemmTest : public CpuCodegenTest {
+ protected:
+  DebugOptions GetDebugOptionsForTest() override {
+    DebugOptions debug_options = CpuCodegenTest::GetDebugOptionsForTest();
+    if (disable_unrolled_gemm_) {
+      DisableUnrolledGemm(&debug_options);
+    }
+    return debug_options;
+  }
+
+  bool disable_unrolled_gemm_ = false;
+};
+
+TEST_F(CpuUnrolledGemmTest, SmallDotHasNoLoops) {
+  CompileAndVerifyIr(MakeDotHlo(8, 32, 64), R"(
+CHECK: define internal void @unrolled_gemm_F32_8x64x32_
+CHECK-NOT: br
+CHECK: ret void
+)");
+}
+
+TEST_F(CpuUnrolledGemmTest, LargeDotIsNotUnrolled) {
+  CompileAndVerifyIr(MakeDotHlo(64, 64, 64), R"(
+CHECK-NOT: unrolled_gemm
+)");
+}
+
+TEST_F(CpuUnrolledGemmTest, DisabledDotIsNotUnrolled) {
+  disable_unrolled_gemm_ = true;
+  CompileAndVerifyIr(MakeDotHlo(8, 32, 64), R"(
+CHECK-NOT: unrolled_gemm
+)");
+}
+
+TEST_F(CpuUnrolledGemmTest, Dots) {
+  // Odd sizes leave partial row tiles and columns that need narrower vectors.
+  for (const auto& dims : std::vector<std::array<int64, 3>>{
+           {8, 32, 64}, {1, 2, 3}, {5, 7, 3}, {7, 29, 13}, {16, 64, 16}}) {
+    EXPECT_TRUE(RunAndCompare(MakeDotHlo(dims[0], dims[1], dims[2]),
+                              ErrorSpec{1e-4, 1e-4}))
+        << dims[0] << "x" << dims[1] << "x" << dims[2];
+  }
+}
+
+TEST_F(CpuUnrolledGemmTest, DotWithColumnMajorOperands) {
+  const char* const hlo_text = R"(
+HloModule DotColumnMajor
+
+ENTRY main {
+  lhs = f32[6,10]{0,1} parameter(0)
+  rhs = f32[10,9]{0,1} parameter(1)
+  ROOT dot = f32[6,9] dot(lhs, rhs),
+    lhs_contracting_dims={1}, rhs_contracting_dims={0}
+}
+)";
+  EXPECT_TRUE(RunAndCompare(hlo_text, ErrorSpec{1e-4, 1e-4}));
+}
+
+TEST_F(CpuUnrolledGemmTest, DotWithBias) {
+  const char* const hlo_text = R"(
+HloModule DotBias
+
+ENTRY main {
+  lhs = f32[8,64] parameter(0)
+  rhs = f32[64,32] parameter(1)
+  bias = f32[8,32] parameter(2)
+  dot = f32[8,32] dot(lhs, rhs),
+    lhs_contracting_dims={1}, rhs_contracting_dims={0}
+  ROOT add = f32[8,32] add(dot, bias)
+}
+)";
+  EXPECT_TRUE(RunAndCompare(hlo_text, ErrorSpec{1e-4, 1e-4}));
+}
+
+// The {m, k, n} dimensions the benchmarks sweep over.
+constexpr int64 kBenchmarkDims[][3] = {
+    {4, 16, 16}, {8, 32, 32}, {8, 64, 32}, {16, 64, 16}, {16, 64, 32},
+    {7, 29, 13}};
+
+// Measures the dot with dimensions kBenchmarkDims[dims_index] with and without
+// unrolling, and reports the multiply-adds as items.
+void BM_SmallDot(int iters, int dims_index, int unrolled) {
+  tensorflow::testing::StopTiming();
+  const int64 m = kBenchmarkDims[dims_index][0];
+  const int64 k = kBenchmarkDims[dims_index][1];
+  const int64 n = kBenchmarkDims[dims_index][2];
+  tensorflow::testing::SetLabel(absl::StrCat(m, "x", k, "x", n));
+  HloRunner runner(PlatformUtil::GetDefaultPlatform().ValueOrDie());
+  DebugOptions debug_options = GetDebugOptionsFromFlags();
+  if (!unrolled) {
+    DisableUnrolledGemm(&debug_options);
+  }
+  std::unique_ptr<HloModule> module =
+      HloRunner::CreateModuleFromString(MakeDotHlo(m, n, k), debug_options)
+          .ConsumeValueOrDie();
+  std::vector<Literal> arguments =
+      MakeFakeArguments(module.get()).ConsumeValueOrDie();
+  std::vector<ScopedShapedBuffer> buffers =
+      runner.TransferLiteralsToDevice(arguments).ConsumeValueOrDie();
+  std::unique_ptr<Executable> executable =
+      runner.CreateExecutable(std::move(module), /*run_hlo_passes=*/true)
+          .ConsumeValueOrDie();
+
+  // Warm up.
+  TF_CHECK_OK(
+      runner.ExecuteWithDeviceBuffers(executable.get(), buffers).status());
+  tensorflow::testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    TF_CHECK_OK(
+        runner.ExecuteWithDeviceBuffers(executable.get(), buffers).status());
+  }
+  tensorflow::testing::StopTiming();
+  tensorflow::testing::ItemsProcessed(static_cast<int64>(iters) * m * k * n);
+}
+
+BENCHMARK(BM_SmallDot)
+    ->ArgPair(0, 0)
+    ->ArgPair(0, 1)
+    ->ArgPair(1, 0)
+    ->ArgPair(1, 1)
+    ->ArgPair(2, 0)
+    ->ArgPair(2, 1)
+    ->ArgPair(3, 0)
+    ->ArgPair(3, 1)
+    ->ArgPair(4, 0)
+    ->ArgPair(4, 1)
+    ->ArgPair(5, 0)
+    ->ArgPair(5, 1);
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
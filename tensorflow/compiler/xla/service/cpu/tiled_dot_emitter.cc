@@ -938,6 +938,134 @@ void TiledSmallGemmEmitter::EmitTiledGemm(
   });
 }
 
+// Emits a row major GEMM with small static dimensions as straight-line code.
+//
+// The result is computed in tiles of `tile_size_m` rows by `tile_size_n`
+// vectors, each held in registers for the whole reduction: every step of the
+// reduction loads `tile_size_n` vectors from one row of the RHS, broadcasts
+// one element of the LHS per row of the tile, and accumulates their products.
+// The columns that do not fill a vector of `vectorization_width` are covered
+// by narrower vectors, down to scalars.
+//
+// No loops are emitted, so the size of the generated code is proportional to
+// m * k * n / vectorization_width.  The caller is responsible for only using
+// this emitter for small dimensions.
+class UnrolledSmallGemmEmitter {
+ public:
+  class Config {
+   public:
+    explicit Config(PrimitiveType scalar_type, int64 m, int64 k, int64 n,
+                    int64 vectorization_width, int64 tile_size_m,
+                    int64 tile_size_n)
+        : scalar_type_(scalar_type),
+          m_(m),
+          k_(k),
+          n_(n),
+          vectorization_width_(vectorization_width),
+          tile_size_m_(tile_size_m),
+          tile_size_n_(tile_size_n) {}
+
+    string GetCacheKey() const {
+      return absl::StrCat("unrolled_gemm_", PrimitiveType_Name(scalar_type()),
+                          "_", m(), "x", k(), "x", n(), "_",
+                          vectorization_width(), "_", tile_size_m(), "_",
+                          tile_size_n());
+    }
+
+    PrimitiveType scalar_type() const { return scalar_type_; }
+    int64 m() const { return m_; }
+    int64 k() const { return k_; }
+    int64 n() const { return n_; }
+    int64 vectorization_width() const { return vectorization_width_; }
+    int64 tile_size_m() const { return tile_size_m_; }
+    int64 tile_size_n() const { return tile_size_n_; }
+
+   private:
+    PrimitiveType scalar_type_;
+    int64 m_;
+    int64 k_;
+    int64 n_;
+    int64 vectorization_width_;
+    int64 tile_size_m_;
+    int64 tile_size_n_;
+  };
+
+  explicit UnrolledSmallGemmEmitter(Config config, llvm::Value* lhs,
+                                    llvm::Value* rhs, llvm::Value* result,
+                                    llvm::IRBuilder<>* b)
+      : config_(config), lhs_(lhs), rhs_(rhs), result_(result), b_(b) {
+    CHECK_GT(config_.vectorization_width(), 0);
+    CHECK_GT(config_.tile_size_m(), 0);
+    CHECK_GT(config_.tile_size_n(), 0);
+  }
+
+  void Emit();
+
+ private:
+  // Computes columns [n_start, n_start + vector_count * vsl->vector_size()) of
+  // the result.
+  void EmitColumnTile(VectorSupportLibrary* vsl, int64 n_start,
+                      int64 vector_count);
+
+  Config config_;
+  llvm::Value* lhs_;
+  llvm::Value* rhs_;
+  llvm::Value* result_;
+  llvm::IRBuilder<>* b_;
+};
+
+void UnrolledSmallGemmEmitter::Emit() {
+  int64 n_start = 0;
+  for (int64 width = config_.vectorization_width(); n_start != config_.n();
+       width = std::max<int64>(width / 2, 1)) {
+    const int64 vector_count = (config_.n() - n_start) / width;
+    if (vector_count == 0) {
+      continue;
+    }
+    VectorSupportLibrary vsl(config_.scalar_type(), width, b_,
+                             "unrolled_gemm");
+    for (int64 v = 0; v < vector_count; v += config_.tile_size_n()) {
+      EmitColumnTile(&vsl, n_start + v * width,
+                     std::min(config_.tile_size_n(), vector_count - v));
+    }
+    n_start += vector_count * width;
+  }
+}
+
+void UnrolledSmallGemmEmitter::EmitColumnTile(VectorSupportLibrary* vsl,
+                                              int64 n_start,
+                                              int64 vector_count) {
+  const int64 m = config_.m();
+  const int64 k = config_.k();
+  const int64 n = config_.n();
+  const int64 width = vsl->vector_size();
+  for (int64 m_start = 0; m_start < m; m_start += config_.tile_size_m()) {
+    const int64 rows = std::min(config_.tile_size_m(), m - m_start);
+    std::vector<std::vector<llvm::Value*>> accumulators(
+        rows, std::vector<llvm::Value*>(vector_count, vsl->GetZeroVector()));
+    std::vector<llvm::Value*> rhs_vectors(vector_count);
+    for (int64 k_i = 0; k_i < k; k_i++) {
+      for (int64 v = 0; v < vector_count; v++) {
+        rhs_vectors[v] = vsl->LoadVector(rhs_, k_i * n + n_start + v * width);
+      }
+      for (int64 r = 0; r < rows; r++) {
+        llvm::Value* lhs_broadcast =
+            vsl->LoadBroadcast(lhs_, (m_start + r) * k + k_i);
+        for (int64 v = 0; v < vector_count; v++) {
+          accumulators[r][v] =
+              vsl->MulAdd(lhs_broadcast, rhs_vectors[v], accumulators[r][v]);
+        }
+      }
+    }
+    for (int64 r = 0; r < rows; r++) {
+      for (int64 v = 0; v < vector_count; v++) {
+        vsl->StoreVector(accumulators[r][v], result_,
+                         (m_start + r) * n + n_start + v * width);
+      }
+    }
+  }
+}
+
 llvm::Type* GetPointerToElementType(llvm::Type* pointer_type) {
   llvm::Type* type =
       llvm::cast<llvm::PointerType>(pointer_type)->getElementType();
@@ -1065,5 +1193,25 @@ void EmitSmallGemm(PrimitiveType scalar_type, int64 m, int64 k, int64 n,
       });
 }
 
+void EmitUnrolledSmallGemm(PrimitiveType scalar_type, int64 m, int64 k,
+                           int64 n, int64 vectorization_width,
+                           int64 tile_size_m, int64 tile_size_n,
+                           llvm::Value* lhs, llvm::Value* rhs,
+                           llvm::Value* result, llvm::IRBuilder<>* b,
+                           const HloModuleConfig& module_config) {
+  UnrolledSmallGemmEmitter::Config config(
+      /*scalar_type=*/scalar_type, /*m=*/m, /*k=*/k, /*n=*/n,
+      /*vectorization_width=*/vectorization_width,
+      /*tile_size_m=*/tile_size_m, /*tile_size_n=*/tile_size_n);
+
+  KernelSupportLibrary::EmitAndCallOutlinedKernel(
+      module_config, b, config.GetCacheKey(), lhs, rhs, result,
+      [&](llvm::Value* lhs, llvm::Value* rhs, llvm::Value* result) {
+        UnrolledSmallGemmEmitter emitter(config, /*lhs=*/lhs, /*rhs=*/rhs,
+                                         /*result=*/result, b);
+        emitter.Emit();
+      });
+}
+
 }  // namespace cpu
 }  // namespace xla
@@ -49,6 +49,19 @@ void EmitSmallGemm(PrimitiveType scalar_type, tensorflow::int64 m,
                    llvm::Value* lhs, llvm::Value* rhs, llvm::Value* result,
                    llvm::IRBuilder<>* b, const HloModuleConfig& module_config);
 
+// Emits a row major GEMM as straight-line code, without loops, holding tiles
+// of `tile_size_m` rows by `tile_size_n` vectors of `vectorization_width`
+// elements of the result in registers.  Only suitable for small dimensions.
+// Overwrites `result`.
+void EmitUnrolledSmallGemm(PrimitiveType scalar_type, tensorflow::int64 m,
+                           tensorflow::int64 k, tensorflow::int64 n,
+                           tensorflow::int64 vectorization_width,
+                           tensorflow::int64 tile_size_m,
+                           tensorflow::int64 tile_size_n, llvm::Value* lhs,
+                           llvm::Value* rhs, llvm::Value* result,
+                           llvm::IRBuilder<>* b,
+                           const HloModuleConfig& module_config);
+
 }  // namespace cpu
 }  // namespace xla
 
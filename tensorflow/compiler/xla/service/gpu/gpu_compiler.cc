@@ -624,7 +624,8 @@ StatusOr<std::unique_ptr<Executable>> GpuCompiler::RunBackend(
       profile_index_map = absl::make_unique<HloProfileIndexMap>(*module);
       profile_printer =
           CreateHloProfilePrinterData(*profile_index_map, cost_analysis,
-                                      module->entry_computation()->name());
+                                      module->entry_computation()->name(),
+                                      module->name());
     }
   }
 
@@ -50,7 +50,7 @@ HloProfileIndexMap::HloProfileIndexMap(const HloModule& module,
 std::unique_ptr<HloProfilePrinterData> CreateHloProfilePrinterData(
     const HloProfileIndexMap& hlo_profile_index_map,
     const HloCostAnalysis& cost_analysis,
-    const string& entry_computation_name) {
+    const string& entry_computation_name, const string& module_name) {
   using HloComputationInfo = HloProfilePrinterData::HloComputationInfo;
   using HloInstructionInfo = HloProfilePrinterData::HloInstructionInfo;
 
@@ -108,6 +108,13 @@ std::unique_ptr<HloProfilePrinterData> CreateHloProfilePrinterData(
           cost_analysis.optimal_seconds(*hlo));
       instruction_info->set_profile_index(
           hlo_profile_index_map.GetProfileIndexFor(*hlo));
+      instruction_info->set_name(hlo->name());
+      for (const HloComputation* called : hlo->called_computations()) {
+        instruction_info->add_called_computation_names(called->name());
+      }
+      for (int64 partitions : hlo->outer_dimension_partitions()) {
+        instruction_info->add_outer_dimension_partitions(partitions);
+      }
     }
   }
 
@@ -118,6 +125,7 @@ std::unique_ptr<HloProfilePrinterData> CreateHloProfilePrinterData(
   }
 
   profile_printer_data->set_entry_computation(entry_computation_name);
+  profile_printer_data->set_module_name(module_name);
 
   return profile_printer_data;
 }
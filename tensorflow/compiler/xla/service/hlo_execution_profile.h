@@ -98,7 +98,8 @@ class HloProfileIndexMap {
 // Create an instance of `HloProfilePrinterData`.
 std::unique_ptr<HloProfilePrinterData> CreateHloProfilePrinterData(
     const HloProfileIndexMap& hlo_profile_index_map,
-    const HloCostAnalysis& cost_analysis, const string& entry_computation_name);
+    const HloCostAnalysis& cost_analysis, const string& entry_computation_name,
+    const string& module_name);
 
 // Describes how much time each HLO operation took.
 //
@@ -60,6 +60,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/core/threadpool_options.h"
 #include "tensorflow/core/lib/gtl/array_slice.h"
+#include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/strings/numbers.h"
@@ -140,6 +141,11 @@ thread::ThreadPool* GlobalThreadPool(const SessionOptions& options) {
   return thread_pool;
 }
 
+// The maximum number of idle RunStates a DirectSession keeps for reuse by the
+// steps of one callable. This bounds the memory held by the pool after a burst
+// of concurrent steps.
+constexpr size_t kMaxPooledRunStates = 16;
+
 // TODO(vrv): Figure out how to unify the many different functions
 // that generate RendezvousKey, since many of them have to be
 // consistent with each other.
@@ -498,7 +504,13 @@ Status DirectSession::RunInternal(
     const thread::ThreadPoolOptions& threadpool_options) {
   const uint64 start_time_usecs = options_.env->NowMicros();
   const int64 executor_step_count = executors_and_keys->step_count.fetch_add(1);
-  RunState run_state(step_id, &devices_);
+  std::unique_ptr<RunState> run_state_ptr =
+      AcquireRunState(step_id, executors_and_keys);
+  RunState& run_state = *run_state_ptr;
+  auto release_run_state =
+      gtl::MakeCleanup([this, executors_and_keys, &run_state_ptr] {
+        ReleaseRunState(executors_and_keys, std::move(run_state_ptr));
+      });
   const size_t num_executors = executors_and_keys->items.size();
 
   profiler::TraceMeProducer activity(
@@ -689,8 +701,8 @@ Status DirectSession::RunInternal(
   Status run_status;
 
   auto set_threadpool_args_for_item =
-      [&default_runner, &handler](const PerPartitionExecutorsAndLib& item,
-                                  Executor::Args* args) {
+      [&default_runner, &handler, pool](const PerPartitionExecutorsAndLib& item,
+                                        Executor::Args* args) {
         // TODO(azaks): support partial run.
         // TODO(azaks): if the device picks its own threadpool, we need to
         // assign
@@ -701,10 +713,12 @@ Status DirectSession::RunInternal(
         // specific thread pool(s).
         if (!device_thread_pool) {
           args->runner = default_runner;
+          args->runner_thread_pool = handler == nullptr ? pool : nullptr;
         } else {
           args->runner = [device_thread_pool](Executor::Args::Closure c) {
             device_thread_pool->Schedule(std::move(c));
           };
+          args->runner_thread_pool = device_thread_pool;
         }
         if (handler != nullptr) {
           args->user_intra_op_threadpool =
@@ -713,8 +727,11 @@ Status DirectSession::RunInternal(
       };
 
   if (can_execute_synchronously) {
-    PrivateIntraProcessRendezvous rendezvous(device_mgr_.get());
-    args.rendezvous = &rendezvous;
+    if (run_state.rendezvous == nullptr) {
+      run_state.rendezvous =
+          absl::make_unique<PrivateIntraProcessRendezvous>(device_mgr_.get());
+    }
+    args.rendezvous = run_state.rendezvous.get();
 
     const auto& item = executors_and_keys->items[0];
     set_threadpool_args_for_item(item, &args);
@@ -784,6 +801,9 @@ Status DirectSession::RunInternal(
 
     mutex_lock l(executor_lock_);
     run_state.collector->BuildCostModel(&cost_model_manager_, device_to_graph);
+    for (const auto& item : executors_and_keys->items) {
+      item.executor->UpdateCostEstimates();
+    }
 
     // annotate stats onto cost graph.
     CostGraphDef* cost_graph = run_metadata->mutable_cost_graph();
@@ -1412,6 +1432,13 @@ Status DirectSession::CreateExecutors(
                                          device->name(),
                                          partition_graph.get()));
 
+    if (options_.config.graph_options().build_cost_model() > 0) {
+      // The executor starts from whatever the cost model knows about this
+      // graph, and is updated as `RunInternal()` adds measurements to it.
+      params.cost_model =
+          cost_model_manager_.FindOrCreateCostModel(partition_graph.get());
+    }
+
     item->executor = nullptr;
     item->device = device;
     auto executor_type = options_.config.experimental().executor_type();
@@ -1764,16 +1791,64 @@ Status DirectSession::CreateGraphs(
 
 DirectSession::RunState::RunState(int64 step_id,
                                   const std::vector<Device*>* devices)
-    : step_container(step_id, [devices, step_id](const string& name) {
+    : step_id(step_id),
+      step_container(step_id, [this, devices](const string& name) {
         for (auto d : *devices) {
           if (!d->resource_manager()->Cleanup(name).ok()) {
             // Do nothing...
           }
           ScopedAllocatorMgr* sam = d->GetScopedAllocatorMgr();
-          if (sam) sam->Cleanup(step_id);
+          if (sam) sam->Cleanup(this->step_id);
         }
       }) {}
 
+void DirectSession::RunState::Reset(int64 new_step_id) {
+  step_id = new_step_id;
+  {
+    mutex_lock l(mu);
+    status = Status::OK();
+  }
+  step_container.Reset(new_step_id);
+}
+
+std::unique_ptr<DirectSession::RunState> DirectSession::AcquireRunState(
+    int64 step_id, ExecutorsAndKeys* executors_and_keys) {
+  std::unique_ptr<RunState> run_state;
+  {
+    mutex_lock l(executors_and_keys->run_state_pool_lock);
+    auto& pool = executors_and_keys->run_state_pool;
+    if (!pool.empty()) {
+      run_state = std::move(pool.back());
+      pool.pop_back();
+    }
+  }
+  if (run_state) {
+    run_state->Reset(step_id);
+  } else {
+    run_state.reset(new RunState(step_id, &devices_));
+  }
+  return run_state;
+}
+
+void DirectSession::ReleaseRunState(ExecutorsAndKeys* executors_and_keys,
+                                    std::unique_ptr<RunState> run_state) {
+  // TensorStore has no way to drop the tensors saved by a GetSessionHandle
+  // step, so a RunState that used it is not reused.
+  if (!run_state->tensor_store.empty()) return;
+  run_state->step_container.CleanUp();
+  run_state->collective_executor.reset();
+  run_state->collector.reset();
+  // A failed step aborts its rendezvous, which cannot be reset.
+  if (run_state->rendezvous != nullptr && !run_state->rendezvous->IsIdle()) {
+    run_state->rendezvous.reset();
+  }
+  mutex_lock l(executors_and_keys->run_state_pool_lock);
+  auto& pool = executors_and_keys->run_state_pool;
+  if (pool.size() < kMaxPooledRunStates) {
+    pool.push_back(std::move(run_state));
+  }
+}
+
 DirectSession::PartialRunState::PartialRunState(
     const std::vector<string>& pending_input_names,
     const std::vector<string>& pending_output_names, int64 step_id,
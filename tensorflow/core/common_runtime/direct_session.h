@@ -158,6 +158,7 @@ class DirectSession : public Session {
   // a partition of the graph bundled with its dependent library runtime.
   // 'input_keys' are the rendezvous keys for the feeds and 'output_keys'
   // are rendezvous keys for the fetches.
+  struct RunState;
   struct ExecutorsAndKeys {
     ExecutorsAndKeys() : step_count(0) {}
 
@@ -176,6 +177,12 @@ class DirectSession : public Session {
     CallableOptions callable_options;
 
     int64 collective_graph_key = BuildGraphOptions::kNoCollectiveGraphKey;
+
+    // RunStates released by completed steps of these executors, kept so that
+    // repeated calls do not reallocate their per-step state.
+    mutex run_state_pool_lock;
+    std::vector<std::unique_ptr<RunState>> run_state_pool
+        TF_GUARDED_BY(run_state_pool_lock);
   };
 
   // A FunctionInfo object is created for every unique set of feeds/fetches.
@@ -197,14 +204,22 @@ class DirectSession : public Session {
   // For each live Run() call, the session maintains a RunState.
   // 'status' is the current status of the execution.
   struct RunState {
+    int64 step_id;
     mutex mu;
     Status status TF_GUARDED_BY(mu);
     std::unique_ptr<CollectiveExecutor::Handle> collective_executor;
     std::unique_ptr<StepStatsCollector> collector;
     TensorStore tensor_store;
     ScopedStepContainer step_container;
+    // The rendezvous of steps that run synchronously on a single executor. It
+    // is kept for the next step as long as it is idle when a step finishes.
+    std::unique_ptr<PrivateIntraProcessRendezvous> rendezvous;
 
     RunState(int64 step_id, const std::vector<Device*>* devices);
+
+    // Prepares a RunState that was released by a previous step for reuse by
+    // the step `new_step_id`.
+    void Reset(int64 new_step_id);
   };
 
   // For each live partial execution, the session maintains a PartialRunState.
@@ -263,6 +278,17 @@ class DirectSession : public Session {
       RunStateArgs* run_state_args, DataTypeVector* input_types,
       DataTypeVector* output_types, int64* collective_graph_key);
 
+  // Returns a RunState for the step `step_id` of `executors_and_keys`,
+  // reusing one from its `run_state_pool` when possible.
+  std::unique_ptr<RunState> AcquireRunState(
+      int64 step_id, ExecutorsAndKeys* executors_and_keys);
+
+  // Returns `run_state` to the `run_state_pool` of `executors_and_keys` after
+  // releasing its per-step resources, or deletes it if the pool is full or it
+  // holds tensors that must outlive the step.
+  void ReleaseRunState(ExecutorsAndKeys* executors_and_keys,
+                       std::unique_ptr<RunState> run_state);
+
   ::tensorflow::Status RunInternal(
       int64 step_id, const RunOptions& run_options,
       CallFrameInterface* call_frame, ExecutorsAndKeys* executors_and_keys,
@@ -15,6 +15,10 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/direct_session.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <limits>
 #include <map>
 #include <memory>
 #include <random>
@@ -27,6 +31,8 @@ limitations under the License.
 #include "absl/strings/match.h"
 #include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/common_runtime/executor.h"
+#include "tensorflow/core/common_runtime/executor_factory.h"
 #include "tensorflow/core/common_runtime/function_testlib.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/graph.pb.h"
@@ -60,6 +66,26 @@ limitations under the License.
 #include "rocm/include/hip/hip_runtime.h"
 #endif  // GOOGLE_CUDA
 
+// Counts the allocations made through the global operator new while
+// `count_heap_allocations` is set, so that benchmarks can report every heap
+// allocation of a step and not only those made by the CPU allocator.
+static std::atomic<bool> count_heap_allocations(false);
+static std::atomic<int64_t> num_heap_allocations(0);
+
+void* operator new(std::size_t size) {
+  if (count_heap_allocations.load(std::memory_order_relaxed)) {
+    num_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+  }
+  void* ptr = std::malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) std::abort();
+  return ptr;
+}
+void* operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+
 namespace tensorflow {
 namespace {
 
@@ -1387,6 +1413,45 @@ TEST(DirectSessionTest, SessionSyncRun) {
             static_cast<int64>(outputs[0].scalar<int64>()()));
 }
 
+// A step that fails returns its RunState to the callable's pool with an
+// aborted rendezvous. The steps that reuse that RunState must still succeed.
+TEST(DirectSessionTest, RunCallableReusesRunStateAfterFailedStep) {
+  Graph g(OpRegistry::Global());
+  Node* placeholder;
+  TF_ASSERT_OK(NodeBuilder(g.NewName("Placeholder"), "Placeholder")
+                   .Attr("shape", TensorShape())
+                   .Attr("dtype", DT_FLOAT)
+                   .Finalize(&g, &placeholder));
+  Node* checked = test::graph::CheckNumerics(&g, placeholder, "not finite");
+  Node* identity = test::graph::Identity(&g, checked);
+  GraphDef def;
+  g.ToGraphDef(&def);
+  auto session = CreateSession();
+  TF_ASSERT_OK(session->Create(def));
+
+  Session::CallableHandle handle;
+  TF_ASSERT_OK(session->MakeCallable(
+      MakeCallableOptions({placeholder->name() + ":0"},
+                          {identity->name() + ":0"}, {}),
+      &handle));
+
+  Tensor bad_value(DT_FLOAT, TensorShape());
+  bad_value.scalar<float>()() = std::numeric_limits<float>::quiet_NaN();
+  Tensor good_value(DT_FLOAT, TensorShape());
+  for (int i = 0; i < 5; ++i) {
+    std::vector<Tensor> outputs;
+    Status s = session->RunCallable(handle, {bad_value}, &outputs, nullptr);
+    EXPECT_TRUE(errors::IsInvalidArgument(s)) << s;
+
+    good_value.scalar<float>()() = i;
+    outputs.clear();
+    TF_ASSERT_OK(session->RunCallable(handle, {good_value}, &outputs, nullptr));
+    ASSERT_EQ(1, outputs.size());
+    EXPECT_EQ(static_cast<float>(i), outputs[0].scalar<float>()());
+  }
+  TF_ASSERT_OK(session->ReleaseCallable(handle));
+}
+
 REGISTER_OP("ExpensiveNoop").SetIsStateful();
 
 class ExpensiveNoopOp : public OpKernel {
@@ -2284,6 +2349,142 @@ TEST(DirectSessionTest, TestDirectSessionReset) {
   EXPECT_EQ("Cancelled: Session has been closed.", s.ToString());
 }
 
+// Records the cost model that each executor of the "COST_MODEL_RECORDING" type
+// is created with, and the number of times it is told that the cost model
+// changed. The executors otherwise behave like the "PRIORITY" executor.
+class CostModelRecordingExecutorRegistrar {
+ public:
+  CostModelRecordingExecutorRegistrar() {
+    ExecutorFactory::Register("COST_MODEL_RECORDING", new Factory());
+  }
+
+  static mutex mu;
+  static std::vector<const CostModel*>* cost_models TF_GUARDED_BY(mu);
+  static int num_updates TF_GUARDED_BY(mu);
+
+ private:
+  class RecordingExecutor : public Executor {
+   public:
+    explicit RecordingExecutor(std::unique_ptr<Executor> executor)
+        : executor_(std::move(executor)) {}
+
+    void RunAsync(const Args& args, DoneCallback done) override {
+      executor_->RunAsync(args, std::move(done));
+    }
+
+    void UpdateCostEstimates() override {
+      {
+        mutex_lock l(mu);
+        ++num_updates;
+      }
+      executor_->UpdateCostEstimates();
+    }
+
+   private:
+    std::unique_ptr<Executor> executor_;
+  };
+
+  class Factory : public ExecutorFactory {
+    Status NewExecutor(const LocalExecutorParams& params, const Graph& graph,
+                       std::unique_ptr<Executor>* out_executor) override {
+      {
+        mutex_lock l(mu);
+        cost_models->push_back(params.cost_model);
+      }
+      LocalExecutorParams priority_params = params;
+      priority_params.prioritize_critical_path = true;
+      Executor* executor = nullptr;
+      TF_RETURN_IF_ERROR(NewLocalExecutor(priority_params, graph, &executor));
+      out_executor->reset(new RecordingExecutor(absl::WrapUnique(executor)));
+      return Status::OK();
+    }
+  };
+};
+mutex CostModelRecordingExecutorRegistrar::mu;
+std::vector<const CostModel*>* CostModelRecordingExecutorRegistrar::cost_models =
+    new std::vector<const CostModel*>;
+int CostModelRecordingExecutorRegistrar::num_updates = 0;
+static CostModelRecordingExecutorRegistrar cost_model_recording_registrar;
+
+// Runs y = a * a on a session with the "COST_MODEL_RECORDING" executor type,
+// `num_steps` times.
+void RunWithCostModelRecordingExecutor(int build_cost_model, int num_steps) {
+  Graph g(OpRegistry::Global());
+  Tensor a_tensor(DT_FLOAT, TensorShape({2, 2}));
+  test::FillValues<float>(&a_tensor, {1, 2, 3, 4});
+  Node* a = test::graph::Constant(&g, a_tensor);
+  Node* y = test::graph::Matmul(&g, a, a, false, false);
+  GraphDef def;
+  g.ToGraphDef(&def);
+
+  SessionOptions options;
+  options.config.mutable_graph_options()->set_build_cost_model(
+      build_cost_model);
+  options.config.mutable_experimental()->set_executor_type(
+      "COST_MODEL_RECORDING");
+  std::unique_ptr<Session> session(NewSession(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def));
+
+  for (int i = 0; i < num_steps; ++i) {
+    std::vector<Tensor> outputs;
+    RunMetadata run_metadata;
+    TF_ASSERT_OK(session->Run(RunOptions(), {}, {y->name() + ":0"}, {},
+                              &outputs, &run_metadata));
+    ASSERT_EQ(1, outputs.size());
+    test::ExpectTensorEqual<float>(
+        outputs[0], test::AsTensor<float>({7, 10, 15, 22}, {2, 2}));
+    EXPECT_EQ(build_cost_model > 0, run_metadata.cost_graph().node_size() > 0);
+  }
+
+  if (build_cost_model > 0) {
+    // The executors were created with the cost models of the session.
+    CostModelManager::CostModelMap session_cost_models;
+    static_cast<DirectSession*>(session.get())
+        ->ExportCostModels(&session_cost_models);
+    mutex_lock l(CostModelRecordingExecutorRegistrar::mu);
+    for (const CostModel* cost_model :
+         *CostModelRecordingExecutorRegistrar::cost_models) {
+      bool found = false;
+      for (const auto& it : session_cost_models) {
+        found |= it.second == cost_model;
+      }
+      EXPECT_TRUE(found);
+    }
+  }
+}
+
+TEST(DirectSessionTest, ExecutorsUseSessionCostModel) {
+  {
+    mutex_lock l(CostModelRecordingExecutorRegistrar::mu);
+    CostModelRecordingExecutorRegistrar::cost_models->clear();
+    CostModelRecordingExecutorRegistrar::num_updates = 0;
+  }
+  RunWithCostModelRecordingExecutor(/*build_cost_model=*/1, /*num_steps=*/3);
+
+  mutex_lock l(CostModelRecordingExecutorRegistrar::mu);
+  ASSERT_FALSE(CostModelRecordingExecutorRegistrar::cost_models->empty());
+  // Every step updates the cost model, and then the executors.
+  EXPECT_GE(CostModelRecordingExecutorRegistrar::num_updates, 3);
+}
+
+TEST(DirectSessionTest, ExecutorsHaveNoCostModelUnlessBuilt) {
+  {
+    mutex_lock l(CostModelRecordingExecutorRegistrar::mu);
+    CostModelRecordingExecutorRegistrar::cost_models->clear();
+    CostModelRecordingExecutorRegistrar::num_updates = 0;
+  }
+  RunWithCostModelRecordingExecutor(/*build_cost_model=*/0, /*num_steps=*/3);
+
+  mutex_lock l(CostModelRecordingExecutorRegistrar::mu);
+  ASSERT_FALSE(CostModelRecordingExecutorRegistrar::cost_models->empty());
+  for (const CostModel* cost_model :
+       *CostModelRecordingExecutorRegistrar::cost_models) {
+    EXPECT_EQ(nullptr, cost_model);
+  }
+  EXPECT_EQ(0, CostModelRecordingExecutorRegistrar::num_updates);
+}
+
 TEST(DirectSessionTest, LocalDeviceManager) {
   SessionOptions options;
   std::unique_ptr<Session> session(NewSession(options));
@@ -2701,6 +2902,87 @@ BENCHMARK(BM_FeedFetchCallableSingleThreadExecutor)
     ->Arg(5)
     ->Arg(10);
 
+// Measures the latency distribution of `RunCallable()` on a tiny graph, where
+// the per-step setup in DirectSession dominates the cost of each call. The
+// label reports the median and tail latency, the number of heap allocations
+// made through operator new by each call, and the number of CPU allocator
+// allocations (which do not go through operator new) made by each call.
+void BM_RunCallableLatency(int iters, int inter_op_threads) {
+  testing::StopTiming();
+
+  Graph g(OpRegistry::Global());
+  Node* placeholder;
+  TF_CHECK_OK(NodeBuilder(g.NewName("Placeholder"), "Placeholder")
+                  .Attr("shape", TensorShape())
+                  .Attr("dtype", DT_FLOAT)
+                  .Device("/cpu:0")
+                  .Finalize(&g, &placeholder));
+  Node* identity;
+  TF_CHECK_OK(NodeBuilder(g.NewName("Identity"), "Identity")
+                  .Input(placeholder)
+                  .Attr("T", DT_FLOAT)
+                  .Device("/cpu:0")
+                  .Finalize(&g, &identity));
+  GraphDef gd;
+  g.ToGraphDef(&gd);
+  SessionOptions opts;
+  opts.config.set_inter_op_parallelism_threads(inter_op_threads);
+  std::unique_ptr<Session> session(NewSession(opts));
+  TF_CHECK_OK(session->Create(gd));
+
+  Session::CallableHandle handle;
+  CallableOptions callable_options;
+  callable_options.add_feed(placeholder->name() + ":0");
+  callable_options.add_fetch(identity->name() + ":0");
+  TF_CHECK_OK(session->MakeCallable(callable_options, &handle));
+
+  Tensor value(DT_FLOAT, TensorShape());
+  value.flat<float>()(0) = 37.0;
+  const std::vector<Tensor> input_tensors = {value};
+  {
+    // Warm up so that the first step's one-time setup is not measured.
+    std::vector<Tensor> output_values;
+    TF_CHECK_OK(
+        session->RunCallable(handle, input_tensors, &output_values, nullptr));
+  }
+
+  std::vector<uint64> latencies_nsec;
+  latencies_nsec.reserve(iters);
+  EnableCPUAllocatorStats(true);
+  cpu_allocator()->ClearStats();
+  num_heap_allocations = 0;
+  count_heap_allocations = true;
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    const uint64 start_nsec = Env::Default()->NowNanos();
+    std::vector<Tensor> output_values;
+    TF_CHECK_OK(
+        session->RunCallable(handle, input_tensors, &output_values, nullptr));
+    latencies_nsec.push_back(Env::Default()->NowNanos() - start_nsec);
+  }
+  testing::StopTiming();
+  count_heap_allocations = false;
+  const int64 num_heap_allocs = num_heap_allocations;
+  const int64 num_allocator_allocs = cpu_allocator()->GetStats()->num_allocs;
+  EnableCPUAllocatorStats(false);
+  TF_CHECK_OK(session->ReleaseCallable(handle));
+
+  std::sort(latencies_nsec.begin(), latencies_nsec.end());
+  const uint64 p50_nsec = latencies_nsec[latencies_nsec.size() / 2];
+  const uint64 p99_nsec = latencies_nsec[latencies_nsec.size() * 99 / 100];
+  const string label = strings::StrCat(
+      "p50 = ", p50_nsec, "ns p99 = ", p99_nsec, "ns heap allocs/run = ",
+      static_cast<double>(num_heap_allocs) / iters, " allocator allocs/run = ",
+      static_cast<double>(num_allocator_allocs) / iters);
+#ifdef PLATFORM_GOOGLE
+  SetBenchmarkLabel(label);
+#else
+  VLOG(1) << label;
+#endif  // PLATFORM_GOOGLE
+}
+
+BENCHMARK(BM_RunCallableLatency)->Arg(0)->Arg(-1);
+
 }  // namespace
 
 class DirectSessionCollectiveTest : public ::testing::Test {
@@ -15,20 +15,25 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/executor.h"
 
+#include <algorithm>
 #include <atomic>
 #include <memory>
+#include <queue>
 #include <vector>
 
 #include "absl/memory/memory.h"
 #include "tensorflow/core/common_runtime/costmodel_manager.h"
+#include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/common_runtime/entry.h"
 #include "tensorflow/core/common_runtime/executor_factory.h"
 #include "tensorflow/core/common_runtime/graph_view.h"
 #include "tensorflow/core/common_runtime/immutable_executor_state.h"
+#include "tensorflow/core/common_runtime/memory_planner.h"
 #include "tensorflow/core/common_runtime/pending_counts.h"
 #include "tensorflow/core/common_runtime/propagator_state.h"
 #include "tensorflow/core/common_runtime/renamed_device.h"
 #include "tensorflow/core/common_runtime/simple_propagator_state.h"
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/cancellation.h"
@@ -43,6 +48,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_reference.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/graph/costmodel.h"
 #include "tensorflow/core/graph/edgeset.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/graph_node_util.h"
@@ -69,6 +75,7 @@ limitations under the License.
 #include "tensorflow/core/profiler/lib/scoped_annotation.h"
 #include "tensorflow/core/profiler/lib/traceme_encode.h"
 #include "tensorflow/core/protobuf/error_codes.pb.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/tensor_slice_reader_cache.h"
 
 namespace tensorflow {
@@ -132,6 +139,21 @@ struct KernelTimer {
 typedef gtl::InlinedVector<TensorValue, 4> TensorValueVec;
 typedef gtl::InlinedVector<AllocatorAttributes, 4> AllocatorAttributeVec;
 
+// Returns true if the environment variable TF_CPU_USE_STEP_ARENA enables step
+// arenas for every CPU executor.
+bool StepArenaEnabledByEnv() {
+  static const bool enabled = [] {
+    bool enabled = false;
+    Status status =
+        ReadBoolFromEnvVar("TF_CPU_USE_STEP_ARENA", false, &enabled);
+    if (!status.ok()) {
+      LOG(ERROR) << "Executor: " << status.error_message();
+    }
+    return enabled;
+  }();
+  return enabled;
+}
+
 class ExecutorImpl : public Executor {
  public:
   explicit ExecutorImpl(const LocalExecutorParams& p) : immutable_state_(p) {}
@@ -139,11 +161,41 @@ class ExecutorImpl : public Executor {
   Status Initialize(const Graph& graph) {
     TF_RETURN_IF_ERROR(immutable_state_.Initialize(graph));
     kernel_stats_.Initialize(immutable_state_.graph_view());
+    if (immutable_state_.params().cost_model != nullptr) {
+      graph_ = &graph;
+      kernel_stats_.SeedCostEstimates(graph, immutable_state_.graph_view(),
+                                      *immutable_state_.params().cost_model);
+    }
+    Device* device = immutable_state_.params().device;
+    if (immutable_state_.params().plan_memory &&
+        device->device_type() == DEVICE_CPU) {
+      const GraphView& gview = immutable_state_.graph_view();
+      memory_planner_ = MemoryPlanner::Create(
+          graph,
+          [&gview](const Node* n, int output_index) {
+            const NodeItem* item = gview.node(n->id());
+            return item != nullptr &&
+                   item->output_attrs()[output_index].step_local();
+          },
+          device->GetAllocator(AllocatorAttributes()));
+    }
+    use_step_arena_ = device->device_type() == DEVICE_CPU &&
+                      (immutable_state_.params().use_step_arena ||
+                       StepArenaEnabledByEnv());
     return Status::OK();
   }
 
   void RunAsync(const Args& args, DoneCallback done) override;
 
+  void UpdateCostEstimates() override {
+    if (graph_ == nullptr) return;
+    kernel_stats_.SeedCostEstimates(*graph_, immutable_state_.graph_view(),
+                                    *immutable_state_.params().cost_model);
+    if (immutable_state_.params().prioritize_critical_path) {
+      immutable_state_.UpdateNodePriorities(*graph_);
+    }
+  }
+
  private:
   template <class PropagatorStateType>
   friend class ExecutorState;
@@ -153,6 +205,10 @@ class ExecutorImpl : public Executor {
    public:
     KernelStats() = default;
 
+    // Cost estimates (in CPU cycles) above this threshold make a node
+    // "expensive".
+    static constexpr uint64 kOpIsExpensiveThresholdCycles = 5000;
+
     void Initialize(const GraphView& gview) {
       is_expensive_ = absl::make_unique<std::atomic<bool>[]>(gview.num_nodes());
       cost_estimates_ =
@@ -166,6 +222,32 @@ class ExecutorImpl : public Executor {
       }
     }
 
+    // Replaces the initial cost estimates with the time estimates recorded in
+    // `cost_model`, for the nodes that it has measured. Without this, every
+    // node starts out "expensive" until it has been run enough times to learn
+    // otherwise.
+    void SeedCostEstimates(const Graph& graph, const GraphView& gview,
+                           const CostModel& cost_model) {
+      const double cycles_per_micro =
+          profile_utils::CpuUtils::GetCycleCounterFrequency() / 1.0e6;
+      if (cycles_per_micro <= 0) return;
+      for (const Node* n : graph.op_nodes()) {
+        const NodeItem* item = gview.node(n->id());
+        if (item == nullptr || cost_model.TotalCount(n) == 0) continue;
+        const uint64 estimate = static_cast<uint64>(
+            cost_model.TimeEstimate(n).value() * cycles_per_micro);
+        cost_estimates_[item->node_id] = estimate;
+        if (estimate < kOpIsExpensiveThresholdCycles) {
+          is_expensive_[item->node_id] = false;
+        }
+      }
+    }
+
+    // Returns the current cost estimate (in CPU cycles) for the given node.
+    uint64 CostEstimate(const NodeItem& node) const {
+      return cost_estimates_[node.node_id].load(std::memory_order_relaxed);
+    }
+
     // Returns true iff the given node is considered "expensive". The
     // executor uses this flag to optimize graph execution, for example
     // by "inlining" inexpensive kernels.
@@ -204,7 +286,6 @@ class ExecutorImpl : public Executor {
     // determine whether an operation should be place in a threadpool.
     // Operations start out "expensive".
     static constexpr uint64 kInitialCostEstimateCycles = 100 * 1000 * 1000;
-    static constexpr uint64 kOpIsExpensiveThresholdCycles = 5000;
     static constexpr uint64 kCostDecay = 10;
 
     std::unique_ptr<std::atomic<bool>[]> is_expensive_;
@@ -214,6 +295,20 @@ class ExecutorImpl : public Executor {
   ImmutableExecutorState immutable_state_;
   KernelStats kernel_stats_;
 
+  // The graph that the executor was created from, if
+  // `LocalExecutorParams::cost_model` is set, to look up the estimates of its
+  // nodes in the cost model. Not owned.
+  const Graph* graph_ = nullptr;
+
+  // Plans the memory of step-local outputs, or nullptr if
+  // `LocalExecutorParams::plan_memory` is false or the graph cannot be
+  // planned.
+  std::unique_ptr<MemoryPlanner> memory_planner_;
+
+  // True if each step allocates its step-local outputs from a
+  // `StepArenaAllocator`. See `LocalExecutorParams::use_step_arena`.
+  bool use_step_arena_ = false;
+
   TF_DISALLOW_COPY_AND_ASSIGN(ExecutorImpl);
 };
 
@@ -271,7 +366,8 @@ class ExecutorState {
  public:
   ExecutorState(const Executor::Args& args,
                 const ImmutableExecutorState& immutable_state_,
-                ExecutorImpl::KernelStats* kernel_stats_);
+                ExecutorImpl::KernelStats* kernel_stats_,
+                MemoryPlanner* memory_planner, bool use_step_arena);
   ~ExecutorState();
 
   void RunAsync(Executor::DoneCallback done);
@@ -307,6 +403,12 @@ class ExecutorState {
   Status ProcessOutputs(const NodeItem& item, OpKernelContext* ctx,
                         Entry* outputs, NodeExecStatsInterface* stats);
 
+  // Replaces `*tensor`, an output that may escape the step, with a copy
+  // allocated with `attr` if it shares a buffer from `step_arena_`. This
+  // happens when a kernel forwards or aliases a step-local input, and would
+  // otherwise keep the whole arena alive after the step.
+  void CopyOutOfStepArena(AllocatorAttributes attr, Tensor* tensor);
+
   // Called after each node finishes. Takes ownership of "stats". Returns true
   // if execution has completed.
   //
@@ -323,6 +425,30 @@ class ExecutorState {
   // REQUIRES: `!ready->empty()`.
   void ScheduleReady(TaggedNodeSeq* ready, TaggedNodeReadyQueue* inline_ready);
 
+  // Variant of `ScheduleReady()` used when static node priorities are
+  // available. The nodes in '*ready' are considered in decreasing order of
+  // priority, and the expensive nodes are added to `prioritized_ready_`. Each
+  // closure passed to `runner_` processes the highest-priority node in
+  // `prioritized_ready_` at the time that it runs, rather than a fixed node,
+  // so that critical-path nodes overtake nodes that became ready earlier.
+  void ScheduleReadyByPriority(TaggedNodeSeq* ready,
+                               TaggedNodeReadyQueue* inline_ready,
+                               int64 scheduled_nsec);
+
+  // Returns true if the pool that backs `runner_` already has at least one
+  // queued closure per thread. In that case, dispatching an expensive node to
+  // the pool would not start it any sooner than running it on this thread.
+  bool RunnerIsSaturated() const {
+    return runner_thread_pool_ != nullptr &&
+           runner_thread_pool_->NumPendingClosures() >=
+               runner_thread_pool_->NumThreads();
+  }
+
+  // Removes and returns the highest-priority node from `prioritized_ready_`.
+  //
+  // REQUIRES: `!prioritized_ready_.empty()`.
+  TaggedNode PopPrioritizedNode();
+
   // Clean up when this executor is done.
   void Finish();
   void ScheduleFinish();
@@ -360,11 +486,47 @@ class ExecutorState {
   // If not null, use this device to schedule intra-op operation
   std::unique_ptr<DeviceBase> user_device_;
   Executor::Args::Runner runner_;
+  thread::ThreadPool* const runner_thread_pool_;  // Not owned.
   bool sync_on_finish_;
   const bool run_all_kernels_inline_;
 
   PropagatorStateType propagator_;
 
+  // Static dispatch priorities indexed by node ID, or nullptr if ready nodes
+  // are dispatched in FIFO order. The step keeps the priorities it started
+  // with, even if the executor recomputes them meanwhile.
+  const std::shared_ptr<const std::vector<int64>> node_priorities_holder_;
+  const int64* const node_priorities_;
+
+  // Not owned. If not null, step-local outputs are allocated from
+  // `memory_slab_` once the planner has a plan. Until then the sizes of the
+  // outputs are recorded in `recorded_output_sizes_`, indexed by the
+  // planner's output index, for the planner to build the plan from.
+  MemoryPlanner* const memory_planner_;
+  MemoryPlanSlab* memory_slab_ = nullptr;
+  std::vector<int64> recorded_output_sizes_;
+
+  // If not null, step-local outputs that are not planned are allocated from
+  // this arena. The step holds a reference on it until it is done.
+  StepArenaAllocator* step_arena_ = nullptr;
+
+  // A ready node awaiting dispatch in `ScheduleReadyByPriority()`. Nodes with
+  // equal priority are dispatched in the order they became ready.
+  struct PrioritizedNode {
+    int64 priority;
+    uint64 seq;
+    TaggedNode node;
+
+    bool operator<(const PrioritizedNode& other) const {
+      return priority < other.priority ||
+             (priority == other.priority && seq > other.seq);
+    }
+  };
+  mutex prioritized_ready_mu_;
+  std::priority_queue<PrioritizedNode> prioritized_ready_
+      TF_GUARDED_BY(prioritized_ready_mu_);
+  uint64 next_prioritized_seq_ TF_GUARDED_BY(prioritized_ready_mu_) = 0;
+
   // Invoked when the execution finishes.
   Executor::DoneCallback done_cb_;
 
@@ -383,7 +545,8 @@ class ExecutorState {
 template <class PropagatorStateType>
 ExecutorState<PropagatorStateType>::ExecutorState(
     const Executor::Args& args, const ImmutableExecutorState& immutable_state,
-    ExecutorImpl::KernelStats* kernel_stats)
+    ExecutorImpl::KernelStats* kernel_stats, MemoryPlanner* memory_planner,
+    bool use_step_arena)
     : vlog_(VLOG_IS_ON(1)),
       log_memory_(LogMemory::IsEnabled()),
       step_id_(args.step_id),
@@ -404,15 +567,32 @@ ExecutorState<PropagatorStateType>::ExecutorState(
       kernel_stats_(kernel_stats),
       cancellation_manager_(args.cancellation_manager),
       runner_(args.runner),
+      runner_thread_pool_(args.runner_thread_pool),
       sync_on_finish_(args.sync_on_finish),
       run_all_kernels_inline_(args.run_all_kernels_inline),
       propagator_(immutable_state, step_id_, vlog_),
+      node_priorities_holder_(immutable_state.node_priorities()),
+      node_priorities_(node_priorities_holder_ ? node_priorities_holder_->data()
+                                               : nullptr),
+      memory_planner_(memory_planner),
       num_outstanding_ops_(0) {
   if (args.user_intra_op_threadpool != nullptr) {
     Device* device = immutable_state_.params().device;
     user_device_ = RenamedDevice::NewRenamedDevice(
         device->name(), device, false, false, args.user_intra_op_threadpool);
   }
+  if (memory_planner_ != nullptr) {
+    memory_slab_ = memory_planner_->AcquireSlab();
+    if (memory_slab_ == nullptr) {
+      recorded_output_sizes_.resize(memory_planner_->num_outputs(), 0);
+    }
+  }
+  if (use_step_arena) {
+    step_arena_ = new StepArenaAllocator(
+        immutable_state_.params().device->GetAllocator(AllocatorAttributes()),
+        StepArenaAllocator::kDefaultChunkSizeBytes,
+        StepArenaAllocator::kDefaultMaxBytesReserved);
+  }
 }
 
 template <class PropagatorStateType>
@@ -421,6 +601,22 @@ ExecutorState<PropagatorStateType>::~ExecutorState() {
     device_context_->Unref();
   }
   delete slice_reader_cache_;
+  if (memory_slab_ != nullptr) {
+    memory_planner_->ReleaseSlab(memory_slab_);
+  } else if (!recorded_output_sizes_.empty()) {
+    bool succeeded;
+    {
+      mutex_lock l(mu_);
+      succeeded = status_.ok();
+    }
+    if (succeeded) {
+      memory_planner_->RecordOutputSizes(recorded_output_sizes_);
+    }
+  }
+  if (step_arena_ != nullptr) {
+    // Frees the arena's chunks, unless an escaped tensor still uses them.
+    step_arena_->Unref();
+  }
 }
 
 template <class PropagatorStateType>
@@ -676,6 +872,7 @@ void ExecutorState<PropagatorStateType>::Process(TaggedNode tagged_node,
   params.input_alloc_attrs = &input_alloc_attrs;
   params.runner = &runner_;
   params.run_all_kernels_inline = run_all_kernels_inline_;
+  params.step_local_allocator = step_arena_;
   params.stats_collector = stats_collector_;
   params.inc_num_deferred_ops_function = [this]() {
     mutex_lock lock(num_deferred_ops_mu_);
@@ -766,6 +963,12 @@ void ExecutorState<PropagatorStateType>::Process(TaggedNode tagged_node,
       params.frame_iter = propagator_.GetFrameAndIter(tagged_node);
       params.is_input_dead = is_input_dead;
       params.output_attr_array = item.output_attrs();
+      const int64 output_base =
+          memory_slab_ != nullptr ? memory_planner_->output_base(item.node_id)
+                                  : -1;
+      params.output_allocator_array =
+          output_base >= 0 ? memory_slab_->output_allocators(output_base)
+                           : nullptr;
       params.forward_from_array = item.forward_from();
       params.outputs_required_array = item.outputs_required.get();
 
@@ -959,10 +1162,18 @@ Status ExecutorState<PropagatorStateType>::ProcessOutputs(
     return s;
   }
 
+  const int64 recorded_base =
+      recorded_output_sizes_.empty()
+          ? -1
+          : memory_planner_->output_base(item.node_id);
   for (int i = 0; i < item.num_outputs; ++i) {
     const TensorValue val = ctx->release_output(i);
     Entry* out = &outputs[i];
     DCHECK(out->state == Entry::State::NO_VALUE);
+    if (recorded_base >= 0 && val.tensor != nullptr && !val.is_ref() &&
+        val.tensor->IsInitialized()) {
+      recorded_output_sizes_[recorded_base + i] = val.tensor->TotalBytes();
+    }
 
     if (val.tensor == nullptr) {
       // Unless it's a Switch or a Recv, or the executor has marked the output
@@ -1001,6 +1212,9 @@ Status ExecutorState<PropagatorStateType>::ProcessOutputs(
           // NOTE that std::move is used here, so val.tensor goes to
           // uninitialized state (val.tensor->IsInitialized return false).
           out->state = Entry::State::HAS_VALUE;
+          if (step_arena_ != nullptr && !out->alloc_attr.step_local()) {
+            CopyOutOfStepArena(out->alloc_attr, val.tensor);
+          }
           out->val.Init(std::move(*val.tensor));
           if (log_memory_) {
             LogMemory::RecordTensorOutput(ctx->op_kernel().name(),
@@ -1024,6 +1238,23 @@ Status ExecutorState<PropagatorStateType>::ProcessOutputs(
   return s;
 }
 
+template <class PropagatorStateType>
+void ExecutorState<PropagatorStateType>::CopyOutOfStepArena(
+    AllocatorAttributes attr, Tensor* tensor) {
+  if (!tensor->IsInitialized() || tensor->TotalBytes() == 0 ||
+      !DataTypeCanUseMemcpy(tensor->dtype()) ||
+      !step_arena_->Owns(DMAHelper::base(tensor))) {
+    return;
+  }
+  Tensor copy(immutable_state_.params().device->GetAllocator(attr),
+              tensor->dtype(), tensor->shape());
+  // If the copy cannot be allocated, the tensor keeps the arena alive.
+  if (!copy.IsInitialized()) return;
+  memcpy(DMAHelper::base(&copy), DMAHelper::base(tensor),
+         tensor->TotalBytes());
+  *tensor = std::move(copy);
+}
+
 template <class PropagatorStateType>
 bool ExecutorState<PropagatorStateType>::NodeDone(
     const Status& s, TaggedNodeSeq* ready, NodeExecStatsInterface* stats,
@@ -1132,19 +1363,64 @@ void ExecutorState<PropagatorStateType>::ScheduleReady(
         inline_ready->push_back(tagged_node);
       }
     }
+  } else if (node_priorities_ != nullptr) {
+    ScheduleReadyByPriority(ready, inline_ready, scheduled_nsec);
   } else {
     const TaggedNode* curr_expensive_node = nullptr;
     if (inline_ready == nullptr) {
-      // Schedule to run all the ready ops in thread pool.
+      // Schedule to run all the ready ops in thread pool. Inexpensive nodes
+      // are grouped into closures whose combined cost estimate is about that
+      // of one expensive node, to amortize the closure and thread wakeup
+      // overhead.
+      TaggedNodeSeq inexpensive_batch;
+      uint64 inexpensive_batch_cost = 0;
+      auto dispatch_inexpensive_batch = [this, &inexpensive_batch,
+                                         &inexpensive_batch_cost,
+                                         scheduled_nsec]() {
+        if (inexpensive_batch.size() == 1) {
+          runner_(std::bind(&ExecutorState::Process, this,
+                            *inexpensive_batch.begin(), scheduled_nsec));
+        } else if (!inexpensive_batch.empty()) {
+          runner_([this, batch = std::move(inexpensive_batch),
+                   scheduled_nsec]() {
+            for (auto& tagged_node : batch) {
+              Process(tagged_node, scheduled_nsec);
+            }
+          });
+        }
+        inexpensive_batch.clear();
+        inexpensive_batch_cost = 0;
+      };
       for (auto& tagged_node : *ready) {
-        runner_([=]() { Process(tagged_node, scheduled_nsec); });
+        const NodeItem& item = *tagged_node.node_item;
+        if (tagged_node.get_is_dead()) {
+          inexpensive_batch.push_back(tagged_node);
+        } else if (!kernel_stats_->IsExpensive(item)) {
+          inexpensive_batch.push_back(tagged_node);
+          inexpensive_batch_cost += kernel_stats_->CostEstimate(item);
+          if (inexpensive_batch_cost >=
+              ExecutorImpl::KernelStats::kOpIsExpensiveThresholdCycles) {
+            dispatch_inexpensive_batch();
+          }
+        } else {
+          runner_([=]() { Process(tagged_node, scheduled_nsec); });
+        }
       }
+      dispatch_inexpensive_batch();
     } else {
+      // If the pool is saturated, one expensive node is run on this thread
+      // rather than queued behind the closures that are already pending. The
+      // others are still dispatched, so that they are not serialized on this
+      // thread once the pool catches up.
+      bool inline_expensive_node = RunnerIsSaturated();
       for (auto& tagged_node : *ready) {
         const NodeItem& item = *tagged_node.node_item;
         if (tagged_node.get_is_dead() || !kernel_stats_->IsExpensive(item)) {
           // Inline this inexpensive node.
           inline_ready->push_back(tagged_node);
+        } else if (inline_expensive_node) {
+          inline_ready->push_back(tagged_node);
+          inline_expensive_node = false;
         } else {
           if (curr_expensive_node) {
             // Dispatch to another thread since there is plenty of work to
@@ -1170,6 +1446,69 @@ void ExecutorState<PropagatorStateType>::ScheduleReady(
   ready->clear();
 }
 
+template <class PropagatorStateType>
+void ExecutorState<PropagatorStateType>::ScheduleReadyByPriority(
+    TaggedNodeSeq* ready, TaggedNodeReadyQueue* inline_ready,
+    int64 scheduled_nsec) {
+  std::stable_sort(ready->begin(), ready->end(),
+                   [this](const TaggedNode& a, const TaggedNode& b) {
+                     return node_priorities_[a.get_node_item().node_id] >
+                            node_priorities_[b.get_node_item().node_id];
+                   });
+
+  const TaggedNode* most_critical_expensive_node = nullptr;
+  int num_to_dispatch = 0;
+  {
+    mutex_lock l(prioritized_ready_mu_);
+    for (auto& tagged_node : *ready) {
+      const NodeItem& item = tagged_node.get_node_item();
+      if (inline_ready != nullptr) {
+        if (tagged_node.get_is_dead() || !kernel_stats_->IsExpensive(item)) {
+          // Inline this inexpensive node.
+          inline_ready->push_back(tagged_node);
+          continue;
+        }
+        if (most_critical_expensive_node == nullptr) {
+          // Keep the most critical expensive node for this thread, unless
+          // there turn out to be inline nodes to run already.
+          most_critical_expensive_node = &tagged_node;
+          continue;
+        }
+      }
+      prioritized_ready_.push(
+          {node_priorities_[item.node_id], next_prioritized_seq_++,
+           tagged_node});
+      ++num_to_dispatch;
+    }
+    if (most_critical_expensive_node && !inline_ready->empty()) {
+      prioritized_ready_.push(
+          {node_priorities_[most_critical_expensive_node->get_node_item()
+                                .node_id],
+           next_prioritized_seq_++, *most_critical_expensive_node});
+      ++num_to_dispatch;
+      most_critical_expensive_node = nullptr;
+    }
+  }
+  if (most_critical_expensive_node) {
+    inline_ready->push_back(*most_critical_expensive_node);
+  }
+  for (int i = 0; i < num_to_dispatch; ++i) {
+    runner_([this, scheduled_nsec]() {
+      Process(PopPrioritizedNode(), scheduled_nsec);
+    });
+  }
+}
+
+template <class PropagatorStateType>
+typename ExecutorState<PropagatorStateType>::TaggedNode
+ExecutorState<PropagatorStateType>::PopPrioritizedNode() {
+  mutex_lock l(prioritized_ready_mu_);
+  DCHECK(!prioritized_ready_.empty());
+  TaggedNode tagged_node = prioritized_ready_.top().node;
+  prioritized_ready_.pop();
+  return tagged_node;
+}
+
 template <class PropagatorStateType>
 void ExecutorState<PropagatorStateType>::ScheduleFinish() {
   // Checks condition to decide if needs to invoke Finish(). If there are
@@ -1305,11 +1644,14 @@ void ExecutorState<PropagatorStateType>::Finish() {
 
 void ExecutorImpl::RunAsync(const Args& args, DoneCallback done) {
   if (immutable_state_.requires_control_flow_support()) {
-    (new ExecutorState<PropagatorState>(args, immutable_state_, &kernel_stats_))
+    (new ExecutorState<PropagatorState>(args, immutable_state_, &kernel_stats_,
+                                        memory_planner_.get(), use_step_arena_))
         ->RunAsync(std::move(done));
   } else {
     (new ExecutorState<SimplePropagatorState>(args, immutable_state_,
-                                              &kernel_stats_))
+                                              &kernel_stats_,
+                                              memory_planner_.get(),
+                                              use_step_arena_))
         ->RunAsync(std::move(done));
   }
 }
@@ -1348,6 +1690,9 @@ class DefaultExecutorRegistrar {
     Factory* factory = new Factory;
     ExecutorFactory::Register("", factory);
     ExecutorFactory::Register("DEFAULT", factory);
+    ExecutorFactory::Register("PRIORITY", new PriorityFactory);
+    ExecutorFactory::Register("PLANNED_MEMORY", new PlannedMemoryFactory);
+    ExecutorFactory::Register("STEP_ARENA", new StepArenaFactory);
   }
 
  private:
@@ -1360,6 +1705,48 @@ class DefaultExecutorRegistrar {
       return Status::OK();
     }
   };
+
+  // Creates executors that dispatch ready nodes in critical-path order. See
+  // `LocalExecutorParams::prioritize_critical_path`.
+  class PriorityFactory : public ExecutorFactory {
+    Status NewExecutor(const LocalExecutorParams& params, const Graph& graph,
+                       std::unique_ptr<Executor>* out_executor) override {
+      LocalExecutorParams priority_params = params;
+      priority_params.prioritize_critical_path = true;
+      Executor* ret = nullptr;
+      TF_RETURN_IF_ERROR(NewLocalExecutor(priority_params, graph, &ret));
+      out_executor->reset(ret);
+      return Status::OK();
+    }
+  };
+
+  // Creates executors that plan the memory of step-local outputs. See
+  // `LocalExecutorParams::plan_memory`.
+  class PlannedMemoryFactory : public ExecutorFactory {
+    Status NewExecutor(const LocalExecutorParams& params, const Graph& graph,
+                       std::unique_ptr<Executor>* out_executor) override {
+      LocalExecutorParams planned_params = params;
+      planned_params.plan_memory = true;
+      Executor* ret = nullptr;
+      TF_RETURN_IF_ERROR(NewLocalExecutor(planned_params, graph, &ret));
+      out_executor->reset(ret);
+      return Status::OK();
+    }
+  };
+
+  // Creates executors that allocate step-local outputs from a per-step arena.
+  // See `LocalExecutorParams::use_step_arena`.
+  class StepArenaFactory : public ExecutorFactory {
+    Status NewExecutor(const LocalExecutorParams& params, const Graph& graph,
+                       std::unique_ptr<Executor>* out_executor) override {
+      LocalExecutorParams arena_params = params;
+      arena_params.use_step_arena = true;
+      Executor* ret = nullptr;
+      TF_RETURN_IF_ERROR(NewLocalExecutor(arena_params, graph, &ret));
+      out_executor->reset(ret);
+      return Status::OK();
+    }
+  };
 };
 static DefaultExecutorRegistrar registrar;
 
@@ -33,6 +33,10 @@ namespace tensorflow {
 
 class StepStatsCollector;
 
+namespace thread {
+class ThreadPool;
+}  // namespace thread
+
 // Executor runs a graph computation.
 // Example:
 //   Graph* graph = ...;
@@ -104,6 +108,10 @@ class Executor {
     typedef std::function<void(Closure)> Runner;
     Runner runner = nullptr;
 
+    // If not null, the thread pool that backs `runner`. The executor reads
+    // its queue depth to avoid dispatching work to a saturated pool.
+    thread::ThreadPool* runner_thread_pool = nullptr;
+
     // If true, all kernels will be treated as "inexpensive", and hence executed
     // on the scheduling thread.
     bool run_all_kernels_inline = false;
@@ -122,6 +130,11 @@ class Executor {
     n.WaitForNotification();
     return ret;
   }
+
+  // Re-reads the cost model that the executor was created with, if any, e.g.
+  // after new measurements were added to it. See
+  // `LocalExecutorParams::cost_model`.
+  virtual void UpdateCostEstimates() {}
 };
 
 // Creates an Executor that computes the given "graph".
@@ -16,6 +16,9 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/executor.h"
 
 #include <algorithm>
+#include <atomic>
+#include <map>
+#include <utility>
 
 #include "tensorflow/cc/framework/ops.h"
 #include "tensorflow/cc/ops/array_ops.h"
@@ -25,22 +28,27 @@ limitations under the License.
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/executor_factory.h"
 #include "tensorflow/core/common_runtime/graph_constructor.h"
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
 #include "tensorflow/core/common_runtime/lower_functional_ops.h"
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/rendezvous.h"
 #include "tensorflow/core/framework/step_stats.pb.h"
+#include "tensorflow/core/framework/tensor_description.pb.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/costmodel.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/notification.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/platform/tracing.h"
@@ -67,10 +75,14 @@ class ExecutorTest : public ::testing::Test {
   }
 
   // Resets executor_ with a new executor based on a graph 'gdef'.
-  void Create(std::unique_ptr<const Graph> graph) {
+  void Create(std::unique_ptr<const Graph> graph,
+              bool prioritize_critical_path = false,
+              const CostModel* cost_model = nullptr) {
     const int version = graph->versions().producer();
     LocalExecutorParams params;
     params.device = device_.get();
+    params.prioritize_critical_path = prioritize_critical_path;
+    params.cost_model = cost_model;
     params.create_kernel =
         [this, version](const std::shared_ptr<const NodeProperties>& props,
                         OpKernel** kernel) {
@@ -82,20 +94,28 @@ class ExecutorTest : public ::testing::Test {
     };
     rendez_ = NewLocalRendezvous();
     delete exec_;
-    TF_CHECK_OK(NewLocalExecutor(params, *graph, &exec_));
+    std::unique_ptr<Executor> executor;
+    TF_CHECK_OK(NewExecutor(executor_type_, params, *graph, &executor));
+    exec_ = executor.release();
+    // The executor reads the cost model of the graph again on
+    // `UpdateCostEstimates()`.
+    graph_ = std::move(graph);
     runner_ = [this](std::function<void()> fn) { thread_pool_->Schedule(fn); };
   }
 
-  Status Run(Rendezvous* rendez) {
+  Status Run(Rendezvous* rendez, bool collect_stats = true) {
     Executor::Args args;
     args.rendezvous = rendez;
-    args.stats_collector = &step_stats_collector_;
+    args.stats_collector = collect_stats ? &step_stats_collector_ : nullptr;
     args.runner = runner_;
     return exec_->Run(args);
   }
 
+  // The type of the executors created by `Create()`.
+  string executor_type_;
   thread::ThreadPool* thread_pool_ = nullptr;
   std::unique_ptr<Device> device_;
+  std::unique_ptr<const Graph> graph_;
   Executor* exec_ = nullptr;
   StepStatsCollector step_stats_collector_;
   StepStats step_stats_;
@@ -255,6 +275,277 @@ TEST_F(ExecutorTest, RandomTree) {
   EXPECT_EQ(4096.0, V(out));
 }
 
+TEST_F(ExecutorTest, RandomTreePrioritized) {
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  BuildTree(4096, g.get());
+  Create(std::move(g), /*prioritize_critical_path=*/true);
+  Rendezvous::Args args;
+  TF_ASSERT_OK(
+      rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out = V(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+  EXPECT_EQ(4096.0, V(out));
+}
+
+// Tests how the executor dispatches a graph where `kWidth` additions of the
+// input become ready at once, depending on what its cost model knows.
+class ExecutorCostModelTest : public ExecutorTest {
+ protected:
+  static constexpr int kWidth = 16;
+
+  // Returns a graph that sends the sum of `kWidth` additions a + a as "b".
+  static std::unique_ptr<Graph> BuildWideAdd() {
+    auto g = absl::make_unique<Graph>(OpRegistry::Global());
+    Node* in = test::graph::Recv(g.get(), "a", "float", ALICE, 1, BOB);
+    Node* sum = nullptr;
+    for (int i = 0; i < kWidth; ++i) {
+      Node* add = test::graph::Add(g.get(), in, in);
+      sum = sum == nullptr ? add : test::graph::Add(g.get(), sum, add);
+    }
+    test::graph::Send(g.get(), sum, "b", BOB, 1, ALICE);
+    return g;
+  }
+
+  // Records in `cost_model` that every op of `graph` ran once, in 1us.
+  static void RecordInexpensiveRun(const Graph& graph, CostModel* cost_model) {
+    for (const Node* n : graph.op_nodes()) {
+      cost_model->RecordCount(n, 1);
+      cost_model->RecordTime(n, Microseconds(1));
+    }
+  }
+
+  // Runs one step, and returns the number of closures passed to the runner.
+  int RunAndCountClosures() {
+    std::atomic<int> num_closures(0);
+    Executor::Args::Runner runner = runner_;
+    runner_ = [runner, &num_closures](std::function<void()> fn) {
+      ++num_closures;
+      runner(std::move(fn));
+    };
+    Rendezvous::Args args;
+    TF_CHECK_OK(rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args,
+                              V(1.0), false));
+    TF_CHECK_OK(Run(rendez_));
+    Tensor out = V(-1);
+    bool is_dead = false;
+    TF_CHECK_OK(rendez_->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out,
+                              &is_dead));
+    EXPECT_EQ(2.0 * kWidth, V(out));
+    runner_ = runner;
+    return num_closures;
+  }
+};
+
+constexpr int ExecutorCostModelTest::kWidth;
+
+TEST_F(ExecutorCostModelTest, FirstStepWithoutCostModel) {
+  // Every addition is expensive on the first step, and all but one are
+  // dispatched to the runner.
+  Create(BuildWideAdd());
+  EXPECT_GE(RunAndCountClosures(), kWidth - 1);
+}
+
+TEST_F(ExecutorCostModelTest, CostModelSeedsFirstStep) {
+  // A cost model that measured the additions as inexpensive makes the
+  // executor run them inline from the first step.
+  std::unique_ptr<Graph> g = BuildWideAdd();
+  CostModel cost_model(/*is_global=*/false);
+  cost_model.InitFromGraph(*g);
+  RecordInexpensiveRun(*g, &cost_model);
+  Create(std::move(g), /*prioritize_critical_path=*/false, &cost_model);
+  EXPECT_LT(RunAndCountClosures(), kWidth - 1);
+}
+
+TEST_F(ExecutorCostModelTest, UpdateCostEstimates) {
+  std::unique_ptr<Graph> g = BuildWideAdd();
+  const Graph* graph = g.get();
+  CostModel cost_model(/*is_global=*/false);
+  cost_model.InitFromGraph(*g);
+  Create(std::move(g), /*prioritize_critical_path=*/true, &cost_model);
+  // The cost model has no measurements yet.
+  EXPECT_GE(RunAndCountClosures(), kWidth - 1);
+
+  RecordInexpensiveRun(*graph, &cost_model);
+  exec_->UpdateCostEstimates();
+  EXPECT_LT(RunAndCountClosures(), kWidth - 1);
+}
+
+class ExecutorPlannedMemoryTest : public ExecutorTest {
+ protected:
+  static constexpr int kDepth = 8;
+
+  ExecutorPlannedMemoryTest() { executor_type_ = "PLANNED_MEMORY"; }
+
+  // Returns a graph that sends "a" doubled `kDepth` times as "b".
+  static std::unique_ptr<Graph> BuildAddChain() {
+    auto g = absl::make_unique<Graph>(OpRegistry::Global());
+    Node* sum = test::graph::Recv(g.get(), "a", "float", ALICE, 1, BOB);
+    for (int i = 0; i < kDepth; ++i) {
+      sum = test::graph::Add(g.get(), sum, sum);
+    }
+    test::graph::Send(g.get(), sum, "b", BOB, 1, ALICE);
+    return g;
+  }
+
+  // Runs one step on `num_elements` ones, without collecting statistics,
+  // which would bypass the plan, and checks the result.
+  void RunAndCheck(int num_elements) {
+    Tensor in(DT_FLOAT, TensorShape({num_elements}));
+    in.flat<float>().setConstant(1.0f);
+    Rendezvous::Args args;
+    TF_ASSERT_OK(
+        rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, in, false));
+    TF_ASSERT_OK(Run(rendez_, /*collect_stats=*/false));
+    Tensor out;
+    bool is_dead = false;
+    TF_ASSERT_OK(rendez_->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out,
+                               &is_dead));
+    Tensor expected(DT_FLOAT, TensorShape({num_elements}));
+    expected.flat<float>().setConstant(1 << kDepth);
+    test::ExpectTensorEqual<float>(expected, out);
+  }
+
+  static int64 NumPlannedAllocations() {
+    return metrics::GetPlannedMemoryAllocationsCounter("planned")->value();
+  }
+  static int64 NumFallbackAllocations() {
+    return metrics::GetPlannedMemoryAllocationsCounter("fallback")->value();
+  }
+};
+
+constexpr int ExecutorPlannedMemoryTest::kDepth;
+
+TEST_F(ExecutorPlannedMemoryTest, AllocatesFromSlab) {
+  Create(BuildAddChain());
+  const int64 planned_before = NumPlannedAllocations();
+  const int64 fallback_before = NumFallbackAllocations();
+  const int64 slab_bytes_before =
+      metrics::GetMemoryPlanBytesCounter("slab")->value();
+  const int64 output_bytes_before =
+      metrics::GetMemoryPlanBytesCounter("outputs")->value();
+
+  // The size of the received tensor is unknown until the first step, which
+  // records the output sizes the plan is built from.
+  RunAndCheck(64);
+  constexpr int64 kOutputBytes = 64 * sizeof(float);
+  EXPECT_EQ(NumPlannedAllocations(), planned_before);
+  // All but the last addition, whose output is sent, are planned. Each of them
+  // only overlaps with its neighbours in the chain, so the plan places them in
+  // two slots.
+  EXPECT_EQ(metrics::GetMemoryPlanBytesCounter("outputs")->value() -
+                output_bytes_before,
+            (kDepth - 1) * kOutputBytes);
+  EXPECT_EQ(metrics::GetMemoryPlanBytesCounter("slab")->value() -
+                slab_bytes_before,
+            2 * kOutputBytes);
+
+  // Later steps allocate the planned outputs from a slab that is released
+  // and reused from step to step.
+  constexpr int kNumSteps = 3;
+  for (int i = 0; i < kNumSteps; ++i) {
+    RunAndCheck(64);
+  }
+  EXPECT_EQ(NumPlannedAllocations() - planned_before,
+            kNumSteps * (kDepth - 1));
+  EXPECT_EQ(NumFallbackAllocations(), fallback_before);
+}
+
+TEST_F(ExecutorPlannedMemoryTest, FallsBackForLargerOutputs) {
+  Create(BuildAddChain());
+  RunAndCheck(64);
+  const int64 planned_before = NumPlannedAllocations();
+  const int64 fallback_before = NumFallbackAllocations();
+
+  // Outputs that don't fit the plan are allocated by the device allocator.
+  RunAndCheck(256);
+  EXPECT_EQ(NumPlannedAllocations(), planned_before);
+  EXPECT_EQ(NumFallbackAllocations() - fallback_before, kDepth - 1);
+
+  // Smaller outputs still fit.
+  RunAndCheck(16);
+  EXPECT_EQ(NumPlannedAllocations() - planned_before, kDepth - 1);
+}
+
+TEST_F(ExecutorPlannedMemoryTest, CollectingStatsBypassesPlan) {
+  Create(BuildAddChain());
+  RunAndCheck(64);
+  const int64 planned_before = NumPlannedAllocations();
+  const int64 fallback_before = NumFallbackAllocations();
+
+  Tensor in(DT_FLOAT, TensorShape({64}));
+  in.flat<float>().setConstant(1.0f);
+  Rendezvous::Args args;
+  TF_ASSERT_OK(
+      rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, in, false));
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out;
+  bool is_dead = false;
+  TF_ASSERT_OK(rendez_->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out,
+                             &is_dead));
+  EXPECT_EQ(out.flat<float>()(0), 1 << kDepth);
+  EXPECT_EQ(NumPlannedAllocations(), planned_before);
+  EXPECT_EQ(NumFallbackAllocations(), fallback_before);
+}
+
+class ExecutorStepArenaTest : public ExecutorTest {
+ protected:
+  ExecutorStepArenaTest() { executor_type_ = "STEP_ARENA"; }
+
+  // Returns the name of the allocator of output 0 of node `node_name` in the
+  // last step, or an empty string if the step did not record it.
+  string OutputAllocatorName(const string& node_name) {
+    step_stats_collector_.Finalize();
+    for (const auto& dev_stats : step_stats_.dev_stats()) {
+      for (const auto& node_stats : dev_stats.node_stats()) {
+        if (node_stats.node_name() == node_name &&
+            node_stats.output_size() > 0) {
+          return node_stats.output(0)
+              .tensor_description()
+              .allocation_description()
+              .allocator_name();
+        }
+      }
+    }
+    return "";
+  }
+};
+
+TEST_F(ExecutorStepArenaTest, EscapingOutputIsCopiedOutOfArena) {
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  Node* in = test::graph::Recv(g.get(), "a", "float", ALICE, 1, BOB);
+  Node* sum = test::graph::Add(g.get(), in, in);
+  Node* shape = test::graph::Constant(g.get(), test::AsTensor<int32>({2, 8}));
+  // The reshape shares the buffer of the sum, and is sent out of the step.
+  Node* reshape = test::graph::Binary(g.get(), "Reshape", sum, shape);
+  test::graph::Send(g.get(), reshape, "b", BOB, 1, ALICE);
+  Create(std::move(g));
+
+  Tensor a(DT_FLOAT, TensorShape({16}));
+  a.flat<float>().setConstant(1.0f);
+  Rendezvous::Args args;
+  TF_ASSERT_OK(rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, a,
+                             false));
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out;
+  bool is_dead = false;
+  TF_ASSERT_OK(rendez_->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out,
+                             &is_dead));
+  Tensor expected(DT_FLOAT, TensorShape({2, 8}));
+  expected.flat<float>().setConstant(2.0f);
+  test::ExpectTensorEqual<float>(expected, out);
+
+  // The sum is step-local and comes from the arena, but the tensor that left
+  // the step does not share its buffer.
+  EXPECT_EQ("step_arena", OutputAllocatorName(sum->name()));
+  TensorDescription description;
+  out.FillDescription(&description);
+  EXPECT_NE("step_arena",
+            description.allocation_description().allocator_name());
+}
+
 void BuildConcurrentAddAssign(Graph* g) {
   auto one = test::graph::Constant(g, V(1.0));
   // A variable holds one float.
@@ -430,6 +721,41 @@ TEST_F(ExecutorTest, NoInputTensors) {
   TF_ASSERT_OK(Run(rendez_));
 }
 
+TEST_F(ExecutorTest, SaturatedRunnerInlinesOneExpensiveNode) {
+  // 'kWidth' expensive nodes become ready together once the constant is done.
+  constexpr int kWidth = 8;
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  Tensor m(DT_FLOAT, TensorShape({16, 16}));
+  m.flat<float>().setConstant(1.0f);
+  Node* in = test::graph::Constant(g.get(), m);
+  for (int i = 0; i < kWidth; ++i) {
+    test::graph::Matmul(g.get(), in, in, false, false);
+  }
+  Create(std::move(g));
+
+  // The pool reported as backing the runner has its only thread blocked and
+  // one more closure queued, so it looks saturated throughout the step.
+  thread::ThreadPool saturated_pool(Env::Default(), "saturated", 1);
+  Notification unblock;
+  for (int i = 0; i < 2; ++i) {
+    saturated_pool.Schedule([&unblock] { unblock.WaitForNotification(); });
+  }
+
+  std::atomic<int> num_dispatched(0);
+  Executor::Args args;
+  args.rendezvous = rendez_;
+  args.runner = [this, &num_dispatched](std::function<void()> fn) {
+    ++num_dispatched;
+    thread_pool_->Schedule(std::move(fn));
+  };
+  args.runner_thread_pool = &saturated_pool;
+  TF_EXPECT_OK(exec_->Run(args));
+  unblock.Notify();
+  // The constant is dispatched, and so is every expensive node but the one
+  // run inline.
+  EXPECT_GE(num_dispatched, kWidth);
+}
+
 // Create a graph that is 'depth' deep. At each level, fan-in and fan-out a
 // maximum of 'width' nodes. All nodes are no-ops and all dependencies are
 // control dependencies.
@@ -486,6 +812,190 @@ BENCHMARK(BM_executor)->ArgPair(8192, 32);
 // Tall fat graph
 BENCHMARK(BM_executor)->ArgPair(1024, 1024);
 
+// Create a graph with a chain of 'depth' matrix multiplications (the critical
+// path), where the first node of the chain also fans out to 'width' independent
+// matrix multiplications that are not on the critical path. With FIFO
+// dispatch the off-path nodes delay the chain; with the "PRIORITY" executor the
+// chain is dispatched first.
+//
+// The FIFO benchmarks record their step time, so that the prioritized
+// benchmarks run after them can report their speedup in their label.
+static std::map<std::pair<int, int>, double>* FanOutFifoStepMicros() {
+  static auto* step_micros = new std::map<std::pair<int, int>, double>;
+  return step_micros;
+}
+
+static void BM_FanOutCriticalPathHelper(int iters, int width, int depth,
+                                        const char* executor_type) {
+  testing::StopTiming();
+#ifdef PLATFORM_GOOGLE
+  BenchmarkUseRealTime();
+#endif  // PLATFORM_GOOGLE
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor m(DT_FLOAT, TensorShape({128, 128}));
+  m.flat<float>().setConstant(1.0f / 128);
+  Node* in = test::graph::Constant(g, m);
+  Node* head = test::graph::Matmul(g, in, in, false, false);
+  for (int i = 0; i < width; ++i) {
+    test::graph::Matmul(g, head, in, false, false);
+  }
+  Node* chain = head;
+  for (int i = 0; i < depth; ++i) {
+    chain = test::graph::Matmul(g, chain, in, false, false);
+  }
+#ifdef PLATFORM_GOOGLE
+  SetBenchmarkItemsProcessed(static_cast<int64>(iters));
+#endif  // PLATFORM_GOOGLE
+  FixupSourceAndSinkEdges(g);
+  test::Benchmark benchmark("cpu", g, nullptr, nullptr, nullptr, executor_type);
+  const uint64 start_us = Env::Default()->NowMicros();
+  benchmark.Run(iters);
+  const double step_us =
+      static_cast<double>(Env::Default()->NowMicros() - start_us) / iters;
+
+  string label = strings::StrCat("Nodes = ", 2 + width + depth,
+                                 ", step = ", step_us, "us");
+  if (executor_type[0] == '\0') {
+    (*FanOutFifoStepMicros())[{width, depth}] = step_us;
+  } else {
+    auto it = FanOutFifoStepMicros()->find({width, depth});
+    if (it != FanOutFifoStepMicros()->end()) {
+      strings::StrAppend(&label, ", FIFO step = ", it->second,
+                         "us, speedup = ", it->second / step_us, "x");
+    }
+  }
+  testing::SetLabel(label);
+}
+
+static void BM_FanOutCriticalPath(int iters, int width, int depth) {
+  BM_FanOutCriticalPathHelper(iters, width, depth, "");
+}
+BENCHMARK(BM_FanOutCriticalPath)->ArgPair(64, 16);
+BENCHMARK(BM_FanOutCriticalPath)->ArgPair(256, 64);
+BENCHMARK(BM_FanOutCriticalPath)->ArgPair(1024, 64);
+
+static void BM_FanOutCriticalPathPrioritized(int iters, int width, int depth) {
+  BM_FanOutCriticalPathHelper(iters, width, depth, "PRIORITY");
+}
+BENCHMARK(BM_FanOutCriticalPathPrioritized)->ArgPair(64, 16);
+BENCHMARK(BM_FanOutCriticalPathPrioritized)->ArgPair(256, 64);
+BENCHMARK(BM_FanOutCriticalPathPrioritized)->ArgPair(1024, 64);
+
+// Create a graph with a chain of 'depth' matrix multiplications of 'size' x
+// 'size' matrices, and run it on the executor of type 'executor_type'. Each
+// product only lives until the next one is computed, so the "PLANNED_MEMORY"
+// executor places all but the last of them in a slab of two products. Its
+// label reports how many of the planned allocations per step were served from
+// the slab, and the bytes of the planned outputs and of the slab.
+static void BM_MatMulChainHelper(int iters, int size, int depth,
+                                 const char* executor_type) {
+  testing::StopTiming();
+#ifdef PLATFORM_GOOGLE
+  BenchmarkUseRealTime();
+#endif  // PLATFORM_GOOGLE
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor m(DT_FLOAT, TensorShape({size, size}));
+  m.flat<float>().setConstant(1.0f / size);
+  Node* in = test::graph::Constant(g, m);
+  Node* chain = in;
+  for (int i = 0; i < depth; ++i) {
+    chain = test::graph::Matmul(g, chain, in, false, false);
+  }
+#ifdef PLATFORM_GOOGLE
+  SetBenchmarkItemsProcessed(static_cast<int64>(iters));
+#endif  // PLATFORM_GOOGLE
+  FixupSourceAndSinkEdges(g);
+  monitoring::CounterCell* planned =
+      metrics::GetPlannedMemoryAllocationsCounter("planned");
+  monitoring::CounterCell* fallback =
+      metrics::GetPlannedMemoryAllocationsCounter("fallback");
+  monitoring::CounterCell* output_bytes =
+      metrics::GetMemoryPlanBytesCounter("outputs");
+  monitoring::CounterCell* slab_bytes =
+      metrics::GetMemoryPlanBytesCounter("slab");
+  const int64 output_bytes_before = output_bytes->value();
+  const int64 slab_bytes_before = slab_bytes->value();
+  test::Benchmark benchmark("cpu", g, nullptr, nullptr, nullptr, executor_type);
+  const int64 planned_before = planned->value();
+  const int64 fallback_before = fallback->value();
+  const uint64 start_us = Env::Default()->NowMicros();
+  benchmark.Run(iters);
+  const double step_us =
+      static_cast<double>(Env::Default()->NowMicros() - start_us) / iters;
+
+  string label = strings::StrCat("Nodes = ", 1 + depth, ", step = ", step_us,
+                                 "us, unplanned outputs = ",
+                                 depth * m.TotalBytes(), " bytes");
+  const int64 num_planned = planned->value() - planned_before;
+  const int64 num_fallback = fallback->value() - fallback_before;
+  if (num_planned + num_fallback > 0) {
+    strings::StrAppend(
+        &label, ", planned = ", output_bytes->value() - output_bytes_before,
+        " bytes in a slab of ", slab_bytes->value() - slab_bytes_before,
+        " bytes, slab allocations = ", num_planned, "/",
+        num_planned + num_fallback);
+  }
+  testing::SetLabel(label);
+}
+
+static void BM_MatMulChain(int iters, int size, int depth) {
+  BM_MatMulChainHelper(iters, size, depth, "");
+}
+BENCHMARK(BM_MatMulChain)->ArgPair(16, 64);
+BENCHMARK(BM_MatMulChain)->ArgPair(128, 64);
+BENCHMARK(BM_MatMulChain)->ArgPair(512, 16);
+
+static void BM_MatMulChainPlannedMemory(int iters, int size, int depth) {
+  BM_MatMulChainHelper(iters, size, depth, "PLANNED_MEMORY");
+}
+BENCHMARK(BM_MatMulChainPlannedMemory)->ArgPair(16, 64);
+BENCHMARK(BM_MatMulChainPlannedMemory)->ArgPair(128, 64);
+BENCHMARK(BM_MatMulChainPlannedMemory)->ArgPair(512, 16);
+
+static void BM_MatMulChainStepArena(int iters, int size, int depth) {
+  BM_MatMulChainHelper(iters, size, depth, "STEP_ARENA");
+}
+BENCHMARK(BM_MatMulChainStepArena)->ArgPair(16, 64);
+BENCHMARK(BM_MatMulChainStepArena)->ArgPair(128, 64);
+BENCHMARK(BM_MatMulChainStepArena)->ArgPair(512, 16);
+
+// Create a graph with 'width' independent expensive matrix multiplications and
+// 'width' independent chains of 'num_inexpensive' scalar additions, all ready
+// at the start of the step. This exercises the executor's choice between running
+// nodes inline and dispatching them to the thread pool.
+static void BM_MixedInexpensiveExpensive(int iters, int width,
+                                         int num_inexpensive) {
+  testing::StopTiming();
+#ifdef PLATFORM_GOOGLE
+  BenchmarkUseRealTime();
+#endif  // PLATFORM_GOOGLE
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor m(DT_FLOAT, TensorShape({128, 128}));
+  m.flat<float>().setConstant(1.0f / 128);
+  Node* in = test::graph::Constant(g, m);
+  Node* one = test::graph::Constant(g, V(1.0));
+  for (int i = 0; i < width; ++i) {
+    test::graph::Matmul(g, in, in, false, false);
+    Node* sum = one;
+    for (int j = 0; j < num_inexpensive; ++j) {
+      sum = test::graph::Add(g, sum, one);
+    }
+  }
+#ifdef PLATFORM_GOOGLE
+  SetBenchmarkLabel(
+      strings::StrCat("Nodes = ", 2 + width * (1 + num_inexpensive)));
+  SetBenchmarkItemsProcessed(static_cast<int64>(iters));
+#endif  // PLATFORM_GOOGLE
+  FixupSourceAndSinkEdges(g);
+  testing::StartTiming();
+  test::Benchmark("cpu", g).Run(iters);
+}
+
+BENCHMARK(BM_MixedInexpensiveExpensive)->ArgPair(16, 1);
+BENCHMARK(BM_MixedInexpensiveExpensive)->ArgPair(16, 16);
+BENCHMARK(BM_MixedInexpensiveExpensive)->ArgPair(256, 1);
+BENCHMARK(BM_MixedInexpensiveExpensive)->ArgPair(256, 16);
+
 static void BM_const_identity(int iters, int width, int outputs_per_const) {
 #ifdef PLATFORM_GOOGL
   BenchmarkUseRealTime();
@@ -674,11 +1184,13 @@ BENCHMARK(BM_LoweredWhileLoop)
     ->ArgPair(10, 1)
     ->ArgPair(100, 1)
     ->ArgPair(1000, 1)
+    ->ArgPair(10000, 1)
     ->ArgPair(0, 100)
     ->ArgPair(1, 100)
     ->ArgPair(10, 100)
     ->ArgPair(100, 100)
-    ->ArgPair(1000, 100);
+    ->ArgPair(1000, 100)
+    ->ArgPair(10000, 100);
 
 static void BM_FunctionalWhileLoop(int iters, int loop_iters, int loop_vars) {
   BM_WhileLoopHelper(iters, loop_iters, loop_vars, /* lower= */ false);
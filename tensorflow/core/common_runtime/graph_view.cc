@@ -399,6 +399,43 @@ Status InferAllocAttr(const Node* n, const Node* dst,
   }
   return s;
 }
+
+// Returns true if `n` may keep one of its inputs alive beyond the current
+// step, by storing it in a resource or passing it out of the step. Identity
+// nodes forward their input buffer, so their consumers are examined instead.
+bool MayRetainInput(const Node* n, int depth) {
+  if (n->IsSend() || n->IsRetval() || n->op_def().is_stateful()) return true;
+  if (!n->IsIdentity()) return false;
+  if (depth == 0) return true;
+  for (const Edge* e : n->out_edges()) {
+    if (!e->IsControlEdge() && MayRetainInput(e->dst(), depth - 1)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Returns true if output `output_index` of `n` is known to die within the
+// step that produced it. A kernel may still forward or alias such a tensor
+// into an output that escapes; the executor copies that output out of the
+// step's arena, and an allocation that escapes anyway keeps its arena alive.
+bool IsStepLocalOutput(const Node* n, int output_index,
+                       const AllocatorAttributes& attr) {
+  if (!n->IsOp() || n->op_def().is_stateful()) return false;
+  if (attr.nic_compatible() || attr.gpu_compatible() || attr.scope_id != 0) {
+    return false;
+  }
+  // Strings, variants and resources own memory outside of the tensor buffer.
+  if (!DataTypeCanUseMemcpy(n->output_type(output_index))) return false;
+  constexpr int kMaxIdentityDepth = 4;
+  for (const Edge* e : n->out_edges()) {
+    if (e->src_output() == output_index &&
+        MayRetainInput(e->dst(), kMaxIdentityDepth)) {
+      return false;
+    }
+  }
+  return true;
+}
 }  // namespace
 
 Status GraphView::SetAllocAttrs(const Graph* g, const Device* device) {
@@ -435,6 +472,10 @@ Status GraphView::SetAllocAttrs(const Graph* g, const Device* device) {
         h.set_on_host(on_host);
         attrs[out].Merge(h);
       }
+      if (local_dev_name.type == "CPU" &&
+          IsStepLocalOutput(n, out, attrs[out])) {
+        attrs[out].set_step_local(true);
+      }
     }
   }
   SetScopedAllocatorAttrs(scoped_allocator_instances);
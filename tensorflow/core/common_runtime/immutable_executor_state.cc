@@ -19,6 +19,8 @@ limitations under the License.
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/costmodel.h"
 #include "tensorflow/core/graph/edgeset.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/graph_node_util.h"
@@ -257,6 +259,9 @@ Status ImmutableExecutorState::Initialize(const Graph& graph) {
   // Initialize PendingCounts only after pending_ids_[node.id] is initialized
   // for all nodes.
   InitializePending(&graph, cf_info);
+  if (params_.prioritize_critical_path) {
+    UpdateNodePriorities(graph);
+  }
   return gview_.SetAllocAttrs(&graph, params_.device);
 }
 
@@ -372,4 +377,36 @@ void ImmutableExecutorState::InitializePending(const Graph* graph,
     }
   }
 }
+
+void ImmutableExecutorState::UpdateNodePriorities(const Graph& graph) {
+  const CostModel* cost_model = params_.cost_model;
+  auto node_priorities =
+      std::make_shared<std::vector<int64>>(gview_.num_nodes(), 0);
+
+  // Ignore the back edges of loops, so that every node is visited after all of
+  // its successors.
+  std::vector<Node*> post_order;
+  GetPostOrder(graph, &post_order, NodeComparatorName(),
+               [](const Edge& e) { return !e.src()->IsNextIteration(); });
+
+  for (const Node* n : post_order) {
+    if (IsSink(n)) continue;
+    int64 max_successor_priority = 0;
+    if (!n->IsNextIteration()) {
+      for (const Edge* e : n->out_edges()) {
+        max_successor_priority = std::max(max_successor_priority,
+                                          (*node_priorities)[e->dst()->id()]);
+      }
+    }
+    int64 cost = 1;
+    if (cost_model != nullptr && n->IsOp()) {
+      cost = std::max<int64>(1, cost_model->TimeEstimate(n).value());
+    }
+    (*node_priorities)[n->id()] = cost + max_successor_priority;
+  }
+
+  mutex_lock l(node_priorities_mu_);
+  node_priorities_ = std::move(node_priorities);
+}
+
 }  // namespace tensorflow
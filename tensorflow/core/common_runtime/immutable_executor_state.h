@@ -29,6 +29,8 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/flatmap.h"
 #include "tensorflow/core/lib/gtl/flatset.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
@@ -101,6 +103,22 @@ class ImmutableExecutorState {
 
   bool requires_control_flow_support() const { return requires_control_flow_; }
 
+  // Returns the static dispatch priority of each node, indexed by node ID, or
+  // nullptr if `params().prioritize_critical_path` is false. A node with a
+  // larger value lies on a longer (more critical) path to the sink.
+  std::shared_ptr<const std::vector<int64>> node_priorities() const {
+    if (!params_.prioritize_critical_path) return nullptr;
+    tf_shared_lock l(node_priorities_mu_);
+    return node_priorities_;
+  }
+
+  // Recomputes the node priorities from the current time estimates of
+  // `params().cost_model`, e.g. after it was updated with new measurements.
+  // Steps that are already running keep the priorities they started with.
+  //
+  // REQUIRES: `graph` is the graph that this state was initialized from.
+  void UpdateNodePriorities(const Graph& graph);
+
   // Copies the pending counts for nodes in this graph to the given array.
   //
   // This method provides a more efficient way of initializing
@@ -152,6 +170,12 @@ class ImmutableExecutorState {
   // pending counts for the nodes in the graph, indexed by node ID.
   std::unique_ptr<std::atomic<int32>[]> atomic_pending_counts_;
 
+  // If `params_.prioritize_critical_path` is true, the length of the longest
+  // path from each node to the sink, indexed by node ID.
+  mutable mutex node_priorities_mu_;
+  std::shared_ptr<const std::vector<int64>> node_priorities_
+      TF_GUARDED_BY(node_priorities_mu_);
+
   // Shallow copies of the constant tensors used in the graph.
   std::vector<Tensor> const_tensors_;
 
@@ -164,6 +164,7 @@ void Benchmark::RunWithRendezvousArgs(
   args.runner = [this](std::function<void()> closure) {
     pool_->Schedule(closure);
   };
+  args.runner_thread_pool = pool_;
   static const int kWarmupRuns = 3;
   for (int i = 0; i < kWarmupRuns; ++i) {
     for (const auto& p : inputs) {
@@ -21,6 +21,7 @@ limitations under the License.
 
 namespace tensorflow {
 
+class CostModel;
 class Device;
 class StepStatsCollector;
 class SessionMetadata;
@@ -47,6 +48,36 @@ struct LocalExecutorParams {
                        OpKernel**)>
       create_kernel;
   std::function<void(OpKernel*)> delete_kernel;
+
+  // If true, the executor computes a static priority for every node (the
+  // length of the longest path from the node to the sink) and dispatches
+  // ready nodes in decreasing order of priority instead of FIFO order, so
+  // that work on the critical path is not starved by off-path work.
+  bool prioritize_critical_path = false;
+
+  // If not null, the time estimates from this cost model seed the executor's
+  // estimates of which kernels are inexpensive enough to run inline, and
+  // weight the paths when `prioritize_critical_path` is true. Otherwise every
+  // kernel starts out expensive, and the priority of a node is its depth from
+  // the sink.
+  //
+  // The executor reads the cost model when it is created, and again on each
+  // call to `Executor::UpdateCostEstimates()`, which the owner of the cost
+  // model should make after updating it. Both the cost model and the graph
+  // that the executor is created from must then outlive the executor, and
+  // must not be modified during these calls.
+  const CostModel* cost_model = nullptr;
+
+  // If true and the device is a CPU, the executor plans the memory of the
+  // step-local outputs of the graph ahead of time, and serves their
+  // allocations from one slab per step. See `MemoryPlanner`.
+  bool plan_memory = false;
+
+  // If true and the device is a CPU, each step allocates the step-local
+  // outputs of the graph that are not planned from a `StepArenaAllocator`,
+  // which it frees in bulk when the step is done. Also enabled for every
+  // executor by setting the environment variable TF_CPU_USE_STEP_ARENA.
+  bool use_step_arena = false;
 };
 
 }  // end namespace tensorflow
@@ -0,0 +1,448 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/memory_planner.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+
+#include "tensorflow/core/framework/metrics.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/shape_inference.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+namespace {
+
+// The reachability matrix takes num_nodes^2 bits, so larger graphs are not
+// planned.
+constexpr int kMaxNodes = 8192;
+
+int64 RoundUpToAlignment(int64 bytes) {
+  constexpr int64 kAlignment = Allocator::kAllocatorAlignment;
+  return (bytes + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+// Returns true if output 0 of `node` may share the buffer of its input 0, so
+// that the consumers of the output also keep the input alive.
+bool ForwardsInput(const Node* node) {
+  return node->IsIdentity() || node->type_string() == "Reshape";
+}
+
+}  // namespace
+
+class MemoryPlanSlab::OutputAllocator : public Allocator {
+ public:
+  OutputAllocator(MemoryPlanSlab* slab, int64 index)
+      : slab_(slab), index_(index) {}
+
+  string Name() override { return "memory_plan_slab"; }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    return slab_->Allocate(index_, alignment, num_bytes);
+  }
+
+  void DeallocateRaw(void* ptr) override { slab_->Deallocate(index_, ptr); }
+
+ private:
+  MemoryPlanSlab* const slab_;
+  const int64 index_;
+};
+
+MemoryPlanSlab::MemoryPlanSlab(std::shared_ptr<const MemoryPlan> plan,
+                               Allocator* base)
+    : plan_(std::move(plan)), base_(base), live_(plan_->offsets.size()) {
+  if (plan_->slab_bytes > 0) {
+    data_ = static_cast<char*>(
+        base_->AllocateRaw(Allocator::kAllocatorAlignment, plan_->slab_bytes));
+  }
+  const int64 num_outputs = plan_->offsets.size();
+  output_allocators_.resize(num_outputs);
+  output_allocator_ptrs_.resize(num_outputs, nullptr);
+  // If the slab could not be allocated every request goes to `base_`.
+  if (data_ == nullptr) return;
+  for (int64 i = 0; i < num_outputs; ++i) {
+    if (plan_->offsets[i] >= 0) {
+      output_allocators_[i].reset(new OutputAllocator(this, i));
+      output_allocator_ptrs_[i] = output_allocators_[i].get();
+    }
+  }
+}
+
+MemoryPlanSlab::~MemoryPlanSlab() {
+  if (data_ != nullptr) {
+    base_->DeallocateRaw(data_);
+  }
+}
+
+void MemoryPlanSlab::ResetCounters() {
+  num_planned_allocations_ = 0;
+  num_fallback_allocations_ = 0;
+}
+
+void* MemoryPlanSlab::Allocate(int64 index, size_t alignment,
+                               size_t num_bytes) {
+  Ref();
+  void* ptr = nullptr;
+  if (alignment <= Allocator::kAllocatorAlignment &&
+      num_bytes <= static_cast<size_t>(plan_->sizes[index])) {
+    mutex_lock l(mu_);
+    bool available = !live_[index];
+    for (int64 other : plan_->overlaps[index]) {
+      if (!available) break;
+      available = !live_[other];
+    }
+    if (available) {
+      live_[index] = true;
+      ptr = data_ + plan_->offsets[index];
+    }
+  }
+  if (ptr != nullptr) {
+    ++num_planned_allocations_;
+    return ptr;
+  }
+  ++num_fallback_allocations_;
+  ptr = base_->AllocateRaw(alignment, num_bytes);
+  if (ptr == nullptr) {
+    Unref();
+  }
+  return ptr;
+}
+
+void MemoryPlanSlab::Deallocate(int64 index, void* ptr) {
+  if (ptr == data_ + plan_->offsets[index]) {
+    mutex_lock l(mu_);
+    live_[index] = false;
+  } else {
+    base_->DeallocateRaw(ptr);
+  }
+  Unref();
+}
+
+std::unique_ptr<MemoryPlanner> MemoryPlanner::Create(
+    const Graph& graph, const CandidateFn& is_candidate, Allocator* base) {
+  if (graph.num_node_ids() > kMaxNodes) {
+    VLOG(1) << "Not planning memory for a graph of " << graph.num_node_ids()
+            << " nodes";
+    return nullptr;
+  }
+  for (const Node* n : graph.nodes()) {
+    if (n->IsEnter() || n->IsExit() || n->IsNextIteration()) {
+      VLOG(1) << "Not planning memory for a graph with loops";
+      return nullptr;
+    }
+  }
+  std::unique_ptr<MemoryPlanner> planner(
+      new MemoryPlanner(graph, is_candidate, base));
+  if (planner->num_outputs() == 0) {
+    return nullptr;
+  }
+  planner->AnalyzeLifetimes(graph);
+  std::vector<int64> sizes = planner->InferOutputSizes(graph);
+  if (!sizes.empty()) {
+    planner->RecordOutputSizes(sizes);
+  }
+  return planner;
+}
+
+MemoryPlanner::MemoryPlanner(const Graph& graph,
+                             const CandidateFn& is_candidate, Allocator* base)
+    : base_(base),
+      num_nodes_(graph.num_node_ids()),
+      words_per_node_((num_nodes_ + 63) / 64),
+      node_base_(num_nodes_, -1) {
+  for (const Node* n : graph.nodes()) {
+    bool has_candidate = false;
+    for (int i = 0; i < n->num_outputs() && !has_candidate; ++i) {
+      has_candidate = is_candidate(n, i);
+    }
+    if (!has_candidate) continue;
+    node_base_[n->id()] = producer_.size();
+    for (int i = 0; i < n->num_outputs(); ++i) {
+      is_candidate_.push_back(is_candidate(n, i));
+      producer_.push_back(n->id());
+    }
+  }
+}
+
+MemoryPlanner::~MemoryPlanner() {
+  for (MemoryPlanSlab* slab : free_slabs_) {
+    slab->Unref();
+  }
+}
+
+void MemoryPlanner::AnalyzeLifetimes(const Graph& graph) {
+  // A node reaches every node that one of its successors reaches. The post
+  // order visits every node after all of its successors.
+  std::vector<Node*> post_order;
+  GetPostOrder(graph, &post_order);
+  reachable_.assign(num_nodes_ * words_per_node_, 0);
+  for (const Node* n : post_order) {
+    uint64* row = &reachable_[n->id() * words_per_node_];
+    for (const Node* out : n->out_nodes()) {
+      const uint64* out_row = &reachable_[out->id() * words_per_node_];
+      for (int64 w = 0; w < words_per_node_; ++w) {
+        row[w] |= out_row[w];
+      }
+      row[out->id() / 64] |= uint64{1} << (out->id() % 64);
+    }
+  }
+
+  users_.resize(producer_.size());
+  for (const Node* n : graph.nodes()) {
+    const int64 base = node_base_[n->id()];
+    if (base < 0) continue;
+    for (int64 i = base; i < base + n->num_outputs(); ++i) {
+      users_[i].push_back(n->id());
+    }
+    for (const Edge* e : n->out_edges()) {
+      if (e->IsControlEdge()) continue;
+      std::vector<int>& users = users_[base + e->src_output()];
+      // Follow the chains of nodes that may forward the buffer.
+      std::vector<const Edge*> stack = {e};
+      while (!stack.empty()) {
+        const Edge* edge = stack.back();
+        stack.pop_back();
+        const Node* dst = edge->dst();
+        users.push_back(dst->id());
+        if (edge->dst_input() != 0 || !ForwardsInput(dst)) continue;
+        for (const Edge* next : dst->out_edges()) {
+          if (!next->IsControlEdge() && next->src_output() == 0) {
+            stack.push_back(next);
+          }
+        }
+      }
+    }
+  }
+}
+
+bool MemoryPlanner::Reaches(int from, int to) const {
+  return (reachable_[from * words_per_node_ + to / 64] >> (to % 64)) & 1;
+}
+
+bool MemoryPlanner::Interferes(int64 a, int64 b) const {
+  auto dead_before = [this](int64 first, int64 second) {
+    const int producer = producer_[second];
+    for (int user : users_[first]) {
+      if (!Reaches(user, producer)) return false;
+    }
+    return true;
+  };
+  return !dead_before(a, b) && !dead_before(b, a);
+}
+
+std::vector<int64> MemoryPlanner::InferOutputSizes(const Graph& graph) const {
+  std::vector<Node*> order;
+  GetReversePostOrder(graph, &order);
+  std::vector<std::vector<PartialTensorShape>> shapes(num_nodes_);
+  std::unordered_map<int, Tensor> constants;
+  for (const Node* n : order) {
+    if (!n->IsOp()) continue;
+    if (n->type_string() == "Const") {
+      const TensorProto* proto = nullptr;
+      Tensor value;
+      if (TryGetNodeAttr(n->attrs(), "value", &proto) &&
+          value.FromProto(*proto)) {
+        constants.emplace(n->id(), std::move(value));
+      }
+    }
+    const OpRegistrationData* op_reg_data = nullptr;
+    if (!graph.op_registry()->LookUp(n->type_string(), &op_reg_data).ok() ||
+        op_reg_data->shape_inference_fn == nullptr) {
+      continue;
+    }
+    std::vector<PartialTensorShape> input_shapes(n->num_inputs());
+    std::vector<const Tensor*> input_tensors(n->num_inputs(), nullptr);
+    for (const Edge* e : n->in_edges()) {
+      if (e->IsControlEdge()) continue;
+      const std::vector<PartialTensorShape>& src_shapes =
+          shapes[e->src()->id()];
+      if (e->src_output() < src_shapes.size()) {
+        input_shapes[e->dst_input()] = src_shapes[e->src_output()];
+      }
+      auto it = constants.find(e->src()->id());
+      if (it != constants.end()) {
+        input_tensors[e->dst_input()] = &it->second;
+      }
+    }
+    shape_inference::InferenceContext c(
+        graph.versions().producer(), n->attrs(), op_reg_data->op_def,
+        input_shapes, input_tensors, std::vector<PartialTensorShape>(),
+        std::vector<std::unique_ptr<
+            std::vector<std::pair<PartialTensorShape, DataType>>>>());
+    if (!c.construction_status().ok() ||
+        !c.Run(op_reg_data->shape_inference_fn).ok()) {
+      continue;
+    }
+    std::vector<PartialTensorShape>& output_shapes = shapes[n->id()];
+    output_shapes.resize(c.num_outputs());
+    for (int i = 0; i < c.num_outputs(); ++i) {
+      TensorShapeProto proto;
+      c.ShapeHandleToProto(c.output(i), &proto);
+      output_shapes[i] = PartialTensorShape(proto);
+    }
+  }
+
+  std::vector<int64> sizes(num_outputs(), 0);
+  for (const Node* n : graph.nodes()) {
+    const int64 base = node_base_[n->id()];
+    if (base < 0) continue;
+    for (int i = 0; i < n->num_outputs(); ++i) {
+      if (!is_candidate_[base + i]) continue;
+      const std::vector<PartialTensorShape>& output_shapes = shapes[n->id()];
+      const int64 element_size = DataTypeSize(n->output_type(i));
+      if (i >= output_shapes.size() || !output_shapes[i].IsFullyDefined() ||
+          element_size == 0) {
+        return {};
+      }
+      sizes[base + i] = element_size * output_shapes[i].num_elements();
+    }
+  }
+  return sizes;
+}
+
+std::shared_ptr<const MemoryPlan> MemoryPlanner::BuildPlan(
+    const std::vector<int64>& sizes) const {
+  auto plan = std::make_shared<MemoryPlan>();
+  const int64 n = num_outputs();
+  plan->offsets.assign(n, -1);
+  plan->sizes.assign(n, 0);
+  plan->overlaps.resize(n);
+
+  std::vector<int64> order;
+  for (int64 i = 0; i < n; ++i) {
+    if (is_candidate_[i] && sizes[i] > 0) {
+      plan->sizes[i] = RoundUpToAlignment(sizes[i]);
+      order.push_back(i);
+    }
+  }
+  std::stable_sort(order.begin(), order.end(), [&plan](int64 a, int64 b) {
+    return plan->sizes[a] > plan->sizes[b];
+  });
+
+  // Places each output in the smallest gap between the outputs placed so far
+  // that it interferes with, or after the last of them.
+  std::vector<int64> placed;
+  std::vector<std::pair<int64, int64>> busy;
+  for (int64 i : order) {
+    const int64 size = plan->sizes[i];
+    busy.clear();
+    for (int64 j : placed) {
+      if (Interferes(i, j)) {
+        busy.emplace_back(plan->offsets[j], plan->offsets[j] + plan->sizes[j]);
+      }
+    }
+    std::sort(busy.begin(), busy.end());
+    int64 best_offset = -1;
+    int64 best_gap = 0;
+    int64 end = 0;
+    for (const auto& range : busy) {
+      const int64 gap = range.first - end;
+      if (gap >= size && (best_offset < 0 || gap < best_gap)) {
+        best_offset = end;
+        best_gap = gap;
+      }
+      end = std::max(end, range.second);
+    }
+    plan->offsets[i] = best_offset >= 0 ? best_offset : end;
+    plan->slab_bytes = std::max(plan->slab_bytes, plan->offsets[i] + size);
+    plan->total_bytes += size;
+    placed.push_back(i);
+  }
+  plan->num_planned = placed.size();
+
+  for (int64 a = 0; a < placed.size(); ++a) {
+    const int64 i = placed[a];
+    for (int64 b = a + 1; b < placed.size(); ++b) {
+      const int64 j = placed[b];
+      if (plan->offsets[i] < plan->offsets[j] + plan->sizes[j] &&
+          plan->offsets[j] < plan->offsets[i] + plan->sizes[i]) {
+        plan->overlaps[i].push_back(j);
+        plan->overlaps[j].push_back(i);
+      }
+    }
+  }
+
+  VLOG(1) << "Planned " << plan->num_planned << " outputs totalling "
+          << plan->total_bytes << " bytes in a slab of " << plan->slab_bytes
+          << " bytes";
+  return plan;
+}
+
+void MemoryPlanner::RecordOutputSizes(const std::vector<int64>& sizes) {
+  DCHECK_EQ(sizes.size(), num_outputs());
+  {
+    mutex_lock l(mu_);
+    if (plan_ != nullptr) return;
+  }
+  if (std::none_of(sizes.begin(), sizes.end(),
+                   [](int64 size) { return size > 0; })) {
+    return;
+  }
+  std::shared_ptr<const MemoryPlan> plan = BuildPlan(sizes);
+  mutex_lock l(mu_);
+  if (plan_ == nullptr) {
+    metrics::RecordMemoryPlan(plan->total_bytes, plan->slab_bytes);
+    plan_ = std::move(plan);
+  }
+}
+
+std::shared_ptr<const MemoryPlan> MemoryPlanner::plan() const {
+  mutex_lock l(mu_);
+  return plan_;
+}
+
+MemoryPlanSlab* MemoryPlanner::AcquireSlab() {
+  std::shared_ptr<const MemoryPlan> plan;
+  {
+    mutex_lock l(mu_);
+    if (!free_slabs_.empty()) {
+      MemoryPlanSlab* slab = free_slabs_.back();
+      free_slabs_.pop_back();
+      return slab;
+    }
+    plan = plan_;
+  }
+  if (plan == nullptr) {
+    return nullptr;
+  }
+  return new MemoryPlanSlab(std::move(plan), base_);
+}
+
+void MemoryPlanner::ReleaseSlab(MemoryPlanSlab* slab) {
+  const int64 num_planned = slab->num_planned_allocations();
+  const int64 num_fallback = slab->num_fallback_allocations();
+  slab->ResetCounters();
+  metrics::RecordPlannedMemoryStep(num_planned, num_fallback);
+  mutex_lock l(mu_);
+  // A slab that still backs tensors which escaped the step is dropped, and
+  // freed along with the last of them.
+  if (slab->RefCountIsOne()) {
+    free_slabs_.push_back(slab);
+  } else {
+    slab->Unref();
+  }
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,195 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_MEMORY_PLANNER_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_MEMORY_PLANNER_H_
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/refcount.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// The placement of the planned outputs of a graph in one slab of memory.
+// Outputs are identified by a dense index assigned by MemoryPlanner.
+struct MemoryPlan {
+  // Offset of each output in the slab, or -1 if the output is not planned.
+  std::vector<int64> offsets;
+  // Number of bytes reserved for each output.
+  std::vector<int64> sizes;
+  // For each planned output, the other planned outputs whose ranges overlap
+  // its range. Those outputs are expected never to be live at the same time.
+  std::vector<std::vector<int64>> overlaps;
+  // Size of the slab.
+  int64 slab_bytes = 0;
+  // Sum of the sizes of the planned outputs, i.e. the memory they would need
+  // if none of them shared memory.
+  int64 total_bytes = 0;
+  int64 num_planned = 0;
+};
+
+// One step's worth of memory for a MemoryPlan.
+//
+// The slab hands out one allocator per output. An allocator returns the
+// output's planned range if the request fits in it and no output whose range
+// overlaps it is live; otherwise it forwards the request to the base
+// allocator. The plan is therefore only an optimization: a tensor that lives
+// longer than planned, because a kernel forwarded its buffer or it escaped the
+// step, costs a base allocation rather than corrupting memory.
+//
+// Every allocation holds a reference on the slab, so the slab outlives the
+// tensors allocated from it.
+class MemoryPlanSlab : public core::RefCounted {
+ public:
+  // `base` is not owned and must outlive *this.
+  MemoryPlanSlab(std::shared_ptr<const MemoryPlan> plan, Allocator* base);
+  ~MemoryPlanSlab() override;
+
+  // Returns an array of allocators indexed by output number for the node
+  // whose first output has index `first_output`. Unplanned outputs have a
+  // nullptr entry.
+  Allocator* const* output_allocators(int64 first_output) const {
+    return output_allocator_ptrs_.data() + first_output;
+  }
+
+  // Number of requests served from the slab and forwarded to the base
+  // allocator since the last call to ResetCounters().
+  int64 num_planned_allocations() const { return num_planned_allocations_; }
+  int64 num_fallback_allocations() const { return num_fallback_allocations_; }
+  void ResetCounters();
+
+ private:
+  class OutputAllocator;
+
+  void* Allocate(int64 index, size_t alignment, size_t num_bytes);
+  void Deallocate(int64 index, void* ptr);
+
+  const std::shared_ptr<const MemoryPlan> plan_;
+  Allocator* const base_;  // Not owned.
+  char* data_ = nullptr;
+
+  std::vector<std::unique_ptr<OutputAllocator>> output_allocators_;
+  std::vector<Allocator*> output_allocator_ptrs_;
+
+  std::atomic<int64> num_planned_allocations_{0};
+  std::atomic<int64> num_fallback_allocations_{0};
+
+  mutex mu_;
+  std::vector<bool> live_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MemoryPlanSlab);
+};
+
+// Assigns the short-lived outputs of a graph fixed offsets in a slab, so that
+// outputs whose lifetimes cannot overlap share memory and a step allocates
+// them without calling into the device allocator.
+//
+// Lifetimes are derived from the graph: an output may share memory with
+// another output if each of its users (its producer and its consumers) has a
+// path to the other output's producer. Sizes come from shape inference when
+// every planned output has a static shape; otherwise they are taken from the
+// first step, see RecordOutputSizes(). The offsets are chosen by placing the
+// outputs in decreasing size order, each in the smallest gap left by the
+// already placed outputs that it may not share memory with.
+//
+// Graphs with control flow loops are not planned, since their outputs have
+// one lifetime per iteration.
+class MemoryPlanner {
+ public:
+  // Returns true if output `output_index` of `node` should be planned.
+  typedef std::function<bool(const Node*, int)> CandidateFn;
+
+  // Returns a planner for the candidate outputs of `graph`, or nullptr if the
+  // graph cannot be planned. `base` is not owned and must outlive the planner
+  // and every slab it returns.
+  static std::unique_ptr<MemoryPlanner> Create(const Graph& graph,
+                                               const CandidateFn& is_candidate,
+                                               Allocator* base);
+
+  ~MemoryPlanner();
+
+  // Index of the first output of the node with id `node_id`, or -1 if the
+  // node has no candidate outputs. Output i of the node has index
+  // output_base(node_id) + i.
+  int64 output_base(int node_id) const { return node_base_[node_id]; }
+
+  // Number of output indices.
+  int64 num_outputs() const { return producer_.size(); }
+
+  // Returns a slab for one step, or nullptr if there is no plan yet. The
+  // caller must pass the slab to ReleaseSlab() when the step is done, which
+  // records the step's planned and fallback allocations in the
+  // /tensorflow/core/planned_memory_allocations metric.
+  MemoryPlanSlab* AcquireSlab();
+  void ReleaseSlab(MemoryPlanSlab* slab);
+
+  // Builds the plan from the number of bytes each output took in a step,
+  // indexed by output index, unless a plan exists already. Outputs with no
+  // recorded bytes are not planned.
+  void RecordOutputSizes(const std::vector<int64>& sizes);
+
+  // Returns the plan, or nullptr if there is no plan yet.
+  std::shared_ptr<const MemoryPlan> plan() const;
+
+  // Returns true if outputs `a` and `b` may not share memory.
+  bool Interferes(int64 a, int64 b) const;
+
+ private:
+  MemoryPlanner(const Graph& graph, const CandidateFn& is_candidate,
+                Allocator* base);
+
+  // Computes the users of every output and the reachability between nodes.
+  void AnalyzeLifetimes(const Graph& graph);
+
+  // Returns the sizes of the candidate outputs as determined by shape
+  // inference, or an empty vector if some of them are not static.
+  std::vector<int64> InferOutputSizes(const Graph& graph) const;
+
+  std::shared_ptr<const MemoryPlan> BuildPlan(
+      const std::vector<int64>& sizes) const;
+
+  bool Reaches(int from, int to) const;
+
+  Allocator* const base_;  // Not owned.
+  const int num_nodes_;
+  const int64 words_per_node_;
+
+  std::vector<int64> node_base_;
+  // Indexed by output index.
+  std::vector<bool> is_candidate_;
+  std::vector<int> producer_;
+  std::vector<std::vector<int>> users_;
+  // Bit `to` of row `from` is set if there is a path from `from` to `to`.
+  std::vector<uint64> reachable_;
+
+  mutable mutex mu_;
+  std::shared_ptr<const MemoryPlan> plan_ TF_GUARDED_BY(mu_);
+  std::vector<MemoryPlanSlab*> free_slabs_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MemoryPlanner);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_MEMORY_PLANNER_H_
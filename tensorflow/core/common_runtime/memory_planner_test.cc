@@ -0,0 +1,176 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/memory_planner.h"
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr int64 kBytes = 256 * sizeof(float);
+
+// Plans the outputs of the "Neg" and "Add" nodes of `graph`.
+std::unique_ptr<MemoryPlanner> CreatePlanner(const Graph& graph) {
+  return MemoryPlanner::Create(
+      graph,
+      [](const Node* n, int) {
+        return n->type_string() == "Neg" || n->type_string() == "Add";
+      },
+      cpu_allocator());
+}
+
+Node* FloatConstant(Graph* g) {
+  Tensor t(DT_FLOAT, TensorShape({256}));
+  t.flat<float>().setZero();
+  return test::graph::Constant(g, t);
+}
+
+TEST(MemoryPlannerTest, ChainSharesMemory) {
+  Graph g(OpRegistry::Global());
+  Node* x = FloatConstant(&g);
+  std::vector<Node*> chain;
+  for (int i = 0; i < 4; ++i) {
+    x = test::graph::Unary(&g, "Neg", x);
+    chain.push_back(x);
+  }
+  std::unique_ptr<MemoryPlanner> planner = CreatePlanner(g);
+  ASSERT_NE(planner, nullptr);
+
+  // The sizes are static, so the plan is built up front.
+  std::shared_ptr<const MemoryPlan> plan = planner->plan();
+  ASSERT_NE(plan, nullptr);
+  EXPECT_EQ(4, plan->num_planned);
+  EXPECT_EQ(4 * kBytes, plan->total_bytes);
+  // Each output is only live together with its input and its consumer's
+  // output, so two slots suffice.
+  EXPECT_EQ(2 * kBytes, plan->slab_bytes);
+
+  const int64 first = planner->output_base(chain[0]->id());
+  const int64 second = planner->output_base(chain[1]->id());
+  const int64 third = planner->output_base(chain[2]->id());
+  EXPECT_TRUE(planner->Interferes(first, second));
+  EXPECT_FALSE(planner->Interferes(first, third));
+  EXPECT_NE(plan->offsets[first], plan->offsets[second]);
+}
+
+TEST(MemoryPlannerTest, ParallelBranchesInterfere) {
+  Graph g(OpRegistry::Global());
+  Node* c = FloatConstant(&g);
+  Node* left = test::graph::Unary(&g, "Neg", c);
+  Node* right = test::graph::Unary(&g, "Neg", c);
+  Node* sum = test::graph::Add(&g, left, right);
+  std::unique_ptr<MemoryPlanner> planner = CreatePlanner(g);
+  ASSERT_NE(planner, nullptr);
+
+  const int64 l = planner->output_base(left->id());
+  const int64 r = planner->output_base(right->id());
+  const int64 s = planner->output_base(sum->id());
+  EXPECT_TRUE(planner->Interferes(l, r));
+  EXPECT_TRUE(planner->Interferes(l, s));
+  EXPECT_TRUE(planner->Interferes(r, s));
+  EXPECT_EQ(3 * kBytes, planner->plan()->slab_bytes);
+}
+
+TEST(MemoryPlannerTest, IdentityExtendsLifetime) {
+  Graph g(OpRegistry::Global());
+  Node* first = test::graph::Unary(&g, "Neg", FloatConstant(&g));
+  Node* alias = test::graph::Identity(&g, first);
+  Node* second = test::graph::Unary(&g, "Neg", FloatConstant(&g));
+  // `first` is still live through `alias` when `second` is produced.
+  g.AddControlEdge(alias, second);
+  test::graph::Add(&g, alias, second);
+  std::unique_ptr<MemoryPlanner> planner = CreatePlanner(g);
+  ASSERT_NE(planner, nullptr);
+  EXPECT_TRUE(planner->Interferes(planner->output_base(first->id()),
+                                  planner->output_base(second->id())));
+}
+
+TEST(MemoryPlannerTest, LoopsAreNotPlanned) {
+  Graph g(OpRegistry::Global());
+  Node* enter = test::graph::Enter(&g, FloatConstant(&g), "loop");
+  test::graph::Unary(&g, "Neg", enter);
+  EXPECT_EQ(CreatePlanner(g), nullptr);
+}
+
+TEST(MemoryPlannerTest, PlansFromRecordedSizes) {
+  Graph g(OpRegistry::Global());
+  Node* recv = test::graph::Recv(&g, "in", "float", "/cpu:0", 1, "/cpu:0");
+  Node* first = test::graph::Unary(&g, "Neg", recv);
+  Node* second = test::graph::Unary(&g, "Neg", first);
+  std::unique_ptr<MemoryPlanner> planner = CreatePlanner(g);
+  ASSERT_NE(planner, nullptr);
+
+  // The shape of the received tensor is unknown.
+  EXPECT_EQ(planner->plan(), nullptr);
+  EXPECT_EQ(planner->AcquireSlab(), nullptr);
+
+  std::vector<int64> sizes(planner->num_outputs(), 0);
+  sizes[planner->output_base(first->id())] = 100;
+  sizes[planner->output_base(second->id())] = 100;
+  planner->RecordOutputSizes(sizes);
+  std::shared_ptr<const MemoryPlan> plan = planner->plan();
+  ASSERT_NE(plan, nullptr);
+  EXPECT_EQ(2, plan->num_planned);
+  // Sizes are rounded up to the allocator alignment.
+  EXPECT_EQ(2 * 128, plan->slab_bytes);
+}
+
+TEST(MemoryPlanSlabTest, FallsBackWhenSlotIsUnavailable) {
+  auto plan = std::make_shared<MemoryPlan>();
+  // Outputs 0 and 1 share a slot; output 2 is not planned.
+  plan->offsets = {0, 0, -1};
+  plan->sizes = {128, 128, 0};
+  plan->overlaps = {{1}, {0}, {}};
+  plan->slab_bytes = 128;
+  plan->total_bytes = 256;
+  plan->num_planned = 2;
+
+  MemoryPlanSlab* slab = new MemoryPlanSlab(plan, cpu_allocator());
+  Allocator* const* allocators = slab->output_allocators(0);
+  EXPECT_EQ(allocators[2], nullptr);
+
+  void* a = allocators[0]->AllocateRaw(Allocator::kAllocatorAlignment, 100);
+  // Output 1 overlaps the live output 0.
+  void* b = allocators[1]->AllocateRaw(Allocator::kAllocatorAlignment, 100);
+  EXPECT_NE(a, b);
+  // Too large for the slot.
+  void* c = allocators[0]->AllocateRaw(Allocator::kAllocatorAlignment, 1000);
+  EXPECT_EQ(1, slab->num_planned_allocations());
+  EXPECT_EQ(2, slab->num_fallback_allocations());
+  EXPECT_FALSE(slab->RefCountIsOne());
+
+  allocators[0]->DeallocateRaw(a);
+  allocators[1]->DeallocateRaw(b);
+  allocators[0]->DeallocateRaw(c);
+  EXPECT_TRUE(slab->RefCountIsOne());
+
+  // Once output 0 is dead, output 1 gets the slot.
+  void* d = allocators[1]->AllocateRaw(Allocator::kAllocatorAlignment, 100);
+  EXPECT_EQ(a, d);
+  EXPECT_EQ(2, slab->num_planned_allocations());
+  allocators[1]->DeallocateRaw(d);
+  slab->Unref();
+}
+
+}  // namespace
+}  // namespace tensorflow
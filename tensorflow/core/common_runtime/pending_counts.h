@@ -91,6 +91,14 @@ class PendingCounts {
 
   ~PendingCounts() { delete[] bytes_; }
 
+  // Overwrites the counts with those of "other", which must have been created
+  // from the same layout. Unlike the copy constructor, this does not allocate,
+  // so that per-iteration state can be recycled cheaply.
+  void CopyFrom(const PendingCounts& other) {
+    DCHECK_EQ(num_bytes_, other.num_bytes_);
+    memcpy(bytes_, other.bytes_, num_bytes_);
+  }
+
   void set_initial_count(Handle h, size_t pending_count) {
     if (h.is_large_) {
       LargeCounts* c = Large(h);
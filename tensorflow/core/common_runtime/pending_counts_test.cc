@@ -75,6 +75,30 @@ TEST(PendingCounts, CopyConstructor) {
   }
 }
 
+TEST(PendingCounts, CopyFrom) {
+  const int C = 300;
+  PendingCounts::Layout layout;
+  std::vector<PendingCounts::Handle> h(C);
+  for (int id = 0; id < C; id++) {
+    h[id] = layout.CreateHandle(id, id);
+  }
+  PendingCounts c(layout);
+  for (int id = 0; id < C; id++) {
+    c.set_initial_count(h[id], id);
+  }
+  PendingCounts c2(c);
+  // Modify the copy, then restore it from the original.
+  for (int id = 1; id < C; id++) {
+    c2.increment_dead_count(h[id]);
+    c2.decrement_pending(h[id], 1);
+  }
+  c2.CopyFrom(c);
+  for (int id = 0; id < C; id++) {
+    EXPECT_EQ(c.pending(h[id]), c2.pending(h[id]));
+    EXPECT_EQ(c.dead_count(h[id]), c2.dead_count(h[id]));
+  }
+}
+
 TEST(PendingCounts, MarkLiveShowsUpAsCount) {
   PendingCounts::Layout layout;
   PendingCounts::Handle handles[2];
@@ -616,8 +616,7 @@ PropagatorState::FrameState::IncrementIteration(TaggedNodeSeq* ready) {
   iteration_count++;
 
   // Initialize the next iteration.
-  IterationState* next_iter =
-      new IterationState(iteration_count, pending_counts, total_input_tensors);
+  IterationState* next_iter = NewIteration(iteration_count);
   SetIteration(iteration_count, next_iter);
   num_outstanding_iterations++;
   dead_exits.clear();
@@ -635,7 +634,7 @@ bool PropagatorState::FrameState::CleanupIterations(IterationState* iter_state,
                                                     TaggedNodeSeq* ready) {
   int64 curr_iter = iter_state->iter_num;
   while (curr_iter <= iteration_count && IsIterationDone(iter_state)) {
-    delete iter_state;
+    RecycleIteration(iter_state);
     SetIteration(curr_iter, nullptr);
     --num_outstanding_iterations;
     ++curr_iter;
@@ -672,6 +671,23 @@ void PropagatorState::FrameState::SetIteration(int64 iter,
   }
 }
 
+PropagatorState::IterationState* PropagatorState::FrameState::NewIteration(
+    int64 iter) TF_EXCLUSIVE_LOCKS_REQUIRED(mu) {
+  if (free_iterations.empty()) {
+    return new IterationState(iter, pending_counts, total_input_tensors);
+  }
+  IterationState* iter_state = free_iterations.back();
+  free_iterations.pop_back();
+  iter_state->Reset(iter, pending_counts);
+  return iter_state;
+}
+
+void PropagatorState::FrameState::RecycleIteration(IterationState* iter_state)
+    TF_EXCLUSIVE_LOCKS_REQUIRED(mu) {
+  iter_state->ClearInputTensors(total_input_tensors);
+  free_iterations.push_back(iter_state);
+}
+
 // Decrement the outstanding op count and clean up the iterations in the
 // frame. Return true iff the execution of the frame is done.
 bool PropagatorState::FrameState::DecrementOutstandingOps(
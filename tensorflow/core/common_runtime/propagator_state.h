@@ -130,7 +130,7 @@ class PropagatorState {
           counts(*pending_counts) {  // Initialize with copy of *pending_counts
     }
 
-    const int64 iter_num;  // The index of this iteration in the enclosing loop.
+    int64 iter_num;  // The index of this iteration in the enclosing loop.
 
     // One copy per iteration. For iteration k, i-th node's j-th input is in
     // input_tensors[k][immutable_state_.nodes[i].input_start + j]. An entry is
@@ -171,6 +171,25 @@ class PropagatorState {
       return counts.adjust_for_activation(h, increment_dead);
     }
 
+    // Prepares a recycled iteration state to be used as iteration `new_iter_num`
+    // without reallocating `input_tensors` or the pending counts.
+    //
+    // REQUIRES: `ClearInputTensors()` was called when the state was recycled.
+    void Reset(int64 new_iter_num, const PendingCounts* pending_counts) {
+      iter_num = new_iter_num;
+      outstanding_ops = 0;
+      outstanding_frame_count = 0;
+      counts.CopyFrom(*pending_counts);
+    }
+
+    // Releases any input tensors that were never consumed (e.g. the inputs of
+    // a Merge node that arrived after it had run).
+    void ClearInputTensors(int total_input_tensors) {
+      for (int i = 0; i < total_input_tensors; ++i) {
+        input_tensors[i].ClearVal();
+      }
+    }
+
     ~IterationState() { delete[] input_tensors; }
 
    private:
@@ -271,6 +290,12 @@ class PropagatorState {
     // will only "execute" the dead exits of the final iteration.
     std::vector<const NodeItem*> dead_exits TF_GUARDED_BY(mu);
 
+    // The states of completed iterations of this frame, kept for reuse by
+    // later iterations. A loop has at most `max_parallel_iterations + 1` live
+    // iterations, so recycling them avoids allocating the input tensors and
+    // pending counts anew for each of thousands of iterations.
+    std::vector<IterationState*> free_iterations TF_GUARDED_BY(mu);
+
     // Static information specific to this frame.
     PendingCounts* pending_counts = nullptr;
     int total_input_tensors = 0;
@@ -294,6 +319,14 @@ class PropagatorState {
 
     void SetIteration(int64 iter, IterationState* state);
 
+    // Returns a state for iteration `iter`, reusing a recycled state from
+    // `free_iterations` if possible.
+    IterationState* NewIteration(int64 iter) TF_EXCLUSIVE_LOCKS_REQUIRED(mu);
+
+    // Adds the state of a completed iteration to `free_iterations`.
+    void RecycleIteration(IterationState* iter_state)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu);
+
     // Decrement the outstanding op count and clean up the iterations in the
     // frame. Return true iff the execution of the frame is done.
     bool DecrementOutstandingOps(IterationState* iter_state,
@@ -355,6 +388,9 @@ class PropagatorState {
         delete iterations[i];
         iterations[i] = nullptr;
       }
+      for (IterationState* iter_state : free_iterations) {
+        delete iter_state;
+      }
     }
 
    private:
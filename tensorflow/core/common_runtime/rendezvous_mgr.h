@@ -80,6 +80,10 @@ class PrivateIntraProcessRendezvous : public RendezvousInterface {
                  DoneCallback done) override;
   void StartAbort(const Status& status) override;
 
+  // Returns true if this rendezvous can serve another step, i.e. it has not
+  // been aborted and no values or receivers are pending.
+  bool IsIdle() { return local_.IsIdle(); }
+
  private:
   const DeviceMgr* device_mgr_;
   LocalRendezvous local_;
@@ -0,0 +1,147 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+StepArenaAllocator::StepArenaAllocator(Allocator* base, size_t chunk_size_bytes,
+                                       size_t max_bytes_reserved)
+    : base_(base),
+      chunk_size_(chunk_size_bytes),
+      max_bump_size_(chunk_size_bytes / 4),
+      max_bytes_reserved_(max_bytes_reserved) {
+  CHECK_GT(chunk_size_, 0);
+}
+
+StepArenaAllocator::~StepArenaAllocator() {
+  DCHECK(fallback_ptrs_.empty());
+  for (const auto& chunk : chunks_) {
+    base_->DeallocateRaw(chunk->data);
+  }
+}
+
+void* StepArenaAllocator::AllocateRaw(size_t alignment, size_t num_bytes) {
+  if (num_bytes > max_bump_size_ ||
+      alignment > Allocator::kAllocatorAlignment) {
+    Chunk* chunk;
+    {
+      mutex_lock l(mu_);
+      chunk = AddChunk(std::max(alignment, Allocator::kAllocatorAlignment),
+                       num_bytes);
+    }
+    if (chunk == nullptr) return AllocateFallback(alignment, num_bytes);
+    Ref();
+    num_allocs_.fetch_add(1, std::memory_order_relaxed);
+    return chunk->data;
+  }
+
+  // Rounding every request up to the alignment keeps every offset aligned.
+  const size_t size = (std::max<size_t>(num_bytes, 1) +
+                       Allocator::kAllocatorAlignment - 1) &
+                      ~(Allocator::kAllocatorAlignment - 1);
+  Chunk* chunk = current_.load(std::memory_order_acquire);
+  while (true) {
+    if (chunk != nullptr) {
+      const size_t offset =
+          chunk->offset.fetch_add(size, std::memory_order_relaxed);
+      if (offset + size <= chunk->size) {
+        Ref();
+        num_allocs_.fetch_add(1, std::memory_order_relaxed);
+        return chunk->data + offset;
+      }
+    }
+    {
+      mutex_lock l(mu_);
+      Chunk* latest = current_.load(std::memory_order_relaxed);
+      if (latest == chunk) {
+        // No other thread has replaced the full chunk yet.
+        latest = AddChunk(Allocator::kAllocatorAlignment, chunk_size_);
+        if (latest != nullptr) {
+          current_.store(latest, std::memory_order_release);
+        }
+      }
+      chunk = latest;
+    }
+    if (chunk == nullptr) return AllocateFallback(alignment, num_bytes);
+  }
+}
+
+void StepArenaAllocator::DeallocateRaw(void* ptr) {
+  if (num_fallback_allocs_.load(std::memory_order_acquire) > 0) {
+    bool is_fallback;
+    {
+      mutex_lock l(mu_);
+      is_fallback = fallback_ptrs_.erase(ptr) > 0;
+      if (is_fallback) {
+        num_fallback_allocs_.fetch_sub(1, std::memory_order_relaxed);
+      }
+    }
+    if (is_fallback) base_->DeallocateRaw(ptr);
+  }
+  // Frees every chunk if this was the last reference.
+  Unref();
+}
+
+absl::optional<AllocatorStats> StepArenaAllocator::GetStats() {
+  AllocatorStats stats;
+  stats.num_allocs = num_allocs_.load(std::memory_order_relaxed);
+  mutex_lock l(mu_);
+  stats.bytes_reserved = bytes_reserved_;
+  stats.peak_bytes_reserved = bytes_reserved_;
+  return stats;
+}
+
+bool StepArenaAllocator::Owns(const void* ptr) const {
+  const char* p = static_cast<const char*>(ptr);
+  mutex_lock l(mu_);
+  for (const auto& chunk : chunks_) {
+    if (p >= chunk->data && p < chunk->data + chunk->size) return true;
+  }
+  return false;
+}
+
+StepArenaAllocator::Chunk* StepArenaAllocator::AddChunk(size_t alignment,
+                                                        size_t size) {
+  if (bytes_reserved_ + size > max_bytes_reserved_) return nullptr;
+  char* data = static_cast<char*>(base_->AllocateRaw(alignment, size));
+  if (data == nullptr) return nullptr;
+  chunks_.emplace_back(new Chunk);
+  Chunk* chunk = chunks_.back().get();
+  chunk->data = data;
+  chunk->size = size;
+  bytes_reserved_ += size;
+  return chunk;
+}
+
+void* StepArenaAllocator::AllocateFallback(size_t alignment,
+                                           size_t num_bytes) {
+  void* ptr = base_->AllocateRaw(alignment, num_bytes);
+  if (ptr == nullptr) return nullptr;
+  {
+    mutex_lock l(mu_);
+    fallback_ptrs_.insert(ptr);
+    num_fallback_allocs_.fetch_add(1, std::memory_order_relaxed);
+  }
+  Ref();
+  num_allocs_.fetch_add(1, std::memory_order_relaxed);
+  return ptr;
+}
+
+}  // namespace tensorflow
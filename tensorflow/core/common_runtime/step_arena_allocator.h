@@ -0,0 +1,115 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/refcount.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// An allocator for the short-lived intermediate tensors of one step.
+//
+// The executor creates an arena when a step starts and allocates the step's
+// step-local outputs from it. Allocations are carved by bumping an offset into
+// chunks obtained from a base allocator, without taking a lock unless a new
+// chunk is needed. DeallocateRaw() does not reuse memory: every chunk is
+// returned to the base allocator at once when the arena is destroyed.
+//
+// Every allocation holds a reference on the arena, and the executor holds one
+// for the duration of the step, so the chunks are freed in bulk when the step
+// is done and no tensor allocated from them is alive. A tensor that escapes
+// the step therefore stays valid, but keeps the whole arena alive; the
+// executor copies step outputs that may escape out of the arena, see Owns().
+//
+// Requests larger than a quarter of a chunk, or with an alignment stricter
+// than Allocator::kAllocatorAlignment, get a chunk of their own. Once the
+// chunks reach `max_bytes_reserved`, further requests are forwarded to the
+// base allocator and freed individually, which bounds the memory held by a
+// step that allocates many step-local tensors, e.g. in a loop.
+class StepArenaAllocator : public Allocator, public core::RefCounted {
+ public:
+  static constexpr size_t kDefaultChunkSizeBytes = 1 << 20;
+  static constexpr size_t kDefaultMaxBytesReserved = 64 << 20;
+
+  // "base" is not owned and must outlive *this.
+  StepArenaAllocator(Allocator* base, size_t chunk_size_bytes,
+                     size_t max_bytes_reserved);
+
+  string Name() override { return "step_arena"; }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override;
+  void DeallocateRaw(void* ptr) override;
+
+  absl::optional<AllocatorStats> GetStats() override;
+
+  // Returns true if `ptr` points into one of the chunks of this arena.
+  bool Owns(const void* ptr) const;
+
+  // Number of chunks currently obtained from the base allocator.
+  int64 num_chunks() const {
+    mutex_lock l(mu_);
+    return chunks_.size();
+  }
+
+ private:
+  struct Chunk {
+    char* data = nullptr;
+    size_t size = 0;
+    std::atomic<size_t> offset{0};
+  };
+
+  ~StepArenaAllocator() override;
+
+  // Obtains a chunk of `size` bytes from `base_`, or returns nullptr if the
+  // chunks would exceed `max_bytes_reserved_` or `base_` fails.
+  Chunk* AddChunk(size_t alignment, size_t size)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Serves a request from `base_` once the arena is full.
+  void* AllocateFallback(size_t alignment, size_t num_bytes);
+
+  Allocator* const base_;  // Not owned.
+  const size_t chunk_size_;
+  const size_t max_bump_size_;
+  const size_t max_bytes_reserved_;
+
+  // The chunk that small requests are carved from.
+  std::atomic<Chunk*> current_{nullptr};
+  std::atomic<int64> num_allocs_{0};
+  // Number of live requests forwarded to `base_`.
+  std::atomic<int64> num_fallback_allocs_{0};
+
+  mutable mutex mu_;
+  std::vector<std::unique_ptr<Chunk>> chunks_ TF_GUARDED_BY(mu_);
+  size_t bytes_reserved_ TF_GUARDED_BY(mu_) = 0;
+  absl::flat_hash_set<void*> fallback_ptrs_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(StepArenaAllocator);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
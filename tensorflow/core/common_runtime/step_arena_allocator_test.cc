@@ -0,0 +1,186 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
+
+#include <cstring>
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr size_t kChunkSize = 1 << 12;
+
+// Counts the live allocations of the wrapped allocator.
+class CountingAllocator : public Allocator {
+ public:
+  string Name() override { return "counting"; }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    ++num_live_;
+    return cpu_allocator()->AllocateRaw(alignment, num_bytes);
+  }
+  void DeallocateRaw(void* ptr) override {
+    --num_live_;
+    cpu_allocator()->DeallocateRaw(ptr);
+  }
+  int num_live() const { return num_live_; }
+
+ private:
+  int num_live_ = 0;
+};
+
+TEST(StepArenaAllocatorTest, AllocationsAreAlignedAndDisjoint) {
+  auto* a = new StepArenaAllocator(cpu_allocator(), kChunkSize,
+                                   /*max_bytes_reserved=*/1 << 20);
+  std::vector<char*> ptrs;
+  for (int i = 0; i < 100; ++i) {
+    char* p = static_cast<char*>(
+        a->AllocateRaw(Allocator::kAllocatorAlignment, 100));
+    ASSERT_NE(p, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % Allocator::kAllocatorAlignment,
+              0);
+    EXPECT_TRUE(a->Owns(p));
+    memset(p, i, 100);
+    ptrs.push_back(p);
+  }
+  for (int i = 0; i < 100; ++i) {
+    for (int j = 0; j < 100; ++j) {
+      EXPECT_EQ(ptrs[i][j], static_cast<char>(i));
+    }
+  }
+  EXPECT_EQ(100, a->GetStats()->num_allocs);
+  for (char* p : ptrs) a->DeallocateRaw(p);
+  a->Unref();
+}
+
+TEST(StepArenaAllocatorTest, ChunksAreFreedInBulkWhenTheStepEnds) {
+  CountingAllocator base;
+  auto* a = new StepArenaAllocator(&base, kChunkSize,
+                                   /*max_bytes_reserved=*/1 << 20);
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 64; ++i) {
+    ptrs.push_back(a->AllocateRaw(Allocator::kAllocatorAlignment, 256));
+  }
+  EXPECT_EQ(4, a->num_chunks());
+  EXPECT_EQ(4, base.num_live());
+  for (void* p : ptrs) a->DeallocateRaw(p);
+  // Freeing the allocations does not return any memory to `base`...
+  EXPECT_EQ(4, base.num_live());
+  // ... but ending the step does.
+  a->Unref();
+  EXPECT_EQ(0, base.num_live());
+}
+
+TEST(StepArenaAllocatorTest, EscapedAllocationOutlivesTheStep) {
+  CountingAllocator base;
+  auto* a = new StepArenaAllocator(&base, kChunkSize,
+                                   /*max_bytes_reserved=*/1 << 20);
+  Tensor escaped;
+  {
+    Tensor t(a, DT_INT32, TensorShape({16}));
+    t.flat<int32>().setConstant(7);
+    escaped = t;
+    Tensor local(a, DT_INT32, TensorShape({16}));
+  }
+  a->Unref();
+  EXPECT_EQ(1, base.num_live());
+  for (int i = 0; i < 16; ++i) {
+    EXPECT_EQ(7, escaped.flat<int32>()(i));
+  }
+  escaped = Tensor();
+  EXPECT_EQ(0, base.num_live());
+}
+
+TEST(StepArenaAllocatorTest, LargeAllocationsGetTheirOwnChunk) {
+  auto* a = new StepArenaAllocator(cpu_allocator(), kChunkSize,
+                                   /*max_bytes_reserved=*/1 << 20);
+  void* small = a->AllocateRaw(Allocator::kAllocatorAlignment, 64);
+  void* large = a->AllocateRaw(Allocator::kAllocatorAlignment, kChunkSize);
+  ASSERT_NE(large, nullptr);
+  EXPECT_EQ(2, a->num_chunks());
+  // The current chunk still serves small requests.
+  void* next = a->AllocateRaw(Allocator::kAllocatorAlignment, 64);
+  EXPECT_EQ(static_cast<char*>(small) + Allocator::kAllocatorAlignment, next);
+  a->DeallocateRaw(next);
+  a->DeallocateRaw(large);
+  a->DeallocateRaw(small);
+  a->Unref();
+}
+
+TEST(StepArenaAllocatorTest, FullArenaForwardsToBase) {
+  CountingAllocator base;
+  auto* a = new StepArenaAllocator(&base, kChunkSize,
+                                   /*max_bytes_reserved=*/kChunkSize / 2);
+  void* first = a->AllocateRaw(Allocator::kAllocatorAlignment, kChunkSize / 2);
+  void* second = a->AllocateRaw(Allocator::kAllocatorAlignment, kChunkSize / 2);
+  EXPECT_TRUE(a->Owns(first));
+  EXPECT_FALSE(a->Owns(second));
+  EXPECT_EQ(1, a->num_chunks());
+  EXPECT_EQ(2, base.num_live());
+  // A forwarded request is returned to `base` as soon as it is freed.
+  a->DeallocateRaw(second);
+  EXPECT_EQ(1, base.num_live());
+  a->DeallocateRaw(first);
+  a->Unref();
+  EXPECT_EQ(0, base.num_live());
+}
+
+// Simulates the allocations of one step of a small CPU graph: a number of
+// intermediate tensors of mixed sizes, all freed at the end of the step.
+void StepAllocationsHelper(int iters, int num_tensors, bool use_arena) {
+  testing::StopTiming();
+  const std::vector<size_t> sizes = {64, 256, 1024, 4096, 16384, 65536};
+  std::vector<void*> ptrs(num_tensors);
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    StepArenaAllocator* arena =
+        use_arena ? new StepArenaAllocator(
+                        cpu_allocator(),
+                        StepArenaAllocator::kDefaultChunkSizeBytes,
+                        StepArenaAllocator::kDefaultMaxBytesReserved)
+                  : nullptr;
+    Allocator* a =
+        use_arena ? static_cast<Allocator*>(arena) : cpu_allocator();
+    for (int j = 0; j < num_tensors; ++j) {
+      ptrs[j] = a->AllocateRaw(Allocator::kAllocatorAlignment,
+                               sizes[j % sizes.size()]);
+    }
+    for (int j = 0; j < num_tensors; ++j) {
+      a->DeallocateRaw(ptrs[j]);
+    }
+    if (arena != nullptr) arena->Unref();
+  }
+  testing::StopTiming();
+#ifdef PLATFORM_GOOGLE
+  SetBenchmarkItemsProcessed(static_cast<int64>(iters) * num_tensors);
+#endif  // PLATFORM_GOOGLE
+}
+
+void BM_StepAllocations(int iters, int num_tensors) {
+  StepAllocationsHelper(iters, num_tensors, /*use_arena=*/false);
+}
+void BM_StepAllocationsArena(int iters, int num_tensors) {
+  StepAllocationsHelper(iters, num_tensors, /*use_arena=*/true);
+}
+BENCHMARK(BM_StepAllocations)->Arg(16)->Arg(128)->Arg(512);
+BENCHMARK(BM_StepAllocationsArena)->Arg(16)->Arg(128)->Arg(512);
+
+}  // namespace
+}  // namespace tensorflow
@@ -285,8 +285,13 @@ Status GraphMgr::InitItem(
                           unit->device->name(), subgraph.get()));
     unit->graph = std::move(subgraph);
     unit->build_cost_model = graph_options.build_cost_model();
+    params.cost_model = nullptr;
     if (unit->build_cost_model > 0) {
       skip_cost_models_ = false;
+      // The executor is updated as `BuildCostModel()` adds measurements to
+      // the cost model of its graph.
+      params.cost_model =
+          cost_model_manager_.FindOrCreateCostModel(unit->graph.get());
     }
     TF_RETURN_IF_ERROR(NewLocalExecutor(params, *unit->graph, &unit->root));
   }
@@ -569,7 +574,13 @@ void GraphMgr::BuildCostModel(Item* item, StepStatsCollector* collector,
         device_to_graph[unit.device->name()] = unit.graph.get();
       }
     }
+    mutex_lock l(cost_model_mu_);
     collector->BuildCostModel(&cost_model_manager_, device_to_graph);
+    for (const auto& unit : item->units) {
+      if (unit.build_cost_model > 0) {
+        unit.root->UpdateCostEstimates();
+      }
+    }
 
     if (cost_graph != nullptr) {
       for (const auto& unit : item->units) {
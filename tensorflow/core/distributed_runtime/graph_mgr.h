@@ -148,6 +148,9 @@ class GraphMgr {
   const DeviceMgr* device_mgr_;
 
   CostModelManager cost_model_manager_;
+  // Serializes the updates of the cost models by concurrent steps, and the
+  // executors reading them.
+  mutex cost_model_mu_;
 
   // Owned.
   mutex mu_;
@@ -367,6 +367,11 @@ struct AllocatorAttributes {
   bool nic_compatible() const { return value & (0x1 << 1); }
   void set_gpu_compatible(bool v) { value |= (static_cast<int>(v) << 2); }
   bool gpu_compatible() const { return value & (0x1 << 2); }
+  // A step-local allocation is expected to be freed before the end of the
+  // step that made it, so a device may serve it from a per-step arena. This
+  // is a placement hint, not a restriction on the memory returned.
+  void set_step_local(bool v) { value |= (static_cast<int>(v) << 3); }
+  bool step_local() const { return value & (0x1 << 3); }
   void Merge(AllocatorAttributes other) {
     value |= other.value;
     if (scope_id != other.scope_id) {
@@ -380,7 +385,8 @@ struct AllocatorAttributes {
   // Returns true if the fields set in *this is a subset of or equal to
   // those set in other.
   bool IsEqualOrLessRestrictiveThan(const AllocatorAttributes& other) const {
-    return (value | other.value) == other.value;
+    constexpr uint32 kHintMask = 0x1 << 3;  // step_local
+    return ((value | other.value) & ~kHintMask) == (other.value & ~kHintMask);
   }
 
   // NOTE: The upper 8 bits of the value are reserved for
@@ -50,13 +50,17 @@ TEST(AllocatorAttributesTest, AllCombos) {
   for (bool on_host : {false, true}) {
     for (bool nic_compatible : {false, true}) {
       for (bool gpu_compatible : {false, true}) {
-        AllocatorAttributes aa;
-        aa.set_on_host(on_host);
-        aa.set_nic_compatible(nic_compatible);
-        aa.set_gpu_compatible(gpu_compatible);
-        EXPECT_EQ(on_host, aa.on_host());
-        EXPECT_EQ(nic_compatible, aa.nic_compatible());
-        EXPECT_EQ(gpu_compatible, aa.gpu_compatible());
+        for (bool step_local : {false, true}) {
+          AllocatorAttributes aa;
+          aa.set_on_host(on_host);
+          aa.set_nic_compatible(nic_compatible);
+          aa.set_gpu_compatible(gpu_compatible);
+          aa.set_step_local(step_local);
+          EXPECT_EQ(on_host, aa.on_host());
+          EXPECT_EQ(nic_compatible, aa.nic_compatible());
+          EXPECT_EQ(gpu_compatible, aa.gpu_compatible());
+          EXPECT_EQ(step_local, aa.step_local());
+        }
       }
     }
   }
@@ -84,6 +88,11 @@ TEST(AllocatorAttributesTest, IsEqualOrLessRestrictiveThan) {
   // The set of flags in b is a proper subset of those in a.
   EXPECT_TRUE(b.IsEqualOrLessRestrictiveThan(a));
   EXPECT_FALSE(a.IsEqualOrLessRestrictiveThan(b));
+
+  b.set_step_local(true);
+  // step_local is a hint, so it does not make b more restrictive.
+  EXPECT_TRUE(b.IsEqualOrLessRestrictiveThan(a));
+  EXPECT_TRUE(a.IsEqualOrLessRestrictiveThan(a));
 }
 
 TEST(AllocatorAttributesTest, Merge) {
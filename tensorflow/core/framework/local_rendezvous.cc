@@ -286,6 +286,11 @@ void LocalRendezvous::RecvAsync(const Rendezvous::ParsedKey& key,
   delete item;
 }
 
+bool LocalRendezvous::IsIdle() {
+  mutex_lock l(mu_);
+  return status_.ok() && table_.empty();
+}
+
 void LocalRendezvous::StartAbort(const Status& status) {
   CHECK(!status.ok());
   Table table;
@@ -46,6 +46,10 @@ class LocalRendezvous {
                  Rendezvous::DoneCallback done);
   void StartAbort(const Status& status);
 
+  // Returns true if the rendezvous has not been aborted and holds no sent
+  // values or waiting receivers.
+  bool IsIdle();
+
  private:
   struct Item;
 
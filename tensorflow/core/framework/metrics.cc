@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/monitoring/gauge.h"
 #include "tensorflow/core/lib/monitoring/sampler.h"
 
 namespace tensorflow {
@@ -118,6 +119,23 @@ auto* parse_ragged_feature_counter = monitoring::Counter<0>::New(
     "/tensorflow/data/ragged_feature",
     "The number of ragged features parsed by ops for parsing tf.Example.");
 
+auto* planned_memory_steps = monitoring::Counter<0>::New(
+    "/tensorflow/core/planned_memory_steps",
+    "The number of steps run by executors that plan the memory of their "
+    "outputs.");
+
+auto* planned_memory_allocations = monitoring::Counter<1>::New(
+    "/tensorflow/core/planned_memory_allocations",
+    "The number of planned output allocations, by whether they were served "
+    "from the step's slab (planned) or from the device allocator (fallback).",
+    "kind");
+
+auto* memory_plan_bytes = monitoring::Counter<1>::New(
+    "/tensorflow/core/memory_plan_bytes",
+    "The number of bytes of the outputs placed by memory plans (outputs), and "
+    "of the slabs they were placed in (slab).",
+    "kind");
+
 auto* build_graph_calls = monitoring::Counter<0>::New(
     "/tensorflow/core/graph_build_calls",
     "The number of times TensorFlow has created a new client graph. "
@@ -144,6 +162,23 @@ auto* xla_compilation_time_usecs = monitoring::Counter<0>::New(
     "/tensorflow/core/xla_compilation_time_usecs",
     "The total time spent on compiling XLA graphs in microseconds.");
 
+auto* xla_async_compilation_queue_depth = monitoring::Gauge<int64, 0>::New(
+    "/tensorflow/core/xla_async_compilation_queue_depth",
+    "The number of XLA compilations queued or running in the background.");
+
+auto* xla_async_compilation_latency_usecs = monitoring::Sampler<0>::New(
+    {"/tensorflow/core/xla_async_compilation_latency_usecs",
+     "The time from scheduling a background XLA compilation until its "
+     "executable became available, in microseconds."},
+    // Power of 2 with bucket count 16 (> 30 seconds)
+    {monitoring::Buckets::Exponential(1000, 2, 16)});
+
+auto* xla_shape_bucket_lookups = monitoring::Counter<3>::New(
+    "/tensorflow/core/xla_shape_bucket_lookups",
+    "The number of XLA compilation cache lookups of shape-bucketed clusters, "
+    "by cluster, bucket and whether the lookup hit a compiled executable.",
+    "cluster", "bucket", "result");
+
 auto* mlir_import_failure_count = monitoring::Counter<0>::New(
     "/tensorflow/mlir/import_failure_count",
     "The number of jobs that failed during mlir import or verification.");
@@ -238,6 +273,31 @@ void UpdateGraphExecTime(const uint64 running_time_usecs) {
   }
 }
 
+void RecordPlannedMemoryStep(int64 num_planned, int64 num_fallback) {
+  static auto* steps_cell = planned_memory_steps->GetCell();
+  static auto* planned_cell = planned_memory_allocations->GetCell("planned");
+  static auto* fallback_cell = planned_memory_allocations->GetCell("fallback");
+  steps_cell->IncrementBy(1);
+  planned_cell->IncrementBy(num_planned);
+  fallback_cell->IncrementBy(num_fallback);
+}
+
+void RecordMemoryPlan(int64 total_bytes, int64 slab_bytes) {
+  static auto* outputs_cell = memory_plan_bytes->GetCell("outputs");
+  static auto* slab_cell = memory_plan_bytes->GetCell("slab");
+  outputs_cell->IncrementBy(total_bytes);
+  slab_cell->IncrementBy(slab_bytes);
+}
+
+monitoring::CounterCell* GetPlannedMemoryAllocationsCounter(
+    const string& kind) {
+  return planned_memory_allocations->GetCell(kind);
+}
+
+monitoring::CounterCell* GetMemoryPlanBytesCounter(const string& kind) {
+  return memory_plan_bytes->GetCell(kind);
+}
+
 void UpdateGraphOptimizationPassTime(const string& pass_name,
                                      const uint64 running_time_usecs) {
   if (running_time_usecs > 0) {
@@ -274,6 +334,24 @@ void UpdateXlaCompilationTime(const uint64 compilation_time_usecs) {
   }
 }
 
+void UpdateXlaAsyncCompilationQueueDepth(const int64 queue_depth) {
+  static auto* xla_async_compilation_queue_depth_cell =
+      xla_async_compilation_queue_depth->GetCell();
+  xla_async_compilation_queue_depth_cell->Set(queue_depth);
+}
+
+void RecordXlaAsyncCompilationLatency(const uint64 latency_usecs) {
+  static auto* xla_async_compilation_latency_usecs_cell =
+      xla_async_compilation_latency_usecs->GetCell();
+  xla_async_compilation_latency_usecs_cell->Add(latency_usecs);
+}
+
+void RecordXlaShapeBucketLookup(const string& cluster, const string& bucket,
+                                bool hit) {
+  xla_shape_bucket_lookups->GetCell(cluster, bucket, hit ? "hit" : "miss")
+      ->IncrementBy(1);
+}
+
 void IncrementMLIRImportFailureCount() {
   static auto* mlir_import_failure_count_cell =
       mlir_import_failure_count->GetCell();
@@ -96,6 +96,23 @@ void UpdateGraphExecTime(const uint64 running_time_usecs);
 // Records that one output of an op of type `op_name` was unused.
 void RecordUnusedOutput(const string& op_name);
 
+// Records the allocations of planned outputs in one step of an executor that
+// plans memory: `num_planned` were served from the step's slab, and
+// `num_fallback` from the device allocator.
+void RecordPlannedMemoryStep(int64 num_planned, int64 num_fallback);
+
+// Records a new memory plan, which places `total_bytes` of outputs in a slab
+// of `slab_bytes`.
+void RecordMemoryPlan(int64 total_bytes, int64 slab_bytes);
+
+// Returns the counter of planned output allocations of kind `kind`, either
+// "planned" or "fallback".
+monitoring::CounterCell* GetPlannedMemoryAllocationsCounter(const string& kind);
+
+// Returns the counter of memory plan bytes of kind `kind`, either "outputs" for
+// the outputs placed or "slab" for the slabs they were placed in.
+monitoring::CounterCell* GetMemoryPlanBytesCounter(const string& kind);
+
 // Updates the metrics stored about time spent building graphs.
 //
 // By "GraphBuild", we refer to building a client graph, which is a sub-graph of
@@ -120,6 +137,19 @@ void UpdateGrapplerPassTime(const string& pass_name,
 // Updates the metrics stored about time XLA spents compiling graphs.
 void UpdateXlaCompilationTime(const uint64 compilation_time_usecs);
 
+// Updates the number of XLA compilations waiting for, or running on, the
+// background compilation threads.
+void UpdateXlaAsyncCompilationQueueDepth(const int64 queue_depth);
+
+// Records the time from scheduling a background XLA compilation until its
+// executable became available.
+void RecordXlaAsyncCompilationLatency(const uint64 latency_usecs);
+
+// Records a compilation cache lookup of the shape bucket `bucket` of the
+// shape-bucketed XLA cluster `cluster`.
+void RecordXlaShapeBucketLookup(const string& cluster, const string& bucket,
+                                bool hit);
+
 // Increment the number of jobs that failed during import to mlir.
 void IncrementMLIRImportFailureCount();
 
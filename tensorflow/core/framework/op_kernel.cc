@@ -362,6 +362,8 @@ Allocator* OpKernelContext::get_allocator(AllocatorAttributes attr) {
   if (TF_PREDICT_FALSE(attr.scope_id > 0)) {
     allocator = params_->device->GetScopedAllocator(attr, step_id());
     CHECK(allocator);
+  } else if (attr.step_local() && params_->step_local_allocator != nullptr) {
+    allocator = params_->step_local_allocator;
   } else {
     allocator = params_->device->GetAllocator(attr);
   }
@@ -703,7 +705,13 @@ Status OpKernelContext::allocate_output(StringPiece name,
 Status OpKernelContext::allocate_tensor(
     DataType type, const TensorShape& shape, Tensor* out_tensor,
     AllocatorAttributes attr, const AllocationAttributes& allocation_attr) {
-  Allocator* a = get_allocator(attr);
+  return allocate_tensor(get_allocator(attr), type, shape, out_tensor,
+                         allocation_attr);
+}
+
+Status OpKernelContext::allocate_tensor(
+    Allocator* a, DataType type, const TensorShape& shape, Tensor* out_tensor,
+    const AllocationAttributes& allocation_attr) {
   Tensor new_tensor(a, type, shape,
                     AllocationAttributes(allocation_attr.no_retry_on_failure,
                                          /* allocation_will_be_logged= */ true,
@@ -760,7 +768,17 @@ Status OpKernelContext::allocate_output(int index, const TensorShape& shape,
   ScopedMemoryDebugAnnotation op_annotation(op_kernel().name_view().data(),
                                             step_id(), "output", type, &shape);
   auto output_tensor = MakeUnique<Tensor>();
-  Status s = allocate_tensor(type, shape, output_tensor.get(), attr);
+  // Planned allocators do not track allocation sizes, so they are bypassed
+  // when allocations are tracked.
+  Allocator* planned_allocator =
+      params_->output_allocator_array != nullptr && attr.step_local() &&
+              !track_allocations()
+          ? params_->output_allocator_array[index]
+          : nullptr;
+  Status s = planned_allocator != nullptr
+                 ? allocate_tensor(planned_allocator, type, shape,
+                                   output_tensor.get(), AllocationAttributes())
+                 : allocate_tensor(type, shape, output_tensor.get(), attr);
   if (s.ok()) {
     outputs_[index] = TensorValue(output_tensor.release());
     *output = outputs_[index].tensor;
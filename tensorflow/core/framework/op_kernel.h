@@ -635,6 +635,15 @@ class OpKernelContext {
     // Array indexed by output number for this node
     const AllocatorAttributes* output_attr_array = nullptr;
 
+    // Array indexed by output number for this node, or nullptr. A non-null
+    // entry is the allocator for a step-local output whose memory the
+    // executor has planned ahead of the step.
+    Allocator* const* output_allocator_array = nullptr;
+
+    // If not null, the allocator for outputs whose attributes are
+    // step_local(), which the executor frees in bulk when the step is done.
+    Allocator* step_local_allocator = nullptr;
+
     // Shared resources accessible by this op kernel invocation.
     ResourceMgr* resource_manager = nullptr;
 
@@ -1276,6 +1285,9 @@ class OpKernelContext {
   Status allocate_tensor(DataType type, const TensorShape& shape,
                          Tensor* out_tensor, AllocatorAttributes allocator_attr,
                          const AllocationAttributes& allocation_attr);
+  Status allocate_tensor(Allocator* a, DataType type, const TensorShape& shape,
+                         Tensor* out_tensor,
+                         const AllocationAttributes& allocation_attr);
 
   // Helpers for `set_output()`.
 
@@ -94,19 +94,31 @@ class ScopedStepContainer {
   // prefix: optional string prefix to disambiguate step containers.
   ScopedStepContainer(const int64 step_id,
                       std::function<void(const string&)> cleanup)
-      : container_(strings::StrCat("__per_step_", step_id)),
+      : container_prefix_("__per_step_"),
+        container_(strings::StrCat(container_prefix_, step_id)),
         cleanup_(cleanup),
         dirty_(false) {}
 
   ScopedStepContainer(const int64 step_id,
                       std::function<void(const string&)> cleanup,
                       const string& prefix)
-      : container_(strings::StrCat("__", prefix, "_per_step_", step_id)),
+      : container_prefix_(strings::StrCat("__", prefix, "_per_step_")),
+        container_(strings::StrCat(container_prefix_, step_id)),
         cleanup_(cleanup),
         dirty_(false) {}
 
   ~ScopedStepContainer() { CleanUp(); }
 
+  // Cleans up this container and renames it for the step `step_id`, so that
+  // callers that run many steps can reuse one ScopedStepContainer.
+  //
+  // REQUIRES: The container is not in use by any other thread.
+  void Reset(const int64 step_id) {
+    CleanUp();
+    container_.resize(container_prefix_.size());
+    strings::StrAppend(&container_, step_id);
+  }
+
   void CleanUp() TF_NO_THREAD_SAFETY_ANALYSIS {
     // NOTE(mrry): Avoid acquiring the mutex in the case that the container is
     // clean.
@@ -143,7 +155,8 @@ class ScopedStepContainer {
                         std::function<Status(T**)> creator) TF_MUST_USE_RESULT;
 
  private:
-  const string container_;
+  const string container_prefix_;
+  string container_;
   const std::function<void(const string&)> cleanup_;
   mutex mu_;
   mutable std::atomic<bool> dirty_ TF_GUARDED_BY(mu_);
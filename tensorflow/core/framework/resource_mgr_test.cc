@@ -183,6 +183,29 @@ Status ComputePolicy(const string& attr_container,
   return Status::OK();
 }
 
+TEST(ScopedStepContainerTest, Reset) {
+  ResourceMgr rm;
+  std::vector<string> cleaned_up;
+  {
+    ScopedStepContainer step_container(1, [&rm, &cleaned_up](const string& c) {
+      cleaned_up.push_back(c);
+      TF_CHECK_OK(rm.Cleanup(c));
+    });
+    TF_CHECK_OK(step_container.Create(&rm, "foo", new Resource("cat")));
+    EXPECT_EQ("R/cat", Find<Resource>(rm, "__per_step_1", "foo"));
+
+    step_container.Reset(23);
+    EXPECT_EQ(std::vector<string>({"__per_step_1"}), cleaned_up);
+    HasError(FindErr<Resource>(rm, "__per_step_1", "foo"),
+             "Not found: Container __per_step_1");
+
+    TF_CHECK_OK(step_container.Create(&rm, "foo", new Resource("dog")));
+    EXPECT_EQ("R/dog", Find<Resource>(rm, "__per_step_23", "foo"));
+  }
+  EXPECT_EQ(std::vector<string>({"__per_step_1", "__per_step_23"}),
+            cleaned_up);
+}
+
 string Policy(const string& attr_container, const string& attr_shared_name,
               bool use_node_name_as_default) {
   string ret;
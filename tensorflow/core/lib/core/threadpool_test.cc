@@ -19,6 +19,7 @@ limitations under the License.
 
 #include "absl/synchronization/barrier.h"
 #include "absl/synchronization/blocking_counter.h"
+#include "absl/synchronization/notification.h"
 #include "absl/types/optional.h"
 #include "tensorflow/core/platform/context.h"
 #include "tensorflow/core/platform/env.h"
@@ -370,6 +371,32 @@ TEST(ThreadPool, Parallelism) {
   }
 }
 
+TEST(ThreadPool, NumPendingClosures) {
+  ThreadPool pool(Env::Default(), "test", 1);
+  EXPECT_EQ(0, pool.NumPendingClosures());
+
+  // Occupy the only thread in the pool, so that subsequent closures queue up.
+  absl::Notification started;
+  absl::Notification unblock;
+  pool.Schedule([&]() {
+    started.Notify();
+    unblock.WaitForNotification();
+  });
+  started.WaitForNotification();
+  EXPECT_EQ(0, pool.NumPendingClosures());
+
+  const int kNumPending = 3;
+  absl::BlockingCounter counter(kNumPending);
+  for (int i = 0; i < kNumPending; ++i) {
+    pool.Schedule([&counter]() { counter.DecrementCount(); });
+  }
+  EXPECT_EQ(kNumPending, pool.NumPendingClosures());
+
+  unblock.Notify();
+  counter.Wait();
+  EXPECT_EQ(0, pool.NumPendingClosures());
+}
+
 static void BM_Sequential(int iters) {
   ThreadPool pool(Env::Default(), "test", kNumThreads);
   // Decrement count sequentially until 0.
@@ -87,6 +87,8 @@ class CPUIDInfo {
         have_avx512ifma_(0),
         have_avx512_4vnniw_(0),
         have_avx512_4fmaps_(0),
+        have_avx512_vnni_(0),
+        have_avx512_bf16_(0),
         have_bmi1_(0),
         have_bmi2_(0),
         have_cmov_(0),
@@ -202,6 +204,14 @@ class CPUIDInfo {
     cpuid->have_avx512ifma_ = have_avx512 && ((ebx >> 21) & 0x1);
     cpuid->have_avx512_4vnniw_ = have_avx512 && ((edx >> 2) & 0x1);
     cpuid->have_avx512_4fmaps_ = have_avx512 && ((edx >> 3) & 0x1);
+    cpuid->have_avx512_vnni_ = have_avx512 && ((ecx >> 11) & 0x1);
+
+    // Sub-leaf 1 of level 7, if present, reports the AVX-512 bfloat16
+    // extension.
+    if (eax >= 1) {
+      GETCPUID(eax, ebx, ecx, edx, 7, 1);
+      cpuid->have_avx512_bf16_ = have_avx512 && ((eax >> 5) & 0x1);
+    }
   }
 
   static bool TestFeature(CPUFeature feature) {
@@ -223,6 +233,8 @@ class CPUIDInfo {
       case AVX512IFMA:    return cpuid->have_avx512ifma_;
       case AVX512_4VNNIW: return cpuid->have_avx512_4vnniw_;
       case AVX512_4FMAPS: return cpuid->have_avx512_4fmaps_;
+      case AVX512_VNNI:   return cpuid->have_avx512_vnni_;
+      case AVX512_BF16:   return cpuid->have_avx512_bf16_;
       case BMI1:          return cpuid->have_bmi1_;
       case BMI2:          return cpuid->have_bmi2_;
       case CMOV:          return cpuid->have_cmov_;
@@ -272,6 +284,8 @@ class CPUIDInfo {
   int have_avx512ifma_ : 1;
   int have_avx512_4vnniw_ : 1;
   int have_avx512_4fmaps_ : 1;
+  int have_avx512_vnni_ : 1;
+  int have_avx512_bf16_ : 1;
   int have_bmi1_ : 1;
   int have_bmi2_ : 1;
   int have_cmov_ : 1;
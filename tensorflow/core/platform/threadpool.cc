@@ -45,10 +45,16 @@ struct EigenEnvironment {
   Env* const env_;
   const ThreadOptions thread_options_;
   const string name_;
+  // Owned by the `ThreadPool`. Incremented for each task created, and
+  // decremented when the task starts running.
+  std::atomic<int64>* const num_pending_tasks_;
 
   EigenEnvironment(Env* env, const ThreadOptions& thread_options,
-                   const string& name)
-      : env_(env), thread_options_(thread_options), name_(name) {}
+                   const string& name, std::atomic<int64>* num_pending_tasks)
+      : env_(env),
+        thread_options_(thread_options),
+        name_(name),
+        num_pending_tasks_(num_pending_tasks) {}
 
   EnvThread* CreateThread(std::function<void()> f) {
     return env_->StartThread(thread_options_, name_, [=]() {
@@ -69,6 +75,7 @@ struct EigenEnvironment {
       id = tracing::GetUniqueArg();
       tracing::RecordEvent(tracing::EventCategory::kScheduleClosure, id);
     }
+    num_pending_tasks_->fetch_add(1, std::memory_order_relaxed);
     return Task{
         std::unique_ptr<TaskImpl>(new TaskImpl{
             std::move(f),
@@ -79,6 +86,7 @@ struct EigenEnvironment {
   }
 
   void ExecuteTask(const Task& t) {
+    num_pending_tasks_->fetch_sub(1, std::memory_order_relaxed);
     WithContext wc(t.f->context);
     tracing::ScopedRegion region(tracing::EventCategory::kRunClosure,
                                  t.f->trace_id);
@@ -99,7 +107,8 @@ ThreadPool::ThreadPool(Env* env, const ThreadOptions& thread_options,
   CHECK_GE(num_threads, 1);
   eigen_threadpool_.reset(new Eigen::ThreadPoolTempl<EigenEnvironment>(
       num_threads, low_latency_hint,
-      EigenEnvironment(env, thread_options, "tf_" + name)));
+      EigenEnvironment(env, thread_options, "tf_" + name,
+                       &num_pending_closures_)));
   underlying_threadpool_ = eigen_threadpool_.get();
   threadpool_device_.reset(new Eigen::ThreadPoolDevice(underlying_threadpool_,
                                                        num_threads, allocator));
@@ -248,6 +257,10 @@ int ThreadPool::CurrentThreadId() const {
   return underlying_threadpool_->CurrentThreadId();
 }
 
+int64 ThreadPool::NumPendingClosures() const {
+  return num_pending_closures_.load(std::memory_order_relaxed);
+}
+
 void ThreadPool::ScheduleWithHint(std::function<void()> fn, int start,
                                   int limit) {
   underlying_threadpool_->ScheduleWithHint(std::move(fn), start, limit);
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_PLATFORM_THREADPOOL_H_
 #define TENSORFLOW_CORE_PLATFORM_THREADPOOL_H_
 
+#include <atomic>
 #include <functional>
 #include <memory>
 
@@ -210,6 +211,12 @@ class ThreadPool {
   // thread in the pool. Returns -1 otherwise.
   int CurrentThreadId() const;
 
+  // Returns the number of closures that have been scheduled but have not yet
+  // started running. The value is approximate when other threads are
+  // scheduling or running closures concurrently. Always returns 0 if the pool
+  // wraps a user-provided ThreadPoolInterface, whose queues are opaque.
+  int64 NumPendingClosures() const;
+
   // If ThreadPool implementation is compatible with Eigen::ThreadPoolInterface,
   // returns a non-null pointer. The caller does not own the object the returned
   // pointer points to, and should not attempt to delete.
@@ -227,6 +234,9 @@ class ThreadPool {
       const int64 total, const int64 block_size,
       const std::function<void(int64, int64)>& fn);
 
+  // Number of closures created by eigen_threadpool_ that have not started
+  // running. Declared before eigen_threadpool_ so that it outlives it.
+  std::atomic<int64> num_pending_closures_{0};
   // underlying_threadpool_ is the user_threadpool if user_threadpool is
   // provided in the constructor. Otherwise it is the eigen_threadpool_.
   Eigen::ThreadPoolInterface* underlying_threadpool_;
@@ -0,0 +1,36 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/add_model_test_util.h"
+
+namespace tflite {
+
+void AddModelTest::SetUp() {
+  model_ = FlatBufferModel::BuildFromFile(kAddModelPath);
+  ASSERT_NE(model_, nullptr);
+}
+
+void FillAddModelInput(float value, int size, float* input) {
+  for (int i = 0; i < size; ++i) {
+    input[i] = value + i;
+  }
+}
+
+void CheckAddModelOutput(float value, int size, const float* output) {
+  for (int i = 0; i < size; ++i) {
+    ASSERT_EQ(output[i], 3 * (value + i)) << "at index " << i;
+  }
+}
+
+}  // namespace tflite
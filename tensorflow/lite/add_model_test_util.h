@@ -0,0 +1,48 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_ADD_MODEL_TEST_UTIL_H_
+#define TENSORFLOW_LITE_ADD_MODEL_TEST_UTIL_H_
+
+#include <memory>
+
+#include <gtest/gtest.h>
+#include "tensorflow/lite/kernels/register.h"
+#include "tensorflow/lite/model.h"
+
+namespace tflite {
+
+// The model computes output = 3 * input, on a [1, 8, 8, 3] float tensor.
+constexpr char kAddModelPath[] = "tensorflow/lite/testdata/add.bin";
+constexpr int kAddModelExampleSize = 8 * 8 * 3;
+
+// Base fixture for the tests that serve the add model to concurrent callers.
+class AddModelTest : public ::testing::Test {
+ protected:
+  void SetUp() override;
+
+  std::unique_ptr<FlatBufferModel> model_;
+  ops::builtin::BuiltinOpResolver resolver_;
+};
+
+// Fills the `size` floats of `input` with an example starting at `value`.
+void FillAddModelInput(float value, int size, float* input);
+
+// Checks that the `size` floats of `output` are the result of the model on the
+// example filled in by FillAddModelInput(value, size, ...).
+void CheckAddModelOutput(float value, int size, const float* output);
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_ADD_MODEL_TEST_UTIL_H_
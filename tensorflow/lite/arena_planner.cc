@@ -85,6 +85,31 @@ TfLiteStatus ArenaPlanner::PlanAllocations() {
   // Keeps track of references to each tensor.
   std::vector<int> refcounts(graph_info_->num_tensors(), 0);
 
+  step_first_node_.clear();
+  step_last_node_.clear();
+  bool has_concurrent_nodes = false;
+  for (size_t i = 0; i < graph_info_->num_nodes(); ++i) {
+    const size_t step = graph_info_->node_step(i);
+    has_concurrent_nodes |= step != i;
+    if (step >= step_first_node_.size()) {
+      step_first_node_.resize(step + 1, kNodeNotAssigned);
+      step_last_node_.resize(step + 1, -1);
+    }
+    step_first_node_[step] =
+        std::min(step_first_node_[step], static_cast<int32_t>(i));
+    step_last_node_[step] =
+        std::max(step_last_node_[step], static_cast<int32_t>(i));
+  }
+  if (!has_concurrent_nodes) {
+    step_first_node_.clear();
+    step_last_node_.clear();
+  }
+  // The last step that reads each tensor, if nodes run concurrently.
+  std::vector<int32_t> last_use_step;
+  if (!step_first_node_.empty()) {
+    last_use_step.assign(graph_info_->num_tensors(), -1);
+  }
+
   auto allocate = [this](int node, int tensor) -> TfLiteStatus {
     if (alloc_node_[tensor] != kNodeNotAssigned) {
       // Tensor has already been allocated.
@@ -168,6 +193,18 @@ TfLiteStatus ArenaPlanner::PlanAllocations() {
       TF_LITE_ENSURE_STATUS(allocate(i, tensor_index));
     }
 
+    if (!last_use_step.empty()) {
+      const int32_t step = graph_info_->node_step(i);
+      TfLiteIntArray* node_inputs = node.inputs;
+      for (int j = 0; j < node_inputs->size; ++j) {
+        int tensor_index = node_inputs->data[j];
+        if (tensor_index != kTfLiteOptionalTensor) {
+          last_use_step[tensor_index] =
+              std::max(last_use_step[tensor_index], step);
+        }
+      }
+    }
+
     // Then update the ref-counts of the node's inputs, and if necessary queue
     // them for deallocation.
     if (!preserve_intermediates_) {
@@ -184,11 +221,50 @@ TfLiteStatus ArenaPlanner::PlanAllocations() {
     }
   }
 
+  if (!last_use_step.empty()) {
+    ExtendLifetimesToSteps(last_use_step);
+  }
+
   // Note that graph outputs will never be scheduled for deallocation. We
   // could do that here for completeness, but it won't have any effect.
   return kTfLiteOk;
 }
 
+void ArenaPlanner::ExtendLifetimesToSteps(
+    const std::vector<int32_t>& last_use_step) {
+  // A tensor must not share memory with any tensor used in a step during which
+  // it is alive. Since the nodes of a step may be anywhere in the graph, its
+  // lifetime has to cover all of them.
+  const int32_t num_steps = step_first_node_.size();
+  for (size_t tensor_index = 0; tensor_index < alloc_node_.size();
+       ++tensor_index) {
+    if (alloc_node_[tensor_index] == kNodeNotAssigned) continue;
+    // Tensors allocated at node 0 include the graph inputs, which are needed
+    // from the first step on.
+    const int32_t first_step =
+        alloc_node_[tensor_index] == 0
+            ? 0
+            : graph_info_->node_step(alloc_node_[tensor_index]);
+    int32_t last_step = num_steps - 1;
+    if (dealloc_node_[tensor_index] != kNodeNotAssigned) {
+      last_step =
+          std::max(last_use_step[tensor_index],
+                   static_cast<int32_t>(
+                       graph_info_->node_step(dealloc_node_[tensor_index])));
+    }
+    int32_t first_node = kNodeNotAssigned;
+    int32_t last_node = -1;
+    for (int32_t step = first_step; step <= last_step; ++step) {
+      first_node = std::min(first_node, step_first_node_[step]);
+      last_node = std::max(last_node, step_last_node_[step]);
+    }
+    alloc_node_[tensor_index] = first_node;
+    if (dealloc_node_[tensor_index] != kNodeNotAssigned) {
+      dealloc_node_[tensor_index] = last_node;
+    }
+  }
+}
+
 TfLiteStatus ArenaPlanner::ExecuteAllocations(int first_node, int last_node) {
   // Grow the size of `allocs_` if necessary. This allows allocating temporary
   // tensors in op's `prepare` function.
@@ -206,6 +282,11 @@ TfLiteStatus ArenaPlanner::ExecuteAllocations(int first_node, int last_node) {
       int tensor_index = node_temporaries->data[j];
       alloc_node_[tensor_index] = i;
       dealloc_node_[tensor_index] = i;
+      if (!step_first_node_.empty()) {
+        const size_t step = graph_info_->node_step(i);
+        alloc_node_[tensor_index] = step_first_node_[step];
+        dealloc_node_[tensor_index] = step_last_node_[step];
+      }
     }
   }
 
@@ -253,6 +334,14 @@ bool ArenaPlanner::HasNonPersistentMemory() {
   return arena_.GetBufferSize() != 0;
 }
 
+void ArenaPlanner::SetLazyCommit(bool lazy_commit) {
+  arena_.SetLazyCommit(lazy_commit);
+}
+
+TfLiteStatus ArenaPlanner::ReleaseMemoryAfter(int node) {
+  return arena_.ReleaseDeadAllocs(context_, node);
+}
+
 TfLiteStatus ArenaPlanner::Commit() {
   TF_LITE_ENSURE_STATUS(arena_.Commit(context_));
   TF_LITE_ENSURE_STATUS(persistent_arena_.Commit(context_));
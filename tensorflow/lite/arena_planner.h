@@ -43,6 +43,11 @@ struct AllocationInfo;
 // execution. Since dynamic tensors don't have sizes until after the
 // corresponding operation is executed, this class supports incremental
 // planning.
+//
+// If the graph runs nodes concurrently (see GraphInfo::node_step()), every
+// tensor is kept for the whole of each step between its first and its last
+// use, so that no two tensors used in the same step share memory. Planning
+// is then expected to cover the whole graph at once.
 class ArenaPlanner : public MemoryPlanner {
  public:
   // Ownership of 'context' is not taken and it must remain util the
@@ -63,6 +68,8 @@ class ArenaPlanner : public MemoryPlanner {
   TfLiteStatus ReleaseNonPersistentMemory() override;
   TfLiteStatus AcquireNonPersistentMemory() override;
   bool HasNonPersistentMemory() override;
+  void SetLazyCommit(bool lazy_commit) override;
+  TfLiteStatus ReleaseMemoryAfter(int node) override;
 
   // Returns the base arena location for a given allocation type.
   std::intptr_t BasePointer(TfLiteAllocationType type);
@@ -98,6 +105,10 @@ class ArenaPlanner : public MemoryPlanner {
   // 'node_index'.
   TfLiteStatus CalculateDeallocationOfInternalTensors(int node_index);
 
+  // Widens the lifetimes in `alloc_node_` and `dealloc_node_` to whole steps.
+  // `last_use_step` holds the last step that reads each tensor.
+  void ExtendLifetimesToSteps(const std::vector<int32_t>& last_use_step);
+
   TfLiteContext* context_;
   std::unique_ptr<GraphInfo> graph_info_;
 
@@ -112,6 +123,11 @@ class ArenaPlanner : public MemoryPlanner {
   // the node's operation.
   std::vector<int32_t> dealloc_node_;
 
+  // The first and the last node of each step. Empty if every node runs in a
+  // step of its own.
+  std::vector<int32_t> step_first_node_;
+  std::vector<int32_t> step_last_node_;
+
   // Raw memory buffer that is allocated for all temporary and graph outputs
   // that are declared kTfLiteArenaRw.
   SimpleMemoryArena arena_;
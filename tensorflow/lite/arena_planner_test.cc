@@ -109,12 +109,17 @@ class TestGraph {
     variables_ = variables;
   }
 
+  // Sets the step each node runs in, see GraphInfo::node_step().
+  void SetSteps(const std::vector<int>& steps) { steps_ = steps; }
+  const std::vector<int>& steps() { return steps_; }
+
   void Swap(TestGraph* other) {
     std::swap(nodes_, other->nodes_);
     std::swap(tensors_, other->tensors_);
     std::swap(inputs_, other->inputs_);
     std::swap(outputs_, other->outputs_);
     std::swap(variables_, other->variables_);
+    std::swap(steps_, other->steps_);
   }
 
  private:
@@ -123,6 +128,7 @@ class TestGraph {
   std::vector<int> inputs_;
   std::vector<int> outputs_;
   std::vector<int> variables_;
+  std::vector<int> steps_;
 };
 
 // The GraphInfo for a TestGraph.
@@ -144,6 +150,9 @@ class TestGraphInfo : public GraphInfo {
   const std::vector<int>& variables() const override {
     return graph_->variables();
   }
+  size_t node_step(size_t index) const override {
+    return graph_->steps().empty() ? index : graph_->steps()[index];
+  }
 
  private:
   TestGraph* graph_;
@@ -217,6 +226,12 @@ class ArenaPlannerTest : public ::testing::Test {
     return offset;
   }
 
+  // Returns true if the given tensors share some memory.
+  bool Overlaps(int tensor1, int tensor2) {
+    return GetOffset(tensor1) < GetOffsetAfter(tensor2) &&
+           GetOffset(tensor2) < GetOffsetAfter(tensor1);
+  }
+
   // Returns if the given tensor is unallocated or not.
   bool IsUnallocated(int tensor_index) {
     return (*graph_->tensors())[tensor_index].data.raw == nullptr;
@@ -710,6 +725,45 @@ TEST_F(ArenaPlannerTest, GraphWithIntermediates) {
   EXPECT_EQ(GetOffset(2), GetOffsetAfter(5));
 }
 
+TEST_F(ArenaPlannerTest, GraphWithConcurrentNodes) {
+  auto make_graph = [] {
+    return TestGraph({0},
+                     {
+                         /* in, out, tmp */
+                         {{0}, {1}, {}},
+                         {{1}, {2}, {}},
+                         {{0}, {3}, {4}},
+                         {{2, 3}, {5}, {}},
+                     },
+                     {5});
+  };
+
+  // Run in order, node 2 may reuse the memory of the output of node 0.
+  TestGraph sequential_graph = make_graph();
+  for (TfLiteTensor& tensor : *sequential_graph.tensors()) tensor.bytes = 16;
+  SetGraph(&sequential_graph);
+  Execute(0, 10);
+  EXPECT_TRUE(Overlaps(1, 3));
+
+  // Nodes 0 and 2 run in the same step, so none of the tensors they use may
+  // share memory, and the output of node 0 is alive until node 1 is done.
+  TestGraph graph = make_graph();
+  for (TfLiteTensor& tensor : *graph.tensors()) tensor.bytes = 16;
+  graph.SetSteps({0, 1, 0, 2});
+  SetGraph(&graph);
+  Execute(0, 10);
+  for (int tensor1 : {0, 1, 3, 4}) {
+    for (int tensor2 : {0, 1, 3, 4}) {
+      if (tensor1 != tensor2) {
+        EXPECT_FALSE(Overlaps(tensor1, tensor2)) << tensor1 << ", " << tensor2;
+      }
+    }
+  }
+  EXPECT_FALSE(Overlaps(1, 2));
+  EXPECT_FALSE(Overlaps(2, 3));
+  EXPECT_FALSE(Overlaps(3, 5));
+}
+
 }  // namespace
 }  // namespace tflite
 
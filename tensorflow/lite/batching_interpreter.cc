@@ -0,0 +1,301 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/batching_interpreter.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstring>
+#include <functional>
+#include <utility>
+
+namespace tflite {
+namespace {
+
+// Returns in `row_bytes` the size of one example's row of each of `tensors`,
+// which must have `batch_size` as their first dimension. If `row_bytes` is
+// already filled in, e.g. for another batch size, checks that it matches.
+TfLiteStatus GetRowBytes(const Interpreter& interpreter,
+                         const std::vector<int>& tensors, int batch_size,
+                         ErrorReporter* error_reporter,
+                         std::vector<size_t>* row_bytes) {
+  const bool check_only = !row_bytes->empty();
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    const TfLiteTensor* tensor = interpreter.tensor(tensors[i]);
+    if (tensor->type == kTfLiteString ||
+        tensor->allocation_type == kTfLiteDynamic) {
+      TF_LITE_REPORT_ERROR(error_reporter,
+                           "Can't batch tensor %s, whose size is only known "
+                           "once the model runs.",
+                           tensor->name ? tensor->name : "");
+      return kTfLiteError;
+    }
+    if (tensor->dims->size < 1 || tensor->dims->data[0] != batch_size ||
+        tensor->data.raw == nullptr) {
+      TF_LITE_REPORT_ERROR(error_reporter,
+                           "Can't batch tensor %s, whose first dimension "
+                           "isn't the batch size.",
+                           tensor->name ? tensor->name : "");
+      return kTfLiteError;
+    }
+    const size_t bytes = tensor->bytes / batch_size;
+    if (!check_only) {
+      row_bytes->push_back(bytes);
+    } else if ((*row_bytes)[i] != bytes) {
+      TF_LITE_REPORT_ERROR(error_reporter,
+                           "Tensor %s has a different size per example for "
+                           "batch size %d.",
+                           tensor->name ? tensor->name : "", batch_size);
+      return kTfLiteError;
+    }
+  }
+  return kTfLiteOk;
+}
+
+}  // namespace
+
+struct BatchingInterpreter::Request {
+  const std::vector<const void*>* inputs;
+  const std::vector<void*>* outputs;
+  std::chrono::steady_clock::time_point enqueue_time;
+  TfLiteStatus status = kTfLiteOk;
+  bool done = false;
+  std::condition_variable done_cv;
+};
+
+std::unique_ptr<BatchingInterpreter> BatchingInterpreter::Create(
+    const FlatBufferModel& model, const OpResolver& op_resolver,
+    const Options& options) {
+  ErrorReporter* error_reporter = model.error_reporter()
+                                      ? model.error_reporter()
+                                      : DefaultErrorReporter();
+  const std::vector<int>& batch_sizes = options.allowed_batch_sizes;
+  if (batch_sizes.empty() || batch_sizes.front() < 1 ||
+      std::adjacent_find(batch_sizes.begin(), batch_sizes.end(),
+                         std::greater_equal<int>()) != batch_sizes.end()) {
+    TF_LITE_REPORT_ERROR(error_reporter,
+                         "allowed_batch_sizes should be positive and in "
+                         "increasing order.");
+    return nullptr;
+  }
+  if (options.batch_timeout_micros < 0) {
+    TF_LITE_REPORT_ERROR(error_reporter,
+                         "batch_timeout_micros should be >= 0.");
+    return nullptr;
+  }
+  if (options.num_batch_threads < 1) {
+    TF_LITE_REPORT_ERROR(error_reporter, "num_batch_threads should be >= 1.");
+    return nullptr;
+  }
+  if (options.num_threads < 1 && options.num_threads != -1) {
+    TF_LITE_REPORT_ERROR(error_reporter,
+                         "num_threads should be >= 1 or just -1 to let TFLite "
+                         "runtime set the value.");
+    return nullptr;
+  }
+  if (options.num_threads != -1 &&
+      options.num_threads < options.num_batch_threads) {
+    // Every batch thread needs at least one thread, so the batches would run
+    // on more threads than num_threads.
+    TF_LITE_REPORT_ERROR(error_reporter,
+                         "num_threads (%d) should be >= num_batch_threads "
+                         "(%d), or -1.",
+                         options.num_threads, options.num_batch_threads);
+    return nullptr;
+  }
+
+  std::unique_ptr<BatchingInterpreter> batcher(
+      new BatchingInterpreter(model, options));
+  for (int i = 0; i < options.num_batch_threads; ++i) {
+    std::unique_ptr<BatchThreadState> state(new BatchThreadState);
+    if (batcher->BuildInterpreters(model, op_resolver, state.get()) !=
+        kTfLiteOk) {
+      return nullptr;
+    }
+    batcher->batch_thread_states_.push_back(std::move(state));
+  }
+  for (auto& state : batcher->batch_thread_states_) {
+    BatchThreadState* state_ptr = state.get();
+    BatchingInterpreter* batcher_ptr = batcher.get();
+    batcher->batch_threads_.emplace_back(
+        [batcher_ptr, state_ptr] { batcher_ptr->BatchThreadMain(state_ptr); });
+  }
+  return batcher;
+}
+
+BatchingInterpreter::BatchingInterpreter(const FlatBufferModel& model,
+                                         const Options& options)
+    : error_reporter_(model.error_reporter() ? model.error_reporter()
+                                             : DefaultErrorReporter()),
+      allowed_batch_sizes_(options.allowed_batch_sizes),
+      batch_timeout_micros_(options.batch_timeout_micros),
+      num_threads_per_batch_thread_(
+          options.num_threads == -1
+              ? -1
+              : options.num_threads / options.num_batch_threads) {}
+
+BatchingInterpreter::~BatchingInterpreter() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  queue_cv_.notify_all();
+  for (std::thread& thread : batch_threads_) {
+    thread.join();
+  }
+}
+
+TfLiteStatus BatchingInterpreter::BuildInterpreters(
+    const FlatBufferModel& model, const OpResolver& op_resolver,
+    BatchThreadState* state) {
+  for (int batch_size : allowed_batch_sizes_) {
+    std::unique_ptr<Interpreter> interpreter;
+    InterpreterBuilder builder(model, op_resolver);
+    if (builder(&interpreter, num_threads_per_batch_thread_) != kTfLiteOk) {
+      TF_LITE_REPORT_ERROR(error_reporter_,
+                           "Failed to build an interpreter for batching.");
+      return kTfLiteError;
+    }
+    interpreter->SetExternalContext(kTfLiteCpuBackendContext,
+                                    &state->cpu_backend_context);
+    for (int input : interpreter->inputs()) {
+      const TfLiteIntArray* dims = interpreter->tensor(input)->dims;
+      if (dims->size < 1) {
+        TF_LITE_REPORT_ERROR(error_reporter_,
+                             "Can't batch an input without dimensions.");
+        return kTfLiteError;
+      }
+      std::vector<int> batched_dims(dims->data, dims->data + dims->size);
+      batched_dims[0] = batch_size;
+      TF_LITE_ENSURE_STATUS(
+          interpreter->ResizeInputTensor(input, batched_dims));
+    }
+    if (interpreter->AllocateTensors() != kTfLiteOk) {
+      TF_LITE_REPORT_ERROR(error_reporter_,
+                           "Failed to allocate tensors for batch size %d.",
+                           batch_size);
+      return kTfLiteError;
+    }
+    TF_LITE_ENSURE_STATUS(GetRowBytes(*interpreter, interpreter->inputs(),
+                                      batch_size, error_reporter_,
+                                      &input_bytes_));
+    TF_LITE_ENSURE_STATUS(GetRowBytes(*interpreter, interpreter->outputs(),
+                                      batch_size, error_reporter_,
+                                      &output_bytes_));
+    state->interpreters.push_back(std::move(interpreter));
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus BatchingInterpreter::Invoke(const std::vector<const void*>& inputs,
+                                         const std::vector<void*>& outputs) {
+  if (inputs.size() != input_bytes_.size() ||
+      outputs.size() != output_bytes_.size()) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Expected %d inputs and %d outputs, got %d and %d.",
+                         inputs_size(), outputs_size(),
+                         static_cast<int>(inputs.size()),
+                         static_cast<int>(outputs.size()));
+    return kTfLiteError;
+  }
+  Request request;
+  request.inputs = &inputs;
+  request.outputs = &outputs;
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  request.enqueue_time = std::chrono::steady_clock::now();
+  queue_.push_back(&request);
+  // Wake the batch threads when a batch starts, so that one of them starts its
+  // timeout, and when it is full, so that it doesn't wait any longer.
+  if (queue_.size() == 1 ||
+      queue_.size() >= static_cast<size_t>(allowed_batch_sizes_.back())) {
+    queue_cv_.notify_all();
+  }
+  request.done_cv.wait(lock, [&request] { return request.done; });
+  return request.status;
+}
+
+int64_t BatchingInterpreter::num_batches() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_batches_;
+}
+
+int64_t BatchingInterpreter::num_requests() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_requests_;
+}
+
+void BatchingInterpreter::BatchThreadMain(BatchThreadState* state) {
+  const size_t max_batch_size = allowed_batch_sizes_.back();
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    queue_cv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+    if (queue_.empty()) return;
+
+    // Give the batch until its first request times out to fill up.
+    const auto deadline = queue_.front()->enqueue_time +
+                          std::chrono::microseconds(batch_timeout_micros_);
+    queue_cv_.wait_until(lock, deadline, [this, max_batch_size] {
+      return stopping_ || queue_.empty() || queue_.size() >= max_batch_size;
+    });
+    // Another batch thread may have taken the requests meanwhile.
+    if (queue_.empty()) continue;
+
+    const size_t batch_size = std::min(queue_.size(), max_batch_size);
+    std::vector<Request*> batch(queue_.begin(), queue_.begin() + batch_size);
+    queue_.erase(queue_.begin(), queue_.begin() + batch_size);
+
+    lock.unlock();
+    const TfLiteStatus status = RunBatch(state, batch);
+    lock.lock();
+
+    ++num_batches_;
+    num_requests_ += batch_size;
+    for (Request* request : batch) {
+      request->status = status;
+      request->done = true;
+      request->done_cv.notify_one();
+    }
+  }
+}
+
+TfLiteStatus BatchingInterpreter::RunBatch(BatchThreadState* state,
+                                           const std::vector<Request*>& batch) {
+  const size_t batch_index =
+      std::lower_bound(allowed_batch_sizes_.begin(),
+                       allowed_batch_sizes_.end(),
+                       static_cast<int>(batch.size())) -
+      allowed_batch_sizes_.begin();
+  Interpreter* interpreter = state->interpreters[batch_index].get();
+
+  for (size_t i = 0; i < input_bytes_.size(); ++i) {
+    char* data = interpreter->tensor(interpreter->inputs()[i])->data.raw;
+    for (size_t row = 0; row < batch.size(); ++row) {
+      std::memcpy(data + row * input_bytes_[i], (*batch[row]->inputs)[i],
+                  input_bytes_[i]);
+    }
+  }
+  TF_LITE_ENSURE_STATUS(interpreter->Invoke());
+  for (size_t i = 0; i < output_bytes_.size(); ++i) {
+    const char* data =
+        interpreter->tensor(interpreter->outputs()[i])->data.raw;
+    for (size_t row = 0; row < batch.size(); ++row) {
+      std::memcpy((*batch[row]->outputs)[i], data + row * output_bytes_[i],
+                  output_bytes_[i]);
+    }
+  }
+  return kTfLiteOk;
+}
+
+}  // namespace tflite
@@ -0,0 +1,166 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+/// \file
+/// Provides a front-end that batches concurrent single-example requests to a
+/// model.
+///
+#ifndef TENSORFLOW_LITE_BATCHING_INTERPRETER_H_
+#define TENSORFLOW_LITE_BATCHING_INTERPRETER_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/core/api/error_reporter.h"
+#include "tensorflow/lite/core/api/op_resolver.h"
+#include "tensorflow/lite/external_cpu_backend_context.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/model.h"
+
+namespace tflite {
+
+/// Runs a model on requests of one example each, gathering the requests that
+/// arrive close together into a batch and invoking the model once for all of
+/// them. The first dimension of every input and output tensor of the model is
+/// taken as the batch dimension, and examples must not depend on each other
+/// along it.
+///
+/// Resizing the inputs of an interpreter to the size of every batch would
+/// prepare the graph and plan its memory again on each invocation. Instead, the
+/// model is prepared once for each of `allowed_batch_sizes`, with an
+/// interpreter per batch size. A batch of n requests runs on the smallest
+/// batch size >= n; the rows of the remaining examples are left as they are,
+/// and their results are dropped. All the interpreters are built from the same
+/// FlatBufferModel, so the weights are only held once.
+///
+/// Batches are formed the way the TensorFlow `BasicBatchScheduler` forms them:
+/// a batch runs as soon as it reaches the largest allowed batch size, or once
+/// its first request has waited `batch_timeout_micros`. Each of
+/// `num_batch_threads` threads runs one batch at a time, with its own set of
+/// interpreters.
+///
+/// Example:
+///
+/// <pre><code>
+/// auto batcher = tflite::BatchingInterpreter::Create(*model, resolver,
+///                                                    options);
+/// // On each request thread, with one example worth of data for every model
+/// // input and output:
+/// if (batcher->Invoke({input_data}, {output_data}) != kTfLiteOk) {
+///   ... // error
+/// }
+/// </code></pre>
+class BatchingInterpreter {
+ public:
+  struct Options {
+    // Batch sizes the model is prepared for, in increasing order. The largest
+    // one is the maximum number of requests in a batch.
+    std::vector<int> allowed_batch_sizes = {1, 2, 4, 8};
+    // How long the first request of a batch waits for more requests before
+    // the batch runs anyway. 0 runs whatever is queued right away.
+    int64_t batch_timeout_micros = 1000;
+    // Number of batches that run concurrently.
+    int num_batch_threads = 1;
+    // Number of threads shared by all the batch threads, each of which gets
+    // `num_threads / num_batch_threads`. It may not be less than
+    // `num_batch_threads`. -1 lets every batch thread use the TFLite default.
+    int num_threads = -1;
+  };
+
+  /// Creates a batching interpreter for `model`, and prepares the model for
+  /// every allowed batch size. Returns nullptr on failure, e.g. if a tensor
+  /// has no batch dimension or an output's size isn't known before invoking.
+  /// Failures are reported to the model's error reporter. `model` must outlive
+  /// the batching interpreter.
+  static std::unique_ptr<BatchingInterpreter> Create(
+      const FlatBufferModel& model, const OpResolver& op_resolver,
+      const Options& options);
+
+  /// Runs the requests still queued, then stops the batch threads. No call to
+  /// Invoke() may start once the destructor has been entered.
+  ~BatchingInterpreter();
+  BatchingInterpreter(const BatchingInterpreter&) = delete;
+  BatchingInterpreter& operator=(const BatchingInterpreter&) = delete;
+
+  /// Runs the model on one example. `inputs[i]` holds the `input_bytes(i)`
+  /// bytes of the example's row of the i-th model input, and `outputs[i]`
+  /// receives the `output_bytes(i)` bytes of its row of the i-th model output.
+  /// Blocks until the batch holding the request has run. Thread-safe.
+  TfLiteStatus Invoke(const std::vector<const void*>& inputs,
+                      const std::vector<void*>& outputs);
+
+  /// Number of model inputs and outputs, and the size of one example's row of
+  /// each of them.
+  int inputs_size() const { return input_bytes_.size(); }
+  int outputs_size() const { return output_bytes_.size(); }
+  size_t input_bytes(int index) const { return input_bytes_[index]; }
+  size_t output_bytes(int index) const { return output_bytes_[index]; }
+
+  /// Number of batches and requests run so far. Thread-safe.
+  int64_t num_batches() const;
+  int64_t num_requests() const;
+
+ private:
+  struct Request;
+  // The interpreters a batch thread runs its batches on, one per allowed
+  // batch size. They never run at the same time, so they share one CPU
+  // backend context.
+  struct BatchThreadState {
+    ExternalCpuBackendContext cpu_backend_context;
+    std::vector<std::unique_ptr<Interpreter>> interpreters;
+  };
+
+  BatchingInterpreter(const FlatBufferModel& model, const Options& options);
+
+  // Builds the interpreters of `state`, and checks that the model can be
+  // batched.
+  TfLiteStatus BuildInterpreters(const FlatBufferModel& model,
+                                 const OpResolver& op_resolver,
+                                 BatchThreadState* state);
+
+  void BatchThreadMain(BatchThreadState* state);
+
+  // Copies the inputs of `batch` into a batch, invokes it and copies the
+  // outputs back. Called without holding `mutex_`.
+  TfLiteStatus RunBatch(BatchThreadState* state,
+                        const std::vector<Request*>& batch);
+
+  ErrorReporter* error_reporter_;
+  const std::vector<int> allowed_batch_sizes_;
+  const int64_t batch_timeout_micros_;
+  const int num_threads_per_batch_thread_;
+  std::vector<size_t> input_bytes_;
+  std::vector<size_t> output_bytes_;
+
+  std::vector<std::unique_ptr<BatchThreadState>> batch_thread_states_;
+  std::vector<std::thread> batch_threads_;
+
+  mutable std::mutex mutex_;
+  // Signaled when a request is queued or the batch threads should stop.
+  std::condition_variable queue_cv_;
+  std::deque<Request*> queue_;
+  bool stopping_ = false;
+  int64_t num_batches_ = 0;
+  int64_t num_requests_ = 0;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_BATCHING_INTERPRETER_H_
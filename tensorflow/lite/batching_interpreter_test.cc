@@ -0,0 +1,175 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/batching_interpreter.h"
+
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/lite/add_model_test_util.h"
+#include "tensorflow/lite/testing/util.h"
+
+namespace tflite {
+namespace {
+
+constexpr int kExampleSize = kAddModelExampleSize;
+
+class BatchingInterpreterTest : public AddModelTest {
+ protected:
+  std::unique_ptr<BatchingInterpreter> CreateBatcher(
+      const BatchingInterpreter::Options& options) {
+    return BatchingInterpreter::Create(*model_, resolver_, options);
+  }
+};
+
+// Runs the model on one example starting at `value` and checks the result.
+// The output buffer is followed by a guard area that must be left untouched.
+void InvokeAndCheck(BatchingInterpreter* batcher, float value) {
+  constexpr int kGuardSize = 16;
+  constexpr float kGuardValue = -1.f;
+  std::vector<float> input(kExampleSize);
+  std::vector<float> output(kExampleSize + kGuardSize, kGuardValue);
+  FillAddModelInput(value, kExampleSize, input.data());
+  ASSERT_EQ(batcher->Invoke({input.data()}, {output.data()}), kTfLiteOk);
+  CheckAddModelOutput(value, kExampleSize, output.data());
+  for (int i = kExampleSize; i < kExampleSize + kGuardSize; ++i) {
+    ASSERT_EQ(output[i], kGuardValue);
+  }
+}
+
+// Sends one request per value concurrently, and checks every result.
+void InvokeConcurrentlyAndCheck(BatchingInterpreter* batcher,
+                                const std::vector<float>& values) {
+  std::vector<std::thread> callers;
+  for (float value : values) {
+    callers.emplace_back(
+        [batcher, value] { InvokeAndCheck(batcher, value); });
+  }
+  for (std::thread& caller : callers) {
+    caller.join();
+  }
+}
+
+TEST_F(BatchingInterpreterTest, InvalidOptions) {
+  BatchingInterpreter::Options options;
+  options.allowed_batch_sizes = {};
+  EXPECT_EQ(CreateBatcher(options), nullptr);
+  options.allowed_batch_sizes = {0, 2};
+  EXPECT_EQ(CreateBatcher(options), nullptr);
+  options.allowed_batch_sizes = {4, 2};
+  EXPECT_EQ(CreateBatcher(options), nullptr);
+  options.allowed_batch_sizes = {2, 2};
+  EXPECT_EQ(CreateBatcher(options), nullptr);
+
+  options.allowed_batch_sizes = {1, 2};
+  options.num_batch_threads = 0;
+  EXPECT_EQ(CreateBatcher(options), nullptr);
+  options.num_batch_threads = 1;
+  options.batch_timeout_micros = -1;
+  EXPECT_EQ(CreateBatcher(options), nullptr);
+  options.batch_timeout_micros = 0;
+  options.num_threads = 0;
+  EXPECT_EQ(CreateBatcher(options), nullptr);
+  // Each batch thread would need a thread of its own beyond the budget.
+  options.num_batch_threads = 4;
+  options.num_threads = 2;
+  EXPECT_EQ(CreateBatcher(options), nullptr);
+}
+
+TEST_F(BatchingInterpreterTest, RowSizes) {
+  auto batcher = CreateBatcher(BatchingInterpreter::Options());
+  ASSERT_NE(batcher, nullptr);
+  ASSERT_EQ(batcher->inputs_size(), 1);
+  ASSERT_EQ(batcher->outputs_size(), 1);
+  EXPECT_EQ(batcher->input_bytes(0), kExampleSize * sizeof(float));
+  EXPECT_EQ(batcher->output_bytes(0), kExampleSize * sizeof(float));
+}
+
+TEST_F(BatchingInterpreterTest, WrongNumberOfBuffers) {
+  auto batcher = CreateBatcher(BatchingInterpreter::Options());
+  ASSERT_NE(batcher, nullptr);
+  std::vector<float> data(kExampleSize);
+  EXPECT_EQ(batcher->Invoke({}, {data.data()}), kTfLiteError);
+  EXPECT_EQ(batcher->Invoke({data.data(), data.data()}, {data.data()}),
+            kTfLiteError);
+  EXPECT_EQ(batcher->num_requests(), 0);
+}
+
+TEST_F(BatchingInterpreterTest, SingleRequestRunsAfterTimeout) {
+  BatchingInterpreter::Options options;
+  options.allowed_batch_sizes = {2, 4};
+  options.batch_timeout_micros = 10;
+  auto batcher = CreateBatcher(options);
+  ASSERT_NE(batcher, nullptr);
+
+  // Each request runs on its own, padded to a batch of 2.
+  InvokeAndCheck(batcher.get(), 1.f);
+  InvokeAndCheck(batcher.get(), 2.f);
+  EXPECT_EQ(batcher->num_batches(), 2);
+  EXPECT_EQ(batcher->num_requests(), 2);
+}
+
+TEST_F(BatchingInterpreterTest, PaddedRowsDoNotReachSmallerBatches) {
+  BatchingInterpreter::Options options;
+  // Every batch runs on the same interpreter, so the padded rows of a small
+  // batch still hold the examples of the earlier, larger one.
+  options.allowed_batch_sizes = {4};
+  options.batch_timeout_micros = 200000;
+  auto batcher = CreateBatcher(options);
+  ASSERT_NE(batcher, nullptr);
+
+  InvokeConcurrentlyAndCheck(batcher.get(), {100.f, 200.f, 300.f, 400.f});
+  EXPECT_EQ(batcher->num_batches(), 1);
+  InvokeConcurrentlyAndCheck(batcher.get(), {1.f, 2.f, 3.f});
+  InvokeAndCheck(batcher.get(), 4.f);
+  EXPECT_EQ(batcher->num_requests(), 8);
+}
+
+TEST_F(BatchingInterpreterTest, ConcurrentRequestsAreBatched) {
+  constexpr int kNumCallers = 8;
+  constexpr int kNumRuns = 20;
+  BatchingInterpreter::Options options;
+  options.allowed_batch_sizes = {1, 2, 4, 8};
+  // Long enough for requests to pile up, without slowing the test down as
+  // full batches run right away.
+  options.batch_timeout_micros = 20000;
+  options.num_batch_threads = 2;
+  auto batcher = CreateBatcher(options);
+  ASSERT_NE(batcher, nullptr);
+
+  std::vector<std::thread> callers;
+  for (int caller = 0; caller < kNumCallers; ++caller) {
+    callers.emplace_back([&batcher, caller] {
+      for (int i = 0; i < kNumRuns; ++i) {
+        InvokeAndCheck(batcher.get(), caller * 100 + i);
+      }
+    });
+  }
+  for (std::thread& caller : callers) {
+    caller.join();
+  }
+  EXPECT_EQ(batcher->num_requests(), kNumCallers * kNumRuns);
+  EXPECT_LT(batcher->num_batches(), batcher->num_requests());
+}
+
+}  // namespace
+}  // namespace tflite
+
+int main(int argc, char** argv) {
+  ::tflite::LogToStderr();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
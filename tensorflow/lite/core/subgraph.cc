@@ -149,7 +149,11 @@ const char* GetTFLiteOpName(const TfLiteRegistration& op_reg) {
 // indices.
 class InterpreterInfo : public GraphInfo {
  public:
-  explicit InterpreterInfo(Subgraph* subgraph) : subgraph_(subgraph) {}
+  // `steps`, if not null, holds the step of each node of the execution plan,
+  // or is empty if the nodes run one at a time.
+  explicit InterpreterInfo(Subgraph* subgraph,
+                           const std::vector<int>* steps = nullptr)
+      : subgraph_(subgraph), steps_(steps) {}
 
   size_t num_tensors() const override { return subgraph_->tensors().size(); }
   TfLiteTensor* tensor(size_t index) override {
@@ -174,9 +178,17 @@ class InterpreterInfo : public GraphInfo {
   const std::vector<int>& variables() const override {
     return subgraph_->variables();
   }
+  size_t node_step(size_t index) const override {
+    // The steps may be stale while the execution plan is being changed.
+    if (!steps_ || steps_->size() != subgraph_->execution_plan().size()) {
+      return index;
+    }
+    return (*steps_)[index];
+  }
 
  public:
   Subgraph* subgraph_;
+  const std::vector<int>* steps_;
 };
 
 Subgraph::Subgraph(ErrorReporter* error_reporter,
@@ -413,6 +425,13 @@ TfLiteStatus Subgraph::ReplaceNodeSubsetsWithDelegateKernels(
 TfLiteExternalContext* Subgraph::GetExternalContext(
     TfLiteExternalContextType type) {
   if (static_cast<int>(type) >= 0 && type < kTfLiteMaxExternalContexts) {
+    // Kernels running concurrently must not share a cpu backend context.
+    if (type == kTfLiteCpuBackendContext && inter_op_thread_pool_) {
+      const int thread_index = inter_op_thread_pool_->CurrentThreadIndex();
+      if (thread_index > 0) {
+        return inter_op_cpu_backend_contexts_[thread_index - 1].get();
+      }
+    }
     return external_contexts_[type];
   }
   return nullptr;
@@ -541,6 +560,162 @@ bool Subgraph::IsCancelled() {
          (*check_cancelled_func_)(cancellation_data_);
 }
 
+TfLiteStatus Subgraph::SetNumInterOpThreads(int num_threads) {
+  if (num_threads < 1) {
+    ReportError("num_inter_op_threads should be >= 1.");
+    return kTfLiteError;
+  }
+  if (num_threads == num_inter_op_threads_) return kTfLiteOk;
+  num_inter_op_threads_ = num_threads;
+  inter_op_thread_pool_.reset();
+  inter_op_cpu_backend_contexts_.clear();
+  state_ = kStateUninvokable;
+  return kTfLiteOk;
+}
+
+TfLiteStatus Subgraph::SetLazyArenaCommit(bool lazy_arena_commit) {
+  if (lazy_arena_commit == lazy_arena_commit_) return kTfLiteOk;
+  lazy_arena_commit_ = lazy_arena_commit;
+  if (memory_planner_) memory_planner_->SetLazyCommit(lazy_arena_commit_);
+  state_ = kStateUninvokable;
+  return kTfLiteOk;
+}
+
+bool Subgraph::BuildInterOpSchedule() {
+  std::vector<int> steps;
+  std::vector<std::vector<int>> step_nodes;
+  if (num_inter_op_threads_ > 1) {
+    // The first step in which a node may read each tensor, i.e. the one after
+    // the step writing it, and the first step in which a node may overwrite
+    // it, i.e. the one after the last step reading it.
+    std::vector<int> readable_step(tensors_.size(), 0);
+    std::vector<int> writable_step(tensors_.size(), 0);
+    // Nodes that run on their own wait for all the previous nodes, and all
+    // the following nodes wait for them.
+    int first_free_step = 0;
+    steps.resize(execution_plan_.size());
+    for (int execution_plan_index = 0;
+         execution_plan_index < execution_plan_.size();
+         execution_plan_index++) {
+      int node_index = execution_plan_[execution_plan_index];
+      const TfLiteNode& node = nodes_and_registration_[node_index].first;
+      const TfLiteRegistration& registration =
+          nodes_and_registration_[node_index].second;
+      // Custom ops may have side effects we can't see, control flow ops
+      // invoke other subgraphs, and delegate kernels manage their own
+      // threads and buffers.
+      const bool runs_alone =
+          node.delegate != nullptr ||
+          registration.builtin_code == BuiltinOperator_CUSTOM ||
+          registration.builtin_code == BuiltinOperator_IF ||
+          registration.builtin_code == BuiltinOperator_WHILE;
+
+      int step = runs_alone ? step_nodes.size() : first_free_step;
+      for (int tensor_index : TfLiteIntArrayView(node.inputs)) {
+        if (tensor_index == kTfLiteOptionalTensor) continue;
+        step = std::max(step, readable_step[tensor_index]);
+        // Variable tensors are updated in place.
+        if (tensors_[tensor_index].is_variable) {
+          step = std::max(step, writable_step[tensor_index]);
+        }
+      }
+      for (const TfLiteIntArray* tensors : {node.outputs, node.intermediates}) {
+        for (int tensor_index : TfLiteIntArrayView(tensors)) {
+          if (tensor_index == kTfLiteOptionalTensor) continue;
+          step = std::max(step, std::max(readable_step[tensor_index],
+                                         writable_step[tensor_index]));
+        }
+      }
+
+      for (int tensor_index : TfLiteIntArrayView(node.inputs)) {
+        if (tensor_index == kTfLiteOptionalTensor) continue;
+        writable_step[tensor_index] =
+            std::max(writable_step[tensor_index], step + 1);
+        if (tensors_[tensor_index].is_variable) {
+          readable_step[tensor_index] = step + 1;
+        }
+      }
+      for (const TfLiteIntArray* tensors : {node.outputs, node.intermediates}) {
+        for (int tensor_index : TfLiteIntArrayView(tensors)) {
+          if (tensor_index == kTfLiteOptionalTensor) continue;
+          readable_step[tensor_index] = step + 1;
+          writable_step[tensor_index] = step + 1;
+        }
+      }
+      if (runs_alone) first_free_step = step + 1;
+
+      steps[execution_plan_index] = step;
+      if (step >= step_nodes.size()) step_nodes.resize(step + 1);
+      step_nodes[step].push_back(execution_plan_index);
+    }
+    // Without concurrent nodes the schedule would only add overhead.
+    if (step_nodes.size() == execution_plan_.size()) {
+      steps.clear();
+      step_nodes.clear();
+    }
+  }
+
+  if (steps == inter_op_steps_) return false;
+  inter_op_steps_ = std::move(steps);
+  inter_op_step_nodes_ = std::move(step_nodes);
+  return true;
+}
+
+TfLiteStatus Subgraph::InvokeInterOpSchedule() {
+  if (!inter_op_thread_pool_) {
+    inter_op_thread_pool_.reset(new InterOpThreadPool(num_inter_op_threads_));
+    inter_op_cpu_backend_contexts_.clear();
+    for (int i = 1; i < num_inter_op_threads_; ++i) {
+      inter_op_cpu_backend_contexts_.emplace_back(
+          new ExternalCpuBackendContext());
+    }
+  }
+
+  for (const std::vector<int>& step : inter_op_step_nodes_) {
+    for (int execution_plan_index : step) {
+      int node_index = execution_plan_[execution_plan_index];
+      TF_LITE_ENSURE_STATUS(EnsureInputDataIsReadable(
+          nodes_and_registration_[node_index].first));
+    }
+
+    if (IsCancelled()) {
+      ReportError("Client requested cancel during Invoke()");
+      return kTfLiteError;
+    }
+
+    EnsureTensorsVectorCapacity();
+    inter_op_statuses_.assign(step.size(), kTfLiteOk);
+    inter_op_thread_pool_->Run(step.size(), [this, &step](int i) {
+      int node_index = execution_plan_[step[i]];
+      auto& node_and_registration = nodes_and_registration_[node_index];
+      inter_op_statuses_[i] = OpInvoke(node_and_registration.second,
+                                       &node_and_registration.first);
+    });
+
+    for (size_t i = 0; i < step.size(); ++i) {
+      if (inter_op_statuses_[i] != kTfLiteOk) {
+        int node_index = execution_plan_[step[i]];
+        const TfLiteNode& node = nodes_and_registration_[node_index].first;
+        const TfLiteRegistration& registration =
+            nodes_and_registration_[node_index].second;
+        return ReportOpError(&context_, node, registration, node_index,
+                             "failed to invoke");
+      }
+    }
+  }
+  return kTfLiteOk;
+}
+
+void Subgraph::RefreshInterOpCpuBackendContexts() {
+  if (context_.recommended_num_threads == -1) return;
+  for (const auto& external_context : inter_op_cpu_backend_contexts_) {
+    if (external_context->internal_backend_context()) {
+      external_context->internal_backend_context()->SetMaxNumThreads(
+          context_.recommended_num_threads);
+    }
+  }
+}
+
 void Subgraph::ReserveNodes(int count) {
   nodes_and_registration_.reserve(count);
 }
@@ -641,8 +816,24 @@ TfLiteStatus Subgraph::AllocateTensors() {
     TF_LITE_ENSURE_STATUS(memory_planner_->ResetAllocations());
   }
 
+  // The memory plan depends on which nodes may run concurrently.
+  if (BuildInterOpSchedule() && memory_planner_) {
+    TF_LITE_ENSURE_STATUS(memory_planner_->PlanAllocations());
+  }
+
   TF_LITE_ENSURE_STATUS(PrepareOpsAndTensors());
 
+  // Dynamic tensors are only allocated while the graph is being invoked, one
+  // node at a time, so such graphs fall back to running sequentially.
+  if (!inter_op_steps_.empty() && has_dynamic_tensors_) {
+    inter_op_steps_.clear();
+    inter_op_step_nodes_.clear();
+    next_execution_plan_index_to_prepare_ = 0;
+    next_execution_plan_index_to_plan_allocation_ = 0;
+    TF_LITE_ENSURE_STATUS(memory_planner_->PlanAllocations());
+    TF_LITE_ENSURE_STATUS(PrepareOpsAndTensors());
+  }
+
   state_ = kStateInvokable;
 
   // Reset the variable tensors to zero after (re)allocating the tensors.
@@ -828,6 +1019,25 @@ TfLiteStatus Subgraph::OpPrepare(const TfLiteRegistration& op_reg,
   return op_reg.prepare(&context_, node);
 }
 
+TfLiteStatus Subgraph::EnsureInputDataIsReadable(const TfLiteNode& node) {
+  // TODO(ycling): This is an extra loop through inputs to check if the data
+  // need to be copied from Delegate buffer to raw memory, which is often not
+  // needed. We may want to cache this in prepare to know if this needs to be
+  // done for a node or not.
+  for (int i = 0; i < node.inputs->size; ++i) {
+    int tensor_index = node.inputs->data[i];
+    if (tensor_index == kTfLiteOptionalTensor) {
+      continue;
+    }
+    TfLiteTensor* tensor = &tensors_[tensor_index];
+    if (tensor->delegate && tensor->delegate != node.delegate &&
+        tensor->data_is_stale) {
+      TF_LITE_ENSURE_STATUS(EnsureTensorDataIsReadable(tensor_index));
+    }
+  }
+  return kTfLiteOk;
+}
+
 TfLiteStatus Subgraph::PrepareOpsStartingAt(
     int first_execution_plan_index, int* last_execution_plan_index_prepared) {
   if (first_execution_plan_index == 0) {
@@ -861,9 +1071,10 @@ TfLiteStatus Subgraph::PrepareOpsStartingAt(
 TfLiteStatus Subgraph::PrepareOpsAndTensors() {
   if (!memory_planner_) {
     memory_planner_.reset(new ArenaPlanner(
-        &context_, std::unique_ptr<GraphInfo>(new InterpreterInfo(this)),
+        &context_, std::unique_ptr<GraphInfo>(new InterpreterInfo(this, &inter_op_steps_)),
         /*preserve_inputs=*/true, /*preserve_intermediates*/ false,
         kDefaultTensorAlignment));
+    memory_planner_->SetLazyCommit(lazy_arena_commit_);
     memory_planner_->PlanAllocations();
   }
 
@@ -904,6 +1115,12 @@ TfLiteStatus Subgraph::Invoke() {
     applied_nnapi_delegate_ = true;
   }
 
+  // The profiler records one operator at a time.
+  if (!inter_op_step_nodes_.empty() && !profiler_ &&
+      next_execution_plan_index_to_prepare_ == execution_plan_.size()) {
+    return InvokeInterOpSchedule();
+  }
+
   // Invocations are always done in node order.
   // Note that calling Invoke repeatedly will cause the original memory plan to
   // be reused, unless either ResizeInputTensor() or AllocateTensors() has been
@@ -924,21 +1141,7 @@ TfLiteStatus Subgraph::Invoke() {
     if (profiler_) op_name = GetTFLiteOpName(registration);
     TFLITE_SCOPED_TAGGED_OPERATOR_PROFILE(profiler_.get(), op_name, node_index);
 
-    // TODO(ycling): This is an extra loop through inputs to check if the data
-    // need to be copied from Delegate buffer to raw memory, which is often not
-    // needed. We may want to cache this in prepare to know if this needs to be
-    // done for a node or not.
-    for (int i = 0; i < node.inputs->size; ++i) {
-      int tensor_index = node.inputs->data[i];
-      if (tensor_index == kTfLiteOptionalTensor) {
-        continue;
-      }
-      TfLiteTensor* tensor = &tensors_[tensor_index];
-      if (tensor->delegate && tensor->delegate != node.delegate &&
-          tensor->data_is_stale) {
-        TF_LITE_ENSURE_STATUS(EnsureTensorDataIsReadable(tensor_index));
-      }
-    }
+    TF_LITE_ENSURE_STATUS(EnsureInputDataIsReadable(node));
 
     if (check_cancelled_func_ != nullptr &&
         check_cancelled_func_(cancellation_data_)) {
@@ -972,6 +1175,11 @@ TfLiteStatus Subgraph::Invoke() {
         }
       }
     }
+
+    if (lazy_arena_commit_ && memory_planner_) {
+      TF_LITE_ENSURE_STATUS(
+          memory_planner_->ReleaseMemoryAfter(execution_plan_index));
+    }
   }
 
   return status;
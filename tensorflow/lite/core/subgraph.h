@@ -18,6 +18,7 @@ limitations under the License.
 #include <cstdint>
 #include <cstdlib>
 #include <map>
+#include <memory>
 #include <utility>
 #include <vector>
 
@@ -27,6 +28,8 @@ limitations under the License.
 #include "tensorflow/lite/core/macros.h"
 #include "tensorflow/lite/delegates/nnapi/nnapi_delegate.h"
 #include "tensorflow/lite/experimental/resource/resource_base.h"
+#include "tensorflow/lite/external_cpu_backend_context.h"
+#include "tensorflow/lite/inter_op_thread_pool.h"
 #include "tensorflow/lite/memory_planner.h"
 #include "tensorflow/lite/util.h"
 
@@ -276,6 +279,30 @@ class Subgraph {
   // WARNING: This is an experimental API and subject to change.
   void SetCancellationFunction(void* data, bool (*check_cancelled_func)(void*));
 
+  // Sets the number of threads that run independent nodes concurrently. With
+  // the default of 1, nodes run one at a time in execution plan order.
+  // Otherwise the execution plan is split into steps of nodes that don't
+  // depend on each other, and the nodes of a step run concurrently. Each
+  // thread gets its own cpu backend context, so the kernels running on it
+  // don't share one. Custom ops, control flow ops and delegate kernels run on
+  // their own. Graphs with dynamic tensors, and invocations with a profiler
+  // installed, still run one node at a time.
+  // Takes effect on the next call to `AllocateTensors`.
+  // WARNING: This is an experimental API and subject to change.
+  TfLiteStatus SetNumInterOpThreads(int num_threads);
+
+  // Sets whether the tensor arena is committed lazily. If enabled (only
+  // supported on Linux), the arena is reserved without being backed by
+  // physical memory, pages only take up memory once a tensor is written to
+  // them, and pages only holding tensors that are no longer needed are handed
+  // back to the system after each node. This lowers the resident memory of
+  // graphs whose intermediate tensors peak early, at the cost of page faults
+  // on every invocation. Nodes running concurrently with
+  // `SetNumInterOpThreads` don't hand pages back.
+  // Takes effect on the next call to `AllocateTensors`.
+  // WARNING: This is an experimental API and subject to change.
+  TfLiteStatus SetLazyArenaCommit(bool lazy_arena_commit);
+
   // Ensure the data in `tensor.data` is readable. In case delegate is used,
   // it might require to copy the data from delegate buffer to raw memory.
   // WARNING: This is an experimental API and subject to change.
@@ -408,6 +435,9 @@ class Subgraph {
     return op_reg.invoke(&context_, node);
   }
 
+  // Copies the data of the inputs of 'node' from delegate buffers if needed.
+  TfLiteStatus EnsureInputDataIsReadable(const TfLiteNode& node);
+
   // Call OpPrepare() for as many ops as possible, allocating memory for their
   // tensors. If an op containing dynamic tensors is found, preparation will be
   // postponed until this function is called again. This allows the interpreter
@@ -575,6 +605,18 @@ class Subgraph {
   // Returns true if cancellation function returns true.
   bool IsCancelled();
 
+  // Splits the execution plan into steps of nodes that may run concurrently
+  // if inter-op parallelism is enabled. Returns true if the steps changed, in
+  // which case the memory needs to be planned again.
+  bool BuildInterOpSchedule();
+
+  // Invokes the nodes step by step, running the nodes of a step concurrently.
+  TfLiteStatus InvokeInterOpSchedule();
+
+  // Updates the number of threads of the cpu backend contexts used by the
+  // inter-op threads after `recommended_num_threads` changed.
+  void RefreshInterOpCpuBackendContexts();
+
   // The state of the Interpreter.
   enum State {
     // The interpreter isn't ready to be invoked.
@@ -702,6 +744,30 @@ class Subgraph {
 
   // A map of resources. Owned by interpreter and shared by multiple subgraphs.
   resource::ResourceMap* resources_ = nullptr;
+
+  // Number of threads running independent nodes concurrently.
+  int num_inter_op_threads_ = 1;
+
+  // Whether the tensor arena is committed lazily, and the pages of tensors no
+  // longer needed are released after each node.
+  bool lazy_arena_commit_ = false;
+
+  // The step each node of the execution plan runs in, indexed like
+  // `execution_plan_`, and the execution plan indices of the nodes of each
+  // step. Both are empty if nodes run one at a time.
+  std::vector<int> inter_op_steps_;
+  std::vector<std::vector<int>> inter_op_step_nodes_;
+
+  // Created on the first invocation that runs nodes concurrently.
+  std::unique_ptr<InterOpThreadPool> inter_op_thread_pool_;
+
+  // The cpu backend context of each thread started by `inter_op_thread_pool_`.
+  // The thread calling `Invoke` uses the interpreter's context.
+  std::vector<std::unique_ptr<ExternalCpuBackendContext>>
+      inter_op_cpu_backend_contexts_;
+
+  // Status of each node of the step being invoked.
+  std::vector<TfLiteStatus> inter_op_statuses_;
 };
 
 }  // namespace impl
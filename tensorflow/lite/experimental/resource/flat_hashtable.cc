@@ -0,0 +1,113 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/experimental/resource/flat_hashtable.h"
+
+#include <algorithm>
+
+namespace tflite {
+namespace resource {
+namespace internal {
+
+uint64_t HashKey(const StringRef& key) {
+  constexpr uint64_t kMul = 0x9ddfea08eb382d69ULL;
+  const char* data = key.str;
+  size_t len = key.len;
+  uint64_t hash = len * kMul;
+  for (; len >= 8; data += 8, len -= 8) {
+    uint64_t chunk;
+    std::memcpy(&chunk, data, 8);
+    hash = (hash ^ HashKey(static_cast<int64_t>(chunk))) * kMul;
+  }
+  if (len > 0) {
+    uint64_t chunk = 0;
+    std::memcpy(&chunk, data, len);
+    hash = (hash ^ HashKey(static_cast<int64_t>(chunk))) * kMul;
+  }
+  return HashKey(static_cast<int64_t>(hash));
+}
+
+template <typename KeyType, typename ValueType>
+constexpr int FlatHashtable<KeyType, ValueType>::kProbeBatchSize;
+
+template <typename KeyType, typename ValueType>
+void FlatHashtable<KeyType, ValueType>::Build(const TfLiteTensor* keys,
+                                              const TfLiteTensor* values,
+                                              int size) {
+  size_t num_slots = 8;
+  while (num_slots < 2 * static_cast<size_t>(size)) num_slots *= 2;
+  slots_.assign(num_slots, Slot{0, -1});
+  slot_mask_ = num_slots - 1;
+  keys_.Reserve(size, keys);
+  values_.Reserve(size, values);
+
+  for (int i = 0; i < size; ++i) {
+    const KeyView key = FlatStorage<KeyType>::Read(keys, i);
+    const uint64_t hash = HashKey(key);
+    const uint32_t tag = Tag(hash);
+    size_t slot = hash & slot_mask_;
+    bool duplicate = false;
+    for (; slots_[slot].entry != -1; slot = (slot + 1) & slot_mask_) {
+      if (slots_[slot].tag == tag &&
+          KeysEqual(keys_.Get(slots_[slot].entry), key)) {
+        duplicate = true;
+        break;
+      }
+    }
+    if (duplicate) continue;
+    slots_[slot] = Slot{tag, keys_.size()};
+    keys_.Append(key);
+    values_.Append(FlatStorage<ValueType>::Read(values, i));
+  }
+}
+
+template <typename KeyType, typename ValueType>
+int32_t FlatHashtable<KeyType, ValueType>::Find(uint64_t hash,
+                                                const KeyView& key) const {
+  const uint32_t tag = Tag(hash);
+  for (size_t slot = hash & slot_mask_;; slot = (slot + 1) & slot_mask_) {
+    const Slot& s = slots_[slot];
+    if (s.entry == -1) return -1;
+    if (s.tag == tag && KeysEqual(keys_.Get(s.entry), key)) return s.entry;
+  }
+}
+
+template <typename KeyType, typename ValueType>
+void FlatHashtable<KeyType, ValueType>::FindBatch(const TfLiteTensor* keys,
+                                                  int first, int count,
+                                                  int32_t* entries) const {
+  KeyView batch_keys[kProbeBatchSize];
+  uint64_t hashes[kProbeBatchSize];
+  count = std::min(count, kProbeBatchSize);
+  for (int i = 0; i < count; ++i) {
+    batch_keys[i] = FlatStorage<KeyType>::Read(keys, first + i);
+    hashes[i] = HashKey(batch_keys[i]);
+  }
+#ifdef __GNUC__
+  for (int i = 0; i < count; ++i) {
+    __builtin_prefetch(&slots_[hashes[i] & slot_mask_], /* 0 means read */ 0,
+                       /* 3 means high locality */ 3);
+  }
+#endif
+  for (int i = 0; i < count; ++i) {
+    entries[i] = Find(hashes[i], batch_keys[i]);
+  }
+}
+
+template class FlatHashtable<std::int64_t, std::string>;
+template class FlatHashtable<std::string, std::int64_t>;
+
+}  // namespace internal
+}  // namespace resource
+}  // namespace tflite
@@ -0,0 +1,184 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_EXPERIMENTAL_RESOURCE_FLAT_HASHTABLE_H_
+#define TENSORFLOW_LITE_EXPERIMENTAL_RESOURCE_FLAT_HASHTABLE_H_
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
+#include "tensorflow/lite/string_util.h"
+
+namespace tflite {
+namespace resource {
+namespace internal {
+
+// Hashes a hashtable key.
+inline uint64_t HashKey(int64_t key) {
+  uint64_t hash = static_cast<uint64_t>(key);
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53ULL;
+  hash ^= hash >> 33;
+  return hash;
+}
+uint64_t HashKey(const StringRef& key);
+
+inline bool KeysEqual(int64_t a, int64_t b) { return a == b; }
+inline bool KeysEqual(const StringRef& a, const StringRef& b) {
+  return a.len == b.len && std::memcmp(a.str, b.str, a.len) == 0;
+}
+
+/// Keys or values of a hashtable, stored back to back. Elements are accessed
+/// as views: the value itself for scalars, and a StringRef into the storage
+/// for strings, so that neither building nor probing the table constructs a
+/// std::string.
+template <typename T>
+class FlatStorage {
+ public:
+  using View = T;
+
+  // Returns the element at `index` of `tensor`.
+  static View Read(const TfLiteTensor* tensor, int index) {
+    return GetTensorData<T>(tensor)[index];
+  }
+
+  void Reserve(int size, const TfLiteTensor* tensor) { data_.reserve(size); }
+  void Append(View value) { data_.push_back(value); }
+  View Get(int index) const { return data_[index]; }
+  int size() const { return data_.size(); }
+
+ private:
+  std::vector<T> data_;
+};
+
+template <>
+class FlatStorage<std::string> {
+ public:
+  using View = StringRef;
+
+  static View Read(const TfLiteTensor* tensor, int index) {
+    return GetString(tensor, index);
+  }
+
+  void Reserve(int size, const TfLiteTensor* tensor) {
+    offsets_.reserve(size + 1);
+    // The string data of the tensor is an upper bound of what is appended.
+    bytes_.reserve(tensor->bytes);
+  }
+  void Append(View value) {
+    bytes_.insert(bytes_.end(), value.str, value.str + value.len);
+    offsets_.push_back(bytes_.size());
+  }
+  View Get(int index) const {
+    const size_t begin = index == 0 ? 0 : offsets_[index - 1];
+    return {bytes_.data() + begin, static_cast<int>(offsets_[index] - begin)};
+  }
+  int size() const { return offsets_.size(); }
+
+ private:
+  std::vector<char> bytes_;
+  // The end of each string in `bytes_`.
+  std::vector<size_t> offsets_;
+};
+
+/// Writes the values found by a lookup to the output tensor.
+template <typename T>
+class FlatValueWriter {
+ public:
+  explicit FlatValueWriter(TfLiteTensor* values)
+      : data_(GetTensorData<T>(values)) {}
+  void Set(int index, T value) { data_[index] = value; }
+  void Commit() {}
+
+ private:
+  T* data_;
+};
+
+template <>
+class FlatValueWriter<std::string> {
+ public:
+  explicit FlatValueWriter(TfLiteTensor* values) : values_(values) {}
+  // Strings must be set in index order.
+  void Set(int index, const StringRef& value) { buffer_.AddString(value); }
+  void Commit() { buffer_.WriteToTensor(values_, /*new_shape=*/nullptr); }
+
+ private:
+  TfLiteTensor* values_;
+  DynamicBuffer buffer_;
+};
+
+/// An immutable hash table built from the keys and values tensors of an
+/// import, for fast lookups of many keys at once.
+///
+/// Keys and values are kept in flat storage, in import order. The table
+/// itself uses open addressing with linear probing, at a load factor of at
+/// most 1/2. Each slot only holds the index of an entry and a 32-bit tag taken
+/// from the key's hash, so that a probe rarely compares keys that don't match
+/// and the slots of a table of a million entries fit in 16MB.
+///
+/// Lookups hash a batch of keys first, prefetch the slot of each, and only
+/// then probe, so the cache misses of the keys of a batch overlap instead of
+/// being paid one after another.
+template <typename KeyType, typename ValueType>
+class FlatHashtable {
+ public:
+  using KeyView = typename FlatStorage<KeyType>::View;
+  using ValueView = typename FlatStorage<ValueType>::View;
+
+  // Maximum number of keys FindBatch() probes at once.
+  static constexpr int kProbeBatchSize = 16;
+
+  // Builds the table from the first `size` keys and values. If a key appears
+  // more than once, its first value is kept.
+  void Build(const TfLiteTensor* keys, const TfLiteTensor* values, int size);
+
+  // Finds the keys at [first, first + count) of `keys`, and writes the entry
+  // of each, or -1 if it is missing, to `entries`. `count` must not exceed
+  // kProbeBatchSize.
+  void FindBatch(const TfLiteTensor* keys, int first, int count,
+                 int32_t* entries) const;
+
+  ValueView value(int32_t entry) const { return values_.Get(entry); }
+
+  // Returns the number of distinct keys.
+  size_t size() const { return keys_.size(); }
+
+ private:
+  struct Slot {
+    uint32_t tag;
+    // Index of the entry in `keys_` and `values_`, or -1 if the slot is empty.
+    int32_t entry;
+  };
+
+  static uint32_t Tag(uint64_t hash) { return hash >> 32; }
+
+  int32_t Find(uint64_t hash, const KeyView& key) const;
+
+  std::vector<Slot> slots_;
+  uint64_t slot_mask_ = 0;
+  FlatStorage<KeyType> keys_;
+  FlatStorage<ValueType> values_;
+};
+
+}  // namespace internal
+}  // namespace resource
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_EXPERIMENTAL_RESOURCE_FLAT_HASHTABLE_H_
@@ -15,7 +15,9 @@ limitations under the License.
 
 #include "tensorflow/lite/experimental/resource/static_hashtable.h"
 
+#include <algorithm>
 #include <memory>
+
 #include "tensorflow/lite/experimental/resource/lookup_interfaces.h"
 
 namespace tflite {
@@ -34,17 +36,21 @@ TfLiteStatus StaticHashtable<KeyType, ValueType>::Lookup(
   const int size =
       MatchingFlatSize(GetTensorShape(keys), GetTensorShape(values));
 
-  auto key_tensor_reader = TensorReader<KeyType>(keys);
-  auto value_tensor_writer = TensorWriter<ValueType>(values);
-  auto default_value_tensor_reader = TensorReader<ValueType>(default_value);
-  ValueType first_default_value = default_value_tensor_reader.GetData(0);
-
-  for (int i = 0; i < size; ++i) {
-    auto result = map_.find(key_tensor_reader.GetData(i));
-    if (result != map_.end()) {
-      value_tensor_writer.SetData(i, result->second);
-    } else {
-      value_tensor_writer.SetData(i, first_default_value);
+  using Table = FlatHashtable<KeyType, ValueType>;
+  FlatValueWriter<ValueType> value_tensor_writer(values);
+  const typename Table::ValueView first_default_value =
+      FlatStorage<ValueType>::Read(default_value, 0);
+
+  int32_t entries[Table::kProbeBatchSize];
+  for (int first = 0; first < size; first += Table::kProbeBatchSize) {
+    const int count = std::min(size - first, Table::kProbeBatchSize);
+    table_.FindBatch(keys, first, count, entries);
+    for (int i = 0; i < count; ++i) {
+      if (entries[i] != -1) {
+        value_tensor_writer.Set(first + i, table_.value(entries[i]));
+      } else {
+        value_tensor_writer.Set(first + i, first_default_value);
+      }
     }
   }
 
@@ -70,11 +76,7 @@ TfLiteStatus StaticHashtable<KeyType, ValueType>::Import(
   const int size =
       MatchingFlatSize(GetTensorShape(keys), GetTensorShape(values));
 
-  auto key_tensor_reader = TensorReader<KeyType>(keys);
-  auto value_tensor_writer = TensorReader<ValueType>(values);
-  for (int i = 0; i < size; ++i) {
-    map_.insert({key_tensor_reader.GetData(i), value_tensor_writer.GetData(i)});
-  }
+  table_.Build(keys, values, size);
 
   is_initialized_ = true;
   return kTfLiteOk;
@@ -15,9 +15,8 @@ limitations under the License.
 #ifndef TENSORFLOW_LITE_EXPERIMENTAL_RESOURCE_STATIC_HASHTABLE_H_
 #define TENSORFLOW_LITE_EXPERIMENTAL_RESOURCE_STATIC_HASHTABLE_H_
 
-#include <unordered_map>
-
 #include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/experimental/resource/flat_hashtable.h"
 #include "tensorflow/lite/experimental/resource/lookup_interfaces.h"
 #include "tensorflow/lite/experimental/resource/lookup_util.h"
 #include "tensorflow/lite/experimental/resource/resource_base.h"
@@ -30,6 +29,8 @@ namespace internal {
 
 // A static hash table class. This hash table allows initialization one time in
 // its life cycle. This hash table implements Tensorflow core's HashTableV2 op.
+// The entries are kept in a FlatHashtable, which is built in one go from the
+// imported tensors and probes batches of keys at a time.
 template <typename KeyType, typename ValueType>
 class StaticHashtable : public tflite::resource::LookupInterface {
  public:
@@ -49,7 +50,7 @@ class StaticHashtable : public tflite::resource::LookupInterface {
                       const TfLiteTensor* values) override;
 
   // Returns the item size of the hash table.
-  size_t Size() override { return map_.size(); }
+  size_t Size() override { return table_.size(); }
 
   TfLiteType GetKeyType() const override { return key_type_; }
   TfLiteType GetValueType() const override { return value_type_; }
@@ -69,7 +70,7 @@ class StaticHashtable : public tflite::resource::LookupInterface {
   TfLiteType key_type_;
   TfLiteType value_type_;
 
-  std::unordered_map<KeyType, ValueType> map_;
+  FlatHashtable<KeyType, ValueType> table_;
   bool is_initialized_ = false;
 };
 
@@ -53,6 +53,13 @@ class GraphInfo {
 
   // Returns the indices of the variable tensors.
   virtual const std::vector<int>& variables() const = 0;
+
+  // Returns the step of the execution in which the node at `index` runs.
+  // Nodes of the same step may run concurrently, and all of them finish
+  // before any node of a later step starts. Steps are numbered densely from
+  // zero but need not be increasing in node order. By default every node
+  // runs in a step of its own, in order.
+  virtual size_t node_step(size_t index) const { return index; }
 };
 
 // Represents a subset of nodes in a TensorFlow Lite graph.
@@ -0,0 +1,116 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/inter_op_thread_pool.h"
+
+namespace tflite {
+
+InterOpThreadPool::InterOpThreadPool(int num_threads) {
+  for (int i = 1; i < num_threads; ++i) {
+    threads_.emplace_back([this] { WorkerLoop(); });
+  }
+}
+
+InterOpThreadPool::~InterOpThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    shutdown_ = true;
+  }
+  work_cv_.notify_all();
+  for (std::thread& thread : threads_) {
+    thread.join();
+  }
+}
+
+void InterOpThreadPool::Run(int num_tasks,
+                            const std::function<void(int)>& task) {
+  if (threads_.empty() || num_tasks <= 1) {
+    for (int i = 0; i < num_tasks; ++i) {
+      task(i);
+    }
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    task_ = &task;
+    num_tasks_ = num_tasks;
+    num_pending_ = num_tasks;
+    next_task_.store(0, std::memory_order_relaxed);
+    ++generation_;
+  }
+  work_cv_.notify_all();
+
+  const int num_done = RunTasks(task, num_tasks);
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  num_pending_ -= num_done;
+  done_cv_.wait(lock, [this] { return num_pending_ == 0 && num_active_ == 0; });
+  task_ = nullptr;
+}
+
+int InterOpThreadPool::CurrentThreadIndex() const {
+  const std::thread::id id = std::this_thread::get_id();
+  for (size_t i = 0; i < threads_.size(); ++i) {
+    if (threads_[i].get_id() == id) {
+      return static_cast<int>(i) + 1;
+    }
+  }
+  return 0;
+}
+
+void InterOpThreadPool::WorkerLoop() {
+  uint64_t seen_generation = 0;
+  while (true) {
+    const std::function<void(int)>* task;
+    int num_tasks;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      work_cv_.wait(lock, [this, seen_generation] {
+        return shutdown_ || generation_ != seen_generation;
+      });
+      if (shutdown_) return;
+      seen_generation = generation_;
+      // The batch may have completed before this thread woke up.
+      if (task_ == nullptr) continue;
+      task = task_;
+      num_tasks = num_tasks_;
+      ++num_active_;
+    }
+
+    const int num_done = RunTasks(*task, num_tasks);
+
+    bool done;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      num_pending_ -= num_done;
+      --num_active_;
+      done = num_pending_ == 0 && num_active_ == 0;
+    }
+    if (done) done_cv_.notify_one();
+  }
+}
+
+int InterOpThreadPool::RunTasks(const std::function<void(int)>& task,
+                                int num_tasks) {
+  int num_done = 0;
+  for (int i = next_task_.fetch_add(1, std::memory_order_relaxed);
+       i < num_tasks; i = next_task_.fetch_add(1, std::memory_order_relaxed)) {
+    task(i);
+    ++num_done;
+  }
+  return num_done;
+}
+
+}  // namespace tflite
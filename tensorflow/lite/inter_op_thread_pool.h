@@ -0,0 +1,78 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_INTER_OP_THREAD_POOL_H_
+#define TENSORFLOW_LITE_INTER_OP_THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tflite {
+
+// A fixed set of threads that runs batches of independent tasks, used by the
+// interpreter to run independent operators concurrently.
+//
+// The thread calling Run() takes part in every batch, so a pool of
+// `num_threads` threads starts `num_threads - 1` threads of its own.
+class InterOpThreadPool {
+ public:
+  explicit InterOpThreadPool(int num_threads);
+  ~InterOpThreadPool();
+  InterOpThreadPool(const InterOpThreadPool&) = delete;
+  InterOpThreadPool& operator=(const InterOpThreadPool&) = delete;
+
+  int num_threads() const { return static_cast<int>(threads_.size()) + 1; }
+
+  // Calls `task(i)` once for every `i` in [0, num_tasks), and returns when all
+  // the calls have returned. Must not be called concurrently, or from a task.
+  void Run(int num_tasks, const std::function<void(int)>& task);
+
+  // Returns a number in [1, num_threads()) identifying the calling thread if it
+  // is one of the threads started by the pool, and 0 otherwise.
+  int CurrentThreadIndex() const;
+
+ private:
+  void WorkerLoop();
+
+  // Claims and calls tasks of the current batch until there are none left.
+  // Returns the number of tasks called.
+  int RunTasks(const std::function<void(int)>& task, int num_tasks);
+
+  std::vector<std::thread> threads_;
+
+  std::mutex mutex_;
+  std::condition_variable work_cv_;
+  std::condition_variable done_cv_;
+  // Incremented for every batch, so that the threads notice the new batch.
+  uint64_t generation_ = 0;
+  bool shutdown_ = false;
+  const std::function<void(int)>* task_ = nullptr;
+  int num_tasks_ = 0;
+  // Number of tasks of the current batch that haven't returned yet.
+  int num_pending_ = 0;
+  // Number of threads that may still claim tasks of the current batch. Run()
+  // waits for them so that no thread claims a task of the next batch while
+  // holding the previous `task_`.
+  int num_active_ = 0;
+  std::atomic<int> next_task_{0};
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_INTER_OP_THREAD_POOL_H_
@@ -0,0 +1,82 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/inter_op_thread_pool.h"
+
+#include <atomic>
+#include <set>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/lite/testing/util.h"
+
+namespace tflite {
+namespace {
+
+TEST(InterOpThreadPoolTest, RunsEveryTaskOnce) {
+  InterOpThreadPool pool(4);
+  EXPECT_EQ(pool.num_threads(), 4);
+  for (int num_tasks : {0, 1, 3, 4, 17}) {
+    std::vector<std::atomic<int>> calls(num_tasks);
+    for (auto& count : calls) count = 0;
+    pool.Run(num_tasks, [&calls](int i) { ++calls[i]; });
+    for (int i = 0; i < num_tasks; ++i) {
+      EXPECT_EQ(calls[i], 1) << "task " << i << " of " << num_tasks;
+    }
+  }
+}
+
+TEST(InterOpThreadPoolTest, ManyBatches) {
+  InterOpThreadPool pool(3);
+  std::atomic<int> sum(0);
+  for (int batch = 0; batch < 1000; ++batch) {
+    pool.Run(2, [&sum](int i) { sum += i + 1; });
+  }
+  EXPECT_EQ(sum, 3000);
+}
+
+TEST(InterOpThreadPoolTest, CurrentThreadIndex) {
+  InterOpThreadPool pool(2);
+  EXPECT_EQ(pool.CurrentThreadIndex(), 0);
+
+  // Tasks wait for each other, so the two tasks run on different threads.
+  std::atomic<int> started(0);
+  std::vector<int> indices(2);
+  pool.Run(2, [&](int i) {
+    ++started;
+    while (started < 2) {
+    }
+    indices[i] = pool.CurrentThreadIndex();
+  });
+  EXPECT_THAT(std::set<int>(indices.begin(), indices.end()),
+              ::testing::ElementsAre(0, 1));
+}
+
+TEST(InterOpThreadPoolTest, SingleThreadRunsOnCaller) {
+  InterOpThreadPool pool(1);
+  EXPECT_EQ(pool.num_threads(), 1);
+  std::vector<int> indices(3, -1);
+  pool.Run(3, [&](int i) { indices[i] = pool.CurrentThreadIndex(); });
+  EXPECT_THAT(indices, ::testing::ElementsAre(0, 0, 0));
+}
+
+}  // namespace
+}  // namespace tflite
+
+int main(int argc, char** argv) {
+  ::tflite::LogToStderr();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -320,6 +320,23 @@ TfLiteStatus Interpreter::SetNumThreads(int num_threads) {
       c->Refresh(context_);
     }
   }
+  for (auto& subgraph : subgraphs_) {
+    subgraph->RefreshInterOpCpuBackendContexts();
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus Interpreter::SetNumInterOpThreads(int num_threads) {
+  for (auto& subgraph : subgraphs_) {
+    TF_LITE_ENSURE_STATUS(subgraph->SetNumInterOpThreads(num_threads));
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus Interpreter::SetLazyArenaCommit(bool enable) {
+  for (auto& subgraph : subgraphs_) {
+    TF_LITE_ENSURE_STATUS(subgraph->SetLazyArenaCommit(enable));
+  }
   return kTfLiteOk;
 }
 
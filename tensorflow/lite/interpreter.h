@@ -374,6 +374,26 @@ class Interpreter {
   /// available to itself.
   TfLiteStatus SetNumThreads(int num_threads);
 
+  /// Set the number of threads that run independent operators concurrently.
+  /// The default of 1 runs operators one at a time in execution plan order.
+  /// Each of these threads runs its operators with up to the number of
+  /// threads set by `SetNumThreads`, so the two are best balanced against the
+  /// number of cores. Graphs with dynamic tensors still run one operator at a
+  /// time. Takes effect on the next call to `AllocateTensors`.
+  ///
+  /// NOTE: num_threads should be >= 1.
+  /// WARNING: This is an experimental API and subject to change.
+  TfLiteStatus SetNumInterOpThreads(int num_threads);
+
+  /// Set whether tensor arenas are committed lazily, so that they only take up
+  /// memory once written to, and memory only holding intermediate tensors
+  /// that are no longer needed is handed back to the system after each
+  /// operator. Lowers peak resident memory at the cost of page faults on every
+  /// invocation. Only supported on Linux; elsewhere this has no effect. Takes
+  /// effect on the next call to `AllocateTensors`.
+  /// WARNING: This is an experimental API and subject to change.
+  TfLiteStatus SetLazyArenaCommit(bool enable);
+
   /// Allow float16 precision for FP32 calculation when possible.
   /// default: not allow.
   /// WARNING: This is an experimental API and subject to change.
@@ -0,0 +1,162 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/interpreter_pool.h"
+
+#include <utility>
+
+namespace tflite {
+
+InterpreterPool::ScopedInterpreter::ScopedInterpreter(ScopedInterpreter&& other)
+    : pool_(other.pool_), interpreter_(other.interpreter_) {
+  other.pool_ = nullptr;
+  other.interpreter_ = nullptr;
+}
+
+InterpreterPool::ScopedInterpreter& InterpreterPool::ScopedInterpreter::
+operator=(ScopedInterpreter&& other) {
+  if (this != &other) {
+    Release();
+    std::swap(pool_, other.pool_);
+    std::swap(interpreter_, other.interpreter_);
+  }
+  return *this;
+}
+
+InterpreterPool::ScopedInterpreter::~ScopedInterpreter() { Release(); }
+
+void InterpreterPool::ScopedInterpreter::Release() {
+  if (interpreter_ != nullptr) {
+    pool_->Release(interpreter_);
+  }
+  pool_ = nullptr;
+  interpreter_ = nullptr;
+}
+
+std::unique_ptr<InterpreterPool> InterpreterPool::Create(
+    const FlatBufferModel& model, const OpResolver& op_resolver,
+    const Options& options) {
+  ErrorReporter* error_reporter = model.error_reporter()
+                                      ? model.error_reporter()
+                                      : DefaultErrorReporter();
+  if (options.max_num_interpreters < 1) {
+    TF_LITE_REPORT_ERROR(error_reporter,
+                         "max_num_interpreters should be >= 1.");
+    return nullptr;
+  }
+  if (options.num_threads < 1 && options.num_threads != -1) {
+    TF_LITE_REPORT_ERROR(error_reporter,
+                         "num_threads should be >= 1 or just -1 to let TFLite "
+                         "runtime set the value.");
+    return nullptr;
+  }
+  if (options.num_threads != -1 &&
+      options.num_threads < options.max_num_interpreters) {
+    // Every interpreter needs at least one thread, so the pool would run more
+    // threads than num_threads.
+    TF_LITE_REPORT_ERROR(error_reporter,
+                         "num_threads (%d) should be >= max_num_interpreters "
+                         "(%d), or -1.",
+                         options.num_threads, options.max_num_interpreters);
+    return nullptr;
+  }
+
+  std::unique_ptr<InterpreterPool> pool(
+      new InterpreterPool(model, op_resolver, options));
+  std::unique_ptr<Interpreter> interpreter;
+  if (pool->BuildInterpreter(&interpreter) != kTfLiteOk) {
+    return nullptr;
+  }
+  pool->idle_.push_back(interpreter.get());
+  pool->interpreters_.push_back(std::move(interpreter));
+  return pool;
+}
+
+InterpreterPool::InterpreterPool(const FlatBufferModel& model,
+                                 const OpResolver& op_resolver,
+                                 const Options& options)
+    : model_(model),
+      op_resolver_(op_resolver),
+      error_reporter_(model.error_reporter() ? model.error_reporter()
+                                             : DefaultErrorReporter()),
+      max_num_interpreters_(options.max_num_interpreters),
+      num_threads_per_interpreter_(
+          options.num_threads == -1
+              ? -1
+              : options.num_threads / options.max_num_interpreters) {}
+
+InterpreterPool::~InterpreterPool() {}
+
+InterpreterPool::ScopedInterpreter InterpreterPool::Acquire() {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    released_cv_.wait(lock, [this] {
+      return !idle_.empty() || interpreters_.size() + num_building_ <
+                                   static_cast<size_t>(max_num_interpreters_);
+    });
+    if (!idle_.empty()) {
+      Interpreter* interpreter = idle_.back();
+      idle_.pop_back();
+      return ScopedInterpreter(this, interpreter);
+    }
+    ++num_building_;
+  }
+
+  // Build outside the lock, so that other requests keep running meanwhile.
+  std::unique_ptr<Interpreter> interpreter;
+  const TfLiteStatus status = BuildInterpreter(&interpreter);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  --num_building_;
+  if (status != kTfLiteOk) {
+    // Let another waiter try to build one.
+    released_cv_.notify_one();
+    return ScopedInterpreter();
+  }
+  Interpreter* result = interpreter.get();
+  interpreters_.push_back(std::move(interpreter));
+  return ScopedInterpreter(this, result);
+}
+
+int InterpreterPool::num_interpreters() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return static_cast<int>(interpreters_.size());
+}
+
+TfLiteStatus InterpreterPool::BuildInterpreter(
+    std::unique_ptr<Interpreter>* interpreter) {
+  InterpreterBuilder builder(model_, op_resolver_);
+  if (builder(interpreter, num_threads_per_interpreter_) != kTfLiteOk) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Failed to build an interpreter for the pool.");
+    return kTfLiteError;
+  }
+  if ((*interpreter)->AllocateTensors() != kTfLiteOk) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Failed to allocate tensors for the pool.");
+    interpreter->reset();
+    return kTfLiteError;
+  }
+  return kTfLiteOk;
+}
+
+void InterpreterPool::Release(Interpreter* interpreter) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    idle_.push_back(interpreter);
+  }
+  released_cv_.notify_one();
+}
+
+}  // namespace tflite
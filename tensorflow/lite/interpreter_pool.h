@@ -0,0 +1,152 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+/// \file
+/// Provides a pool of interpreters for serving concurrent requests with a
+/// single model.
+///
+#ifndef TENSORFLOW_LITE_INTERPRETER_POOL_H_
+#define TENSORFLOW_LITE_INTERPRETER_POOL_H_
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/core/api/error_reporter.h"
+#include "tensorflow/lite/core/api/op_resolver.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/model.h"
+
+namespace tflite {
+
+/// A set of interpreters of the same model that are handed out one request at
+/// a time, so that a server can invoke the model from several threads at once.
+///
+/// All the interpreters are built from the same FlatBufferModel, so the
+/// read-only weights are only held once: constant tensors point into the model
+/// buffer. Interpreters are built when the first request needs them, up to
+/// `max_num_interpreters`, and tensors are allocated once per interpreter.
+///
+/// `num_threads` is a budget for the whole pool rather than for each
+/// interpreter. A CPU backend context (i.e. its ruy or gemmlowp thread pool)
+/// can't be used by two invocations at once, so every interpreter keeps its
+/// own, and each of them gets `num_threads / max_num_interpreters` threads. At
+/// most `num_threads` threads are therefore busy however many callers there
+/// are, and `num_threads` may not be less than `max_num_interpreters`.
+///
+/// Example:
+///
+/// <pre><code>
+/// auto pool = tflite::InterpreterPool::Create(*model, resolver, options);
+/// // On each request thread:
+/// tflite::InterpreterPool::ScopedInterpreter interpreter = pool->Acquire();
+/// if (!interpreter) ... // error
+/// // Fill inputs, then
+/// interpreter->Invoke();
+/// // Read outputs. The interpreter returns to the pool when 'interpreter' is
+/// // destroyed.
+/// </code></pre>
+class InterpreterPool {
+ public:
+  struct Options {
+    // Maximum number of interpreters, i.e. of requests that run concurrently.
+    int max_num_interpreters = 1;
+    // Number of threads shared by all the interpreters, at least
+    // `max_num_interpreters`. -1 lets every interpreter use the TFLite
+    // default.
+    int num_threads = -1;
+  };
+
+  /// An interpreter acquired from the pool. It is returned to the pool when
+  /// the ScopedInterpreter is destroyed, keeping the state (e.g. input shapes
+  /// and variable tensors) the request left in it.
+  class ScopedInterpreter {
+   public:
+    ScopedInterpreter() = default;
+    ScopedInterpreter(ScopedInterpreter&& other);
+    ScopedInterpreter& operator=(ScopedInterpreter&& other);
+    ~ScopedInterpreter();
+
+    Interpreter* get() const { return interpreter_; }
+    Interpreter* operator->() const { return interpreter_; }
+    Interpreter& operator*() const { return *interpreter_; }
+    explicit operator bool() const { return interpreter_ != nullptr; }
+
+   private:
+    friend class InterpreterPool;
+    ScopedInterpreter(InterpreterPool* pool, Interpreter* interpreter)
+        : pool_(pool), interpreter_(interpreter) {}
+    void Release();
+
+    InterpreterPool* pool_ = nullptr;
+    Interpreter* interpreter_ = nullptr;
+  };
+
+  /// Creates a pool of interpreters of `model`, and builds the first one to
+  /// check that the model can run. Returns nullptr on failure, which is
+  /// reported to the model's error reporter. `model` must outlive the pool;
+  /// `op_resolver` must outlive the pool too, as interpreters are built on
+  /// demand.
+  static std::unique_ptr<InterpreterPool> Create(const FlatBufferModel& model,
+                                                 const OpResolver& op_resolver,
+                                                 const Options& options);
+
+  /// Every ScopedInterpreter must have been destroyed before the pool.
+  ~InterpreterPool();
+  InterpreterPool(const InterpreterPool&) = delete;
+  InterpreterPool& operator=(const InterpreterPool&) = delete;
+
+  /// Returns an idle interpreter with allocated tensors, building a new one if
+  /// none is idle and the pool isn't full, and otherwise waiting for one to be
+  /// released. Returns an empty ScopedInterpreter if building fails.
+  /// Thread-safe.
+  ScopedInterpreter Acquire();
+
+  /// Number of threads each interpreter uses.
+  int num_threads_per_interpreter() const {
+    return num_threads_per_interpreter_;
+  }
+
+  /// Number of interpreters built so far. Thread-safe.
+  int num_interpreters() const;
+
+ private:
+  InterpreterPool(const FlatBufferModel& model, const OpResolver& op_resolver,
+                  const Options& options);
+
+  // Builds an interpreter and allocates its tensors. Called without holding
+  // `mutex_`.
+  TfLiteStatus BuildInterpreter(std::unique_ptr<Interpreter>* interpreter);
+
+  void Release(Interpreter* interpreter);
+
+  const FlatBufferModel& model_;
+  const OpResolver& op_resolver_;
+  ErrorReporter* error_reporter_;
+  const int max_num_interpreters_;
+  const int num_threads_per_interpreter_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable released_cv_;
+  std::vector<std::unique_ptr<Interpreter>> interpreters_;
+  std::vector<Interpreter*> idle_;
+  // Interpreters being built, which count against `max_num_interpreters_`.
+  int num_building_ = 0;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_INTERPRETER_POOL_H_
@@ -0,0 +1,140 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/interpreter_pool.h"
+
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/lite/add_model_test_util.h"
+#include "tensorflow/lite/testing/util.h"
+
+namespace tflite {
+namespace {
+
+class InterpreterPoolTest : public AddModelTest {
+ protected:
+  std::unique_ptr<InterpreterPool> CreatePool(int max_num_interpreters,
+                                              int num_threads = -1) {
+    InterpreterPool::Options options;
+    options.max_num_interpreters = max_num_interpreters;
+    options.num_threads = num_threads;
+    return InterpreterPool::Create(*model_, resolver_, options);
+  }
+};
+
+// Runs the model on `value` and checks the result.
+void InvokeAndCheck(Interpreter* interpreter, float value) {
+  TfLiteTensor* input = interpreter->tensor(interpreter->inputs()[0]);
+  FillAddModelInput(value, kAddModelExampleSize, input->data.f);
+  ASSERT_EQ(interpreter->Invoke(), kTfLiteOk);
+  const TfLiteTensor* output = interpreter->tensor(interpreter->outputs()[0]);
+  CheckAddModelOutput(value, kAddModelExampleSize, output->data.f);
+}
+
+TEST_F(InterpreterPoolTest, InvalidOptions) {
+  EXPECT_EQ(CreatePool(/*max_num_interpreters=*/0), nullptr);
+  EXPECT_EQ(CreatePool(/*max_num_interpreters=*/1, /*num_threads=*/0),
+            nullptr);
+  EXPECT_EQ(CreatePool(/*max_num_interpreters=*/1, /*num_threads=*/-2),
+            nullptr);
+  // Each interpreter would need a thread of its own beyond the budget.
+  EXPECT_EQ(CreatePool(/*max_num_interpreters=*/4, /*num_threads=*/2),
+            nullptr);
+}
+
+TEST_F(InterpreterPoolTest, SplitsThreadBudget) {
+  EXPECT_EQ(CreatePool(4, 8)->num_threads_per_interpreter(), 2);
+  EXPECT_EQ(CreatePool(4, 4)->num_threads_per_interpreter(), 1);
+  EXPECT_EQ(CreatePool(3, 8)->num_threads_per_interpreter(), 2);
+  EXPECT_EQ(CreatePool(4, -1)->num_threads_per_interpreter(), -1);
+}
+
+TEST_F(InterpreterPoolTest, ReusesReleasedInterpreter) {
+  auto pool = CreatePool(/*max_num_interpreters=*/4);
+  ASSERT_NE(pool, nullptr);
+  EXPECT_EQ(pool->num_interpreters(), 1);
+
+  Interpreter* first;
+  {
+    InterpreterPool::ScopedInterpreter interpreter = pool->Acquire();
+    ASSERT_TRUE(interpreter);
+    first = interpreter.get();
+    InvokeAndCheck(interpreter.get(), 1.f);
+  }
+  InterpreterPool::ScopedInterpreter interpreter = pool->Acquire();
+  EXPECT_EQ(interpreter.get(), first);
+  EXPECT_EQ(pool->num_interpreters(), 1);
+
+  // A second request while the first is still running gets its own.
+  InterpreterPool::ScopedInterpreter other = pool->Acquire();
+  ASSERT_TRUE(other);
+  EXPECT_NE(other.get(), first);
+  EXPECT_EQ(pool->num_interpreters(), 2);
+  InvokeAndCheck(other.get(), 2.f);
+}
+
+TEST_F(InterpreterPoolTest, WaitsForRelease) {
+  auto pool = CreatePool(/*max_num_interpreters=*/1);
+  ASSERT_NE(pool, nullptr);
+  InterpreterPool::ScopedInterpreter interpreter = pool->Acquire();
+  ASSERT_TRUE(interpreter);
+
+  std::atomic<bool> acquired(false);
+  std::thread waiter([&pool, &acquired] {
+    InterpreterPool::ScopedInterpreter other = pool->Acquire();
+    acquired = static_cast<bool>(other);
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(acquired);
+
+  interpreter = InterpreterPool::ScopedInterpreter();
+  waiter.join();
+  EXPECT_TRUE(acquired);
+  EXPECT_EQ(pool->num_interpreters(), 1);
+}
+
+TEST_F(InterpreterPoolTest, ConcurrentRequests) {
+  constexpr int kNumInterpreters = 3;
+  auto pool = CreatePool(kNumInterpreters, /*num_threads=*/kNumInterpreters);
+  ASSERT_NE(pool, nullptr);
+
+  std::vector<std::thread> callers;
+  for (int caller = 0; caller < 8; ++caller) {
+    callers.emplace_back([&pool, caller] {
+      for (int i = 0; i < 50; ++i) {
+        InterpreterPool::ScopedInterpreter interpreter = pool->Acquire();
+        ASSERT_TRUE(interpreter);
+        InvokeAndCheck(interpreter.get(), caller * 100 + i);
+      }
+    });
+  }
+  for (std::thread& caller : callers) {
+    caller.join();
+  }
+  EXPECT_LE(pool->num_interpreters(), kNumInterpreters);
+}
+
+}  // namespace
+}  // namespace tflite
+
+int main(int argc, char** argv) {
+  ::tflite::LogToStderr();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
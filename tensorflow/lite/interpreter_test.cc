@@ -17,7 +17,13 @@ limitations under the License.
 
 #include <stdint.h>
 
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+#include <map>
 #include <memory>
+#include <mutex>   // NOLINT(build/c++11)
+#include <set>
+#include <thread>  // NOLINT(build/c++11)
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
@@ -1480,6 +1486,189 @@ TEST_F(CancellationTest, CancelDuringInvoke) {
   ASSERT_EQ(invoke_error_code, kTfLiteError);
 }
 
+// Records how many nodes run at the same time, and the cpu backend context
+// each thread sees.
+struct InterOpRecord {
+  std::atomic<int> num_running{0};
+  std::atomic<int> max_num_running{0};
+  std::mutex mutex;
+  std::map<std::thread::id, TfLiteExternalContext*> contexts;
+};
+
+InterOpRecord* inter_op_record = nullptr;
+
+// Test fixture for running independent nodes concurrently. The graph has four
+// branches of two nodes each, interleaved in the execution plan, and a final
+// node summing the branches.
+class InterOpParallelismTest : public ::testing::Test {
+ protected:
+  static constexpr int kNumBranches = 4;
+  static constexpr int kOutput = 2 * kNumBranches + 1;
+
+  // Index of the output tensor of node `node` of branch `branch`.
+  static int BranchTensor(int branch, int node) {
+    return 1 + node * kNumBranches + branch;
+  }
+
+  // An op computing the sum of its inputs plus one. It gives other nodes some
+  // time to start before it finishes, so that concurrency can be observed.
+  static TfLiteRegistration SumPlusOneRegistration() {
+    TfLiteRegistration reg = {nullptr, nullptr, nullptr, nullptr};
+    reg.prepare = [](TfLiteContext* context, TfLiteNode* node) {
+      const TfLiteTensor* input = GetInput(context, node, 0);
+      TfLiteTensor* output = GetOutput(context, node, 0);
+      return context->ResizeTensor(context, output,
+                                   TfLiteIntArrayCopy(input->dims));
+    };
+    reg.invoke = [](TfLiteContext* context, TfLiteNode* node) {
+      InterOpRecord& record = *inter_op_record;
+      const int num_running = ++record.num_running;
+      int max_num_running = record.max_num_running;
+      while (num_running > max_num_running &&
+             !record.max_num_running.compare_exchange_weak(max_num_running,
+                                                           num_running)) {
+      }
+      {
+        std::lock_guard<std::mutex> lock(record.mutex);
+        record.contexts[std::this_thread::get_id()] =
+            context->GetExternalContext(context, kTfLiteCpuBackendContext);
+      }
+      const auto deadline =
+          std::chrono::steady_clock::now() + std::chrono::milliseconds(100);
+      while (record.max_num_running < 2 &&
+             std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::yield();
+      }
+
+      TfLiteTensor* output = GetOutput(context, node, 0);
+      const int num_elements = NumElements(output);
+      for (int i = 0; i < num_elements; ++i) {
+        output->data.f[i] = 1;
+      }
+      for (int j = 0; j < node->inputs->size; ++j) {
+        const TfLiteTensor* input = GetInput(context, node, j);
+        for (int i = 0; i < num_elements; ++i) {
+          output->data.f[i] += input->data.f[i];
+        }
+      }
+      --record.num_running;
+      return kTfLiteOk;
+    };
+    return reg;
+  }
+
+  void SetUp() final {
+    inter_op_record = &record_;
+    ASSERT_EQ(interpreter_.AddTensors(kOutput + 1), kTfLiteOk);
+    ASSERT_EQ(interpreter_.SetInputs({0}), kTfLiteOk);
+    ASSERT_EQ(interpreter_.SetOutputs({kOutput}), kTfLiteOk);
+    TfLiteQuantizationParams quantized;
+    for (int i = 0; i <= kOutput; ++i) {
+      ASSERT_EQ(interpreter_.SetTensorParametersReadWrite(i, kTfLiteFloat32, "",
+                                                          {256}, quantized),
+                kTfLiteOk);
+    }
+    TfLiteRegistration reg = SumPlusOneRegistration();
+    std::vector<int> sum_inputs;
+    for (int branch = 0; branch < kNumBranches; ++branch) {
+      ASSERT_EQ(interpreter_.AddNodeWithParameters(
+                    {0}, {BranchTensor(branch, 0)}, nullptr, 0, nullptr, &reg),
+                kTfLiteOk);
+      ASSERT_EQ(interpreter_.AddNodeWithParameters(
+                    {BranchTensor(branch, 0)}, {BranchTensor(branch, 1)},
+                    nullptr, 0, nullptr, &reg),
+                kTfLiteOk);
+      sum_inputs.push_back(BranchTensor(branch, 1));
+    }
+    ASSERT_EQ(interpreter_.AddNodeWithParameters(sum_inputs, {kOutput}, nullptr,
+                                                 0, nullptr, &reg),
+              kTfLiteOk);
+  }
+
+  void TearDown() final { inter_op_record = nullptr; }
+
+  // Invokes the graph and checks its output.
+  void InvokeAndCheck() {
+    float* input = interpreter_.typed_tensor<float>(0);
+    for (int i = 0; i < 256; ++i) input[i] = i;
+    ASSERT_EQ(interpreter_.Invoke(), kTfLiteOk);
+    const float* output = interpreter_.typed_tensor<float>(kOutput);
+    for (int i = 0; i < 256; ++i) {
+      ASSERT_EQ(output[i], kNumBranches * (i + 2) + 1) << i;
+    }
+  }
+
+  // Returns true if the buffers of the given tensors overlap.
+  bool Overlaps(int tensor1, int tensor2) {
+    const TfLiteTensor* t1 = interpreter_.tensor(tensor1);
+    const TfLiteTensor* t2 = interpreter_.tensor(tensor2);
+    return t1->data.raw < t2->data.raw + t2->bytes &&
+           t2->data.raw < t1->data.raw + t1->bytes;
+  }
+
+  InterOpRecord record_;
+  Interpreter interpreter_;
+};
+
+TEST_F(InterOpParallelismTest, Sequential) {
+  ASSERT_EQ(interpreter_.AllocateTensors(), kTfLiteOk);
+  InvokeAndCheck();
+  EXPECT_EQ(record_.max_num_running, 1);
+  // Each branch's first output is dead before the next branch starts.
+  EXPECT_TRUE(Overlaps(BranchTensor(0, 0), BranchTensor(1, 0)));
+}
+
+TEST_F(InterOpParallelismTest, RunsIndependentNodesConcurrently) {
+  ASSERT_EQ(interpreter_.SetNumInterOpThreads(kNumBranches), kTfLiteOk);
+  ASSERT_EQ(interpreter_.AllocateTensors(), kTfLiteOk);
+  InvokeAndCheck();
+  InvokeAndCheck();
+  EXPECT_GE(record_.max_num_running, 2);
+
+  // Tensors used by nodes that may run at the same time don't share memory.
+  for (int node = 0; node < 2; ++node) {
+    for (int branch1 = 0; branch1 < kNumBranches; ++branch1) {
+      EXPECT_FALSE(Overlaps(0, BranchTensor(branch1, node)));
+      for (int branch2 = 0; branch2 < kNumBranches; ++branch2) {
+        if (branch1 == branch2) continue;
+        EXPECT_FALSE(
+            Overlaps(BranchTensor(branch1, node), BranchTensor(branch2, node)))
+            << branch1 << ", " << branch2;
+        EXPECT_FALSE(Overlaps(BranchTensor(branch1, 0),
+                              BranchTensor(branch2, 1)))
+            << branch1 << ", " << branch2;
+      }
+    }
+  }
+
+  // Every thread has a cpu backend context of its own.
+  std::set<TfLiteExternalContext*> contexts;
+  for (const auto& thread_and_context : record_.contexts) {
+    EXPECT_NE(thread_and_context.second, nullptr);
+    contexts.insert(thread_and_context.second);
+  }
+  EXPECT_EQ(contexts.size(), record_.contexts.size());
+}
+
+TEST_F(InterOpParallelismTest, BackToSequential) {
+  ASSERT_EQ(interpreter_.SetNumInterOpThreads(kNumBranches), kTfLiteOk);
+  ASSERT_EQ(interpreter_.AllocateTensors(), kTfLiteOk);
+  InvokeAndCheck();
+
+  ASSERT_EQ(interpreter_.SetNumInterOpThreads(1), kTfLiteOk);
+  // The graph needs to be allocated again.
+  ASSERT_NE(interpreter_.Invoke(), kTfLiteOk);
+  ASSERT_EQ(interpreter_.AllocateTensors(), kTfLiteOk);
+  record_.max_num_running = 0;
+  InvokeAndCheck();
+  EXPECT_EQ(record_.max_num_running, 1);
+  EXPECT_TRUE(Overlaps(BranchTensor(0, 0), BranchTensor(1, 0)));
+}
+
+TEST_F(InterOpParallelismTest, InvalidNumThreads) {
+  EXPECT_EQ(interpreter_.SetNumInterOpThreads(0), kTfLiteError);
+}
+
 }  // namespace
 }  // namespace tflite
 
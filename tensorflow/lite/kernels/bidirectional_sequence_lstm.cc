@@ -1085,7 +1085,8 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
           fw_output_gate_bias, fw_projection_weights, fw_projection_bias,
           &lstm_params,
           /*forward_sequence=*/true, time_major, /*output_offset=*/0,
-          fw_scratch_buffer, fw_activation_state, fw_cell_state, fw_output);
+          fw_scratch_buffer, fw_activation_state, fw_cell_state, fw_output,
+          /*context=*/nullptr);
       TF_LITE_ENSURE_OK(context, fw_pass_status);
 
       TfLiteStatus bw_pass_status = lstm_eval::EvalFloat(
@@ -1106,7 +1107,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
           &lstm_params,
           /*forward_sequence=*/false, time_major, bw_output_offset,
           bw_scratch_buffer, bw_activation_state, bw_cell_state,
-          actual_bw_output);
+          actual_bw_output, /*context=*/nullptr);
       TF_LITE_ENSURE_OK(context, bw_pass_status);
       return kTfLiteOk;
     }
@@ -17,6 +17,7 @@ limitations under the License.
 #include <stddef.h>
 
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 #include "tensorflow/lite/c/builtin_op_data.h"
@@ -30,6 +31,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/optimized/multithreaded_conv.h"
 #endif
 #include "tensorflow/lite/kernels/internal/optimized/optimized_ops.h"
+#include "tensorflow/lite/kernels/internal/optimized/sparse_ops/fully_connected.h"
 #include "tensorflow/lite/kernels/internal/quantization_util.h"
 #include "tensorflow/lite/kernels/internal/reference/conv.h"
 #include "tensorflow/lite/kernels/internal/reference/integer_ops/conv.h"
@@ -38,6 +40,8 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/tensor_utils.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
 #include "tensorflow/lite/kernels/padding.h"
+#include "tensorflow/lite/kernels/weight_cache.h"
+#include "tensorflow/lite/tools/optimize/sparsity/format_converter.h"
 
 namespace tflite {
 namespace ops {
@@ -98,13 +102,35 @@ struct OpData {
 
   bool need_hwcn_weights = false;
   bool have_weights_been_transposed = false;
+  // Constant filters are transposed once per process and shared through the
+  // WeightCache, instead of into the `hwcn_weights` temporary.
+  bool hwcn_weights_from_cache = false;
+  std::shared_ptr<const WeightCache::Entry> cached_hwcn_weights;
   bool need_im2col = false;
 
+  // A 1x1 filter with unit strides in a block sparse format runs as a block
+  // sparse fully connected over the pixels. The reference kernel runs the
+  // dense convolution on a dense copy of the filter instead.
+  bool is_block_sparse = false;
+  optimized_ops::BlockSparseMatrix sparse_filter;
+  std::vector<float> dense_float_filter;
+  std::vector<int8_t> dense_int8_filter;
+
   bool supports_multithreaded_kernel = false;
   bool is_hybrid_per_channel = false;
   bool compute_hybrid_row_sums = true;
 };
 
+// Returns the dense values of the sparse constant `filter`.
+template <typename T>
+std::vector<T> DensifyFilter(const TfLiteTensor* filter) {
+  std::vector<int> shape(filter->dims->data,
+                         filter->dims->data + filter->dims->size);
+  optimize::sparsity::FormatConverter<T> converter(shape, *filter->sparsity);
+  converter.SparseToDense(GetTensorData<T>(filter));
+  return converter.GetData();
+}
+
 inline PaddingType RuntimePaddingType(TfLitePadding padding) {
   switch (padding) {
     case TfLitePadding::kTfLitePaddingSame:
@@ -134,11 +160,8 @@ void Free(TfLiteContext* context, void* buffer) {
 // Naive implementation of transpose for floats. Could be optimized to be more
 // cache friendly, but for now it's a one-time cost on first run, and we would
 // prefer to remove the need to do this at all eventually.
-void TransposeFloatTensor(const TfLiteTensor* input, TfLiteTensor* output) {
-  const int rows = output->dims->data[1];
-  const int cols = output->dims->data[0];
-  const float* input_data = GetTensorData<float>(input);
-  float* output_data = GetTensorData<float>(output);
+void TransposeFloatMatrix(const float* input_data, int rows, int cols,
+                          float* output_data) {
   for (int i = 0; i < rows; ++i) {
     for (int j = 0; j < cols; ++j) {
       const float in_value = input_data[i * cols + j];
@@ -147,6 +170,27 @@ void TransposeFloatTensor(const TfLiteTensor* input, TfLiteTensor* output) {
   }
 }
 
+void TransposeFloatTensor(const TfLiteTensor* input, TfLiteTensor* output) {
+  TransposeFloatMatrix(GetTensorData<float>(input), output->dims->data[1],
+                       output->dims->data[0], GetTensorData<float>(output));
+}
+
+// Returns the transposed `filter` from the process-wide weight cache, packing
+// it if no other interpreter has yet.
+std::shared_ptr<const WeightCache::Entry> GetCachedHwcnWeights(
+    const TfLiteTensor* filter) {
+  const int rows = filter->dims->data[0];
+  const int cols = NumElements(filter) / rows;
+  const float* filter_data = GetTensorData<float>(filter);
+  return WeightCache::Global().GetOrPack(
+      filter_data, filter->bytes, WeightCache::kConvHwcnFloat,
+      (static_cast<uint64_t>(rows) << 32) | static_cast<uint32_t>(cols),
+      filter->bytes, [filter_data, rows, cols](void* packed) {
+        TransposeFloatMatrix(filter_data, rows, cols,
+                             static_cast<float*>(packed));
+      });
+}
+
 // Check if im2col needs to be allocated, as some version of optimized Conv dont
 // use it. If any change is supporting im2col in any of the Conv versions, then
 // it should be updated here as well
@@ -225,6 +269,8 @@ static TfLiteStatus AllocateTemporaryTensorsIfRequired(TfLiteContext* context,
   // we're running with that data type.
   data->need_hwcn_weights =
       input->type == kTfLiteFloat32 && data->supports_multithreaded_kernel;
+  data->hwcn_weights_from_cache =
+      data->need_hwcn_weights && filter->allocation_type == kTfLiteMmapRo;
 
   // We don't always need to allocate im2col. It is only used in some versions
   // of the optimized Conv. This test just mimics something that happens inside
@@ -240,7 +286,7 @@ static TfLiteStatus AllocateTemporaryTensorsIfRequired(TfLiteContext* context,
     }
     ++temporaries_count;
   }
-  if (data->need_hwcn_weights) {
+  if (data->need_hwcn_weights && !data->hwcn_weights_from_cache) {
     data->hwcn_weights_index = temporaries_count;
     if (data->hwcn_weights_id == kTensorNotAllocated) {
       context->AddTensors(context, 1, &data->hwcn_weights_id);
@@ -367,11 +413,37 @@ TfLiteStatus Prepare(KernelType kernel_type, TfLiteContext* context,
     }
   }
 
+  data->is_block_sparse = false;
+  if (filter->sparsity != nullptr) {
+    if (filter->type != input_type ||
+        (input_type != kTfLiteFloat32 && input_type != kTfLiteInt8) ||
+        (input_type == kTfLiteInt8 && filter->params.zero_point != 0) ||
+        filter->dims->data[1] != 1 || filter->dims->data[2] != 1 ||
+        params->stride_width != 1 || params->stride_height != 1 ||
+        params->dilation_width_factor != 1 ||
+        params->dilation_height_factor != 1 ||
+        !optimized_ops::GetBlockSparseMatrix(*filter->sparsity,
+                                             GetTensorShape(filter),
+                                             &data->sparse_filter)) {
+      TF_LITE_KERNEL_LOG(context, "Unsupported sparse Conv filter format.");
+      return kTfLiteError;
+    }
+    data->is_block_sparse = true;
+    if (kernel_type == kReference) {
+      if (input_type == kTfLiteFloat32) {
+        data->dense_float_filter = DensifyFilter<float>(filter);
+      } else {
+        data->dense_int8_filter = DensifyFilter<int8_t>(filter);
+      }
+    }
+  }
+
   // The multi-threaded kernel supports neither dilation nor hybrid kernels, and
   // is incompatible with mutable input filters that might change between evals.
   data->supports_multithreaded_kernel =
       (kernel_type == kMultithreadOptimized) &&
       (context->recommended_num_threads != 1) && !is_hybrid &&
+      !data->is_block_sparse &&
       (params->dilation_width_factor == 1) &&
       (params->dilation_height_factor == 1) &&
       (filter->allocation_type != kTfLiteArenaRw) &&
@@ -453,7 +525,7 @@ TfLiteStatus Prepare(KernelType kernel_type, TfLiteContext* context,
     if (im2col_status != kTfLiteOk) return im2col_status;
   }
 
-  if (data->need_hwcn_weights) {
+  if (data->need_hwcn_weights && !data->hwcn_weights_from_cache) {
     node->temporaries->data[data->hwcn_weights_index] = data->hwcn_weights_id;
     TfLiteIntArray* hwcn_weights_size = TfLiteIntArrayCreate(2);
 
@@ -654,15 +726,35 @@ void EvalQuantizedPerChannel(TfLiteContext* context, TfLiteNode* node,
   op_params.quantized_activation_min = data->output_activation_min;
   op_params.quantized_activation_max = data->output_activation_max;
 
+  if (data->is_block_sparse && kernel_type != kReference) {
+    FullyConnectedParams fc_params;
+    fc_params.input_offset = op_params.input_offset;
+    fc_params.weights_offset = 0;
+    fc_params.output_offset = op_params.output_offset;
+    fc_params.quantized_activation_min = op_params.quantized_activation_min;
+    fc_params.quantized_activation_max = op_params.quantized_activation_max;
+    optimized_ops::FullyConnectedBlockSparseWeight(
+        data->sparse_filter, fc_params,
+        data->per_channel_output_multiplier.data(),
+        data->per_channel_output_shift.data(), GetTensorShape(input),
+        GetTensorData<int8>(input), GetTensorShape(filter),
+        GetTensorData<int8>(filter), GetTensorShape(bias),
+        GetTensorData<int32>(bias), GetTensorShape(output),
+        GetTensorData<int8>(output),
+        CpuBackendContext::GetFromContext(context));
+    return;
+  }
+
   switch (kernel_type) {
     case kReference: {
       reference_integer_ops::ConvPerChannel(
           op_params, data->per_channel_output_multiplier.data(),
           data->per_channel_output_shift.data(), GetTensorShape(input),
           GetTensorData<int8>(input), GetTensorShape(filter),
-          GetTensorData<int8>(filter), GetTensorShape(bias),
-          GetTensorData<int32>(bias), GetTensorShape(output),
-          GetTensorData<int8>(output));
+          data->is_block_sparse ? data->dense_int8_filter.data()
+                                : GetTensorData<int8>(filter),
+          GetTensorShape(bias), GetTensorData<int32>(bias),
+          GetTensorShape(output), GetTensorData<int8>(output));
       break;
     }
     case kGenericOptimized:
@@ -727,6 +819,19 @@ void EvalFloat(TfLiteContext* context, TfLiteNode* node,
   float output_activation_min, output_activation_max;
   CalculateActivationRange(params->activation, &output_activation_min,
                            &output_activation_max);
+  if (data->is_block_sparse && kernel_type != kReference) {
+    FullyConnectedParams fc_params;
+    fc_params.float_activation_min = output_activation_min;
+    fc_params.float_activation_max = output_activation_max;
+    optimized_ops::FullyConnectedBlockSparseWeight(
+        data->sparse_filter, fc_params, GetTensorShape(input),
+        GetTensorData<float>(input), GetTensorShape(filter),
+        GetTensorData<float>(filter), GetTensorShape(bias),
+        GetTensorData<float>(bias), GetTensorShape(output),
+        GetTensorData<float>(output),
+        CpuBackendContext::GetFromContext(context));
+    return;
+  }
   KernelType effective_kernel_type = kernel_type;
   // Fall back to the optimized path if multi-threaded conv is unsupported.
   if ((kernel_type == kMultithreadOptimized) &&
@@ -747,10 +852,12 @@ void EvalFloat(TfLiteContext* context, TfLiteNode* node,
     case kReference: {
       reference_ops::Conv(op_params, GetTensorShape(input),
                           GetTensorData<float>(input), GetTensorShape(filter),
-                          GetTensorData<float>(filter), GetTensorShape(bias),
-                          GetTensorData<float>(bias), GetTensorShape(output),
-                          GetTensorData<float>(output), GetTensorShape(im2col),
-                          GetTensorData<float>(im2col));
+                          data->is_block_sparse
+                              ? data->dense_float_filter.data()
+                              : GetTensorData<float>(filter),
+                          GetTensorShape(bias), GetTensorData<float>(bias),
+                          GetTensorShape(output), GetTensorData<float>(output),
+                          GetTensorShape(im2col), GetTensorData<float>(im2col));
       break;
     }
     case kCblasOptimized:
@@ -772,7 +879,10 @@ void EvalFloat(TfLiteContext* context, TfLiteNode* node,
       TFLITE_DCHECK(false);
 #else
       const float* filter_data;
-      if (data->need_hwcn_weights) {
+      if (data->hwcn_weights_from_cache) {
+        filter_data =
+            static_cast<const float*>(data->cached_hwcn_weights->data());
+      } else if (data->need_hwcn_weights) {
         filter_data = GetTensorData<float>(hwcn_weights);
       } else {
         filter_data = GetTensorData<float>(filter);
@@ -945,11 +1055,15 @@ TfLiteStatus EvalImpl(TfLiteContext* context, TfLiteNode* node) {
           ? &context->tensors[node->temporaries->data[data->im2col_index]]
           : nullptr;
   TfLiteTensor* hwcn_weights =
-      data->need_hwcn_weights
+      data->need_hwcn_weights && !data->hwcn_weights_from_cache
           ? &context->tensors[node->temporaries->data[data->hwcn_weights_index]]
           : nullptr;
 
-  if (data->need_hwcn_weights && !data->have_weights_been_transposed) {
+  if (data->hwcn_weights_from_cache) {
+    if (!data->cached_hwcn_weights) {
+      data->cached_hwcn_weights = GetCachedHwcnWeights(filter);
+    }
+  } else if (data->need_hwcn_weights && !data->have_weights_been_transposed) {
     TransposeFloatTensor(filter, hwcn_weights);
     data->have_weights_been_transposed = true;
   }
@@ -451,6 +451,225 @@ TEST_P(ConvolutionOpTest, PointwiseFloat32) {
                              }));
 }
 
+class SparseConvolutionOpModel : public SingleOpModel {
+ public:
+  SparseConvolutionOpModel(TfLiteRegistration* registration,
+                           const TensorData& input, const TensorData& filter,
+                           std::initializer_list<float> filter_data,
+                           int stride = 1) {
+    input_ = AddInput(input);
+    filter_ = AddConstSparseInput(filter, filter_data);
+    bias_ = AddInput({TensorType_FLOAT32, {GetShape(filter_)[0]}});
+    output_ = AddOutput({TensorType_FLOAT32, {}});
+
+    SetBuiltinOp(BuiltinOperator_CONV_2D, BuiltinOptions_Conv2DOptions,
+                 CreateConv2DOptions(builder_, Padding_VALID,
+                                     /*stride_w=*/stride, /*stride_h=*/stride)
+                     .Union());
+    resolver_ = absl::make_unique<SingleOpResolver>(BuiltinOperator_CONV_2D,
+                                                    registration);
+    BuildInterpreter({GetShape(input_), GetShape(filter_), GetShape(bias_)},
+                     /*num_threads=*/-1, /*allow_fp32_relax_to_fp16=*/false,
+                     /*apply_delegate=*/false);
+  }
+
+  void SetBias(std::initializer_list<float> f) { PopulateTensor(bias_, f); }
+  void SetInput(std::initializer_list<float> data) {
+    PopulateTensor(input_, data);
+  }
+  std::vector<float> GetOutput() { return ExtractVector<float>(output_); }
+
+ private:
+  int input_;
+  int filter_;
+  int bias_;
+  int output_;
+};
+
+TEST_P(ConvolutionOpTest, BlockSparsePointwiseFloat32) {
+  std::initializer_list<float> filter_data = {
+      1, 1, -1, 2, 0, 0, 0, 0,  // first filter
+      2, 1, -1, 2, 0, 0, 0, 0,  // second filter
+      3, 1, -1, 2, 0, 0, 0, 0,  // third filter
+      4, 1, -1, 2, 0, 0, 0, 0,  // fourth filter
+  };
+  for (const std::vector<int>& block_size :
+       std::vector<std::vector<int>>{{4}, {4, 4}}) {
+    TensorData filter = {TensorType_FLOAT32, {4, 1, 1, 8}};
+    filter.format = {kTfLiteDimDense, kTfLiteDimDense, kTfLiteDimDense,
+                     kTfLiteDimSparseCSR};
+    filter.block_size = block_size;
+    if (block_size.size() == 1) {
+      filter.traversal_order = {0, 1, 2, 3, 4};
+      filter.block_map = {3};
+    } else {
+      filter.traversal_order = {0, 1, 2, 3, 4, 5};
+      filter.block_map = {0, 3};
+    }
+    SparseConvolutionOpModel m(GetRegistration(),
+                               {TensorType_FLOAT32, {1, 2, 2, 8}}, filter,
+                               filter_data);
+
+    m.SetInput({
+        0, 1, 2, 3, 9, 9, 9, 9,  // pixel = 0
+        1, 1, 2, 3, 9, 9, 9, 9,  // pixel = 1
+        2, 1, 2, 3, 9, 9, 9, 9,  // pixel = 2
+        3, 1, 2, 3, 9, 9, 9, 9,  // pixel = 3
+    });
+    m.SetBias({0, 1, 2, 3});
+
+    m.Invoke();
+
+    EXPECT_THAT(m.GetOutput(), ElementsAreArray({
+                                   5, 6, 7, 8,     // pixel = 0
+                                   6, 8, 10, 12,   // pixel = 1
+                                   7, 10, 13, 16,  // pixel = 2
+                                   8, 12, 16, 20,  // pixel = 3
+                               }));
+  }
+}
+
+class SparsePerChannelQuantizedConvolutionOpModel : public SingleOpModel {
+ public:
+  SparsePerChannelQuantizedConvolutionOpModel(
+      TfLiteRegistration* registration, const TensorData& input,
+      const TensorData& filter, std::initializer_list<int8_t> filter_data,
+      const TensorData& output) {
+    input_ = AddInput(input);
+    filter_ = AddConstSparseInput(filter, filter_data);
+    std::vector<float> bias_scales;
+    for (float filter_scale : filter.per_channel_quantization_scales) {
+      bias_scales.push_back(input.scale * filter_scale);
+    }
+    bias_ = AddInput({TensorType_INT32,
+                      {GetShape(filter_)[0]},
+                      /*min=*/0,
+                      /*max=*/0,
+                      /*scale=*/0,
+                      /*zero_point=*/0,
+                      /*per_channel_quantization=*/true,
+                      bias_scales,
+                      std::vector<int64_t>(bias_scales.size(), 0),
+                      /*channel_index=*/0});
+    output_ = AddOutput(output);
+
+    SetBuiltinOp(BuiltinOperator_CONV_2D, BuiltinOptions_Conv2DOptions,
+                 CreateConv2DOptions(builder_, Padding_VALID,
+                                     /*stride_w=*/1, /*stride_h=*/1)
+                     .Union());
+    resolver_ = absl::make_unique<SingleOpResolver>(BuiltinOperator_CONV_2D,
+                                                    registration);
+    BuildInterpreter({GetShape(input_), GetShape(filter_), GetShape(bias_)},
+                     /*num_threads=*/-1, /*allow_fp32_relax_to_fp16=*/false,
+                     /*apply_delegate=*/false);
+  }
+
+  void SetInput(std::initializer_list<float> data) {
+    QuantizeAndPopulate<int8_t>(input_, data);
+  }
+  void SetBias(std::initializer_list<float> data) {
+    PerChannelQuantizeBias(bias_, data);
+  }
+  std::vector<float> GetDequantizedOutput() {
+    return Dequantize<int8_t>(ExtractVector<int8_t>(output_), GetScale(output_),
+                              GetZeroPoint(output_));
+  }
+
+ private:
+  int input_;
+  int filter_;
+  int bias_;
+  int output_;
+};
+
+TEST_P(ConvolutionOpTest, BlockSparsePointwisePerChannelInt8) {
+  // The same filters as in BlockSparsePointwiseFloat32, with a scale per
+  // output channel.
+  std::initializer_list<int8_t> filter_data = {
+      1,  1, -1, 2, 0, 0, 0, 0,  // first filter, scale = 1
+      4,  2, -2, 4, 0, 0, 0, 0,  // second filter, scale = 0.5
+      3,  1, -1, 2, 0, 0, 0, 0,  // third filter, scale = 1
+      16, 4, -4, 8, 0, 0, 0, 0,  // fourth filter, scale = 0.25
+  };
+  TensorData filter = {TensorType_INT8,
+                       {4, 1, 1, 8},
+                       /*min=*/0,
+                       /*max=*/0,
+                       /*scale=*/0,
+                       /*zero_point=*/0,
+                       /*per_channel_quantization=*/true,
+                       /*per_channel_quantization_scales=*/{1, 0.5, 1, 0.25},
+                       /*per_channel_quantization_offsets=*/{0, 0, 0, 0},
+                       /*channel_index=*/0};
+  filter.format = {kTfLiteDimDense, kTfLiteDimDense, kTfLiteDimDense,
+                   kTfLiteDimSparseCSR};
+  filter.block_size = {4};
+  filter.traversal_order = {0, 1, 2, 3, 4};
+  filter.block_map = {3};
+  SparsePerChannelQuantizedConvolutionOpModel m(
+      GetRegistration(), {TensorType_INT8, {1, 2, 2, 8}, -63.5, 64, 0.5, -1},
+      filter, filter_data, {TensorType_INT8, {}, -63.5, 64, 0.5, -1});
+
+  m.SetInput({
+      0, 1, 2, 3, 9, 9, 9, 9,  // pixel = 0
+      1, 1, 2, 3, 9, 9, 9, 9,  // pixel = 1
+      2, 1, 2, 3, 9, 9, 9, 9,  // pixel = 2
+      3, 1, 2, 3, 9, 9, 9, 9,  // pixel = 3
+  });
+  m.SetBias({0, 1, 2, 3});
+
+  m.Invoke();
+
+  EXPECT_THAT(m.GetDequantizedOutput(), ElementsAreArray(ArrayFloatNear({
+                                            5, 6, 7, 8,     // pixel = 0
+                                            6, 8, 10, 12,   // pixel = 1
+                                            7, 10, 13, 16,  // pixel = 2
+                                            8, 12, 16, 20,  // pixel = 3
+                                        })));
+}
+
+#ifdef GTEST_HAS_DEATH_TEST
+// Only 1x1 filters with unit strides can be block sparse.
+TEST_P(ConvolutionOpTest, BlockSparseFilterMustBePointwise) {
+  TensorData filter = {TensorType_FLOAT32, {4, 1, 2, 4}};
+  filter.format = {kTfLiteDimDense, kTfLiteDimDense, kTfLiteDimDense,
+                   kTfLiteDimSparseCSR};
+  filter.block_size = {4};
+  filter.traversal_order = {0, 1, 2, 3, 4};
+  filter.block_map = {3};
+  EXPECT_DEATH(SparseConvolutionOpModel(GetRegistration(),
+                                        {TensorType_FLOAT32, {1, 2, 2, 4}},
+                                        filter,
+                                        {
+                                            1, 1, -1, 2, 0, 0, 0, 0,  //
+                                            2, 1, -1, 2, 0, 0, 0, 0,  //
+                                            3, 1, -1, 2, 0, 0, 0, 0,  //
+                                            4, 1, -1, 2, 0, 0, 0, 0,  //
+                                        }),
+               "Cannot allocate tensors");
+}
+
+TEST_P(ConvolutionOpTest, BlockSparseFilterMustHaveUnitStrides) {
+  TensorData filter = {TensorType_FLOAT32, {4, 1, 1, 8}};
+  filter.format = {kTfLiteDimDense, kTfLiteDimDense, kTfLiteDimDense,
+                   kTfLiteDimSparseCSR};
+  filter.block_size = {4};
+  filter.traversal_order = {0, 1, 2, 3, 4};
+  filter.block_map = {3};
+  EXPECT_DEATH(SparseConvolutionOpModel(GetRegistration(),
+                                        {TensorType_FLOAT32, {1, 2, 2, 8}},
+                                        filter,
+                                        {
+                                            1, 1, -1, 2, 0, 0, 0, 0,  //
+                                            2, 1, -1, 2, 0, 0, 0, 0,  //
+                                            3, 1, -1, 2, 0, 0, 0, 0,  //
+                                            4, 1, -1, 2, 0, 0, 0, 0,  //
+                                        },
+                                        /*stride=*/2),
+               "Cannot allocate tensors");
+}
+#endif
+
 // TODO(alanchiao): this passes locally, but fails on continuous build system.
 // Re-enable when root cause found.
 TEST_P(ConvolutionOpTest, DISABLED_PointwiseMultifilterFloat32) {
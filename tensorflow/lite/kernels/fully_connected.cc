@@ -51,7 +51,6 @@ bool SupportedSparsityFormat(const TfLiteSparsity& sparsity) {
 }
 
 static const int kDimMetadataSizeRandomSparse = 2;
-static const int kDimMetadataSizeBlockSparse = 3;
 
 }  // namespace
 
@@ -423,10 +422,11 @@ TfLiteStatus EvalHybrid(TfLiteContext* context, TfLiteNode* node,
 
 namespace {
 template <KernelType kernel_type>
-void FullyConnectedInt8(const OpData* data, const TfLiteTensor* input,
-                        const TfLiteTensor* filter, const TfLiteTensor* bias,
-                        TfLiteTensor* output,
-                        CpuBackendContext* cpu_backend_context) {
+TfLiteStatus FullyConnectedInt8(TfLiteContext* context, const OpData* data,
+                                const TfLiteTensor* input,
+                                const TfLiteTensor* filter,
+                                const TfLiteTensor* bias, TfLiteTensor* output,
+                                CpuBackendContext* cpu_backend_context) {
   FullyConnectedParams op_params;
   op_params.input_offset = -input->params.zero_point;
   op_params.weights_offset = -filter->params.zero_point;
@@ -437,7 +437,34 @@ void FullyConnectedInt8(const OpData* data, const TfLiteTensor* input,
   op_params.quantized_activation_max = data->output_activation_max;
   op_params.lhs_cacheable = IsConstantTensor(filter);
   op_params.rhs_cacheable = IsConstantTensor(input);
-  if (kernel_type == kReference) {
+  if (filter->sparsity != nullptr) {
+    const auto& sparsity = *filter->sparsity;
+    if (kernel_type == kReference) {
+      reference_ops::FullyConnectedSparseWeight(
+          sparsity, op_params, GetTensorShape(input),
+          GetTensorData<int8_t>(input), GetTensorShape(filter),
+          GetTensorData<int8_t>(filter), GetTensorShape(bias),
+          GetTensorData<int32_t>(bias), GetTensorShape(output),
+          GetTensorData<int8_t>(output));
+      return kTfLiteOk;
+    }
+    // Block sparse with block size of 1x4 or 4x4, and symmetric weights.
+    optimized_ops::BlockSparseMatrix weights_matrix;
+    if (filter->params.zero_point != 0 ||
+        !optimized_ops::GetBlockSparseMatrix(sparsity, GetTensorShape(filter),
+                                             &weights_matrix)) {
+      TF_LITE_KERNEL_LOG(context,
+                         "Unsupported sparse fully-connected weight format.");
+      return kTfLiteError;
+    }
+    optimized_ops::FullyConnectedBlockSparseWeight(
+        weights_matrix, op_params, /*output_multiplier=*/nullptr,
+        /*output_shift=*/nullptr, GetTensorShape(input),
+        GetTensorData<int8_t>(input), GetTensorShape(filter),
+        GetTensorData<int8_t>(filter), GetTensorShape(bias),
+        GetTensorData<int32_t>(bias), GetTensorShape(output),
+        GetTensorData<int8_t>(output), cpu_backend_context);
+  } else if (kernel_type == kReference) {
     reference_integer_ops::FullyConnected(
         op_params, GetTensorShape(input), GetTensorData<int8_t>(input),
         GetTensorShape(filter), GetTensorData<int8_t>(filter),
@@ -451,6 +478,7 @@ void FullyConnectedInt8(const OpData* data, const TfLiteTensor* input,
         GetTensorShape(output), GetTensorData<int8_t>(output),
         cpu_backend_context);
   }
+  return kTfLiteOk;
 }
 }  // namespace
 
@@ -521,10 +549,9 @@ TfLiteStatus EvalQuantized(TfLiteContext* context, TfLiteNode* node,
         }
         break;
       case kTfLiteInt8:
-        FullyConnectedInt8<kernel_type>(
-            data, input, filter, bias, output,
+        return FullyConnectedInt8<kernel_type>(
+            context, data, input, filter, bias, output,
             CpuBackendContext::GetFromContext(context));
-        break;
       case kTfLiteInt16:
         if (input->type == kTfLiteInt16) {
           FullyConnectedInt16<kernel_type>(data, input, filter, bias, output);
@@ -648,6 +675,7 @@ TfLiteStatus EvalFloat(TfLiteContext* context, TfLiteNode* node,
         return kTfLiteError;
       }
 
+      optimized_ops::BlockSparseMatrix weights_matrix;
       if (sparsity.dim_metadata_size == kDimMetadataSizeRandomSparse) {
         // Random sparse.
         optimized_ops::FullyConnectedSparseWeight(
@@ -656,11 +684,11 @@ TfLiteStatus EvalFloat(TfLiteContext* context, TfLiteNode* node,
             GetTensorData<float>(filter), GetTensorShape(bias),
             GetTensorData<float>(bias), GetTensorShape(output),
             GetTensorData<float>(output));
-      } else if (sparsity.dim_metadata_size == kDimMetadataSizeBlockSparse &&
-                 sparsity.dim_metadata[2].dense_size == 4) {
-        // Block sparse with block size of 1x4.
-        optimized_ops::FullyConnectedSparseWeight1x4(
-            sparsity, op_params, GetTensorShape(input),
+      } else if (optimized_ops::GetBlockSparseMatrix(
+                     sparsity, GetTensorShape(filter), &weights_matrix)) {
+        // Block sparse with block size of 1x4 or 4x4.
+        optimized_ops::FullyConnectedBlockSparseWeight(
+            weights_matrix, op_params, GetTensorShape(input),
             GetTensorData<float>(input), GetTensorShape(filter),
             GetTensorData<float>(filter), GetTensorShape(bias),
             GetTensorData<float>(bias), GetTensorShape(output),
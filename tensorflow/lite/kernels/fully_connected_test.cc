@@ -1355,6 +1355,123 @@ TEST_P(SparseFullyConnectedOpTest, Simple1x4TestMultiThreadedMoreBatches) {
                                            ));
   }
 }
+
+TEST_P(SparseFullyConnectedOpTest, Simple4x4Test) {
+  std::initializer_list<float> weight_data = {
+      1,  2,  0, -1, 0, 0, 0, 0, 1,  0, 0, 1,   // u = 0
+      0,  1,  1, 0,  0, 0, 0, 0, -1, 2, 0, 0,   // u = 1
+      2,  0,  0, 0,  0, 0, 0, 0, 0,  0, 1, 1,   // u = 2
+      -1, -1, 1, 1,  0, 0, 0, 0, 0,  0, 0, -2,  // u = 3
+  };
+  TensorData weight = {};
+  weight.type = TensorType_FLOAT32;
+  weight.shape = {4, 12};
+  weight.traversal_order = {0, 1, 2, 3};
+  weight.format = {kTfLiteDimDense, kTfLiteDimSparseCSR};
+  weight.block_map = {0, 1};
+  weight.block_size = {4, 4};
+  for (int num_threads = 1; num_threads <= 2; num_threads++) {
+    SparseFullyConnectedOpModel<float> m(
+        GetRegistration(),
+        /*units=*/4, /*batches=*/2,
+        /*input=*/{TensorType_FLOAT32, {2, 12}}, weight, weight_data,
+        num_threads);
+    m.SetBias({1, 2, 3, 4});
+
+    m.SetInput({
+        1,  2, 3,  4, 5, 6, 7, 8, -1, -2, 3,  4,  // b = 0
+        -3, 2, -1, 0, 9, 9, 9, 9, 2,  2,  -2, 1,  // b = 1
+    });
+
+    m.Invoke();
+
+    EXPECT_THAT(m.GetOutputShape(), ElementsAre(2, 4));
+    EXPECT_THAT(m.GetOutput(), ElementsAre(5, 4, 12, 0, 5, 5, 0, 2));
+  }
+}
+
+class SparseQuantizedFullyConnectedOpModel : public SingleOpModel {
+ public:
+  SparseQuantizedFullyConnectedOpModel(
+      TfLiteRegistration* registration, int units, const TensorData& input,
+      const TensorData& weights, std::initializer_list<int8_t> weights_data,
+      const TensorData& output) {
+    input_ = AddInput(input);
+    weights_ = AddConstSparseInput(weights, weights_data);
+    bias_ = AddInput({TensorType_INT32,
+                      {units},
+                      0,
+                      0,
+                      GetScale(input_) * GetScale(weights_)});
+    output_ = AddOutput(output);
+
+    SetBuiltinOp(
+        BuiltinOperator_FULLY_CONNECTED, BuiltinOptions_FullyConnectedOptions,
+        CreateFullyConnectedOptions(builder_, ActivationFunctionType_NONE)
+            .Union());
+    resolver_ = absl::make_unique<SingleOpResolver>(
+        BuiltinOperator_FULLY_CONNECTED, registration);
+    BuildInterpreter({GetShape(input_), GetShape(weights_), GetShape(bias_)},
+                     /*num_threads=*/-1, /*allow_fp32_relax_to_fp16=*/false,
+                     /*apply_delegate=*/false);
+  }
+  void SetBias(const std::vector<float>& data) {
+    QuantizeAndPopulate<int32_t>(bias_, data);
+  }
+  void SetInput(const std::vector<float>& data) {
+    QuantizeAndPopulate<int8_t>(input_, data);
+  }
+  std::vector<int8_t> GetOutput() { return ExtractVector<int8_t>(output_); }
+  std::vector<float> GetDequantizedOutput() {
+    return Dequantize<int8_t>(ExtractVector<int8_t>(output_),
+                              GetScale(output_), GetZeroPoint(output_));
+  }
+
+ protected:
+  int input_;
+  int weights_;
+  int bias_;
+  int output_;
+};
+
+TEST_P(SparseFullyConnectedOpTest, BlockSparseQuantizedInt8) {
+  std::initializer_list<int8_t> weight_data = {
+      1,  2,  0, -1, 0, 0, 0, 0, 1,  0, 0, 1,   // u = 0
+      0,  1,  1, 0,  0, 0, 0, 0, -1, 2, 0, 0,   // u = 1
+      2,  0,  0, 0,  0, 0, 0, 0, 0,  0, 1, 1,   // u = 2
+      -1, -1, 1, 1,  0, 0, 0, 0, 0,  0, 0, -2,  // u = 3
+  };
+  for (const std::vector<int>& block_size :
+       std::vector<std::vector<int>>{{4}, {4, 4}}) {
+    TensorData weight = {TensorType_INT8, {4, 12}, 0, 0, /*scale=*/1.0};
+    weight.format = {kTfLiteDimDense, kTfLiteDimSparseCSR};
+    weight.block_size = block_size;
+    if (block_size.size() == 1) {
+      weight.traversal_order = {0, 1, 2};
+      weight.block_map = {1};
+    } else {
+      weight.traversal_order = {0, 1, 2, 3};
+      weight.block_map = {0, 1};
+    }
+    SparseQuantizedFullyConnectedOpModel m(
+        GetRegistration(), /*units=*/4,
+        /*input=*/{TensorType_INT8, {2, 12}, -63.5, 64}, weight, weight_data,
+        /*output=*/{TensorType_INT8, {}, -127, 128});
+    m.SetBias({1, 2, 3, 4});
+
+    m.SetInput({
+        1,  2, 3,  4, 5, 6, 7, 8, -1, -2, 3,  4,  // b = 0
+        -3, 2, -1, 0, 9, 9, 9, 9, 2,  2,  -2, 1,  // b = 1
+    });
+
+    m.Invoke();
+
+    EXPECT_THAT(m.GetDequantizedOutput(),
+                ElementsAreArray(ArrayFloatNear({5, 4, 12, 0, 5, 5, -4, 2})));
+    EXPECT_THAT(m.GetOutput(), ElementsAre(4, 3, 11, -1, 4, 4, -5, 1));
+  }
+}
+
 // TODO(b/148391360): Add tests for unsupported sparsity format.
 // TEST_P(SparseFullyConnectedOpTest, TestUnsupportedSparsityFormat)
 
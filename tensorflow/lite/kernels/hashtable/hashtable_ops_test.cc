@@ -12,7 +12,9 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
+#include <functional>
 #include <initializer_list>
+#include <string>
 #include <vector>
 
 #include "absl/memory/memory.h"
@@ -26,6 +28,10 @@ limitations under the License.
 #include "tensorflow/lite/model.h"
 #include "tensorflow/lite/testing/util.h"
 
+#ifdef HASHTABLE_BENCHMARKS
+#include "testing/base/public/benchmark.h"
+#endif  // HASHTABLE_BENCHMARKS
+
 namespace tflite {
 
 // Forward declaration for op kernels.
@@ -977,5 +983,178 @@ TEST(HashtableOpsTest, TestHashtableSizeNonInitialized) {
   EXPECT_NE(m.InvokeUnchecked(), kTfLiteOk);
 }
 
+template <typename T>
+T GetTensorValue(const TfLiteTensor* tensor, int index) {
+  return GetTensorData<T>(tensor)[index];
+}
+
+template <>
+std::string GetTensorValue(const TfLiteTensor* tensor, int index) {
+  const StringRef str = GetString(tensor, index);
+  return std::string(str.str, str.len);
+}
+
+// Imports `keys` and `values` into a new hashtable resource and looks up
+// `queries` in it, without going through the hashtable ops.
+template <typename KeyType, typename ValueType>
+std::vector<ValueType> ImportAndLookup(TfLiteType key_type,
+                                       TfLiteType value_type,
+                                       const std::vector<KeyType>& keys,
+                                       const std::vector<ValueType>& values,
+                                       const std::vector<KeyType>& queries,
+                                       const ValueType& default_value) {
+  resource::ResourceMap resources;
+  resource::CreateHashtableResourceIfNotAvailable(&resources, 0, key_type,
+                                                  value_type);
+  auto* lookup = resource::GetHashtableResource(&resources, 0);
+
+  TfLiteContext context;
+  TfLiteTensor key_tensor = CreateTensor<KeyType>(key_type, keys);
+  TfLiteTensor value_tensor = CreateTensor<ValueType>(value_type, values);
+  EXPECT_EQ(lookup->Import(&context, &key_tensor, &value_tensor), kTfLiteOk);
+
+  TfLiteTensor query_tensor = CreateTensor<KeyType>(key_type, queries);
+  TfLiteTensor result_tensor = CreateTensor<ValueType>(
+      value_type, std::vector<ValueType>(queries.size()));
+  TfLiteTensor default_tensor =
+      CreateTensor<ValueType>(value_type, {default_value});
+  EXPECT_EQ(lookup->Lookup(&context, &query_tensor, &result_tensor,
+                           &default_tensor),
+            kTfLiteOk);
+  std::vector<ValueType> results;
+  for (int i = 0; i < queries.size(); ++i) {
+    results.push_back(GetTensorValue<ValueType>(&result_tensor, i));
+  }
+
+  for (TfLiteTensor* tensor : {&key_tensor, &value_tensor, &query_tensor,
+                               &result_tensor, &default_tensor}) {
+    TfLiteTensorFree(tensor);
+  }
+  return results;
+}
+
+TEST(HashtableOpsTest, TestLookupManyInt64Keys) {
+  std::vector<std::int64_t> keys;
+  std::vector<std::string> values;
+  for (int i = 0; i < 1000; ++i) {
+    keys.push_back(i * 7);
+    values.push_back("v" + std::to_string(i));
+  }
+  // The first value of a duplicate key is kept.
+  keys.push_back(0);
+  values.push_back("duplicate");
+
+  // More queries than are probed at once, and not a multiple of it.
+  std::vector<std::int64_t> queries;
+  std::vector<std::string> expected;
+  for (int i = -5; i < 7100; ++i) {
+    queries.push_back(i);
+    const bool found = i >= 0 && i % 7 == 0 && i / 7 < 1000;
+    expected.push_back(found ? "v" + std::to_string(i / 7) : "default");
+  }
+  EXPECT_THAT((ImportAndLookup<std::int64_t, std::string>(
+                  kTfLiteInt64, kTfLiteString, keys, values, queries,
+                  "default")),
+              ElementsAreArray(expected));
+}
+
+TEST(HashtableOpsTest, TestLookupManyStringKeys) {
+  std::vector<std::string> keys;
+  std::vector<std::int64_t> values;
+  for (int i = 0; i < 1000; ++i) {
+    // Keys both shorter and longer than a hashed word.
+    keys.push_back(std::string(i % 13, 'k') + std::to_string(i));
+    values.push_back(i);
+  }
+  keys.push_back("");
+  values.push_back(-7);
+  keys.push_back(keys[5]);
+  values.push_back(99);
+
+  std::vector<std::string> queries;
+  std::vector<std::int64_t> expected;
+  for (int i = 0; i < 1000; ++i) {
+    queries.push_back(keys[(i * 31) % 1000]);
+    expected.push_back((i * 31) % 1000);
+    queries.push_back("missing" + std::to_string(i));
+    expected.push_back(-1);
+  }
+  queries.push_back("");
+  expected.push_back(-7);
+  EXPECT_THAT((ImportAndLookup<std::string, std::int64_t>(
+                  kTfLiteString, kTfLiteInt64, keys, values, queries, -1)),
+              ElementsAreArray(expected));
+}
+
+#ifdef HASHTABLE_BENCHMARKS
+
+// Compile with --copt="-DHASHTABLE_BENCHMARKS"
+// Run with --benchmarks=all
+//
+// Measures lookups of a batch of keys that are all in a hashtable of
+// `state.range(0)` entries, like the vocabulary lookups of text models. The
+// reported items are keys.
+template <typename KeyType, typename ValueType>
+void BenchmarkLookup(benchmark::State& state, TfLiteType key_type,
+                     TfLiteType value_type,
+                     const std::function<KeyType(int)>& make_key,
+                     const std::function<ValueType(int)>& make_value) {
+  const int kNumQueries = 4096;
+  const int num_entries = state.range(0);
+  std::vector<KeyType> keys;
+  std::vector<ValueType> values;
+  for (int i = 0; i < num_entries; ++i) {
+    keys.push_back(make_key(i));
+    values.push_back(make_value(i));
+  }
+  std::vector<KeyType> queries;
+  for (int i = 0; i < kNumQueries; ++i) {
+    queries.push_back(keys[(i * 7919) % num_entries]);
+  }
+
+  resource::ResourceMap resources;
+  resource::CreateHashtableResourceIfNotAvailable(&resources, 0, key_type,
+                                                  value_type);
+  auto* lookup = resource::GetHashtableResource(&resources, 0);
+  TfLiteContext context;
+  TfLiteTensor key_tensor = CreateTensor<KeyType>(key_type, keys);
+  TfLiteTensor value_tensor = CreateTensor<ValueType>(value_type, values);
+  lookup->Import(&context, &key_tensor, &value_tensor);
+  TfLiteTensor query_tensor = CreateTensor<KeyType>(key_type, queries);
+  TfLiteTensor result_tensor = CreateTensor<ValueType>(
+      value_type, std::vector<ValueType>(kNumQueries));
+  TfLiteTensor default_tensor =
+      CreateTensor<ValueType>(value_type, {values[0]});
+  for (auto _ : state) {
+    lookup->Lookup(&context, &query_tensor, &result_tensor, &default_tensor);
+  }
+  state.SetItemsProcessed(state.iterations() * kNumQueries);
+
+  for (TfLiteTensor* tensor : {&key_tensor, &value_tensor, &query_tensor,
+                               &result_tensor, &default_tensor}) {
+    TfLiteTensorFree(tensor);
+  }
+}
+
+void BM_HashtableLookupStringToInt64(benchmark::State& state) {
+  BenchmarkLookup<std::string, std::int64_t>(
+      state, kTfLiteString, kTfLiteInt64,
+      [](int i) { return "token_" + std::to_string(i); },
+      [](int i) { return static_cast<std::int64_t>(i); });
+}
+BENCHMARK(BM_HashtableLookupStringToInt64)->Arg(1000)->Arg(100000)->Arg(
+    1000000);
+
+void BM_HashtableLookupInt64ToString(benchmark::State& state) {
+  BenchmarkLookup<std::int64_t, std::string>(
+      state, kTfLiteInt64, kTfLiteString,
+      [](int i) { return static_cast<std::int64_t>(i) * 2654435761LL; },
+      [](int i) { return "token_" + std::to_string(i); });
+}
+BENCHMARK(BM_HashtableLookupInt64ToString)->Arg(1000)->Arg(100000)->Arg(
+    1000000);
+
+#endif  // HASHTABLE_BENCHMARKS
+
 }  // namespace
 }  // namespace tflite
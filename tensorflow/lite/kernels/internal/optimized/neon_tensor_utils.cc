@@ -241,6 +241,13 @@ inline int32x4x2_t MultiplyByQuantizedMultiplier2Rows(
   return result;
 }
 
+// Loads 4 int8 values, which may end a buffer, widened to int16.
+inline int16x4_t LoadInt8x4AsInt16(const int8_t* ptr) {
+  int32_t bytes;
+  memcpy(&bytes, ptr, sizeof(bytes));
+  return vget_low_s16(vmovl_s8(vreinterpret_s8_s32(vdup_n_s32(bytes))));
+}
+
 }  // namespace
 
 void NeonMatrixBatchVectorMultiplyAccumulate(const float* matrix, int m_rows,
@@ -1989,6 +1996,120 @@ void NeonSparseMatrixBatchVectorMultiplyAccumulate1x4(
   }
 }
 
+void NeonSparseMatrixBatchVectorMultiplyAccumulate4x4(
+    const float* __restrict__ matrix, const int32_t* __restrict__ segments,
+    const int32_t* __restrict__ indices, int m_rows, int m_cols,
+    const float* __restrict__ vector, int n_batch, float* __restrict__ result) {
+  const int kBlockSize = 4;
+  TFLITE_DCHECK_EQ(m_rows % kBlockSize, 0);
+  TFLITE_DCHECK_EQ(m_cols % kBlockSize, 0);
+
+  for (int batch = 0; batch < n_batch; batch++) {
+    const float* matrix_ptr = matrix;
+    const float* vector_in_batch = vector + batch * m_cols;
+    for (int block_row = 0; block_row < m_rows / kBlockSize; block_row++) {
+      float32x4_t acc0_32x4 = vmovq_n_f32(0.0);
+      float32x4_t acc1_32x4 = vmovq_n_f32(0.0);
+      float32x4_t acc2_32x4 = vmovq_n_f32(0.0);
+      float32x4_t acc3_32x4 = vmovq_n_f32(0.0);
+
+      for (int i = segments[block_row]; i < segments[block_row + 1]; i++) {
+        // The 4 vector values are shared by the 4 rows of the block.
+        const float32x4_t vector_f32x4 =
+            vld1q_f32(vector_in_batch + indices[i] * kBlockSize);
+        acc0_32x4 = vmlaq_f32(acc0_32x4, vld1q_f32(matrix_ptr), vector_f32x4);
+        acc1_32x4 =
+            vmlaq_f32(acc1_32x4, vld1q_f32(matrix_ptr + 4), vector_f32x4);
+        acc2_32x4 =
+            vmlaq_f32(acc2_32x4, vld1q_f32(matrix_ptr + 8), vector_f32x4);
+        acc3_32x4 =
+            vmlaq_f32(acc3_32x4, vld1q_f32(matrix_ptr + 12), vector_f32x4);
+        matrix_ptr += kBlockSize * kBlockSize;
+      }
+      float* result_ptr = result + batch * m_rows + block_row * kBlockSize;
+      result_ptr[0] += AccumulateNeonLane(acc0_32x4);
+      result_ptr[1] += AccumulateNeonLane(acc1_32x4);
+      result_ptr[2] += AccumulateNeonLane(acc2_32x4);
+      result_ptr[3] += AccumulateNeonLane(acc3_32x4);
+    }
+  }
+}
+
+void NeonSparseMatrixBatchVectorMultiplyAccumulate1x4(
+    const int8_t* __restrict__ matrix, const int32_t* __restrict__ segments,
+    const int32_t* __restrict__ indices, int m_rows, int m_cols,
+    const int8_t* __restrict__ vectors, int32_t input_offset, int n_batch,
+    int32_t* __restrict__ result) {
+  const int kBlockSize = 4;
+  TFLITE_DCHECK_EQ(m_cols % kBlockSize, 0);
+  // The offset input values fit in int16, so that each block is a single
+  // widening multiply-accumulate.
+  const int16x4_t input_offset_16x4 = vdup_n_s16(input_offset);
+
+  for (int batch = 0; batch < n_batch; batch++) {
+    const int8_t* matrix_ptr = matrix;
+    const int8_t* vector_in_batch = vectors + batch * m_cols;
+    for (int row = 0; row < m_rows; row++) {
+      int32x4_t acc_32x4 = vmovq_n_s32(0);
+      for (int i = segments[row]; i < segments[row + 1]; i++) {
+        const int16x4_t vector_16x4 = vadd_s16(
+            LoadInt8x4AsInt16(vector_in_batch + indices[i] * kBlockSize),
+            input_offset_16x4);
+        acc_32x4 =
+            vmlal_s16(acc_32x4, LoadInt8x4AsInt16(matrix_ptr), vector_16x4);
+        matrix_ptr += kBlockSize;
+      }
+      result[batch * m_rows + row] += AccumulateNeonLane(acc_32x4);
+    }
+  }
+}
+
+void NeonSparseMatrixBatchVectorMultiplyAccumulate4x4(
+    const int8_t* __restrict__ matrix, const int32_t* __restrict__ segments,
+    const int32_t* __restrict__ indices, int m_rows, int m_cols,
+    const int8_t* __restrict__ vectors, int32_t input_offset, int n_batch,
+    int32_t* __restrict__ result) {
+  const int kBlockSize = 4;
+  TFLITE_DCHECK_EQ(m_rows % kBlockSize, 0);
+  TFLITE_DCHECK_EQ(m_cols % kBlockSize, 0);
+  const int16x4_t input_offset_16x4 = vdup_n_s16(input_offset);
+
+  for (int batch = 0; batch < n_batch; batch++) {
+    const int8_t* matrix_ptr = matrix;
+    const int8_t* vector_in_batch = vectors + batch * m_cols;
+    for (int block_row = 0; block_row < m_rows / kBlockSize; block_row++) {
+      int32x4_t acc0_32x4 = vmovq_n_s32(0);
+      int32x4_t acc1_32x4 = vmovq_n_s32(0);
+      int32x4_t acc2_32x4 = vmovq_n_s32(0);
+      int32x4_t acc3_32x4 = vmovq_n_s32(0);
+
+      for (int i = segments[block_row]; i < segments[block_row + 1]; i++) {
+        const int16x4_t vector_16x4 = vadd_s16(
+            LoadInt8x4AsInt16(vector_in_batch + indices[i] * kBlockSize),
+            input_offset_16x4);
+        // A block is 16 int8 values, i.e. one full NEON register.
+        const int8x16_t matrix_8x16 = vld1q_s8(matrix_ptr);
+        const int16x8_t rows01_16x8 = vmovl_s8(vget_low_s8(matrix_8x16));
+        const int16x8_t rows23_16x8 = vmovl_s8(vget_high_s8(matrix_8x16));
+        acc0_32x4 =
+            vmlal_s16(acc0_32x4, vget_low_s16(rows01_16x8), vector_16x4);
+        acc1_32x4 =
+            vmlal_s16(acc1_32x4, vget_high_s16(rows01_16x8), vector_16x4);
+        acc2_32x4 =
+            vmlal_s16(acc2_32x4, vget_low_s16(rows23_16x8), vector_16x4);
+        acc3_32x4 =
+            vmlal_s16(acc3_32x4, vget_high_s16(rows23_16x8), vector_16x4);
+        matrix_ptr += kBlockSize * kBlockSize;
+      }
+      int32_t* result_ptr = result + batch * m_rows + block_row * kBlockSize;
+      result_ptr[0] += AccumulateNeonLane(acc0_32x4);
+      result_ptr[1] += AccumulateNeonLane(acc1_32x4);
+      result_ptr[2] += AccumulateNeonLane(acc2_32x4);
+      result_ptr[3] += AccumulateNeonLane(acc3_32x4);
+    }
+  }
+}
+
 void NeonSparseMatrixBatchVectorMultiplyAccumulate(
     const float* __restrict__ matrix, const uint8_t* __restrict__ ledger,
     int m_rows, int m_cols, const float* __restrict__ vector, int n_batch,
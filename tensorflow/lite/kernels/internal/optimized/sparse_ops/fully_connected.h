@@ -15,6 +15,9 @@ limitations under the License.
 #ifndef TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_SPARSE_OPS_FULLY_CONNECTED_H_
 #define TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_SPARSE_OPS_FULLY_CONNECTED_H_
 
+#include <algorithm>
+#include <vector>
+
 #include "ruy/profiler/instrumentation.h"  // from @ruy
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/kernels/cpu_backend_threadpool.h"
@@ -73,115 +76,91 @@ inline void FullyConnectedSparseWeight(
   }
 }
 
-inline void FullyConnectedSparseWeight1x4Impl(
-    const TfLiteSparsity& sparsity, const FullyConnectedParams& params,
-    const RuntimeShape& input_shape, const float* input_data,
-    const RuntimeShape& weights_shape, const float* weights_data,
-    const RuntimeShape& bias_shape, const float* bias_data,
-    const RuntimeShape& output_shape, float* output_data, int thread_start,
-    int thread_end, const CpuBackendContext& cpu_backend_context) {
-  ruy::profiler::ScopeLabel label("FullyConnected");
-  ruy::profiler::ScopeLabel inner_label("1x4 Block Sparse");
-  const float output_activation_min = params.float_activation_min;
-  const float output_activation_max = params.float_activation_max;
-
-  const int input_dims_count = input_shape.DimensionsCount();
-  const int output_dims_count = output_shape.DimensionsCount();
-  const int weights_dims_count = weights_shape.DimensionsCount();
-  const int batches = thread_end - thread_start;
-  const int input_depth = MatchingDim(weights_shape, weights_dims_count - 1,
-                                      input_shape, input_dims_count - 1);
-  const int output_depth = MatchingDim(weights_shape, weights_dims_count - 2,
-                                       output_shape, output_dims_count - 1);
-  const int* w1_segments = sparsity.dim_metadata[1].array_segments->data;
-  const int* w1_indices = sparsity.dim_metadata[1].array_indices->data;
-
-  tensor_utils::SparseMatrixBatchVectorMultiplyAccumulate1x4(
-      weights_data, w1_segments, w1_indices, weights_shape.Dims(0),
-      weights_shape.Dims(1), input_data + thread_start * input_depth, batches,
-      output_data + thread_start * output_depth);
+// A weight matrix in the block sparse format: a dense dimension of block
+// rows, a CSR dimension of block columns, and dense blocks of
+// block_rows x block_cols values stored in row major.
+struct BlockSparseMatrix {
+  int block_rows;
+  int block_cols;
+  const int32_t* segments;
+  const int32_t* indices;
+};
 
-  ruy::profiler::ScopeLabel activation_label("activation function");
-  for (int b = thread_start; b < thread_end; ++b) {
-    for (int i = 0; i < output_depth; ++i) {
-      float total = output_data[b * output_depth + i];
-      float bias_value = bias_data[i];
-      output_data[b * output_depth + i] = ActivationFunctionWithMinMax(
-          total + bias_value, output_activation_min, output_activation_max);
+// Returns whether `sparsity` describes the weights of `weights_shape`, i.e.
+// [output_depth, ..., accum_depth] where the middle dimensions, if any, are 1
+// (e.g. the filter of a 1x1 Conv), in the block sparse format with 1x4 or 4x4
+// blocks that FullyConnectedBlockSparseWeight supports. If so, fills `matrix`.
+inline bool GetBlockSparseMatrix(const TfLiteSparsity& sparsity,
+                                 const RuntimeShape& weights_shape,
+                                 BlockSparseMatrix* matrix) {
+  const int rank = weights_shape.DimensionsCount();
+  if (rank < 2 || sparsity.traversal_order == nullptr ||
+      sparsity.block_map == nullptr) {
+    return false;
+  }
+  const int num_block_dims = sparsity.block_map->size;
+  if (num_block_dims < 1 || num_block_dims > 2 ||
+      sparsity.dim_metadata_size != rank + num_block_dims ||
+      sparsity.traversal_order->size != sparsity.dim_metadata_size) {
+    return false;
+  }
+  for (int i = 0; i < sparsity.dim_metadata_size; ++i) {
+    const TfLiteDimensionType format =
+        i == rank - 1 ? kTfLiteDimSparseCSR : kTfLiteDimDense;
+    if (sparsity.traversal_order->data[i] != i ||
+        sparsity.dim_metadata[i].format != format) {
+      return false;
     }
+    if (i > 0 && i < rank - 1 && weights_shape.Dims(i) != 1) return false;
+  }
+  // Blocks span columns, and with two block dimensions rows as well.
+  if (sparsity.block_map->data[num_block_dims - 1] != rank - 1 ||
+      (num_block_dims == 2 && sparsity.block_map->data[0] != 0)) {
+    return false;
   }
+  matrix->block_rows =
+      num_block_dims == 2 ? sparsity.dim_metadata[rank].dense_size : 1;
+  matrix->block_cols =
+      sparsity.dim_metadata[rank + num_block_dims - 1].dense_size;
+  if (matrix->block_cols != 4 ||
+      (matrix->block_rows != 1 && matrix->block_rows != 4) ||
+      weights_shape.Dims(0) % matrix->block_rows != 0 ||
+      weights_shape.Dims(rank - 1) % matrix->block_cols != 0) {
+    return false;
+  }
+  matrix->segments = sparsity.dim_metadata[rank - 1].array_segments->data;
+  matrix->indices = sparsity.dim_metadata[rank - 1].array_indices->data;
+  return true;
 }
 
-struct FullyConnectedSparseWeight1x4Task : cpu_backend_threadpool::Task {
-  FullyConnectedSparseWeight1x4Task(
-      const TfLiteSparsity& sparsity, const FullyConnectedParams& params,
-      const RuntimeShape& input_shape, const float* input_data,
-      const RuntimeShape& weights_shape, const float* weights_data,
-      const RuntimeShape& bias_shape, const float* bias_data,
-      const RuntimeShape& output_shape, float* output_data, int thread_start,
-      int thread_end, const CpuBackendContext& cpu_backend_context_x)
-      : sparsity(sparsity),
-        params(params),
-        input_shape(input_shape),
-        input_data(input_data),
-        weights_shape(weights_shape),
-        weights_data(weights_data),
-        bias_shape(bias_shape),
-        bias_data(bias_data),
-        output_shape(output_shape),
-        output_data(output_data),
-        thread_start(thread_start),
-        thread_end(thread_end),
-        cpu_backend_context(cpu_backend_context_x) {}
-
-  void Run() override {
-    FullyConnectedSparseWeight1x4Impl(
-        sparsity, params, input_shape, input_data, weights_shape, weights_data,
-        bias_shape, bias_data, output_shape, output_data, thread_start,
-        thread_end, cpu_backend_context);
-  }
+template <typename BatchRunner>
+struct BlockSparseBatchTask : cpu_backend_threadpool::Task {
+  BlockSparseBatchTask(const BatchRunner& run, int batch_start, int batch_end)
+      : run(run), batch_start(batch_start), batch_end(batch_end) {}
+
+  void Run() override { run(batch_start, batch_end); }
 
  private:
-  const TfLiteSparsity& sparsity;
-  const FullyConnectedParams& params;
-  const RuntimeShape& input_shape;
-  const float* input_data;
-  const RuntimeShape& weights_shape;
-  const float* weights_data;
-  const RuntimeShape& bias_shape;
-  const float* bias_data;
-  const RuntimeShape& output_shape;
-  float* output_data;
-  int thread_start;
-  int thread_end;
-  const CpuBackendContext& cpu_backend_context;
+  const BatchRunner& run;
+  int batch_start;
+  int batch_end;
 };
 
+// Calls `run(batch_start, batch_end)` on slices of [0, batches).
 // The multi-threaded kernel slices the workload along the batch dimension. If
 // there's not enough batches of data, the number of threads used is equal to
 // the batch size. We can improve this later with slicing along the row
 // dimension of the weight.
-inline void FullyConnectedSparseWeight1x4(
-    const TfLiteSparsity& sparsity, const FullyConnectedParams& params,
-    const RuntimeShape& input_shape, const float* input_data,
-    const RuntimeShape& weights_shape, const float* weights_data,
-    const RuntimeShape& bias_shape, const float* bias_data,
-    const RuntimeShape& output_shape, float* output_data,
-    CpuBackendContext* cpu_backend_context) {
-  const int output_elements = output_shape.FlatSize();
-  memset(output_data, 0, output_elements * sizeof(float));
-
+template <typename BatchRunner>
+inline void RunBlockSparseOverBatches(int batches, const BatchRunner& run,
+                                      CpuBackendContext* cpu_backend_context) {
   const int max_threads = cpu_backend_context->max_num_threads();
-  const int batches =
-      FlatSizeSkipDim(output_shape, output_shape.DimensionsCount() - 1);
   const int thread_count = std::max(1, std::min(batches, max_threads));
   if (thread_count == 1) {
-    return FullyConnectedSparseWeight1x4Impl(
-        sparsity, params, input_shape, input_data, weights_shape, weights_data,
-        bias_shape, bias_data, output_shape, output_data, 0, batches,
-        *cpu_backend_context);
+    run(0, batches);
+    return;
   }
-  std::vector<FullyConnectedSparseWeight1x4Task> tasks;
+  std::vector<BlockSparseBatchTask<BatchRunner>> tasks;
   tasks.reserve(thread_count);
   int thread_start = 0;
   for (int i = 0; i < thread_count; ++i) {
@@ -191,16 +170,143 @@ inline void FullyConnectedSparseWeight1x4(
     int thread_end = thread_start + batches / thread_count;
     if (i < batches % thread_count) thread_end++;
 
-    tasks.emplace_back(sparsity, params, input_shape, input_data, weights_shape,
-                       weights_data, bias_shape, bias_data, output_shape,
-                       output_data, thread_start, thread_end,
-                       *cpu_backend_context);
+    tasks.emplace_back(run, thread_start, thread_end);
     thread_start = thread_end;
   }
   cpu_backend_threadpool::Execute(tasks.size(), tasks.data(),
                                   cpu_backend_context);
 }
 
+// Fully connected with weights in a block sparse format, see
+// GetBlockSparseMatrix. All the dimensions of the input and output but the
+// last one are batches, so that a 1x1 Conv with stride 1 runs as this op over
+// its pixels.
+inline void FullyConnectedBlockSparseWeight(
+    const BlockSparseMatrix& weights_matrix, const FullyConnectedParams& params,
+    const RuntimeShape& input_shape, const float* input_data,
+    const RuntimeShape& weights_shape, const float* weights_data,
+    const RuntimeShape& bias_shape, const float* bias_data,
+    const RuntimeShape& output_shape, float* output_data,
+    CpuBackendContext* cpu_backend_context) {
+  ruy::profiler::ScopeLabel label("FullyConnected");
+  ruy::profiler::ScopeLabel inner_label(weights_matrix.block_rows == 4
+                                            ? "4x4 Block Sparse"
+                                            : "1x4 Block Sparse");
+  const float output_activation_min = params.float_activation_min;
+  const float output_activation_max = params.float_activation_max;
+
+  const int output_dims_count = output_shape.DimensionsCount();
+  const int weights_dims_count = weights_shape.DimensionsCount();
+  const int batches = FlatSizeSkipDim(output_shape, output_dims_count - 1);
+  const int output_depth =
+      MatchingDim(weights_shape, 0, output_shape, output_dims_count - 1);
+  const int accum_depth =
+      MatchingDim(weights_shape, weights_dims_count - 1, input_shape,
+                  input_shape.DimensionsCount() - 1);
+
+  auto run = [&](int batch_start, int batch_end) {
+    const int n_batch = batch_end - batch_start;
+    float* output = output_data + batch_start * output_depth;
+    std::fill_n(output, n_batch * output_depth, 0.0f);
+    if (weights_matrix.block_rows == 4) {
+      tensor_utils::SparseMatrixBatchVectorMultiplyAccumulate4x4(
+          weights_data, weights_matrix.segments, weights_matrix.indices,
+          output_depth, accum_depth, input_data + batch_start * accum_depth,
+          n_batch, output);
+    } else {
+      tensor_utils::SparseMatrixBatchVectorMultiplyAccumulate1x4(
+          weights_data, weights_matrix.segments, weights_matrix.indices,
+          output_depth, accum_depth, input_data + batch_start * accum_depth,
+          n_batch, output);
+    }
+
+    ruy::profiler::ScopeLabel activation_label("activation function");
+    for (int b = 0; b < n_batch; ++b) {
+      for (int i = 0; i < output_depth; ++i) {
+        const float bias_value = bias_data ? bias_data[i] : 0.0f;
+        output[b * output_depth + i] = ActivationFunctionWithMinMax(
+            output[b * output_depth + i] + bias_value, output_activation_min,
+            output_activation_max);
+      }
+    }
+  };
+  RunBlockSparseOverBatches(batches, run, cpu_backend_context);
+}
+
+// Same as above, but for int8 inputs, weights and outputs with int32 biases.
+// The weights must be symmetrically quantized. If `output_multiplier` and
+// `output_shift` aren't null they hold per-channel values, otherwise
+// params.output_multiplier and params.output_shift apply to all channels.
+inline void FullyConnectedBlockSparseWeight(
+    const BlockSparseMatrix& weights_matrix, const FullyConnectedParams& params,
+    const int32_t* output_multiplier, const int* output_shift,
+    const RuntimeShape& input_shape, const int8_t* input_data,
+    const RuntimeShape& weights_shape, const int8_t* weights_data,
+    const RuntimeShape& bias_shape, const int32_t* bias_data,
+    const RuntimeShape& output_shape, int8_t* output_data,
+    CpuBackendContext* cpu_backend_context) {
+  ruy::profiler::ScopeLabel label("FullyConnectedInt8");
+  ruy::profiler::ScopeLabel inner_label(weights_matrix.block_rows == 4
+                                            ? "4x4 Block Sparse"
+                                            : "1x4 Block Sparse");
+  TFLITE_DCHECK_EQ(params.weights_offset, 0);
+  const int32_t output_activation_min = params.quantized_activation_min;
+  const int32_t output_activation_max = params.quantized_activation_max;
+
+  const int output_dims_count = output_shape.DimensionsCount();
+  const int weights_dims_count = weights_shape.DimensionsCount();
+  const int batches = FlatSizeSkipDim(output_shape, output_dims_count - 1);
+  const int output_depth =
+      MatchingDim(weights_shape, 0, output_shape, output_dims_count - 1);
+  const int accum_depth =
+      MatchingDim(weights_shape, weights_dims_count - 1, input_shape,
+                  input_shape.DimensionsCount() - 1);
+
+  auto run = [&](int batch_start, int batch_end) {
+    // Rows are accumulated in int32 by tiles, so that a tile of the weights
+    // stays in cache for all the batches of the slice.
+    constexpr int kRowTile = 64;
+    int32_t accum[kRowTile];
+    for (int row_start = 0; row_start < output_depth; row_start += kRowTile) {
+      const int rows = std::min(kRowTile, output_depth - row_start);
+      const int32_t* segments =
+          weights_matrix.segments + row_start / weights_matrix.block_rows;
+      const int8_t* weights =
+          weights_data +
+          segments[0] * weights_matrix.block_rows * weights_matrix.block_cols;
+      for (int b = batch_start; b < batch_end; ++b) {
+        std::fill_n(accum, rows, 0);
+        if (weights_matrix.block_rows == 4) {
+          tensor_utils::SparseMatrixBatchVectorMultiplyAccumulate4x4(
+              weights, segments, weights_matrix.indices, rows, accum_depth,
+              input_data + b * accum_depth, params.input_offset,
+              /*n_batch=*/1, accum);
+        } else {
+          tensor_utils::SparseMatrixBatchVectorMultiplyAccumulate1x4(
+              weights, segments, weights_matrix.indices, rows, accum_depth,
+              input_data + b * accum_depth, params.input_offset,
+              /*n_batch=*/1, accum);
+        }
+        int8_t* output = output_data + b * output_depth + row_start;
+        for (int i = 0; i < rows; ++i) {
+          const int channel = row_start + i;
+          int32_t acc = accum[i] + (bias_data ? bias_data[channel] : 0);
+          acc = MultiplyByQuantizedMultiplier(
+              acc,
+              output_multiplier ? output_multiplier[channel]
+                                : params.output_multiplier,
+              output_shift ? output_shift[channel] : params.output_shift);
+          acc += params.output_offset;
+          acc = std::max(acc, output_activation_min);
+          acc = std::min(acc, output_activation_max);
+          output[i] = static_cast<int8_t>(acc);
+        }
+      }
+    }
+  };
+  RunBlockSparseOverBatches(batches, run, cpu_backend_context);
+}
+
 }  // namespace optimized_ops
 }  // namespace tflite
 #endif  // TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_SPARSE_OPS_FULLY_CONNECTED_H_
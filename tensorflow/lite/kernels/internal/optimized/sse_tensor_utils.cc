@@ -23,6 +23,7 @@ limitations under the License.
 #endif
 
 #include <cstdint>
+#include <cstring>
 
 #include "ruy/profiler/instrumentation.h"  // from @ruy
 #include "tensorflow/lite/kernels/cpu_backend_context.h"
@@ -91,6 +92,29 @@ float GetFloatVectorElement(__m128 v) {
   return _mm_cvtss_f32(v);
 }
 
+// Horizontally add 4 float values stored in a single XMM register.
+static inline float ReduceFloat32x4(__m128 acc) {
+  // [a0 + a2, a1 + a3, ...]
+  acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+  // [a0 + a1 + a2 + a3, ...]
+  acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, _MM_SHUFFLE(1, 1, 1, 1)));
+  return _mm_cvtss_f32(acc);
+}
+
+// Sign-extends the low 8 int8 values of a XMM register to int16.
+static inline __m128i Int8x8ToInt16x8(__m128i a_8x16) {
+  return _mm_unpacklo_epi8(a_8x16,
+                           _mm_cmpgt_epi8(_mm_setzero_si128(), a_8x16));
+}
+
+// Loads 4 int8 values, which may end a buffer, sign-extended to the low 4
+// int16 values of a XMM register. The high 4 values are 0.
+static inline __m128i LoadInt8x4AsInt16(const int8_t* ptr) {
+  int32_t bytes;
+  memcpy(&bytes, ptr, sizeof(bytes));
+  return Int8x8ToInt16x8(_mm_cvtsi32_si128(bytes));
+}
+
 }  // namespace
 
 void SseMatrixBatchVectorMultiplyAccumulateImpl(
@@ -415,6 +439,151 @@ void SseSparseMatrixBatchVectorMultiplyAccumulate(
   }  // for batch
 }
 
+void SseSparseMatrixBatchVectorMultiplyAccumulate1x4(
+    const float* __restrict__ matrix, const int32_t* __restrict__ segments,
+    const int32_t* __restrict__ indices, int m_rows, int m_cols,
+    const float* __restrict__ vector, int n_batch, float* __restrict__ result) {
+  static constexpr std::intptr_t kBlockSize = 4;
+  TFLITE_DCHECK_EQ(m_cols % kBlockSize, 0);
+
+  for (std::intptr_t batch = 0; batch < n_batch; ++batch) {
+    const float* __restrict__ matrix_ptr = matrix;
+    const float* __restrict__ vector_in_batch = vector + batch * m_cols;
+    for (std::intptr_t row = 0; row < m_rows; ++row) {
+      __m128 acc_fx4 = _mm_setzero_ps();
+      for (std::intptr_t i = segments[row]; i < segments[row + 1]; ++i) {
+        const __m128 vector_fx4 =
+            _mm_loadu_ps(vector_in_batch + indices[i] * kBlockSize);
+        const __m128 matrix_fx4 = _mm_loadu_ps(matrix_ptr);
+        acc_fx4 = _mm_add_ps(acc_fx4, _mm_mul_ps(matrix_fx4, vector_fx4));
+        matrix_ptr += kBlockSize;
+      }
+      result[batch * m_rows + row] += ReduceFloat32x4(acc_fx4);
+    }
+  }
+}
+
+void SseSparseMatrixBatchVectorMultiplyAccumulate4x4(
+    const float* __restrict__ matrix, const int32_t* __restrict__ segments,
+    const int32_t* __restrict__ indices, int m_rows, int m_cols,
+    const float* __restrict__ vector, int n_batch, float* __restrict__ result) {
+  static constexpr std::intptr_t kBlockSize = 4;
+  TFLITE_DCHECK_EQ(m_rows % kBlockSize, 0);
+  TFLITE_DCHECK_EQ(m_cols % kBlockSize, 0);
+
+  for (std::intptr_t batch = 0; batch < n_batch; ++batch) {
+    const float* __restrict__ matrix_ptr = matrix;
+    const float* __restrict__ vector_in_batch = vector + batch * m_cols;
+    for (std::intptr_t block_row = 0; block_row < m_rows / kBlockSize;
+         ++block_row) {
+      __m128 acc0_fx4 = _mm_setzero_ps();
+      __m128 acc1_fx4 = _mm_setzero_ps();
+      __m128 acc2_fx4 = _mm_setzero_ps();
+      __m128 acc3_fx4 = _mm_setzero_ps();
+      for (std::intptr_t i = segments[block_row]; i < segments[block_row + 1];
+           ++i) {
+        // The 4 vector values are shared by the 4 rows of the block.
+        const __m128 vector_fx4 =
+            _mm_loadu_ps(vector_in_batch + indices[i] * kBlockSize);
+        acc0_fx4 = _mm_add_ps(
+            acc0_fx4, _mm_mul_ps(_mm_loadu_ps(matrix_ptr), vector_fx4));
+        acc1_fx4 = _mm_add_ps(
+            acc1_fx4, _mm_mul_ps(_mm_loadu_ps(matrix_ptr + 4), vector_fx4));
+        acc2_fx4 = _mm_add_ps(
+            acc2_fx4, _mm_mul_ps(_mm_loadu_ps(matrix_ptr + 8), vector_fx4));
+        acc3_fx4 = _mm_add_ps(
+            acc3_fx4, _mm_mul_ps(_mm_loadu_ps(matrix_ptr + 12), vector_fx4));
+        matrix_ptr += kBlockSize * kBlockSize;
+      }
+      // Horizontally add the 4 accumulators into the 4 rows of the block.
+      _MM_TRANSPOSE4_PS(acc0_fx4, acc1_fx4, acc2_fx4, acc3_fx4);
+      const __m128 dot_prod_fx4 = _mm_add_ps(_mm_add_ps(acc0_fx4, acc1_fx4),
+                                             _mm_add_ps(acc2_fx4, acc3_fx4));
+      float* __restrict__ result_ptr =
+          result + batch * m_rows + block_row * kBlockSize;
+      _mm_storeu_ps(result_ptr,
+                    _mm_add_ps(_mm_loadu_ps(result_ptr), dot_prod_fx4));
+    }
+  }
+}
+
+void SseSparseMatrixBatchVectorMultiplyAccumulate1x4(
+    const int8_t* __restrict__ matrix, const int32_t* __restrict__ segments,
+    const int32_t* __restrict__ indices, int m_rows, int m_cols,
+    const int8_t* __restrict__ vectors, int32_t input_offset, int n_batch,
+    int32_t* __restrict__ result) {
+  static constexpr std::intptr_t kBlockSize = 4;
+  TFLITE_DCHECK_EQ(m_cols % kBlockSize, 0);
+  // The offset input values fit in int16, so that a block is a single
+  // _mm_madd_epi16. The high 4 products are 0, as the matrix values are.
+  const __m128i input_offset_16x8 = _mm_set1_epi16(input_offset);
+
+  for (std::intptr_t batch = 0; batch < n_batch; ++batch) {
+    const int8_t* __restrict__ matrix_ptr = matrix;
+    const int8_t* __restrict__ vector_in_batch = vectors + batch * m_cols;
+    for (std::intptr_t row = 0; row < m_rows; ++row) {
+      __m128i acc_32x4 = _mm_setzero_si128();
+      for (std::intptr_t i = segments[row]; i < segments[row + 1]; ++i) {
+        const __m128i vector_16x8 = _mm_add_epi16(
+            LoadInt8x4AsInt16(vector_in_batch + indices[i] * kBlockSize),
+            input_offset_16x8);
+        const __m128i matrix_16x8 = LoadInt8x4AsInt16(matrix_ptr);
+        acc_32x4 =
+            _mm_add_epi32(acc_32x4, _mm_madd_epi16(matrix_16x8, vector_16x8));
+        matrix_ptr += kBlockSize;
+      }
+      result[batch * m_rows + row] += ReduceInt32x4(acc_32x4);
+    }
+  }
+}
+
+void SseSparseMatrixBatchVectorMultiplyAccumulate4x4(
+    const int8_t* __restrict__ matrix, const int32_t* __restrict__ segments,
+    const int32_t* __restrict__ indices, int m_rows, int m_cols,
+    const int8_t* __restrict__ vectors, int32_t input_offset, int n_batch,
+    int32_t* __restrict__ result) {
+  static constexpr std::intptr_t kBlockSize = 4;
+  TFLITE_DCHECK_EQ(m_rows % kBlockSize, 0);
+  TFLITE_DCHECK_EQ(m_cols % kBlockSize, 0);
+  const __m128i input_offset_16x8 = _mm_set1_epi16(input_offset);
+
+  for (std::intptr_t batch = 0; batch < n_batch; ++batch) {
+    const int8_t* __restrict__ matrix_ptr = matrix;
+    const int8_t* __restrict__ vector_in_batch = vectors + batch * m_cols;
+    for (std::intptr_t block_row = 0; block_row < m_rows / kBlockSize;
+         ++block_row) {
+      // acc01 = [r0 c01, r0 c23, r1 c01, r1 c23], same for acc23.
+      __m128i acc01_32x4 = _mm_setzero_si128();
+      __m128i acc23_32x4 = _mm_setzero_si128();
+      for (std::intptr_t i = segments[block_row]; i < segments[block_row + 1];
+           ++i) {
+        __m128i vector_16x8 = _mm_add_epi16(
+            LoadInt8x4AsInt16(vector_in_batch + indices[i] * kBlockSize),
+            input_offset_16x8);
+        // The same 4 vector values for both rows of a pair of rows.
+        vector_16x8 = _mm_unpacklo_epi64(vector_16x8, vector_16x8);
+        const __m128i matrix_8x16 =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(matrix_ptr));
+        const __m128i rows01_16x8 = Int8x8ToInt16x8(matrix_8x16);
+        const __m128i rows23_16x8 =
+            Int8x8ToInt16x8(_mm_unpackhi_epi64(matrix_8x16, matrix_8x16));
+        acc01_32x4 = _mm_add_epi32(acc01_32x4,
+                                   _mm_madd_epi16(rows01_16x8, vector_16x8));
+        acc23_32x4 = _mm_add_epi32(acc23_32x4,
+                                   _mm_madd_epi16(rows23_16x8, vector_16x8));
+        matrix_ptr += kBlockSize * kBlockSize;
+      }
+      // [r0, r1, r2, r3]
+      const __m128i dot_prod_32x4 = _mm_hadd_epi32(acc01_32x4, acc23_32x4);
+      int32_t* __restrict__ result_ptr =
+          result + batch * m_rows + block_row * kBlockSize;
+      __m128i* result_32x4 = reinterpret_cast<__m128i*>(result_ptr);
+      _mm_storeu_si128(result_32x4, _mm_add_epi32(_mm_loadu_si128(result_32x4),
+                                                  dot_prod_32x4));
+    }
+  }
+}
+
 void SseReductionSumVector(const int8_t* input_vector, int32_t* output_vector,
                            const int output_size, const int reduction_size) {
   static constexpr std::intptr_t kBlockSize = 16;
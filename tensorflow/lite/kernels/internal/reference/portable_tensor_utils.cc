@@ -229,6 +229,89 @@ void PortableSparseMatrixBatchVectorMultiplyAccumulate1x4(
   }
 }
 
+void PortableSparseMatrixBatchVectorMultiplyAccumulate4x4(
+    const float* __restrict__ matrix, const int32_t* __restrict__ segments,
+    const int32_t* __restrict__ indices, int m_rows, int m_cols,
+    const float* __restrict__ vector, int n_batch, float* __restrict__ result) {
+  const int kBlockSize = 4;
+  TFLITE_DCHECK_EQ(m_rows % kBlockSize, 0);
+  TFLITE_DCHECK_EQ(m_cols % kBlockSize, 0);
+  for (int batch = 0; batch < n_batch; batch++) {
+    const float* matrix_ptr = matrix;
+    const float* vector_in_batch = vector + batch * m_cols;
+    for (int block_row = 0; block_row < m_rows / kBlockSize; block_row++) {
+      float dot_prod[kBlockSize] = {0.0f};
+      for (int i = segments[block_row]; i < segments[block_row + 1]; i++) {
+        const float* vector_block_in_batch_ptr =
+            vector_in_batch + indices[i] * kBlockSize;
+        for (int r = 0; r < kBlockSize; r++) {
+          for (int c = 0; c < kBlockSize; c++) {
+            dot_prod[r] += *matrix_ptr++ * vector_block_in_batch_ptr[c];
+          }
+        }
+      }
+      for (int r = 0; r < kBlockSize; r++) {
+        result[batch * m_rows + block_row * kBlockSize + r] += dot_prod[r];
+      }
+    }
+  }
+}
+
+void PortableSparseMatrixBatchVectorMultiplyAccumulate1x4(
+    const int8_t* __restrict__ matrix, const int32_t* __restrict__ segments,
+    const int32_t* __restrict__ indices, int m_rows, int m_cols,
+    const int8_t* __restrict__ vectors, int32_t input_offset, int n_batch,
+    int32_t* __restrict__ result) {
+  const int kBlockSize = 4;
+  TFLITE_DCHECK_EQ(m_cols % kBlockSize, 0);
+  for (int batch = 0; batch < n_batch; batch++) {
+    const int8_t* matrix_ptr = matrix;
+    const int8_t* vector_in_batch = vectors + batch * m_cols;
+    for (int row = 0; row < m_rows; row++) {
+      int32_t dot_prod = 0;
+      for (int i = segments[row]; i < segments[row + 1]; i++) {
+        const int8_t* vector_block_in_batch_ptr =
+            vector_in_batch + indices[i] * kBlockSize;
+        for (int c = 0; c < kBlockSize; c++) {
+          dot_prod += *matrix_ptr++ *
+                      (vector_block_in_batch_ptr[c] + input_offset);
+        }
+      }
+      result[batch * m_rows + row] += dot_prod;
+    }
+  }
+}
+
+void PortableSparseMatrixBatchVectorMultiplyAccumulate4x4(
+    const int8_t* __restrict__ matrix, const int32_t* __restrict__ segments,
+    const int32_t* __restrict__ indices, int m_rows, int m_cols,
+    const int8_t* __restrict__ vectors, int32_t input_offset, int n_batch,
+    int32_t* __restrict__ result) {
+  const int kBlockSize = 4;
+  TFLITE_DCHECK_EQ(m_rows % kBlockSize, 0);
+  TFLITE_DCHECK_EQ(m_cols % kBlockSize, 0);
+  for (int batch = 0; batch < n_batch; batch++) {
+    const int8_t* matrix_ptr = matrix;
+    const int8_t* vector_in_batch = vectors + batch * m_cols;
+    for (int block_row = 0; block_row < m_rows / kBlockSize; block_row++) {
+      int32_t dot_prod[kBlockSize] = {0};
+      for (int i = segments[block_row]; i < segments[block_row + 1]; i++) {
+        const int8_t* vector_block_in_batch_ptr =
+            vector_in_batch + indices[i] * kBlockSize;
+        for (int r = 0; r < kBlockSize; r++) {
+          for (int c = 0; c < kBlockSize; c++) {
+            dot_prod[r] += *matrix_ptr++ *
+                           (vector_block_in_batch_ptr[c] + input_offset);
+          }
+        }
+      }
+      for (int r = 0; r < kBlockSize; r++) {
+        result[batch * m_rows + block_row * kBlockSize + r] += dot_prod[r];
+      }
+    }
+  }
+}
+
 void PortableSparseMatrixBatchVectorMultiplyAccumulate(
     const float* __restrict__ matrix, const uint8_t* __restrict__ ledger,
     int m_rows, int m_cols, const float* __restrict__ vector, int n_batch,
@@ -1535,6 +1535,139 @@ TEST(uKernels, SparseMatrixBatchVectorMultiplyAccumulateTest) {
               ElementsAreArray(ArrayFloatNear(dense_output, 1e-4)));
 }
 
+// A matrix in the block sparse format of
+// SparseMatrixBatchVectorMultiplyAccumulate1x4/4x4, holding the blocks of a
+// dense matrix that aren't all zeros.
+template <typename T>
+struct BlockSparseMatrixData {
+  std::vector<T> values;
+  std::vector<int32_t> segments;
+  std::vector<int32_t> indices;
+};
+
+template <typename T>
+BlockSparseMatrixData<T> BlockSparsify(const std::vector<T>& matrix, int rows,
+                                       int cols, int block_rows) {
+  const int kBlockCols = 4;
+  BlockSparseMatrixData<T> data;
+  data.segments.push_back(0);
+  for (int block_row = 0; block_row < rows / block_rows; ++block_row) {
+    for (int block_col = 0; block_col < cols / kBlockCols; ++block_col) {
+      std::vector<T> block;
+      bool is_zero = true;
+      for (int r = 0; r < block_rows; ++r) {
+        for (int c = 0; c < kBlockCols; ++c) {
+          const T value = matrix[(block_row * block_rows + r) * cols +
+                                 block_col * kBlockCols + c];
+          is_zero = is_zero && value == 0;
+          block.push_back(value);
+        }
+      }
+      if (is_zero) continue;
+      data.values.insert(data.values.end(), block.begin(), block.end());
+      data.indices.push_back(block_col);
+    }
+    data.segments.push_back(data.indices.size());
+  }
+  return data;
+}
+
+// Returns a rows x cols matrix where about `sparsity_percent` percent of the
+// block_rows x 4 blocks are zeros.
+template <typename T>
+std::vector<T> MakeBlockSparseMatrix(int rows, int cols, int block_rows,
+                                     int sparsity_percent) {
+  std::vector<T> matrix(rows * cols);
+  for (int row = 0; row < rows; ++row) {
+    for (int col = 0; col < cols; ++col) {
+      const int block = (row / block_rows) * (cols / 4) + col / 4;
+      if ((block * 37) % 100 < sparsity_percent) continue;
+      matrix[row * cols + col] = static_cast<T>((row * 7 + col * 3) % 15 - 7);
+    }
+  }
+  return matrix;
+}
+
+TEST(uKernels, BlockSparseMatrixBatchVectorMultiplyAccumulateTest) {
+  const int kRow = 8;
+  const int kCol = 20;
+  const int kBatch = 3;
+  std::vector<float> vectors(kBatch * kCol);
+  for (int i = 0; i < kBatch * kCol; ++i) {
+    vectors[i] = (i % 11) * 0.25f - 1.0f;
+  }
+
+  for (int block_rows : {1, 4}) {
+    const std::vector<float> matrix =
+        MakeBlockSparseMatrix<float>(kRow, kCol, block_rows, 50);
+    const BlockSparseMatrixData<float> sparse =
+        BlockSparsify(matrix, kRow, kCol, block_rows);
+    ASSERT_LT(sparse.values.size(), matrix.size());
+
+    std::vector<float> dense_output(kRow * kBatch, 1.0f);
+    MatrixBatchVectorMultiplyAccumulate(matrix.data(), kRow, kCol,
+                                        vectors.data(), kBatch,
+                                        dense_output.data());
+
+    std::vector<float> sparse_output(kRow * kBatch, 1.0f);
+    if (block_rows == 1) {
+      SparseMatrixBatchVectorMultiplyAccumulate1x4(
+          sparse.values.data(), sparse.segments.data(), sparse.indices.data(),
+          kRow, kCol, vectors.data(), kBatch, sparse_output.data());
+    } else {
+      SparseMatrixBatchVectorMultiplyAccumulate4x4(
+          sparse.values.data(), sparse.segments.data(), sparse.indices.data(),
+          kRow, kCol, vectors.data(), kBatch, sparse_output.data());
+    }
+    EXPECT_THAT(sparse_output,
+                ElementsAreArray(ArrayFloatNear(dense_output, 1e-5)));
+  }
+}
+
+TEST(uKernels, BlockSparseInt8MatrixBatchVectorMultiplyAccumulateTest) {
+  const int kRow = 8;
+  const int kCol = 20;
+  const int kBatch = 3;
+  const int32_t kInputOffset = 128;
+  std::vector<int8_t> vectors(kBatch * kCol);
+  for (int i = 0; i < kBatch * kCol; ++i) {
+    vectors[i] = static_cast<int8_t>((i * 29) % 256 - 128);
+  }
+
+  for (int block_rows : {1, 4}) {
+    const std::vector<int8_t> matrix =
+        MakeBlockSparseMatrix<int8_t>(kRow, kCol, block_rows, 50);
+    const BlockSparseMatrixData<int8_t> sparse =
+        BlockSparsify(matrix, kRow, kCol, block_rows);
+    ASSERT_LT(sparse.values.size(), matrix.size());
+
+    std::vector<int32_t> expected_output(kRow * kBatch, 1);
+    for (int batch = 0; batch < kBatch; ++batch) {
+      for (int row = 0; row < kRow; ++row) {
+        for (int col = 0; col < kCol; ++col) {
+          expected_output[batch * kRow + row] +=
+              matrix[row * kCol + col] *
+              (vectors[batch * kCol + col] + kInputOffset);
+        }
+      }
+    }
+
+    std::vector<int32_t> sparse_output(kRow * kBatch, 1);
+    if (block_rows == 1) {
+      SparseMatrixBatchVectorMultiplyAccumulate1x4(
+          sparse.values.data(), sparse.segments.data(), sparse.indices.data(),
+          kRow, kCol, vectors.data(), kInputOffset, kBatch,
+          sparse_output.data());
+    } else {
+      SparseMatrixBatchVectorMultiplyAccumulate4x4(
+          sparse.values.data(), sparse.segments.data(), sparse.indices.data(),
+          kRow, kCol, vectors.data(), kInputOffset, kBatch,
+          sparse_output.data());
+    }
+    EXPECT_THAT(sparse_output, testing::ElementsAreArray(expected_output));
+  }
+}
+
 #ifdef __ANDROID__
 TEST(uKernels,
      SparseMatrixBatchVectorMultiplyAccumulateSymmetricQuantizedTest) {
@@ -2209,4 +2342,96 @@ BENCHMARK(BM_DotprodSparseMultiply)
     ->Args({2048, 2048, 1, 1})
     ->Args({2048, 2048, 8, 1});
 
+
+// Compares the block sparse kernels with the dense one for a sweep of
+// sparsities, to find where sparse weights start paying off.
+void BM_DenseFloatMultiply(benchmark::State& state) {
+  const int rows = state.range(0);
+  const int cols = state.range(1);
+  const int batch = state.range(2);
+  const std::vector<float> matrix =
+      tflite::tensor_utils::MakeBlockSparseMatrix<float>(rows, cols, 1, 0);
+  const std::vector<float> vectors(cols * batch, 1.0f);
+  std::vector<float> results(rows * batch);
+  for (auto _ : state) {
+    tflite::tensor_utils::MatrixBatchVectorMultiplyAccumulate(
+        matrix.data(), rows, cols, vectors.data(), batch, results.data());
+    testing::DoNotOptimize(results[2]);
+  }
+}
+BENCHMARK(BM_DenseFloatMultiply)
+    ->Args({256, 256, 1})
+    ->Args({256, 256, 8})
+    ->Args({1024, 1024, 1})
+    ->Args({1024, 1024, 8});
+
+void BlockSparsityArgs(benchmark::internal::Benchmark* b) {
+  for (int size : {256, 1024}) {
+    for (int batch : {1, 8}) {
+      for (int block_rows : {1, 4}) {
+        for (int sparsity : {0, 50, 70, 80, 90, 95}) {
+          b->Args({size, size, batch, block_rows, sparsity});
+        }
+      }
+    }
+  }
+}
+
+// Args are rows, cols, batch, rows per block (1 or 4), sparsity in percent.
+void BM_BlockSparseFloatMultiply(benchmark::State& state) {
+  const int rows = state.range(0);
+  const int cols = state.range(1);
+  const int batch = state.range(2);
+  const int block_rows = state.range(3);
+  const tflite::tensor_utils::BlockSparseMatrixData<float> sparse =
+      tflite::tensor_utils::BlockSparsify(
+          tflite::tensor_utils::MakeBlockSparseMatrix<float>(
+              rows, cols, block_rows, state.range(4)),
+          rows, cols, block_rows);
+  const std::vector<float> vectors(cols * batch, 1.0f);
+  std::vector<float> results(rows * batch);
+  for (auto _ : state) {
+    if (block_rows == 1) {
+      tflite::tensor_utils::SparseMatrixBatchVectorMultiplyAccumulate1x4(
+          sparse.values.data(), sparse.segments.data(), sparse.indices.data(),
+          rows, cols, vectors.data(), batch, results.data());
+    } else {
+      tflite::tensor_utils::SparseMatrixBatchVectorMultiplyAccumulate4x4(
+          sparse.values.data(), sparse.segments.data(), sparse.indices.data(),
+          rows, cols, vectors.data(), batch, results.data());
+    }
+    testing::DoNotOptimize(results[2]);
+  }
+}
+BENCHMARK(BM_BlockSparseFloatMultiply)->Apply(BlockSparsityArgs);
+
+void BM_BlockSparseInt8Multiply(benchmark::State& state) {
+  const int rows = state.range(0);
+  const int cols = state.range(1);
+  const int batch = state.range(2);
+  const int block_rows = state.range(3);
+  const tflite::tensor_utils::BlockSparseMatrixData<int8_t> sparse =
+      tflite::tensor_utils::BlockSparsify(
+          tflite::tensor_utils::MakeBlockSparseMatrix<int8_t>(
+              rows, cols, block_rows, state.range(4)),
+          rows, cols, block_rows);
+  const std::vector<int8_t> vectors(cols * batch, 1);
+  std::vector<int32_t> results(rows * batch);
+  for (auto _ : state) {
+    if (block_rows == 1) {
+      tflite::tensor_utils::SparseMatrixBatchVectorMultiplyAccumulate1x4(
+          sparse.values.data(), sparse.segments.data(), sparse.indices.data(),
+          rows, cols, vectors.data(), /*input_offset=*/3, batch,
+          results.data());
+    } else {
+      tflite::tensor_utils::SparseMatrixBatchVectorMultiplyAccumulate4x4(
+          sparse.values.data(), sparse.segments.data(), sparse.indices.data(),
+          rows, cols, vectors.data(), /*input_offset=*/3, batch,
+          results.data());
+    }
+    testing::DoNotOptimize(results[2]);
+  }
+}
+BENCHMARK(BM_BlockSparseInt8Multiply)->Apply(BlockSparsityArgs);
+
 #endif  // DOTPROD_BENCHMARKS
@@ -1619,7 +1619,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
           /*forward_sequence=*/true,
           /*time_major=*/true,
           /*output_offset=*/0, scratch_buffer, output_state, cell_state,
-          output);
+          output, /*context=*/nullptr);
     }
     case kTfLiteUInt8:
     case kTfLiteInt8: {
@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/lite/c/builtin_op_data.h"
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/kernels/cpu_backend_context.h"
+#include "tensorflow/lite/kernels/cpu_backend_gemm.h"
 #include "tensorflow/lite/kernels/internal/compatibility.h"
 #include "tensorflow/lite/kernels/internal/kernel_utils.h"
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
@@ -152,6 +153,8 @@ inline float GetTensorScale(const TfLiteTensor* tensor) {
 //   cell_to_gate_weights      | n_cell               | y (peephole)
 //   gate_bias                 | n_cell               |
 //   layer_norm_coefficients   | n_cell               | y (layer norm)
+// Precomputed vector, replacing input and aux_input:
+//   input_projection          | n_cell               | y (sequence LSTM)
 // Output vector:
 //   gate                      | n_cell               |
 // Scalar parameters:
@@ -160,6 +163,10 @@ inline float GetTensorScale(const TfLiteTensor* tensor) {
 //   activation                                 - activation to use.
 //   is_input_all_zeros, is_aux_input_all_zeros - if input vectors are all zero.
 //   use_layer_norm                             - if doing layer norm LSTM.
+//
+// The input_projection, if given, holds the W_input * input (+ bias without
+// layer norm) part computed ahead for several time steps, see
+// CalculateLstmInputProjectionFloat.
 inline void CalculateLstmGateFloat(
     const float* input, const float* input_to_gate_weights,
     const float* aux_input, const float* aux_input_to_gate_weights,
@@ -169,29 +176,34 @@ inline void CalculateLstmGateFloat(
     const int n_batch, const int n_input, const int n_aux_input,
     const int n_output, const int n_cell,
     const TfLiteFusedActivation activation, float* gate,
-    const bool is_input_all_zeros, const bool is_aux_input_all_zeros) {
+    const bool is_input_all_zeros, const bool is_aux_input_all_zeros,
+    const float* input_projection) {
   const bool use_peephole = (cell_to_gate_weights != nullptr);
   const bool use_layer_norm = (layer_norm_coefficients != nullptr);
 
-  // Initialize scratch buffers with bias for regular lstm or initialize with
-  // zero for layer norm lstm.
-  if (use_layer_norm) {
-    std::fill_n(gate, n_cell * n_batch, 0.0f);
+  if (input_projection != nullptr) {
+    std::copy_n(input_projection, n_cell * n_batch, gate);
   } else {
-    tensor_utils::VectorBatchVectorAssign(gate_bias, n_cell, n_batch, gate);
-  }
-  // For each batch and cell: compute input_weight * input.
-  // Skip if input is all zeros.
-  if (!is_input_all_zeros) {
-    tensor_utils::MatrixBatchVectorMultiplyAccumulate(
-        input_to_gate_weights, n_cell, n_input, input, n_batch, gate);
-  }
-  // For each batch and cell: compute aux_input_weight * aux_input.
-  // Skip if auxiliary input is not available or all zeros.
-  if (!is_aux_input_all_zeros) {
-    tensor_utils::MatrixBatchVectorMultiplyAccumulate(aux_input_to_gate_weights,
-                                                      n_cell, n_aux_input,
-                                                      aux_input, n_batch, gate);
+    // Initialize scratch buffers with bias for regular lstm or initialize with
+    // zero for layer norm lstm.
+    if (use_layer_norm) {
+      std::fill_n(gate, n_cell * n_batch, 0.0f);
+    } else {
+      tensor_utils::VectorBatchVectorAssign(gate_bias, n_cell, n_batch, gate);
+    }
+    // For each batch and cell: compute input_weight * input.
+    // Skip if input is all zeros.
+    if (!is_input_all_zeros) {
+      tensor_utils::MatrixBatchVectorMultiplyAccumulate(
+          input_to_gate_weights, n_cell, n_input, input, n_batch, gate);
+    }
+    // For each batch and cell: compute aux_input_weight * aux_input.
+    // Skip if auxiliary input is not available or all zeros.
+    if (!is_aux_input_all_zeros) {
+      tensor_utils::MatrixBatchVectorMultiplyAccumulate(
+          aux_input_to_gate_weights, n_cell, n_aux_input, aux_input, n_batch,
+          gate);
+    }
   }
   // For each batch and cell: compute recurrent_weight * output_state.
   tensor_utils::MatrixBatchVectorMultiplyAccumulate(
@@ -213,6 +225,39 @@ inline void CalculateLstmGateFloat(
                                         gate);
 }
 
+// Computes the input part of a gate for 'n_vectors' consecutive input vectors
+// of size 'n_input', e.g. for several time steps of a sequence:
+//   input_projection = W_input * input + bias
+// without the bias for layer norm LSTM, which adds it after normalizing.
+//
+// This is a single matrix multiplication, which runs much faster than a
+// matrix-vector product per time step, as it loads the weights once for all
+// the time steps.
+void CalculateLstmInputProjectionFloat(
+    const float* input, const TfLiteTensor* input_to_gate_weights,
+    const float* gate_bias, int n_vectors, int n_input, int n_cell,
+    float* input_projection, CpuBackendContext* context) {
+  cpu_backend_gemm::MatrixParams<float> lhs_params;
+  lhs_params.order = cpu_backend_gemm::Order::kRowMajor;
+  lhs_params.rows = n_cell;
+  lhs_params.cols = n_input;
+  lhs_params.cache_policy = cpu_backend_gemm::DefaultCachePolicy(
+      input_to_gate_weights->allocation_type == kTfLiteMmapRo);
+  cpu_backend_gemm::MatrixParams<float> rhs_params;
+  rhs_params.order = cpu_backend_gemm::Order::kColMajor;
+  rhs_params.rows = n_input;
+  rhs_params.cols = n_vectors;
+  cpu_backend_gemm::MatrixParams<float> dst_params;
+  dst_params.order = cpu_backend_gemm::Order::kColMajor;
+  dst_params.rows = n_cell;
+  dst_params.cols = n_vectors;
+  cpu_backend_gemm::GemmParams<float, float> gemm_params;
+  gemm_params.bias = gate_bias;
+  cpu_backend_gemm::Gemm(
+      lhs_params, GetTensorData<float>(input_to_gate_weights), rhs_params,
+      input, dst_params, input_projection, gemm_params, context);
+}
+
 // Updates the LSTM cell state, used by both float and hybrid LSTM versions.
 //
 // Implements the following formula:
@@ -783,6 +828,10 @@ void CalculateLstmOutputInteger8x8_8(
 // for bidirectional LSTMs with merge_outputs. In this case, the batched
 // operations cannot be used since they assume that the batched outputs are
 // contiguous, and we manually loop over the batched outputs.
+//
+// The {input,forget,cell,output}_gate_projection_ptr, if not null, hold the
+// input part of the gates computed ahead by CalculateLstmInputProjectionFloat,
+// and replace input_ptr and aux_input_ptr.
 // LINT.IfChange
 inline void LstmStepFloat(
     const float* input_ptr, const float* input_to_input_weights_ptr,
@@ -810,7 +859,11 @@ inline void LstmStepFloat(
     const TfLiteLSTMParams* params, int n_batch, int n_cell, int n_input,
     int n_aux_input, int n_output, int output_batch_leading_dim,
     float* output_state_ptr, float* cell_state_ptr, float* scratch0,
-    float* scratch1, float* scratch2, float* scratch3, float* output_ptr) {
+    float* scratch1, float* scratch2, float* scratch3, float* output_ptr,
+    const float* input_gate_projection_ptr,
+    const float* forget_gate_projection_ptr,
+    const float* cell_gate_projection_ptr,
+    const float* output_gate_projection_ptr) {
   ruy::profiler::ScopeLabel label("LstmStepFloat");
   // Since we have already checked that weights are all there or none, we can
   // check the existence of only one to the get the condition.
@@ -822,11 +875,14 @@ inline void LstmStepFloat(
   float* cell_gate_scratch = scratch2;
   float* output_gate_scratch = scratch3;
 
-  // Check if inputs are all zeros so we can skip some computations.
+  // Check if inputs are all zeros so we can skip some computations. This is
+  // moot if the input part of the gates was computed ahead.
+  const bool has_input_projection = (forget_gate_projection_ptr != nullptr);
   const bool is_input_all_zeros =
+      !has_input_projection &&
       tensor_utils::IsZeroVector(input_ptr, n_batch * n_input);
   const bool is_aux_input_all_zeros =
-      (aux_input_ptr == nullptr ||
+      (has_input_projection || aux_input_ptr == nullptr ||
        tensor_utils::IsZeroVector(aux_input_ptr, n_batch * n_aux_input));
   if (!use_cifg) {
     // Calculate the input gate. (If not CIFG.)
@@ -837,7 +893,7 @@ inline void LstmStepFloat(
         cell_to_input_weights_ptr, input_layer_norm_coefficients_ptr,
         input_gate_bias_ptr, n_batch, n_input, n_aux_input, n_output, n_cell,
         /*activation=*/kTfLiteActSigmoid, input_gate_scratch,
-        is_input_all_zeros, is_aux_input_all_zeros);
+        is_input_all_zeros, is_aux_input_all_zeros, input_gate_projection_ptr);
   }
   // Calculate the forget gate.
   CalculateLstmGateFloat(
@@ -847,7 +903,7 @@ inline void LstmStepFloat(
       cell_to_forget_weights_ptr, forget_layer_norm_coefficients_ptr,
       forget_gate_bias_ptr, n_batch, n_input, n_aux_input, n_output, n_cell,
       /*activation=*/kTfLiteActSigmoid, forget_gate_scratch, is_input_all_zeros,
-      is_aux_input_all_zeros);
+      is_aux_input_all_zeros, forget_gate_projection_ptr);
   // Calculate the cell update gate.
   CalculateLstmGateFloat(input_ptr, input_to_cell_weights_ptr, aux_input_ptr,
                          aux_input_to_cell_weights_ptr, output_state_ptr,
@@ -856,7 +912,8 @@ inline void LstmStepFloat(
                          cell_layer_norm_coefficients_ptr, cell_gate_bias_ptr,
                          n_batch, n_input, n_aux_input, n_output, n_cell,
                          params->activation, cell_gate_scratch,
-                         is_input_all_zeros, is_aux_input_all_zeros);
+                         is_input_all_zeros, is_aux_input_all_zeros,
+                         cell_gate_projection_ptr);
   // Update the cell state.
   UpdateLstmCellFloat(n_batch, n_cell, cell_state_ptr, input_gate_scratch,
                       forget_gate_scratch, cell_gate_scratch, use_cifg,
@@ -869,7 +926,7 @@ inline void LstmStepFloat(
       cell_to_output_weights_ptr, output_layer_norm_coefficients_ptr,
       output_gate_bias_ptr, n_batch, n_input, n_aux_input, n_output, n_cell,
       /*activation=*/kTfLiteActSigmoid, output_gate_scratch, is_input_all_zeros,
-      is_aux_input_all_zeros);
+      is_aux_input_all_zeros, output_gate_projection_ptr);
   // Update the output state.
   CalculateLstmOutputFloat(n_batch, n_cell, n_output, cell_state_ptr,
                            output_gate_scratch, params->activation,
@@ -1672,7 +1729,8 @@ TfLiteStatus EvalFloat(
     const TfLiteTensor* projection_weights, const TfLiteTensor* projection_bias,
     const TfLiteLSTMParams* params, bool forward_sequence, bool time_major,
     int output_offset, TfLiteTensor* scratch_buffer, TfLiteTensor* output_state,
-    TfLiteTensor* cell_state, TfLiteTensor* output) {
+    TfLiteTensor* cell_state, TfLiteTensor* output,
+    CpuBackendContext* context) {
   TF_LITE_ASSERT(input->dims->size >= 2 && input->dims->size <= 3);
   int max_time, n_batch;
   if (input->dims->size == 3) {
@@ -1711,16 +1769,62 @@ TfLiteStatus EvalFloat(
     output_gate_scratch = scratch_buffer_ptr + 3 * n_cell * n_batch;
   }
 
+  // If the scratch buffer has room for it after the gate scratch buffers,
+  // compute the input part of the gates ahead for chunks of up to
+  // kMaxFloatInputProjectionSteps time steps. The auxiliary input would need
+  // another product per gate, so it is left to the time steps.
+  const int n_gates = use_cifg ? 3 : 4;
+  const int projection_steps =
+      std::min(max_time, kMaxFloatInputProjectionSteps);
+  const bool use_input_projection =
+      context != nullptr && aux_input == nullptr && projection_steps > 1 &&
+      scratch_buffer->bytes >=
+          sizeof(float) * n_batch *
+              GetFloatScratchBufferSize(max_time, n_gates, n_cell);
+  const TfLiteTensor* input_to_gate_weights[] = {
+      input_to_input_weights, input_to_forget_weights, input_to_cell_weights,
+      input_to_output_weights};
+  const TfLiteTensor* gate_biases[] = {input_gate_bias, forget_gate_bias,
+                                       cell_gate_bias, output_gate_bias};
+  const bool use_layer_norm = (forget_layer_norm_coefficients != nullptr);
+  const float* gate_projections[4] = {};
+  // Computes the input part of the gates for 'n_vectors' consecutive input
+  // vectors starting at 'input_ptr', into gate_projections.
+  auto project_inputs = [&](const float* input_ptr, int n_vectors) {
+    float* projection = scratch_buffer_ptr + n_gates * n_cell * n_batch;
+    for (int gate = use_cifg ? 1 : 0; gate < 4; ++gate) {
+      CalculateLstmInputProjectionFloat(
+          input_ptr, input_to_gate_weights[gate],
+          use_layer_norm ? nullptr : GetTensorData<float>(gate_biases[gate]),
+          n_vectors, n_input, n_cell, projection, context);
+      gate_projections[gate] = projection;
+      projection += n_vectors * n_cell;
+    }
+  };
+  // Returns the input part of 'gate' for the vectors 'offset' floats after
+  // the start of the chunk, or nullptr if it wasn't computed ahead.
+  auto gate_projection = [&](int gate, int offset) -> const float* {
+    return gate_projections[gate] ? gate_projections[gate] + offset : nullptr;
+  };
+
   const int output_batch_leading_dim =
       output->dims->data[output->dims->size - 1];
   if (time_major) {
     // Loop through the sequence.
     const int input_step = n_batch * n_input;
     const int output_step = n_batch * output_batch_leading_dim;
+    int chunk_start = 0;
     for (int t = 0; t < max_time; t++) {
       // If this is the forward_sequence, step forward, otherwise step
       // backwards.
       const int t_rel = forward_sequence ? t : max_time - t - 1;
+      if (use_input_projection && t % projection_steps == 0) {
+        const int chunk_steps = std::min(projection_steps, max_time - t);
+        chunk_start = forward_sequence ? t : max_time - t - chunk_steps;
+        project_inputs(GetTensorData<float>(input) + chunk_start * input_step,
+                       chunk_steps * n_batch);
+      }
+      const int projection_offset = (t_rel - chunk_start) * n_batch * n_cell;
       const float* input_ptr = GetTensorData<float>(input) + t_rel * input_step;
       const float* aux_input_ptr = nullptr;
       if (aux_input) {
@@ -1758,16 +1862,29 @@ TfLiteStatus EvalFloat(
           n_input, aux_input_size, n_output, output_batch_leading_dim,
           GetTensorData<float>(output_state), GetTensorData<float>(cell_state),
           input_gate_scratch, forget_gate_scratch, cell_gate_scratch,
-          output_gate_scratch, output_ptr);
+          output_gate_scratch, output_ptr,
+          gate_projection(0, projection_offset),
+          gate_projection(1, projection_offset),
+          gate_projection(2, projection_offset),
+          gate_projection(3, projection_offset));
     }
   } else {
     for (int b = 0; b < n_batch; b++) {
       const int input_step = n_input;
       const int output_step = output_batch_leading_dim;
+      int chunk_start = 0;
       for (int t = 0; t < max_time; t++) {
         // If this is the forward_sequence, step forward, otherwise step
         // backwards.
         const int t_rel = forward_sequence ? t : max_time - t - 1;
+        if (use_input_projection && t % projection_steps == 0) {
+          const int chunk_steps = std::min(projection_steps, max_time - t);
+          chunk_start = forward_sequence ? t : max_time - t - chunk_steps;
+          project_inputs(GetTensorData<float>(input) +
+                             (b * max_time + chunk_start) * input_step,
+                         chunk_steps);
+        }
+        const int projection_offset = (t_rel - chunk_start) * n_cell;
         const int time_offset = b * max_time + t_rel;
         const float* input_ptr =
             GetTensorData<float>(input) + time_offset * input_step;
@@ -1819,7 +1936,11 @@ TfLiteStatus EvalFloat(
             n_cell, n_input, aux_input_size, n_output, output_batch_leading_dim,
             output_state_ptr, cell_state_ptr, input_gate_scratch_ptr,
             forget_gate_scratch_ptr, cell_gate_scratch_ptr,
-            output_gate_scratch_ptr, output_ptr);
+            output_gate_scratch_ptr, output_ptr,
+            gate_projection(0, projection_offset),
+            gate_projection(1, projection_offset),
+            gate_projection(2, projection_offset),
+            gate_projection(3, projection_offset));
       }
     }
   }
@@ -15,6 +15,7 @@ limitations under the License.
 #ifndef TENSORFLOW_LITE_KERNELS_LSTM_EVAL_H_
 #define TENSORFLOW_LITE_KERNELS_LSTM_EVAL_H_
 
+#include <algorithm>
 #include <cstdint>
 #include <memory>
 
@@ -95,6 +96,27 @@ struct IntegerLstmParameter {
   int32_t intermediate_zp[12];
 };
 
+// Float LSTMs compute the input contribution to the gates of up to this many
+// time steps at once, with one matrix multiplication per gate instead of one
+// matrix-vector product per gate and time step.
+constexpr int kMaxFloatInputProjectionSteps = 32;
+
+// Returns the number of floats EvalFloat needs in `scratch_buffer` per batch
+// for an input of `max_time` steps and `n_gates` (3 with CIFG, 4 otherwise)
+// gates of `n_cell` cells. Any smaller scratch buffer of at least
+// n_gates * n_cell floats per batch still works, computing the input
+// contribution one time step at a time.
+inline int GetFloatScratchBufferSize(int max_time, int n_gates, int n_cell) {
+  const int projection_steps =
+      std::min(max_time, kMaxFloatInputProjectionSteps);
+  return n_gates * n_cell * (projection_steps > 1 ? 1 + projection_steps : 1);
+}
+
+// The output and cell state tensors keep the state of the LSTM across calls,
+// so a sequence can be fed as consecutive chunks of time steps, e.g. the
+// frames of a stream, which gives the same output as feeding it at once.
+// Without a `context`, the input contribution is computed one time step at a
+// time.
 TfLiteStatus EvalFloat(
     const TfLiteTensor* input, const TfLiteTensor* input_to_input_weights,
     const TfLiteTensor* input_to_forget_weights,
@@ -121,7 +143,8 @@ TfLiteStatus EvalFloat(
     const TfLiteTensor* projection_weights, const TfLiteTensor* projection_bias,
     const TfLiteLSTMParams* params, bool forward_sequence, bool time_major,
     int output_offset, TfLiteTensor* scratch_buffer, TfLiteTensor* output_state,
-    TfLiteTensor* cell_state, TfLiteTensor* output);
+    TfLiteTensor* cell_state, TfLiteTensor* output,
+    CpuBackendContext* context);
 
 TfLiteStatus EvalHybrid(
     const TfLiteTensor* input, const TfLiteTensor* input_to_input_weights,
@@ -360,12 +360,17 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   const bool use_cifg = (input_to_input_weights == nullptr);
   TfLiteIntArray* scratch_buffer_size = TfLiteIntArrayCreate(2);
   scratch_buffer_size->data[0] = n_batch;
-  if (use_cifg) {
-    // Reserving space for Cell, Forget, Output gates
-    scratch_buffer_size->data[1] = n_cell * 3;
+  // Reserving space for Input (unless CIFG), Cell, Forget, Output gates.
+  const int n_gates = use_cifg ? 3 : 4;
+  if (IsHybridOp(input, input_to_output_weights)) {
+    scratch_buffer_size->data[1] = n_gates * n_cell;
   } else {
-    // Reserving space for Input, Cell, Forget, Output gates
-    scratch_buffer_size->data[1] = n_cell * 4;
+    // Float LSTMs also compute the input part of the gates ahead for several
+    // time steps of a sequence.
+    const int max_time =
+        time_major ? input->dims->data[0] : input->dims->data[1];
+    scratch_buffer_size->data[1] =
+        lstm_eval::GetFloatScratchBufferSize(max_time, n_gates, n_cell);
   }
   TF_LITE_ENSURE_OK(context, context->ResizeTensor(context, scratch_buffer,
                                                    scratch_buffer_size));
@@ -642,7 +647,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
           projection_weights, projection_bias, &lstm_params,
           /*forward_sequence=*/true, time_major,
           /*output_offset=*/0, scratch_buffer, output_state, cell_state,
-          output);
+          output, CpuBackendContext::GetFromContext(context));
     }
     case kTfLiteUInt8:
     case kTfLiteInt8: {
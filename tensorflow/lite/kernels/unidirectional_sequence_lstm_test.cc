@@ -14,6 +14,9 @@ limitations under the License.
 ==============================================================================*/
 // Unit test for TFLite Sequential LSTM op.
 
+#include <math.h>
+
+#include <memory>
 #include <vector>
 
 #include <gmock/gmock.h>
@@ -22,6 +25,10 @@ limitations under the License.
 #include "tensorflow/lite/kernels/test_util.h"
 #include "tensorflow/lite/schema/schema_generated.h"
 
+#ifdef UNIDIRECTIONAL_SEQUENCE_LSTM_BENCHMARKS
+#include "testing/base/public/benchmark.h"
+#endif  // UNIDIRECTIONAL_SEQUENCE_LSTM_BENCHMARKS
+
 namespace tflite {
 namespace {
 
@@ -2740,6 +2747,157 @@ TEST_F(CifgPeepholeNoProjectionNoClippingUnidirectionalLstmTest,
   VerifyGoldens(lstm_input_, lstm_golden_output_, &lstm);
 }
 
+// Returns `size` deterministic values in [-0.5, 0.5].
+std::vector<float> PseudoRandomValues(int size, int seed) {
+  std::vector<float> values(size);
+  for (int i = 0; i < size; ++i) {
+    values[i] = 0.5f * sinf(1.3f * i + 7.1f * seed);
+  }
+  return values;
+}
+
+// Builds a time-major LSTM with peepholes and projection, which processes
+// `chunk_length` frames per invocation and keeps its state in between.
+std::unique_ptr<UnidirectionalLSTMOpModel> BuildStreamingLstm(
+    int n_batch, int n_input, int n_cell, int n_output, int chunk_length) {
+  std::unique_ptr<UnidirectionalLSTMOpModel> lstm(
+      new UnidirectionalLSTMOpModel(
+          n_batch, n_input, n_cell, n_output, chunk_length,
+          /*time_major=*/true, /*use_cifg=*/false, /*use_peephole=*/true,
+          /*use_projection_weights=*/true,
+          /*use_projection_bias=*/false,
+          /*cell_clip=*/0.0, /*proj_clip=*/0.0,
+          {
+              {chunk_length, n_batch, n_input},  // input tensor
+
+              {n_cell, n_input},  // input_to_input_weight tensor
+              {n_cell, n_input},  // input_to_forget_weight tensor
+              {n_cell, n_input},  // input_to_cell_weight tensor
+              {n_cell, n_input},  // input_to_output_weight tensor
+
+              {n_cell, n_output},  // recurrent_to_input_weight tensor
+              {n_cell, n_output},  // recurrent_to_forget_weight tensor
+              {n_cell, n_output},  // recurrent_to_cell_weight tensor
+              {n_cell, n_output},  // recurrent_to_output_weight tensor
+
+              {n_cell},  // cell_to_input_weight tensor
+              {n_cell},  // cell_to_forget_weight tensor
+              {n_cell},  // cell_to_output_weight tensor
+
+              {n_cell},  // input_gate_bias tensor
+              {n_cell},  // forget_gate_bias tensor
+              {n_cell},  // cell_gate_bias tensor
+              {n_cell},  // output_gate_bias tensor
+
+              {n_output, n_cell},  // projection_weight tensor
+              {0},                 // projection_bias tensor
+
+              {n_batch, n_output},  // output_state tensor
+              {n_batch, n_cell},    // cell_state tensor
+          }));
+  const int input_weights_size = n_cell * n_input;
+  const int recurrent_weights_size = n_cell * n_output;
+  lstm->SetInputToInputWeights(PseudoRandomValues(input_weights_size, 1));
+  lstm->SetInputToForgetWeights(PseudoRandomValues(input_weights_size, 2));
+  lstm->SetInputToCellWeights(PseudoRandomValues(input_weights_size, 3));
+  lstm->SetInputToOutputWeights(PseudoRandomValues(input_weights_size, 4));
+  lstm->SetRecurrentToInputWeights(
+      PseudoRandomValues(recurrent_weights_size, 5));
+  lstm->SetRecurrentToForgetWeights(
+      PseudoRandomValues(recurrent_weights_size, 6));
+  lstm->SetRecurrentToCellWeights(
+      PseudoRandomValues(recurrent_weights_size, 7));
+  lstm->SetRecurrentToOutputWeights(
+      PseudoRandomValues(recurrent_weights_size, 8));
+  lstm->SetCellToInputWeights(PseudoRandomValues(n_cell, 9));
+  lstm->SetCellToForgetWeights(PseudoRandomValues(n_cell, 10));
+  lstm->SetCellToOutputWeights(PseudoRandomValues(n_cell, 11));
+  lstm->SetInputGateBias(PseudoRandomValues(n_cell, 12));
+  lstm->SetForgetGateBias(PseudoRandomValues(n_cell, 13));
+  lstm->SetCellBias(PseudoRandomValues(n_cell, 14));
+  lstm->SetOutputGateBias(PseudoRandomValues(n_cell, 15));
+  lstm->SetProjectionWeights(PseudoRandomValues(n_output * n_cell, 16));
+  return lstm;
+}
+
+// Feeds `input` to a streaming LSTM `chunk_length` frames at a time, and
+// returns the concatenated outputs.
+std::vector<float> RunStreamingLstm(const std::vector<float>& input,
+                                    int n_batch, int n_input, int n_cell,
+                                    int n_output, int chunk_length) {
+  std::unique_ptr<UnidirectionalLSTMOpModel> lstm =
+      BuildStreamingLstm(n_batch, n_input, n_cell, n_output, chunk_length);
+  const int chunk_size = chunk_length * n_batch * n_input;
+  std::vector<float> output;
+  for (int offset = 0; offset < static_cast<int>(input.size());
+       offset += chunk_size) {
+    const float* chunk = input.data() + offset;
+    lstm->SetInput(0, chunk, chunk + chunk_size);
+    lstm->Invoke();
+    const std::vector<float> chunk_output = lstm->GetOutput();
+    output.insert(output.end(), chunk_output.begin(), chunk_output.end());
+  }
+  return output;
+}
+
+TEST(StreamingUnidirectionalLstmTest, ChunksMatchFrameByFrame) {
+  const int n_batch = 2;
+  const int n_input = 3;
+  const int n_cell = 6;
+  const int n_output = 4;
+  // Longer than the number of frames whose input part the op computes at once.
+  const int sequence_length = 72;
+  const std::vector<float> input =
+      PseudoRandomValues(sequence_length * n_batch * n_input, 17);
+
+  const std::vector<float> expected =
+      RunStreamingLstm(input, n_batch, n_input, n_cell, n_output,
+                       /*chunk_length=*/1);
+  ASSERT_EQ(expected.size(), sequence_length * n_batch * n_output);
+  for (int chunk_length : {8, sequence_length}) {
+    EXPECT_THAT(RunStreamingLstm(input, n_batch, n_input, n_cell, n_output,
+                                 chunk_length),
+                ElementsAreArray(ArrayFloatNear(expected, 1e-5)))
+        << "chunk_length: " << chunk_length;
+  }
+}
+
+#ifdef UNIDIRECTIONAL_SEQUENCE_LSTM_BENCHMARKS
+
+// Compile with --copt="-DUNIDIRECTIONAL_SEQUENCE_LSTM_BENCHMARKS"
+// Run with --benchmarks=all
+//
+// Measures a streaming LSTM with `state.range(1)` cells fed `state.range(0)`
+// frames per invocation. The reported items are frames, so the latency per
+// frame is the inverse of the items per second.
+void BM_StreamingLstmFloat(benchmark::State& state) {
+  const int chunk_length = state.range(0);
+  const int n_cell = state.range(1);
+  const int n_batch = 1;
+  const int n_input = 80;
+  const int n_output = n_cell / 2;
+  std::unique_ptr<UnidirectionalLSTMOpModel> lstm =
+      BuildStreamingLstm(n_batch, n_input, n_cell, n_output, chunk_length);
+  const std::vector<float> input =
+      PseudoRandomValues(chunk_length * n_batch * n_input, 1);
+  lstm->SetInput(0, input.data(), input.data() + input.size());
+  for (auto _ : state) {
+    lstm->Invoke();
+  }
+  state.SetItemsProcessed(state.iterations() * chunk_length);
+}
+BENCHMARK(BM_StreamingLstmFloat)
+    ->Args({1, 256})
+    ->Args({4, 256})
+    ->Args({16, 256})
+    ->Args({32, 256})
+    ->Args({1, 1024})
+    ->Args({4, 1024})
+    ->Args({16, 1024})
+    ->Args({32, 1024});
+
+#endif  // UNIDIRECTIONAL_SEQUENCE_LSTM_BENCHMARKS
+
 #define QUANTIZE_PARAMETER_TEST(test) \
   INSTANTIATE_TEST_SUITE_P(test, test, ::testing::ValuesIn({false, true}));
 
@@ -0,0 +1,281 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/kernels/weight_cache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace tflite {
+namespace {
+
+// Packed weights are aligned like tensors in the arena.
+constexpr size_t kAlignment = 64;
+
+constexpr char kFileMagic[8] = {'T', 'F', 'L', 'W', 'C', 'A', 'C', '1'};
+
+// The file is a header, followed by `num_entries` FileEntryHeaders, followed
+// by the packed weights, each at a kAlignment-aligned offset.
+struct FileHeader {
+  char magic[8];
+  uint64_t num_entries;
+};
+
+struct FileEntryHeader {
+  uint64_t fingerprint;
+  uint64_t source_bytes;
+  uint64_t kernel_params;
+  uint64_t offset;
+  uint64_t bytes;
+  uint32_t kind;
+  uint32_t reserved;
+};
+
+size_t AlignTo(size_t offset) {
+  return (offset + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+// A 64-bit hash of `bytes` bytes at `data`, reading 8 bytes at a time so that
+// fingerprinting costs much less than packing.
+uint64_t Fingerprint(const void* data, size_t bytes) {
+  constexpr uint64_t kMul = 0x9ddfea08eb382d69ULL;
+  const uint8_t* p = static_cast<const uint8_t*>(data);
+  uint64_t hash = 0xcbf29ce484222325ULL ^ (bytes * kMul);
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= bytes; i += sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, p + i, sizeof(word));
+    hash = (hash ^ word) * kMul;
+    hash ^= hash >> 47;
+  }
+  for (; i < bytes; ++i) {
+    hash = (hash ^ p[i]) * kMul;
+  }
+  hash ^= hash >> 47;
+  return hash;
+}
+
+}  // namespace
+
+WeightCache& WeightCache::Global() {
+  static WeightCache* cache = new WeightCache;
+  return *cache;
+}
+
+std::shared_ptr<const WeightCache::Entry> WeightCache::GetOrPack(
+    const void* source, size_t source_bytes, Kind kind, uint64_t kernel_params,
+    size_t packed_bytes, const std::function<void(void* packed)>& pack) {
+  const LiveKey live_key(source, kind, kernel_params);
+  bool has_file;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = live_.find(live_key);
+    if (it != live_.end()) {
+      std::shared_ptr<const Entry> entry = it->second.lock();
+      if (entry && entry->bytes() == packed_bytes) {
+        ++stats_.num_shared;
+        stats_.shared_bytes += packed_bytes;
+        return entry;
+      }
+    }
+    has_file = file_ != nullptr;
+  }
+
+  std::shared_ptr<Entry> entry;
+  if (has_file) {
+    const FileKey file_key(Fingerprint(source, source_bytes), source_bytes,
+                           kind, kernel_params);
+    std::lock_guard<std::mutex> lock(mutex_);
+    entry = FindInFile(file_key, packed_bytes);
+    if (entry) ++stats_.num_loaded;
+  }
+  if (!entry) {
+    // Pack without holding the lock; if another thread packs the same weights
+    // meanwhile, the first one to finish wins.
+    entry = std::make_shared<Entry>();
+    entry->buffer_.reset(new uint8_t[packed_bytes + kAlignment]);
+    uint8_t* data = entry->buffer_.get();
+    data += AlignTo(reinterpret_cast<uintptr_t>(data)) -
+            reinterpret_cast<uintptr_t>(data);
+    pack(data);
+    entry->data_ = data;
+    entry->bytes_ = packed_bytes;
+  }
+  entry->kind_ = kind;
+  entry->kernel_params_ = kernel_params;
+  entry->source_ = source;
+  entry->source_bytes_ = source_bytes;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = live_.find(live_key);
+  if (it != live_.end()) {
+    std::shared_ptr<const Entry> existing = it->second.lock();
+    if (existing && existing->bytes() == packed_bytes) {
+      ++stats_.num_shared;
+      stats_.shared_bytes += packed_bytes;
+      return existing;
+    }
+  }
+  if (entry->buffer_) ++stats_.num_packed;
+  // Misses are rare (once per weights and kernel), so this is a good time to
+  // forget entries nobody holds anymore.
+  for (auto live_it = live_.begin(); live_it != live_.end();) {
+    if (live_it->second.expired()) {
+      live_it = live_.erase(live_it);
+    } else {
+      ++live_it;
+    }
+  }
+  live_[live_key] = entry;
+  return entry;
+}
+
+std::shared_ptr<WeightCache::Entry> WeightCache::FindInFile(
+    const FileKey& key, size_t packed_bytes) {
+  auto it = file_entries_.find(key);
+  if (it == file_entries_.end() || it->second.bytes != packed_bytes) {
+    return nullptr;
+  }
+  auto entry = std::make_shared<Entry>();
+  entry->data_ =
+      static_cast<const uint8_t*>(file_->base()) + it->second.offset;
+  entry->bytes_ = packed_bytes;
+  entry->file_ = file_;
+  return entry;
+}
+
+TfLiteStatus WeightCache::LoadFile(const std::string& filename,
+                                   ErrorReporter* error_reporter) {
+  std::shared_ptr<const Allocation> file;
+  if (MMAPAllocation::IsSupported()) {
+    file = std::make_shared<MMAPAllocation>(filename.c_str(), error_reporter);
+  } else {
+    file =
+        std::make_shared<FileCopyAllocation>(filename.c_str(), error_reporter);
+  }
+  if (!file->valid()) {
+    TF_LITE_REPORT_ERROR(error_reporter, "Could not load weight cache %s.",
+                         filename.c_str());
+    return kTfLiteError;
+  }
+
+  const uint8_t* base = static_cast<const uint8_t*>(file->base());
+  const size_t size = file->bytes();
+  FileHeader header = {};
+  if (size >= sizeof(header)) {
+    std::memcpy(&header, base, sizeof(header));
+  }
+  if (std::memcmp(header.magic, kFileMagic, sizeof(kFileMagic)) != 0 ||
+      header.num_entries >
+          (size - sizeof(header)) / sizeof(FileEntryHeader)) {
+    TF_LITE_REPORT_ERROR(error_reporter, "%s is not a valid weight cache.",
+                         filename.c_str());
+    return kTfLiteError;
+  }
+
+  std::map<FileKey, FileEntry> entries;
+  for (uint64_t i = 0; i < header.num_entries; ++i) {
+    FileEntryHeader entry;
+    std::memcpy(&entry, base + sizeof(header) + i * sizeof(entry),
+                sizeof(entry));
+    if (entry.offset > size || entry.bytes > size - entry.offset) {
+      TF_LITE_REPORT_ERROR(error_reporter, "%s is not a valid weight cache.",
+                           filename.c_str());
+      return kTfLiteError;
+    }
+    entries[FileKey(entry.fingerprint, entry.source_bytes, entry.kind,
+                    entry.kernel_params)] = {entry.offset, entry.bytes};
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  file_ = std::move(file);
+  file_entries_ = std::move(entries);
+  return kTfLiteOk;
+}
+
+TfLiteStatus WeightCache::SaveFile(const std::string& filename,
+                                   ErrorReporter* error_reporter) {
+  std::vector<std::shared_ptr<const Entry>> entries;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& live : live_) {
+      if (std::shared_ptr<const Entry> entry = live.second.lock()) {
+        entries.push_back(std::move(entry));
+      }
+    }
+  }
+
+  // The source weights of a held entry are alive, see the class comment.
+  std::vector<FileEntryHeader> entry_headers;
+  size_t offset =
+      AlignTo(sizeof(FileHeader) + entries.size() * sizeof(FileEntryHeader));
+  for (const auto& entry : entries) {
+    FileEntryHeader entry_header = {};
+    entry_header.fingerprint =
+        Fingerprint(entry->source_, entry->source_bytes_);
+    entry_header.source_bytes = entry->source_bytes_;
+    entry_header.kernel_params = entry->kernel_params_;
+    entry_header.offset = offset;
+    entry_header.bytes = entry->bytes();
+    entry_header.kind = entry->kind_;
+    entry_headers.push_back(entry_header);
+    offset = AlignTo(offset + entry->bytes());
+  }
+
+  // Write to a temporary file first, so that a process mapping `filename`
+  // keeps seeing the old contents.
+  const std::string temp_filename = filename + ".tmp";
+  FILE* file = fopen(temp_filename.c_str(), "wb");
+  if (file == nullptr) {
+    TF_LITE_REPORT_ERROR(error_reporter, "Could not open %s for writing.",
+                         temp_filename.c_str());
+    return kTfLiteError;
+  }
+  FileHeader header;
+  std::memcpy(header.magic, kFileMagic, sizeof(kFileMagic));
+  header.num_entries = entries.size();
+  bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+  if (!entry_headers.empty()) {
+    ok = ok && fwrite(entry_headers.data(), sizeof(FileEntryHeader),
+                      entry_headers.size(), file) == entry_headers.size();
+  }
+  const char padding[kAlignment] = {};
+  for (size_t i = 0; ok && i < entries.size(); ++i) {
+    const long position = ftell(file);  // NOLINT(runtime/int)
+    ok = position >= 0 && static_cast<size_t>(position) <=
+                              entry_headers[i].offset;
+    if (!ok) break;
+    const size_t padding_bytes = entry_headers[i].offset - position;
+    ok = fwrite(padding, 1, padding_bytes, file) == padding_bytes &&
+         fwrite(entries[i]->data(), 1, entries[i]->bytes(), file) ==
+             entries[i]->bytes();
+  }
+  ok = fclose(file) == 0 && ok;
+  if (!ok || std::rename(temp_filename.c_str(), filename.c_str()) != 0) {
+    std::remove(temp_filename.c_str());
+    TF_LITE_REPORT_ERROR(error_reporter, "Could not write weight cache %s.",
+                         filename.c_str());
+    return kTfLiteError;
+  }
+  return kTfLiteOk;
+}
+
+WeightCache::Stats WeightCache::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+}  // namespace tflite
@@ -0,0 +1,141 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_KERNELS_WEIGHT_CACHE_H_
+#define TENSORFLOW_LITE_KERNELS_WEIGHT_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+#include "tensorflow/lite/allocation.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/core/api/error_reporter.h"
+
+namespace tflite {
+
+// A process-wide cache of constant weights that kernels rearrange into another
+// layout before running, e.g. the transposed filter of the multithreaded float
+// Conv.
+//
+// Entries are keyed by the address of the source weights, so interpreters
+// built from the same FlatBufferModel share one copy of each packed matrix
+// instead of packing their own. An entry lives as long as a kernel holds it;
+// since kernels only cache read-only weights (kTfLiteMmapRo tensors), whose
+// model outlives the kernel, the address can't be reused for other weights
+// meanwhile.
+//
+// The cache can also be saved to a file and loaded by another process, which
+// then maps the packed weights instead of packing them again. Entries of a
+// file are keyed by a fingerprint of the source weights. The layout of packed
+// weights depends on how TF Lite was built, so a file should only be loaded by
+// the binary that saved it.
+class WeightCache {
+ public:
+  // Identifies a kind of packing, i.e. which kernel packs the weights and how.
+  enum Kind : uint32_t {
+    // Float Conv filter transposed from OHWI to HWIO, for the multithreaded
+    // Eigen kernel.
+    kConvHwcnFloat = 1,
+  };
+
+  // Packed weights, immutable once created.
+  class Entry {
+   public:
+    const void* data() const { return data_; }
+    size_t bytes() const { return bytes_; }
+
+   private:
+    friend class WeightCache;
+    const void* data_ = nullptr;
+    size_t bytes_ = 0;
+    // Owns `data_` unless it points into a loaded file.
+    std::unique_ptr<uint8_t[]> buffer_;
+    // Keeps the file `data_` points into mapped.
+    std::shared_ptr<const Allocation> file_;
+    // Key of the entry, for saving it to a file.
+    uint32_t kind_ = 0;
+    uint64_t kernel_params_ = 0;
+    const void* source_ = nullptr;
+    size_t source_bytes_ = 0;
+  };
+
+  struct Stats {
+    // Number of entries packed by this process.
+    int num_packed = 0;
+    // Number of entries found in a loaded file instead of being packed.
+    int num_loaded = 0;
+    // Number of requests served by an entry another kernel already holds.
+    int num_shared = 0;
+    // Bytes that sharing saved, i.e. the sum of the sizes of shared entries.
+    size_t shared_bytes = 0;
+  };
+
+  // Returns the cache shared by all interpreters of the process.
+  static WeightCache& Global();
+
+  WeightCache() = default;
+  WeightCache(const WeightCache&) = delete;
+  WeightCache& operator=(const WeightCache&) = delete;
+
+  // Returns the packed version of the `source_bytes` bytes at `source`, calling
+  // `pack` to write the `packed_bytes` bytes of a new entry if neither the
+  // cache nor the loaded file has it. `kernel_params` holds whatever the
+  // packing depends on besides the source data, e.g. the matrix dimensions.
+  // The entry is dropped from the cache once all the returned pointers are
+  // destroyed. Thread-safe; `pack` is called without holding the cache lock.
+  std::shared_ptr<const Entry> GetOrPack(
+      const void* source, size_t source_bytes, Kind kind,
+      uint64_t kernel_params, size_t packed_bytes,
+      const std::function<void(void* packed)>& pack);
+
+  // Maps the entries saved in `filename`, replacing any previously loaded
+  // file. Entries already in the cache are not affected.
+  TfLiteStatus LoadFile(const std::string& filename,
+                        ErrorReporter* error_reporter);
+
+  // Writes the entries currently held by kernels to `filename`, replacing it.
+  TfLiteStatus SaveFile(const std::string& filename,
+                        ErrorReporter* error_reporter);
+
+  Stats stats() const;
+
+ private:
+  // (source, kind, kernel_params).
+  using LiveKey = std::tuple<const void*, uint32_t, uint64_t>;
+  // (fingerprint of the source, source bytes, kind, kernel_params).
+  using FileKey = std::tuple<uint64_t, uint64_t, uint32_t, uint64_t>;
+  struct FileEntry {
+    size_t offset;
+    size_t bytes;
+  };
+
+  // Returns the entry for `key` of the loaded file, or nullptr.
+  std::shared_ptr<Entry> FindInFile(const FileKey& key, size_t packed_bytes);
+
+  mutable std::mutex mutex_;
+  std::map<LiveKey, std::weak_ptr<const Entry>> live_;
+  std::shared_ptr<const Allocation> file_;
+  std::map<FileKey, FileEntry> file_entries_;
+  Stats stats_;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_KERNELS_WEIGHT_CACHE_H_
@@ -0,0 +1,131 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/kernels/weight_cache.h"
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/lite/stderr_reporter.h"
+#include "tensorflow/lite/testing/util.h"
+
+namespace tflite {
+namespace {
+
+// Packs `weights` by negating them, and counts the calls.
+std::shared_ptr<const WeightCache::Entry> Negate(
+    WeightCache* cache, const std::vector<float>& weights, int* num_packs,
+    uint64_t kernel_params = 0) {
+  const size_t bytes = weights.size() * sizeof(float);
+  return cache->GetOrPack(weights.data(), bytes, WeightCache::kConvHwcnFloat,
+                          kernel_params, bytes,
+                          [&weights, num_packs](void* packed) {
+                            ++*num_packs;
+                            float* out = static_cast<float*>(packed);
+                            for (size_t i = 0; i < weights.size(); ++i) {
+                              out[i] = -weights[i];
+                            }
+                          });
+}
+
+void ExpectNegated(const WeightCache::Entry& entry,
+                   const std::vector<float>& weights) {
+  ASSERT_EQ(entry.bytes(), weights.size() * sizeof(float));
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(entry.data()) % 64, 0);
+  const float* data = static_cast<const float*>(entry.data());
+  for (size_t i = 0; i < weights.size(); ++i) {
+    EXPECT_EQ(data[i], -weights[i]);
+  }
+}
+
+TEST(WeightCacheTest, SharesPackedWeights) {
+  WeightCache cache;
+  const std::vector<float> weights = {1, 2, 3, 4, 5};
+  int num_packs = 0;
+  auto first = Negate(&cache, weights, &num_packs);
+  auto second = Negate(&cache, weights, &num_packs);
+  EXPECT_EQ(num_packs, 1);
+  EXPECT_EQ(first, second);
+  ExpectNegated(*first, weights);
+  EXPECT_EQ(cache.stats().num_packed, 1);
+  EXPECT_EQ(cache.stats().num_shared, 1);
+  EXPECT_EQ(cache.stats().shared_bytes, weights.size() * sizeof(float));
+
+  // Other kernel parameters need another packing.
+  auto other = Negate(&cache, weights, &num_packs, /*kernel_params=*/1);
+  EXPECT_EQ(num_packs, 2);
+  EXPECT_NE(other, first);
+}
+
+TEST(WeightCacheTest, DropsReleasedEntries) {
+  WeightCache cache;
+  const std::vector<float> weights = {1, 2, 3};
+  int num_packs = 0;
+  Negate(&cache, weights, &num_packs);
+  Negate(&cache, weights, &num_packs);
+  EXPECT_EQ(num_packs, 2);
+}
+
+TEST(WeightCacheTest, SaveAndLoadFile) {
+  const std::string filename = ::testing::TempDir() + "/weight_cache.bin";
+  const std::vector<float> weights = {1, 2, 3, 4, 5, 6, 7};
+  const std::vector<float> other_weights = {8, 9};
+  {
+    WeightCache cache;
+    int num_packs = 0;
+    auto entry = Negate(&cache, weights, &num_packs);
+    auto other_entry = Negate(&cache, other_weights, &num_packs);
+    ASSERT_EQ(cache.SaveFile(filename, DefaultErrorReporter()), kTfLiteOk);
+  }
+
+  // Another process would find the same weights at another address.
+  const std::vector<float> copy = weights;
+  WeightCache cache;
+  ASSERT_EQ(cache.LoadFile(filename, DefaultErrorReporter()), kTfLiteOk);
+  int num_packs = 0;
+  auto entry = Negate(&cache, copy, &num_packs);
+  EXPECT_EQ(num_packs, 0);
+  EXPECT_EQ(cache.stats().num_loaded, 1);
+  ExpectNegated(*entry, copy);
+
+  // Weights that weren't saved are packed.
+  const std::vector<float> changed = {1, 2, 3, 4, 5, 6, 0};
+  auto changed_entry = Negate(&cache, changed, &num_packs);
+  EXPECT_EQ(num_packs, 1);
+  ExpectNegated(*changed_entry, changed);
+}
+
+TEST(WeightCacheTest, RejectsInvalidFile) {
+  const std::string filename = ::testing::TempDir() + "/not_a_cache.bin";
+  FILE* file = fopen(filename.c_str(), "wb");
+  ASSERT_NE(file, nullptr);
+  fputs("not a weight cache", file);
+  fclose(file);
+  WeightCache cache;
+  EXPECT_EQ(cache.LoadFile(filename, DefaultErrorReporter()), kTfLiteError);
+  EXPECT_EQ(cache.LoadFile(filename + ".missing", DefaultErrorReporter()),
+            kTfLiteError);
+}
+
+}  // namespace
+}  // namespace tflite
+
+int main(int argc, char** argv) {
+  ::tflite::LogToStderr();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -59,6 +59,16 @@ class MemoryPlanner {
 
   // Returns true if the non-persistent memory is available.
   virtual bool HasNonPersistentMemory() = 0;
+
+  // Sets whether non-persistent memory is committed lazily, i.e. only takes
+  // up system memory once it is first written, and can be handed back with
+  // ReleaseMemoryAfter(). Takes effect on the next ExecuteAllocations() or
+  // AcquireNonPersistentMemory().
+  virtual void SetLazyCommit(bool lazy_commit) = 0;
+
+  // With lazy commit, hands the non-persistent memory that only holds tensors
+  // no longer needed once the given node has run back to the system.
+  virtual TfLiteStatus ReleaseMemoryAfter(int node) = 0;
 };
 
 }  // namespace tflite
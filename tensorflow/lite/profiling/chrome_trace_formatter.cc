@@ -0,0 +1,241 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/profiling/chrome_trace_formatter.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <unordered_map>
+
+namespace tflite {
+namespace profiling {
+namespace {
+
+using EventType = tflite::Profiler::EventType;
+
+std::string EscapeJson(const char* str) {
+  std::string escaped;
+  if (str == nullptr) return escaped;
+  for (const char* c = str; *c != '\0'; ++c) {
+    switch (*c) {
+      case '"':
+        escaped += "\\\"";
+        break;
+      case '\\':
+        escaped += "\\\\";
+        break;
+      case '\n':
+        escaped += "\\n";
+        break;
+      default:
+        if (static_cast<unsigned char>(*c) < 0x20) {
+          char buf[8];
+          snprintf(buf, sizeof(buf), "\\u%04x", *c);
+          escaped += buf;
+        } else {
+          escaped += *c;
+        }
+    }
+  }
+  return escaped;
+}
+
+const char* EventCategory(EventType event_type) {
+  switch (event_type) {
+    case EventType::OPERATOR_INVOKE_EVENT:
+      return "operator";
+    case EventType::DELEGATE_OPERATOR_INVOKE_EVENT:
+      return "delegate_operator";
+    case EventType::GENERAL_RUNTIME_INSTRUMENTATION_EVENT:
+      return "runtime";
+    default:
+      return "default";
+  }
+}
+
+// Returns true if 'e' spans a whole invocation of the interpreter: the event
+// of Interpreter::Invoke(), or a run marked by the benchmark tool.
+bool IsInvocationEvent(const TraceEvent& e) {
+  if (e.tag == nullptr) return false;
+  switch (e.event_type) {
+    case EventType::GENERAL_RUNTIME_INSTRUMENTATION_EVENT:
+      return std::strcmp(e.tag, "invoke") == 0;
+    case EventType::DEFAULT:
+      return std::strcmp(e.tag, "Run") == 0 ||
+             std::strcmp(e.tag, "WarmupRun") == 0;
+    default:
+      return false;
+  }
+}
+
+// Tracks how far into its arena a subgraph has got during an invocation.
+class ArenaWatermark {
+ public:
+  explicit ArenaWatermark(const Subgraph* subgraph) : subgraph_(subgraph) {
+    for (size_t i = 0; i < subgraph->tensors_size(); ++i) {
+      const TfLiteTensor* t = subgraph->tensor(i);
+      if (t->allocation_type != kTfLiteArenaRw || t->data.raw == nullptr) {
+        continue;
+      }
+      if (arena_base_ == nullptr || t->data.raw < arena_base_) {
+        arena_base_ = t->data.raw;
+      }
+    }
+  }
+
+  // Forgets the arena touched by the previous invocation.
+  void StartInvocation() { high_water_mark_ = 0; }
+
+  // Returns the arena high-water mark once 'node_index' has run. Nodes that
+  // run more than once in an invocation, e.g. in the body of a loop, count
+  // toward the same mark.
+  size_t Update(int node_index) {
+    const auto* node_and_reg = subgraph_->node_and_registration(node_index);
+    if (node_and_reg == nullptr || arena_base_ == nullptr) {
+      return high_water_mark_;
+    }
+    const TfLiteNode& node = node_and_reg->first;
+    for (const TfLiteIntArray* tensors :
+         {node.inputs, node.outputs, node.temporaries}) {
+      if (tensors == nullptr) continue;
+      for (int i = 0; i < tensors->size; ++i) {
+        if (tensors->data[i] == kTfLiteOptionalTensor) continue;
+        const TfLiteTensor* t = subgraph_->tensor(tensors->data[i]);
+        if (t == nullptr || t->allocation_type != kTfLiteArenaRw ||
+            t->data.raw == nullptr) {
+          continue;
+        }
+        const size_t end = (t->data.raw - arena_base_) + t->bytes;
+        high_water_mark_ = std::max(high_water_mark_, end);
+      }
+    }
+    return high_water_mark_;
+  }
+
+ private:
+  const Subgraph* subgraph_;
+  const char* arena_base_ = nullptr;
+  size_t high_water_mark_ = 0;
+};
+
+}  // namespace
+
+std::string FormatChromeTrace(const std::vector<const TraceEvent*>& events,
+                              const tflite::Interpreter& interpreter) {
+  std::vector<const TraceEvent*> finished;
+  finished.reserve(events.size());
+  std::copy_if(events.begin(), events.end(), std::back_inserter(finished),
+               [](const TraceEvent* e) {
+                 return e != nullptr && e->end_timestamp_us != 0 &&
+                        e->end_timestamp_us >= e->begin_timestamp_us;
+               });
+  std::stable_sort(finished.begin(), finished.end(),
+                   [](const TraceEvent* a, const TraceEvent* b) {
+                     return a->begin_timestamp_us < b->begin_timestamp_us;
+                   });
+  const uint64_t base_us =
+      finished.empty() ? 0 : finished.front()->begin_timestamp_us;
+
+  auto& mutable_interpreter = const_cast<tflite::Interpreter&>(interpreter);
+  std::map<int64_t, std::unique_ptr<ArenaWatermark>> watermarks;
+  // The delegate kernel each thread is currently running, used to attribute
+  // delegate-internal operator events to their partition.
+  std::unordered_map<uint32_t, const TraceEvent*> open_delegate_kernels;
+  std::set<uint32_t> thread_ids;
+
+  std::ostringstream json;
+  json << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first = true;
+  auto begin_event = [&]() {
+    if (!first) json << ",";
+    first = false;
+    json << "\n";
+  };
+
+  for (const TraceEvent* e : finished) {
+    thread_ids.insert(e->thread_id);
+    // Events are in order of their start, so the operators of an invocation
+    // come after its event.
+    if (IsInvocationEvent(*e)) {
+      for (auto& watermark : watermarks) watermark.second->StartInvocation();
+    }
+    const uint64_t ts = e->begin_timestamp_us - base_us;
+    begin_event();
+    json << "{\"name\":\"" << EscapeJson(e->tag) << "\",\"cat\":\""
+         << EventCategory(e->event_type) << "\",\"ph\":\"X\",\"pid\":0"
+         << ",\"tid\":" << e->thread_id << ",\"ts\":" << ts
+         << ",\"dur\":" << e->end_timestamp_us - e->begin_timestamp_us
+         << ",\"args\":{";
+
+    const Subgraph* subgraph = nullptr;
+    size_t high_water_mark = 0;
+    if (e->event_type == EventType::OPERATOR_INVOKE_EVENT) {
+      const int64_t subgraph_index = e->extra_event_metadata;
+      const int node_index = static_cast<int>(e->event_metadata);
+      json << "\"subgraph\":" << subgraph_index << ",\"node\":" << node_index;
+      if (subgraph_index >= 0 &&
+          subgraph_index < static_cast<int64_t>(interpreter.subgraphs_size())) {
+        subgraph = mutable_interpreter.subgraph(subgraph_index);
+      }
+      if (subgraph != nullptr) {
+        const auto* node_and_reg = subgraph->node_and_registration(node_index);
+        if (node_and_reg != nullptr && node_and_reg->first.delegate) {
+          json << ",\"delegate_partition\":" << node_index;
+          open_delegate_kernels[e->thread_id] = e;
+        }
+        auto& watermark = watermarks[subgraph_index];
+        if (!watermark) watermark.reset(new ArenaWatermark(subgraph));
+        high_water_mark = watermark->Update(node_index);
+        json << ",\"arena_high_water_mark_bytes\":" << high_water_mark;
+      }
+    } else if (e->event_type == EventType::DELEGATE_OPERATOR_INVOKE_EVENT) {
+      json << "\"subgraph\":" << e->extra_event_metadata
+           << ",\"delegate_node\":" << e->event_metadata;
+      const auto kernel = open_delegate_kernels.find(e->thread_id);
+      if (kernel != open_delegate_kernels.end() &&
+          kernel->second->end_timestamp_us >= e->end_timestamp_us) {
+        json << ",\"delegate_partition\":" << kernel->second->event_metadata;
+      }
+    } else {
+      json << "\"metadata\":" << e->event_metadata
+           << ",\"extra_metadata\":" << e->extra_event_metadata;
+    }
+    json << "}}";
+
+    if (subgraph != nullptr) {
+      begin_event();
+      json << "{\"name\":\"arena_high_water_mark\",\"ph\":\"C\",\"pid\":0"
+           << ",\"ts\":" << ts << ",\"args\":{\"subgraph_"
+           << e->extra_event_metadata << "\":" << high_water_mark << "}}";
+    }
+  }
+
+  for (uint32_t thread_id : thread_ids) {
+    begin_event();
+    json << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":"
+         << thread_id << ",\"args\":{\"name\":\"Thread " << thread_id
+         << "\"}}";
+  }
+  json << "\n]}\n";
+  return json.str();
+}
+
+}  // namespace profiling
+}  // namespace tflite
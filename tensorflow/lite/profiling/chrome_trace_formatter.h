@@ -0,0 +1,47 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_PROFILING_CHROME_TRACE_FORMATTER_H_
+#define TENSORFLOW_LITE_PROFILING_CHROME_TRACE_FORMATTER_H_
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/profiling/trace_profiler.h"
+
+namespace tflite {
+namespace profiling {
+
+// Formats events recorded by a TraceProfiler as Chrome trace event JSON, which
+// can be loaded in chrome://tracing or Perfetto.
+//
+// Every finished event becomes a complete ("X") event on the thread it was
+// recorded on. Operator events carry their subgraph and node index, the
+// delegate partition (the node index of the delegate kernel) they belong to,
+// if any, and the arena high-water mark: the highest offset of the subgraph's
+// tensor arena touched by the current invocation so far. The latter is also
+// emitted as a counter track per subgraph. Invocations start with the event of
+// Interpreter::Invoke() or with the "Run" and "WarmupRun" events of the
+// benchmark tool; without them, the mark covers the whole trace.
+//
+// 'interpreter' must be the one the events were recorded from, and its tensors
+// must not have been reallocated since.
+std::string FormatChromeTrace(const std::vector<const TraceEvent*>& events,
+                              const tflite::Interpreter& interpreter);
+
+}  // namespace profiling
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_PROFILING_CHROME_TRACE_FORMATTER_H_
@@ -0,0 +1,209 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/profiling/chrome_trace_formatter.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/kernels/test_util.h"
+#include "tensorflow/lite/testing/util.h"
+
+namespace tflite {
+namespace profiling {
+namespace {
+
+using ::testing::HasSubstr;
+using ::testing::Not;
+
+TfLiteStatus SimpleOpEval(TfLiteContext* context, TfLiteNode* node) {
+  const TfLiteTensor* input1 = tflite::GetInput(context, node, /*index=*/0);
+  const TfLiteTensor* input2 = tflite::GetInput(context, node, /*index=*/1);
+  TfLiteTensor* output = GetOutput(context, node, /*index=*/0);
+  *output->data.i32 = *input1->data.i32 + *input2->data.i32;
+  return kTfLiteOk;
+}
+
+TfLiteRegistration* RegisterSimpleOp() {
+  static TfLiteRegistration registration = {
+      nullptr,        nullptr, nullptr,
+      SimpleOpEval,   nullptr, tflite::BuiltinOperator_CUSTOM,
+      "SimpleOpEval", 1};
+  return &registration;
+}
+
+class SimpleOpModel : public SingleOpModel {
+ public:
+  SimpleOpModel() {
+    inputs_[0] = AddInput({TensorType_INT32, {1}});
+    inputs_[1] = AddInput({TensorType_INT32, {1}});
+    output_ = AddOutput({TensorType_INT32, {}});
+    SetCustomOp("SimpleOpEval", {}, RegisterSimpleOp);
+    BuildInterpreter({GetShape(inputs_[0]), GetShape(inputs_[1])});
+  }
+  tflite::Interpreter* GetInterpreter() { return interpreter_.get(); }
+  void SetInputs(int32_t x, int32_t y) {
+    PopulateTensor(inputs_[0], {x});
+    PopulateTensor(inputs_[1], {y});
+  }
+
+ private:
+  int inputs_[2];
+  int output_;
+};
+
+TEST(ChromeTraceFormatterTest, Empty) {
+  Interpreter interpreter;
+  EXPECT_THAT(FormatChromeTrace({}, interpreter), HasSubstr("\"traceEvents\""));
+}
+
+TEST(ChromeTraceFormatterTest, EventsAreRelativeAndPerThread) {
+  Interpreter interpreter;
+  TraceEvent first = {"First",  1000, 1010, Profiler::EventType::DEFAULT,
+                      0,        0,    /*thread_id=*/3};
+  TraceEvent second = {"Sec\"ond", 1004, 1006, Profiler::EventType::DEFAULT,
+                       0,          0,    /*thread_id=*/5};
+  TraceEvent unfinished = {"Unfinished", 1005, 0, Profiler::EventType::DEFAULT,
+                           0,            0,    /*thread_id=*/3};
+  const std::string trace =
+      FormatChromeTrace({&second, &unfinished, &first}, interpreter);
+
+  EXPECT_THAT(trace, HasSubstr("\"name\":\"First\",\"cat\":\"default\","
+                               "\"ph\":\"X\",\"pid\":0,\"tid\":3,\"ts\":0,"
+                               "\"dur\":10"));
+  EXPECT_THAT(trace, HasSubstr("\"name\":\"Sec\\\"ond\""));
+  EXPECT_THAT(trace, HasSubstr("\"tid\":5,\"ts\":4,\"dur\":2"));
+  EXPECT_THAT(trace, Not(HasSubstr("Unfinished")));
+  EXPECT_THAT(trace, HasSubstr("\"name\":\"thread_name\",\"ph\":\"M\","
+                               "\"pid\":0,\"tid\":5"));
+  EXPECT_LT(trace.find("\"First\""), trace.find("\"Sec"));
+}
+
+TEST(ChromeTraceFormatterTest, OperatorEvents) {
+  TraceProfiler profiler;
+  SimpleOpModel m;
+  auto interpreter = m.GetInterpreter();
+  interpreter->SetProfiler(&profiler);
+  profiler.StartProfiling();
+  m.SetInputs(1, 2);
+  m.Invoke();
+  profiler.StopProfiling();
+
+  // The event of Interpreter::Invoke() and the one of the operator.
+  auto events = profiler.GetTraceEvents();
+  ASSERT_EQ(2, events.size());
+  const std::string trace = FormatChromeTrace(events, *interpreter);
+  EXPECT_THAT(trace, HasSubstr("\"name\":\"SimpleOpEval\",\"cat\":"
+                               "\"operator\""));
+  EXPECT_THAT(trace, HasSubstr("\"subgraph\":0,\"node\":0"));
+  EXPECT_THAT(trace, HasSubstr("\"arena_high_water_mark_bytes\":"));
+  EXPECT_THAT(trace, HasSubstr("\"name\":\"arena_high_water_mark\","
+                               "\"ph\":\"C\""));
+  EXPECT_THAT(trace, Not(HasSubstr("delegate_partition")));
+}
+
+// Builds an interpreter that runs the simple op twice: t2 = t0 + t1, then
+// t3 = t2 + t2.
+void BuildTwoOpInterpreter(Interpreter* interpreter) {
+  ASSERT_EQ(interpreter->AddTensors(4), kTfLiteOk);
+  ASSERT_EQ(interpreter->SetInputs({0, 1}), kTfLiteOk);
+  ASSERT_EQ(interpreter->SetOutputs({3}), kTfLiteOk);
+  TfLiteQuantizationParams quant;
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_EQ(interpreter->SetTensorParametersReadWrite(i, kTfLiteInt32, "",
+                                                        {1}, quant),
+              kTfLiteOk);
+  }
+  ASSERT_EQ(interpreter->AddNodeWithParameters({0, 1}, {2}, nullptr, 0,
+                                               nullptr, RegisterSimpleOp()),
+            kTfLiteOk);
+  ASSERT_EQ(interpreter->AddNodeWithParameters({2, 2}, {3}, nullptr, 0,
+                                               nullptr, RegisterSimpleOp()),
+            kTfLiteOk);
+  ASSERT_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+}
+
+// Returns the arena high-water marks of the operator events of 'trace', in
+// order.
+std::vector<int> HighWaterMarks(const std::string& trace) {
+  static constexpr char kKey[] = "\"arena_high_water_mark_bytes\":";
+  std::vector<int> marks;
+  for (size_t pos = trace.find(kKey); pos != std::string::npos;
+       pos = trace.find(kKey, pos + 1)) {
+    marks.push_back(std::atoi(trace.c_str() + pos + sizeof(kKey) - 1));
+  }
+  return marks;
+}
+
+TraceEvent InvokeEvent(uint64_t begin_us, uint64_t end_us) {
+  return {"invoke", begin_us, end_us,
+          Profiler::EventType::GENERAL_RUNTIME_INSTRUMENTATION_EVENT,
+          0,        0,        /*thread_id=*/1};
+}
+
+TraceEvent NodeEvent(int node_index, uint64_t begin_us) {
+  return {"SimpleOpEval", begin_us,   begin_us + 1,
+          Profiler::EventType::OPERATOR_INVOKE_EVENT,
+          node_index,     /*subgraph_index=*/0, /*thread_id=*/1};
+}
+
+TEST(ChromeTraceFormatterTest, HighWaterMarkResetsAtEachInvocation) {
+  Interpreter interpreter;
+  BuildTwoOpInterpreter(&interpreter);
+  TraceEvent invoke = InvokeEvent(0, 10);
+  TraceEvent node0 = NodeEvent(0, 1);
+  TraceEvent node1 = NodeEvent(1, 2);
+  const std::vector<int> node1_only =
+      HighWaterMarks(FormatChromeTrace({&invoke, &node1}, interpreter));
+  ASSERT_EQ(1, node1_only.size());
+
+  // The second invocation only has an event for node 1, e.g. because the
+  // event of node 0 was dropped, and must not inherit the first one's mark.
+  TraceEvent second_invoke = InvokeEvent(20, 30);
+  TraceEvent second_node1 = NodeEvent(1, 21);
+  const std::vector<int> marks = HighWaterMarks(FormatChromeTrace(
+      {&invoke, &node0, &second_invoke, &second_node1}, interpreter));
+  ASSERT_EQ(2, marks.size());
+  EXPECT_EQ(node1_only[0], marks[1]);
+}
+
+TEST(ChromeTraceFormatterTest, RepeatedNodesShareAnInvocation) {
+  Interpreter interpreter;
+  BuildTwoOpInterpreter(&interpreter);
+  // Node 0 runs again after node 1 within a single invocation, as nodes do in
+  // the body of a loop.
+  TraceEvent invoke = InvokeEvent(0, 10);
+  TraceEvent node0 = NodeEvent(0, 1);
+  TraceEvent node1 = NodeEvent(1, 2);
+  TraceEvent node0_again = NodeEvent(0, 3);
+  const std::vector<int> marks = HighWaterMarks(
+      FormatChromeTrace({&invoke, &node0, &node1, &node0_again}, interpreter));
+  ASSERT_EQ(3, marks.size());
+  EXPECT_EQ(std::max(marks[0], marks[1]), marks[2]);
+}
+
+}  // namespace
+}  // namespace profiling
+}  // namespace tflite
+
+int main(int argc, char** argv) {
+  ::tflite::LogToStderr();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -14,6 +14,9 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/lite/profiling/memory_info.h"
 
+#include <cstdio>
+#include <cstring>
+
 #ifdef __linux__
 #include <malloc.h>
 #include <sys/resource.h>
@@ -47,6 +50,39 @@ MemoryUsage GetMemoryUsage() {
   return result;
 }
 
+int64_t GetPeakResidentSetSizeKb() {
+  int64_t peak_rss_kb = MemoryUsage::kValueNotSet;
+#ifdef __linux__
+  // getrusage's ru_maxrss can't be reset, so read the high-water mark the
+  // kernel keeps per process instead.
+  FILE* status = fopen("/proc/self/status", "r");
+  if (status == nullptr) return peak_rss_kb;
+  char line[256];
+  while (fgets(line, sizeof(line), status) != nullptr) {
+    long long value_kb;
+    if (strncmp(line, "VmHWM:", 6) == 0 &&
+        sscanf(line + 6, "%lld", &value_kb) == 1) {
+      peak_rss_kb = value_kb;
+      break;
+    }
+  }
+  fclose(status);
+#endif
+  return peak_rss_kb;
+}
+
+bool ResetPeakResidentSetSize() {
+#ifdef __linux__
+  // Writing 5 to clear_refs resets VmHWM to the current resident set size.
+  FILE* clear_refs = fopen("/proc/self/clear_refs", "w");
+  if (clear_refs == nullptr) return false;
+  const bool written = fputs("5", clear_refs) >= 0;
+  return (fclose(clear_refs) == 0) && written;
+#else
+  return false;
+#endif
+}
+
 void MemoryUsage::AllStatsToStream(std::ostream* stream) const {
   *stream << "max resident set size = " << max_rss_kb / 1024.0
           << " MB, total malloc-ed size = "
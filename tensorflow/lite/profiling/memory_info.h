@@ -81,6 +81,18 @@ struct MemoryUsage {
 // systems will be added later.
 MemoryUsage GetMemoryUsage();
 
+// Return the peak resident set size (in kilobytes) of the process since it
+// started or since the last successful call to ResetPeakResidentSetSize(), or
+// MemoryUsage::kValueNotSet if it can't be obtained. Unlike
+// MemoryUsage::max_rss_kb, this can be reset, e.g. to measure the peak of
+// each inference run on its own.
+// Note: this only works on Linux-based systems.
+int64_t GetPeakResidentSetSizeKb();
+
+// Reset the peak resident set size to the current one. Returns false if this
+// isn't supported, e.g. on kernels older than 4.0.
+bool ResetPeakResidentSetSize();
+
 }  // namespace memory
 }  // namespace profiling
 }  // namespace tflite
@@ -14,6 +14,9 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/lite/profiling/memory_info.h"
 
+#include <cstring>
+#include <memory>
+
 #include <gtest/gtest.h>
 #include "tensorflow/lite/testing/util.h"
 
@@ -60,6 +63,29 @@ TEST(MemoryUsage, GetMemoryUsage) {
 #endif
 }
 
+TEST(MemoryUsage, PeakResidentSetSize) {
+#ifdef __linux__
+  const int64_t peak_rss_kb = GetPeakResidentSetSizeKb();
+  EXPECT_NE(MemoryUsage::kValueNotSet, peak_rss_kb);
+
+  // Touch enough memory to raise the peak noticeably.
+  const size_t size = 32 * 1024 * 1024;
+  std::unique_ptr<char[]> buffer(new char[size]);
+  memset(buffer.get(), 1, size);
+  EXPECT_GE(GetPeakResidentSetSizeKb(), peak_rss_kb + size / 1024 / 2);
+
+  // Once the memory is freed, resetting brings the peak back down, if the
+  // kernel supports it.
+  buffer.reset();
+  if (ResetPeakResidentSetSize()) {
+    EXPECT_LT(GetPeakResidentSetSizeKb(), peak_rss_kb + size / 1024 / 2);
+  }
+#else
+  EXPECT_EQ(MemoryUsage::kValueNotSet, GetPeakResidentSetSizeKb());
+  EXPECT_FALSE(ResetPeakResidentSetSize());
+#endif
+}
+
 TEST(MemoryUsage, IsSupported) {
 #ifdef __linux__
   EXPECT_TRUE(MemoryUsage::IsSupported());
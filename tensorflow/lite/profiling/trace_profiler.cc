@@ -0,0 +1,160 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/profiling/trace_profiler.h"
+
+#include <algorithm>
+
+#include "tensorflow/lite/profiling/profile_buffer.h"
+#include "tensorflow/lite/profiling/time.h"
+
+namespace tflite {
+namespace profiling {
+namespace {
+
+uint32_t CurrentThreadId() {
+  static std::atomic<uint32_t> next_thread_id(0);
+  thread_local uint32_t thread_id = next_thread_id.fetch_add(1);
+  return thread_id;
+}
+
+}  // namespace
+
+constexpr uint32_t TraceEventBuffer::kChunkSize;
+constexpr uint32_t TraceProfiler::kDefaultMaxNumEntries;
+
+TraceEventBuffer::TraceEventBuffer(uint32_t max_num_entries)
+    : max_num_chunks_(
+          std::max<uint32_t>(1, (max_num_entries + kChunkSize - 1) /
+                                    kChunkSize)),
+      chunks_(new std::atomic<TraceEvent*>[max_num_chunks_]),
+      next_index_(0),
+      num_dropped_(0) {
+  for (uint32_t i = 0; i < max_num_chunks_; ++i) {
+    chunks_[i].store(nullptr);
+  }
+}
+
+TraceEventBuffer::~TraceEventBuffer() {
+  for (uint32_t i = 0; i < max_num_chunks_; ++i) {
+    delete[] chunks_[i].load();
+  }
+}
+
+TraceEvent* TraceEventBuffer::GetOrAllocateChunk(uint32_t chunk_index) {
+  TraceEvent* chunk = chunks_[chunk_index].load(std::memory_order_acquire);
+  if (chunk != nullptr) return chunk;
+  // Several threads may race to allocate the same chunk; the first one to
+  // publish it wins and the others free their copy.
+  TraceEvent* new_chunk = new TraceEvent[kChunkSize];
+  if (chunks_[chunk_index].compare_exchange_strong(
+          chunk, new_chunk, std::memory_order_acq_rel,
+          std::memory_order_acquire)) {
+    return new_chunk;
+  }
+  delete[] new_chunk;
+  return chunk;
+}
+
+uint32_t TraceEventBuffer::AddEvent(const char* tag,
+                                    TraceEvent::EventType event_type,
+                                    uint64_t begin_timestamp_us,
+                                    uint64_t end_timestamp_us,
+                                    int64_t event_metadata1,
+                                    int64_t event_metadata2) {
+  const uint32_t index = next_index_.fetch_add(1, std::memory_order_relaxed);
+  if (index >= max_num_chunks_ * kChunkSize) {
+    num_dropped_.fetch_add(1, std::memory_order_relaxed);
+    return kInvalidEventHandle;
+  }
+  TraceEvent* event =
+      GetOrAllocateChunk(index / kChunkSize) + index % kChunkSize;
+  event->tag = tag;
+  event->begin_timestamp_us = begin_timestamp_us;
+  event->end_timestamp_us = end_timestamp_us;
+  event->event_type = event_type;
+  event->event_metadata = event_metadata1;
+  event->extra_event_metadata = event_metadata2;
+  event->thread_id = CurrentThreadId();
+  return index;
+}
+
+TraceEvent* TraceEventBuffer::Get(uint32_t event_handle) {
+  if (event_handle >= Size()) return nullptr;
+  return chunks_[event_handle / kChunkSize].load(std::memory_order_acquire) +
+         event_handle % kChunkSize;
+}
+
+size_t TraceEventBuffer::Size() const {
+  return std::min<size_t>(next_index_.load(std::memory_order_acquire),
+                          static_cast<size_t>(max_num_chunks_) * kChunkSize);
+}
+
+const TraceEvent* TraceEventBuffer::At(size_t index) const {
+  if (index >= Size()) return nullptr;
+  return chunks_[index / kChunkSize].load(std::memory_order_acquire) +
+         index % kChunkSize;
+}
+
+void TraceEventBuffer::Reset() {
+  next_index_.store(0);
+  num_dropped_.store(0);
+}
+
+uint32_t TraceProfiler::BeginEvent(const char* tag, EventType event_type,
+                                   int64_t event_metadata1,
+                                   int64_t event_metadata2) {
+  if (!enabled_.load(std::memory_order_relaxed)) return kInvalidEventHandle;
+  return buffer_.AddEvent(tag, event_type, time::NowMicros(),
+                          /*end_timestamp_us=*/0, event_metadata1,
+                          event_metadata2);
+}
+
+void TraceProfiler::EndEvent(uint32_t event_handle) {
+  if (event_handle == kInvalidEventHandle) return;
+  TraceEvent* event = buffer_.Get(event_handle);
+  if (event != nullptr) event->end_timestamp_us = time::NowMicros();
+}
+
+void TraceProfiler::EndEvent(uint32_t event_handle, int64_t event_metadata1,
+                             int64_t event_metadata2) {
+  if (event_handle == kInvalidEventHandle) return;
+  TraceEvent* event = buffer_.Get(event_handle);
+  if (event == nullptr) return;
+  event->end_timestamp_us = time::NowMicros();
+  event->event_metadata = event_metadata1;
+  event->extra_event_metadata = event_metadata2;
+}
+
+void TraceProfiler::AddEvent(const char* tag, EventType event_type,
+                             uint64_t start, uint64_t end,
+                             int64_t event_metadata1,
+                             int64_t event_metadata2) {
+  if (!enabled_.load(std::memory_order_relaxed)) return;
+  buffer_.AddEvent(tag, event_type, start, end, event_metadata1,
+                   event_metadata2);
+}
+
+std::vector<const TraceEvent*> TraceProfiler::GetTraceEvents() const {
+  std::vector<const TraceEvent*> events;
+  const size_t size = buffer_.Size();
+  events.reserve(size);
+  for (size_t i = 0; i < size; ++i) {
+    events.push_back(buffer_.At(i));
+  }
+  return events;
+}
+
+}  // namespace profiling
+}  // namespace tflite
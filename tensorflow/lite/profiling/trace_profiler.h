@@ -0,0 +1,138 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_PROFILING_TRACE_PROFILER_H_
+#define TENSORFLOW_LITE_PROFILING_TRACE_PROFILER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/lite/core/api/profiler.h"
+
+namespace tflite {
+namespace profiling {
+
+// A single event recorded by the TraceProfiler.
+struct TraceEvent {
+  using EventType = tflite::Profiler::EventType;
+
+  // Label of the event. Not owned, it must outlive the profiler.
+  const char* tag;
+  // Timestamp in microseconds when the event began.
+  uint64_t begin_timestamp_us;
+  // Timestamp in microseconds when the event ended, 0 if it hasn't ended.
+  uint64_t end_timestamp_us;
+  EventType event_type;
+  // Same meaning as in ProfileEvent: for operator events these are the node
+  // index and the subgraph index.
+  int64_t event_metadata;
+  int64_t extra_event_metadata;
+  // Small process-wide id of the thread that began the event.
+  uint32_t thread_id;
+};
+
+// An append-only event buffer that grows in fixed-size chunks up to
+// 'max_num_entries' events. Unlike ProfileBuffer, events are never
+// overwritten, and beginning and ending events are lock-free so that kernels
+// running on several threads can be recorded at once. Events beyond the
+// capacity are counted and dropped.
+//
+// Size(), At() and Reset() must not be called concurrently with recording.
+class TraceEventBuffer {
+ public:
+  static constexpr uint32_t kChunkSize = 1024;
+
+  explicit TraceEventBuffer(uint32_t max_num_entries);
+  ~TraceEventBuffer();
+
+  TraceEventBuffer(const TraceEventBuffer&) = delete;
+  TraceEventBuffer& operator=(const TraceEventBuffer&) = delete;
+
+  // Reserves a slot, fills it and returns its handle, or kInvalidEventHandle
+  // if the buffer is full.
+  uint32_t AddEvent(const char* tag, TraceEvent::EventType event_type,
+                    uint64_t begin_timestamp_us, uint64_t end_timestamp_us,
+                    int64_t event_metadata1, int64_t event_metadata2);
+
+  // Returns the event for a handle returned by AddEvent, or nullptr.
+  TraceEvent* Get(uint32_t event_handle);
+
+  // Number of events recorded since the last Reset().
+  size_t Size() const;
+
+  // Returns the event at the given index, or nullptr if out of range.
+  const TraceEvent* At(size_t index) const;
+
+  // Number of events dropped because the buffer was full.
+  size_t NumDroppedEvents() const { return num_dropped_.load(); }
+
+  // Forgets all events. Allocated chunks are kept for reuse.
+  void Reset();
+
+ private:
+  TraceEvent* GetOrAllocateChunk(uint32_t chunk_index);
+
+  const uint32_t max_num_chunks_;
+  std::unique_ptr<std::atomic<TraceEvent*>[]> chunks_;
+  std::atomic<uint32_t> next_index_;
+  std::atomic<uint32_t> num_dropped_;
+};
+
+// A profiler that keeps every event, including every operator invocation,
+// together with the id of the thread it ran on. It is meant for exporting
+// per-invocation timelines, e.g. with ChromeTraceFormatter, rather than
+// aggregate statistics.
+class TraceProfiler : public tflite::Profiler {
+ public:
+  // 4M events, allocated lazily in chunks of TraceEventBuffer::kChunkSize.
+  static constexpr uint32_t kDefaultMaxNumEntries = 1 << 22;
+
+  explicit TraceProfiler(uint32_t max_num_entries = kDefaultMaxNumEntries)
+      : buffer_(max_num_entries), enabled_(false) {}
+
+  uint32_t BeginEvent(const char* tag, EventType event_type,
+                      int64_t event_metadata1,
+                      int64_t event_metadata2) override;
+
+  void EndEvent(uint32_t event_handle) override;
+
+  void EndEvent(uint32_t event_handle, int64_t event_metadata1,
+                int64_t event_metadata2) override;
+
+  void AddEvent(const char* tag, EventType event_type, uint64_t start,
+                uint64_t end, int64_t event_metadata1,
+                int64_t event_metadata2) override;
+
+  void StartProfiling() { enabled_.store(true); }
+  void StopProfiling() { enabled_.store(false); }
+  void Reset() { buffer_.Reset(); }
+
+  // Returns the recorded events in recording order. Must not be called while
+  // events are being recorded.
+  std::vector<const TraceEvent*> GetTraceEvents() const;
+
+  size_t NumDroppedEvents() const { return buffer_.NumDroppedEvents(); }
+
+ private:
+  TraceEventBuffer buffer_;
+  std::atomic<bool> enabled_;
+};
+
+}  // namespace profiling
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_PROFILING_TRACE_PROFILER_H_
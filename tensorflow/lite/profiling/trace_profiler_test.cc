@@ -0,0 +1,109 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/profiling/trace_profiler.h"
+
+#include <set>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/lite/testing/util.h"
+
+namespace tflite {
+namespace profiling {
+namespace {
+
+TEST(TraceProfilerTest, NoEventsWhenDisabled) {
+  TraceProfiler profiler;
+  { ScopedProfile profile(&profiler, "Disabled"); }
+  EXPECT_TRUE(profiler.GetTraceEvents().empty());
+}
+
+TEST(TraceProfilerTest, GrowsPastOneChunk) {
+  TraceProfiler profiler;
+  profiler.StartProfiling();
+  const int num_events = 3 * TraceEventBuffer::kChunkSize + 7;
+  for (int i = 0; i < num_events; ++i) {
+    ScopedOperatorProfile profile(&profiler, "Op", i);
+  }
+  profiler.StopProfiling();
+
+  auto events = profiler.GetTraceEvents();
+  ASSERT_EQ(num_events, events.size());
+  for (int i = 0; i < num_events; ++i) {
+    EXPECT_EQ(i, events[i]->event_metadata);
+    EXPECT_EQ(Profiler::EventType::OPERATOR_INVOKE_EVENT,
+              events[i]->event_type);
+    EXPECT_GE(events[i]->end_timestamp_us, events[i]->begin_timestamp_us);
+  }
+  EXPECT_EQ(0, profiler.NumDroppedEvents());
+}
+
+TEST(TraceProfilerTest, DropsEventsPastCapacity) {
+  TraceProfiler profiler(/*max_num_entries=*/TraceEventBuffer::kChunkSize);
+  profiler.StartProfiling();
+  for (int i = 0; i < TraceEventBuffer::kChunkSize + 5; ++i) {
+    ScopedProfile profile(&profiler, "Event");
+  }
+  profiler.StopProfiling();
+  EXPECT_EQ(TraceEventBuffer::kChunkSize, profiler.GetTraceEvents().size());
+  EXPECT_EQ(5, profiler.NumDroppedEvents());
+
+  profiler.Reset();
+  EXPECT_TRUE(profiler.GetTraceEvents().empty());
+  EXPECT_EQ(0, profiler.NumDroppedEvents());
+}
+
+TEST(TraceProfilerTest, RecordsEventsFromConcurrentThreads) {
+  TraceProfiler profiler;
+  profiler.StartProfiling();
+  const int kNumThreads = 4;
+  const int kEventsPerThread = 2000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&profiler, t]() {
+      for (int i = 0; i < kEventsPerThread; ++i) {
+        ScopedProfile profile(&profiler, "Work",
+                              Profiler::EventType::DEFAULT, t);
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  profiler.StopProfiling();
+
+  auto events = profiler.GetTraceEvents();
+  ASSERT_EQ(kNumThreads * kEventsPerThread, events.size());
+  // Every recording thread gets its own id.
+  std::set<uint32_t> thread_ids;
+  std::vector<int> events_per_metadata(kNumThreads, 0);
+  for (const TraceEvent* event : events) {
+    EXPECT_NE(0, event->end_timestamp_us);
+    thread_ids.insert(event->thread_id);
+    events_per_metadata[event->event_metadata]++;
+  }
+  EXPECT_EQ(kNumThreads, thread_ids.size());
+  EXPECT_THAT(events_per_metadata, ::testing::Each(kEventsPerThread));
+}
+
+}  // namespace
+}  // namespace profiling
+}  // namespace tflite
+
+int main(int argc, char** argv) {
+  ::tflite::LogToStderr();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
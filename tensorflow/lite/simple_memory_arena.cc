@@ -20,6 +20,11 @@ limitations under the License.
 #include <limits>
 #include <vector>
 
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 namespace {
 
 template <typename T>
@@ -28,9 +33,50 @@ T AlignTo(size_t alignment, T offset) {
                                  : offset + (alignment - offset % alignment);
 }
 
+#ifdef __linux__
+constexpr bool kLazyCommitSupported = true;
+#else
+constexpr bool kLazyCommitSupported = false;
+#endif
+
+// Returns the parts of the sorted, merged `ranges` not covered by the sorted,
+// merged `holes`.
+std::vector<std::pair<size_t, size_t>> SubtractRanges(
+    const std::vector<std::pair<size_t, size_t>>& ranges,
+    const std::vector<std::pair<size_t, size_t>>& holes) {
+  std::vector<std::pair<size_t, size_t>> result;
+  auto hole = holes.begin();
+  for (auto range : ranges) {
+    while (hole != holes.end() && hole->second <= range.first) ++hole;
+    for (auto h = hole; h != holes.end() && h->first < range.second; ++h) {
+      if (h->first > range.first) result.emplace_back(range.first, h->first);
+      range.first = std::max(range.first, h->second);
+    }
+    if (range.first < range.second) result.push_back(range);
+  }
+  return result;
+}
+
+// Merges overlapping or adjacent ranges of a list sorted by begin.
+void MergeRanges(std::vector<std::pair<size_t, size_t>>* ranges) {
+  size_t merged = 0;
+  for (size_t i = 0; i < ranges->size(); ++i) {
+    if (merged > 0 && (*ranges)[i].first <= (*ranges)[merged - 1].second) {
+      (*ranges)[merged - 1].second =
+          std::max((*ranges)[merged - 1].second, (*ranges)[i].second);
+    } else {
+      (*ranges)[merged++] = (*ranges)[i];
+    }
+  }
+  ranges->resize(merged);
+}
+
 }  // namespace
 
 namespace tflite {
+
+SimpleMemoryArena::~SimpleMemoryArena() { FreeUnderlyingBuffer(); }
+
 TfLiteStatus SimpleMemoryArena::Allocate(
     TfLiteContext* context, size_t alignment, size_t size, int32_t tensor,
     int32_t first_node, int32_t last_node,
@@ -44,6 +90,7 @@ TfLiteStatus SimpleMemoryArena::Allocate(
     new_alloc->offset = 0;
     return kTfLiteOk;
   }
+  dead_ranges_valid_ = false;
 
   // If we don't find a better gap just allocate at the end of the buffer.
   const size_t kOffsetNotAssigned = std::numeric_limits<size_t>::max();
@@ -89,6 +136,7 @@ TfLiteStatus SimpleMemoryArena::Deallocate(
   if (alloc.size == 0) {
     return kTfLiteOk;
   }
+  dead_ranges_valid_ = false;
 
   int erased_allocs_count = 0;
   auto it = ordered_allocs_.begin();
@@ -106,8 +154,38 @@ TfLiteStatus SimpleMemoryArena::Deallocate(
 
 TfLiteStatus SimpleMemoryArena::Commit(TfLiteContext* context) {
   size_t required_size = RequiredBufferSize();
-  if (required_size > underlying_buffer_size_) {
-    char* new_alloc = new char[required_size];
+  const bool map_buffer = lazy_commit_ && kLazyCommitSupported;
+  if (required_size > underlying_buffer_size_ ||
+      (underlying_buffer_ != nullptr &&
+       map_buffer != underlying_buffer_mapped_)) {
+    required_size = std::max(required_size, underlying_buffer_size_);
+#ifdef __linux__
+    // A mapped buffer grows without touching its pages, which would commit
+    // them.
+    if (map_buffer && underlying_buffer_mapped_) {
+      void* new_alloc = mremap(underlying_buffer_, underlying_buffer_size_,
+                               required_size, MREMAP_MAYMOVE);
+      TF_LITE_ENSURE(context, new_alloc != MAP_FAILED);
+      underlying_buffer_ = static_cast<char*>(new_alloc);
+      underlying_buffer_size_ = required_size;
+      // Mappings are page aligned, hence aligned to the arena alignment too.
+      underlying_buffer_aligned_ptr_ = underlying_buffer_;
+      committed_ = true;
+      return kTfLiteOk;
+    }
+#endif
+    char* new_alloc = nullptr;
+#ifdef __linux__
+    if (map_buffer) {
+      void* mapping = mmap(nullptr, required_size, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      TF_LITE_ENSURE(context, mapping != MAP_FAILED);
+      new_alloc = static_cast<char*>(mapping);
+    }
+#endif
+    if (!map_buffer) {
+      new_alloc = new char[required_size];
+    }
     char* new_underlying_buffer_aligned_ptr = reinterpret_cast<char*>(
         AlignTo(arena_alignment_, reinterpret_cast<intptr_t>(new_alloc)));
 
@@ -116,14 +194,16 @@ TfLiteStatus SimpleMemoryArena::Commit(TfLiteContext* context) {
     // memory block.
     if (high_water_mark_ > 0 && underlying_buffer_size_ > 0) {
       size_t copy_amount = std::min(
-          underlying_buffer_.get() + underlying_buffer_size_ -
+          underlying_buffer_ + underlying_buffer_size_ -
               underlying_buffer_aligned_ptr_,
           new_alloc + required_size - new_underlying_buffer_aligned_ptr);
       memcpy(new_underlying_buffer_aligned_ptr, underlying_buffer_aligned_ptr_,
              copy_amount);
     }
 
-    underlying_buffer_.reset(new_alloc);
+    FreeUnderlyingBuffer();
+    underlying_buffer_ = new_alloc;
+    underlying_buffer_mapped_ = map_buffer;
     underlying_buffer_size_ = required_size;
     underlying_buffer_aligned_ptr_ = new_underlying_buffer_aligned_ptr;
   }
@@ -150,15 +230,88 @@ TfLiteStatus SimpleMemoryArena::ClearPlan() {
   committed_ = false;
   high_water_mark_ = 0;
   ordered_allocs_.clear();
+  dead_ranges_valid_ = false;
   return kTfLiteOk;
 }
 
 TfLiteStatus SimpleMemoryArena::ReleaseBuffer() {
   committed_ = false;
+  FreeUnderlyingBuffer();
   underlying_buffer_size_ = 0;
   underlying_buffer_aligned_ptr_ = nullptr;
-  underlying_buffer_.reset();
   return kTfLiteOk;
 }
 
+TfLiteStatus SimpleMemoryArena::ReleaseDeadAllocs(TfLiteContext* context,
+                                                  int32_t node) {
+  if (!underlying_buffer_mapped_ || node < 0) return kTfLiteOk;
+  TF_LITE_ENSURE(context, committed_);
+  if (!dead_ranges_valid_) CalculateDeadRanges();
+  if (static_cast<size_t>(node) >= dead_ranges_.size()) return kTfLiteOk;
+#ifdef __linux__
+  static const size_t page_size = sysconf(_SC_PAGESIZE);
+  const intptr_t base =
+      reinterpret_cast<intptr_t>(underlying_buffer_aligned_ptr_);
+  for (const auto& range : dead_ranges_[node]) {
+    // Only whole pages can be released; the partial pages at either end may
+    // be shared with live allocations.
+    const intptr_t begin = AlignTo(page_size, base + range.first);
+    const intptr_t end = (base + range.second) / page_size * page_size;
+    if (begin < end) {
+      // The pages are zero-filled again on their next use. Failing to release
+      // them only costs memory, so errors are ignored.
+      madvise(reinterpret_cast<void*>(begin), end - begin, MADV_DONTNEED);
+    }
+  }
+#endif
+  return kTfLiteOk;
+}
+
+void SimpleMemoryArena::CalculateDeadRanges() {
+  dead_ranges_.clear();
+  int32_t last_dying_node = -1;
+  for (const auto& alloc : ordered_allocs_) {
+    if (alloc.size > 0 &&
+        alloc.last_node != std::numeric_limits<int32_t>::max()) {
+      last_dying_node = std::max(last_dying_node, alloc.last_node);
+    }
+  }
+  dead_ranges_.resize(last_dying_node + 1);
+  std::vector<std::pair<size_t, size_t>> dead;
+  std::vector<std::pair<size_t, size_t>> live;
+  for (int32_t node = 0; node <= last_dying_node; ++node) {
+    dead.clear();
+    live.clear();
+    // `ordered_allocs_` is sorted by offset, hence so are both lists.
+    for (const auto& alloc : ordered_allocs_) {
+      if (alloc.size == 0) continue;
+      const auto range =
+          std::make_pair(alloc.offset, alloc.offset + alloc.size);
+      if (alloc.last_node == node) {
+        dead.push_back(range);
+      } else if (alloc.first_node <= node && alloc.last_node > node) {
+        live.push_back(range);
+      }
+    }
+    if (dead.empty()) continue;
+    MergeRanges(&dead);
+    MergeRanges(&live);
+    dead_ranges_[node] = SubtractRanges(dead, live);
+  }
+  dead_ranges_valid_ = true;
+}
+
+void SimpleMemoryArena::FreeUnderlyingBuffer() {
+  if (underlying_buffer_ == nullptr) return;
+#ifdef __linux__
+  if (underlying_buffer_mapped_) {
+    munmap(underlying_buffer_, underlying_buffer_size_);
+    underlying_buffer_ = nullptr;
+    return;
+  }
+#endif
+  delete[] underlying_buffer_;
+  underlying_buffer_ = nullptr;
+}
+
 }  // namespace tflite
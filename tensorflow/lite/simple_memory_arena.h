@@ -16,7 +16,7 @@ limitations under the License.
 #define TENSORFLOW_LITE_SIMPLE_MEMORY_ARENA_H_
 
 #include <cstdint>
-#include <memory>
+#include <utility>
 #include <vector>
 
 #include "tensorflow/lite/c/common.h"
@@ -57,14 +57,29 @@ struct ArenaAllocWithUsageInterval {
 // scenarios when the pattern of memory allocations and deallocations is
 // repetitive, e.g. running NN inference in multiple iterations. Note that
 // zero-sized allocations are explicitly allowed, and will resolve to null.
+//
+// With lazy commit, the underlying buffer is mapped from the system without
+// being backed by memory, so that its pages only take up memory once they are
+// first written, and ReleaseDeadAllocs() hands pages that only hold dead
+// allocations back to the system. This is only supported on Linux; elsewhere
+// the arena is always fully committed.
 class SimpleMemoryArena {
  public:
   explicit SimpleMemoryArena(size_t arena_alignment)
       : committed_(false),
+        lazy_commit_(false),
         arena_alignment_(arena_alignment),
         high_water_mark_(0),
+        underlying_buffer_(nullptr),
+        underlying_buffer_mapped_(false),
         underlying_buffer_size_(0),
-        ordered_allocs_() {}
+        underlying_buffer_aligned_ptr_(nullptr),
+        ordered_allocs_(),
+        dead_ranges_valid_(false) {}
+  ~SimpleMemoryArena();
+
+  SimpleMemoryArena(const SimpleMemoryArena&) = delete;
+  SimpleMemoryArena& operator=(const SimpleMemoryArena&) = delete;
 
   // Schedule memory allocation for a tensor with a given size, assuming that it
   // needs to be allocated before the execution of first_node, and deallocated
@@ -99,6 +114,17 @@ class SimpleMemoryArena {
   // again until Commit() is called & tensor allocations are resolved.
   TfLiteStatus ReleaseBuffer();
 
+  // Sets whether the underlying buffer is committed lazily. Takes effect on
+  // the next call to Commit(), which moves the contents to a new buffer if the
+  // mode changed.
+  void SetLazyCommit(bool lazy_commit) { lazy_commit_ = lazy_commit; }
+
+  // Returns the pages that only hold allocations whose last_node is `node`,
+  // and no allocation used after `node`, to the system. Their contents are
+  // lost and the pages read as zeros until written again. No-op unless the
+  // buffer is committed lazily.
+  TfLiteStatus ReleaseDeadAllocs(TfLiteContext* context, int32_t node);
+
   size_t GetBufferSize() { return underlying_buffer_size_; }
 
   std::intptr_t BasePointer() const {
@@ -106,13 +132,27 @@ class SimpleMemoryArena {
   }
 
  private:
+  // Frees the underlying buffer, however it was allocated.
+  void FreeUnderlyingBuffer();
+
+  // Computes `dead_ranges_` from `ordered_allocs_`.
+  void CalculateDeadRanges();
+
   bool committed_;
+  bool lazy_commit_;
   size_t arena_alignment_;
   size_t high_water_mark_;
-  std::unique_ptr<char[]> underlying_buffer_;
+  char* underlying_buffer_;
+  // Whether `underlying_buffer_` was mapped rather than allocated with new[].
+  bool underlying_buffer_mapped_;
   size_t underlying_buffer_size_;
   char* underlying_buffer_aligned_ptr_;
   std::vector<ArenaAllocWithUsageInterval> ordered_allocs_;
+
+  // For each node, the [begin, end) offset ranges that only hold allocations
+  // that die after that node. Recomputed when the allocations change.
+  std::vector<std::vector<std::pair<size_t, size_t>>> dead_ranges_;
+  bool dead_ranges_valid_;
 };
 
 }  // namespace tflite
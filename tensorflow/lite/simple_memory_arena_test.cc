@@ -14,6 +14,9 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/lite/simple_memory_arena.h"
 
+#include <cstring>
+#include <limits>
+
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include "tensorflow/core/platform/logging.h"
@@ -118,6 +121,94 @@ TEST(SimpleMemoryArenaTest, TestClearPlan) {
   EXPECT_EQ(allocs[8].offset, 8192);
 }
 
+TEST(SimpleMemoryArenaTest, LazyCommitKeepsContents) {
+  TfLiteContext context;
+  context.ReportError = ReportError;
+  SimpleMemoryArena arena(64);
+  ArenaAllocWithUsageInterval allocs[2];
+  const size_t kSize = 64 * 1024;
+
+  ASSERT_EQ(arena.Allocate(&context, 32, kSize, 0, 0, 2, &allocs[0]),
+            kTfLiteOk);
+  ASSERT_EQ(arena.Commit(&context), kTfLiteOk);
+  char* resolved_ptr = nullptr;
+  ASSERT_EQ(arena.ResolveAlloc(&context, allocs[0], &resolved_ptr), kTfLiteOk);
+  std::memset(resolved_ptr, 7, kSize);
+
+  // Switching to lazy commit moves the contents to a new buffer.
+  arena.SetLazyCommit(true);
+  ASSERT_EQ(arena.Commit(&context), kTfLiteOk);
+  ASSERT_EQ(arena.ResolveAlloc(&context, allocs[0], &resolved_ptr), kTfLiteOk);
+  EXPECT_EQ(resolved_ptr[0], 7);
+  EXPECT_EQ(resolved_ptr[kSize - 1], 7);
+
+  // So does growing it.
+  ASSERT_EQ(arena.Allocate(&context, 32, 4 * kSize, 1, 1, 2, &allocs[1]),
+            kTfLiteOk);
+  ASSERT_EQ(arena.Commit(&context), kTfLiteOk);
+  ASSERT_EQ(arena.ResolveAlloc(&context, allocs[0], &resolved_ptr), kTfLiteOk);
+  EXPECT_EQ(resolved_ptr[0], 7);
+  EXPECT_EQ(resolved_ptr[kSize - 1], 7);
+
+  arena.SetLazyCommit(false);
+  ASSERT_EQ(arena.Commit(&context), kTfLiteOk);
+  ASSERT_EQ(arena.ResolveAlloc(&context, allocs[0], &resolved_ptr), kTfLiteOk);
+  EXPECT_EQ(resolved_ptr[0], 7);
+  EXPECT_EQ(resolved_ptr[kSize - 1], 7);
+}
+
+TEST(SimpleMemoryArenaTest, LazyCommitReleasesDeadAllocs) {
+  TfLiteContext context;
+  context.ReportError = ReportError;
+  SimpleMemoryArena arena(64);
+  arena.SetLazyCommit(true);
+  ArenaAllocWithUsageInterval allocs[3];
+  const size_t kSize = 64 * 1024;
+
+  // Tensor 0 dies after node 1, tensor 1 after node 2, and tensor 2 lives
+  // until the end.
+  ASSERT_EQ(arena.Allocate(&context, 32, kSize, 0, 0, 1, &allocs[0]),
+            kTfLiteOk);
+  ASSERT_EQ(arena.Allocate(&context, 32, kSize, 1, 0, 2, &allocs[1]),
+            kTfLiteOk);
+  ASSERT_EQ(arena.Allocate(&context, 32, kSize, 2, 0,
+                           std::numeric_limits<int32_t>::max(), &allocs[2]),
+            kTfLiteOk);
+  ASSERT_EQ(arena.Commit(&context), kTfLiteOk);
+  char* ptrs[3];
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_EQ(arena.ResolveAlloc(&context, allocs[i], &ptrs[i]), kTfLiteOk);
+    std::memset(ptrs[i], i + 1, kSize);
+  }
+
+  // Nothing dies after node 0.
+  ASSERT_EQ(arena.ReleaseDeadAllocs(&context, 0), kTfLiteOk);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(ptrs[i][kSize / 2], i + 1);
+  }
+
+  ASSERT_EQ(arena.ReleaseDeadAllocs(&context, 1), kTfLiteOk);
+#ifdef __linux__
+  // Released pages read as zeros.
+  EXPECT_EQ(ptrs[0][kSize / 2], 0);
+#endif
+  EXPECT_EQ(ptrs[1][0], 2);
+  EXPECT_EQ(ptrs[1][kSize - 1], 2);
+  EXPECT_EQ(ptrs[2][0], 3);
+  EXPECT_EQ(ptrs[2][kSize - 1], 3);
+
+  ASSERT_EQ(arena.ReleaseDeadAllocs(&context, 2), kTfLiteOk);
+#ifdef __linux__
+  EXPECT_EQ(ptrs[1][kSize / 2], 0);
+#endif
+  EXPECT_EQ(ptrs[2][0], 3);
+  EXPECT_EQ(ptrs[2][kSize - 1], 3);
+
+  // Released memory can be used again.
+  std::memset(ptrs[0], 9, kSize);
+  EXPECT_EQ(ptrs[0][kSize - 1], 9);
+}
+
 TEST(SimpleMemoryArenaTest, TestClearBuffer) {
   TfLiteContext context;
   context.ReportError = ReportError;
@@ -0,0 +1,165 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Measures the throughput and request latency of a model served by a
+// BatchingInterpreter to several concurrent callers, for each of a list of
+// batch timeouts, e.g.:
+//
+//   benchmark_batching_interpreter --graph=model.tflite --num_callers=16 \
+//     --allowed_batch_sizes=1,2,4,8,16 --batch_timeouts_micros=0,500,2000
+//
+// Every caller sends `num_runs` requests of zeros, one after another. Longer
+// timeouts gather larger batches, which raises throughput but makes every
+// request wait longer, so the runs trace out the throughput-latency trade-off.
+
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/util/stats_calculator.h"
+#include "tensorflow/lite/batching_interpreter.h"
+#include "tensorflow/lite/kernels/register.h"
+#include "tensorflow/lite/model.h"
+#include "tensorflow/lite/tools/benchmark/benchmark_utils.h"
+#include "tensorflow/lite/tools/benchmark/concurrent_requests.h"
+#include "tensorflow/lite/tools/command_line_flags.h"
+#include "tensorflow/lite/tools/logging.h"
+
+namespace tflite {
+namespace benchmark {
+namespace {
+
+// Runs `num_callers` callers concurrently, each sending `num_runs` requests
+// of zeros, and if `log_results` is set, logs the throughput, the request
+// latency and the average batch size.
+bool RunCallers(BatchingInterpreter* batcher, int num_callers, int num_runs,
+                bool log_results) {
+  std::vector<std::vector<std::vector<char>>> input_data(num_callers);
+  std::vector<std::vector<std::vector<char>>> output_data(num_callers);
+  std::vector<std::vector<const void*>> inputs(num_callers);
+  std::vector<std::vector<void*>> outputs(num_callers);
+  for (int caller = 0; caller < num_callers; ++caller) {
+    for (int i = 0; i < batcher->inputs_size(); ++i) {
+      input_data[caller].emplace_back(batcher->input_bytes(i), 0);
+      inputs[caller].push_back(input_data[caller].back().data());
+    }
+    for (int i = 0; i < batcher->outputs_size(); ++i) {
+      output_data[caller].emplace_back(batcher->output_bytes(i));
+      outputs[caller].push_back(output_data[caller].back().data());
+    }
+  }
+
+  const int64_t num_batches_before = batcher->num_batches();
+  const int64_t num_requests_before = batcher->num_requests();
+  tensorflow::Stat<int64_t> latency_us;
+  int64_t elapsed_us;
+  if (!RunConcurrentRequests(
+          num_callers, num_runs,
+          [batcher, &inputs, &outputs](int caller) {
+            return batcher->Invoke(inputs[caller], outputs[caller]) ==
+                   kTfLiteOk;
+          },
+          &latency_us, &elapsed_us)) {
+    return false;
+  }
+  if (!log_results) return true;
+
+  const int64_t num_requests = batcher->num_requests() - num_requests_before;
+  const int64_t num_batches = batcher->num_batches() - num_batches_before;
+  LogThroughputAndLatency(num_requests, elapsed_us, latency_us);
+  TFLITE_LOG(INFO) << "Average batch size: "
+                   << num_requests / static_cast<double>(num_batches);
+  return true;
+}
+
+}  // namespace
+
+int Main(int argc, char** argv) {
+  std::string graph;
+  int32_t num_callers = 8;
+  std::string allowed_batch_sizes = "1,2,4,8";
+  std::string batch_timeouts_micros = "0,1000";
+  int32_t num_batch_threads = 1;
+  int32_t num_threads = -1;
+  int32_t num_runs = 50;
+  std::vector<Flag> flags = {
+      Flag::CreateFlag("graph", &graph, "graph file name"),
+      Flag::CreateFlag("num_callers", &num_callers,
+                       "number of threads sending requests concurrently"),
+      Flag::CreateFlag("allowed_batch_sizes", &allowed_batch_sizes,
+                       "comma-separated batch sizes the model is prepared "
+                       "for, in increasing order"),
+      Flag::CreateFlag("batch_timeouts_micros", &batch_timeouts_micros,
+                       "comma-separated batch timeouts to benchmark one after "
+                       "another"),
+      Flag::CreateFlag("num_batch_threads", &num_batch_threads,
+                       "number of batches running concurrently"),
+      Flag::CreateFlag("num_threads", &num_threads,
+                       "number of threads shared by all the batch threads, or "
+                       "-1 for the TFLite default per batch thread"),
+      Flag::CreateFlag("num_runs", &num_runs, "number of requests per caller"),
+  };
+  const bool parsed =
+      Flags::Parse(&argc, const_cast<const char**>(argv), flags);
+  BatchingInterpreter::Options options;
+  options.allowed_batch_sizes.clear();
+  std::vector<int64_t> timeouts_micros;
+  if (!parsed || graph.empty() || num_callers < 1 || num_runs < 1 ||
+      !util::SplitAndParse(allowed_batch_sizes, ',',
+                           &options.allowed_batch_sizes) ||
+      !util::SplitAndParse(batch_timeouts_micros, ',', &timeouts_micros) ||
+      timeouts_micros.empty()) {
+    TFLITE_LOG(ERROR) << Flags::Usage(argv[0], flags);
+    return EXIT_FAILURE;
+  }
+
+  std::unique_ptr<FlatBufferModel> model =
+      FlatBufferModel::BuildFromFile(graph.c_str());
+  if (!model) {
+    TFLITE_LOG(ERROR) << "Failed to load the model " << graph;
+    return EXIT_FAILURE;
+  }
+  ops::builtin::BuiltinOpResolver resolver;
+  options.num_batch_threads = num_batch_threads;
+  options.num_threads = num_threads;
+
+  for (int64_t timeout_micros : timeouts_micros) {
+    options.batch_timeout_micros = timeout_micros;
+    std::unique_ptr<BatchingInterpreter> batcher =
+        BatchingInterpreter::Create(*model, resolver, options);
+    if (!batcher) {
+      TFLITE_LOG(ERROR) << "Failed to create the batching interpreter";
+      return EXIT_FAILURE;
+    }
+    TFLITE_LOG(INFO) << "Batch timeout: " << timeout_micros
+                     << " us, callers: " << num_callers
+                     << ", batch threads: " << num_batch_threads;
+    // Warm up with one request per caller.
+    if (!RunCallers(batcher.get(), num_callers, /*num_runs=*/1,
+                    /*log_results=*/false) ||
+        !RunCallers(batcher.get(), num_callers, num_runs,
+                    /*log_results=*/true)) {
+      return EXIT_FAILURE;
+    }
+  }
+  return EXIT_SUCCESS;
+}
+
+}  // namespace benchmark
+}  // namespace tflite
+
+int main(int argc, char** argv) { return tflite::benchmark::Main(argc, argv); }
@@ -0,0 +1,133 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Measures the throughput of a model served by an InterpreterPool to several
+// concurrent callers, e.g.:
+//
+//   benchmark_interpreter_pool --graph=model.tflite --num_callers=8 \
+//     --num_interpreters=4 --num_threads=4
+//
+// Every caller acquires an interpreter, fills its inputs with zeros, invokes
+// it and releases it, `num_runs` times. The reported latency of a request
+// includes the time spent waiting for an idle interpreter.
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/util/stats_calculator.h"
+#include "tensorflow/lite/interpreter_pool.h"
+#include "tensorflow/lite/kernels/register.h"
+#include "tensorflow/lite/model.h"
+#include "tensorflow/lite/tools/benchmark/concurrent_requests.h"
+#include "tensorflow/lite/tools/command_line_flags.h"
+#include "tensorflow/lite/tools/logging.h"
+
+namespace tflite {
+namespace benchmark {
+namespace {
+
+// Acquires an interpreter of `pool`, fills its inputs with zeros and invokes
+// it.
+bool SendRequest(InterpreterPool* pool) {
+  InterpreterPool::ScopedInterpreter interpreter = pool->Acquire();
+  if (!interpreter) return false;
+  for (int input : interpreter->inputs()) {
+    TfLiteTensor* tensor = interpreter->tensor(input);
+    if (tensor->data.raw != nullptr) {
+      std::memset(tensor->data.raw, 0, tensor->bytes);
+    }
+  }
+  return interpreter->Invoke() == kTfLiteOk;
+}
+
+}  // namespace
+
+int Main(int argc, char** argv) {
+  std::string graph;
+  int32_t num_callers = 4;
+  int32_t num_interpreters = 4;
+  int32_t num_threads = -1;
+  int32_t num_runs = 50;
+  std::vector<Flag> flags = {
+      Flag::CreateFlag("graph", &graph, "graph file name"),
+      Flag::CreateFlag("num_callers", &num_callers,
+                       "number of threads sending requests concurrently"),
+      Flag::CreateFlag("num_interpreters", &num_interpreters,
+                       "maximum number of interpreters in the pool"),
+      Flag::CreateFlag("num_threads", &num_threads,
+                       "number of threads shared by all the interpreters, or "
+                       "-1 for the TFLite default per interpreter"),
+      Flag::CreateFlag("num_runs", &num_runs, "number of requests per caller"),
+  };
+  const bool parsed =
+      Flags::Parse(&argc, const_cast<const char**>(argv), flags);
+  if (!parsed || graph.empty() || num_callers < 1 || num_runs < 1) {
+    TFLITE_LOG(ERROR) << Flags::Usage(argv[0], flags);
+    return EXIT_FAILURE;
+  }
+
+  std::unique_ptr<FlatBufferModel> model =
+      FlatBufferModel::BuildFromFile(graph.c_str());
+  if (!model) {
+    TFLITE_LOG(ERROR) << "Failed to load the model " << graph;
+    return EXIT_FAILURE;
+  }
+  ops::builtin::BuiltinOpResolver resolver;
+  InterpreterPool::Options options;
+  options.max_num_interpreters = num_interpreters;
+  options.num_threads = num_threads;
+  std::unique_ptr<InterpreterPool> pool =
+      InterpreterPool::Create(*model, resolver, options);
+  if (!pool) {
+    TFLITE_LOG(ERROR) << "Failed to create the interpreter pool";
+    return EXIT_FAILURE;
+  }
+
+  const auto send_request = [&pool](int caller) {
+    return SendRequest(pool.get());
+  };
+  tensorflow::Stat<int64_t> latency_us;
+  int64_t elapsed_us;
+  // Warm up, which also builds one interpreter per concurrent request.
+  {
+    tensorflow::Stat<int64_t> unused_latency_us;
+    int64_t unused_elapsed_us;
+    if (!RunConcurrentRequests(num_callers, /*num_runs=*/1, send_request,
+                               &unused_latency_us, &unused_elapsed_us)) {
+      return EXIT_FAILURE;
+    }
+  }
+  if (!RunConcurrentRequests(num_callers, num_runs, send_request, &latency_us,
+                             &elapsed_us)) {
+    return EXIT_FAILURE;
+  }
+
+  TFLITE_LOG(INFO) << "Callers: " << num_callers
+                   << ", interpreters built: " << pool->num_interpreters()
+                   << ", threads per interpreter: "
+                   << pool->num_threads_per_interpreter();
+  LogThroughputAndLatency(static_cast<int64_t>(num_callers) * num_runs,
+                          elapsed_us, latency_us);
+  return EXIT_SUCCESS;
+}
+
+}  // namespace benchmark
+}  // namespace tflite
+
+int main(int argc, char** argv) { return tflite::benchmark::Main(argc, argv); }
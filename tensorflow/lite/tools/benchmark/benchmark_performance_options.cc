@@ -75,6 +75,10 @@ std::string MultiRunStatsRecorder::PerfOptionName(
   // requires C++11.
   std::stringstream sstm;
   sstm << "cpu w/ " << params.Get<int32_t>("num_threads") << " threads";
+  if (params.Get<int32_t>("num_inter_op_threads") > 1) {
+    sstm << ", " << params.Get<int32_t>("num_inter_op_threads")
+         << " inter-op threads";
+  }
 
   // Handle cases run on CPU w/ the xnnpack delegate
   if (params.Get<bool>("use_xnnpack")) {
@@ -226,6 +230,7 @@ bool BenchmarkPerformanceOptions::HasOption(const std::string& option) const {
 
 void BenchmarkPerformanceOptions::ResetPerformanceOptions() {
   single_option_run_params_->Set<int32_t>("num_threads", 1);
+  single_option_run_params_->Set<int32_t>("num_inter_op_threads", 1);
   single_option_run_params_->Set<bool>("use_gpu", false);
 #if defined(__ANDROID__)
   single_option_run_params_->Set<bool>("gpu_precision_loss_allowed", true);
@@ -268,6 +273,15 @@ void BenchmarkPerformanceOptions::CreatePerformanceOptions() {
       xnnpack_params.AddParam("num_threads",
                               BenchmarkParam::Create<int32_t>(count));
       all_run_params_.emplace_back(std::move(xnnpack_params));
+
+      // Running independent operators concurrently, compared with the
+      // sequential run above.
+      if (count > 1) {
+        BenchmarkParams inter_op_params;
+        inter_op_params.AddParam("num_inter_op_threads",
+                                 BenchmarkParam::Create<int32_t>(count));
+        all_run_params_.emplace_back(std::move(inter_op_params));
+      }
     }
   }
 
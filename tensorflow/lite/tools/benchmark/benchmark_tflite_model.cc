@@ -32,8 +32,10 @@ limitations under the License.
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/kernels/cpu_backend_context.h"
 #include "tensorflow/lite/kernels/register.h"
+#include "tensorflow/lite/kernels/weight_cache.h"
 #include "tensorflow/lite/model.h"
 #include "tensorflow/lite/op_resolver.h"
+#include "tensorflow/lite/profiling/memory_info.h"
 #include "tensorflow/lite/profiling/platform_profiler.h"
 #include "tensorflow/lite/profiling/profile_summary_formatter.h"
 #include "tensorflow/lite/string_util.h"
@@ -94,6 +96,74 @@ void RuyProfileListener::OnBenchmarkEnd(const BenchmarkResults& results) {
   ruy_profile_ = nullptr;
 }
 
+// Reports what the process-wide weight cache saved, and saves the cache to
+// `filename`, if set, for later runs to load.
+class WeightCacheListener : public BenchmarkListener {
+ public:
+  explicit WeightCacheListener(const std::string& filename)
+      : filename_(filename) {}
+
+  void OnBenchmarkEnd(const BenchmarkResults& results) override;
+
+ private:
+  std::string filename_;
+};
+
+void WeightCacheListener::OnBenchmarkEnd(const BenchmarkResults& results) {
+  const WeightCache::Stats stats = WeightCache::Global().stats();
+  if (stats.num_packed + stats.num_loaded + stats.num_shared == 0) return;
+  TFLITE_LOG(INFO) << "Weight cache: " << stats.num_packed << " packed, "
+                   << stats.num_loaded << " loaded from file, "
+                   << stats.num_shared << " shared (" << stats.shared_bytes
+                   << " bytes not duplicated).";
+  if (!filename_.empty() &&
+      WeightCache::Global().SaveFile(filename_, DefaultErrorReporter()) !=
+          kTfLiteOk) {
+    TFLITE_LOG(WARN) << "Failed to save the weight cache to " << filename_;
+  }
+}
+
+// Reports the peak resident set size of the process during each regular run,
+// i.e. the memory an inference actually touched, including the pages of a
+// lazily committed arena, rather than the peak over the whole benchmark.
+class PeakMemoryListener : public BenchmarkListener {
+ public:
+  void OnSingleRunStart(RunType run_type) override;
+
+  void OnSingleRunEnd() override;
+
+  void OnBenchmarkEnd(const BenchmarkResults& results) override;
+
+ private:
+  bool in_regular_run_ = false;
+  tensorflow::Stat<int64_t> peak_rss_kb_;
+};
+
+void PeakMemoryListener::OnSingleRunStart(RunType run_type) {
+  in_regular_run_ =
+      run_type == REGULAR && profiling::memory::ResetPeakResidentSetSize();
+}
+
+void PeakMemoryListener::OnSingleRunEnd() {
+  if (!in_regular_run_) return;
+  in_regular_run_ = false;
+  const int64_t peak_rss_kb = profiling::memory::GetPeakResidentSetSizeKb();
+  if (peak_rss_kb != profiling::memory::MemoryUsage::kValueNotSet) {
+    peak_rss_kb_.UpdateStat(peak_rss_kb);
+  }
+}
+
+void PeakMemoryListener::OnBenchmarkEnd(const BenchmarkResults& results) {
+  if (peak_rss_kb_.empty()) {
+    TFLITE_LOG(WARN) << "Peak memory per run is not supported on this system.";
+    return;
+  }
+  TFLITE_LOG(INFO) << "Peak resident set size per run: avg="
+                   << peak_rss_kb_.avg() / 1024.0
+                   << " MB, min=" << peak_rss_kb_.min() / 1024.0
+                   << " MB, max=" << peak_rss_kb_.max() / 1024.0 << " MB";
+}
+
 std::vector<std::string> Split(const std::string& str, const char delim) {
   std::vector<std::string> results;
   if (!util::SplitAndParse(str, delim, &results)) {
@@ -262,6 +332,12 @@ BenchmarkParams BenchmarkTfLiteModel::DefaultParams() {
   default_params.AddParam("use_legacy_nnapi",
                           BenchmarkParam::Create<bool>(false));
   default_params.AddParam("allow_fp16", BenchmarkParam::Create<bool>(false));
+  default_params.AddParam("num_inter_op_threads",
+                          BenchmarkParam::Create<int32_t>(1));
+  default_params.AddParam("lazy_arena_commit",
+                          BenchmarkParam::Create<bool>(false));
+  default_params.AddParam("report_peak_memory_per_run",
+                          BenchmarkParam::Create<bool>(false));
   default_params.AddParam("require_full_delegation",
                           BenchmarkParam::Create<bool>(false));
   default_params.AddParam(
@@ -273,6 +349,10 @@ BenchmarkParams BenchmarkTfLiteModel::DefaultParams() {
                           BenchmarkParam::Create<std::string>(""));
   default_params.AddParam("enable_platform_tracing",
                           BenchmarkParam::Create<bool>(false));
+  default_params.AddParam("profiling_output_chrome_trace_file",
+                          BenchmarkParam::Create<std::string>(""));
+  default_params.AddParam("weight_cache_file",
+                          BenchmarkParam::Create<std::string>(""));
 
   for (const auto& delegate_provider :
        tools::GetRegisteredDelegateProviders()) {
@@ -326,6 +406,16 @@ std::vector<Flag> BenchmarkTfLiteModel::GetFlags() {
           "strings format."),
       CreateFlag<bool>("use_legacy_nnapi", &params_, "use legacy nnapi api"),
       CreateFlag<bool>("allow_fp16", &params_, "allow fp16"),
+      CreateFlag<int32_t>(
+          "num_inter_op_threads", &params_,
+          "number of threads running independent operators concurrently"),
+      CreateFlag<bool>("lazy_arena_commit", &params_,
+                       "only back the tensor arena with memory once written "
+                       "to, and release the memory of intermediate tensors "
+                       "after their last use (Linux only)"),
+      CreateFlag<bool>("report_peak_memory_per_run", &params_,
+                       "report the peak resident set size of each run "
+                       "(Linux only)"),
       CreateFlag<bool>("require_full_delegation", &params_,
                        "require delegate to run the entire graph"),
       CreateFlag<bool>("enable_op_profiling", &params_, "enable op profiling"),
@@ -337,7 +427,17 @@ std::vector<Flag> BenchmarkTfLiteModel::GetFlags() {
           "prints to stdout."),
       CreateFlag<bool>("enable_platform_tracing", &params_,
                        "enable platform-wide tracing, only meaningful when "
-                       "--enable_op_profiling is set to true.")};
+                       "--enable_op_profiling is set to true."),
+      CreateFlag<std::string>(
+          "profiling_output_chrome_trace_file", &params_,
+          "File path to export every profiled event, including each op "
+          "invocation, as a Chrome trace instead of printing the profiling "
+          "summary. Only meaningful when --enable_op_profiling is set to "
+          "true."),
+      CreateFlag<std::string>(
+          "weight_cache_file", &params_,
+          "File to load prepacked weights from if it exists, and to save "
+          "them to after the run.")};
 
   flags.insert(flags.end(), specific_flags.begin(), specific_flags.end());
 
@@ -367,6 +467,11 @@ void BenchmarkTfLiteModel::LogParams() {
   LOG_BENCHMARK_PARAM(bool, "use_legacy_nnapi", "Use legacy nnapi", verbose);
 #endif
   LOG_BENCHMARK_PARAM(bool, "allow_fp16", "Allow fp16", verbose);
+  LOG_BENCHMARK_PARAM(int32_t, "num_inter_op_threads", "Num inter-op threads",
+                      verbose);
+  LOG_BENCHMARK_PARAM(bool, "lazy_arena_commit", "Lazy arena commit", verbose);
+  LOG_BENCHMARK_PARAM(bool, "report_peak_memory_per_run",
+                      "Report peak memory per run", verbose);
   LOG_BENCHMARK_PARAM(bool, "require_full_delegation",
                       "Require full delegation", verbose);
   LOG_BENCHMARK_PARAM(bool, "enable_op_profiling", "Enable op profiling",
@@ -377,6 +482,11 @@ void BenchmarkTfLiteModel::LogParams() {
                       "CSV File to export profiling data to", verbose);
   LOG_BENCHMARK_PARAM(bool, "enable_platform_tracing",
                       "Enable platform-wide tracing", verbose);
+  LOG_BENCHMARK_PARAM(std::string, "profiling_output_chrome_trace_file",
+                      "Chrome trace file to export profiling events to",
+                      verbose);
+  LOG_BENCHMARK_PARAM(std::string, "weight_cache_file", "Weight cache file",
+                      verbose);
 
   for (const auto& delegate_provider :
        tools::GetRegisteredDelegateProviders()) {
@@ -601,6 +711,17 @@ TfLiteStatus BenchmarkTfLiteModel::ResetInputsAndOutputs() {
 }
 
 TfLiteStatus BenchmarkTfLiteModel::InitInterpreter() {
+  const std::string weight_cache_file =
+      params_.Get<std::string>("weight_cache_file");
+  if (!weight_cache_file.empty() && std::ifstream(weight_cache_file).good()) {
+    if (WeightCache::Global().LoadFile(weight_cache_file,
+                                       DefaultErrorReporter()) == kTfLiteOk) {
+      TFLITE_LOG(INFO) << "Loaded weight cache " << weight_cache_file;
+    } else {
+      TFLITE_LOG(WARN) << "Ignoring weight cache " << weight_cache_file;
+    }
+  }
+
   auto resolver = GetOpResolver();
   const int32_t num_threads = params_.Get<int32_t>("num_threads");
   const bool use_caching = params_.Get<bool>("use_caching");
@@ -622,6 +743,18 @@ TfLiteStatus BenchmarkTfLiteModel::InitInterpreter() {
                                      external_context_.get());
   }
 
+  if (interpreter_->SetNumInterOpThreads(
+          params_.Get<int32_t>("num_inter_op_threads")) != kTfLiteOk) {
+    TFLITE_LOG(ERROR) << "Failed to set the number of inter-op threads";
+    return kTfLiteError;
+  }
+
+  if (interpreter_->SetLazyArenaCommit(
+          params_.Get<bool>("lazy_arena_commit")) != kTfLiteOk) {
+    TFLITE_LOG(ERROR) << "Failed to set lazy arena commit";
+    return kTfLiteError;
+  }
+
   return kTfLiteOk;
 }
 
@@ -725,6 +858,15 @@ TfLiteStatus BenchmarkTfLiteModel::Init() {
   ruy_profiling_listener_.reset(new RuyProfileListener());
   AddListener(ruy_profiling_listener_.get());
 
+  weight_cache_listener_.reset(
+      new WeightCacheListener(params_.Get<std::string>("weight_cache_file")));
+  AddListener(weight_cache_listener_.get());
+
+  if (params_.Get<bool>("report_peak_memory_per_run")) {
+    peak_memory_listener_.reset(new PeakMemoryListener());
+    AddListener(peak_memory_listener_.get());
+  }
+
   return kTfLiteOk;
 }
 
@@ -755,6 +897,13 @@ BenchmarkTfLiteModel::MayCreateProfilingListener() const {
         new PlatformProfilingListener(interpreter_.get()));
   }
 
+  const auto trace_file =
+      params_.Get<std::string>("profiling_output_chrome_trace_file");
+  if (!trace_file.empty()) {
+    return std::unique_ptr<BenchmarkListener>(
+        new TraceProfilingListener(interpreter_.get(), trace_file));
+  }
+
   return std::unique_ptr<BenchmarkListener>(new ProfilingListener(
       interpreter_.get(), params_.Get<int32_t>("max_profiling_buffer_entries"),
       params_.Get<std::string>("profiling_output_csv_file"),
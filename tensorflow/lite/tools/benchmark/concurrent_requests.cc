@@ -0,0 +1,78 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/tools/benchmark/concurrent_requests.h"
+
+#include <sstream>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "tensorflow/lite/profiling/time.h"
+#include "tensorflow/lite/tools/logging.h"
+
+namespace tflite {
+namespace benchmark {
+
+bool RunConcurrentRequests(int num_callers, int num_runs,
+                           const std::function<bool(int caller)>& send_request,
+                           tensorflow::Stat<int64_t>* latency_us,
+                           int64_t* elapsed_us) {
+  std::vector<std::vector<int64_t>> latencies_us(num_callers);
+  std::vector<char> succeeded(num_callers);
+  const int64_t start_us = profiling::time::NowMicros();
+  {
+    std::vector<std::thread> callers;
+    for (int i = 0; i < num_callers; ++i) {
+      callers.emplace_back([&send_request, &latencies_us, &succeeded, num_runs,
+                            i] {
+        latencies_us[i].reserve(num_runs);
+        for (int run = 0; run < num_runs; ++run) {
+          const int64_t request_start_us = profiling::time::NowMicros();
+          if (!send_request(i)) return;
+          latencies_us[i].push_back(profiling::time::NowMicros() -
+                                    request_start_us);
+        }
+        succeeded[i] = true;
+      });
+    }
+    for (std::thread& caller : callers) caller.join();
+  }
+  *elapsed_us = profiling::time::NowMicros() - start_us;
+
+  for (int i = 0; i < num_callers; ++i) {
+    if (!succeeded[i]) {
+      TFLITE_LOG(ERROR) << "Caller " << i << " failed";
+      return false;
+    }
+  }
+  for (const std::vector<int64_t>& caller_latencies_us : latencies_us) {
+    for (int64_t latency : caller_latencies_us) latency_us->UpdateStat(latency);
+  }
+  return true;
+}
+
+void LogThroughputAndLatency(int64_t num_requests, int64_t elapsed_us,
+                             const tensorflow::Stat<int64_t>& latency_us) {
+  std::stringstream latency_stream;
+  latency_us.OutputToStream(&latency_stream);
+  TFLITE_LOG(INFO) << "Throughput: "
+                   << num_requests * 1e6 / static_cast<double>(elapsed_us)
+                   << " requests/s (" << num_requests << " requests in "
+                   << elapsed_us << " us)";
+  TFLITE_LOG(INFO) << "Request latency (us): " << latency_stream.str();
+}
+
+}  // namespace benchmark
+}  // namespace tflite
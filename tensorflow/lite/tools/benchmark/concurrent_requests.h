@@ -0,0 +1,45 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_TOOLS_BENCHMARK_CONCURRENT_REQUESTS_H_
+#define TENSORFLOW_LITE_TOOLS_BENCHMARK_CONCURRENT_REQUESTS_H_
+
+#include <cstdint>
+#include <functional>
+
+#include "tensorflow/core/util/stats_calculator.h"
+
+namespace tflite {
+namespace benchmark {
+
+// Runs `num_callers` threads that each send `num_runs` requests one after
+// another by calling `send_request(caller)`, where `caller` is the index of
+// the thread. Adds the latency of every request to `latency_us`, and sets
+// `elapsed_us` to the time taken by all the callers. Returns false if a
+// request failed.
+bool RunConcurrentRequests(int num_callers, int num_runs,
+                           const std::function<bool(int caller)>& send_request,
+                           tensorflow::Stat<int64_t>* latency_us,
+                           int64_t* elapsed_us);
+
+// Logs the throughput of `num_requests` requests that took `elapsed_us`, and
+// their latency.
+void LogThroughputAndLatency(int64_t num_requests, int64_t elapsed_us,
+                             const tensorflow::Stat<int64_t>& latency_us);
+
+}  // namespace benchmark
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_TOOLS_BENCHMARK_CONCURRENT_REQUESTS_H_
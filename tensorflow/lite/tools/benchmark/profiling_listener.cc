@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <fstream>
 
+#include "tensorflow/lite/profiling/chrome_trace_formatter.h"
 #include "tensorflow/lite/tools/logging.h"
 
 namespace tflite {
@@ -88,5 +89,43 @@ void ProfilingListener::WriteOutput(const std::string& header,
   (*stream) << data << std::endl;
 }
 
+TraceProfilingListener::TraceProfilingListener(
+    Interpreter* interpreter, const std::string& trace_file_path)
+    : interpreter_(interpreter), trace_file_path_(trace_file_path) {
+  TFLITE_TOOLS_CHECK(interpreter);
+  interpreter_->SetProfiler(&profiler_);
+  // As with ProfilingListener, start right away so that the initialization
+  // events end up in the trace too.
+  profiler_.StartProfiling();
+}
+
+void TraceProfilingListener::OnSingleRunStart(RunType run_type) {
+  // Marks each inference so that they can be told apart in the timeline.
+  run_event_handle_ = profiler_.BeginEvent(
+      run_type == WARMUP ? "WarmupRun" : "Run",
+      Profiler::EventType::DEFAULT, num_runs_++, /*event_metadata2=*/0);
+}
+
+void TraceProfilingListener::OnSingleRunEnd() {
+  profiler_.EndEvent(run_event_handle_);
+}
+
+void TraceProfilingListener::OnBenchmarkEnd(const BenchmarkResults& results) {
+  profiler_.StopProfiling();
+  if (profiler_.NumDroppedEvents() > 0) {
+    TFLITE_LOG(WARN) << "Dropped " << profiler_.NumDroppedEvents()
+                     << " trace events, the trace is incomplete.";
+  }
+  std::ofstream output_file(trace_file_path_);
+  if (!output_file.good()) {
+    TFLITE_LOG(ERROR) << "Failed to open " << trace_file_path_
+                      << " to write the trace.";
+    return;
+  }
+  output_file << profiling::FormatChromeTrace(profiler_.GetTraceEvents(),
+                                              *interpreter_);
+  TFLITE_LOG(INFO) << "Wrote the Chrome trace to " << trace_file_path_;
+}
+
 }  // namespace benchmark
 }  // namespace tflite
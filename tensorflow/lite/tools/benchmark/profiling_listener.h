@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/lite/profiling/buffered_profiler.h"
 #include "tensorflow/lite/profiling/profile_summarizer.h"
 #include "tensorflow/lite/profiling/profile_summary_formatter.h"
+#include "tensorflow/lite/profiling/trace_profiler.h"
 #include "tensorflow/lite/tools/benchmark/benchmark_model.h"
 
 namespace tflite {
@@ -55,6 +56,27 @@ class ProfilingListener : public BenchmarkListener {
   profiling::BufferedProfiler profiler_;
 };
 
+// Records every event of the benchmark, including each operator invocation of
+// every run, and writes them as a Chrome trace file at the end.
+class TraceProfilingListener : public BenchmarkListener {
+ public:
+  TraceProfilingListener(Interpreter* interpreter,
+                         const std::string& trace_file_path);
+
+  void OnSingleRunStart(RunType run_type) override;
+
+  void OnSingleRunEnd() override;
+
+  void OnBenchmarkEnd(const BenchmarkResults& results) override;
+
+ private:
+  Interpreter* interpreter_;
+  std::string trace_file_path_;
+  profiling::TraceProfiler profiler_;
+  int64_t num_runs_ = 0;
+  uint32_t run_event_handle_ = profiling::kInvalidEventHandle;
+};
+
 }  // namespace benchmark
 }  // namespace tflite
 